@@ -26,6 +26,12 @@ namespace {
     // This sample displays hand tracking inputs appears as hand mesh, or joint axes.
     // User can clap their hands to toggle between different display mode
     // It also demos a simple procedural coloring of the hand mesh using the "open palm" reference hand input.
+    // The hand mesh is shown in two ways, which clapping also toggles between:
+    // - The "open palm" reference mesh skinned to the tracked joints on the GPU. A frame only updates the joint transforms,
+    //   and the mesh is rebuilt only when the runtime changes the reference mesh. Each vertex follows the two joints of its
+    //   closest bone, so it only approximates how the runtime deforms the hand, e.g. where the skin creases around knuckles.
+    // - The tracked mesh, which the runtime deforms itself. It matches the hand exactly, but all of its vertices are
+    //   uploaded every frame.
     //
     struct HandTrackingScene : public Scene {
         HandTrackingScene(SceneContext& sceneContext)
@@ -64,15 +70,17 @@ namespace {
 
                 createJointObjects(handData);
 
-                // Initialize buffers to receive hand mesh indices and vertices
+                // Initialize buffers to receive hand mesh indices and vertices, for the skinned and the tracked mesh each.
                 const XrSystemHandTrackingMeshPropertiesMSFT& handMeshSystemProperties = sceneContext.System.HandMeshProperties;
-                handData.IndexBuffer = std::make_unique<uint32_t[]>(handMeshSystemProperties.maxHandMeshIndexCount);
-                handData.VertexBuffer = std::make_unique<XrHandMeshVertexMSFT[]>(handMeshSystemProperties.maxHandMeshVertexCount);
-
-                handData.meshState.indexBuffer.indexCapacityInput = handMeshSystemProperties.maxHandMeshIndexCount;
-                handData.meshState.indexBuffer.indices = handData.IndexBuffer.get();
-                handData.meshState.vertexBuffer.vertexCapacityInput = handMeshSystemProperties.maxHandMeshVertexCount;
-                handData.meshState.vertexBuffer.vertices = handData.VertexBuffer.get();
+                for (HandMesh& mesh : {std::ref(handData.SkinnedMesh), std::ref(handData.TrackedMesh)}) {
+                    mesh.IndexBuffer = std::make_unique<uint32_t[]>(handMeshSystemProperties.maxHandMeshIndexCount);
+                    mesh.VertexBuffer = std::make_unique<XrHandMeshVertexMSFT[]>(handMeshSystemProperties.maxHandMeshVertexCount);
+
+                    mesh.meshState.indexBuffer.indexCapacityInput = handMeshSystemProperties.maxHandMeshIndexCount;
+                    mesh.meshState.indexBuffer.indices = mesh.IndexBuffer.get();
+                    mesh.meshState.vertexBuffer.vertexCapacityInput = handMeshSystemProperties.maxHandMeshVertexCount;
+                    mesh.meshState.vertexBuffer.vertices = mesh.VertexBuffer.get();
+                }
 
                 XrHandMeshSpaceCreateInfoMSFT meshSpaceCreateInfo{XR_TYPE_HAND_MESH_SPACE_CREATE_INFO_MSFT};
                 meshSpaceCreateInfo.poseInHandMeshSpace = xr::math::Pose::Identity();
@@ -116,19 +124,28 @@ namespace {
                     m_sceneContext.Extensions.xrLocateHandJointsEXT(handData.TrackerHandle.Get(), &locateInfo, &handJointLocations));
 
                 bool jointsVisible = m_mode == HandDisplayMode::Joints;
-                bool meshVisible = m_mode == HandDisplayMode::Mesh;
+                bool skinnedMeshVisible = m_mode == HandDisplayMode::SkinnedMesh;
+                bool trackedMeshVisible = m_mode == HandDisplayMode::TrackedMesh;
 
                 if (jointsVisible) {
                     jointsVisible = UpdateJoints(handData, m_sceneContext.SceneSpace, frameTime.PredictedDisplayTime);
                 }
 
-                if (meshVisible) {
-                    meshVisible = UpdateMesh(handData, m_sceneContext.SceneSpace, frameTime.PredictedDisplayTime);
+                if (skinnedMeshVisible) {
+                    skinnedMeshVisible = UpdateSkinnedMesh(handData, m_sceneContext.SceneSpace, frameTime.PredictedDisplayTime);
+                }
+
+                if (trackedMeshVisible) {
+                    trackedMeshVisible = UpdateTrackedMesh(handData, m_sceneContext.SceneSpace, frameTime.PredictedDisplayTime);
                 }
 
                 handData.JointModel->SetVisible(jointsVisible);
-                if (handData.MeshSceneObject != nullptr) { // Pbr mesh object creation is deferred.
-                    handData.MeshSceneObject->SetVisible(meshVisible);
+                // Pbr mesh object creation is deferred.
+                if (handData.SkinnedMesh.MeshSceneObject != nullptr) {
+                    handData.SkinnedMesh.MeshSceneObject->SetVisible(skinnedMeshVisible);
+                }
+                if (handData.TrackedMesh.MeshSceneObject != nullptr) {
+                    handData.TrackedMesh.MeshSceneObject->SetVisible(trackedMeshVisible);
                 }
             }
 
@@ -136,6 +153,16 @@ namespace {
             m_clapDetector->Update(frameTime.PredictedDisplayTime);
         }
 
+        // A hand mesh received from the runtime in one hand pose type, and the scene object displaying it.
+        struct HandMesh {
+            XrHandMeshMSFT meshState{XR_TYPE_HAND_MESH_MSFT};
+            std::unique_ptr<uint32_t[]> IndexBuffer{};
+            std::unique_ptr<XrHandMeshVertexMSFT[]> VertexBuffer{};
+            std::vector<XMFLOAT4> VertexColors;
+            std::shared_ptr<PbrModelObject> MeshSceneObject;
+            uint32_t StreamingStatsFrameCount{0}; // Frames since the streaming stats of the mesh primitive were reset.
+        };
+
         struct HandData {
             xr::HandTrackerHandle TrackerHandle;
 
@@ -144,16 +171,16 @@ namespace {
             std::array<Pbr::NodeIndex_t, XR_HAND_JOINT_COUNT_EXT> PbrNodeIndices{};
             std::array<XrHandJointLocationEXT, XR_HAND_JOINT_COUNT_EXT> JointLocations{};
 
-            // Data to display hand mesh tracking
+            // Data to display the tracked hand mesh, which is in the tracked mesh space.
             xr::SpaceHandle MeshSpace;
-            xr::SpaceHandle ReferenceMeshSpace;
-            std::vector<XMFLOAT4> VertexColors;
-            std::shared_ptr<PbrModelObject> MeshSceneObject;
+            HandMesh TrackedMesh;
 
-            // Data to process open-palm reference hand.
-            XrHandMeshMSFT meshState{XR_TYPE_HAND_MESH_MSFT};
-            std::unique_ptr<uint32_t[]> IndexBuffer{};
-            std::unique_ptr<XrHandMeshVertexMSFT[]> VertexBuffer{};
+            // Data to display the open-palm reference hand mesh skinned to the joints. The mesh and the reference joints are
+            // both in the reference mesh space.
+            xr::SpaceHandle ReferenceMeshSpace;
+            HandMesh SkinnedMesh;
+            std::array<Pbr::NodeIndex_t, XR_HAND_JOINT_COUNT_EXT> MeshJointNodeIndices{}; // Nodes posing the mesh joints.
+            std::array<XrHandJointLocationEXT, XR_HAND_JOINT_COUNT_EXT> ReferenceJointLocations{};
 
             HandData() = default;
             HandData(HandData&&) = delete;
@@ -187,63 +214,162 @@ namespace {
             return jointsVisible;
         }
 
-        bool UpdateMesh(HandData& handData, XrSpace referenceSpace, XrTime time) {
+        bool UpdateSkinnedMesh(HandData& handData, XrSpace referenceSpace, XrTime time) {
+            // The reference mesh only changes when the runtime refits the hand, unlike the tracked mesh which changes every frame.
+            HandMesh& mesh = handData.SkinnedMesh;
             XrHandMeshUpdateInfoMSFT meshUpdateInfo{XR_TYPE_HAND_MESH_UPDATE_INFO_MSFT};
             meshUpdateInfo.time = time;
-            meshUpdateInfo.handPoseType = XR_HAND_POSE_TYPE_TRACKED_MSFT;
-            CHECK_XRCMD(m_sceneContext.Extensions.xrUpdateHandMeshMSFT(handData.TrackerHandle.Get(), &meshUpdateInfo, &handData.meshState));
+            meshUpdateInfo.handPoseType = XR_HAND_POSE_TYPE_REFERENCE_OPEN_PALM_MSFT;
+            CHECK_XRCMD(m_sceneContext.Extensions.xrUpdateHandMeshMSFT(handData.TrackerHandle.Get(), &meshUpdateInfo, &mesh.meshState));
+
+            if (!mesh.meshState.isActive) {
+                return false;
+            }
+
+            if (mesh.meshState.indexBufferChanged || mesh.meshState.vertexBufferChanged || !mesh.MeshSceneObject) {
+                // Recalculate vertices color and joint weights based on neutral hand pose.
+                LocateReferenceJoints(handData, time);
+                ComputeHandMeshColor(handData, mesh);
+
+                Pbr::PrimitiveBuilder meshBuilder = CreateHandMeshPrimitiveBuilder(mesh.meshState.indexBuffer.indices,
+                                                                                   mesh.meshState.indexBuffer.indexCountOutput,
+                                                                                   mesh.meshState.vertexBuffer.vertices,
+                                                                                   mesh.meshState.vertexBuffer.vertexCountOutput,
+                                                                                   mesh.VertexColors);
+                ComputeHandMeshSkin(handData, meshBuilder);
+
+                // Each joint is a node posed in the scene space, and its inverse bind matrix maps the reference mesh into the joint.
+                auto surfaceModel = std::make_shared<Pbr::Model>();
+                std::vector<Pbr::NodeIndex_t> jointNodes(XR_HAND_JOINT_COUNT_EXT);
+                std::vector<XMFLOAT4X4> inverseBindMatrices(XR_HAND_JOINT_COUNT_EXT);
+                for (uint32_t k = 0; k < XR_HAND_JOINT_COUNT_EXT; k++) {
+                    jointNodes[k] = surfaceModel->AddNode(XMMatrixIdentity(), Pbr::RootNodeIndex, "joint");
+                    XMStoreFloat4x4(&inverseBindMatrices[k], xr::math::LoadInvertedXrPose(handData.ReferenceJointLocations[k].pose));
+                    handData.MeshJointNodeIndices[k] = jointNodes[k];
+                }
+                surfaceModel->AddSkin(jointNodes, inverseBindMatrices);
+                surfaceModel->AddPrimitive(Pbr::Primitive(m_sceneContext.PbrResources, meshBuilder, m_meshMaterial));
+
+                if (!mesh.MeshSceneObject) {
+                    mesh.MeshSceneObject = AddSceneObject(std::make_shared<PbrModelObject>(std::move(surfaceModel)));
+                } else {
+                    mesh.MeshSceneObject->SetModel(std::move(surfaceModel));
+                }
+            }
+
+            // Pose the joints with the tracked joint locations, which OnUpdate located in the scene space.
+            return PoseMeshJoints(handData);
+        }
+
+        // The joint that a hand joint moves with: the wrist for the metacarpals, the previous joint of the finger for the other
+        // finger joints, and the palm for the wrist. The palm has none.
+        static std::optional<uint32_t> GetParentJoint(uint32_t joint) {
+            switch (joint) {
+            case XR_HAND_JOINT_PALM_EXT:
+                return std::nullopt;
+            case XR_HAND_JOINT_WRIST_EXT:
+                return XR_HAND_JOINT_PALM_EXT;
+            case XR_HAND_JOINT_THUMB_METACARPAL_EXT:
+            case XR_HAND_JOINT_INDEX_METACARPAL_EXT:
+            case XR_HAND_JOINT_MIDDLE_METACARPAL_EXT:
+            case XR_HAND_JOINT_RING_METACARPAL_EXT:
+            case XR_HAND_JOINT_LITTLE_METACARPAL_EXT:
+                return XR_HAND_JOINT_WRIST_EXT;
+            default:
+                return joint - 1;
+            }
+        }
 
-            if (!handData.meshState.isActive) {
+        bool PoseMeshJoints(HandData& handData) {
+            if (!xr::math::Pose::IsPoseValid(handData.JointLocations[XR_HAND_JOINT_PALM_EXT])) {
                 return false;
             }
 
-            bool indicesChanged = handData.meshState.indexBufferChanged;
-            bool verticesChanged = handData.meshState.vertexBufferChanged;
+            // Joints that aren't tracked this frame, e.g. occluded fingers, keep their pose in the reference hand relative to their
+            // parent joint, instead of their pose of an earlier frame which would tear the mesh apart from the tracked joints.
+            // Parents come before their children, so their pose of this frame is already known.
+            const std::shared_ptr<Pbr::Model> surfaceModel = handData.SkinnedMesh.MeshSceneObject->GetModel();
+            std::array<XMFLOAT4X4, XR_HAND_JOINT_COUNT_EXT> jointTransforms;
+            for (uint32_t k = 0; k < XR_HAND_JOINT_COUNT_EXT; k++) {
+                XMMATRIX jointTransform;
+                if (xr::math::Pose::IsPoseValid(handData.JointLocations[k])) {
+                    jointTransform = xr::math::LoadXrPose(handData.JointLocations[k].pose);
+                } else {
+                    const uint32_t parent = GetParentJoint(k).value();
+                    const XMMATRIX referenceToParent =
+                        XMMatrixMultiply(xr::math::LoadXrPose(handData.ReferenceJointLocations[k].pose),
+                                         xr::math::LoadInvertedXrPose(handData.ReferenceJointLocations[parent].pose));
+                    jointTransform = XMMatrixMultiply(referenceToParent, XMLoadFloat4x4(&jointTransforms[parent]));
+                }
+                XMStoreFloat4x4(&jointTransforms[k], jointTransform);
+                surfaceModel->GetNode(handData.MeshJointNodeIndices[k]).SetTransform(jointTransform);
+            }
+            return true;
+        }
 
-            if (indicesChanged) {
+        bool UpdateTrackedMesh(HandData& handData, XrSpace referenceSpace, XrTime time) {
+            HandMesh& mesh = handData.TrackedMesh;
+            XrHandMeshUpdateInfoMSFT meshUpdateInfo{XR_TYPE_HAND_MESH_UPDATE_INFO_MSFT};
+            meshUpdateInfo.time = time;
+            meshUpdateInfo.handPoseType = XR_HAND_POSE_TYPE_TRACKED_MSFT;
+            CHECK_XRCMD(m_sceneContext.Extensions.xrUpdateHandMeshMSFT(handData.TrackerHandle.Get(), &meshUpdateInfo, &mesh.meshState));
+
+            if (!mesh.meshState.isActive) {
+                return false;
+            }
+
+            if (mesh.meshState.indexBufferChanged || !mesh.MeshSceneObject) {
                 // Index buffer is changed, recalculate vertices color based on neutral hand pose.
-                ComputeHandMeshColor(handData, time);
+                LocateReferenceJoints(handData, time);
+                ComputeHandMeshColor(handData, mesh);
             }
 
-            if (verticesChanged) {
-                Pbr::PrimitiveBuilder meshBuilder = CreateHandMeshPrimitiveBuilder(handData.meshState.indexBuffer.indices,
-                                                                                   handData.meshState.indexBuffer.indexCountOutput,
-                                                                                   handData.meshState.vertexBuffer.vertices,
-                                                                                   handData.meshState.vertexBuffer.vertexCountOutput,
-                                                                                   handData.VertexColors);
+            if (mesh.meshState.vertexBufferChanged || !mesh.MeshSceneObject) {
+                Pbr::PrimitiveBuilder meshBuilder = CreateHandMeshPrimitiveBuilder(mesh.meshState.indexBuffer.indices,
+                                                                                   mesh.meshState.indexBuffer.indexCountOutput,
+                                                                                   mesh.meshState.vertexBuffer.vertices,
+                                                                                   mesh.meshState.vertexBuffer.vertexCountOutput,
+                                                                                   mesh.VertexColors);
 
-                if (!handData.MeshSceneObject) {
+                if (!mesh.MeshSceneObject) {
                     // The hand mesh scene object doesn't exist yet and must be created.
-                    Pbr::Primitive surfacePrimitive(m_sceneContext.PbrResources, meshBuilder, m_meshMaterial, false /* updatableBuffers */);
+                    Pbr::Primitive surfacePrimitive(m_sceneContext.PbrResources, meshBuilder, m_meshMaterial, true /* updatableBuffers */);
 
                     auto surfaceModel = std::make_shared<Pbr::Model>();
                     surfaceModel->AddPrimitive(std::move(surfacePrimitive));
 
-                    handData.MeshSceneObject = AddSceneObject(std::make_shared<PbrModelObject>(surfaceModel));
+                    mesh.MeshSceneObject = AddSceneObject(std::make_shared<PbrModelObject>(std::move(surfaceModel)));
                 } else {
                     // Update vertices and indices of the existing hand mesh scene object's primitive.
-                    handData.MeshSceneObject->GetModel()->GetPrimitive(0).UpdateBuffers(
+                    mesh.MeshSceneObject->GetModel()->GetPrimitive(0).UpdateBuffers(
                         m_sceneContext.Device.get(), m_sceneContext.DeviceContext.get(), meshBuilder);
                 }
             }
 
-            if (handData.MeshSceneObject) {
-                XrSpaceLocation meshLocation{XR_TYPE_SPACE_LOCATION};
-                CHECK_XRCMD(xrLocateSpace(handData.MeshSpace.Get(), referenceSpace, time, &meshLocation));
-                if (xr::math::Pose::IsPoseValid(meshLocation)) {
-                    handData.MeshSceneObject->Pose() = meshLocation.pose;
-                    return true;
-                }
+            // The tracked mesh streams its vertices every frame. Trace its uploads per frame, averaged over a few seconds.
+            constexpr uint32_t StreamingStatsFrames = 300;
+            Pbr::Primitive& meshPrimitive = mesh.MeshSceneObject->GetModel()->GetPrimitive(0);
+            if (++mesh.StreamingStatsFrameCount == StreamingStatsFrames) {
+                const Pbr::StreamingGeometryStats stats = meshPrimitive.GetStreamingStats();
+                sample::Trace("Tracked hand mesh: {} bytes uploaded per frame, {} discards and {} reallocations in {} frames",
+                              stats.Buffers.UploadBytes / StreamingStatsFrames,
+                              stats.Buffers.Discards,
+                              stats.Buffers.Reallocations,
+                              StreamingStatsFrames);
+                meshPrimitive.ResetStreamingStats();
+                mesh.StreamingStatsFrameCount = 0;
             }
 
-            return false;
+            XrSpaceLocation meshLocation{XR_TYPE_SPACE_LOCATION};
+            CHECK_XRCMD(xrLocateSpace(handData.MeshSpace.Get(), referenceSpace, time, &meshLocation));
+            if (!xr::math::Pose::IsPoseValid(meshLocation)) {
+                return false;
+            }
+            mesh.MeshSceneObject->Pose() = meshLocation.pose;
+            return true;
         }
 
-        void ComputeHandMeshColor(HandData& handData, XrTime time) {
-            // Compute a color for each vertex on hand mesh based on relative position to an open palm reference hand.
-            // Use the middle finger tip and wrist joints to normalize the vertical range.
-            // Use the little finger tip and thumb tip joints to normalize the horizonal range.
-
+        void LocateReferenceJoints(HandData& handData, XrTime time) {
             XrHandPoseTypeInfoMSFT poseTypeInfo{XR_TYPE_HAND_POSE_TYPE_INFO_MSFT};
             poseTypeInfo.handPoseType = XR_HAND_POSE_TYPE_REFERENCE_OPEN_PALM_MSFT;
 
@@ -252,19 +378,24 @@ namespace {
             locateInfo.time = time;
 
             XrHandJointLocationsEXT locations{XR_TYPE_HAND_JOINT_LOCATIONS_EXT};
-            locations.jointCount = (uint32_t)handData.JointLocations.size();
-            locations.jointLocations = handData.JointLocations.data();
+            locations.jointCount = (uint32_t)handData.ReferenceJointLocations.size();
+            locations.jointLocations = handData.ReferenceJointLocations.data();
 
             CHECK_XRCMD(m_sceneContext.Extensions.xrLocateHandJointsEXT(handData.TrackerHandle.Get(), &locateInfo, &locations));
             assert(locations.isActive);
+        }
 
-            const XrVector3f& vZero = handData.JointLocations[XR_HAND_JOINT_MIDDLE_TIP_EXT].pose.position;
-            const XrVector3f& vOne = handData.JointLocations[XR_HAND_JOINT_WRIST_EXT].pose.position;
-            const XrVector3f& hZero = handData.JointLocations[XR_HAND_JOINT_LITTLE_TIP_EXT].pose.position;
-            const XrVector3f& hOne = handData.JointLocations[XR_HAND_JOINT_THUMB_TIP_EXT].pose.position;
+        void ComputeHandMeshColor(const HandData& handData, HandMesh& mesh) {
+            // Compute a color for each vertex on hand mesh based on relative position to an open palm reference hand.
+            // Use the middle finger tip and wrist joints to normalize the vertical range.
+            // Use the little finger tip and thumb tip joints to normalize the horizonal range.
+            const XrVector3f& vZero = handData.ReferenceJointLocations[XR_HAND_JOINT_MIDDLE_TIP_EXT].pose.position;
+            const XrVector3f& vOne = handData.ReferenceJointLocations[XR_HAND_JOINT_WRIST_EXT].pose.position;
+            const XrVector3f& hZero = handData.ReferenceJointLocations[XR_HAND_JOINT_LITTLE_TIP_EXT].pose.position;
+            const XrVector3f& hOne = handData.ReferenceJointLocations[XR_HAND_JOINT_THUMB_TIP_EXT].pose.position;
 
-            const XrHandMeshVertexBufferMSFT& vertexBuffer = handData.meshState.vertexBuffer;
-            handData.VertexColors.resize(vertexBuffer.vertexCountOutput);
+            const XrHandMeshVertexBufferMSFT& vertexBuffer = mesh.meshState.vertexBuffer;
+            mesh.VertexColors.resize(vertexBuffer.vertexCountOutput);
 
             // Calculate the normalized length of a vertex to a line segment defined by two point [zero, one].
             auto weight = [](const XrVector3f& v, const XrVector3f& zero, const XrVector3f& one) -> float {
@@ -281,7 +412,43 @@ namespace {
                 const float v = weight(vertexPosition, vZero, vOne);
                 const float h = weight(vertexPosition, hZero, hOne);
                 // Pick a simple psuedo color map to visualize figers in colors.
-                handData.VertexColors[i] = {v, (1 - h), h, 1};
+                mesh.VertexColors[i] = {v, (1 - h), h, 1};
+            }
+        }
+
+        void ComputeHandMeshSkin(const HandData& handData, Pbr::PrimitiveBuilder& builder) {
+            // Bind each vertex to the closest bone of the open palm reference hand, blending between the joints at both ends.
+            // The bones connect the wrist to each metacarpal, and each finger joint to the next one.
+            std::vector<std::pair<uint16_t, uint16_t>> bones;
+            for (uint16_t finger = XR_HAND_JOINT_THUMB_METACARPAL_EXT; finger < XR_HAND_JOINT_COUNT_EXT;) {
+                const uint16_t fingerJointCount = finger == XR_HAND_JOINT_THUMB_METACARPAL_EXT ? 4 : 5;
+                bones.emplace_back((uint16_t)XR_HAND_JOINT_WRIST_EXT, finger);
+                for (uint16_t joint = finger; joint + 1 < finger + fingerJointCount; joint++) {
+                    bones.emplace_back(joint, (uint16_t)(joint + 1));
+                }
+                finger += fingerJointCount;
+            }
+
+            builder.SkinVertices.resize(builder.Vertices.size());
+            for (size_t i = 0; i < builder.Vertices.size(); i++) {
+                const XMVECTOR position = XMLoadFloat3(&builder.Vertices[i].Position);
+                float closestDistanceSq = std::numeric_limits<float>::max();
+                for (const auto& [parent, child] : bones) {
+                    const XMVECTOR start = xr::math::LoadXrVector3(handData.ReferenceJointLocations[parent].pose.position);
+                    const XMVECTOR end = xr::math::LoadXrVector3(handData.ReferenceJointLocations[child].pose.position);
+                    const XMVECTOR bone = XMVectorSubtract(end, start);
+                    const float boneLengthSq = XMVectorGetX(XMVector3LengthSq(bone));
+                    const float projection = XMVectorGetX(XMVector3Dot(XMVectorSubtract(position, start), bone));
+                    const float t = boneLengthSq > 0 ? std::clamp(projection / boneLengthSq, 0.0f, 1.0f) : 0.0f;
+                    const XMVECTOR closestPoint = XMVectorMultiplyAdd(bone, XMVectorReplicate(t), start);
+                    const float distanceSq = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(position, closestPoint)));
+                    if (distanceSq < closestDistanceSq) {
+                        closestDistanceSq = distanceSq;
+                        const uint16_t childWeight = (uint16_t)std::lround(t * 65535);
+                        builder.SkinVertices[i].Joints = {parent, child, 0, 0};
+                        builder.SkinVertices[i].Weights = {(uint16_t)(65535 - childWeight), childWeight, 0, 0};
+                    }
+                }
             }
         }
 
@@ -309,7 +476,8 @@ namespace {
                 XMStoreFloat4(&vertex.Tangent, tangent);
 
                 XMStoreFloat2(&vertex.TexCoord0, g_XMZero);
-                vertex.ModelTransformIndex = Pbr::RootNodeIndex; // Index into the node transforms
+                // Index into the node transforms. Skinned vertices are relative to the root.
+                vertex.ModelTransformIndex = Pbr::RootNodeIndex;
             }
 
             return builder;
@@ -339,8 +507,8 @@ namespace {
             std::optional<bool> m_lastState{};
         };
 
-        enum class HandDisplayMode { Mesh, Joints, Count };
-        HandDisplayMode m_mode{HandDisplayMode::Mesh};
+        enum class HandDisplayMode { SkinnedMesh, TrackedMesh, Joints, Count };
+        HandDisplayMode m_mode{HandDisplayMode::SkinnedMesh};
 
         std::shared_ptr<Pbr::Material> m_meshMaterial, m_jointMaterial;
 
@@ -46,6 +46,17 @@ namespace sample {
         }
     }
 
+    void WriteFileBytes(const std::filesystem::path& path, const std::vector<uint8_t>& data) {
+        try {
+            std::ofstream file;
+            file.exceptions(std::ios::failbit | std::ios::badbit);
+            file.open(path, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        } catch (const std::ios::failure&) {
+            throw std::runtime_error(fmt::format("Failed to write file: {}", path.string()));
+        }
+    }
+
     std::filesystem::path GetAppFolder() {
         HMODULE thisModule;
 #ifdef UWP
@@ -92,12 +103,77 @@ namespace sample {
         return "";
     }
 
+    namespace {
+        // The cache file is named after the size and time of the environment map, so that a changed map is precomputed again.
+        std::filesystem::path GetPrecomputedLightingCachePath(const std::filesystem::path& environmentMapPath) {
+            std::string filename = "PbrPrecomputedLighting.bin";
+            if (!environmentMapPath.empty()) {
+                filename = fmt::format("PbrPrecomputedLighting_{:x}_{:x}.bin",
+                                       std::filesystem::file_size(environmentMapPath),
+                                       std::filesystem::last_write_time(environmentMapPath).time_since_epoch().count());
+            }
+            return std::filesystem::temp_directory_path() / filename;
+        }
+
+        // The BRDF lookup table and, given a radiance environment map, its diffuse irradiance and prefiltered specular map.
+        // Throws if the environment map can't be read, such as for DDS formats that Pbr::Ibl doesn't decode.
+        Pbr::PrecomputedLighting LoadPrecomputedLighting(const std::filesystem::path& environmentMapPath) {
+            const std::filesystem::path cachePath = GetPrecomputedLightingCachePath(environmentMapPath);
+            if (std::filesystem::exists(cachePath)) {
+                try {
+                    const std::vector<uint8_t> data = ReadFileBytes(cachePath);
+                    return Pbr::Ibl::Read(data.data(), data.size());
+                } catch (const std::exception& ex) {
+                    sample::Trace("Precomputing the lighting again, the cache is unusable: {}", ex.what());
+                }
+            }
+
+            Pbr::PrecomputedLighting lighting;
+            lighting.BrdfLutSize = Pbr::Ibl::DefaultBrdfLutSize;
+            lighting.BrdfLut = Pbr::Ibl::ComputeBrdfLut(lighting.BrdfLutSize, Pbr::Ibl::DefaultBrdfSampleCount);
+            if (!environmentMapPath.empty()) {
+                const std::vector<uint8_t> data = ReadFileBytes(environmentMapPath);
+                const Pbr::CubeMap radiance = Pbr::Ibl::ReadDdsCubeMap(data.data(), data.size());
+                lighting.DiffuseIrradiance = Pbr::Ibl::ComputeIrradiance(radiance);
+                lighting.Specular = Pbr::Ibl::PrefilterSpecular(
+                    radiance, std::min(radiance.Size, Pbr::Ibl::DefaultSpecularSize), Pbr::Ibl::DefaultSpecularSampleCount);
+            }
+
+            // The results are still usable when they can't be cached.
+            try {
+                WriteFileBytes(cachePath, Pbr::Ibl::Write(lighting));
+            } catch (const std::exception& ex) {
+                sample::Trace("Failed to cache the precomputed lighting: {}", ex.what());
+            }
+            return lighting;
+        }
+    } // namespace
+
     Pbr::Resources InitializePbrResources(ID3D11Device* device, bool environmentIBL) {
         Pbr::Resources pbrResources(device);
 
         // Set up a light source (an image-based lighting environment map will also be loaded and contribute to the scene lighting).
         pbrResources.SetLight({0.0f, 0.7071067811865475f, 0.7071067811865475f}, Pbr::RGB::White);
 
+        const std::filesystem::path environmentMapPath =
+            environmentIBL ? FindFileInAppFolder(L"Sample_SpecularHDR.DDS", {"", "SampleShared_uwp"}) : std::filesystem::path();
+        try {
+            const Pbr::PrecomputedLighting lighting = LoadPrecomputedLighting(environmentMapPath);
+            pbrResources.SetBrdfLut(Pbr::Texture::CreateBrdfLutTexture(device, lighting.BrdfLut, lighting.BrdfLutSize).get());
+            if (environmentIBL) {
+                const winrt::com_ptr<ID3D11ShaderResourceView> specularTextureView =
+                    Pbr::Texture::CreateCubeTexture(device, lighting.Specular);
+                pbrResources.SetEnvironmentMap(specularTextureView.get(), lighting.DiffuseIrradiance);
+            } else {
+                const winrt::com_ptr<ID3D11ShaderResourceView> flatTextureView =
+                    Pbr::Texture::CreateFlatCubeTexture(device, Pbr::RGBA::White);
+                pbrResources.SetEnvironmentMap(flatTextureView.get(), flatTextureView.get());
+            }
+            return pbrResources;
+        } catch (const std::exception& ex) {
+            sample::Trace("Loading the shipped lighting textures, the lighting can't be precomputed: {}", ex.what());
+        }
+
         // Read the BRDF Lookup Table used by the PBR system into a DirectX texture.
         std::vector<byte> brdfLutFileData = ReadFileBytes(FindFileInAppFolder(L"brdf_lut.png", {"", L"Pbr_uwp"}));
         winrt::com_ptr<ID3D11ShaderResourceView> brdLutResourceView =
@@ -24,6 +24,9 @@ namespace Pbr {
 namespace sample {
     std::vector<uint8_t> ReadFileBytes(const std::filesystem::path& path);
 
+    // Write the data to a file, replacing the file if it exists.
+    void WriteFileBytes(const std::filesystem::path& path, const std::vector<uint8_t>& data);
+
     // Get a path in app folder, the path might not exist
     std::filesystem::path GetPathInAppFolder(const std::filesystem::path& filename);
 
@@ -32,5 +35,7 @@ namespace sample {
     std::filesystem::path FindFileInAppFolder(const std::filesystem::path& filename,
                                               const std::vector<std::filesystem::path>& searchFolders = {""});
 
+    // Create the PBR resources with the BRDF lookup table and, if environmentIBL is set, the image-based lighting of the sample
+    // environment map. Both are precomputed on the first launch and cached in the temp folder.
     Pbr::Resources InitializePbrResources(ID3D11Device* device, bool environmentIBL = true);
 } // namespace sample
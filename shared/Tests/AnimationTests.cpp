@@ -0,0 +1,182 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <pbr/PbrAnimation.h>
+#include <pbr/PbrModel.h>
+
+using namespace DirectX;
+
+namespace {
+    Pbr::AnimationChannel MakeChannel(Pbr::NodeIndex_t node,
+                                      Pbr::AnimationPath path,
+                                      Pbr::AnimationInterpolation interpolation,
+                                      std::vector<float> times,
+                                      std::vector<XMFLOAT4A> values) {
+        Pbr::AnimationChannel channel;
+        channel.TargetNode = node;
+        channel.Path = path;
+        channel.Interpolation = interpolation;
+        channel.Times = std::move(times);
+        channel.Values = std::move(values);
+        return channel;
+    }
+
+    // A model with one scaled node under the root, and a clip for the tests to add channels on that node to.
+    struct AnimatedNode {
+        std::shared_ptr<Pbr::Model> Model = std::make_shared<Pbr::Model>();
+        Pbr::NodeIndex_t Node = Model->AddNode(XMMatrixScaling(2, 2, 2), Pbr::RootNodeIndex);
+        std::shared_ptr<Pbr::AnimationClip> Clip = std::make_shared<Pbr::AnimationClip>();
+
+        XMFLOAT3 PoseAt(Pbr::AnimationPlayer& player, float time, XMFLOAT3 point = {0, 0, 0}) {
+            player.SetTime(time);
+            player.Apply();
+            XMFLOAT3 result;
+            XMStoreFloat3(&result, XMVector3TransformCoord(XMLoadFloat3(&point), Model->GetNode(Node).GetTransform()));
+            return result;
+        }
+    };
+
+    // A clip of channelCount channels over nodes of the model, each animating one path with keyCount keys over 4 seconds.
+    // One in ten channels is a cubic spline, the others are linear.
+    std::shared_ptr<Pbr::AnimationClip> CreateClip(uint32_t nodeCount,
+                                                   uint32_t channelCount,
+                                                   uint32_t keyCount,
+                                                   std::minstd_rand& random) {
+        std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+        auto clip = std::make_shared<Pbr::AnimationClip>();
+        for (uint32_t c = 0; c < channelCount; c++) {
+            const auto path = (Pbr::AnimationPath)(c % 3);
+            const auto interpolation = c % 10 == 0 ? Pbr::AnimationInterpolation::CubicSpline : Pbr::AnimationInterpolation::Linear;
+            std::vector<float> times(keyCount);
+            std::vector<XMFLOAT4A> values;
+            for (uint32_t k = 0; k < keyCount; k++) {
+                times[k] = 4.0f * k / (keyCount - 1);
+                for (int v = 0; v < (interpolation == Pbr::AnimationInterpolation::CubicSpline ? 3 : 1); v++) {
+                    XMFLOAT4A element;
+                    XMStoreFloat4A(&element, path == Pbr::AnimationPath::Rotation
+                                                 ? XMQuaternionNormalize(XMVectorSet(value(random), value(random), value(random), 1))
+                                                 : XMVectorSet(value(random), value(random), value(random), 0));
+                    values.push_back(element);
+                }
+            }
+            clip->AddChannel(MakeChannel(1 + c / 3 % nodeCount, path, interpolation, std::move(times), std::move(values)));
+        }
+        return clip;
+    }
+} // namespace
+
+TEST_CASE(Animation_LinearAndStepTranslation) {
+    AnimatedNode animated;
+    animated.Clip->AddChannel(MakeChannel(animated.Node,
+                                          Pbr::AnimationPath::Translation,
+                                          Pbr::AnimationInterpolation::Linear,
+                                          {1, 2, 4},
+                                          {{0, 0, 0, 0}, {10, 0, 0, 0}, {10, 20, 0, 0}}));
+    Pbr::AnimationPlayer player(animated.Clip, animated.Model);
+    CHECK_EQUAL(4.0f, animated.Clip->GetDuration());
+
+    CHECK_NEAR(0.0f, animated.PoseAt(player, 0.5f).x, 1e-5f); // Before the first key.
+    CHECK_NEAR(5.0f, animated.PoseAt(player, 1.5f).x, 1e-5f);
+    CHECK_NEAR(10.0f, animated.PoseAt(player, 3.0f).y, 1e-5f);
+    CHECK_NEAR(2.5f, animated.PoseAt(player, 1.25f).x, 1e-5f); // Backwards past the cached key.
+
+    // The scale of the rest pose is kept, since the clip doesn't animate it.
+    CHECK_NEAR(7.0f, animated.PoseAt(player, 1.5f, {1, 0, 0}).x, 1e-5f);
+
+    AnimatedNode stepped;
+    stepped.Clip->AddChannel(MakeChannel(
+        stepped.Node, Pbr::AnimationPath::Translation, Pbr::AnimationInterpolation::Step, {0, 1}, {{1, 0, 0, 0}, {3, 0, 0, 0}}));
+    Pbr::AnimationPlayer stepPlayer(stepped.Clip, stepped.Model);
+    stepPlayer.Looping = false;
+    CHECK_NEAR(1.0f, stepped.PoseAt(stepPlayer, 0.99f).x, 1e-5f);
+    CHECK_NEAR(3.0f, stepped.PoseAt(stepPlayer, 5.0f).x, 1e-5f);
+}
+
+TEST_CASE(Animation_RotationSlerpAndCubicSpline) {
+    AnimatedNode animated;
+    XMFLOAT4A quarterTurn;
+    XMStoreFloat4A(&quarterTurn, XMQuaternionRotationRollPitchYaw(0, XM_PIDIV2, 0));
+    animated.Clip->AddChannel(MakeChannel(
+        animated.Node, Pbr::AnimationPath::Rotation, Pbr::AnimationInterpolation::Linear, {0, 1}, {{0, 0, 0, 1}, quarterTurn}));
+
+    // Zero tangents ease in and out: the value is halfway at the middle and a quarter of the way is less than a quarter.
+    animated.Clip->AddChannel(MakeChannel(animated.Node,
+                                          Pbr::AnimationPath::Scale,
+                                          Pbr::AnimationInterpolation::CubicSpline,
+                                          {0, 1},
+                                          {{0, 0, 0, 0}, {1, 1, 1, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {3, 3, 3, 0}, {0, 0, 0, 0}}));
+    Pbr::AnimationPlayer player(animated.Clip, animated.Model);
+
+    // Half a quarter turn around Y with a scale of 2 moves (1, 0, 0) to 2 * (cos 45, 0, -sin 45).
+    const XMFLOAT3 halfway = animated.PoseAt(player, 0.5f, {1, 0, 0});
+    CHECK_NEAR(2 * 0.70710678f, halfway.x, 1e-4f);
+    CHECK_NEAR(-2 * 0.70710678f, halfway.z, 1e-4f);
+
+    const XMFLOAT3 quarter = animated.PoseAt(player, 0.25f, {0, 1, 0});
+    CHECK(quarter.y > 1.0f && quarter.y < 1.5f);
+}
+
+TEST_CASE(Animation_LoopingWrapsTime) {
+    AnimatedNode animated;
+    animated.Clip->AddChannel(MakeChannel(
+        animated.Node, Pbr::AnimationPath::Translation, Pbr::AnimationInterpolation::Linear, {0, 2}, {{0, 0, 0, 0}, {2, 0, 0, 0}}));
+    Pbr::AnimationPlayer player(animated.Clip, animated.Model);
+    player.SetTime(2.5f);
+    CHECK_NEAR(0.5f, player.GetTime(), 1e-5f);
+    player.SetTime(-0.5f);
+    CHECK_NEAR(1.5f, player.GetTime(), 1e-5f);
+
+    player.Looping = false;
+    player.SetTime(1.0f);
+    player.Advance(3.0f);
+    CHECK_EQUAL(2.0f, player.GetTime());
+}
+
+TEST_CASE(Animation_InvalidChannelsThrow) {
+    Pbr::AnimationClip clip;
+    CHECK_THROWS(clip.AddChannel(MakeChannel(1, Pbr::AnimationPath::Translation, Pbr::AnimationInterpolation::Linear, {}, {})),
+                 std::exception);
+    CHECK_THROWS(clip.AddChannel(MakeChannel(
+                     1, Pbr::AnimationPath::Translation, Pbr::AnimationInterpolation::Linear, {1, 0}, {{0, 0, 0, 0}, {0, 0, 0, 0}})),
+                 std::exception);
+    CHECK_THROWS(clip.AddChannel(MakeChannel(
+                     1, Pbr::AnimationPath::Scale, Pbr::AnimationInterpolation::CubicSpline, {0, 1}, {{0, 0, 0, 0}, {0, 0, 0, 0}})),
+                 std::exception);
+
+    // Channels targeting nodes the model doesn't have.
+    clip.AddChannel(MakeChannel(5, Pbr::AnimationPath::Translation, Pbr::AnimationInterpolation::Step, {0}, {{0, 0, 0, 0}}));
+    CHECK_THROWS(Pbr::AnimationPlayer(std::make_shared<Pbr::AnimationClip>(clip), std::make_shared<Pbr::Model>()), std::out_of_range);
+}
+
+// 100 players of 100 channels with 120 keys each, 10% of them cubic splines, advanced by 90 Hz frames.
+BENCHMARK(Animation_UpdateAnimations) {
+    constexpr uint32_t PlayerCount = 100, ChannelCount = 100, KeyCount = 120, NodeCount = 34;
+    std::minstd_rand random(43);
+    const std::shared_ptr<Pbr::AnimationClip> clip = CreateClip(NodeCount, ChannelCount, KeyCount, random);
+
+    std::vector<std::unique_ptr<Pbr::AnimationPlayer>> players;
+    std::vector<Pbr::AnimationPlayer*> playerPointers;
+    for (uint32_t i = 0; i < PlayerCount; i++) {
+        auto model = std::make_shared<Pbr::Model>();
+        for (uint32_t node = 0; node < NodeCount; node++) {
+            model->AddNode(XMMatrixIdentity(), Pbr::RootNodeIndex);
+        }
+        players.push_back(std::make_unique<Pbr::AnimationPlayer>(clip, model));
+        players.back()->SetTime(i * 0.04f); // Spread the players over the clip.
+        playerPointers.push_back(players.back().get());
+    }
+
+    constexpr float FrameSeconds = 1.0f / 90;
+    const double serialMicroseconds = Test::MeasureMicroseconds([&] {
+        for (Pbr::AnimationPlayer* player : playerPointers) {
+            player->Advance(FrameSeconds);
+            player->Apply();
+        }
+    });
+    const double parallelMicroseconds = Test::MeasureMicroseconds([&] { Pbr::UpdateAnimations(playerPointers, FrameSeconds); });
+
+    Test::ReportMetric("One thread", serialMicroseconds, "us/frame");
+    Test::ReportMetric("One thread, per channel", serialMicroseconds * 1000 / (PlayerCount * ChannelCount), "ns");
+    Test::ReportMetric("UpdateAnimations", parallelMicroseconds, "us/frame");
+}
@@ -0,0 +1,369 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <limits>
+#include <set>
+#include <pbr/PbrBlockCompression.h>
+
+using namespace Pbr;
+
+namespace {
+    constexpr BlockFormat AllFormats[] = {BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7};
+
+    // The channels each format stores, as a ComputePsnr channel mask.
+    uint32_t GetChannelMask(BlockFormat format) {
+        switch (format) {
+        case BlockFormat::BC1:
+            return 0x7;
+        case BlockFormat::BC4:
+            return 0x1;
+        case BlockFormat::BC5:
+            return 0x3;
+        default:
+            return 0xF;
+        }
+    }
+
+    // Smooth color and alpha gradients with some texel noise, like a photographic texture.
+    std::vector<uint8_t> PhotoLikeImage(uint32_t width, uint32_t height, uint32_t seed) {
+        std::minstd_rand random(seed);
+        std::uniform_int_distribution<int> noise(-6, 6);
+        std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                const float u = (float)x / width;
+                const float v = (float)y / height;
+                const float base[4] = {0.5f + 0.4f * std::sin(u * 9.0f),
+                                       0.5f + 0.4f * std::cos(v * 7.0f),
+                                       0.5f + 0.4f * std::sin((u + v) * 5.0f),
+                                       0.5f + 0.5f * std::sin(u * 3.0f + v * 2.0f)};
+                for (uint32_t c = 0; c < 4; c++) {
+                    rgba[(static_cast<size_t>(y) * width + x) * 4 + c] =
+                        static_cast<uint8_t>(std::clamp((int)(base[c] * 255.0f) + noise(random), 0, 255));
+                }
+            }
+        }
+        return rgba;
+    }
+
+    // A tangent space normal map of bumps, encoded as 0.5 + 0.5 * n like glTF normal textures.
+    std::vector<uint8_t> NormalMapImage(uint32_t width, uint32_t height) {
+        std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                const DirectX::XMVECTOR normal = DirectX::XMVector3Normalize(
+                    DirectX::XMVectorSet(0.6f * std::sin(x * 0.2f), 0.6f * std::cos(y * 0.15f), 1.0f, 0.0f));
+                DirectX::XMFLOAT3 n;
+                DirectX::XMStoreFloat3(&n, normal);
+                uint8_t* texel = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+                texel[0] = static_cast<uint8_t>(std::lround((n.x * 0.5f + 0.5f) * 255.0f));
+                texel[1] = static_cast<uint8_t>(std::lround((n.y * 0.5f + 0.5f) * 255.0f));
+                texel[2] = static_cast<uint8_t>(std::lround((n.z * 0.5f + 0.5f) * 255.0f));
+                texel[3] = 255;
+            }
+        }
+        return rgba;
+    }
+
+    // The normal of a texel of a two-channel normal map, with Z reconstructed as the pixel shader does.
+    DirectX::XMVECTOR ReconstructNormal(const uint8_t* texel) {
+        const float x = texel[0] / 255.0f * 2.0f - 1.0f;
+        const float y = texel[1] / 255.0f * 2.0f - 1.0f;
+        const float z = std::sqrt(std::clamp(1.0f - x * x - y * y, 0.0f, 1.0f));
+        return DirectX::XMVector3Normalize(DirectX::XMVectorSet(x, y, z, 0.0f));
+    }
+
+    // Writes the fields of a BC7 block, least significant bit first.
+    struct Bc7BlockWriter {
+        std::array<uint8_t, 16> Block{};
+        uint32_t Position{0};
+
+        Bc7BlockWriter& Write(uint32_t value, uint32_t bitCount) {
+            for (uint32_t i = 0; i < bitCount; i++, Position++) {
+                Block[Position >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (Position & 7));
+            }
+            return *this;
+        }
+    };
+
+    std::vector<uint8_t> RoundTrip(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, BlockFormat format) {
+        const std::vector<uint8_t> blocks = BlockCompression::Compress(rgba.data(), width, height, format);
+        return BlockCompression::Decompress(blocks.data(), width, height, format);
+    }
+} // namespace
+
+TEST_CASE(BlockCompression_BlockAndRowSizes) {
+    CHECK_EQUAL(8u, BlockCompression::GetBlockByteSize(BlockFormat::BC1));
+    CHECK_EQUAL(8u, BlockCompression::GetBlockByteSize(BlockFormat::BC4));
+    CHECK_EQUAL(16u, BlockCompression::GetBlockByteSize(BlockFormat::BC3));
+    CHECK_EQUAL(16u, BlockCompression::GetBlockByteSize(BlockFormat::BC5));
+    CHECK_EQUAL(16u, BlockCompression::GetBlockByteSize(BlockFormat::BC7));
+
+    CHECK_EQUAL(8u, BlockCompression::GetRowPitch(BlockFormat::BC1, 1));
+    CHECK_EQUAL(16u, BlockCompression::GetRowPitch(BlockFormat::BC1, 5));
+    CHECK_EQUAL(64u, BlockCompression::GetRowPitch(BlockFormat::BC7, 16));
+
+    for (BlockFormat format : AllFormats) {
+        const std::vector<uint8_t> image(9 * 6 * 4, 128);
+        const std::vector<uint8_t> blocks = BlockCompression::Compress(image.data(), 9, 6, format);
+        CHECK_EQUAL(size_t{BlockCompression::GetRowPitch(format, 9)} * 2, blocks.size());
+    }
+}
+
+TEST_CASE(BlockCompression_RoundTripQuality) {
+    constexpr uint32_t Size = 64;
+    const std::vector<uint8_t> image = PhotoLikeImage(Size, Size, 1);
+
+    // Minimum PSNR in dB over the channels each format stores. The texel noise keeps all formats well below 40 dB.
+    const std::pair<BlockFormat, double> expectations[] = {
+        {BlockFormat::BC1, 30}, {BlockFormat::BC3, 30}, {BlockFormat::BC4, 40}, {BlockFormat::BC5, 40}, {BlockFormat::BC7, 32}};
+    std::vector<double> psnrs;
+    for (const auto& [format, minPsnr] : expectations) {
+        const std::vector<uint8_t> decoded = RoundTrip(image, Size, Size, format);
+        psnrs.push_back(BlockCompression::ComputePsnr(image.data(), decoded.data(), Size * Size, GetChannelMask(format)));
+        CHECK(psnrs.back() >= minPsnr);
+    }
+
+    // BC7 has 16 palette entries against the 4 of BC1 and BC3, and its RGBA endpoints are more precise than 5:6:5.
+    CHECK(psnrs[4] > psnrs[0]);
+    CHECK(psnrs[4] > psnrs[1]);
+}
+
+TEST_CASE(BlockCompression_AbsentChannelsDecodeToDefaults) {
+    const std::vector<uint8_t> image = PhotoLikeImage(8, 8, 2);
+    const std::vector<uint8_t> bc1 = RoundTrip(image, 8, 8, BlockFormat::BC1);
+    const std::vector<uint8_t> bc4 = RoundTrip(image, 8, 8, BlockFormat::BC4);
+    const std::vector<uint8_t> bc5 = RoundTrip(image, 8, 8, BlockFormat::BC5);
+    for (size_t texel = 0; texel < 64; texel++) {
+        CHECK_EQUAL(255, (int)bc1[texel * 4 + 3]);
+        CHECK_EQUAL(0, (int)bc4[texel * 4 + 1]);
+        CHECK_EQUAL(0, (int)bc4[texel * 4 + 2]);
+        CHECK_EQUAL(255, (int)bc4[texel * 4 + 3]);
+        CHECK_EQUAL(0, (int)bc5[texel * 4 + 2]);
+        CHECK_EQUAL(255, (int)bc5[texel * 4 + 3]);
+    }
+}
+
+TEST_CASE(BlockCompression_SolidColorsAreExact) {
+    // Colors that 5:6:5 endpoints represent exactly, so BC1 to BC5 round-trip them without error. BC7 mode 6 shares the
+    // p-bit of an endpoint between its channels, so a color mixing 0 and 255 is off by at most one.
+    const std::array<uint8_t, 4> colors[] = {{0, 0, 0, 255}, {255, 255, 255, 255}, {255, 0, 255, 0}, {0, 255, 0, 128}};
+    for (const std::array<uint8_t, 4>& color : colors) {
+        std::vector<uint8_t> image(8 * 8 * 4);
+        for (size_t i = 0; i < image.size(); i++) {
+            image[i] = color[i % 4];
+        }
+
+        for (BlockFormat format : AllFormats) {
+            const std::vector<uint8_t> decoded = RoundTrip(image, 8, 8, format);
+            if (format == BlockFormat::BC7) {
+                for (size_t i = 0; i < image.size(); i++) {
+                    CHECK(std::abs(image[i] - decoded[i]) <= 1);
+                }
+            } else {
+                CHECK(std::isinf(BlockCompression::ComputePsnr(image.data(), decoded.data(), 64, GetChannelMask(format))));
+            }
+        }
+    }
+}
+
+TEST_CASE(BlockCompression_PartialBlocksKeepTheImageSize) {
+    // 5x3 pads to 8x4 blocks by repeating edge texels, so it compresses like the 8x4 image with its edges repeated, and
+    // decodes to the top left 5x3 texels of that image.
+    const std::vector<uint8_t> image = PhotoLikeImage(5, 3, 3);
+    std::vector<uint8_t> padded(8 * 4 * 4);
+    for (uint32_t y = 0; y < 4; y++) {
+        for (uint32_t x = 0; x < 8; x++) {
+            const uint8_t* source = &image[(std::min(y, 2u) * 5 + std::min(x, 4u)) * 4];
+            std::copy(source, source + 4, &padded[(y * 8 + x) * 4]);
+        }
+    }
+
+    for (BlockFormat format : AllFormats) {
+        CHECK(BlockCompression::Compress(image.data(), 5, 3, format) == BlockCompression::Compress(padded.data(), 8, 4, format));
+
+        const std::vector<uint8_t> decoded = RoundTrip(image, 5, 3, format);
+        const std::vector<uint8_t> decodedPadded = RoundTrip(padded, 8, 4, format);
+        CHECK_EQUAL(image.size(), decoded.size());
+        for (uint32_t y = 0; y < 3; y++) {
+            const auto row = decoded.begin() + y * 5 * 4;
+            CHECK(std::equal(row, row + 5 * 4, decodedPadded.begin() + y * 8 * 4));
+        }
+    }
+}
+
+TEST_CASE(BlockCompression_Bc7DecodesSaturatedBlocksOfAllModesToWhite) {
+    // After the mode bits, every field set to ones gives endpoints of 255 in all channels whatever the partition, rotation,
+    // p-bits and indices are. Modes without alpha decode to opaque.
+    for (uint32_t mode = 0; mode < 8; mode++) {
+        Bc7BlockWriter writer;
+        writer.Write(1u << mode, mode + 1);
+        while (writer.Position < 128) {
+            writer.Write(1, 1);
+        }
+        const std::vector<uint8_t> decoded = BlockCompression::Decompress(writer.Block.data(), 4, 4, BlockFormat::BC7);
+        CHECK(std::all_of(decoded.begin(), decoded.end(), [](uint8_t value) { return value == 255; }));
+    }
+
+    // A first byte of zero is a reserved mode, which decodes to transparent black.
+    const std::array<uint8_t, 16> reserved{0, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    const std::vector<uint8_t> decoded = BlockCompression::Decompress(reserved.data(), 4, 4, BlockFormat::BC7);
+    CHECK(std::all_of(decoded.begin(), decoded.end(), [](uint8_t value) { return value == 0; }));
+}
+
+TEST_CASE(BlockCompression_Bc7SeparateAlphaWithRotation) {
+    // Mode 5: red 127 to 0, green 64, blue 0 and alpha 255 to 0, all 7-bit color index 0 and alpha index 3 except for the
+    // anchor texel 0, whose index has one bit less and is 0.
+    for (uint32_t rotation : {0u, 1u}) {
+        Bc7BlockWriter writer;
+        writer.Write(1 << 5, 6).Write(rotation, 2);
+        writer.Write(127, 7).Write(0, 7).Write(64, 7).Write(64, 7).Write(0, 7).Write(0, 7);
+        writer.Write(255, 8).Write(0, 8);
+        writer.Write(0, 1).Write(0, 30);
+        writer.Write(0, 1);
+        for (uint32_t i = 1; i < 16; i++) {
+            writer.Write(3, 2);
+        }
+        CHECK_EQUAL(128u, writer.Position);
+
+        // 7-bit endpoints expand by replicating their high bits: 127 is 255 and 64 is 129.
+        const std::vector<uint8_t> decoded = BlockCompression::Decompress(writer.Block.data(), 4, 4, BlockFormat::BC7);
+        for (size_t texel = 0; texel < 16; texel++) {
+            const uint8_t alpha = texel == 0 ? 255 : 0;
+            CHECK_EQUAL(rotation == 1 ? alpha : 255, (int)decoded[texel * 4 + 0]);
+            CHECK_EQUAL(129, (int)decoded[texel * 4 + 1]);
+            CHECK_EQUAL(0, (int)decoded[texel * 4 + 2]);
+            CHECK_EQUAL(rotation == 1 ? 255 : alpha, (int)decoded[texel * 4 + 3]);
+        }
+    }
+
+    // Mode 4: red and alpha from 0 to 31 and 63, which expand to 255, with 2-bit indices of 3 (1 for the anchor texel) and
+    // 3-bit indices of 2. The index selection bit swaps which of them color and alpha use.
+    for (uint32_t indexSelection : {0u, 1u}) {
+        Bc7BlockWriter writer;
+        writer.Write(1 << 4, 5).Write(0, 2).Write(indexSelection, 1);
+        writer.Write(0, 5).Write(31, 5).Write(0, 20);
+        writer.Write(0, 6).Write(63, 6);
+        writer.Write(1, 1);
+        for (uint32_t i = 1; i < 16; i++) {
+            writer.Write(3, 2);
+        }
+        writer.Write(2, 2);
+        for (uint32_t i = 1; i < 16; i++) {
+            writer.Write(2, 3);
+        }
+        CHECK_EQUAL(128u, writer.Position);
+
+        // The 2-bit weights are 0, 21, 43 and 64 of 64, and 3-bit index 2 weighs 18 of 64.
+        const std::vector<uint8_t> decoded = BlockCompression::Decompress(writer.Block.data(), 4, 4, BlockFormat::BC7);
+        for (size_t texel = 0; texel < 16; texel++) {
+            const int twoBit = texel == 0 ? 84 : 255;
+            CHECK_EQUAL(indexSelection ? 72 : twoBit, (int)decoded[texel * 4 + 0]);
+            CHECK_EQUAL(indexSelection ? twoBit : 72, (int)decoded[texel * 4 + 3]);
+        }
+    }
+}
+
+TEST_CASE(BlockCompression_Bc7Partitions) {
+    // Mode 1 has two subsets. With zero indices, every texel takes the first endpoint of its subset: red 0 for the first
+    // subset, and red 63 with a p-bit of 1 (255) for the second.
+    std::set<uint32_t> masks;
+    for (uint32_t partition = 0; partition < 64; partition++) {
+        Bc7BlockWriter writer;
+        writer.Write(1 << 1, 2).Write(partition, 6);
+        writer.Write(0, 6).Write(0, 6).Write(63, 6).Write(0, 6).Write(0, 48);
+        writer.Write(0, 1).Write(1, 1);
+        writer.Write(0, 46);
+        CHECK_EQUAL(128u, writer.Position);
+
+        const std::vector<uint8_t> decoded = BlockCompression::Decompress(writer.Block.data(), 4, 4, BlockFormat::BC7);
+        uint32_t mask = 0;
+        for (uint32_t texel = 0; texel < 16; texel++) {
+            CHECK(decoded[texel * 4] == 0 || decoded[texel * 4] == 255);
+            mask |= decoded[texel * 4] == 255 ? 1u << texel : 0;
+        }
+        CHECK((mask & 1) == 0); // Texel 0 is always in the first subset.
+        CHECK(mask != 0);
+        masks.insert(mask);
+
+        // The right half, and the bottom half.
+        CHECK(partition != 0 || mask == 0xCCCC);
+        CHECK(partition != 13 || mask == 0xFF00);
+    }
+    CHECK_EQUAL(size_t{64}, masks.size());
+
+    // Mode 2 has three subsets, here with red 31 (255) for the second and green 31 for the third.
+    std::set<std::vector<uint32_t>> subsetsOfPartitions;
+    for (uint32_t partition = 0; partition < 64; partition++) {
+        Bc7BlockWriter writer;
+        writer.Write(1 << 2, 3).Write(partition, 6);
+        writer.Write(0, 10).Write(31, 5).Write(0, 15);
+        writer.Write(0, 20).Write(31, 5).Write(0, 5);
+        writer.Write(0, 30);
+        writer.Write(0, 29);
+        CHECK_EQUAL(128u, writer.Position);
+
+        const std::vector<uint8_t> decoded = BlockCompression::Decompress(writer.Block.data(), 4, 4, BlockFormat::BC7);
+        std::vector<uint32_t> subsets(16);
+        for (uint32_t texel = 0; texel < 16; texel++) {
+            subsets[texel] = decoded[texel * 4] == 255 ? 1 : decoded[texel * 4 + 1] == 255 ? 2 : 0;
+        }
+        CHECK_EQUAL(0u, subsets[0]);
+        for (uint32_t subset = 0; subset < 3; subset++) {
+            CHECK(std::find(subsets.begin(), subsets.end(), subset) != subsets.end());
+        }
+        subsetsOfPartitions.insert(subsets);
+
+        // Two rows of the first subset, then a row of each of the others.
+        CHECK(partition != 8 || subsets == (std::vector<uint32_t>{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2}));
+    }
+    CHECK_EQUAL(size_t{64}, subsetsOfPartitions.size());
+}
+
+TEST_CASE(BlockCompression_Bc5NormalsWithReconstructedZ) {
+    // BC5 drops Z. Reconstructing it from X and Y, like the pixel shader does for two-channel normal textures, keeps the
+    // normals within a few degrees.
+    constexpr uint32_t Size = 32;
+    const std::vector<uint8_t> image = NormalMapImage(Size, Size);
+    const std::vector<uint8_t> decoded = RoundTrip(image, Size, Size, BlockFormat::BC5);
+
+    float maxAngle = 0;
+    for (size_t texel = 0; texel < Size * Size; texel++) {
+        const DirectX::XMVECTOR expected = ReconstructNormal(&image[texel * 4]);
+        const DirectX::XMVECTOR actual = ReconstructNormal(&decoded[texel * 4]);
+        maxAngle = std::max(maxAngle, DirectX::XMVectorGetX(DirectX::XMVector3AngleBetweenNormals(expected, actual)));
+
+        // The reconstructed normal of the source also matches the stored Z.
+        CHECK_NEAR(image[texel * 4 + 2] / 255.0f * 2.0f - 1.0f, DirectX::XMVectorGetZ(expected), 0.02f);
+    }
+    CHECK(maxAngle < DirectX::XMConvertToRadians(3.0f));
+}
+
+TEST_CASE(BlockCompression_PsnrOfIdenticalImages) {
+    const std::vector<uint8_t> image = PhotoLikeImage(4, 4, 4);
+    CHECK(std::isinf(BlockCompression::ComputePsnr(image.data(), image.data(), 16)));
+
+    std::vector<uint8_t> changed = image;
+    changed[0] ^= 1;
+    CHECK(!std::isinf(BlockCompression::ComputePsnr(image.data(), changed.data(), 16)));
+    CHECK(std::isinf(BlockCompression::ComputePsnr(image.data(), changed.data(), 16, 0xE))); // Red is not compared.
+}
+
+BENCHMARK(BlockCompression_1024) {
+    constexpr uint32_t Size = 1024;
+    const std::vector<uint8_t> image = PhotoLikeImage(Size, Size, 5);
+    const std::pair<BlockFormat, const char*> formats[] = {
+        {BlockFormat::BC1, "BC1"}, {BlockFormat::BC3, "BC3"}, {BlockFormat::BC5, "BC5"}, {BlockFormat::BC7, "BC7"}};
+    for (const auto& [format, name] : formats) {
+        std::vector<uint8_t> blocks;
+        const double microseconds = Test::MeasureMicroseconds(
+            [&, format = format] { blocks = BlockCompression::Compress(image.data(), Size, Size, format); }, 3);
+        const std::vector<uint8_t> decoded = BlockCompression::Decompress(blocks.data(), Size, Size, format);
+
+        Test::ReportMetric(std::string(name) + " encode", microseconds / 1000, "ms");
+        Test::ReportMetric(std::string(name) + " PSNR",
+                           BlockCompression::ComputePsnr(image.data(), decoded.data(), Size * Size, GetChannelMask(format)),
+                           "dB");
+    }
+}
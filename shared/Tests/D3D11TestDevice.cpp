@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <cstring>
+#include "D3D11TestDevice.h"
+
+namespace Test {
+    D3D11Device CreateWarpDevice() {
+        const D3D_FEATURE_LEVEL featureLevels[] = {D3D_FEATURE_LEVEL_11_1, D3D_FEATURE_LEVEL_11_0};
+
+        D3D11Device device;
+        winrt::check_hresult(D3D11CreateDevice(nullptr,
+                                               D3D_DRIVER_TYPE_WARP,
+                                               nullptr,
+                                               D3D11_CREATE_DEVICE_BGRA_SUPPORT,
+                                               featureLevels,
+                                               (UINT)std::size(featureLevels),
+                                               D3D11_SDK_VERSION,
+                                               device.Device.put(),
+                                               nullptr,
+                                               device.Context.put()));
+        return device;
+    }
+
+    RenderTarget CreateRenderTarget(_In_ ID3D11Device* device, uint32_t size) {
+        D3D11_TEXTURE2D_DESC desc{};
+        desc.Width = size;
+        desc.Height = size;
+        desc.MipLevels = 1;
+        desc.ArraySize = 1;
+        desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        desc.SampleDesc.Count = 1;
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.BindFlags = D3D11_BIND_RENDER_TARGET;
+
+        RenderTarget target;
+        target.Size = size;
+        winrt::check_hresult(device->CreateTexture2D(&desc, nullptr, target.Texture.put()));
+        winrt::check_hresult(device->CreateRenderTargetView(target.Texture.get(), nullptr, target.View.put()));
+
+        desc.Usage = D3D11_USAGE_STAGING;
+        desc.BindFlags = 0;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        winrt::check_hresult(device->CreateTexture2D(&desc, nullptr, target.Staging.put()));
+        return target;
+    }
+
+    void RenderTarget::ClearAndBind(_In_ ID3D11DeviceContext* context) const {
+        const float clearColor[4] = {0, 0, 0, 0};
+        context->ClearRenderTargetView(View.get(), clearColor);
+        ID3D11RenderTargetView* renderTargets[] = {View.get()};
+        context->OMSetRenderTargets(1, renderTargets, nullptr);
+        const D3D11_VIEWPORT viewport{0, 0, (float)Size, (float)Size, 0, 1};
+        context->RSSetViewports(1, &viewport);
+    }
+
+    std::vector<uint32_t> RenderTarget::ReadPixels(_In_ ID3D11DeviceContext* context) const {
+        context->CopyResource(Staging.get(), Texture.get());
+        D3D11_MAPPED_SUBRESOURCE mapped{};
+        winrt::check_hresult(context->Map(Staging.get(), 0, D3D11_MAP_READ, 0, &mapped));
+        std::vector<uint32_t> pixels((size_t)Size * Size);
+        for (uint32_t y = 0; y < Size; y++) {
+            memcpy(&pixels[(size_t)y * Size], static_cast<const uint8_t*>(mapped.pData) + (size_t)y * mapped.RowPitch, Size * 4);
+        }
+        context->Unmap(Staging.get(), 0);
+        return pixels;
+    }
+} // namespace Test
@@ -0,0 +1,34 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#pragma once
+
+#include <vector>
+#include <winrt/base.h>
+#include <d3d11.h>
+
+namespace Test {
+    struct D3D11Device {
+        winrt::com_ptr<ID3D11Device> Device;
+        winrt::com_ptr<ID3D11DeviceContext> Context;
+    };
+
+    // A WARP (software) device, so that test cases and benchmarks that need D3D11 also run on machines without a GPU,
+    // like the build agents. Nothing is presented, so draws only go as far as the driver.
+    D3D11Device CreateWarpDevice();
+
+    // A square R8G8B8A8 render target, to check what draws cover by reading its pixels back.
+    struct RenderTarget {
+        winrt::com_ptr<ID3D11Texture2D> Texture;
+        winrt::com_ptr<ID3D11RenderTargetView> View;
+        winrt::com_ptr<ID3D11Texture2D> Staging;
+        uint32_t Size{0};
+
+        // Clear the target to transparent black, and bind it with a viewport covering it and no depth buffer.
+        void ClearAndBind(_In_ ID3D11DeviceContext* context) const;
+
+        // Read the pixels back as 0xAABBGGRR, row by row from the top.
+        std::vector<uint32_t> ReadPixels(_In_ ID3D11DeviceContext* context) const;
+    };
+    RenderTarget CreateRenderTarget(_In_ ID3D11Device* device, uint32_t size);
+} // namespace Test
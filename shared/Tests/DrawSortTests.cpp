@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <cmath>
+#include <pbr/PbrDrawSort.h>
+
+using namespace Pbr;
+
+namespace {
+    // Keys of count draws at random depths up to 20 meters, with one in four of them blended.
+    std::vector<uint64_t> CreateKeys(uint32_t count, std::minstd_rand& random) {
+        std::uniform_real_distribution<float> depth(0.0f, 20.0f);
+        std::vector<uint64_t> keys;
+        keys.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            keys.push_back(DrawSort::MakeKey(i % 4 == 0 ? DrawPass::Blended : DrawPass::Opaque, depth(random), i));
+        }
+        return keys;
+    }
+} // namespace
+
+TEST_CASE(DrawSort_KeyOrder) {
+    // Opaque front to back, then blended back to front, with ties in index order.
+    std::vector<uint64_t> keys = {DrawSort::MakeKey(DrawPass::Blended, 1.0f, 0),
+                                  DrawSort::MakeKey(DrawPass::Opaque, 5.0f, 1),
+                                  DrawSort::MakeKey(DrawPass::Blended, 3.0f, 2),
+                                  DrawSort::MakeKey(DrawPass::Opaque, 0.5f, 3),
+                                  DrawSort::MakeKey(DrawPass::Opaque, 5.0f, 4)};
+    std::vector<uint64_t> scratch;
+    DrawSort::RadixSort(keys, scratch);
+
+    const uint32_t expected[] = {3, 1, 4, 2, 0};
+    for (size_t i = 0; i < keys.size(); i++) {
+        CHECK_EQUAL(expected[i], DrawSort::GetIndex(keys[i]));
+    }
+    CHECK(DrawSort::GetPass(keys[2]) == DrawPass::Opaque);
+    CHECK(DrawSort::GetPass(keys[3]) == DrawPass::Blended);
+}
+
+TEST_CASE(DrawSort_DepthsBehindTheViewer) {
+    // Negative depths and NaN sort like 0, in front of everything in the opaque pass and last in the blended pass.
+    CHECK_EQUAL(DrawSort::MakeKey(DrawPass::Opaque, 0.0f, 7), DrawSort::MakeKey(DrawPass::Opaque, -3.0f, 7));
+    CHECK_EQUAL(DrawSort::MakeKey(DrawPass::Opaque, 0.0f, 7), DrawSort::MakeKey(DrawPass::Opaque, std::nanf(""), 7));
+    CHECK(DrawSort::MakeKey(DrawPass::Blended, -1.0f, 0) > DrawSort::MakeKey(DrawPass::Blended, 0.01f, 1));
+    CHECK(DrawSort::MakeKey(DrawPass::Opaque, 1e30f, 0) < DrawSort::MakeKey(DrawPass::Blended, 1e30f, 1));
+}
+
+TEST_CASE(DrawSort_RadixSortMatchesStdSort) {
+    // Around the size where the radix sort takes over, and with all draws in one pass, which skips the pass digit.
+    std::minstd_rand random(48);
+    std::vector<uint64_t> scratch;
+    for (const uint32_t count : {0u, 1u, 1023u, 1024u, 5000u}) {
+        std::vector<uint64_t> keys = CreateKeys(count, random);
+        std::vector<uint64_t> expected = keys;
+        std::sort(expected.begin(), expected.end());
+        DrawSort::RadixSort(keys, scratch);
+        CHECK(keys == expected);
+    }
+
+    std::vector<uint64_t> opaque;
+    for (uint32_t i = 0; i < 3000; i++) {
+        opaque.push_back(DrawSort::MakeKey(DrawPass::Opaque, (float)(random() % 100), i));
+    }
+    std::vector<uint64_t> expected = opaque;
+    std::sort(expected.begin(), expected.end());
+    DrawSort::RadixSort(opaque, scratch);
+    CHECK(opaque == expected);
+}
+
+// Sorting the keys of 256 to 100000 draws, a quarter of them blended, with std::sort and with RadixSort. Below 1024 keys,
+// RadixSort falls back to std::sort.
+BENCHMARK(DrawSort_RadixSort) {
+    std::minstd_rand random(48);
+    std::vector<uint64_t> scratch;
+    for (const uint32_t count : {256u, 1000u, 2000u, 10000u, 100000u}) {
+        const std::vector<uint64_t> keys = CreateKeys(count, random);
+        std::vector<uint64_t> sorted;
+
+        const double stdSortMicroseconds = Test::MeasureMicroseconds([&] {
+            sorted = keys;
+            std::sort(sorted.begin(), sorted.end());
+        });
+        const double radixSortMicroseconds = Test::MeasureMicroseconds([&] {
+            sorted = keys;
+            DrawSort::RadixSort(sorted, scratch);
+        });
+        Test::DoNotOptimize(sorted.data());
+
+        const std::string name = std::to_string(count) + " keys";
+        Test::ReportMetric(name + ", std::sort", stdSortMicroseconds, "us");
+        Test::ReportMetric(name + ", RadixSort", radixSortMicroseconds, "us");
+    }
+}
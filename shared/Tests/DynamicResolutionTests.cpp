@@ -0,0 +1,193 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <deque>
+#include <XrSceneLib/DynamicResolution.h>
+
+namespace {
+    using duration = DynamicResolutionController::duration;
+
+    const duration FramePeriod = duration(1.0f / 90);
+    const float TargetCost = FramePeriod.count() * (1.0f - DynamicResolutionConfig{}.TargetHeadroom);
+
+    // Drive a controller with a synthetic GPU whose cost is fullCost at a scale of 1 and proportional to the pixel count.
+    // Results arrive latency frames after the frame was rendered, like timestamp queries, and carry the scale the frame
+    // was rendered at. Returns the scale of every frame.
+    std::vector<float> Simulate(DynamicResolutionController& controller,
+                                uint32_t frameCount,
+                                uint32_t latency,
+                                float (*fullCost)(uint32_t frame),
+                                float noise = 0) {
+        std::minstd_rand random(7);
+        std::uniform_real_distribution<float> noiseDistribution(-noise, noise);
+        std::deque<std::pair<duration, float>> pending;
+        std::vector<float> scales;
+        for (uint32_t frame = 0; frame < frameCount; frame++) {
+            const float scale = controller.Scale();
+            scales.push_back(scale);
+            pending.emplace_back(duration(fullCost(frame) * scale * scale * (1 + noiseDistribution(random))), scale);
+
+            if (pending.size() > latency) {
+                controller.Update(pending.front().first, pending.front().second, FramePeriod);
+                pending.pop_front();
+            }
+        }
+        return scales;
+    }
+
+    float SpreadOfLast(const std::vector<float>& scales, size_t count) {
+        const auto [min, max] = std::minmax_element(scales.end() - count, scales.end());
+        return *max - *min;
+    }
+} // namespace
+
+TEST_CASE(DynamicResolution_StaysAtMaxScaleWhenUnderBudget) {
+    DynamicResolutionController controller;
+    const std::vector<float> scales = Simulate(controller, 300, 2, [](uint32_t) { return 0.004f; });
+    for (float scale : scales) {
+        CHECK_EQUAL(1.0f, scale);
+    }
+}
+
+TEST_CASE(DynamicResolution_ConvergesToTargetCostWithLateSamples) {
+    // At a cost of 16 ms at full scale, the scale that fits the target cost is sqrt(target / 16 ms).
+    const float fullCost = 0.016f;
+    const float expectedScale = std::sqrt(TargetCost / fullCost);
+
+    for (uint32_t latency : {0u, 1u, 3u}) {
+        DynamicResolutionController controller;
+        const std::vector<float> scales = Simulate(controller, 400, latency, [](uint32_t) { return 0.016f; });
+        CHECK_NEAR(expectedScale, scales.back(), 0.03f);
+        CHECK(SpreadOfLast(scales, 100) < 0.01f);
+        CHECK(controller.SmoothedCost().count() <= TargetCost * (1 + controller.Config().Deadband) * 1.05f);
+    }
+}
+
+TEST_CASE(DynamicResolution_DoesNotOscillateUnderNoisyLoad) {
+    DynamicResolutionController controller;
+    const std::vector<float> scales = Simulate(controller, 1000, 3, [](uint32_t) { return 0.016f; }, 0.1f /*noise*/);
+
+    // Count reversals of the direction of the scale over the settled part of the trace.
+    uint32_t reversalCount = 0;
+    float previousStep = 0;
+    for (size_t i = 500; i < scales.size(); i++) {
+        const float step = scales[i] - scales[i - 1];
+        if (step != 0) {
+            if (previousStep != 0 && (step > 0) != (previousStep > 0)) {
+                reversalCount++;
+            }
+            previousStep = step;
+        }
+    }
+    CHECK(reversalCount < 25);
+    CHECK(SpreadOfLast(scales, 500) < 0.08f);
+}
+
+TEST_CASE(DynamicResolution_RecoversAfterLoadDrops) {
+    DynamicResolutionController controller;
+    const std::vector<float> scales =
+        Simulate(controller, 1200, 2, [](uint32_t frame) { return frame < 300 ? 0.03f : 0.004f; });
+
+    const DynamicResolutionConfig config = controller.Config();
+    CHECK(*std::min_element(scales.begin(), scales.begin() + 300) < 0.6f);
+    CHECK(scales[299] >= config.MinScale);
+    CHECK_NEAR(config.MaxScale, scales.back(), 1e-3);
+}
+
+TEST_CASE(DynamicResolution_ClampsToMinScale) {
+    DynamicResolutionController controller;
+    const std::vector<float> scales = Simulate(controller, 300, 2, [](uint32_t) { return 0.2f; });
+    CHECK_NEAR(controller.Config().MinScale, scales.back(), 1e-3);
+    for (float scale : scales) {
+        CHECK(scale >= controller.Config().MinScale && scale <= controller.Config().MaxScale);
+    }
+}
+
+TEST_CASE(DynamicResolution_NormalizesSamplesByTheirScale) {
+    // A sample of a frame rendered at half scale weighs the same as four times its cost at full scale.
+    DynamicResolutionController halfScale;
+    DynamicResolutionController fullScale;
+    halfScale.Update(duration(0.002f), 0.5f, FramePeriod);
+    fullScale.Update(duration(0.008f), 1.0f, FramePeriod);
+    CHECK_EQUAL(fullScale.Scale(), halfScale.Scale());
+    CHECK_NEAR(fullScale.SmoothedCost().count(), halfScale.SmoothedCost().count(), 1e-7);
+}
+
+TEST_CASE(DynamicResolution_IgnoresEmptySamples) {
+    DynamicResolutionController controller;
+    controller.Update(duration(0.02f), 1.0f, FramePeriod);
+    const float scale = controller.Scale();
+    CHECK(scale < 1.0f);
+
+    controller.Update(duration(0), scale, FramePeriod);
+    controller.Update(duration(0.02f), 0, FramePeriod);
+    controller.Update(duration(0.02f), scale, duration(0));
+    CHECK_EQUAL(scale, controller.Scale());
+}
+
+TEST_CASE(DynamicResolution_FallsBackToCpuTimeWithoutGpuSamples) {
+    // Timestamp queries that never resolve: only CPU samples arrive, one per frame at the scale of that frame.
+    DynamicResolutionController controller;
+    const uint32_t timeout = controller.Config().GpuTimeout;
+    std::vector<float> scales;
+    for (uint32_t frame = 0; frame < 400; frame++) {
+        const float scale = controller.Scale();
+        scales.push_back(scale);
+        controller.Update(duration(0.016f * scale * scale), scale, FramePeriod, RenderCostSource::Cpu);
+    }
+
+    // The first frames wait for GPU results, then the CPU average drives the scale to the target cost.
+    CHECK(controller.ActiveSource() == RenderCostSource::Cpu);
+    for (uint32_t frame = 0; frame < timeout; frame++) {
+        CHECK_EQUAL(1.0f, scales[frame]);
+    }
+    CHECK(scales[timeout] < 1.0f);
+    CHECK_NEAR(std::sqrt(TargetCost / 0.016f), scales.back(), 0.03f);
+    CHECK(SpreadOfLast(scales, 100) < 0.01f);
+}
+
+TEST_CASE(DynamicResolution_CpuSamplesDoNotBiasGpuSamples) {
+    // CPU submit time far above the budget is ignored while GPU results arrive, and doesn't enter the GPU average.
+    DynamicResolutionController withCpuSamples;
+    DynamicResolutionController gpuOnly;
+    for (uint32_t frame = 0; frame < 200; frame++) {
+        withCpuSamples.Update(duration(0.004f), withCpuSamples.Scale(), FramePeriod, RenderCostSource::Gpu);
+        withCpuSamples.Update(duration(0.05f), withCpuSamples.Scale(), FramePeriod, RenderCostSource::Cpu);
+        gpuOnly.Update(duration(0.004f), gpuOnly.Scale(), FramePeriod);
+    }
+    CHECK(withCpuSamples.ActiveSource() == RenderCostSource::Gpu);
+    CHECK_EQUAL(gpuOnly.Scale(), withCpuSamples.Scale());
+    CHECK_EQUAL(gpuOnly.SmoothedCost().count(), withCpuSamples.SmoothedCost().count());
+
+    // GPU results stop arriving, e.g. every query is disjoint: after the timeout the CPU average takes over and lowers the scale.
+    // The CPU sample of the last frame with a GPU result counts towards the timeout.
+    const uint32_t timeout = withCpuSamples.Config().GpuTimeout;
+    for (uint32_t frame = 1; frame < timeout; frame++) {
+        CHECK_EQUAL(1.0f, withCpuSamples.Scale());
+        withCpuSamples.Update(duration(0.05f), withCpuSamples.Scale(), FramePeriod, RenderCostSource::Cpu);
+    }
+    CHECK(withCpuSamples.ActiveSource() == RenderCostSource::Cpu);
+    CHECK(withCpuSamples.Scale() < 1.0f);
+
+    // A GPU result switches back to the GPU average right away.
+    withCpuSamples.Update(duration(0.004f), withCpuSamples.Scale(), FramePeriod, RenderCostSource::Gpu);
+    CHECK(withCpuSamples.ActiveSource() == RenderCostSource::Gpu);
+}
+
+TEST_CASE(DynamicResolution_ResetAndSetConfig) {
+    DynamicResolutionController controller;
+    for (int i = 0; i < 50; i++) {
+        controller.Update(duration(0.05f), controller.Scale(), FramePeriod);
+    }
+    CHECK_NEAR(controller.Config().MinScale, controller.Scale(), 1e-3);
+
+    DynamicResolutionConfig config = controller.Config();
+    config.MinScale = 0.75f;
+    controller.SetConfig(config);
+    CHECK_EQUAL(0.75f, controller.Scale());
+
+    controller.Reset();
+    CHECK_EQUAL(config.MaxScale, controller.Scale());
+    CHECK_EQUAL(0.0f, controller.SmoothedCost().count());
+}
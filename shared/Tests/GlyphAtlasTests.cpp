@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <XrSceneLib/GlyphAtlas.h>
+
+namespace {
+    bool Overlap(const AtlasRect& a, const AtlasRect& b) {
+        return a.X < b.X + b.Width && b.X < a.X + a.Width && a.Y < b.Y + b.Height && b.Y < a.Y + a.Height;
+    }
+
+    // Glyph-sized rectangles, like a font rasterized at 32 to 48 pixels.
+    std::vector<std::pair<uint32_t, uint32_t>> GlyphSizes(size_t count, uint32_t seed) {
+        std::minstd_rand random(seed);
+        std::uniform_int_distribution<uint32_t> width(8, 40);
+        std::uniform_int_distribution<uint32_t> height(30, 48);
+        std::vector<std::pair<uint32_t, uint32_t>> sizes(count);
+        for (auto& size : sizes) {
+            size = {width(random), height(random)};
+        }
+        return sizes;
+    }
+
+    // A coverage bitmap with a filled square of the given size in its center.
+    std::vector<uint8_t> SquareCoverage(uint32_t size, uint32_t squareSize) {
+        std::vector<uint8_t> coverage(static_cast<size_t>(size) * size, 0);
+        const uint32_t begin = (size - squareSize) / 2;
+        for (uint32_t y = begin; y < begin + squareSize; y++) {
+            for (uint32_t x = begin; x < begin + squareSize; x++) {
+                coverage[static_cast<size_t>(y) * size + x] = 255;
+            }
+        }
+        return coverage;
+    }
+} // namespace
+
+TEST_CASE(SkylinePacker_RejectsEmptyAndOversizedRectangles) {
+    SkylinePacker packer(64, 32);
+    CHECK(!packer.Allocate(0, 8).has_value());
+    CHECK(!packer.Allocate(8, 0).has_value());
+    CHECK(!packer.Allocate(65, 8).has_value());
+    CHECK(!packer.Allocate(8, 33).has_value());
+    CHECK(packer.Allocate(64, 32).has_value());
+    CHECK_EQUAL(1.0f, packer.Occupancy());
+}
+
+TEST_CASE(SkylinePacker_FillsTheLowestRowFirst) {
+    SkylinePacker packer(64, 64);
+    const std::optional<AtlasRect> a = packer.Allocate(20, 10);
+    const std::optional<AtlasRect> b = packer.Allocate(20, 16);
+    const std::optional<AtlasRect> c = packer.Allocate(20, 12);
+    CHECK(a && b && c);
+    CHECK_EQUAL(0u, a->X);
+    CHECK_EQUAL(0u, a->Y);
+    CHECK_EQUAL(20u, b->X);
+    CHECK_EQUAL(0u, b->Y);
+    CHECK_EQUAL(40u, c->X);
+    CHECK_EQUAL(0u, c->Y);
+
+    // Rests on the lowest part of the skyline, on top of a.
+    const std::optional<AtlasRect> d = packer.Allocate(20, 8);
+    CHECK(d.has_value());
+    CHECK_EQUAL(0u, d->X);
+    CHECK_EQUAL(10u, d->Y);
+}
+
+TEST_CASE(SkylinePacker_PrefersTheNarrowestSegmentOnTies) {
+    SkylinePacker packer(64, 64);
+    (void)packer.Allocate(32, 8);  // Skyline: [0, 32) at 8, [32, 64) at 0.
+    (void)packer.Allocate(16, 16); // Skyline: [0, 32) at 8, [32, 48) at 16, [48, 64) at 0.
+    (void)packer.Allocate(16, 8);  // Skyline: [0, 32) at 8, [32, 48) at 16, [48, 64) at 8.
+    const std::optional<AtlasRect> narrow = packer.Allocate(8, 8);
+    CHECK(narrow.has_value());
+    CHECK_EQUAL(48u, narrow->X);
+    CHECK_EQUAL(8u, narrow->Y);
+}
+
+TEST_CASE(SkylinePacker_FillsTheAtlasExactlyWithEqualTiles) {
+    SkylinePacker packer(64, 64);
+    for (uint32_t i = 0; i < 16; i++) {
+        const std::optional<AtlasRect> tile = packer.Allocate(16, 16);
+        CHECK(tile.has_value());
+        CHECK_EQUAL(i % 4 * 16, tile->X);
+        CHECK_EQUAL(i / 4 * 16, tile->Y);
+    }
+    CHECK_EQUAL(1.0f, packer.Occupancy());
+    CHECK(!packer.Allocate(1, 1).has_value());
+
+    packer.Reset();
+    CHECK_EQUAL(0.0f, packer.Occupancy());
+    const std::optional<AtlasRect> first = packer.Allocate(16, 16);
+    CHECK(first.has_value());
+    CHECK_EQUAL(0u, first->X);
+    CHECK_EQUAL(0u, first->Y);
+}
+
+TEST_CASE(SkylinePacker_AllocationsStayInBoundsAndDoNotOverlap) {
+    constexpr uint32_t Size = 256;
+    SkylinePacker packer(Size, Size);
+    std::vector<AtlasRect> rects;
+    uint64_t area = 0;
+    for (const auto& [width, height] : GlyphSizes(200, 1)) {
+        if (const std::optional<AtlasRect> rect = packer.Allocate(width, height)) {
+            CHECK(rect->X + rect->Width <= Size);
+            CHECK(rect->Y + rect->Height <= Size);
+            for (const AtlasRect& other : rects) {
+                CHECK(!Overlap(*rect, other));
+            }
+            rects.push_back(*rect);
+            area += uint64_t{width} * height;
+        }
+    }
+
+    CHECK(rects.size() < 200); // The atlas filled up.
+    CHECK_NEAR(static_cast<double>(area) / (Size * Size), packer.Occupancy(), 1e-6);
+    CHECK(packer.Occupancy() > 0.75f);
+}
+
+TEST_CASE(SignedDistanceField_EdgesAndSpread) {
+    constexpr uint32_t Size = 32, SquareSize = 12, Spread = 4;
+    const std::vector<uint8_t> coverage = SquareCoverage(Size, SquareSize);
+    const std::vector<uint8_t> field = GenerateSignedDistanceField(coverage.data(), Size, Size, Spread);
+    CHECK_EQUAL(coverage.size(), field.size());
+
+    for (size_t i = 0; i < field.size(); i++) {
+        CHECK((coverage[i] >= 128) == (field[i] >= 128));
+    }
+
+    // Along the middle row: saturated more than the spread outside, rising through 128 at the edge, saturated deep inside.
+    const uint8_t* row = &field[Size / 2 * Size];
+    const uint32_t edge = (Size - SquareSize) / 2;
+    CHECK(row[0] < 20);
+    CHECK_EQUAL(255 - (int)row[0], (int)row[Size / 2]);
+    CHECK_EQUAL((int)row[0], (int)row[edge - Spread]);
+    CHECK(row[edge - 1] < 128 && row[edge - 1] > 96);
+    CHECK(row[edge] >= 128 && row[edge] < 160);
+    for (uint32_t x = 1; x <= Size / 2; x++) {
+        CHECK(row[x - 1] <= row[x]);
+    }
+}
+
+BENCHMARK(GlyphAtlas_PackAndSdf) {
+    // Pack glyph-sized rectangles into a 1024x1024 atlas until it is full.
+    const std::vector<std::pair<uint32_t, uint32_t>> sizes = GlyphSizes(2000, 2);
+    size_t packed = 0;
+    float occupancy = 0;
+    const double packMicroseconds = Test::MeasureMicroseconds([&] {
+        SkylinePacker packer(1024, 1024);
+        packed = 0;
+        for (const auto& [width, height] : sizes) {
+            packed += packer.Allocate(width, height).has_value() ? 1 : 0;
+        }
+        occupancy = packer.Occupancy();
+    });
+    Test::ReportMetric("Pack 1024x1024 until full", packMicroseconds, "us");
+    Test::ReportMetric("Glyphs packed", static_cast<double>(packed), "glyphs");
+    Test::ReportMetric("Occupancy", occupancy * 100, "%");
+
+    // A 48 pixel glyph with 8 texels of padding on each side.
+    const std::vector<uint8_t> coverage = SquareCoverage(64, 48);
+    const double sdfMicroseconds = Test::MeasureMicroseconds([&] {
+        const std::vector<uint8_t> field = GenerateSignedDistanceField(coverage.data(), 64, 64, 8);
+        Test::DoNotOptimize(field.data());
+    });
+    Test::ReportMetric("SDF 64x64, spread 8", sdfMicroseconds, "us");
+}
@@ -0,0 +1,239 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <cstring>
+#include <pbr/PbrIbl.h>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+using namespace Pbr;
+
+namespace {
+    constexpr uint32_t FaceCount = 6;
+
+    // A cube map of one level with the radiance of each texel given by its direction.
+    template <typename Fn>
+    CubeMap CreateCubeMap(uint32_t size, const Fn& radiance) {
+        CubeMap cubeMap;
+        cubeMap.Size = size;
+        cubeMap.MipLevels = 1;
+        cubeMap.Texels.resize(cubeMap.GetLevelOffset(FaceCount, 0));
+        for (uint32_t face = 0; face < FaceCount; face++) {
+            for (uint32_t y = 0; y < size; y++) {
+                for (uint32_t x = 0; x < size; x++) {
+                    const float u = 2 * (x + 0.5f) / size - 1;
+                    const float v = 2 * (y + 0.5f) / size - 1;
+                    // The D3D cube map face directions of texture coordinates (u, v).
+                    const XMFLOAT3 directions[FaceCount] = {{1, -v, -u}, {-1, -v, u}, {u, 1, v}, {u, -1, -v}, {u, -v, 1}, {-u, -v, -1}};
+                    const XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&directions[face]));
+                    XMStoreHalf4(&cubeMap.Texels[cubeMap.GetLevelOffset(face, 0) + y * size + x], XMVectorSetW(radiance(direction), 1));
+                }
+            }
+        }
+        return cubeMap;
+    }
+
+    XMFLOAT4 GetTexel(const CubeMap& cubeMap, uint32_t face, uint32_t level, size_t texel) {
+        XMFLOAT4 value;
+        XMStoreFloat4(&value, XMLoadHalf4(&cubeMap.Texels[cubeMap.GetLevelOffset(face, level) + texel]));
+        return value;
+    }
+
+    float LutValue(const std::vector<uint16_t>& lut, uint32_t size, uint32_t x, uint32_t y, uint32_t channel) {
+        return lut[((size_t)y * size + x) * 2 + channel] / 65535.0f;
+    }
+
+    template <typename T>
+    void Append(std::vector<uint8_t>& data, T value) {
+        const size_t offset = data.size();
+        data.resize(offset + sizeof(T));
+        std::memcpy(data.data() + offset, &value, sizeof(T));
+    }
+} // namespace
+
+TEST_CASE(Ibl_BrdfLutIsDeterministicAndBounded) {
+    constexpr uint32_t Size = 32;
+    const std::vector<uint16_t> lut = Ibl::ComputeBrdfLut(Size, 128);
+    CHECK_EQUAL(size_t{Size * Size * 2}, lut.size());
+    CHECK(lut == Ibl::ComputeBrdfLut(Size, 128));
+
+    // Scale and bias on F0 never reflect more than the incoming light.
+    for (uint32_t y = 0; y < Size; y++) {
+        for (uint32_t x = 0; x < Size; x++) {
+            CHECK(LutValue(lut, Size, x, y, 0) + LutValue(lut, Size, x, y, 1) <= 1.0f + 1e-3f);
+        }
+    }
+
+    CHECK_THROWS(Ibl::ComputeBrdfLut(0, 128), std::out_of_range);
+    CHECK_THROWS(Ibl::ComputeBrdfLut(Size, 0), std::out_of_range);
+}
+
+TEST_CASE(Ibl_BrdfLutLayout) {
+    constexpr uint32_t Size = 32;
+    const std::vector<uint16_t> lut = Ibl::ComputeBrdfLut(Size, 256);
+
+    // Smooth and seen head on (the last row and column), all light is reflected with F0: the scale is 1, the bias 0.
+    CHECK_NEAR(1.0f, LutValue(lut, Size, Size - 1, Size - 1, 0), 0.02f);
+    CHECK_NEAR(0.0f, LutValue(lut, Size, Size - 1, Size - 1, 1), 0.01f);
+
+    // Fresnel raises the bias toward grazing angles, and rough surfaces (the first row) reflect less than smooth ones.
+    CHECK(LutValue(lut, Size, 2, Size - 1, 1) > LutValue(lut, Size, Size / 2, Size - 1, 1));
+    CHECK(LutValue(lut, Size, Size / 2, Size - 1, 1) > LutValue(lut, Size, Size - 1, Size - 1, 1));
+    CHECK(LutValue(lut, Size, Size / 2, 0, 0) < LutValue(lut, Size, Size / 2, Size - 1, 0));
+}
+
+TEST_CASE(Ibl_IrradianceOfConstantRadiance) {
+    // Irradiance of a uniform environment is pi times its radiance, which the coefficients hold divided by pi.
+    const CubeMap radiance = CreateCubeMap(16, [](FXMVECTOR) { return XMVectorSet(0.5f, 1.0f, 2.0f, 0); });
+    const SphericalHarmonics9 irradiance = Ibl::ComputeIrradiance(radiance);
+    for (const XMVECTOR direction : {XMVectorSet(1, 0, 0, 0), XMVectorSet(0, -1, 0, 0), XMVectorSet(0.3f, 0.4f, -0.5f, 0)}) {
+        const XMFLOAT3 value = Ibl::EvaluateIrradiance(irradiance, direction);
+        CHECK_NEAR(0.5f, value.x, 0.005f);
+        CHECK_NEAR(1.0f, value.y, 0.01f);
+        CHECK_NEAR(2.0f, value.z, 0.02f);
+    }
+
+    // Only the constant band is set.
+    for (size_t i = 1; i < irradiance.Coefficients.size(); i++) {
+        CHECK_NEAR(0.0f, irradiance.Coefficients[i].y, 1e-3f);
+    }
+}
+
+TEST_CASE(Ibl_IrradianceOfASkyAbove) {
+    // Radiance of the clamped cosine around +Y. Irradiance divided by pi is 2/3 facing up, 2/(3 pi) facing sideways and 0 facing
+    // down, which nine coefficients approximate within a few hundredths.
+    const CubeMap radiance = CreateCubeMap(32, [](FXMVECTOR direction) {
+        return XMVectorReplicate(std::max(0.0f, XMVectorGetY(direction)));
+    });
+    const SphericalHarmonics9 irradiance = Ibl::ComputeIrradiance(radiance);
+    CHECK_NEAR(2.0f / 3, Ibl::EvaluateIrradiance(irradiance, XMVectorSet(0, 1, 0, 0)).x, 0.03f);
+    constexpr float Sideways = 2 / (3 * 3.14159265f);
+    CHECK_NEAR(Sideways, Ibl::EvaluateIrradiance(irradiance, XMVectorSet(1, 0, 0, 0)).x, 0.03f);
+    CHECK_NEAR(Sideways, Ibl::EvaluateIrradiance(irradiance, XMVectorSet(0, 0, -1, 0)).y, 0.03f);
+    CHECK_NEAR(0.0f, Ibl::EvaluateIrradiance(irradiance, XMVectorSet(0, -1, 0, 0)).z, 0.03f);
+
+    CHECK_THROWS(Ibl::ComputeIrradiance(CubeMap{}), std::out_of_range);
+}
+
+TEST_CASE(Ibl_PrefilterSpecular) {
+    std::minstd_rand random(46);
+    std::uniform_real_distribution<float> value(0.0f, 4.0f);
+    CubeMap radiance = CreateCubeMap(16, [&](FXMVECTOR) { return XMVectorSet(value(random), value(random), value(random), 0); });
+
+    const CubeMap specular = Ibl::PrefilterSpecular(radiance, 16, 32);
+    CHECK_EQUAL(16u, specular.Size);
+    CHECK_EQUAL(5u, specular.MipLevels);
+    CHECK_EQUAL(specular.GetLevelOffset(FaceCount, 0), specular.Texels.size());
+    CHECK(std::memcmp(specular.Texels.data(),
+                      Ibl::PrefilterSpecular(radiance, 16, 32).Texels.data(),
+                      specular.Texels.size() * sizeof(XMHALF4)) == 0);
+
+    // The most detailed level is the environment itself.
+    for (uint32_t face = 0; face < FaceCount; face++) {
+        for (size_t texel = 0; texel < 16 * 16; texel++) {
+            CHECK_NEAR(GetTexel(radiance, face, 0, texel).y, GetTexel(specular, face, 0, texel).y, 0.01f);
+        }
+    }
+
+    // Filtering keeps a uniform environment uniform at every roughness.
+    radiance = CreateCubeMap(16, [](FXMVECTOR) { return XMVectorSet(1.0f, 0.25f, 3.0f, 0); });
+    const CubeMap uniform = Ibl::PrefilterSpecular(radiance, 8, 32);
+    for (uint32_t level = 0; level < uniform.MipLevels; level++) {
+        const XMFLOAT4 texel = GetTexel(uniform, 3, level, 0);
+        CHECK_NEAR(1.0f, texel.x, 0.01f);
+        CHECK_NEAR(0.25f, texel.y, 0.01f);
+        CHECK_NEAR(3.0f, texel.z, 0.02f);
+    }
+}
+
+TEST_CASE(Ibl_ReadDdsCubeMap) {
+    // A 2x2 R32G32B32A32_FLOAT cube map with a DX10 header, where each texel holds its face and index.
+    std::vector<uint8_t> dds = {'D', 'D', 'S', ' '};
+    Append<uint32_t>(dds, 124);     // Header size.
+    Append<uint32_t>(dds, 0x1007);  // Caps, height, width and pixel format.
+    Append<uint32_t>(dds, 2);       // Height.
+    Append<uint32_t>(dds, 2);       // Width.
+    dds.resize(76);
+    Append<uint32_t>(dds, 32);      // Pixel format size.
+    Append<uint32_t>(dds, 0x4);     // DDPF_FOURCC.
+    dds.insert(dds.end(), {'D', 'X', '1', '0'});
+    dds.resize(128);
+    Append<uint32_t>(dds, 2);       // DXGI_FORMAT_R32G32B32A32_FLOAT.
+    Append<uint32_t>(dds, 3);       // D3D11_RESOURCE_DIMENSION_TEXTURE2D.
+    Append<uint32_t>(dds, 0x4);     // D3D11_RESOURCE_MISC_TEXTURECUBE.
+    Append<uint32_t>(dds, 1);       // Array size.
+    Append<uint32_t>(dds, 0);
+    for (uint32_t face = 0; face < FaceCount; face++) {
+        for (uint32_t texel = 0; texel < 4; texel++) {
+            for (const float channel : {(float)face, (float)texel, 0.5f, 1.0f}) {
+                Append<float>(dds, channel);
+            }
+        }
+    }
+
+    const CubeMap cubeMap = Ibl::ReadDdsCubeMap(dds.data(), dds.size());
+    CHECK_EQUAL(2u, cubeMap.Size);
+    CHECK_EQUAL(1u, cubeMap.MipLevels);
+    CHECK_EQUAL(5.0f, GetTexel(cubeMap, 5, 0, 3).x);
+    CHECK_EQUAL(3.0f, GetTexel(cubeMap, 5, 0, 3).y);
+    CHECK_EQUAL(0.5f, GetTexel(cubeMap, 2, 0, 1).z);
+
+    CHECK_THROWS(Ibl::ReadDdsCubeMap(dds.data(), dds.size() - 1), std::exception);
+
+    std::vector<uint8_t> notCube = dds;
+    notCube[136] = 0;
+    CHECK_THROWS(Ibl::ReadDdsCubeMap(notCube.data(), notCube.size()), std::exception);
+
+    std::vector<uint8_t> otherFormat = dds;
+    otherFormat[128] = 28; // DXGI_FORMAT_R8G8B8A8_UNORM.
+    CHECK_THROWS(Ibl::ReadDdsCubeMap(otherFormat.data(), otherFormat.size()), std::exception);
+}
+
+TEST_CASE(Ibl_CacheRoundTrip) {
+    PrecomputedLighting lighting;
+    lighting.BrdfLutSize = 8;
+    lighting.BrdfLut = Ibl::ComputeBrdfLut(8, 16);
+    lighting.DiffuseIrradiance.Coefficients[0] = {0.25f, 0.5f, 0.75f};
+    lighting.DiffuseIrradiance.Coefficients[8] = {-0.1f, 0.2f, -0.3f};
+    lighting.Specular = Ibl::PrefilterSpecular(CreateCubeMap(8, [](FXMVECTOR direction) { return XMVectorAbs(direction); }), 4, 8);
+
+    const std::vector<uint8_t> data = Ibl::Write(lighting);
+    const PrecomputedLighting read = Ibl::Read(data.data(), data.size());
+    CHECK_EQUAL(lighting.BrdfLutSize, read.BrdfLutSize);
+    CHECK(lighting.BrdfLut == read.BrdfLut);
+    CHECK(std::memcmp(&lighting.DiffuseIrradiance, &read.DiffuseIrradiance, sizeof(SphericalHarmonics9)) == 0);
+    CHECK_EQUAL(lighting.Specular.Size, read.Specular.Size);
+    CHECK_EQUAL(lighting.Specular.MipLevels, read.Specular.MipLevels);
+    CHECK(std::memcmp(lighting.Specular.Texels.data(), read.Specular.Texels.data(), lighting.Specular.Texels.size() * sizeof(XMHALF4)) ==
+          0);
+    CHECK(Ibl::Write(read) == data);
+
+    // Lighting without an environment.
+    PrecomputedLighting lutOnly = lighting;
+    lutOnly.Specular = {};
+    const std::vector<uint8_t> lutOnlyData = Ibl::Write(lutOnly);
+    CHECK(Ibl::Read(lutOnlyData.data(), lutOnlyData.size()).Specular.Texels.empty());
+}
+
+TEST_CASE(Ibl_CacheRejectsOtherData) {
+    PrecomputedLighting lighting;
+    lighting.BrdfLutSize = 4;
+    lighting.BrdfLut = Ibl::ComputeBrdfLut(4, 4);
+    const std::vector<uint8_t> data = Ibl::Write(lighting);
+
+    CHECK_THROWS(Ibl::Read(data.data(), data.size() - 1), std::exception);
+    CHECK_THROWS(Ibl::Read(data.data(), 10), std::exception);
+
+    std::vector<uint8_t> otherVersion = data;
+    otherVersion[4]++;
+    CHECK_THROWS(Ibl::Read(otherVersion.data(), otherVersion.size()), std::exception);
+
+    std::vector<uint8_t> badMagic = data;
+    badMagic[0] ^= 0xFF;
+    CHECK_THROWS(Ibl::Read(badMagic.data(), badMagic.size()), std::exception);
+
+    // The sizes of the header must match the data when writing, too.
+    lighting.BrdfLutSize = 5;
+    CHECK_THROWS(Ibl::Write(lighting), std::exception);
+}
@@ -0,0 +1,252 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <cstring>
+#include <pbr/PbrKtx2.h>
+
+using namespace Pbr;
+
+namespace {
+    constexpr size_t LevelCountOffset = 40;
+    constexpr size_t LevelIndexOffset = 80; // byteOffset, byteLength and uncompressedByteLength of each level.
+
+    // An RGBA image with its full mip chain, with each level filled with a different value.
+    Ktx2Image CreateRgbaImage(uint32_t width, uint32_t height) {
+        Ktx2Image image;
+        const uint32_t levelCount = MipGenerator::GetLevelCount(width, height);
+        for (uint32_t level = 0; level < levelCount; level++) {
+            MipLevel& mip = image.Levels.emplace_back();
+            mip.Width = std::max(1u, width >> level);
+            mip.Height = std::max(1u, height >> level);
+            mip.Pixels.assign(static_cast<size_t>(mip.Width) * mip.Height * 4, static_cast<uint8_t>(level + 1));
+        }
+        return image;
+    }
+
+    // A BC7 image with its full mip chain, compressed from color and alpha gradients.
+    Ktx2Image CreateBc7Image(uint32_t size) {
+        Ktx2Image image;
+        image.Format = BlockFormat::BC7;
+        image.SRGB = true;
+        for (uint32_t levelSize = size; levelSize > 0; levelSize /= 2) {
+            std::vector<uint8_t> rgba(static_cast<size_t>(levelSize) * levelSize * 4);
+            for (uint32_t y = 0; y < levelSize; y++) {
+                for (uint32_t x = 0; x < levelSize; x++) {
+                    uint8_t* texel = &rgba[(static_cast<size_t>(y) * levelSize + x) * 4];
+                    texel[0] = static_cast<uint8_t>(x * 255 / levelSize);
+                    texel[1] = static_cast<uint8_t>(y * 255 / levelSize);
+                    texel[2] = static_cast<uint8_t>((x + y) * 127 / levelSize);
+                    texel[3] = static_cast<uint8_t>(255 - x * 127 / levelSize);
+                }
+            }
+            image.Levels.push_back({levelSize, levelSize, BlockCompression::Compress(rgba.data(), levelSize, levelSize, BlockFormat::BC7)});
+        }
+        return image;
+    }
+
+    template <typename T>
+    void Patch(std::vector<uint8_t>& file, size_t offset, T value) {
+        std::memcpy(file.data() + offset, &value, sizeof(T));
+    }
+
+    bool Reads(const std::vector<uint8_t>& file) {
+        try {
+            (void)Ktx2::Read(file.data(), file.size());
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+} // namespace
+
+TEST_CASE(Ktx2_RgbaRoundTrip) {
+    Ktx2Image image = CreateRgbaImage(16, 4);
+    image.SRGB = true;
+    const std::vector<uint8_t> file = Ktx2::Write(image);
+    CHECK(Ktx2::IsKtx2(file.data(), file.size()));
+    CHECK(Ktx2::IsSupported(file.data(), file.size()));
+
+    const Ktx2Image read = Ktx2::Read(file.data(), file.size());
+    CHECK(!read.Format.has_value());
+    CHECK(read.SRGB);
+    CHECK_EQUAL(size_t{5}, read.Levels.size());
+    for (size_t level = 0; level < read.Levels.size(); level++) {
+        CHECK_EQUAL(image.Levels[level].Width, read.Levels[level].Width);
+        CHECK_EQUAL(image.Levels[level].Height, read.Levels[level].Height);
+        CHECK(image.Levels[level].Pixels == read.Levels[level].Pixels);
+    }
+}
+
+TEST_CASE(Ktx2_BlockCompressedRoundTrip) {
+    const std::vector<uint8_t> rgba(8 * 8 * 4, 200);
+    Ktx2Image image;
+    image.Format = BlockFormat::BC7;
+    image.Levels.push_back({8, 8, BlockCompression::Compress(rgba.data(), 8, 8, BlockFormat::BC7)});
+    const std::vector<uint8_t> file = Ktx2::Write(image);
+
+    const Ktx2Image read = Ktx2::Read(file.data(), file.size());
+    CHECK(read.Format == BlockFormat::BC7);
+    CHECK(!read.SRGB);
+    CHECK_EQUAL(size_t{1}, read.Levels.size());
+    CHECK(image.Levels[0].Pixels == read.Levels[0].Pixels);
+}
+
+TEST_CASE(Ktx2_RejectsTruncatedData) {
+    const std::vector<uint8_t> file = Ktx2::Write(CreateRgbaImage(4, 4));
+    for (size_t size : {size_t{12}, size_t{79}, LevelIndexOffset + 2 * 24, file.size() - 1}) {
+        const std::vector<uint8_t> truncated(file.begin(), file.begin() + size);
+        CHECK(!Reads(truncated));
+    }
+    CHECK(!Reads(std::vector<uint8_t>(file.begin() + 1, file.end())));
+}
+
+TEST_CASE(Ktx2_RejectsLevelIndexPastTheEndOfTheData) {
+    // A level count that is valid for the image size but whose level index doesn't fit in the file.
+    std::vector<uint8_t> file = Ktx2::Write(CreateRgbaImage(1, 1));
+    Patch<uint32_t>(file, 20, 16384);
+    Patch<uint32_t>(file, LevelCountOffset, 15);
+    CHECK(!Ktx2::IsSupported(file.data(), file.size()));
+    CHECK_THROWS(Ktx2::Read(file.data(), file.size()), std::exception);
+}
+
+TEST_CASE(Ktx2_RejectsMoreLevelsThanTheMipChain) {
+    std::vector<uint8_t> file = Ktx2::Write(CreateRgbaImage(4, 4));
+    file.resize(file.size() + 24 * 64); // Room for the index of the extra levels.
+    Patch<uint32_t>(file, LevelCountOffset, 4);
+    CHECK(!Ktx2::IsSupported(file.data(), file.size()));
+    CHECK_THROWS(Ktx2::Read(file.data(), file.size()), std::exception);
+
+    // A level count of 40 used to shift the width by 32 or more.
+    Patch<uint32_t>(file, LevelCountOffset, 40);
+    CHECK_THROWS(Ktx2::Read(file.data(), file.size()), std::exception);
+}
+
+TEST_CASE(Ktx2_RejectsImagesLargerThanTheTextureLimit) {
+    std::vector<uint8_t> file = Ktx2::Write(CreateRgbaImage(1, 1));
+    Patch<uint32_t>(file, 20, 16385);
+    CHECK(!Ktx2::IsSupported(file.data(), file.size()));
+    CHECK_THROWS(Ktx2::Read(file.data(), file.size()), std::exception);
+
+    Patch<uint32_t>(file, 20, 1);
+    Patch<uint32_t>(file, 24, UINT32_MAX);
+    CHECK(!Ktx2::IsSupported(file.data(), file.size()));
+    CHECK_THROWS(Ktx2::Read(file.data(), file.size()), std::exception);
+}
+
+TEST_CASE(Ktx2_RejectsLevelsOfTheWrongSizeBeforeAllocating) {
+    // A 16384x16384 RGBA header with the 4 bytes of a 1x1 level would allocate 1 GiB if the size wasn't checked first.
+    std::vector<uint8_t> file = Ktx2::Write(CreateRgbaImage(1, 1));
+    Patch<uint32_t>(file, 20, 16384);
+    Patch<uint32_t>(file, 24, 16384);
+    CHECK(Ktx2::IsSupported(file.data(), file.size()));
+    CHECK_THROWS(Ktx2::Read(file.data(), file.size()), std::exception);
+}
+
+TEST_CASE(Ktx2_RejectsLevelDataOutOfRange) {
+    const std::vector<uint8_t> file = Ktx2::Write(CreateRgbaImage(2, 2));
+
+    std::vector<uint8_t> pastTheEnd = file;
+    Patch<uint64_t>(pastTheEnd, LevelIndexOffset, file.size() - 8); // Level 0 is 16 bytes.
+    CHECK_THROWS(Ktx2::Read(pastTheEnd.data(), pastTheEnd.size()), std::exception);
+
+    std::vector<uint8_t> overflowing = file;
+    Patch<uint64_t>(overflowing, LevelIndexOffset, 16);
+    Patch<uint64_t>(overflowing, LevelIndexOffset + 8, UINT64_MAX - 8);
+    CHECK_THROWS(Ktx2::Read(overflowing.data(), overflowing.size()), std::exception);
+}
+
+TEST_CASE(Ktx2_RejectsUnsupportedContainers) {
+    std::vector<uint8_t> file = Ktx2::Write(CreateRgbaImage(4, 4));
+    std::vector<uint8_t> cube = file;
+    Patch<uint32_t>(cube, 36, 6);
+    CHECK(!Ktx2::IsSupported(cube.data(), cube.size()));
+
+    std::vector<uint8_t> zstd = file;
+    Patch<uint32_t>(zstd, 44, 2);
+    CHECK(!Ktx2::IsSupported(zstd.data(), zstd.size()));
+
+    std::vector<uint8_t> undefinedFormat = file;
+    Patch<uint32_t>(undefinedFormat, 12, 0);
+    CHECK_THROWS(Ktx2::Read(undefinedFormat.data(), undefinedFormat.size()), std::exception);
+}
+
+TEST_CASE(Ktx2_DetectsBasisUniversalPayloads) {
+    const std::vector<uint8_t> file = Ktx2::Write(CreateRgbaImage(4, 4));
+    CHECK(!Ktx2::IsBasisUniversal(file.data(), file.size()));
+    uint32_t dfdOffset;
+    std::memcpy(&dfdOffset, file.data() + 48, sizeof(dfdOffset));
+
+    // ETC1S and UASTC have an undefined vkFormat and are told apart by the color model of the data format descriptor.
+    for (uint8_t colorModel : {163 /* ETC1S */, 166 /* UASTC */}) {
+        std::vector<uint8_t> basis = file;
+        Patch<uint32_t>(basis, 12, 0);
+        basis[dfdOffset + 12] = colorModel;
+        CHECK(Ktx2::IsBasisUniversal(basis.data(), basis.size()));
+        CHECK(!Ktx2::IsSupported(basis.data(), basis.size()));
+        CHECK_THROWS(Ktx2::Read(basis.data(), basis.size()), std::exception);
+    }
+
+    std::vector<uint8_t> basisLz = file;
+    Patch<uint32_t>(basisLz, 44, 1);
+    CHECK(Ktx2::IsBasisUniversal(basisLz.data(), basisLz.size()));
+
+    // Other undefined formats aren't.
+    std::vector<uint8_t> undefinedFormat = file;
+    Patch<uint32_t>(undefinedFormat, 12, 0);
+    CHECK(!Ktx2::IsBasisUniversal(undefinedFormat.data(), undefinedFormat.size()));
+    CHECK(!Ktx2::IsBasisUniversal(file.data(), 40));
+}
+
+TEST_CASE(Ktx2_TranscodesBc7ToRgbaAndBc3) {
+    const Ktx2Image image = CreateBc7Image(16);
+
+    const Ktx2Image rgba = Ktx2::Transcode(image, std::nullopt);
+    CHECK(!rgba.Format.has_value());
+    CHECK(rgba.SRGB);
+    CHECK_EQUAL(image.Levels.size(), rgba.Levels.size());
+    for (size_t level = 0; level < image.Levels.size(); level++) {
+        const MipLevel& mip = image.Levels[level];
+        CHECK_EQUAL(mip.Width, rgba.Levels[level].Width);
+        CHECK(BlockCompression::Decompress(mip.Pixels.data(), mip.Width, mip.Height, BlockFormat::BC7) == rgba.Levels[level].Pixels);
+    }
+
+    // BC3 has the size of BC7 with less precise 5:6:5 colors and a separate alpha block, so the transcoded levels stay close
+    // to the decoded BC7.
+    const Ktx2Image bc3 = Ktx2::Transcode(image, BlockFormat::BC3);
+    CHECK(bc3.Format == BlockFormat::BC3);
+    CHECK_EQUAL(image.Levels.size(), bc3.Levels.size());
+    for (size_t level = 0; level < image.Levels.size(); level++) {
+        const MipLevel& mip = bc3.Levels[level];
+        CHECK_EQUAL(image.Levels[level].Pixels.size(), mip.Pixels.size());
+        const std::vector<uint8_t> decoded = BlockCompression::Decompress(mip.Pixels.data(), mip.Width, mip.Height, BlockFormat::BC3);
+        const double psnr = BlockCompression::ComputePsnr(rgba.Levels[level].Pixels.data(), decoded.data(), mip.Width * mip.Height);
+        CHECK(psnr > (level == 0 ? 30 : 20)); // The gradients of the smaller levels are steeper within a block.
+    }
+
+    // Transcoding to the same format is a copy.
+    CHECK(Ktx2::Transcode(image, BlockFormat::BC7).Levels[0].Pixels == image.Levels[0].Pixels);
+}
+
+BENCHMARK(Ktx2_ReadAndTranscode_1024) {
+    constexpr uint32_t Size = 1024;
+    const std::vector<uint8_t> file = Ktx2::Write(CreateBc7Image(Size));
+
+    Ktx2Image image;
+    const double readMicroseconds = Test::MeasureMicroseconds([&] { image = Ktx2::Read(file.data(), file.size()); });
+    Ktx2Image rgba;
+    const double decodeMicroseconds = Test::MeasureMicroseconds([&] { rgba = Ktx2::Transcode(image, std::nullopt); }, 3);
+    Ktx2Image bc3;
+    const double transcodeMicroseconds = Test::MeasureMicroseconds([&] { bc3 = Ktx2::Transcode(image, BlockFormat::BC3); }, 3);
+
+    // Bytes per microsecond are megabytes per second.
+    Test::ReportMetric("Read BC7 with mips", readMicroseconds / 1000, "ms");
+    Test::ReportMetric("Read BC7 with mips throughput", file.size() / readMicroseconds, "MB/s");
+    Test::ReportMetric("Decode BC7 to RGBA", decodeMicroseconds / 1000, "ms");
+    Test::ReportMetric("Transcode BC7 to BC3", transcodeMicroseconds / 1000, "ms");
+
+    const MipLevel& top = bc3.Levels[0];
+    const std::vector<uint8_t> decoded = BlockCompression::Decompress(top.Pixels.data(), Size, Size, BlockFormat::BC3);
+    Test::ReportMetric(
+        "BC3 against BC7 PSNR", BlockCompression::ComputePsnr(rgba.Levels[0].Pixels.data(), decoded.data(), Size * Size), "dB");
+}
@@ -0,0 +1,11 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// The stb_image implementation, which the Gltf library provides in the Visual Studio builds. The KTX2 reader uses its
+// zlib decoder.
+//
+#include <sal.h> // The annotations of the bundled stb_image.h
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
@@ -0,0 +1,22 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// The SAL annotations of the headers the portable tests include, which only the Microsoft compiler checks. DirectXMath
+// includes "sal.h" on every platform, and expects it from the Windows SDK.
+//
+#pragma once
+
+#define _Analysis_assume_(expression)
+#define _Check_return_
+#define _In_
+#define _In_opt_
+#define _In_reads_(size)
+#define _In_reads_bytes_(size)
+#define _Inout_
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(size)
+#define _Out_writes_bytes_(size)
+#define _Success_(expression)
+#define _Use_decl_annotations_
@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// Runs the test cases, or with --benchmark the benchmarks, whose names contain the optional filter argument. Returns
+// the number of failed test cases.
+//
+#include "pch.h"
+#include <cstdio>
+#include <cstring>
+#include <exception>
+
+namespace {
+    struct Entry {
+        const char* Name;
+        Test::Function Function;
+        bool Benchmark;
+    };
+
+    std::vector<Entry>& GetEntries() {
+        static std::vector<Entry> entries;
+        return entries;
+    }
+
+    uint32_t g_failureCount = 0;
+    const void* volatile g_sink = nullptr;
+} // namespace
+
+namespace Test {
+    Registration::Registration(const char* name, Function function, bool benchmark) {
+        GetEntries().push_back({name, function, benchmark});
+    }
+
+    void ReportFailure(const char* file, int line, const std::string& message) {
+        std::printf("  %s(%d): %s\n", file, line, message.c_str());
+        g_failureCount++;
+    }
+
+    void ReportMetric(const std::string& name, double value, const char* unit) {
+        std::printf("  %-60s %12.3f %s\n", name.c_str(), value, unit);
+    }
+
+    void DoNotOptimize(const void* value) {
+        g_sink = value;
+    }
+} // namespace Test
+
+int main(int argc, char** argv) {
+    bool benchmark = false;
+    const char* filter = "";
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--benchmark") == 0) {
+            benchmark = true;
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    std::vector<Entry> entries = GetEntries();
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return std::strcmp(a.Name, b.Name) < 0; });
+
+    uint32_t runCount = 0;
+    uint32_t failedCount = 0;
+    for (const Entry& entry : entries) {
+        if (entry.Benchmark != benchmark || std::strstr(entry.Name, filter) == nullptr) {
+            continue;
+        }
+
+        std::printf("%s\n", entry.Name);
+        const uint32_t previousFailureCount = g_failureCount;
+        try {
+            entry.Function();
+        } catch (const std::exception& exception) {
+            Test::ReportFailure(__FILE__, __LINE__, std::string("unexpected exception: ") + exception.what());
+        }
+
+        runCount++;
+        if (g_failureCount != previousFailureCount) {
+            failedCount++;
+        }
+    }
+
+    std::printf("%u of %u %s passed\n", runCount - failedCount, runCount, benchmark ? "benchmarks" : "test cases");
+    return (int)failedCount;
+}
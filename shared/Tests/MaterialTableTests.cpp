@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <pbr/PbrMaterialTable.h>
+#include "D3D11TestDevice.h"
+
+using namespace Pbr;
+
+namespace {
+    using Element = std::array<uint32_t, 4>;
+    constexpr uint32_t ElementSize = sizeof(Element);
+
+    Element CreateElement(uint32_t value) {
+        return {value, value + 1, value + 2, value + 3};
+    }
+
+    // Copy a buffer back through a staging buffer of the same description, as elements.
+    template <typename T>
+    std::vector<T> ReadBack(const Test::D3D11Device& device, ID3D11Buffer* buffer) {
+        D3D11_BUFFER_DESC desc;
+        buffer->GetDesc(&desc);
+        desc.Usage = D3D11_USAGE_STAGING;
+        desc.BindFlags = 0;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        winrt::com_ptr<ID3D11Buffer> staging;
+        CHECK(SUCCEEDED(device.Device->CreateBuffer(&desc, nullptr, staging.put())));
+        device.Context->CopyResource(staging.get(), buffer);
+
+        D3D11_MAPPED_SUBRESOURCE mapped{};
+        CHECK(SUCCEEDED(device.Context->Map(staging.get(), 0, D3D11_MAP_READ, 0, &mapped)));
+        const T* elements = static_cast<const T*>(mapped.pData);
+        std::vector<T> data(elements, elements + desc.ByteWidth / sizeof(T));
+        device.Context->Unmap(staging.get(), 0);
+        return data;
+    }
+} // namespace
+
+TEST_CASE(MaterialTable_ReusesReleasedSlots) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    MaterialTable table(device.Device.get(), ElementSize, 4);
+
+    std::shared_ptr<const MaterialTableSlot> a = table.Allocate();
+    std::shared_ptr<const MaterialTableSlot> b = table.Allocate();
+    std::shared_ptr<const MaterialTableSlot> c = table.Allocate();
+    CHECK_EQUAL(0u, a->Index);
+    CHECK_EQUAL(1u, b->Index);
+    CHECK_EQUAL(2u, c->Index);
+    CHECK_EQUAL(3u, table.GetStats().SlotCount);
+
+    // Releasing the last reference returns the slot, and the next allocation takes it before growing the used slots.
+    std::shared_ptr<const MaterialTableSlot> bCopy = b;
+    b = nullptr;
+    CHECK_EQUAL(3u, table.GetStats().SlotCount);
+    bCopy = nullptr;
+    CHECK_EQUAL(2u, table.GetStats().SlotCount);
+    b = table.Allocate();
+    CHECK_EQUAL(1u, b->Index);
+    CHECK_EQUAL(3u, table.Allocate()->Index); // Released again right away.
+
+    // Slots can outlive the table.
+    a = nullptr;
+    c = nullptr;
+    {
+        MaterialTable shortLived(device.Device.get(), ElementSize, 4);
+        a = shortLived.Allocate();
+    }
+    a = nullptr;
+    CHECK_EQUAL(1u, table.GetStats().SlotCount);
+    CHECK_EQUAL(4u, table.GetStats().Capacity);
+}
+
+TEST_CASE(MaterialTable_GrowsByDoublingWithAFullUpload) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    MaterialTable table(device.Device.get(), ElementSize, 2);
+    std::vector<std::shared_ptr<const MaterialTableSlot>> slots = {table.Allocate(), table.Allocate()};
+    for (const auto& slot : slots) {
+        const Element element = CreateElement(slot->Index * 10);
+        table.Update(*slot, element.data());
+    }
+    CHECK(!table.Flush(device.Context.get()));
+    CHECK_EQUAL(1u, table.GetStats().LastFlushRangeCount);
+    CHECK_EQUAL(size_t{2 * ElementSize}, table.GetStats().LastFlushBytes);
+
+    // The third slot doubles the capacity. The buffers are only recreated by the next flush, which uploads every slot.
+    ID3D11Buffer* const parameterBuffer = table.GetParameterBuffer();
+    slots.push_back(table.Allocate());
+    CHECK_EQUAL(2u, slots.back()->Index);
+    CHECK_EQUAL(4u, table.GetStats().Capacity);
+    CHECK(table.GetParameterBuffer() == parameterBuffer);
+    const Element third = CreateElement(20);
+    table.Update(*slots.back(), third.data());
+    CHECK(table.Flush(device.Context.get()));
+    CHECK(table.GetParameterBuffer() != parameterBuffer);
+    CHECK_EQUAL(1u, table.GetStats().LastFlushRangeCount);
+    CHECK_EQUAL(size_t{4 * ElementSize}, table.GetStats().LastFlushBytes);
+
+    // The slots uploaded before the growth keep their parameters in the new buffer, and the index buffer grew with it.
+    const std::vector<Element> parameters = ReadBack<Element>(device, table.GetParameterBuffer());
+    CHECK_EQUAL(size_t{4}, parameters.size());
+    for (uint32_t i = 0; i < 3; i++) {
+        CHECK(parameters[i] == CreateElement(i * 10));
+    }
+    const std::vector<uint32_t> indices = ReadBack<uint32_t>(device, table.GetMaterialIndexBuffer());
+    CHECK(indices == (std::vector<uint32_t>{0, 1, 2, 3}));
+
+    // Growing again doubles again.
+    slots.push_back(table.Allocate());
+    slots.push_back(table.Allocate());
+    CHECK_EQUAL(8u, table.GetStats().Capacity);
+    CHECK(table.Flush(device.Context.get()));
+    CHECK_EQUAL(size_t{8 * ElementSize}, table.GetStats().LastFlushBytes);
+}
+
+TEST_CASE(MaterialTable_FlushMergesDirtyRanges) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    MaterialTable table(device.Device.get(), ElementSize, 8);
+    std::vector<std::shared_ptr<const MaterialTableSlot>> slots;
+    for (uint32_t i = 0; i < 8; i++) {
+        slots.push_back(table.Allocate());
+    }
+
+    // Without updates there is nothing to upload.
+    CHECK(!table.Flush(device.Context.get()));
+    CHECK_EQUAL(0u, table.GetStats().LastFlushRangeCount);
+    CHECK_EQUAL(size_t{0}, table.GetStats().LastFlushBytes);
+
+    // Slots 1 to 3, 5 and 7 are uploaded as three ranges.
+    for (uint32_t index : {3, 1, 7, 2, 5}) {
+        const Element element = CreateElement(index * 10);
+        table.Update(*slots[index], element.data());
+    }
+    CHECK(!table.Flush(device.Context.get()));
+    CHECK_EQUAL(3u, table.GetStats().LastFlushRangeCount);
+    CHECK_EQUAL(size_t{5 * ElementSize}, table.GetStats().LastFlushBytes);
+    std::vector<Element> parameters = ReadBack<Element>(device, table.GetParameterBuffer());
+    for (uint32_t index : {1, 2, 3, 5, 7}) {
+        CHECK(parameters[index] == CreateElement(index * 10));
+    }
+
+    // Updating a slot twice before a flush uploads it once, with the last parameters.
+    const Element first = CreateElement(100);
+    const Element second = CreateElement(200);
+    table.Update(*slots[2], first.data());
+    table.Update(*slots[2], second.data());
+    CHECK(!table.Flush(device.Context.get()));
+    CHECK_EQUAL(1u, table.GetStats().LastFlushRangeCount);
+    CHECK_EQUAL(size_t{ElementSize}, table.GetStats().LastFlushBytes);
+    parameters = ReadBack<Element>(device, table.GetParameterBuffer());
+    CHECK(parameters[2] == second);
+    CHECK(parameters[1] == CreateElement(10));
+    CHECK(parameters[3] == CreateElement(30));
+
+    // The first and last slots are separate ranges, and all slots are one.
+    table.Update(*slots[0], first.data());
+    table.Update(*slots[7], first.data());
+    table.Flush(device.Context.get());
+    CHECK_EQUAL(2u, table.GetStats().LastFlushRangeCount);
+    for (const auto& slot : slots) {
+        table.Update(*slot, first.data());
+    }
+    table.Flush(device.Context.get());
+    CHECK_EQUAL(1u, table.GetStats().LastFlushRangeCount);
+    CHECK_EQUAL(size_t{8 * ElementSize}, table.GetStats().LastFlushBytes);
+}
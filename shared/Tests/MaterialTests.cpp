@@ -0,0 +1,56 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <pbr/PbrMaterial.h>
+#include <pbr/PbrResources.h>
+#include "D3D11TestDevice.h"
+
+using namespace Pbr;
+
+TEST_CASE(Material_PixelShaderPermutation) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    Resources pbrResources(device.Device.get());
+
+    // Flat materials only have the neutral textures, which the flat permutation doesn't sample.
+    const std::shared_ptr<Material> material = Material::CreateFlat(pbrResources, RGBAColor{1, 0, 0, 1});
+    CHECK(material->GetPixelShaderPermutation(pbrResources) == PixelShaderPermutation::Flat);
+
+    material->SetImageBasedLighting(false);
+    CHECK(material->GetPixelShaderPermutation(pbrResources) == PixelShaderPermutation::NoImageBasedLighting);
+    material->SetImageBasedLighting(true);
+
+    // Any texture other than the neutral one of its slot needs the full permutation, even a solid color.
+    const winrt::com_ptr<ID3D11ShaderResourceView> gray = pbrResources.CreateSolidColorTexture(RGBAColor{0.5f, 0.5f, 0.5f, 1});
+    material->SetTexture(ShaderSlots::Occlusion, gray.get());
+    CHECK(material->GetPixelShaderPermutation(pbrResources) == PixelShaderPermutation::Full);
+
+    material->SetUnlit(true);
+    CHECK(material->GetPixelShaderPermutation(pbrResources) == PixelShaderPermutation::Unlit);
+    material->SetUnlit(false);
+
+    // Setting the neutral texture back makes the material flat again.
+    material->SetTexture(ShaderSlots::Occlusion, pbrResources.CreateSolidColorTexture(RGBA::White).get());
+    CHECK(material->GetPixelShaderPermutation(pbrResources) == PixelShaderPermutation::Flat);
+
+    // White is neutral for every slot but the normal map.
+    material->SetTexture(ShaderSlots::Normal, pbrResources.CreateSolidColorTexture(RGBA::White).get());
+    CHECK(material->GetPixelShaderPermutation(pbrResources) == PixelShaderPermutation::Full);
+}
+
+// The settings that a frame of 1000 objects switches per object: scene objects set their shading mode before rendering and
+// projection layers set the depth function per view. Their pipeline states are created once, on the first switch.
+BENCHMARK(Resources_SettingsSwitchedPerObject) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    Resources pbrResources(device.Device.get());
+
+    bool reverseZ = false;
+    const double microseconds = Test::MeasureMicroseconds([&] {
+        reverseZ = !reverseZ;
+        pbrResources.SetDepthFuncReversed(reverseZ);
+        for (uint32_t object = 0; object < 1000; object++) {
+            pbrResources.SetShadingMode(object % 10 == 0 ? ShadingMode::Highlight : ShadingMode::Regular);
+        }
+    });
+    Test::ReportMetric("1000 objects", microseconds, "us/frame");
+}
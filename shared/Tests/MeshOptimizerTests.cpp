@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <cmath>
+#include <cstring>
+#include <pbr/PbrMeshOptimizer.h>
+
+using namespace Pbr;
+
+namespace {
+    struct Mesh {
+        std::vector<std::array<float, 3>> Positions;
+        std::vector<uint32_t> Indices;
+    };
+
+    // A UV sphere of segments x segments quads, with its triangles in row order like most exporters write them.
+    Mesh CreateSphere(uint32_t segments) {
+        constexpr float Pi = 3.14159265f;
+        Mesh mesh;
+        for (uint32_t row = 0; row <= segments; row++) {
+            const float theta = Pi * row / segments;
+            for (uint32_t column = 0; column <= segments; column++) {
+                const float phi = 2 * Pi * column / segments;
+                mesh.Positions.push_back({std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)});
+            }
+        }
+        for (uint32_t row = 0; row < segments; row++) {
+            for (uint32_t column = 0; column < segments; column++) {
+                const uint32_t i0 = row * (segments + 1) + column;
+                const uint32_t i1 = i0 + segments + 1;
+                mesh.Indices.insert(mesh.Indices.end(), {i0, i1, i0 + 1, i0 + 1, i1, i1 + 1});
+            }
+        }
+        return mesh;
+    }
+
+    void ShuffleTriangles(std::vector<uint32_t>& indices, uint32_t seed) {
+        std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+        std::memcpy(triangles.data(), indices.data(), indices.size() * sizeof(uint32_t));
+        std::shuffle(triangles.begin(), triangles.end(), std::minstd_rand(seed));
+        std::memcpy(indices.data(), triangles.data(), indices.size() * sizeof(uint32_t));
+    }
+
+    // Triangles rotated so their smallest index comes first, sorted, to compare meshes regardless of triangle order.
+    std::vector<std::array<uint32_t, 3>> CanonicalTriangles(const std::vector<uint32_t>& indices) {
+        std::vector<std::array<uint32_t, 3>> triangles;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            std::array<uint32_t, 3> triangle{indices[i], indices[i + 1], indices[i + 2]};
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    float Acmr(const std::vector<uint32_t>& indices, size_t vertexCount) {
+        return (float)MeshOptimizer::CountCacheMisses(indices.data(), indices.size(), vertexCount) / (indices.size() / 3);
+    }
+} // namespace
+
+TEST_CASE(MeshOptimizer_CountCacheMisses) {
+    // Two triangles sharing an edge transform 4 vertices, then a cache of 3 evicts vertex 0 before it is used again.
+    const uint32_t indices[] = {0, 1, 2, 2, 1, 3, 0, 2, 3};
+    CHECK_EQUAL(size_t{4}, MeshOptimizer::CountCacheMisses(indices, 6, 4));
+    CHECK_EQUAL(size_t{4}, MeshOptimizer::CountCacheMisses(indices, 9, 4));
+    CHECK_EQUAL(size_t{5}, MeshOptimizer::CountCacheMisses(indices, 9, 4, 3));
+}
+
+TEST_CASE(MeshOptimizer_VertexCacheKeepsTrianglesAndWinding) {
+    Mesh mesh = CreateSphere(20);
+    ShuffleTriangles(mesh.Indices, 1);
+    const std::vector<std::array<uint32_t, 3>> before = CanonicalTriangles(mesh.Indices);
+    const float acmrBefore = Acmr(mesh.Indices, mesh.Positions.size());
+
+    MeshOptimizer::OptimizeVertexCache(mesh.Indices.data(), mesh.Indices.size(), mesh.Positions.size());
+    CHECK(before == CanonicalTriangles(mesh.Indices));
+    CHECK(Acmr(mesh.Indices, mesh.Positions.size()) < acmrBefore * 0.5f);
+    CHECK(Acmr(mesh.Indices, mesh.Positions.size()) < 0.8f);
+
+    MeshOptimizer::OptimizeOverdraw(
+        mesh.Indices.data(), mesh.Indices.size(), mesh.Positions.data(), sizeof(mesh.Positions[0]), mesh.Positions.size());
+    CHECK(before == CanonicalTriangles(mesh.Indices));
+}
+
+TEST_CASE(MeshOptimizer_VertexFetchRemap) {
+    std::vector<uint32_t> indices = {4, 2, 0, 0, 2, 5};
+    const std::array<char, 6> vertices = {'a', 'b', 'c', 'd', 'e', 'f'};
+    std::vector<uint32_t> remap;
+    const size_t uniqueCount = MeshOptimizer::OptimizeVertexFetchRemap(indices.data(), indices.size(), vertices.size(), remap);
+    CHECK_EQUAL(size_t{4}, uniqueCount);
+    CHECK(indices == (std::vector<uint32_t>{0, 1, 2, 2, 1, 3}));
+    CHECK_EQUAL(MeshOptimizer::InvalidIndex, remap[1]);
+    CHECK_EQUAL(MeshOptimizer::InvalidIndex, remap[3]);
+
+    const std::vector<char> remapped = MeshOptimizer::RemapVertices(vertices.data(), remap, uniqueCount);
+    CHECK(remapped == (std::vector<char>{'e', 'c', 'a', 'f'}));
+}
+
+BENCHMARK(MeshOptimizer_SphereAcmr) {
+    // 100x100 quads, 20000 triangles, in exporter row order and with the triangles shuffled.
+    const Mesh sphere = CreateSphere(100);
+    Mesh shuffled = sphere;
+    ShuffleTriangles(shuffled.Indices, 2);
+
+    for (const auto& [name, mesh] : {std::pair<const char*, const Mesh*>{"In order", &sphere}, {"Shuffled", &shuffled}}) {
+        std::vector<uint32_t> optimized;
+        const double microseconds = Test::MeasureMicroseconds([&, mesh = mesh] {
+            optimized = mesh->Indices;
+            MeshOptimizer::OptimizeVertexCache(optimized.data(), optimized.size(), mesh->Positions.size());
+        });
+
+        Test::ReportMetric(std::string(name) + " ACMR before", Acmr(mesh->Indices, mesh->Positions.size()), "");
+        Test::ReportMetric(std::string(name) + " ACMR after", Acmr(optimized, mesh->Positions.size()), "");
+        Test::ReportMetric(std::string(name) + " optimize", microseconds / 1000, "ms");
+
+        MeshOptimizer::OptimizeOverdraw(
+            optimized.data(), optimized.size(), mesh->Positions.data(), sizeof(mesh->Positions[0]), mesh->Positions.size());
+        Test::ReportMetric(std::string(name) + " ACMR after overdraw", Acmr(optimized, mesh->Positions.size()), "");
+    }
+}
@@ -0,0 +1,177 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <pbr/PbrMipGenerator.h>
+
+using namespace Pbr;
+
+namespace {
+    std::vector<uint8_t> SolidImage(uint32_t width, uint32_t height, std::array<uint8_t, 4> color) {
+        std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+        for (size_t i = 0; i < rgba.size(); i++) {
+            rgba[i] = color[i % 4];
+        }
+        return rgba;
+    }
+
+    // Black and white texels alternating in both directions, with alpha alternating the other way around.
+    std::vector<uint8_t> Checkerboard(uint32_t width, uint32_t height) {
+        std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                const uint8_t value = (x + y) % 2 == 0 ? 255 : 0;
+                uint8_t* texel = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+                texel[0] = texel[1] = texel[2] = value;
+                texel[3] = 255 - value;
+            }
+        }
+        return rgba;
+    }
+
+    std::vector<uint8_t> RandomImage(uint32_t width, uint32_t height, uint32_t seed) {
+        std::minstd_rand random(seed);
+        std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+        for (uint8_t& value : rgba) {
+            value = static_cast<uint8_t>(random());
+        }
+        return rgba;
+    }
+
+    const uint8_t* TexelAt(const MipLevel& level, uint32_t x, uint32_t y) {
+        return &level.Pixels[(static_cast<size_t>(y) * level.Width + x) * 4];
+    }
+} // namespace
+
+TEST_CASE(MipGenerator_LevelCount) {
+    CHECK_EQUAL(1u, MipGenerator::GetLevelCount(1, 1));
+    CHECK_EQUAL(2u, MipGenerator::GetLevelCount(2, 1));
+    CHECK_EQUAL(9u, MipGenerator::GetLevelCount(256, 256));
+    CHECK_EQUAL(9u, MipGenerator::GetLevelCount(257, 3));
+    CHECK_EQUAL(3u, MipGenerator::GetLevelCount(7, 3));
+    CHECK_EQUAL(11u, MipGenerator::GetLevelCount(1, 1024));
+}
+
+TEST_CASE(MipGenerator_OddSizesHalveRoundingDown) {
+    for (MipFilter filter : {MipFilter::Box, MipFilter::Kaiser}) {
+        const std::vector<uint8_t> image = RandomImage(13, 5, 1);
+        const std::vector<MipLevel> levels = MipGenerator::GenerateMips(image.data(), 13, 5, false, filter);
+
+        // 13x5 -> 6x2 -> 3x1 -> 1x1
+        CHECK_EQUAL(size_t{3}, levels.size());
+        const uint32_t expectedSizes[][2] = {{6, 2}, {3, 1}, {1, 1}};
+        for (size_t i = 0; i < levels.size(); i++) {
+            CHECK_EQUAL(expectedSizes[i][0], levels[i].Width);
+            CHECK_EQUAL(expectedSizes[i][1], levels[i].Height);
+            CHECK_EQUAL(static_cast<size_t>(levels[i].Width) * levels[i].Height * 4, levels[i].Pixels.size());
+        }
+    }
+}
+
+TEST_CASE(MipGenerator_SolidImagesStaySolid) {
+    const std::array<uint8_t, 4> color{200, 30, 90, 128};
+    for (bool sRGB : {false, true}) {
+        for (MipFilter filter : {MipFilter::Box, MipFilter::Kaiser}) {
+            const std::vector<uint8_t> image = SolidImage(37, 11, color);
+            for (const MipLevel& level : MipGenerator::GenerateMips(image.data(), 37, 11, sRGB, filter)) {
+                for (size_t i = 0; i < level.Pixels.size(); i++) {
+                    CHECK_EQUAL((int)color[i % 4], (int)level.Pixels[i]);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(MipGenerator_BoxAveragesInLinearSpaceForSrgb) {
+    const std::vector<uint8_t> image = Checkerboard(4, 4);
+
+    // UNORM data averages the stored values: black and white give 50% gray.
+    const std::vector<MipLevel> unorm = MipGenerator::GenerateMips(image.data(), 4, 4, false, MipFilter::Box);
+    CHECK_EQUAL(128, (int)TexelAt(unorm[0], 1, 1)[0]);
+    CHECK_EQUAL(128, (int)TexelAt(unorm[0], 1, 1)[3]);
+
+    // sRGB data averages the light: 50% linear is 188 in sRGB. Alpha is always linear.
+    const std::vector<MipLevel> srgb = MipGenerator::GenerateMips(image.data(), 4, 4, true, MipFilter::Box);
+    for (uint32_t channel = 0; channel < 3; channel++) {
+        CHECK_EQUAL(188, (int)TexelAt(srgb[0], 1, 0)[channel]);
+        CHECK_EQUAL(188, (int)TexelAt(srgb[1], 0, 0)[channel]);
+    }
+    CHECK_EQUAL(128, (int)TexelAt(srgb[0], 1, 0)[3]);
+}
+
+TEST_CASE(MipGenerator_BoxFilterOfSingleColumn) {
+    // A 1x4 column only averages vertically: the clamped horizontal neighbor is the same texel.
+    const std::vector<uint8_t> image = Checkerboard(1, 4);
+    const std::vector<MipLevel> levels = MipGenerator::GenerateMips(image.data(), 1, 4, false, MipFilter::Box);
+    CHECK_EQUAL(size_t{2}, levels.size());
+    CHECK_EQUAL(1u, levels[0].Width);
+    CHECK_EQUAL(2u, levels[0].Height);
+    CHECK_EQUAL(128, (int)TexelAt(levels[0], 0, 0)[0]);
+    CHECK_EQUAL(128, (int)TexelAt(levels[0], 0, 1)[0]);
+}
+
+TEST_CASE(MipGenerator_BoxMatchesReferenceOnLargeImages) {
+    // Large enough to be split over several tasks.
+    constexpr uint32_t Width = 1024;
+    constexpr uint32_t Height = 768;
+    const std::vector<uint8_t> image = RandomImage(Width, Height, 2);
+    const std::vector<MipLevel> levels = MipGenerator::GenerateMips(image.data(), Width, Height, false, MipFilter::Box);
+    CHECK_EQUAL(size_t{10}, levels.size());
+
+    uint32_t mismatchCount = 0;
+    for (uint32_t y = 0; y < levels[0].Height; y++) {
+        for (uint32_t x = 0; x < levels[0].Width; x++) {
+            for (uint32_t channel = 0; channel < 4; channel++) {
+                const auto source = [&](uint32_t sx, uint32_t sy) {
+                    return (int)image[(static_cast<size_t>(sy) * Width + sx) * 4 + channel];
+                };
+                const int sum = source(x * 2, y * 2) + source(x * 2 + 1, y * 2) + source(x * 2, y * 2 + 1) + source(x * 2 + 1, y * 2 + 1);
+                if (std::abs((sum + 2) / 4 - (int)TexelAt(levels[0], x, y)[channel]) > 1) {
+                    mismatchCount++;
+                }
+            }
+        }
+    }
+    CHECK_EQUAL(0u, mismatchCount);
+}
+
+TEST_CASE(MipGenerator_KaiserKeepsTheAverageOfSmoothImages) {
+    // A horizontal ramp: the Kaiser filter is normalized, so smooth content keeps its level.
+    constexpr uint32_t Width = 64;
+    std::vector<uint8_t> image(Width * Width * 4);
+    for (uint32_t y = 0; y < Width; y++) {
+        for (uint32_t x = 0; x < Width; x++) {
+            for (uint32_t channel = 0; channel < 4; channel++) {
+                image[(y * Width + x) * 4 + channel] = static_cast<uint8_t>(x * 4);
+            }
+        }
+    }
+
+    const std::vector<MipLevel> levels = MipGenerator::GenerateMips(image.data(), Width, Width, false, MipFilter::Kaiser);
+    const MipLevel& level = levels[0];
+    for (uint32_t x = 2; x + 2 < level.Width; x++) {
+        // Destination texel x covers source texels 2x and 2x + 1.
+        CHECK_NEAR(x * 8 + 2, TexelAt(level, x, level.Height / 2)[0], 1);
+    }
+}
+
+TEST_CASE(MipGenerator_NoLevelsWithoutFilterOrPixels) {
+    const std::vector<uint8_t> image = SolidImage(4, 4, {1, 2, 3, 4});
+    CHECK(MipGenerator::GenerateMips(image.data(), 4, 4, false, MipFilter::None).empty());
+    CHECK(MipGenerator::GenerateMips(image.data(), 0, 4, false, MipFilter::Box).empty());
+    CHECK(MipGenerator::GenerateMips(image.data(), 1, 1, false, MipFilter::Box).empty());
+}
+
+BENCHMARK(MipGenerator_2048) {
+    constexpr uint32_t Size = 2048;
+    const std::vector<uint8_t> image = RandomImage(Size, Size, 3);
+    for (MipFilter filter : {MipFilter::Box, MipFilter::Kaiser}) {
+        for (bool sRGB : {false, true}) {
+            const double microseconds = Test::MeasureMicroseconds(
+                [&] { Test::DoNotOptimize(MipGenerator::GenerateMips(image.data(), Size, Size, sRGB, filter).data()); }, 3);
+            Test::ReportMetric(std::string(filter == MipFilter::Box ? "Box" : "Kaiser") + (sRGB ? ", sRGB" : ", UNORM"),
+                               microseconds / 1000,
+                               "ms/chain");
+        }
+    }
+}
@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <pbr/PbrModel.h>
+#include <pbr/PbrRecordingRenderDevice.h>
+#include <pbr/PbrResources.h>
+#include "D3D11TestDevice.h"
+
+using namespace DirectX;
+
+namespace {
+    constexpr uint32_t NodeCount = 500;
+
+    // A random hierarchy of NodeCount nodes under the root, each parented to an earlier node like glTF scenes are loaded.
+    void AddRandomHierarchy(Pbr::Model& model, std::minstd_rand& random) {
+        std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+        for (uint32_t i = 0; i < NodeCount; i++) {
+            const Pbr::NodeIndex_t parent = (Pbr::NodeIndex_t)(random() % model.GetNodeCount());
+            model.AddNode(XMMatrixTranslation(offset(random), offset(random), offset(random)), parent, "Node" + std::to_string(i));
+        }
+    }
+} // namespace
+
+// 500 nodes with 5 of them animated, updated each frame when every node changes (the cost of the update before it was
+// incremental) and when only the animated nodes change.
+BENCHMARK(Model_TransformUpdate) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    ID3D11DeviceContext* context = device.Context.get();
+    Pbr::Resources pbrResources(device.Device.get());
+
+    std::minstd_rand random(39);
+    Pbr::Model model;
+    AddRandomHierarchy(model, random);
+    std::vector<Pbr::NodeIndex_t> animatedNodes;
+    for (uint32_t i = 0; i < 5; i++) {
+        animatedNodes.push_back((Pbr::NodeIndex_t)(1 + random() % NodeCount));
+    }
+    model.Render(pbrResources, context);
+
+    float angle = 0;
+    const auto animate = [&](const std::vector<Pbr::NodeIndex_t>& nodes) {
+        angle += 0.01f;
+        for (const Pbr::NodeIndex_t node : nodes) {
+            model.GetNode(node).SetTransform(XMMatrixRotationY(angle) * model.GetNode(node).GetTransform());
+        }
+        model.Render(pbrResources, context);
+    };
+
+    std::vector<Pbr::NodeIndex_t> allNodes(model.GetNodeCount());
+    std::iota(allNodes.begin(), allNodes.end(), Pbr::NodeIndex_t{0});
+    const std::pair<const char*, const std::vector<Pbr::NodeIndex_t>*> cases[] = {{"All nodes changed", &allNodes},
+                                                                                   {"5 animated nodes", &animatedNodes}};
+    for (const auto& [name, nodes] : cases) {
+        const double microseconds = Test::MeasureMicroseconds([&, nodes = nodes] { animate(*nodes); });
+        const Pbr::TransformUpdateStats& stats = model.GetLastTransformUpdateStats();
+        Test::ReportMetric(std::string(name) + ", update", microseconds, "us/frame");
+        Test::ReportMetric(std::string(name) + ", updated nodes", stats.UpdatedNodeCount, "nodes");
+        Test::ReportMetric(std::string(name) + ", upload ranges", stats.UploadRangeCount, "ranges");
+        Test::ReportMetric(std::string(name) + ", upload", (double)stats.UploadBytes, "bytes/frame");
+    }
+
+    // Nothing changed: nothing is recomputed or uploaded.
+    model.Render(pbrResources, context);
+    CHECK_EQUAL(0u, model.GetLastTransformUpdateStats().UpdatedNodeCount);
+    CHECK_EQUAL(size_t{0}, model.GetLastTransformUpdateStats().UploadBytes);
+}
+
+// 250 lookups scoped to a parent node on a 500-node hierarchy, the access pattern of loading a controller model: 125
+// components with VALUE, MIN and MAX children each, where the children of every component share their names.
+BENCHMARK(Model_FindNodeByParent) {
+    Pbr::Model model;
+    std::vector<Pbr::NodeIndex_t> components;
+    for (uint32_t i = 0; i < 125; i++) {
+        components.push_back(model.AddNode(XMMatrixIdentity(), Pbr::RootNodeIndex, "component" + std::to_string(i)));
+        for (const char* child : {"VALUE", "MIN", "MAX"}) {
+            model.AddNode(XMMatrixIdentity(), components.back(), child);
+        }
+    }
+
+    // The lookup before the name index: a scan of the nodes after the parent.
+    const auto findByScan = [&](std::string_view name, Pbr::NodeIndex_t parent) -> std::optional<Pbr::NodeIndex_t> {
+        for (Pbr::NodeIndex_t i = parent + 1; i < model.GetNodeCount(); i++) {
+            if (model.GetNode(i).ParentNodeIndex == parent && model.GetNode(i).Name == name) {
+                return i;
+            }
+        }
+        return {};
+    };
+
+    size_t found = 0;
+    const double scanMicroseconds = Test::MeasureMicroseconds([&] {
+        found = 0;
+        for (const Pbr::NodeIndex_t component : components) {
+            found += findByScan("VALUE", component).has_value() + findByScan("MAX", component).has_value();
+        }
+    });
+    const double indexMicroseconds = Test::MeasureMicroseconds([&] {
+        found = 0;
+        for (const Pbr::NodeIndex_t component : components) {
+            found += model.FindFirstNode("VALUE", component).has_value() + model.FindFirstNode("MAX", component).has_value();
+        }
+    });
+    CHECK_EQUAL(size_t{250}, found);
+
+    for (const Pbr::NodeIndex_t component : components) {
+        CHECK(findByScan("MAX", component) == model.FindFirstNode("MAX", component));
+    }
+    CHECK(!model.FindFirstNode("VALUE", Pbr::RootNodeIndex).has_value());
+
+    Test::ReportMetric("Linear scan", scanMicroseconds, "us/250 lookups");
+    Test::ReportMetric("Name index", indexMicroseconds, "us/250 lookups");
+}
+
+// The submission of a frame of a model with 200 cubes on their own nodes and 20 materials, 5 of them alpha blended, through
+// Model::Render into the recording render device, with materials using constant buffers and the material table. The
+// objects are created on WARP, while the binds, uploads and draws are counted by the recording device.
+BENCHMARK(Model_RenderSubmission) {
+    constexpr uint32_t PrimitiveCount = 200;
+    constexpr uint32_t MaterialCount = 20;
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    ID3D11DeviceContext* context = device.Context.get();
+    Pbr::RecordingRenderDevice recording(false);
+    Pbr::Resources pbrResources(device.Device.get(), recording);
+
+    std::vector<std::shared_ptr<Pbr::Material>> materials;
+    for (uint32_t i = 0; i < MaterialCount; i++) {
+        const float shade = (float)i / MaterialCount;
+        materials.push_back(Pbr::Material::CreateFlat(pbrResources, Pbr::RGBAColor{shade, 1 - shade, 0.5f, i % 4 == 0 ? 0.5f : 1.0f}));
+    }
+    Pbr::Model model;
+    for (uint32_t i = 0; i < PrimitiveCount; i++) {
+        const Pbr::NodeIndex_t node = model.AddNode(XMMatrixTranslation((float)(i % 20), (float)(i / 20), -10), Pbr::RootNodeIndex);
+        Pbr::PrimitiveBuilder builder;
+        builder.AddCube(0.5f, node);
+        model.AddPrimitive(Pbr::Primitive(pbrResources, builder, materials[i % MaterialCount]));
+    }
+
+    float angle = 0;
+    const auto renderFrame = [&] {
+        angle += 0.01f;
+        model.GetNode(1).SetTransform(XMMatrixRotationY(angle) * XMMatrixTranslation(0, 0, -10));
+        pbrResources.Bind(context);
+        pbrResources.SetModelToWorld(XMMatrixIdentity(), context);
+        model.Render(pbrResources, context);
+    };
+
+    for (const bool materialTable : {false, true}) {
+        pbrResources.SetMaterialTableEnabled(materialTable);
+        renderFrame(); // Creates the transforms buffer, and imports the buffers and textures of the primitives and materials.
+
+        const double microseconds = Test::MeasureMicroseconds([&] {
+            recording.ResetStats();
+            renderFrame();
+        });
+        const Pbr::RenderDeviceStats& stats = recording.GetStats();
+        CHECK_EQUAL(PrimitiveCount, stats.DrawCount);
+        CHECK_EQUAL(0u, stats.CreatedResourceCount); // Imports are kept by their owners across frames.
+
+        const std::string name = materialTable ? "Material table" : "Constant buffers";
+        Test::ReportMetric(name + ", submission", microseconds, "us/frame");
+        Test::ReportMetric(name + ", draws", stats.DrawCount, "draws");
+        Test::ReportMetric(name + ", state changes", stats.StateChangeCount, "changes");
+        Test::ReportMetric(name + ", redundant state changes", stats.RedundantStateChangeCount, "changes");
+        Test::ReportMetric(name + ", upload", (double)stats.UploadBytes, "bytes/frame");
+    }
+}
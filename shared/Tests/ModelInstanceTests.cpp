@@ -0,0 +1,244 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <pbr/PbrModel.h>
+#include <pbr/PbrModelInstance.h>
+#include <pbr/PbrResources.h>
+#include "D3D11TestDevice.h"
+
+using namespace DirectX;
+
+namespace {
+    constexpr uint32_t TargetSize = 32;
+    constexpr float ViewExtent = 2; // The orthographic view covers [-2, 2] in x and y.
+
+    // Colors as 0xBBGGRR, without the alpha channel, which depends on the blend state of the pass.
+    constexpr uint32_t Green = 0x00FF00;
+    constexpr uint32_t Blue = 0xFF0000;
+    constexpr uint32_t Red = 0x0000FF;
+    constexpr uint32_t Empty = 0;
+
+    std::shared_ptr<Pbr::Material> CreateUnlitMaterial(const Pbr::Resources& pbrResources, Pbr::RGBAColor color) {
+        std::shared_ptr<Pbr::Material> material = Pbr::Material::CreateFlat(pbrResources, color);
+        material->SetUnlit(true);
+        material->SetDoubleSided(true);
+        return material;
+    }
+
+    // A green quad on the node "Left" at (-1, 0, 0) and a blue quad on the node "Right" at (1, 0, 0), drawn unlit so that the
+    // colors of the pixels they cover are exactly their material colors.
+    std::shared_ptr<Pbr::Model> CreateTwoQuadModel(const Pbr::Resources& pbrResources) {
+        auto model = std::make_shared<Pbr::Model>();
+        const Pbr::NodeIndex_t left = model->AddNode(XMMatrixTranslation(-1, 0, 0), Pbr::RootNodeIndex, "Left");
+        const Pbr::NodeIndex_t right = model->AddNode(XMMatrixTranslation(1, 0, 0), Pbr::RootNodeIndex, "Right");
+        model->AddPrimitive(Pbr::Primitive(pbrResources,
+                                           Pbr::PrimitiveBuilder().AddQuad({0.5f, 0.5f}, {1, 1}, left),
+                                           CreateUnlitMaterial(pbrResources, Pbr::RGBAColor{0, 1, 0, 1})));
+        model->AddPrimitive(Pbr::Primitive(pbrResources,
+                                           Pbr::PrimitiveBuilder().AddQuad({0.5f, 0.5f}, {1, 1}, right),
+                                           CreateUnlitMaterial(pbrResources, Pbr::RGBAColor{0, 0, 1, 1})));
+        return model;
+    }
+
+    struct Renderer {
+        Test::D3D11Device Device = Test::CreateWarpDevice();
+        Pbr::Resources PbrResources{Device.Device.get()};
+        Test::RenderTarget Target = Test::CreateRenderTarget(Device.Device.get(), TargetSize);
+
+        // Render a model or instance in an orthographic view looking down -Z, and read the pixels back.
+        template <typename T>
+        std::vector<uint32_t> Render(const T& modelOrInstance, std::optional<Pbr::DrawPass> drawPass = {}) {
+            ID3D11DeviceContext* context = Device.Context.get();
+            Target.ClearAndBind(context);
+            PbrResources.SetViewProjection(XMMatrixIdentity(),
+                                           XMMatrixOrthographicOffCenterRH(-ViewExtent, ViewExtent, -ViewExtent, ViewExtent, -1, 1));
+            PbrResources.SetDrawPass(drawPass);
+            PbrResources.Bind(context);
+            PbrResources.SetModelToWorld(XMMatrixIdentity(), context);
+            modelOrInstance.Render(PbrResources, context);
+            PbrResources.SetDrawPass(std::nullopt);
+            return Target.ReadPixels(context);
+        }
+    };
+
+    // The color of the pixel containing a point of the view.
+    uint32_t ColorAt(const std::vector<uint32_t>& pixels, float x, float y) {
+        const uint32_t column = (uint32_t)((x + ViewExtent) / (2 * ViewExtent) * TargetSize);
+        const uint32_t row = (uint32_t)((ViewExtent - y) / (2 * ViewExtent) * TargetSize);
+        return pixels[row * TargetSize + column] & 0xFFFFFF;
+    }
+} // namespace
+
+TEST_CASE(ModelInstance_NodeTransformOverrides) {
+    Renderer renderer;
+    const std::shared_ptr<Pbr::Model> model = CreateTwoQuadModel(renderer.PbrResources);
+    const Pbr::NodeIndex_t left = model->FindFirstNode("Left").value();
+    const Pbr::NodeIndex_t right = model->FindFirstNode("Right").value();
+    Pbr::ModelInstance instance(model);
+
+    // An instance without overrides renders with the model's transforms, and owns no transform buffer.
+    std::vector<uint32_t> pixels = renderer.Render(instance);
+    CHECK_EQUAL(Green, ColorAt(pixels, -1, 0));
+    CHECK_EQUAL(Blue, ColorAt(pixels, 1, 0));
+    CHECK_EQUAL(sizeof(Pbr::ModelInstance), instance.GetInstanceByteSize());
+
+    // Overriding a node moves its quad in the instance only.
+    instance.SetNodeTransform(left, XMMatrixTranslation(-1, 1, 0));
+    CHECK(XMVector4Equal(instance.GetNodeTransform(left).r[3], XMVectorSet(-1, 1, 0, 1)));
+    CHECK(XMVector4Equal(instance.GetNodeTransform(right).r[3], XMVectorSet(1, 0, 0, 1)));
+    pixels = renderer.Render(instance);
+    CHECK_EQUAL(Green, ColorAt(pixels, -1, 1));
+    CHECK_EQUAL(Empty, ColorAt(pixels, -1, 0));
+    CHECK_EQUAL(Blue, ColorAt(pixels, 1, 0));
+    const size_t posedByteSize = instance.GetInstanceByteSize();
+    CHECK(posedByteSize > sizeof(Pbr::ModelInstance));
+    pixels = renderer.Render(*model);
+    CHECK_EQUAL(Green, ColorAt(pixels, -1, 0));
+    CHECK_EQUAL(Empty, ColorAt(pixels, -1, 1));
+
+    // Changes of the model's nodes show through on the nodes the instance doesn't override, even though the model was already
+    // rendered with them: the instance recomputes its transforms when the model's transform generation changes.
+    model->GetNode(right).SetTransform(XMMatrixTranslation(1, -1, 0));
+    pixels = renderer.Render(*model);
+    CHECK_EQUAL(Blue, ColorAt(pixels, 1, -1));
+    pixels = renderer.Render(instance);
+    CHECK_EQUAL(Green, ColorAt(pixels, -1, 1));
+    CHECK_EQUAL(Blue, ColorAt(pixels, 1, -1));
+    CHECK_EQUAL(Empty, ColorAt(pixels, 1, 0));
+
+    // Overrides win over later changes of the model's node.
+    model->GetNode(left).SetTransform(XMMatrixTranslation(-1, -1, 0));
+    pixels = renderer.Render(instance);
+    CHECK_EQUAL(Green, ColorAt(pixels, -1, 1));
+    CHECK_EQUAL(Empty, ColorAt(pixels, -1, -1));
+
+    // Resetting the node goes back to the model's transform.
+    instance.ResetNodeTransform(left);
+    pixels = renderer.Render(instance);
+    CHECK_EQUAL(Green, ColorAt(pixels, -1, -1));
+    CHECK_EQUAL(Empty, ColorAt(pixels, -1, 1));
+
+    // Resetting all nodes also releases the transform buffer.
+    instance.SetNodeTransform(right, XMMatrixTranslation(1, 1, 0));
+    pixels = renderer.Render(instance);
+    CHECK_EQUAL(Blue, ColorAt(pixels, 1, 1));
+    instance.ResetNodeTransforms();
+    CHECK(instance.GetInstanceByteSize() < posedByteSize);
+    pixels = renderer.Render(instance);
+    CHECK_EQUAL(Blue, ColorAt(pixels, 1, -1));
+    CHECK_EQUAL(Empty, ColorAt(pixels, 1, 1));
+
+    CHECK_THROWS(instance.SetNodeTransform(model->GetNodeCount(), XMMatrixIdentity()), std::out_of_range);
+}
+
+TEST_CASE(ModelInstance_MaterialOverrides) {
+    Renderer renderer;
+    const std::shared_ptr<Pbr::Model> model = CreateTwoQuadModel(renderer.PbrResources);
+    Pbr::ModelInstance instance(model);
+    CHECK(instance.GetDrawPasses().Opaque);
+    CHECK(!instance.GetDrawPasses().Blended);
+
+    // A blended red material on the right quad moves it into the blended pass of the instance, and not of the model.
+    std::shared_ptr<Pbr::Material> red = CreateUnlitMaterial(renderer.PbrResources, Pbr::RGBAColor{1, 0, 0, 1});
+    red->SetAlphaBlended(true);
+    instance.SetMaterialOverride(1, red);
+    CHECK(instance.GetMaterial(1) == red);
+    CHECK(instance.GetMaterial(0) == model->GetPrimitive(0).GetMaterial());
+    CHECK(instance.GetDrawPasses().Opaque);
+    CHECK(instance.GetDrawPasses().Blended);
+    CHECK(!model->GetDrawPasses().Blended);
+
+    // Each pass only draws the primitives whose material, overridden or not, is in that pass.
+    std::vector<uint32_t> pixels = renderer.Render(instance, Pbr::DrawPass::Opaque);
+    CHECK_EQUAL(Green, ColorAt(pixels, -1, 0));
+    CHECK_EQUAL(Empty, ColorAt(pixels, 1, 0));
+    pixels = renderer.Render(instance, Pbr::DrawPass::Blended);
+    CHECK_EQUAL(Empty, ColorAt(pixels, -1, 0));
+    CHECK_EQUAL(Red, ColorAt(pixels, 1, 0));
+    pixels = renderer.Render(*model);
+    CHECK_EQUAL(Blue, ColorAt(pixels, 1, 0));
+
+    // Overriding the first primitive too keeps the overrides sorted, so both are applied.
+    instance.SetMaterialOverride(0, CreateUnlitMaterial(renderer.PbrResources, Pbr::RGBAColor{0, 0, 1, 1}));
+    pixels = renderer.Render(instance);
+    CHECK_EQUAL(Blue, ColorAt(pixels, -1, 0));
+    CHECK_EQUAL(Red, ColorAt(pixels, 1, 0));
+
+    // Hidden materials are neither drawn nor reported.
+    instance.GetMaterial(0)->Hidden = true;
+    CHECK(!instance.GetDrawPasses().Opaque);
+    pixels = renderer.Render(instance);
+    CHECK_EQUAL(Empty, ColorAt(pixels, -1, 0));
+
+    // A null material removes the override.
+    instance.SetMaterialOverride(0, nullptr);
+    instance.SetMaterialOverride(1, nullptr);
+    CHECK(instance.GetMaterial(1) == model->GetPrimitive(1).GetMaterial());
+    CHECK(!instance.GetDrawPasses().Blended);
+    pixels = renderer.Render(instance);
+    CHECK_EQUAL(Green, ColorAt(pixels, -1, 0));
+    CHECK_EQUAL(Blue, ColorAt(pixels, 1, 0));
+
+    CHECK_THROWS(instance.SetMaterialOverride(model->GetPrimitiveCount(), red), std::out_of_range);
+}
+
+// 1,000 posed copies of a model with 100 nodes and 10 primitives, as instances with one node override and as clones. Clones
+// share the vertex and index buffers of the model, but own their nodes, transform buffer and a material per primitive.
+BENCHMARK(ModelInstance_InstanceByteSizeVersusClone) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    ID3D11DeviceContext* context = device.Context.get();
+    Pbr::Resources pbrResources(device.Device.get());
+
+    constexpr uint32_t CopyCount = 1000;
+    constexpr uint32_t NodeCount = 100;
+    constexpr uint32_t PrimitiveCount = 10;
+    auto model = std::make_shared<Pbr::Model>();
+    for (uint32_t i = 0; i < NodeCount; i++) {
+        model->AddNode(XMMatrixTranslation(0.01f, 0, 0), (Pbr::NodeIndex_t)(i / 2), "Node" + std::to_string(i));
+    }
+    for (uint32_t i = 0; i < PrimitiveCount; i++) {
+        model->AddPrimitive(Pbr::Primitive(pbrResources,
+                                           Pbr::PrimitiveBuilder().AddCube(0.1f, (Pbr::NodeIndex_t)(1 + i * 9)),
+                                           Pbr::Material::CreateFlat(pbrResources, Pbr::RGBA::White)));
+    }
+    model->Render(pbrResources, context);
+
+    std::vector<Pbr::ModelInstance> instances;
+    instances.reserve(CopyCount);
+    const double instanceMicroseconds = Test::MeasureMicroseconds([&] {
+        instances.clear();
+        for (uint32_t i = 0; i < CopyCount; i++) {
+            instances.emplace_back(model).SetNodeTransform(1, XMMatrixTranslation(0, (float)i, 0));
+            instances.back().Render(pbrResources, context);
+        }
+    });
+    size_t instanceBytes = 0;
+    for (const Pbr::ModelInstance& instance : instances) {
+        instanceBytes += instance.GetInstanceByteSize();
+    }
+
+    std::vector<std::shared_ptr<Pbr::Model>> clones;
+    clones.reserve(CopyCount);
+    const double cloneMicroseconds = Test::MeasureMicroseconds([&] {
+        clones.clear();
+        for (uint32_t i = 0; i < CopyCount; i++) {
+            clones.push_back(model->Clone(pbrResources));
+            clones.back()->GetNode(1).SetTransform(XMMatrixTranslation(0, (float)i, 0));
+            clones.back()->Render(pbrResources, context);
+        }
+    });
+    // Each cloned primitive owns a material with its own constant buffer.
+    constexpr size_t ClonedPrimitiveBytes = sizeof(Pbr::Primitive) + sizeof(Pbr::Material) + sizeof(Pbr::Material::ConstantBufferData);
+    size_t cloneBytes = 0;
+    for (const std::shared_ptr<Pbr::Model>& clone : clones) {
+        cloneBytes += sizeof(Pbr::Model) + clone->GetNodeCount() * sizeof(Pbr::Node) + clone->GetMemoryFootprint().TransformBufferBytes +
+                      clone->GetPrimitiveCount() * ClonedPrimitiveBytes;
+    }
+
+    Test::ReportMetric("Instances, create and render", instanceMicroseconds / CopyCount, "us/copy");
+    Test::ReportMetric("Clones, create and render", cloneMicroseconds / CopyCount, "us/copy");
+    Test::ReportMetric("Instances, owned memory", (double)instanceBytes / CopyCount, "bytes/copy");
+    Test::ReportMetric("Clones, owned memory", (double)cloneBytes / CopyCount, "bytes/copy");
+    CHECK(instanceBytes < cloneBytes);
+}
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <pbr/PbrModel.h>
+#include <pbr/PbrResources.h>
+#include "D3D11TestDevice.h"
+
+using namespace DirectX;
+
+namespace {
+    XMMATRIX RandomTransform(std::minstd_rand& random) {
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        const XMVECTOR axis = XMVector3Normalize(XMVectorSet(unit(random), unit(random), unit(random) + 2, 0));
+        return XMMatrixScaling(1 + unit(random) * 0.2f, 1, 1) * XMMatrixRotationAxis(axis, unit(random) * XM_PI) *
+               XMMatrixTranslation(unit(random), unit(random), unit(random));
+    }
+
+    // Check the transforms of the most recent render against transforms computed from scratch for every node.
+    void CheckModelTransforms(const Pbr::Model& model) {
+        const std::vector<XMFLOAT4X4>& modelTransforms = model.GetModelTransforms();
+        CHECK_EQUAL((size_t)model.GetNodeCount(), modelTransforms.size());
+        const XMMATRIX rootTransform = model.GetNode(Pbr::RootNodeIndex).GetTransform();
+        for (Pbr::NodeIndex_t nodeIndex = 0; nodeIndex < model.GetNodeCount(); nodeIndex++) {
+            XMFLOAT4X4 expected;
+            XMStoreFloat4x4(&expected, XMMatrixTranspose(model.GetNodeToModelRootTransform(nodeIndex) * rootTransform));
+            for (uint32_t i = 0; i < 16; i++) {
+                CHECK_NEAR((&expected._11)[i], (&modelTransforms[nodeIndex]._11)[i], 1e-4f);
+            }
+        }
+    }
+} // namespace
+
+TEST_CASE(Model_IncrementalTransformsMatchFullRecompute) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    ID3D11DeviceContext* context = device.Context.get();
+    Pbr::Resources pbrResources(device.Device.get());
+
+    // A random hierarchy of 300 nodes, each parented to an earlier node like glTF scenes are loaded, under a moved root.
+    std::minstd_rand random(39);
+    Pbr::Model model;
+    model.GetNode(Pbr::RootNodeIndex).SetTransform(RandomTransform(random));
+    for (uint32_t i = 0; i < 300; i++) {
+        model.AddNode(RandomTransform(random), (Pbr::NodeIndex_t)(random() % model.GetNodeCount()));
+    }
+    model.Render(pbrResources, context);
+    CHECK_EQUAL(model.GetNodeCount(), model.GetLastTransformUpdateStats().UpdatedNodeCount);
+    CheckModelTransforms(model);
+
+    // Change a few random nodes per frame, and the root node every 10 frames. Exactly the subtrees of the changed nodes are
+    // updated, and every node ends up with the transform of a full recompute.
+    for (uint32_t frame = 0; frame < 50; frame++) {
+        std::vector<bool> changed(model.GetNodeCount(), false);
+        const uint32_t changeCount = 1 + random() % 5;
+        for (uint32_t i = 0; i < changeCount; i++) {
+            const Pbr::NodeIndex_t nodeIndex = (Pbr::NodeIndex_t)(1 + random() % (model.GetNodeCount() - 1));
+            model.GetNode(nodeIndex).SetTransform(RandomTransform(random));
+            changed[nodeIndex] = true;
+        }
+        if (frame % 10 == 9) {
+            model.GetNode(Pbr::RootNodeIndex).SetTransform(RandomTransform(random));
+            changed[Pbr::RootNodeIndex] = true;
+        }
+
+        uint32_t expectedUpdatedNodeCount = 0;
+        for (Pbr::NodeIndex_t nodeIndex = 0; nodeIndex < model.GetNodeCount(); nodeIndex++) {
+            const Pbr::NodeIndex_t parentIndex = model.GetNode(nodeIndex).ParentNodeIndex;
+            changed[nodeIndex] = changed[nodeIndex] || (nodeIndex != Pbr::RootNodeIndex && changed[parentIndex]);
+            expectedUpdatedNodeCount += changed[nodeIndex] ? 1 : 0;
+        }
+
+        model.Render(pbrResources, context);
+        CHECK_EQUAL(expectedUpdatedNodeCount, model.GetLastTransformUpdateStats().UpdatedNodeCount);
+        CheckModelTransforms(model);
+    }
+
+    // Nothing changed: nothing is updated and the transforms stay the same.
+    model.Render(pbrResources, context);
+    CHECK_EQUAL(0u, model.GetLastTransformUpdateStats().UpdatedNodeCount);
+    CheckModelTransforms(model);
+}
@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <unordered_set>
+#include <pbr/PbrPipelineState.h>
+
+using namespace Pbr;
+
+namespace {
+    struct FakePipelineState {
+        PipelineStateKey Key;
+    };
+
+    struct KeySet {
+        std::unordered_set<PipelineStateKey, PipelineStateKeyHash> Keys;
+
+        bool Insert(PipelineStateKey key) {
+            return Keys.insert(key).second;
+        }
+    };
+} // namespace
+
+TEST_CASE(PipelineStateKey_WithAndHas) {
+    const PipelineStateKey key = PipelineStateKey{}
+                                     .With(PipelineStateBits::AlphaBlended, true)
+                                     .With(PipelineStateBits::ReverseZ, true)
+                                     .With(PixelShaderPermutation::Unlit);
+    CHECK(key.Has(PipelineStateBits::AlphaBlended));
+    CHECK(key.Has(PipelineStateBits::ReverseZ));
+    CHECK(!key.Has(PipelineStateBits::DoubleSided));
+    CHECK(key.GetPixelShaderPermutation() == PixelShaderPermutation::Unlit);
+
+    const PipelineStateKey changed = key.With(PipelineStateBits::AlphaBlended, false).With(PixelShaderPermutation::Flat);
+    CHECK(!changed.Has(PipelineStateBits::AlphaBlended));
+    CHECK(changed.Has(PipelineStateBits::ReverseZ));
+    CHECK(changed.GetPixelShaderPermutation() == PixelShaderPermutation::Flat);
+    CHECK(changed != key);
+    CHECK(changed.With(PipelineStateBits::AlphaBlended, true).With(PixelShaderPermutation::Unlit) == key);
+}
+
+TEST_CASE(PipelineStateKey_EveryPermutationRoundTrips) {
+    for (uint32_t permutation = 0; permutation < PixelShaderPermutationCount; permutation++) {
+        const PipelineStateKey key = PipelineStateKey{PipelineStateBits::Wireframe}.With((PixelShaderPermutation)permutation);
+        CHECK_EQUAL(permutation, (uint32_t)key.GetPixelShaderPermutation());
+        CHECK(key.Has(PipelineStateBits::Wireframe));
+    }
+}
+
+TEST_CASE(PipelineStateKey_Validity) {
+    for (uint32_t vertexFormat : PipelineStateBits::VertexFormats) {
+        CHECK(PipelineStateKey{vertexFormat | PipelineStateBits::AlphaBlended}.IsValid());
+    }
+    CHECK(!PipelineStateKey{PipelineStateBits::QuantizedPosition}.IsValid());
+    CHECK(!PipelineStateKey{PipelineStateBits::CompactVertex | PipelineStateBits::SplitVertexStreams}.IsValid());
+    CHECK(!PipelineStateKey{PipelineStateBits::CompactVertex | PipelineStateBits::SkinnedVertex}.IsValid());
+    CHECK(!PipelineStateKey{PipelineStateBits::SplitVertexStreams | PipelineStateBits::SkinnedVertex}.IsValid());
+}
+
+TEST_CASE(PipelineStateKey_NormalizesHighlightKeys) {
+    const PipelineStateKey highlight{PipelineStateBits::Highlight | PipelineStateBits::DoubleSided};
+    const PipelineStateKey withPbrBits = highlight.With(PipelineStateBits::MaterialTable, true)
+                                             .With(PipelineStateBits::TextureArrays, true)
+                                             .With(PixelShaderPermutation::Unlit);
+    CHECK(highlight != withPbrBits);
+    CHECK(highlight.Normalized() == withPbrBits.Normalized());
+    CHECK(PipelineStateKeyHash{}(highlight.Normalized()) == PipelineStateKeyHash{}(withPbrBits.Normalized()));
+    CHECK(withPbrBits.Normalized().Has(PipelineStateBits::DoubleSided));
+
+    // Regular keys keep every bit.
+    const PipelineStateKey regular = withPbrBits.With(PipelineStateBits::Highlight, false);
+    CHECK(regular.Normalized() == regular);
+}
+
+TEST_CASE(PipelineStateKey_HashMatchesEquality) {
+    KeySet keys;
+    uint32_t distinctCount = 0;
+    for (uint32_t bits = 0; bits < (1u << 14); bits++) {
+        const PipelineStateKey key = PipelineStateKey{bits}.Normalized();
+        CHECK(PipelineStateKeyHash{}(key) == PipelineStateKeyHash{}(PipelineStateKey{key.Bits}));
+        if (keys.Insert(key)) {
+            distinctCount++;
+        }
+    }
+
+    // 2^13 regular keys, and 2^9 highlight keys without the material table, texture array and pixel shader bits.
+    CHECK_EQUAL(8192u + 512u, distinctCount);
+}
+
+TEST_CASE(PipelineStateKey_MaterialKeysOfTheSettings) {
+    const PipelineStateKey settings = PipelineStateKey{}
+                                          .With(PipelineStateBits::ReverseZ, true)
+                                          .With(PipelineStateBits::MaterialTable, true)
+                                          .With(PipelineStateBits::AlphaBlended, true); // A material bit, ignored.
+    const std::vector<PipelineStateKey> keys = GetMaterialPipelineStateKeys(settings);
+
+    // 5 vertex formats, 4 pixel shaders, and alpha blended, double sided and wireframe on or off.
+    CHECK_EQUAL(size_t{5 * 4 * 8}, keys.size());
+    KeySet distinct;
+    for (PipelineStateKey key : keys) {
+        CHECK(key.IsValid());
+        CHECK(key == key.Normalized());
+        CHECK(key.Has(PipelineStateBits::ReverseZ));
+        CHECK(key.Has(PipelineStateBits::MaterialTable));
+        CHECK(!key.Has(PipelineStateBits::TextureArrays));
+        CHECK(!key.Has(PipelineStateBits::FrontCounterClockwise));
+        CHECK(distinct.Insert(key));
+    }
+
+    // Every key a material can resolve to with these settings is in the list.
+    for (uint32_t vertexFormat : PipelineStateBits::VertexFormats) {
+        const PipelineStateKey key = PipelineStateKey{settings.Bits | vertexFormat | PipelineStateBits::Wireframe}.With(
+            PixelShaderPermutation::NoImageBasedLighting);
+        CHECK(!distinct.Insert(key));
+    }
+}
+
+TEST_CASE(PipelineStateKey_HighlightMaterialKeys) {
+    const PipelineStateKey settings = PipelineStateKey{}
+                                          .With(PipelineStateBits::Highlight, true)
+                                          .With(PipelineStateBits::MaterialTable, true)
+                                          .With(PipelineStateBits::TextureArrays, true);
+    const std::vector<PipelineStateKey> keys = GetMaterialPipelineStateKeys(settings);
+    CHECK_EQUAL(size_t{5 * 8}, keys.size());
+
+    KeySet distinct;
+    for (PipelineStateKey key : keys) {
+        CHECK(key.Has(PipelineStateBits::Highlight));
+        CHECK(!key.Has(PipelineStateBits::PbrPixelShaderMask));
+        CHECK(distinct.Insert(key));
+    }
+}
+
+TEST_CASE(PipelineStateCache_HitsAndMisses) {
+    PipelineStateCache<FakePipelineState> cache;
+    uint32_t createCount = 0;
+    const auto factory = [&createCount](PipelineStateKey key) {
+        createCount++;
+        return std::make_unique<FakePipelineState>(FakePipelineState{key});
+    };
+
+    const PipelineStateKey first{PipelineStateBits::AlphaBlended};
+    const PipelineStateKey second{PipelineStateBits::DoubleSided};
+    CHECK(cache.Find(first) == nullptr);
+    CHECK_EQUAL(size_t{0}, cache.Size());
+
+    const FakePipelineState& firstState = cache.GetOrCreate(first, factory);
+    CHECK_EQUAL(1u, createCount);
+    CHECK(firstState.Key == first);
+    CHECK(&cache.GetOrCreate(first, factory) == &firstState);
+    CHECK_EQUAL(1u, createCount);
+    CHECK(cache.Find(first) == &firstState);
+
+    const FakePipelineState& secondState = cache.GetOrCreate(second, factory);
+    CHECK_EQUAL(2u, createCount);
+    CHECK(&secondState != &firstState);
+    CHECK_EQUAL(size_t{2}, cache.Size());
+
+    // References stay valid while other states are added.
+    for (PipelineStateKey key : GetMaterialPipelineStateKeys(PipelineStateKey{})) {
+        cache.GetOrCreate(key, factory);
+    }
+    CHECK(cache.Find(first) == &firstState);
+    CHECK(firstState.Key == first);
+
+    cache.Clear();
+    CHECK_EQUAL(size_t{0}, cache.Size());
+    CHECK(cache.Find(first) == nullptr);
+    const uint32_t countBefore = createCount;
+    cache.GetOrCreate(first, factory);
+    CHECK_EQUAL(countBefore + 1, createCount);
+}
+
+TEST_CASE(PixelShaderPermutation_SelectsTheCheapestForTheFeatures) {
+    CHECK(SelectPixelShaderPermutation(MaterialFeatures{}) == PixelShaderPermutation::Full);
+    CHECK(SelectPixelShaderPermutation(MaterialFeatures{true, true, true}) == PixelShaderPermutation::Full);
+    CHECK(SelectPixelShaderPermutation(MaterialFeatures{false, true, true}) == PixelShaderPermutation::Flat);
+    CHECK(SelectPixelShaderPermutation(MaterialFeatures{true, true, false}) == PixelShaderPermutation::NoImageBasedLighting);
+
+    // There is no flat variant without image-based lighting, so untextured materials sample their neutral textures.
+    CHECK(SelectPixelShaderPermutation(MaterialFeatures{false, true, false}) == PixelShaderPermutation::NoImageBasedLighting);
+
+    // Unlit materials ignore the lighting features and their textures.
+    for (const bool textured : {false, true}) {
+        for (const bool imageBasedLighting : {false, true}) {
+            CHECK(SelectPixelShaderPermutation(MaterialFeatures{textured, false, imageBasedLighting}) == PixelShaderPermutation::Unlit);
+        }
+    }
+    static_assert(SelectPixelShaderPermutation(MaterialFeatures{false, false, false}) == PixelShaderPermutation::Unlit);
+}
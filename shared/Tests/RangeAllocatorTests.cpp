@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <pbr/PbrRangeAllocator.h>
+
+using namespace Pbr;
+
+TEST_CASE(RangeAllocator_AllocatesFromTheStart) {
+    RangeAllocator allocator(100);
+    CHECK(allocator.IsEmpty());
+    CHECK_EQUAL(0u, allocator.Allocate(10).value());
+    CHECK_EQUAL(10u, allocator.Allocate(30).value());
+    CHECK_EQUAL(40u, allocator.Allocate(60).value());
+    CHECK(!allocator.Allocate(1).has_value());
+
+    const RangeAllocatorStats stats = allocator.GetStats();
+    CHECK_EQUAL(100u, stats.Size);
+    CHECK_EQUAL(100u, stats.UsedSize);
+    CHECK_EQUAL(0u, stats.FreeRangeCount);
+    CHECK_EQUAL(0.0f, stats.Fragmentation());
+}
+
+TEST_CASE(RangeAllocator_FreeMergesAdjacentRanges) {
+    RangeAllocator allocator(100);
+    const uint32_t a = allocator.Allocate(20).value();
+    const uint32_t b = allocator.Allocate(20).value();
+    const uint32_t c = allocator.Allocate(20).value();
+    (void)allocator.Allocate(40);
+
+    // Freeing a and c leaves two ranges; freeing b between them merges all three.
+    allocator.Free(a, 20);
+    allocator.Free(c, 20);
+    CHECK_EQUAL(2u, allocator.GetStats().FreeRangeCount);
+    CHECK_EQUAL(20u, allocator.GetStats().LargestFreeRange);
+    CHECK_NEAR(0.5f, allocator.GetStats().Fragmentation(), 1e-6f);
+
+    allocator.Free(b, 20);
+    CHECK_EQUAL(1u, allocator.GetStats().FreeRangeCount);
+    CHECK_EQUAL(60u, allocator.GetStats().LargestFreeRange);
+    CHECK_EQUAL(0.0f, allocator.GetStats().Fragmentation());
+    CHECK_EQUAL(0u, allocator.Allocate(60).value());
+}
+
+TEST_CASE(RangeAllocator_MergesWithTheEndOfTheBlock) {
+    RangeAllocator allocator(100);
+    const uint32_t a = allocator.Allocate(50).value();
+    const uint32_t b = allocator.Allocate(30).value(); // [80, 100) stays free.
+    allocator.Free(b, 30);
+    CHECK_EQUAL(1u, allocator.GetStats().FreeRangeCount);
+    allocator.Free(a, 50);
+    CHECK(allocator.IsEmpty());
+    CHECK_EQUAL(100u, allocator.GetStats().LargestFreeRange);
+}
+
+TEST_CASE(RangeAllocator_BestFit) {
+    RangeAllocator allocator(100);
+    const uint32_t large = allocator.Allocate(30).value();
+    (void)allocator.Allocate(5);
+    const uint32_t small = allocator.Allocate(10).value();
+    (void)allocator.Allocate(5);
+    allocator.Free(large, 30); // Free: [0, 30), [35, 45) and [50, 100).
+    allocator.Free(small, 10);
+
+    // The smallest free range that fits is used, keeping the larger ones for larger allocations.
+    CHECK_EQUAL(35u, allocator.Allocate(8).value());
+    CHECK_EQUAL(0u, allocator.Allocate(25).value());
+    CHECK_EQUAL(50u, allocator.Allocate(40).value());
+    CHECK_EQUAL(43u, allocator.Allocate(2).value());
+    CHECK_EQUAL(25u, allocator.Allocate(5).value());
+    CHECK_EQUAL(90u, allocator.Allocate(10).value());
+    CHECK(!allocator.Allocate(1).has_value());
+}
+
+TEST_CASE(RangeAllocator_RejectsInvalidRanges) {
+    RangeAllocator allocator(100);
+    CHECK_THROWS(allocator.Allocate(0), std::out_of_range);
+
+    const uint32_t a = allocator.Allocate(20).value();
+    (void)allocator.Allocate(20);
+    CHECK_THROWS(allocator.Free(a, 0), std::out_of_range);
+    CHECK_THROWS(allocator.Free(90, 20), std::out_of_range); // Past the end.
+    CHECK_THROWS(allocator.Free(50, 10), std::out_of_range); // Never allocated.
+
+    // Double free, and ranges overlapping a free range on either side.
+    allocator.Free(a, 20);
+    CHECK_THROWS(allocator.Free(a, 20), std::out_of_range);
+    CHECK_THROWS(allocator.Free(10, 20), std::out_of_range);
+    CHECK_THROWS(allocator.Free(30, 20), std::out_of_range);
+    CHECK_EQUAL(20u, allocator.GetStats().UsedSize);
+}
+
+TEST_CASE(RangeAllocator_RandomAllocationsStayConsistent) {
+    // Allocate and free at random, checking that live ranges never overlap and that freeing everything restores one range.
+    constexpr uint32_t Size = 4096;
+    RangeAllocator allocator(Size);
+    std::vector<std::pair<uint32_t, uint32_t>> live; // Offset and count.
+    std::vector<bool> used(Size, false);
+    std::minstd_rand random(3);
+    for (int step = 0; step < 5000; step++) {
+        if (live.empty() || random() % 3 != 0) {
+            const uint32_t count = 1 + random() % 64;
+            if (const std::optional<uint32_t> offset = allocator.Allocate(count)) {
+                for (uint32_t i = *offset; i < *offset + count; i++) {
+                    CHECK(!used[i]);
+                    used[i] = true;
+                }
+                live.emplace_back(*offset, count);
+            }
+        } else {
+            const size_t index = random() % live.size();
+            const auto [offset, count] = live[index];
+            allocator.Free(offset, count);
+            std::fill(used.begin() + offset, used.begin() + offset + count, false);
+            live.erase(live.begin() + index);
+        }
+        CHECK_EQUAL((uint32_t)std::count(used.begin(), used.end(), true), allocator.GetStats().UsedSize);
+    }
+
+    for (const auto& [offset, count] : live) {
+        allocator.Free(offset, count);
+    }
+    CHECK(allocator.IsEmpty());
+    CHECK_EQUAL(1u, allocator.GetStats().FreeRangeCount);
+    CHECK_EQUAL(Size, allocator.GetStats().LargestFreeRange);
+}
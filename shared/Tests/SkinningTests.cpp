@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#define TINYGLTF_USE_RAPIDJSON
+#define TINYGLTF_USE_RAPIDJSON_CRTALLOCATOR
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+#include <tiny_gltf.h>
+#include <pbr/GltfLoader.h>
+#include <pbr/PbrModel.h>
+#include <pbr/PbrResources.h>
+#include "D3D11TestDevice.h"
+
+using namespace DirectX;
+
+namespace {
+    constexpr uint32_t TargetSize = 64;
+    constexpr float ViewExtent = 2; // The orthographic view covers [-2, 2] in x and y.
+
+    // Append the values to the only buffer of the model, and add a buffer view and an accessor of them.
+    template <typename T>
+    int AddAccessor(tinygltf::Model& gltfModel, const std::vector<T>& values, int type, int componentType, int componentsPerValue) {
+        std::vector<unsigned char>& data = gltfModel.buffers[0].data;
+        tinygltf::BufferView bufferView;
+        bufferView.buffer = 0;
+        bufferView.byteOffset = data.size();
+        bufferView.byteLength = values.size() * sizeof(T);
+        data.insert(data.end(), (const unsigned char*)values.data(), (const unsigned char*)(values.data() + values.size()));
+        gltfModel.bufferViews.push_back(bufferView);
+
+        tinygltf::Accessor accessor;
+        accessor.bufferView = (int)gltfModel.bufferViews.size() - 1;
+        accessor.type = type;
+        accessor.componentType = componentType;
+        accessor.count = values.size() / componentsPerValue;
+        gltfModel.accessors.push_back(accessor);
+        return (int)gltfModel.accessors.size() - 1;
+    }
+
+    const std::vector<XMFLOAT3> BindPositions = {{0.75f, -0.25f, 0}, {1.25f, -0.25f, 0}, {1.0f, 0.25f, 0}};
+    const XMFLOAT4 Weights = {0.25f, 0.75f, 0, 0};
+
+    // A triangle skinned to two joints, JointA at the origin and its child JointB at (1, 0, 0). Every vertex follows JointA by a
+    // quarter and JointB by three quarters.
+    tinygltf::Model CreateSkinnedTriangle() {
+        tinygltf::Model gltfModel;
+        gltfModel.buffers.resize(1);
+
+        tinygltf::Primitive primitive;
+        std::vector<float> positions;
+        for (const XMFLOAT3& position : BindPositions) {
+            positions.insert(positions.end(), {position.x, position.y, position.z});
+        }
+        primitive.attributes["POSITION"] = AddAccessor(gltfModel, positions, TINYGLTF_TYPE_VEC3, TINYGLTF_COMPONENT_TYPE_FLOAT, 3);
+        const std::vector<uint16_t> joints = {0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0};
+        primitive.attributes["JOINTS_0"] = AddAccessor(gltfModel, joints, TINYGLTF_TYPE_VEC4, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, 4);
+        std::vector<float> weights;
+        for (size_t i = 0; i < BindPositions.size(); i++) {
+            weights.insert(weights.end(), {Weights.x, Weights.y, Weights.z, Weights.w});
+        }
+        primitive.attributes["WEIGHTS_0"] = AddAccessor(gltfModel, weights, TINYGLTF_TYPE_VEC4, TINYGLTF_COMPONENT_TYPE_FLOAT, 4);
+        primitive.mode = TINYGLTF_MODE_TRIANGLES;
+        gltfModel.meshes.resize(1);
+        gltfModel.meshes[0].primitives.push_back(primitive);
+
+        // The inverse bind matrices undo the bind pose of the joints: identity for JointA, and a translation by -1 for JointB.
+        std::vector<float> inverseBindMatrices(32, 0.0f);
+        for (size_t i = 0; i < 4; i++) {
+            inverseBindMatrices[i * 5] = 1;
+            inverseBindMatrices[16 + i * 5] = 1;
+        }
+        inverseBindMatrices[16 + 12] = -1;
+        tinygltf::Skin skin;
+        skin.joints = {1, 2};
+        skin.inverseBindMatrices = AddAccessor(gltfModel, inverseBindMatrices, TINYGLTF_TYPE_MAT4, TINYGLTF_COMPONENT_TYPE_FLOAT, 16);
+        gltfModel.skins.push_back(skin);
+
+        gltfModel.nodes.resize(3);
+        gltfModel.nodes[0].name = "Mesh";
+        gltfModel.nodes[0].mesh = 0;
+        gltfModel.nodes[0].skin = 0;
+        gltfModel.nodes[1].name = "JointA";
+        gltfModel.nodes[1].children = {2};
+        gltfModel.nodes[2].name = "JointB";
+        gltfModel.nodes[2].translation = {1, 0, 0};
+
+        gltfModel.scenes.resize(1);
+        gltfModel.scenes[0].nodes = {0, 1};
+        return gltfModel;
+    }
+
+    // Render the model in an orthographic view looking down -Z, and read back the red channel of the target.
+    std::vector<uint8_t> RenderRed(const Test::D3D11Device& device, Pbr::Resources& pbrResources, const Pbr::Model& model) {
+        ID3D11DeviceContext* context = device.Context.get();
+        const Test::RenderTarget target = Test::CreateRenderTarget(device.Device.get(), TargetSize);
+        target.ClearAndBind(context);
+        pbrResources.SetViewProjection(XMMatrixIdentity(),
+                                       XMMatrixOrthographicOffCenterRH(-ViewExtent, ViewExtent, -ViewExtent, ViewExtent, -1, 1));
+        pbrResources.Bind(context);
+        pbrResources.SetModelToWorld(XMMatrixIdentity(), context);
+        model.Render(pbrResources, context);
+
+        const std::vector<uint32_t> pixels = target.ReadPixels(context);
+        std::vector<uint8_t> red(pixels.size());
+        std::transform(pixels.begin(), pixels.end(), red.begin(), [](uint32_t pixel) { return (uint8_t)pixel; });
+        return red;
+    }
+
+    // Whether the pixel containing a point of the view is red.
+    bool IsCovered(const std::vector<uint8_t>& red, FXMVECTOR point) {
+        const uint32_t x = (uint32_t)((XMVectorGetX(point) + ViewExtent) / (2 * ViewExtent) * TargetSize);
+        const uint32_t y = (uint32_t)((ViewExtent - XMVectorGetY(point)) / (2 * ViewExtent) * TargetSize);
+        return red[y * TargetSize + x] > 128;
+    }
+} // namespace
+
+TEST_CASE(Skinning_JointMatricesMatchCpuSkinning) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    Pbr::Resources pbrResources(device.Device.get());
+    const std::shared_ptr<Pbr::Model> model = Gltf::FromGltfObject(pbrResources, CreateSkinnedTriangle());
+    CHECK_EQUAL(2u, model->GetJointCount());
+    CHECK_EQUAL(1u, model->GetPrimitiveCount());
+    CHECK(model->GetPrimitive(0).GetVertexFormat() == Pbr::VertexFormat::Skinned);
+
+    // Draw the triangle unlit and double-sided in red, so that coverage doesn't depend on lighting or winding.
+    std::shared_ptr<Pbr::Material> material = Pbr::Material::CreateFlat(pbrResources, Pbr::RGBAColor{1, 0, 0, 1});
+    material->SetUnlit(true);
+    material->SetDoubleSided(true);
+    model->GetPrimitive(0).GetMaterial() = material;
+
+    // In the bind pose, every joint matrix is identity and the triangle stays where it is.
+    std::vector<uint8_t> red = RenderRed(device, pbrResources, *model);
+    for (const XMFLOAT4X4& jointMatrix : model->GetJointMatrices()) {
+        for (uint32_t i = 0; i < 16; i++) {
+            CHECK_NEAR(i % 5 == 0 ? 1.0f : 0.0f, (&jointMatrix._11)[i], 1e-5f);
+        }
+    }
+    XMVECTOR bindCentroid = XMVectorZero();
+    for (const XMFLOAT3& position : BindPositions) {
+        bindCentroid = XMVectorAdd(bindCentroid, XMVectorScale(XMLoadFloat3(&position), 1.0f / BindPositions.size()));
+    }
+    CHECK(IsCovered(red, bindCentroid));
+
+    // Rotate JointA by 90 degrees, and JointB back by 90 degrees, which leaves JointB unrotated at (0, 1, 0).
+    const Pbr::NodeIndex_t jointA = model->FindFirstNode("JointA").value();
+    const Pbr::NodeIndex_t jointB = model->FindFirstNode("JointB").value();
+    const XMMATRIX jointALocal = XMMatrixRotationZ(XM_PIDIV2);
+    const XMMATRIX jointBLocal = XMMatrixMultiply(XMMatrixRotationZ(-XM_PIDIV2), XMMatrixTranslation(1, 0, 0));
+    model->GetNode(jointA).SetTransform(jointALocal);
+    model->GetNode(jointB).SetTransform(jointBLocal);
+    red = RenderRed(device, pbrResources, *model);
+
+    // The joint matrices take the bind pose into the posed joints. They are transposed for the shader.
+    const XMMATRIX expectedJoints[] = {jointALocal,
+                                       XMMatrixMultiply(XMMatrixTranslation(-1, 0, 0), XMMatrixMultiply(jointBLocal, jointALocal))};
+    CHECK_EQUAL(size_t{2}, model->GetJointMatrices().size());
+    for (uint32_t joint = 0; joint < 2; joint++) {
+        XMFLOAT4X4 expected;
+        XMStoreFloat4x4(&expected, XMMatrixTranspose(expectedJoints[joint]));
+        const XMFLOAT4X4& actual = model->GetJointMatrices()[joint];
+        for (uint32_t i = 0; i < 16; i++) {
+            CHECK_NEAR((&expected._11)[i], (&actual._11)[i], 1e-5f);
+        }
+    }
+
+    // Skin the vertices on the CPU: the pixel at the centroid of the skinned triangle is drawn, and the one at the bind pose
+    // centroid no longer is.
+    XMVECTOR skinnedCentroid = XMVectorZero();
+    for (const XMFLOAT3& position : BindPositions) {
+        const XMVECTOR bindPosition = XMLoadFloat3(&position);
+        const XMVECTOR skinnedPosition = XMVectorAdd(XMVectorScale(XMVector3Transform(bindPosition, expectedJoints[0]), Weights.x),
+                                                     XMVectorScale(XMVector3Transform(bindPosition, expectedJoints[1]), Weights.y));
+        skinnedCentroid = XMVectorAdd(skinnedCentroid, XMVectorScale(skinnedPosition, 1.0f / BindPositions.size()));
+    }
+    CHECK_NEAR(0.0208f, XMVectorGetX(skinnedCentroid), 1e-3f);
+    CHECK_NEAR(0.9375f, XMVectorGetY(skinnedCentroid), 1e-3f);
+    CHECK(IsCovered(red, skinnedCentroid));
+    CHECK(!IsCovered(red, bindCentroid));
+}
@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <functional>
+#include <pbr/PbrMaterial.h>
+#include <pbr/PbrModel.h>
+#include <pbr/PbrResources.h>
+#include <pbr/PbrStaticBatch.h>
+#include "D3D11TestDevice.h"
+
+using namespace DirectX;
+
+namespace {
+    constexpr uint32_t ObjectCount = 1000;
+    constexpr uint32_t MaterialCount = 8;
+
+    XMMATRIX RandomPlacement(std::minstd_rand& random) {
+        std::uniform_real_distribution<float> position(-5.0f, 5.0f);
+        std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+        return XMMatrixRotationRollPitchYaw(angle(random), angle(random), angle(random)) *
+               XMMatrixTranslation(position(random), position(random), position(random));
+    }
+
+    void ReportSubmitTime(const std::string& name,
+                          Pbr::Resources& pbrResources,
+                          ID3D11DeviceContext* context,
+                          const std::function<void()>& render) {
+        Test::ReportMetric(name, Test::MeasureMicroseconds([&] {
+                               pbrResources.Bind(context);
+                               pbrResources.SetModelToWorld(XMMatrixIdentity(), context);
+                               render();
+                               context->Flush();
+                           }),
+                           "us/frame");
+    }
+} // namespace
+
+// 1000 static objects with 8 materials, drawn as one primitive per object or through a static batch.
+BENCHMARK(StaticBatch_DrawCount) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    Pbr::Resources pbrResources(device.Device.get());
+
+    std::vector<std::shared_ptr<Pbr::Material>> materials;
+    for (uint32_t i = 0; i < MaterialCount; i++) {
+        const float shade = (float)(i + 1) / MaterialCount;
+        materials.push_back(Pbr::Material::CreateFlat(pbrResources, Pbr::RGBAColor{shade, shade, shade, 1}));
+    }
+
+    std::minstd_rand random(28);
+    Pbr::Model unbatched;
+    Pbr::StaticBatch batch;
+    for (uint32_t i = 0; i < ObjectCount; i++) {
+        const XMMATRIX placement = RandomPlacement(random);
+        const std::shared_ptr<Pbr::Material>& material = materials[i % MaterialCount];
+
+        const Pbr::NodeIndex_t node = unbatched.AddNode(placement, Pbr::RootNodeIndex);
+        unbatched.AddPrimitive(Pbr::Primitive(pbrResources, Pbr::PrimitiveBuilder().AddCube(0.1f, node), material));
+        batch.Add(Pbr::PrimitiveBuilder().AddCube(0.1f), material, placement);
+    }
+
+    ID3D11DeviceContext* context = device.Context.get();
+    ReportSubmitTime("One primitive per object", pbrResources, context, [&] { unbatched.Render(pbrResources, context); });
+    ReportSubmitTime("Static batch", pbrResources, context, [&] { batch.Render(pbrResources, context); });
+
+    Test::ReportMetric("Draws, one primitive per object", unbatched.GetPrimitiveCount(), "draws");
+    Test::ReportMetric("Draws, static batch", batch.GetDrawCount(), "draws");
+    CHECK_EQUAL(MaterialCount, batch.GetDrawCount());
+
+    // Moving one object rebuilds the merged buffers of its material on the next render.
+    Pbr::StaticBatch::EntryId movedEntry = 0;
+    Test::ReportMetric("Static batch rebuild after moving one object",
+                       Test::MeasureMicroseconds([&] {
+                           batch.Remove(movedEntry);
+                           movedEntry = batch.Add(Pbr::PrimitiveBuilder().AddCube(0.1f), materials[0], RandomPlacement(random));
+                           batch.Render(pbrResources, context);
+                           context->Flush();
+                       }),
+                       "us");
+    Test::ReportMetric("Materials rebuilt after moving one object", batch.GetLastRebuildGroupCount(), "materials");
+    CHECK_EQUAL(1u, batch.GetLastRebuildGroupCount());
+    CHECK_EQUAL(ObjectCount, batch.GetEntryCount());
+}
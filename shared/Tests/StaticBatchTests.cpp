@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <pbr/PbrMaterial.h>
+#include <pbr/PbrResources.h>
+#include <pbr/PbrStaticBatch.h>
+#include "D3D11TestDevice.h"
+
+using namespace DirectX;
+
+namespace {
+    void RenderBatch(Pbr::StaticBatch& batch, Pbr::Resources& pbrResources, ID3D11DeviceContext* context) {
+        pbrResources.Bind(context);
+        pbrResources.SetModelToWorld(XMMatrixIdentity(), context);
+        batch.Render(pbrResources, context);
+    }
+} // namespace
+
+TEST_CASE(StaticBatch_RebuildsOnlyTheChangedMaterials) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    ID3D11DeviceContext* context = device.Context.get();
+    Pbr::Resources pbrResources(device.Device.get());
+    const std::shared_ptr<Pbr::Material> red = Pbr::Material::CreateFlat(pbrResources, Pbr::RGBAColor{1, 0, 0, 1});
+    const std::shared_ptr<Pbr::Material> green = Pbr::Material::CreateFlat(pbrResources, Pbr::RGBAColor{0, 1, 0, 1});
+    const std::shared_ptr<Pbr::Material> blue = Pbr::Material::CreateFlat(pbrResources, Pbr::RGBAColor{0, 0, 1, 1});
+
+    Pbr::StaticBatch batch;
+    const Pbr::StaticBatch::EntryId red0 = batch.Add(Pbr::PrimitiveBuilder().AddCube(0.1f), red, XMMatrixTranslation(1, 0, 0));
+    const Pbr::StaticBatch::EntryId red1 = batch.Add(Pbr::PrimitiveBuilder().AddCube(0.1f), red, XMMatrixTranslation(2, 0, 0));
+    batch.Add(Pbr::PrimitiveBuilder().AddCube(0.1f), green, XMMatrixTranslation(3, 0, 0));
+    RenderBatch(batch, pbrResources, context);
+    CHECK_EQUAL(2u, batch.GetDrawCount());
+    CHECK_EQUAL(2u, batch.GetLastRebuildGroupCount());
+
+    // Removing an entry rebuilds only its material.
+    batch.Remove(red0);
+    RenderBatch(batch, pbrResources, context);
+    CHECK_EQUAL(2u, batch.GetDrawCount());
+    CHECK_EQUAL(1u, batch.GetLastRebuildGroupCount());
+
+    // Removing the last entry of a material drops its draw without rebuilding the others, and new materials add a draw.
+    batch.Remove(red1);
+    RenderBatch(batch, pbrResources, context);
+    CHECK_EQUAL(1u, batch.GetDrawCount());
+    CHECK_EQUAL(0u, batch.GetLastRebuildGroupCount());
+    batch.Add(Pbr::PrimitiveBuilder().AddCube(0.1f), blue, XMMatrixIdentity());
+    batch.Add(Pbr::PrimitiveBuilder(), red, XMMatrixIdentity()); // No indices, no draw.
+    RenderBatch(batch, pbrResources, context);
+    CHECK_EQUAL(2u, batch.GetDrawCount());
+    CHECK_EQUAL(1u, batch.GetLastRebuildGroupCount());
+    CHECK_EQUAL(3u, batch.GetEntryCount());
+
+    batch.Clear();
+    RenderBatch(batch, pbrResources, context);
+    CHECK_EQUAL(0u, batch.GetDrawCount());
+    CHECK_EQUAL(0u, batch.GetEntryCount());
+}
+
+TEST_CASE(StaticBatch_DrawPassesOfTheMaterials) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    Pbr::Resources pbrResources(device.Device.get());
+    const std::shared_ptr<Pbr::Material> opaque = Pbr::Material::CreateFlat(pbrResources, Pbr::RGBAColor{1, 1, 1, 1});
+    const std::shared_ptr<Pbr::Material> blended = Pbr::Material::CreateFlat(pbrResources, Pbr::RGBAColor{1, 1, 1, 0.5f});
+    blended->SetAlphaBlended(true);
+
+    Pbr::StaticBatch batch;
+    CHECK(!batch.GetDrawPasses().Any());
+
+    // Entries count before the next render rebuilds the merged buffers.
+    const Pbr::StaticBatch::EntryId blendedEntry = batch.Add(Pbr::PrimitiveBuilder().AddCube(0.1f), blended, XMMatrixIdentity());
+    batch.Add(Pbr::PrimitiveBuilder().AddCube(0.1f), opaque, XMMatrixIdentity());
+    CHECK(batch.GetDrawPasses().Opaque);
+    CHECK(batch.GetDrawPasses().Blended);
+
+    batch.Remove(blendedEntry);
+    CHECK(!batch.GetDrawPasses().Blended);
+    opaque->Hidden = true;
+    CHECK(!batch.GetDrawPasses().Any());
+}
@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <pbr/PbrPrimitive.h>
+#include <pbr/PbrResources.h>
+#include <pbr/PbrStreamingBuffer.h>
+#include "D3D11TestDevice.h"
+
+namespace {
+    std::vector<uint8_t> CreateData(UINT byteSize, uint8_t seed) {
+        std::vector<uint8_t> data(byteSize);
+        for (UINT i = 0; i < byteSize; i++) {
+            data[i] = (uint8_t)(seed + i * 7);
+        }
+        return data;
+    }
+
+    // Copy the bytes of the buffer at the offset back through a staging buffer.
+    std::vector<uint8_t> ReadBack(const Test::D3D11Device& device, const Pbr::StreamingBuffer& buffer, UINT offset, UINT byteSize) {
+        const CD3D11_BUFFER_DESC desc(buffer.GetCapacity(), 0, D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ);
+        winrt::com_ptr<ID3D11Buffer> staging;
+        CHECK(SUCCEEDED(device.Device->CreateBuffer(&desc, nullptr, staging.put())));
+        device.Context->CopyResource(staging.get(), buffer.Get());
+
+        D3D11_MAPPED_SUBRESOURCE mapped{};
+        CHECK(SUCCEEDED(device.Context->Map(staging.get(), 0, D3D11_MAP_READ, 0, &mapped)));
+        const uint8_t* bytes = static_cast<const uint8_t*>(mapped.pData) + offset;
+        std::vector<uint8_t> data(bytes, bytes + byteSize);
+        device.Context->Unmap(staging.get(), 0);
+        return data;
+    }
+} // namespace
+
+TEST_CASE(StreamingBuffer_AppendsThenWrapsWithDiscard) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    Pbr::StreamingBuffer buffer(D3D11_BIND_VERTEX_BUFFER);
+
+    // The first write creates the buffer with the data, without a context.
+    constexpr UINT ByteSize = 1000;
+    CHECK_EQUAL(0u, buffer.Write(device.Device.get(), nullptr, CreateData(ByteSize, 0).data(), ByteSize, 16));
+    CHECK_EQUAL(4096u, buffer.GetCapacity());
+    CHECK_EQUAL(1u, buffer.GetStats().Reallocations);
+
+    // Writes are appended at aligned offsets with Map(NO_OVERWRITE), leaving the earlier data in place.
+    const UINT expectedOffsets[] = {1008, 2016, 3024};
+    for (uint8_t i = 0; i < std::size(expectedOffsets); i++) {
+        const std::vector<uint8_t> data = CreateData(ByteSize, (uint8_t)(i + 1));
+        const UINT offset = buffer.Write(device.Device.get(), device.Context.get(), data.data(), ByteSize, 16);
+        CHECK_EQUAL(expectedOffsets[i], offset);
+        CHECK(ReadBack(device, buffer, offset, ByteSize) == data);
+    }
+    CHECK(ReadBack(device, buffer, 0, ByteSize) == CreateData(ByteSize, 0));
+    CHECK(ReadBack(device, buffer, expectedOffsets[0], ByteSize) == CreateData(ByteSize, 1));
+    CHECK_EQUAL(0u, buffer.GetStats().Discards);
+
+    // The next write doesn't fit behind the last one, so it wraps to the start with Map(DISCARD), in the same buffer.
+    ID3D11Buffer* const d3dBuffer = buffer.Get();
+    const std::vector<uint8_t> wrapped = CreateData(ByteSize, 9);
+    CHECK_EQUAL(0u, buffer.Write(device.Device.get(), device.Context.get(), wrapped.data(), ByteSize, 16));
+    CHECK(ReadBack(device, buffer, 0, ByteSize) == wrapped);
+    CHECK(buffer.Get() == d3dBuffer);
+    CHECK_EQUAL(1u, buffer.GetStats().Discards);
+    CHECK_EQUAL(1u, buffer.GetStats().Reallocations);
+    CHECK_EQUAL(uint64_t{5 * ByteSize}, buffer.GetStats().UploadBytes);
+
+    // Writes continue behind the wrapped one.
+    CHECK_EQUAL(1008u, buffer.Write(device.Device.get(), device.Context.get(), wrapped.data(), ByteSize, 16));
+}
+
+TEST_CASE(StreamingBuffer_GrowsWhenTwoWritesDontFit) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    Pbr::StreamingBuffer buffer(D3D11_BIND_INDEX_BUFFER);
+    buffer.Write(device.Device.get(), nullptr, CreateData(1000, 0).data(), 1000, 4);
+    buffer.Write(device.Device.get(), device.Context.get(), CreateData(1000, 1).data(), 1000, 4);
+    CHECK_EQUAL(4096u, buffer.GetCapacity());
+
+    // Two writes of 3000 bytes don't fit in 4096 bytes, so a larger buffer is created with the data, with headroom for growth.
+    const std::vector<uint8_t> data = CreateData(3000, 2);
+    CHECK_EQUAL(0u, buffer.Write(device.Device.get(), device.Context.get(), data.data(), 3000, 4));
+    CHECK_EQUAL(8192u, buffer.GetCapacity());
+    CHECK_EQUAL(2u, buffer.GetStats().Reallocations);
+    CHECK_EQUAL(0u, buffer.GetStats().Discards);
+    CHECK(ReadBack(device, buffer, 0, 3000) == data);
+
+    // The next write of the same size is appended to the new buffer.
+    CHECK_EQUAL(3000u, buffer.Write(device.Device.get(), device.Context.get(), data.data(), 3000, 4));
+    CHECK_EQUAL(2u, buffer.GetStats().Reallocations);
+
+    // Resetting the stats starts counting again, e.g. for the next frame, and keeps the buffer.
+    buffer.ResetStats();
+    CHECK_EQUAL(uint64_t{0}, buffer.GetStats().UploadBytes);
+    CHECK_EQUAL(0u, buffer.GetStats().Reallocations);
+    CHECK_EQUAL(8192u, buffer.GetCapacity());
+    buffer.Write(device.Device.get(), device.Context.get(), data.data(), 3000, 4);
+    CHECK_EQUAL(uint64_t{3000}, buffer.GetStats().UploadBytes);
+    CHECK_EQUAL(1u, buffer.GetStats().Discards);
+}
+
+TEST_CASE(StreamingBuffer_PrimitiveStatsPerFrame) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    Pbr::Resources pbrResources(device.Device.get());
+    Pbr::PrimitiveBuilder builder;
+    builder.AddSphere(1, 8);
+    Pbr::Primitive primitive(pbrResources, builder, Pbr::Material::CreateFlat(pbrResources, Pbr::RGBA::White), true);
+    CHECK_EQUAL(1u, primitive.GetStreamingStats().UpdateCount);
+
+    // Each frame, moving vertices only upload their positions, normals and tangents. After a reset, the stats only count the
+    // frames since.
+    primitive.ResetStreamingStats();
+    CHECK_EQUAL(0u, primitive.GetStreamingStats().UpdateCount);
+    CHECK_EQUAL(uint64_t{0}, primitive.GetStreamingStats().Buffers.UploadBytes);
+    for (Pbr::Vertex& vertex : builder.Vertices) {
+        vertex.Position.x += 1;
+    }
+    primitive.UpdateBuffers(device.Device.get(), device.Context.get(), builder);
+    const Pbr::StreamingGeometryStats stats = primitive.GetStreamingStats();
+    CHECK_EQUAL(1u, stats.UpdateCount);
+    CHECK_EQUAL(stats.LastUpdateUploadBytes, stats.Buffers.UploadBytes);
+    CHECK(stats.Buffers.UploadBytes < builder.Vertices.size() * sizeof(Pbr::Vertex));
+    CHECK_EQUAL(0u, stats.Buffers.Reallocations);
+}
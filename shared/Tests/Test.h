@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// A minimal test and benchmark runner for the shared libraries. Test cases check results with CHECK macros and keep
+// running after a failed check. Benchmarks time a workload and report their results. Both register themselves at static
+// initialization and are run by Main.cpp. Cases that need D3D11 run on the WARP device of D3D11TestDevice.h. The cases of
+// the graphics-free sources also build with CMakeLists.txt, on platforms without Direct3D.
+//
+
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace Test {
+    using Function = void (*)();
+
+    struct Registration {
+        Registration(const char* name, Function function, bool benchmark);
+    };
+
+    void ReportFailure(const char* file, int line, const std::string& message);
+
+    // Print a named benchmark result.
+    void ReportMetric(const std::string& name, double value, const char* unit);
+
+    // The average duration of one call of the function in microseconds, over at least minIterations calls and at least
+    // minDuration of total time, after one warm up call.
+    template <typename TFunction>
+    double MeasureMicroseconds(TFunction&& function,
+                               uint32_t minIterations = 10,
+                               std::chrono::duration<double> minDuration = std::chrono::milliseconds(200)) {
+        using clock = std::chrono::steady_clock;
+        function();
+
+        uint32_t iterations = 0;
+        const clock::time_point start = clock::now();
+        clock::duration elapsed{};
+        do {
+            function();
+            iterations++;
+            elapsed = clock::now() - start;
+        } while (iterations < minIterations || elapsed < minDuration);
+
+        return std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+    }
+
+    // Keep the optimizer from removing a computation whose result is otherwise unused.
+    void DoNotOptimize(const void* value);
+
+    template <typename T>
+    std::string ToString(const T& value) {
+        std::ostringstream stream;
+        stream << value;
+        return stream.str();
+    }
+} // namespace Test
+
+#define TEST_CASE(name)                                                                    \
+    static void name();                                                                    \
+    static const Test::Registration name##Registration(#name, &name, false /*benchmark*/); \
+    static void name()
+
+#define BENCHMARK(name)                                                                   \
+    static void name();                                                                   \
+    static const Test::Registration name##Registration(#name, &name, true /*benchmark*/); \
+    static void name()
+
+#define CHECK(expression)                                         \
+    do {                                                          \
+        if (!(expression)) {                                      \
+            Test::ReportFailure(__FILE__, __LINE__, #expression); \
+        }                                                         \
+    } while (false)
+
+#define CHECK_EQUAL(expected, actual)                                                                       \
+    do {                                                                                                    \
+        const auto expectedValue = (expected);                                                              \
+        const auto actualValue = (actual);                                                                  \
+        if (!(expectedValue == actualValue)) {                                                              \
+            Test::ReportFailure(__FILE__,                                                                   \
+                                __LINE__,                                                                   \
+                                std::string(#actual " is ") + Test::ToString(actualValue) + ", expected " + \
+                                    Test::ToString(expectedValue));                                         \
+        }                                                                                                   \
+    } while (false)
+
+#define CHECK_NEAR(expected, actual, tolerance)                                                                     \
+    do {                                                                                                            \
+        const double expectedValue = (double)(expected);                                                            \
+        const double actualValue = (double)(actual);                                                                \
+        if (!(std::abs(expectedValue - actualValue) <= (double)(tolerance))) {                                      \
+            Test::ReportFailure(__FILE__,                                                                           \
+                                __LINE__,                                                                           \
+                                std::string(#actual " is ") + Test::ToString(actualValue) + ", expected " +         \
+                                    Test::ToString(expectedValue) + " +/- " + Test::ToString((double)(tolerance))); \
+        }                                                                                                           \
+    } while (false)
+
+#define CHECK_THROWS(expression, exceptionType)                                                                 \
+    do {                                                                                                        \
+        bool thrown = false;                                                                                    \
+        try {                                                                                                   \
+            (void)(expression);                                                                                 \
+        } catch (const exceptionType&) {                                                                        \
+            thrown = true;                                                                                      \
+        }                                                                                                       \
+        if (!thrown) {                                                                                          \
+            Test::ReportFailure(__FILE__, __LINE__, std::string(#expression " did not throw " #exceptionType)); \
+        }                                                                                                       \
+    } while (false)
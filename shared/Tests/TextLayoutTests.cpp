@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <XrSceneLib/TextLayout.h>
+
+namespace {
+    // A monospaced font: 10 pixel advances with 8x12 bitmaps, and 5 pixel spaces without a bitmap. Lines are 16 pixels high.
+    const FontMetrics Font{10, 4, 2};
+    const GlyphMetrics Letter{10, 1, -10, AtlasRect{0, 0, 8, 12}};
+    const GlyphMetrics Space{5, 0, 0, AtlasRect{0, 0, 0, 0}};
+
+    const GlyphMetrics& GetGlyph(char32_t codepoint) {
+        return codepoint == U' ' ? Space : Letter;
+    }
+
+    TextLayoutResult Layout(std::u32string_view text, const TextLayoutOptions& options = {}) {
+        return LayoutText(text, Font, GetGlyph, options);
+    }
+
+    TextLayoutOptions Box(float width, float height, TextAlignment horizontal, ParagraphAlignment vertical) {
+        TextLayoutOptions options;
+        options.Width = width;
+        options.Height = height;
+        options.HorizontalAlignment = horizontal;
+        options.VerticalAlignment = vertical;
+        return options;
+    }
+
+    TextCluster Cluster(const wchar_t* text, float left, float top) {
+        return TextCluster{text, TextRect{left, top, left + 10, top + 16}};
+    }
+} // namespace
+
+TEST_CASE(TextLayout_SingleLineIsSizedToTheText) {
+    const TextLayoutResult layout = Layout(U"abc");
+    CHECK_EQUAL(1u, layout.LineCount);
+    CHECK_EQUAL(30.0f, layout.Width);
+    CHECK_EQUAL(14.0f, layout.Height); // Ascent and descent, without the line gap.
+    CHECK_EQUAL(size_t{3}, layout.Glyphs.size());
+    for (size_t i = 0; i < layout.Glyphs.size(); i++) {
+        CHECK_EQUAL(static_cast<char32_t>(U'a' + i), layout.Glyphs[i].Codepoint);
+        CHECK_EQUAL(i * 10 + 1.0f, layout.Glyphs[i].X);
+        CHECK_EQUAL(0.0f, layout.Glyphs[i].Y); // Baseline at the ascent, bitmap top 10 pixels above it.
+    }
+}
+
+TEST_CASE(TextLayout_SpacesAdvanceWithoutGlyphs) {
+    const TextLayoutResult layout = Layout(U"a b  ");
+    CHECK_EQUAL(size_t{2}, layout.Glyphs.size());
+    CHECK_EQUAL(16.0f, layout.Glyphs[1].X);
+    CHECK_EQUAL(25.0f, layout.Width); // Trailing spaces don't count towards the line width.
+}
+
+TEST_CASE(TextLayout_NewlinesStartLines) {
+    const TextLayoutResult layout = Layout(U"ab\r\nc\n\nd");
+    CHECK_EQUAL(4u, layout.LineCount);
+    CHECK_EQUAL(20.0f, layout.Width);
+    CHECK_EQUAL(4 * 16.0f - 2, layout.Height);
+    CHECK_EQUAL(size_t{4}, layout.Glyphs.size());
+    CHECK_EQUAL(16.0f, layout.Glyphs[2].Y);
+    CHECK_EQUAL(48.0f, layout.Glyphs[3].Y);
+
+    // Lines are centered in the width of the widest line.
+    CHECK_EQUAL(6.0f, layout.Glyphs[2].X);
+}
+
+TEST_CASE(TextLayout_WrapsAtSpaces) {
+    const TextLayoutResult layout = Layout(U"aaa bbb cc", Box(80, 0, TextAlignment::Leading, ParagraphAlignment::Near));
+    CHECK_EQUAL(2u, layout.LineCount);
+    CHECK_EQUAL(80.0f, layout.Width);
+    CHECK_EQUAL(size_t{8}, layout.Glyphs.size());
+
+    // "aaa bbb " fits in 80 pixels, "cc" moves to the second line.
+    CHECK_EQUAL(0.0f, layout.Glyphs[5].Y);
+    CHECK_EQUAL(36.0f, layout.Glyphs[3].X);
+    CHECK_EQUAL(1.0f, layout.Glyphs[6].X);
+    CHECK_EQUAL(16.0f, layout.Glyphs[6].Y);
+}
+
+TEST_CASE(TextLayout_BreaksWordsLongerThanTheBox) {
+    const TextLayoutResult layout = Layout(U"aaaaaaa", Box(30, 0, TextAlignment::Leading, ParagraphAlignment::Near));
+    CHECK_EQUAL(3u, layout.LineCount);
+    CHECK_EQUAL(size_t{7}, layout.Glyphs.size());
+    const float expectedX[] = {1, 11, 21, 1, 11, 21, 1};
+    for (size_t i = 0; i < 7; i++) {
+        CHECK_EQUAL(expectedX[i], layout.Glyphs[i].X);
+        CHECK_EQUAL(i / 3 * 16.0f, layout.Glyphs[i].Y);
+    }
+}
+
+TEST_CASE(TextLayout_WordWrapCanBeDisabled) {
+    TextLayoutOptions options = Box(30, 0, TextAlignment::Leading, ParagraphAlignment::Near);
+    options.WordWrap = false;
+    const TextLayoutResult layout = Layout(U"aaa bbb", options);
+    CHECK_EQUAL(1u, layout.LineCount);
+    CHECK_EQUAL(56.0f, layout.Glyphs.back().X);
+}
+
+TEST_CASE(TextLayout_AlignsInTheBox) {
+    const struct {
+        TextAlignment Horizontal;
+        ParagraphAlignment Vertical;
+        float X;
+        float Y;
+    } cases[] = {
+        {TextAlignment::Leading, ParagraphAlignment::Near, 1, 0},
+        {TextAlignment::Center, ParagraphAlignment::Center, 41, 43},
+        {TextAlignment::Trailing, ParagraphAlignment::Far, 81, 86},
+    };
+    for (const auto& alignment : cases) {
+        const TextLayoutResult layout = Layout(U"ab", Box(100, 100, alignment.Horizontal, alignment.Vertical));
+        CHECK_EQUAL(100.0f, layout.Width);
+        CHECK_EQUAL(100.0f, layout.Height);
+        CHECK_EQUAL(alignment.X, layout.Glyphs[0].X);
+        CHECK_EQUAL(alignment.Y, layout.Glyphs[0].Y);
+    }
+}
+
+TEST_CASE(TextLayout_EmptyText) {
+    const TextLayoutResult layout = Layout(U"");
+    CHECK_EQUAL(1u, layout.LineCount);
+    CHECK_EQUAL(0.0f, layout.Width);
+    CHECK(layout.Glyphs.empty());
+}
+
+TEST_CASE(TextLayout_ToCodepoints) {
+    CHECK(ToCodepoints(L"abc") == U"abc");
+    if constexpr (sizeof(wchar_t) == 2) {
+        const wchar_t pair[] = {L'a', static_cast<wchar_t>(0xD83D), static_cast<wchar_t>(0xDE00), L'b', 0};
+        CHECK(ToCodepoints(pair) == std::u32string({U'a', 0x1F600, U'b'}));
+
+        const wchar_t unpaired[] = {static_cast<wchar_t>(0xDE00), static_cast<wchar_t>(0xD83D), L'b', static_cast<wchar_t>(0xD83D), 0};
+        CHECK(ToCodepoints(unpaired) == std::u32string({0xFFFD, 0xFFFD, U'b', 0xFFFD}));
+    }
+}
+
+TEST_CASE(TextLayout_DirtyRectsOfUnchangedLayoutsAreEmpty) {
+    const std::vector<TextCluster> clusters = {Cluster(L"a", 0, 0), Cluster(L"b", 10, 0)};
+    CHECK(ComputeDirtyRects(clusters, clusters, 2).empty());
+
+    // The order of the clusters doesn't matter.
+    const std::vector<TextCluster> reordered = {clusters[1], clusters[0]};
+    CHECK(ComputeDirtyRects(clusters, reordered, 2).empty());
+}
+
+TEST_CASE(TextLayout_DirtyRectsCoverChangedClusters) {
+    const std::vector<TextCluster> before = {Cluster(L"a", 0, 0), Cluster(L"b", 10, 0), Cluster(L"c", 0, 32)};
+    const std::vector<TextCluster> after = {Cluster(L"a", 0, 0), Cluster(L"x", 10, 0), Cluster(L"c", 0, 32)};
+    const std::vector<TextRect> rects = ComputeDirtyRects(before, after, 1);
+    CHECK_EQUAL(size_t{1}, rects.size());
+    CHECK_EQUAL(9.0f, rects[0].Left);
+    CHECK_EQUAL(-1.0f, rects[0].Top);
+    CHECK_EQUAL(21.0f, rects[0].Right);
+    CHECK_EQUAL(17.0f, rects[0].Bottom);
+}
+
+TEST_CASE(TextLayout_DirtyRectsMergePerLine) {
+    // Changes at both ends of the first line and on the third line.
+    const std::vector<TextCluster> before = {Cluster(L"a", 0, 0), Cluster(L"b", 10, 0), Cluster(L"c", 20, 0), Cluster(L"d", 0, 32)};
+    const std::vector<TextCluster> after = {Cluster(L"x", 0, 0), Cluster(L"b", 10, 0), Cluster(L"y", 20, 0), Cluster(L"z", 0, 32)};
+    const std::vector<TextRect> rects = ComputeDirtyRects(before, after, 0);
+    CHECK_EQUAL(size_t{2}, rects.size());
+    const auto firstLine = std::find_if(rects.begin(), rects.end(), [](const TextRect& rect) { return rect.Top == 0; });
+    CHECK(firstLine != rects.end());
+    CHECK_EQUAL(0.0f, firstLine->Left);
+    CHECK_EQUAL(30.0f, firstLine->Right);
+
+    // Inflating enough to reach the third line merges everything.
+    CHECK_EQUAL(size_t{1}, ComputeDirtyRects(before, after, 9).size());
+}
+
+BENCHMARK(TextLayout_Layout) {
+    const std::u32string label = U"Hologram placed 1.25 m away.";
+    std::u32string paragraph;
+    while (paragraph.size() < 2000) {
+        paragraph += U"The quick brown fox jumps over the lazy dog. ";
+    }
+
+    const TextLayoutOptions unbounded;
+    const TextLayoutOptions wrapped = Box(600, 0, TextAlignment::Leading, ParagraphAlignment::Near);
+    uint32_t lineCount = 0;
+    const double labelMicroseconds = Test::MeasureMicroseconds([&] { Test::DoNotOptimize(Layout(label, unbounded).Glyphs.data()); });
+    const double paragraphMicroseconds = Test::MeasureMicroseconds([&] { lineCount = Layout(paragraph, wrapped).LineCount; });
+
+    Test::ReportMetric("Label, 28 characters", labelMicroseconds, "us");
+    Test::ReportMetric("Paragraph, " + std::to_string(paragraph.size()) + " characters", paragraphMicroseconds, "us");
+    Test::ReportMetric("Paragraph lines", lineCount, "lines");
+}
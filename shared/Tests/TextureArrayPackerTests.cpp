@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <pbr/PbrTextureArrayPacker.h>
+
+using namespace Pbr;
+
+namespace {
+    constexpr TextureArrayFormat FormatA{256, 256, 9, 71};
+    constexpr TextureArrayFormat FormatB{512, 512, 10, 71};
+    constexpr TextureArrayFormat FormatC{256, 256, 9, 98};
+    constexpr TextureArrayFormat FormatD{128, 128, 8, 28};
+} // namespace
+
+TEST_CASE(TextureArrayPacker_FillsArraysOfAFormat) {
+    TextureArrayPacker packer(400, 256, UINT64_MAX); // 4 slices of 100 bytes per array.
+    for (uint32_t slice = 0; slice < 4; slice++) {
+        const TextureArrayPlacement placement = packer.Allocate(FormatA, 100);
+        CHECK_EQUAL(0u, placement.Array);
+        CHECK_EQUAL(slice, placement.Slice);
+        CHECK_EQUAL(slice == 0, placement.NewArray);
+    }
+    CHECK_EQUAL(4u, packer.GetSliceCount(0));
+
+    const TextureArrayPlacement next = packer.Allocate(FormatA, 100);
+    CHECK_EQUAL(1u, next.Array);
+    CHECK_EQUAL(0u, next.Slice);
+    CHECK(next.NewArray);
+
+    // Other formats never share an array.
+    const TextureArrayPlacement other = packer.Allocate(FormatC, 100);
+    CHECK_EQUAL(2u, other.Array);
+    CHECK(other.NewArray);
+
+    const TextureArrayStats stats = packer.GetStats();
+    CHECK_EQUAL(3u, stats.ArrayCount);
+    CHECK_EQUAL(12u, stats.SliceCount);
+    CHECK_EQUAL(6u, stats.UsedSliceCount);
+    CHECK_EQUAL(uint64_t{1200}, stats.ArrayBytes);
+}
+
+TEST_CASE(TextureArrayPacker_PlacesInTheFullestArray) {
+    TextureArrayPacker packer(400, 256, UINT64_MAX);
+    for (int i = 0; i < 6; i++) {
+        (void)packer.Allocate(FormatA, 100); // Array 0 is full, array 1 has 2 slices used.
+    }
+
+    // A slice freed in the fuller array is used before the free slices of the emptier one, so array 1 can drain.
+    packer.Free(0, 2);
+    const TextureArrayPlacement refill = packer.Allocate(FormatA, 100);
+    CHECK_EQUAL(0u, refill.Array);
+    CHECK_EQUAL(2u, refill.Slice);
+    CHECK(!refill.NewArray);
+
+    // Once array 0 drains below array 1, array 1 is the fuller one.
+    packer.Free(0, 1);
+    packer.Free(0, 2);
+    packer.Free(0, 3);
+    const TextureArrayPlacement fuller = packer.Allocate(FormatA, 100);
+    CHECK_EQUAL(1u, fuller.Array);
+    CHECK_EQUAL(2u, fuller.Slice);
+}
+
+TEST_CASE(TextureArrayPacker_SliceCountOfArrays) {
+    // Between one slice for textures larger than an array, and the maximum for small ones.
+    TextureArrayPacker packer(1000, 8, UINT64_MAX);
+    CHECK_EQUAL(1u, packer.GetSliceCount(packer.Allocate(FormatB, 5000).Array));
+    CHECK_EQUAL(8u, packer.GetSliceCount(packer.Allocate(FormatD, 10).Array));
+    CHECK_EQUAL(3u, packer.GetSliceCount(packer.Allocate(FormatA, 300).Array));
+    CHECK_EQUAL(0u, packer.GetSliceCount(10));
+}
+
+TEST_CASE(TextureArrayPacker_RejectsInvalidSlices) {
+    TextureArrayPacker packer(400, 256, UINT64_MAX);
+    CHECK_THROWS(packer.Allocate(FormatA, 0), std::out_of_range);
+
+    const TextureArrayPlacement placement = packer.Allocate(FormatA, 100);
+    CHECK_THROWS(packer.Allocate(FormatA, 200), std::out_of_range);
+    CHECK_THROWS(packer.Free(placement.Array, 1), std::out_of_range); // Never allocated.
+    CHECK_THROWS(packer.Free(placement.Array, 4), std::out_of_range); // Past the end of the array.
+    CHECK_THROWS(packer.Free(5, 0), std::out_of_range);
+
+    packer.Free(placement.Array, placement.Slice);
+    CHECK_THROWS(packer.Free(placement.Array, placement.Slice), std::out_of_range);
+}
+
+TEST_CASE(TextureArrayPacker_KeepsEmptyArraysWithinTheBudget) {
+    TextureArrayPacker packer(400, 256, 1000);
+    const TextureArrayPlacement first = packer.Allocate(FormatA, 100);
+    packer.Free(first.Array, first.Slice);
+    CHECK(packer.Evict().empty());
+    CHECK_EQUAL(1u, packer.GetStats().EmptyArrayCount);
+
+    // The empty array is reused instead of creating another.
+    const TextureArrayPlacement second = packer.Allocate(FormatA, 100);
+    CHECK_EQUAL(first.Array, second.Array);
+    CHECK(!second.NewArray);
+    CHECK_EQUAL(0u, packer.GetStats().EmptyArrayCount);
+}
+
+TEST_CASE(TextureArrayPacker_EvictsTheLongestEmptyArraysOverBudget) {
+    TextureArrayPacker packer(100, 256, 250); // One slice of 100 bytes per array, two arrays within the budget.
+    const TextureArrayPlacement a = packer.Allocate(FormatA, 100);
+    const TextureArrayPlacement b = packer.Allocate(FormatB, 100);
+    const TextureArrayPlacement c = packer.Allocate(FormatC, 100);
+
+    // Arrays holding textures are never evicted, even over budget.
+    CHECK(packer.Evict().empty());
+    CHECK_EQUAL(uint64_t{300}, packer.GetStats().ArrayBytes);
+
+    // B became empty first, so it goes first, which is enough to fit in the budget.
+    packer.Free(b.Array, b.Slice);
+    packer.Free(a.Array, a.Slice);
+    CHECK(packer.Evict() == std::vector<uint32_t>{b.Array});
+
+    TextureArrayStats stats = packer.GetStats();
+    CHECK_EQUAL(2u, stats.ArrayCount);
+    CHECK_EQUAL(1u, stats.EmptyArrayCount);
+    CHECK_EQUAL(1u, stats.EvictedArrayCount);
+    CHECK_EQUAL(uint64_t{200}, stats.ArrayBytes);
+    CHECK_EQUAL(0u, packer.GetSliceCount(b.Array));
+
+    // The id of the evicted array is reused, and B's format gets a new array.
+    const TextureArrayPlacement d = packer.Allocate(FormatD, 100);
+    CHECK_EQUAL(b.Array, d.Array);
+    CHECK(d.NewArray);
+    const TextureArrayPlacement b2 = packer.Allocate(FormatB, 100);
+    CHECK(b2.NewArray);
+
+    // Over budget again: A and then C are evicted, in the order they became empty.
+    packer.Free(c.Array, c.Slice);
+    CHECK(packer.Evict() == (std::vector<uint32_t>{a.Array, c.Array}));
+    stats = packer.GetStats();
+    CHECK_EQUAL(2u, stats.ArrayCount);
+    CHECK_EQUAL(0u, stats.EmptyArrayCount);
+    CHECK_EQUAL(3u, stats.EvictedArrayCount);
+}
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <pbr/PbrTextureArrayPool.h>
+#include "D3D11TestDevice.h"
+
+namespace {
+    winrt::com_ptr<ID3D11ShaderResourceView> CreateTexture(ID3D11Device* device, D3D11_USAGE usage, UINT bindFlags) {
+        D3D11_TEXTURE2D_DESC desc{};
+        desc.Width = 64;
+        desc.Height = 64;
+        desc.MipLevels = 1;
+        desc.ArraySize = 1;
+        desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        desc.SampleDesc.Count = 1;
+        desc.Usage = usage;
+        desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | bindFlags;
+        desc.CPUAccessFlags = usage == D3D11_USAGE_DYNAMIC ? D3D11_CPU_ACCESS_WRITE : 0;
+
+        winrt::com_ptr<ID3D11Texture2D> texture;
+        CHECK(SUCCEEDED(device->CreateTexture2D(&desc, nullptr, texture.put())));
+        winrt::com_ptr<ID3D11ShaderResourceView> view;
+        CHECK(SUCCEEDED(device->CreateShaderResourceView(texture.get(), nullptr, view.put())));
+        return view;
+    }
+
+    winrt::com_ptr<ID3D11Resource> GetResource(ID3D11ShaderResourceView* view) {
+        winrt::com_ptr<ID3D11Resource> resource;
+        view->GetResource(resource.put());
+        return resource;
+    }
+} // namespace
+
+TEST_CASE(TextureArrayPool_CopiesStaticTextures) {
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    Pbr::TextureArrayPool pool(device.Device.get());
+    const winrt::com_ptr<ID3D11ShaderResourceView> texture = CreateTexture(device.Device.get(), D3D11_USAGE_DEFAULT, 0);
+
+    std::shared_ptr<const Pbr::TextureArraySlice> slice = pool.GetSlice(device.Context.get(), texture.get());
+    CHECK(GetResource(slice->ArrayView.get()) != GetResource(texture.get()));
+    CHECK(pool.GetSlice(device.Context.get(), texture.get()) == slice);
+    CHECK_EQUAL(1u, pool.GetStats().Arrays.UsedSliceCount);
+    CHECK_EQUAL(0u, pool.GetStats().StandaloneTextureCount);
+
+    slice.reset();
+    CHECK_EQUAL(0u, pool.GetStats().Arrays.UsedSliceCount);
+}
+
+TEST_CASE(TextureArrayPool_ViewsWritableTextures) {
+    // Copies of textures that are written after the copy would go stale, so they are viewed in place.
+    const Test::D3D11Device device = Test::CreateWarpDevice();
+    Pbr::TextureArrayPool pool(device.Device.get());
+    const winrt::com_ptr<ID3D11ShaderResourceView> textures[] = {
+        CreateTexture(device.Device.get(), D3D11_USAGE_DEFAULT, D3D11_BIND_RENDER_TARGET),
+        CreateTexture(device.Device.get(), D3D11_USAGE_DEFAULT, D3D11_BIND_UNORDERED_ACCESS),
+        CreateTexture(device.Device.get(), D3D11_USAGE_DYNAMIC, 0),
+    };
+
+    std::vector<std::shared_ptr<const Pbr::TextureArraySlice>> slices;
+    for (const winrt::com_ptr<ID3D11ShaderResourceView>& texture : textures) {
+        slices.push_back(pool.GetSlice(device.Context.get(), texture.get()));
+        CHECK(GetResource(slices.back()->ArrayView.get()) == GetResource(texture.get()));
+        CHECK_EQUAL(0u, slices.back()->Slice);
+    }
+
+    const Pbr::TextureArrayPoolStats stats = pool.GetStats();
+    CHECK_EQUAL(3u, stats.StandaloneTextureCount);
+    CHECK_EQUAL(0u, stats.Arrays.ArrayCount);
+
+    slices.clear();
+    CHECK_EQUAL(0u, pool.GetStats().StandaloneTextureCount);
+}
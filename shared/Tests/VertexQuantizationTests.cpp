@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <cmath>
+#include <cstring>
+#include <pbr/PbrVertexQuantization.h>
+
+using namespace Pbr::VertexQuantization;
+
+namespace {
+    uint32_t FloatBits(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    float BitsToFloat(uint32_t bits) {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // Unit vectors spread over the sphere, plus the axes and the directions along the folds of the octahedron.
+    std::vector<std::array<float, 3>> UnitVectors(size_t randomCount) {
+        std::vector<std::array<float, 3>> vectors = {
+            {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {0.6f, 0.8f, 0}, {-0.8f, 0, -0.6f}, {0, 0.6f, -0.8f}};
+        std::minstd_rand random(7);
+        std::normal_distribution<float> normal;
+        while (vectors.size() < randomCount) {
+            const float x = normal(random), y = normal(random), z = normal(random);
+            const float length = std::sqrt(x * x + y * y + z * z);
+            if (length > 1e-3f) {
+                vectors.push_back({x / length, y / length, z / length});
+            }
+        }
+        return vectors;
+    }
+} // namespace
+
+TEST_CASE(VertexQuantization_HalfRoundTripIsExact) {
+    // Every half converts to a float and back to the same bits, including denormals, zeros and infinities.
+    for (uint32_t half = 0; half <= 0xFFFF; half++) {
+        const float value = HalfToFloat(static_cast<uint16_t>(half));
+        const uint16_t roundTrip = FloatToHalf(value);
+        if (std::isnan(value)) {
+            CHECK(std::isnan(HalfToFloat(roundTrip)));
+        } else if (roundTrip != half) {
+            CHECK_EQUAL(half, static_cast<uint32_t>(roundTrip));
+        }
+    }
+}
+
+TEST_CASE(VertexQuantization_HalfRounding) {
+    CHECK_EQUAL(0x3C00, (int)FloatToHalf(1.0f));
+    CHECK_EQUAL(0xC000, (int)FloatToHalf(-2.0f));
+
+    // Halfway between two halves rounds to the even mantissa.
+    CHECK_EQUAL(0x3C00, (int)FloatToHalf(1.0f + std::ldexp(1.0f, -11)));
+    CHECK_EQUAL(0x3C02, (int)FloatToHalf(1.0f + 3 * std::ldexp(1.0f, -11)));
+    CHECK_EQUAL(0x3C01, (int)FloatToHalf(BitsToFloat(FloatBits(1.0f + std::ldexp(1.0f, -11)) + 1)));
+
+    // Largest half, overflow and denormals.
+    CHECK_EQUAL(0x7BFF, (int)FloatToHalf(65504.0f));
+    CHECK_EQUAL(0x7BFF, (int)FloatToHalf(65519.0f));
+    CHECK_EQUAL(0x7C00, (int)FloatToHalf(65520.0f));
+    CHECK_EQUAL(0xFC00, (int)FloatToHalf(-1e10f));
+    CHECK_EQUAL(0x0001, (int)FloatToHalf(std::ldexp(1.0f, -24)));
+    CHECK_EQUAL(0x0000, (int)FloatToHalf(std::ldexp(1.0f, -25)));
+    CHECK_EQUAL(0x0002, (int)FloatToHalf(std::ldexp(3.0f, -25)));
+    CHECK_EQUAL(0x8000, (int)FloatToHalf(-1e-10f));
+    CHECK_EQUAL(0x0400, (int)FloatToHalf(std::ldexp(1.0f, -14)));
+}
+
+TEST_CASE(VertexQuantization_Snorm16AndUnorm8) {
+    CHECK_EQUAL(32767, (int)FloatToSnorm16(1.0f));
+    CHECK_EQUAL(-32767, (int)FloatToSnorm16(-1.0f));
+    CHECK_EQUAL(32767, (int)FloatToSnorm16(2.0f));
+    CHECK_EQUAL(0, (int)FloatToSnorm16(0.0f));
+    CHECK_EQUAL(-1.0f, Snorm16ToFloat(-32768));
+    CHECK_EQUAL(-1.0f, Snorm16ToFloat(-32767));
+
+    for (int32_t value = -32767; value <= 32767; value++) {
+        if (FloatToSnorm16(Snorm16ToFloat(static_cast<int16_t>(value))) != value) {
+            CHECK_EQUAL(value, (int32_t)FloatToSnorm16(Snorm16ToFloat(static_cast<int16_t>(value))));
+        }
+    }
+    for (uint32_t value = 0; value <= 255; value++) {
+        CHECK_EQUAL(value, (uint32_t)FloatToUnorm8(Unorm8ToFloat(static_cast<uint8_t>(value))));
+    }
+    CHECK_EQUAL(255, (int)FloatToUnorm8(1.5f));
+    CHECK_EQUAL(0, (int)FloatToUnorm8(-0.5f));
+}
+
+TEST_CASE(VertexQuantization_OctahedralRoundTrip) {
+    float maxError = 0;
+    for (const std::array<float, 3>& n : UnitVectors(20000)) {
+        const std::array<int16_t, 2> encoded = EncodeOctahedral(n[0], n[1], n[2]);
+        const std::array<float, 3> decoded = DecodeOctahedral(encoded[0], encoded[1]);
+        CHECK_NEAR(1.0f, std::sqrt(decoded[0] * decoded[0] + decoded[1] * decoded[1] + decoded[2] * decoded[2]), 1e-6f);
+        for (size_t axis = 0; axis < 3; axis++) {
+            maxError = std::max(maxError, std::abs(decoded[axis] - n[axis]));
+        }
+    }
+    CHECK(maxError < 1e-4f);
+
+    // Axes land on the corners and the center of the octahedron, which snorm16 represents exactly.
+    const std::array<float, 3> down = DecodeOctahedral(EncodeOctahedral(0, 0, -1)[0], EncodeOctahedral(0, 0, -1)[1]);
+    CHECK_EQUAL(-1.0f, down[2]);
+    CHECK(EncodeOctahedral(0, 0, 1) == (std::array<int16_t, 2>{0, 0}));
+    CHECK(EncodeOctahedral(0, 0, 0) == (std::array<int16_t, 2>{0, 0}));
+}
+
+TEST_CASE(VertexQuantization_PositionsWithinBounds) {
+    const float positions[][3] = {{-2, 1, 5}, {6, 1, 5.5f}, {0.3f, 1, 5.1f}, {4.4f, 1, 5.25f}};
+    const PositionBounds bounds = ComputePositionBounds(positions, 4, sizeof(positions[0]));
+    CHECK_EQUAL(2.0f, bounds.Center[0]);
+    CHECK_EQUAL(4.0f, bounds.Extent[0]);
+    CHECK_EQUAL(1.0f, bounds.Center[1]);
+    CHECK(bounds.Extent[1] > 0); // The flat axis still has an extent to divide by.
+    CHECK_EQUAL(5.25f, bounds.Center[2]);
+
+    for (const auto& position : positions) {
+        const std::array<int16_t, 3> quantized = QuantizePosition(position, bounds);
+        const std::array<float, 3> dequantized = DequantizePosition(quantized.data(), bounds);
+        for (size_t axis = 0; axis < 3; axis++) {
+            // Half a snorm16 step of the extent, plus float rounding.
+            CHECK_NEAR(position[axis], dequantized[axis], bounds.Extent[axis] * 0.5f / 32767 + 1e-6f);
+        }
+    }
+
+    // The corners of the bounds are exact.
+    const std::array<float, 3> low = DequantizePosition(QuantizePosition(positions[0], bounds).data(), bounds);
+    CHECK_EQUAL(-2.0f, low[0]);
+    CHECK_EQUAL(1.0f, low[1]);
+    CHECK_EQUAL(5.0f, low[2]);
+}
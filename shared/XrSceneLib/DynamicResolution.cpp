@@ -0,0 +1,81 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#include "pch.h"
+#include <algorithm>
+#include <cmath>
+#include "DynamicResolution.h"
+
+DynamicResolutionController::DynamicResolutionController(const DynamicResolutionConfig& config)
+    : m_config(config)
+    , m_scale(config.MaxScale) {
+}
+
+void DynamicResolutionController::SetConfig(const DynamicResolutionConfig& config) {
+    m_config = config;
+    m_scale = std::clamp(m_scale, m_config.MinScale, m_config.MaxScale);
+}
+
+void DynamicResolutionController::Reset() {
+    m_scale = m_config.MaxScale;
+    m_costs[(size_t)RenderCostSource::Gpu] = {};
+    m_costs[(size_t)RenderCostSource::Cpu] = {};
+    m_cpuSamplesSinceGpuSample = 0;
+}
+
+RenderCostSource DynamicResolutionController::ActiveSource() const {
+    // Until the first GPU sample, wait GpuTimeout frames for it rather than reacting to the CPU samples of the first frames.
+    return m_cpuSamplesSinceGpuSample >= m_config.GpuTimeout ? RenderCostSource::Cpu : RenderCostSource::Gpu;
+}
+
+float DynamicResolutionController::Update(duration renderCost, float renderScale, duration framePeriod, RenderCostSource source) {
+    const float cost = renderCost.count();
+    const float period = framePeriod.count();
+    if (cost <= 0 || period <= 0 || renderScale <= 0) {
+        return m_scale; // Nothing measured, keep the current scale.
+    }
+
+    if (source == RenderCostSource::Gpu) {
+        m_cpuSamplesSinceGpuSample = 0;
+    } else if (m_cpuSamplesSinceGpuSample < m_config.GpuTimeout) {
+        m_cpuSamplesSinceGpuSample++;
+    }
+
+    // Cost scales with the pixel count, so the cost of the measured frame at a scale of 1 is its cost over the squared scale.
+    // Normalizing each sample keeps samples rendered at older scales comparable with the current one. CPU time is much lower
+    // than GPU time for the same frame, so each source has its own average and only the active one drives the scale.
+    const float fullCost = cost / (renderScale * renderScale);
+    CostAverage& average = m_costs[(size_t)source];
+    if (average.HasSample) {
+        average.SmoothedFullCost += (fullCost - average.SmoothedFullCost) * m_config.CostSmoothing;
+    } else {
+        average.SmoothedFullCost = fullCost;
+        average.HasSample = true;
+    }
+    if (source != ActiveSource()) {
+        return m_scale;
+    }
+
+    const float targetCost = period * (1.0f - m_config.TargetHeadroom);
+    const float costRatio = targetCost / (average.SmoothedFullCost * m_scale * m_scale);
+    if (std::abs(costRatio - 1.0f) < m_config.Deadband) {
+        return m_scale;
+    }
+
+    const float idealScale = std::clamp(std::sqrt(targetCost / average.SmoothedFullCost), m_config.MinScale, m_config.MaxScale);
+    const float step = std::clamp((idealScale - m_scale) * m_config.Damping, -m_config.MaxStepDown, m_config.MaxStepUp);
+    m_scale = std::clamp(m_scale + step, m_config.MinScale, m_config.MaxScale);
+    return m_scale;
+}
@@ -0,0 +1,90 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+struct DynamicResolutionConfig {
+    float MinScale = 0.5f;       // Lower bound of the viewport scale
+    float MaxScale = 1.0f;       // Upper bound of the viewport scale
+    float TargetHeadroom = 0.2f; // Fraction of the frame period to keep free of render work
+    float CostSmoothing = 0.2f;  // Weight of the newest sample in the exponential moving average of render cost
+    float Damping = 0.3f;        // Fraction of the distance to the ideal scale covered per update
+    float Deadband = 0.05f;      // Relative cost error below which the scale is left unchanged
+    float MaxStepUp = 0.02f;     // Largest scale increase per update, grow slowly to avoid oscillation
+    float MaxStepDown = 0.1f;    // Largest scale decrease per update, shrink quickly to recover from overload
+    uint32_t GpuTimeout = 30;    // CPU samples without a GPU sample after which CPU time drives the scale instead
+};
+
+// Where a render cost sample was measured. GPU time is what the viewport scale controls. CPU submit time is only a rough
+// proxy of it, used when the GPU timing is unavailable, e.g. when timestamp queries never resolve or are always disjoint.
+enum class RenderCostSource {
+    Gpu,
+    Cpu,
+};
+
+// Closed-loop controller that picks a viewport scale so that the measured render cost stays within
+// the frame period minus the configured headroom. Render cost is assumed to be proportional to the
+// number of rendered pixels, i.e. to the square of the viewport scale, so each sample is normalized
+// by the scale it was rendered at before it is averaged. GPU and CPU samples are averaged separately,
+// and the CPU average only drives the scale while no GPU sample has arrived for GpuTimeout CPU samples.
+// This class has no graphics dependency so that it can be driven by synthetic frame-time traces.
+class DynamicResolutionController {
+public:
+    using duration = std::chrono::duration<float>;
+
+    explicit DynamicResolutionController(const DynamicResolutionConfig& config = {});
+
+    // Feed the render cost measured for a frame rendered at renderScale and the frame period it must fit in.
+    // GPU results arrive a few frames late, so renderScale is the scale of the measured frame, not necessarily Scale().
+    // Feed a CPU sample every frame for the fallback to work. Returns the scale to use for the next frame.
+    float Update(duration renderCost, float renderScale, duration framePeriod, RenderCostSource source = RenderCostSource::Gpu);
+
+    // The current viewport scale, always within [MinScale, MaxScale].
+    float Scale() const {
+        return m_scale;
+    }
+
+    // The source whose samples drive the scale. The GPU, unless GPU samples stopped arriving or never did.
+    RenderCostSource ActiveSource() const;
+
+    // The smoothed render cost estimate of the active source at the current scale.
+    duration SmoothedCost() const {
+        return duration(m_costs[(size_t)ActiveSource()].SmoothedFullCost * m_scale * m_scale);
+    }
+
+    const DynamicResolutionConfig& Config() const {
+        return m_config;
+    }
+
+    // Change the settings without discarding the current estimate; the scale is clamped to the new bounds.
+    void SetConfig(const DynamicResolutionConfig& config);
+
+    // Restart from the maximum scale, e.g. after the swapchain was recreated.
+    void Reset();
+
+private:
+    struct CostAverage {
+        float SmoothedFullCost{0}; // Smoothed render cost normalized to a scale of 1.
+        bool HasSample{false};
+    };
+
+    DynamicResolutionConfig m_config;
+    float m_scale;
+    CostAverage m_costs[2]; // Indexed by RenderCostSource.
+    uint32_t m_cpuSamplesSinceGpuSample{0};
+};
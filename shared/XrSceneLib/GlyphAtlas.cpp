@@ -0,0 +1,134 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#include "pch.h"
+#include <algorithm>
+#include <cmath>
+#include "GlyphAtlas.h"
+
+SkylinePacker::SkylinePacker(uint32_t width, uint32_t height)
+    : m_width(width)
+    , m_height(height) {
+    Reset();
+}
+
+void SkylinePacker::Reset() {
+    m_skyline.assign(1, Segment{0, 0, m_width});
+    m_allocatedArea = 0;
+}
+
+float SkylinePacker::Occupancy() const {
+    return static_cast<float>(static_cast<double>(m_allocatedArea) / (static_cast<double>(m_width) * m_height));
+}
+
+std::optional<AtlasRect> SkylinePacker::Allocate(uint32_t width, uint32_t height) {
+    if (width == 0 || height == 0 || width > m_width || height > m_height) {
+        return std::nullopt;
+    }
+
+    // Find the segment where the rectangle rests lowest, preferring the narrowest fit on ties.
+    size_t bestIndex = m_skyline.size();
+    uint32_t bestY = UINT32_MAX;
+    uint32_t bestWidth = UINT32_MAX;
+    for (size_t i = 0; i < m_skyline.size(); i++) {
+        const uint32_t x = m_skyline[i].X;
+        if (x + width > m_width) {
+            break;
+        }
+
+        uint32_t y = 0;
+        uint32_t remaining = width;
+        for (size_t j = i; remaining > 0; j++) {
+            y = std::max(y, m_skyline[j].Y);
+            remaining -= std::min(remaining, m_skyline[j].Width);
+        }
+
+        if (y + height <= m_height && (y < bestY || (y == bestY && m_skyline[i].Width < bestWidth))) {
+            bestIndex = i;
+            bestY = y;
+            bestWidth = m_skyline[i].Width;
+        }
+    }
+
+    if (bestIndex == m_skyline.size()) {
+        return std::nullopt;
+    }
+
+    const AtlasRect rect{m_skyline[bestIndex].X, bestY, width, height};
+
+    // Raise the skyline over the new rectangle, trimming the segments it covers.
+    m_skyline.insert(m_skyline.begin() + bestIndex, Segment{rect.X, rect.Y + height, width});
+    for (size_t i = bestIndex + 1; i < m_skyline.size();) {
+        Segment& segment = m_skyline[i];
+        const uint32_t rectRight = rect.X + width;
+        if (segment.X >= rectRight) {
+            break;
+        }
+        const uint32_t overlap = std::min(segment.Width, rectRight - segment.X);
+        segment.X += overlap;
+        segment.Width -= overlap;
+        if (segment.Width == 0) {
+            m_skyline.erase(m_skyline.begin() + i);
+        } else {
+            break;
+        }
+    }
+
+    // Merge neighbors at the same height to keep the skyline short.
+    for (size_t i = 0; i + 1 < m_skyline.size();) {
+        if (m_skyline[i].Y == m_skyline[i + 1].Y) {
+            m_skyline[i].Width += m_skyline[i + 1].Width;
+            m_skyline.erase(m_skyline.begin() + i + 1);
+        } else {
+            i++;
+        }
+    }
+
+    m_allocatedArea += static_cast<uint64_t>(width) * height;
+    return rect;
+}
+
+std::vector<uint8_t> GenerateSignedDistanceField(const uint8_t* coverage, uint32_t width, uint32_t height, uint32_t spread) {
+    std::vector<uint8_t> field(static_cast<size_t>(width) * height);
+    const int32_t radius = static_cast<int32_t>(spread);
+    const auto inside = [&](int32_t x, int32_t y) { return coverage[static_cast<size_t>(y) * width + x] >= 128; };
+
+    for (int32_t y = 0; y < static_cast<int32_t>(height); y++) {
+        for (int32_t x = 0; x < static_cast<int32_t>(width); x++) {
+            // Distance to the nearest texel on the other side of the edge, searched within the spread.
+            const bool isInside = inside(x, y);
+            float nearestSquared = static_cast<float>(radius * radius);
+            for (int32_t dy = -radius; dy <= radius; dy++) {
+                const int32_t sy = y + dy;
+                if (sy < 0 || sy >= static_cast<int32_t>(height) || static_cast<float>(dy * dy) >= nearestSquared) {
+                    continue;
+                }
+                for (int32_t dx = -radius; dx <= radius; dx++) {
+                    const int32_t sx = x + dx;
+                    if (sx >= 0 && sx < static_cast<int32_t>(width) && inside(sx, sy) != isInside) {
+                        nearestSquared = std::min(nearestSquared, static_cast<float>(dx * dx + dy * dy));
+                    }
+                }
+            }
+
+            // The edge lies halfway between the two texels.
+            const float distance = std::max(0.0f, std::sqrt(nearestSquared) - 0.5f) * (isInside ? 1.0f : -1.0f);
+            const float value = 127.5f + 127.5f * std::clamp(distance / radius, -1.0f, 1.0f);
+            field[static_cast<size_t>(y) * width + x] = static_cast<uint8_t>(value + 0.5f);
+        }
+    }
+
+    return field;
+}
@@ -0,0 +1,66 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+struct AtlasRect {
+    uint32_t X;
+    uint32_t Y;
+    uint32_t Width;
+    uint32_t Height;
+};
+
+// Packs rectangles into a fixed size atlas using the bottom-left skyline heuristic, which suits glyphs of similar heights.
+// This class has no graphics dependency.
+class SkylinePacker {
+public:
+    SkylinePacker(uint32_t width, uint32_t height);
+
+    // Returns the allocated rectangle, or nothing if the atlas has no room left for it.
+    std::optional<AtlasRect> Allocate(uint32_t width, uint32_t height);
+
+    // Free all allocations.
+    void Reset();
+
+    uint32_t Width() const {
+        return m_width;
+    }
+    uint32_t Height() const {
+        return m_height;
+    }
+
+    // Fraction of the atlas area covered by allocations.
+    float Occupancy() const;
+
+private:
+    struct Segment {
+        uint32_t X;
+        uint32_t Y; // Height of the skyline over [X, X + Width)
+        uint32_t Width;
+    };
+
+    const uint32_t m_width;
+    const uint32_t m_height;
+    std::vector<Segment> m_skyline;
+    uint64_t m_allocatedArea{0};
+};
+
+// Convert an 8-bit coverage bitmap into a signed distance field of the same size. 128 is the glyph edge, values above are
+// inside. Distances are clamped to spread texels, so the bitmap should have at least that much empty padding.
+std::vector<uint8_t> GenerateSignedDistanceField(const uint8_t* coverage, uint32_t width, uint32_t height, uint32_t spread);
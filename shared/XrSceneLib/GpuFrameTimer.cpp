@@ -0,0 +1,79 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#include "pch.h"
+#include "GpuFrameTimer.h"
+
+void GpuFrameTimer::Begin(_In_ ID3D11Device* device, _In_ ID3D11DeviceContext* context, float scale) {
+    Frame& frame = m_frames[m_nextFrame];
+    if (frame.Pending) {
+        // The GPU is more than FrameCount frames behind, drop the oldest result rather than waiting for it.
+        frame.Pending = false;
+    }
+
+    if (!frame.Disjoint) {
+        const CD3D11_QUERY_DESC disjointDesc(D3D11_QUERY_TIMESTAMP_DISJOINT);
+        const CD3D11_QUERY_DESC timestampDesc(D3D11_QUERY_TIMESTAMP);
+        CHECK_HRCMD(device->CreateQuery(&disjointDesc, frame.Disjoint.put()));
+        CHECK_HRCMD(device->CreateQuery(&timestampDesc, frame.Start.put()));
+        CHECK_HRCMD(device->CreateQuery(&timestampDesc, frame.Stop.put()));
+    }
+
+    context->Begin(frame.Disjoint.get());
+    context->End(frame.Start.get());
+    frame.Scale = scale;
+    m_inFrame = true;
+}
+
+void GpuFrameTimer::End(_In_ ID3D11DeviceContext* context) {
+    if (!m_inFrame) {
+        return;
+    }
+
+    Frame& frame = m_frames[m_nextFrame];
+    context->End(frame.Stop.get());
+    context->End(frame.Disjoint.get());
+    frame.Pending = true;
+
+    m_nextFrame = (m_nextFrame + 1) % FrameCount;
+    m_inFrame = false;
+}
+
+std::optional<GpuFrameTimer::Sample> GpuFrameTimer::TryGetLatest(_In_ ID3D11DeviceContext* context) {
+    std::optional<Sample> latest;
+
+    // Walk from the oldest to the newest pending frame so the newest available result wins.
+    for (uint32_t i = 0; i < FrameCount; i++) {
+        Frame& frame = m_frames[(m_nextFrame + i) % FrameCount];
+        if (!frame.Pending) {
+            continue;
+        }
+
+        D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint{};
+        uint64_t start = 0, stop = 0;
+        if (context->GetData(frame.Disjoint.get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+            context->GetData(frame.Start.get(), &start, sizeof(start), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+            context->GetData(frame.Stop.get(), &stop, sizeof(stop), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+            continue; // Not resolved yet.
+        }
+
+        frame.Pending = false;
+        if (!disjoint.Disjoint && disjoint.Frequency > 0 && stop > start) {
+            latest = Sample{duration(static_cast<float>(stop - start) / static_cast<float>(disjoint.Frequency)), frame.Scale};
+        }
+    }
+
+    return latest;
+}
@@ -0,0 +1,49 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#pragma once
+
+// Measures GPU time of a span of work using D3D11 timestamp queries.
+// Queries are kept in a small ring so that results are read back a few frames later without stalling the pipeline.
+class GpuFrameTimer {
+public:
+    using duration = std::chrono::duration<float>;
+
+    struct Sample {
+        duration Duration;
+        float Scale; // The scale passed to Begin for the measured span.
+    };
+
+    // The scale is handed back with the result of the span, because results arrive a few frames after the span was recorded.
+    void Begin(_In_ ID3D11Device* device, _In_ ID3D11DeviceContext* context, float scale = 1.0f);
+    void End(_In_ ID3D11DeviceContext* context);
+
+    // Returns the most recently completed span, or nullopt when no valid result is available yet.
+    std::optional<Sample> TryGetLatest(_In_ ID3D11DeviceContext* context);
+
+private:
+    struct Frame {
+        winrt::com_ptr<ID3D11Query> Disjoint;
+        winrt::com_ptr<ID3D11Query> Start;
+        winrt::com_ptr<ID3D11Query> Stop;
+        float Scale{1.0f};
+        bool Pending{false};
+    };
+
+    static constexpr uint32_t FrameCount = 4;
+    std::array<Frame, FrameCount> m_frames;
+    uint32_t m_nextFrame{0};
+    bool m_inFrame{false};
+};
@@ -0,0 +1,39 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#include "pch.h"
+#include "ModelInstanceObject.h"
+
+ModelInstanceObject::ModelInstanceObject(std::shared_ptr<const Pbr::Model> pbrModel, Pbr::ShadingMode shadingMode, Pbr::FillMode fillMode)
+    : m_instance(std::move(pbrModel))
+    , m_shadingMode(shadingMode)
+    , m_fillMode(fillMode) {
+}
+
+void ModelInstanceObject::Render(SceneContext& sceneContext) const {
+    if (!IsVisible()) {
+        return;
+    }
+
+    sceneContext.PbrResources.SetShadingMode(m_shadingMode);
+    sceneContext.PbrResources.SetFillMode(m_fillMode);
+    sceneContext.PbrResources.SetModelToWorld(WorldTransform(), sceneContext.DeviceContext.get());
+    sceneContext.PbrResources.Bind(sceneContext.DeviceContext.get());
+    m_instance.Render(sceneContext.PbrResources, sceneContext.DeviceContext.get());
+}
+
+Pbr::DrawPasses ModelInstanceObject::GetDrawPasses() const {
+    return m_instance.GetDrawPasses();
+}
@@ -0,0 +1,44 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#pragma once
+
+#include <pbr/PbrModelInstance.h>
+#include "Scene.h"
+#include "SceneContext.h"
+
+// A scene object for one of many copies of a model, e.g. a prop or controller model spawned many times. The copies share the
+// model's geometry and materials, and each can be posed and given different materials on its own.
+class ModelInstanceObject : public SceneObject {
+public:
+    explicit ModelInstanceObject(std::shared_ptr<const Pbr::Model> pbrModel,
+                                 Pbr::ShadingMode shadingMode = Pbr::ShadingMode::Regular,
+                                 Pbr::FillMode fillMode = Pbr::FillMode::Solid);
+
+    Pbr::ModelInstance& Instance() {
+        return m_instance;
+    }
+    const Pbr::ModelInstance& Instance() const {
+        return m_instance;
+    }
+
+    void Render(SceneContext& sceneContext) const override;
+    Pbr::DrawPasses GetDrawPasses() const override;
+
+private:
+    Pbr::ModelInstance m_instance;
+    Pbr::ShadingMode m_shadingMode;
+    Pbr::FillMode m_fillMode;
+};
@@ -27,6 +27,7 @@ PbrModelObject::PbrModelObject(std::shared_ptr<Pbr::Model> pbrModel, Pbr::Shadin
 
 void PbrModelObject::SetModel(std::shared_ptr<Pbr::Model> model) {
     m_pbrModel = std::move(model);
+    m_primitiveBuilders.clear();
 }
 
 std::shared_ptr<Pbr::Model> PbrModelObject::GetModel() const {
@@ -45,6 +46,29 @@ void PbrModelObject::Render(SceneContext& sceneContext) const {
     m_pbrModel->Render(sceneContext.PbrResources, sceneContext.DeviceContext.get());
 }
 
+Pbr::DrawPasses PbrModelObject::GetDrawPasses() const {
+    return m_pbrModel ? m_pbrModel->GetDrawPasses() : Pbr::DrawPasses{};
+}
+
+void PbrModelObject::SetPrimitiveBuilders(std::vector<Pbr::PrimitiveBuilder> primitiveBuilders) {
+    m_primitiveBuilders = std::move(primitiveBuilders);
+}
+
+std::vector<Pbr::StaticBatch::EntryId> PbrModelObject::AddStaticGeometry(Pbr::StaticBatch& batch) const {
+    // Static batches draw with the regular shading and solid fill, and have a single node.
+    std::vector<Pbr::StaticBatch::EntryId> entryIds;
+    if (!m_pbrModel || m_pbrModel->GetNodeCount() != 1 || m_primitiveBuilders.size() != m_pbrModel->GetPrimitiveCount() ||
+        m_shadingMode != Pbr::ShadingMode::Regular || m_fillMode != Pbr::FillMode::Solid) {
+        return entryIds;
+    }
+
+    const XMMATRIX transform = m_pbrModel->GetNode(Pbr::RootNodeIndex).GetTransform() * WorldTransform();
+    for (uint32_t k = 0; k < m_pbrModel->GetPrimitiveCount(); k++) {
+        entryIds.push_back(batch.Add(m_primitiveBuilders[k], m_pbrModel->GetPrimitive(k).GetMaterial(), transform));
+    }
+    return entryIds;
+}
+
 void PbrModelObject::SetShadingMode(const Pbr::ShadingMode& shadingMode) {
     m_shadingMode = shadingMode;
 }
@@ -67,16 +91,22 @@ std::shared_ptr<PbrModelObject> CreateCube(const Pbr::Resources& pbrResources,
                                          float metallic /*= 0.0f*/) {
     auto material = Pbr::Material::CreateFlat(pbrResources, color, roughness, metallic);
     auto cubeModel = std::make_shared<Pbr::Model>();
-    cubeModel->AddPrimitive(Pbr::Primitive(pbrResources, Pbr::PrimitiveBuilder().AddCube(sideLengths), std::move(material)));
-    return std::make_shared<PbrModelObject>(std::move(cubeModel));
+    Pbr::PrimitiveBuilder cubeBuilder = Pbr::PrimitiveBuilder().AddCube(sideLengths);
+    cubeModel->AddPrimitive(Pbr::Primitive(pbrResources, cubeBuilder, std::move(material)));
+    auto cubeObject = std::make_shared<PbrModelObject>(std::move(cubeModel));
+    cubeObject->SetPrimitiveBuilders({std::move(cubeBuilder)});
+    return cubeObject;
 }
 
 std::shared_ptr<PbrModelObject> CreateQuad(const Pbr::Resources& pbrResources,
                                          XMFLOAT2 sideLengths,
                                          std::shared_ptr<Pbr::Material> material) {
     auto quadModel = std::make_shared<Pbr::Model>();
-    quadModel->AddPrimitive(Pbr::Primitive(pbrResources, Pbr::PrimitiveBuilder().AddQuad(sideLengths), std::move(material)));
-    return std::make_shared<PbrModelObject>(std::move(quadModel));
+    Pbr::PrimitiveBuilder quadBuilder = Pbr::PrimitiveBuilder().AddQuad(sideLengths);
+    quadModel->AddPrimitive(Pbr::Primitive(pbrResources, quadBuilder, std::move(material)));
+    auto quadObject = std::make_shared<PbrModelObject>(std::move(quadModel));
+    quadObject->SetPrimitiveBuilders({std::move(quadBuilder)});
+    return quadObject;
 }
 
 std::shared_ptr<PbrModelObject> CreateSphere(const Pbr::Resources& pbrResources,
@@ -87,8 +117,11 @@ std::shared_ptr<PbrModelObject> CreateSphere(const Pbr::Resources& pbrResources,
                                            float metallic /*= 0.0f*/) {
     auto material = Pbr::Material::CreateFlat(pbrResources, color, roughness, metallic);
     auto sphereModel = std::make_shared<Pbr::Model>();
-    sphereModel->AddPrimitive(Pbr::Primitive(pbrResources, Pbr::PrimitiveBuilder().AddSphere(size, tesselation), std::move(material)));
-    return std::make_shared<PbrModelObject>(std::move(sphereModel));
+    Pbr::PrimitiveBuilder sphereBuilder = Pbr::PrimitiveBuilder().AddSphere(size, tesselation);
+    sphereModel->AddPrimitive(Pbr::Primitive(pbrResources, sphereBuilder, std::move(material)));
+    auto sphereObject = std::make_shared<PbrModelObject>(std::move(sphereModel));
+    sphereObject->SetPrimitiveBuilders({std::move(sphereBuilder)});
+    return sphereObject;
 }
 
 std::shared_ptr<PbrModelObject> CreateAxis(const Pbr::Resources& pbrResources,
@@ -99,7 +132,10 @@ std::shared_ptr<PbrModelObject> CreateAxis(const Pbr::Resources& pbrResources,
     auto material = Pbr::Material::CreateFlat(pbrResources, Pbr::RGBA::White, roughness, metallic);
 
     auto axisModel = std::make_shared<Pbr::Model>();
-    axisModel->AddPrimitive(Pbr::Primitive(pbrResources, Pbr::PrimitiveBuilder().AddAxis(axisLength, axisThickness), material));
+    Pbr::PrimitiveBuilder axisBuilder = Pbr::PrimitiveBuilder().AddAxis(axisLength, axisThickness);
+    axisModel->AddPrimitive(Pbr::Primitive(pbrResources, axisBuilder, material));
 
-    return std::make_shared<PbrModelObject>(std::move(axisModel));
+    auto axisObject = std::make_shared<PbrModelObject>(std::move(axisModel));
+    axisObject->SetPrimitiveBuilders({std::move(axisBuilder)});
+    return axisObject;
 }
@@ -29,14 +29,21 @@ public:
     void SetModel(std::shared_ptr<Pbr::Model> model);
     std::shared_ptr<Pbr::Model> GetModel() const;
 
+    // The builders that the primitives of a single-node model were created from, in the order of the primitives. They are kept
+    // so that the object can be merged into the static batch of its scene when it is static. SetModel drops them.
+    void SetPrimitiveBuilders(std::vector<Pbr::PrimitiveBuilder> primitiveBuilders);
+
     void SetShadingMode(const Pbr::ShadingMode& shadingMode);
     void SetFillMode(const Pbr::FillMode& fillMode);
     void SetBaseColorFactor(Pbr::RGBAColor color);
 
     void Render(SceneContext& sceneContext) const override;
+    Pbr::DrawPasses GetDrawPasses() const override;
+    std::vector<Pbr::StaticBatch::EntryId> AddStaticGeometry(Pbr::StaticBatch& batch) const override;
 
 private:
     std::shared_ptr<Pbr::Model> m_pbrModel;
+    std::vector<Pbr::PrimitiveBuilder> m_primitiveBuilders;
     Pbr::ShadingMode m_shadingMode;
     Pbr::FillMode m_fillMode;
 };
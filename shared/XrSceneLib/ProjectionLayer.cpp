@@ -79,9 +79,17 @@ void ProjectionLayer::PrepareRendering(const SceneContext& sceneContext,
         shouldResetSwapchain = true;
     }
 
+    const bool resetDynamicResolution = shouldResetSwapchain || !layerCurrentConfig.DynamicResolution;
+
     layerPendingConfig.ForceReset = false;
     layerCurrentConfig = layerPendingConfig;
 
+    viewConfigComponent.ResolutionController.SetConfig(layerCurrentConfig.DynamicResolutionSettings);
+    if (resetDynamicResolution) {
+        viewConfigComponent.ResolutionController.Reset();
+    }
+    const float dynamicScale = layerCurrentConfig.DynamicResolution ? viewConfigComponent.ResolutionController.Scale() : 1.0f;
+
     // SceneLib only supports identical sized swapchain images for left and right eyes (texture array/double wide).
     // Thus if runtime gives us different image rect sizes for left/right eyes,
     // we use the maximum left/right imageRect extent for recommendedImageRectExtent
@@ -110,15 +118,17 @@ void ProjectionLayer::PrepareRendering(const SceneContext& sceneContext,
             layerCurrentConfig.DoubleWideMode ? static_cast<float>(swapchainImageWidth * viewIndex + layerCurrentConfig.ViewportOffset.x)
                                               : static_cast<float>(layerCurrentConfig.ViewportOffset.x),
             static_cast<float>(layerCurrentConfig.ViewportOffset.y),
-            static_cast<float>(swapchainImageWidth * layerCurrentConfig.ViewportSizeScale.width),
-            static_cast<float>(swapchainImageHeight * layerCurrentConfig.ViewportSizeScale.height));
+            static_cast<float>(swapchainImageWidth * layerCurrentConfig.ViewportSizeScale.width * dynamicScale),
+            static_cast<float>(swapchainImageHeight * layerCurrentConfig.ViewportSizeScale.height * dynamicScale));
 
+        // The dynamic resolution scale shrinks the submitted imageRect together with the viewport,
+        // so the compositor upscales the rendered region to the full field of view.
         const int32_t doubleWideOffsetX = static_cast<int32_t>(swapchainImageWidth * viewIndex);
         viewConfigComponent.LayerDepthImageRect[viewIndex] =
             viewConfigComponent.LayerColorImageRect[viewIndex] = {layerCurrentConfig.DoubleWideMode ? doubleWideOffsetX : 0,
                                                                   0,
-                                                                  static_cast<int32_t>(std::ceil(swapchainImageWidth)),
-                                                                  static_cast<int32_t>(std::ceil(swapchainImageHeight))};
+                                                                  static_cast<int32_t>(std::ceil(swapchainImageWidth * dynamicScale)),
+                                                                  static_cast<int32_t>(std::ceil(swapchainImageHeight * dynamicScale))};
     }
 
     if (!shouldResetSwapchain) {
@@ -199,6 +209,13 @@ bool ProjectionLayer::Render(SceneContext& sceneContext,
         // Swapchain image timeout, don't submit this multi projection layer
         submitProjectionLayer = false;
     } else {
+        // The viewports of this frame were sized in PrepareRendering with the scale the controller holds until Update.
+        const float renderScale = viewConfigComponent.ResolutionController.Scale();
+        const FrameTime::clock::time_point renderStart = FrameTime::clock::now();
+        if (currentConfig.DynamicResolution) {
+            viewConfigComponent.RenderTimer.Begin(sceneContext.Device.get(), sceneContext.DeviceContext.get(), renderScale);
+        }
+
         const uint32_t viewCount = (uint32_t)views.size();
         for (uint32_t viewIndex = 0; viewIndex < viewCount; viewIndex++) {
             const XrView& projection = views[viewIndex];
@@ -239,8 +256,11 @@ bool ProjectionLayer::Render(SceneContext& sceneContext,
 
             // Render for this view pose.
             {
-                // Set the Viewport.
-                sceneContext.DeviceContext->RSSetViewports(1, &viewport);
+                // Set the Viewport through the render device of the PBR resources, which the scene objects draw with. The
+                // render target views below are views of the swapchain images, so they stay on the D3D11 context.
+                Pbr::RenderDevice& renderDevice = sceneContext.PbrResources.GetRenderDevice(sceneContext.DeviceContext.get());
+                renderDevice.SetViewport(
+                    {viewport.TopLeftX, viewport.TopLeftY, viewport.Width, viewport.Height, viewport.MinDepth, viewport.MaxDepth});
 
                 const uint32_t firstArraySliceForColor = projectionViews[viewIndex].subImage.imageArrayIndex;
 
@@ -311,6 +331,22 @@ bool ProjectionLayer::Render(SceneContext& sceneContext,
                 }
             }
         }
+
+        if (currentConfig.DynamicResolution) {
+            viewConfigComponent.RenderTimer.End(sceneContext.DeviceContext.get());
+
+            // GPU time drives the scale. CPU submit time is fed every frame too, but the controller averages it separately and
+            // only uses it when no GPU result arrived for a while, e.g. when the timestamp queries never resolve or are disjoint.
+            DynamicResolutionController& controller = viewConfigComponent.ResolutionController;
+            const GpuFrameTimer::duration framePeriod = std::chrono::nanoseconds(frameTime.PredictedDisplayPeriod);
+            const std::optional<GpuFrameTimer::Sample> gpuCost =
+                viewConfigComponent.RenderTimer.TryGetLatest(sceneContext.DeviceContext.get());
+            if (gpuCost) {
+                controller.Update(gpuCost->Duration, gpuCost->Scale, framePeriod, RenderCostSource::Gpu);
+            }
+            const auto cpuCost = std::chrono::duration_cast<GpuFrameTimer::duration>(FrameTime::clock::now() - renderStart);
+            controller.Update(cpuCost, renderScale, framePeriod, RenderCostSource::Cpu);
+        }
     }
 
     // Now that the scene is done writing to the swapchain, it must be released in order to be made available for
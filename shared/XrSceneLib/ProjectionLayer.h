@@ -22,6 +22,8 @@
 #include <SampleShared/DxUtility.h>
 #include "SceneContext.h"
 #include "FrameTime.h"
+#include "DynamicResolution.h"
+#include "GpuFrameTimer.h"
 
 struct ProjectionLayerConfig {
     XrCompositionLayerFlags LayerFlags = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
@@ -38,6 +40,11 @@ struct ProjectionLayerConfig {
     bool ContentProtected = false;
     bool ForceReset = false;
     DirectX::XMFLOAT4 ClearColor = {0, 0, 0, 0}; // Transparent
+
+    // When enabled, the viewport and submitted imageRect are further scaled each frame
+    // by a closed-loop controller to keep the measured render cost within the frame budget.
+    bool DynamicResolution = false;
+    DynamicResolutionConfig DynamicResolutionSettings{};
 };
 
 struct Scene;
@@ -65,6 +72,12 @@ public:
         return m_viewConfigComponents.at(viewConfig.value_or(m_defaultViewConfigurationType)).LayerSpace;
     }
 
+    // The viewport scale currently chosen by the dynamic resolution controller, 1 when it is disabled.
+    float DynamicResolutionScale(std::optional<XrViewConfigurationType> viewConfig = std::nullopt) const {
+        const ViewConfigComponent& component = m_viewConfigComponents.at(viewConfig.value_or(m_defaultViewConfigurationType));
+        return component.CurrentConfig.DynamicResolution ? component.ResolutionController.Scale() : 1.0f;
+    }
+
     void PrepareRendering(const SceneContext& sceneContext,
                           XrViewConfigurationType viewConfigType,
                           const std::vector<XrViewConfigurationView>& viewConfigViews);
@@ -91,6 +104,9 @@ private:
 
         sample::dx::SwapchainD3D11 ColorSwapchain;
         sample::dx::SwapchainD3D11 DepthSwapchain;
+
+        DynamicResolutionController ResolutionController;
+        GpuFrameTimer RenderTimer;
     };
     std::unordered_map<XrViewConfigurationType, ViewConfigComponent> m_viewConfigComponents;
     XrViewConfigurationType m_defaultViewConfigurationType;
@@ -55,6 +55,7 @@ namespace {
 Scene::Scene(SceneContext& sceneContext)
     : m_sceneContext(sceneContext)
     , m_actionContext(sceneContext.Instance.Handle) {
+    m_staticBatch.State = SceneObjectState::Initialized;
 }
 
 void Scene::Update(const FrameTime& frameTime) {
@@ -65,6 +66,7 @@ void Scene::Update(const FrameTime& frameTime) {
     AddPendingObjects(&m_sceneObjects, std::move(uninitializedSceneObjects));
     AddPendingObjects(&m_quadLayerObjects, std::move(uninitializedQuadLayerObjects));
 
+    UpdateStaticBatch();
     RemoveDestroyedObjects(&m_sceneObjects);
     RemoveDestroyedObjects(&m_quadLayerObjects);
 
@@ -74,8 +76,63 @@ void Scene::Update(const FrameTime& frameTime) {
     OnUpdate(frameTime);
 }
 
+void Scene::UpdateStaticBatch() {
+    // Static objects are added once, with their world transform at that time. This runs before the removed objects leave the
+    // list, so that their entries leave the batch with them.
+    for (const std::shared_ptr<SceneObject>& object : m_sceneObjects) {
+        const bool batched = object->IsStatic() && object->IsVisible();
+        const auto it = m_staticEntries.find(object.get());
+        if (batched && it == m_staticEntries.end()) {
+            m_staticEntries.emplace(object.get(), object->AddStaticGeometry(m_staticBatch.Batch()));
+        } else if (!batched && it != m_staticEntries.end()) {
+            for (const Pbr::StaticBatch::EntryId entryId : it->second) {
+                m_staticBatch.Batch().Remove(entryId);
+            }
+            m_staticEntries.erase(it);
+        }
+    }
+}
+
 void Scene::Render(const FrameTime& frameTime) {
-    RenderObjects(m_sceneObjects, m_sceneContext);
+    // Each object is rendered once per pass it has content in, ordered by the view-space depth of its origin: front to back in the
+    // opaque pass and back to front in the blended pass. Models also order their own primitives within each pass.
+    const XMMATRIX view = m_sceneContext.PbrResources.GetViewTransform();
+    // The static batch draws the geometry of the batched static objects, which aren't rendered on their own.
+    const uint32_t staticBatchIndex = (uint32_t)m_sceneObjects.size();
+    const auto getObject = [&](uint32_t objectIndex) -> const SceneObject& {
+        return objectIndex == staticBatchIndex ? m_staticBatch : *m_sceneObjects[objectIndex];
+    };
+    m_renderKeys.clear();
+    for (uint32_t objectIndex = 0; objectIndex <= staticBatchIndex; objectIndex++) {
+        const SceneObject& object = getObject(objectIndex);
+        if (!object.IsVisible()) {
+            continue;
+        }
+        if (object.IsStatic()) {
+            if (const auto it = m_staticEntries.find(&object); it != m_staticEntries.end() && !it->second.empty()) {
+                continue;
+            }
+        }
+        const Pbr::DrawPasses passes = object.GetDrawPasses();
+        if (!passes.Any()) {
+            continue;
+        }
+        const float viewDepth = -XMVectorGetZ(XMVector3Transform(object.WorldTransform().r[3], view));
+        if (passes.Opaque) {
+            m_renderKeys.push_back(Pbr::DrawSort::MakeKey(Pbr::DrawPass::Opaque, viewDepth, objectIndex));
+        }
+        if (passes.Blended) {
+            m_renderKeys.push_back(Pbr::DrawSort::MakeKey(Pbr::DrawPass::Blended, viewDepth, objectIndex));
+        }
+    }
+    Pbr::DrawSort::RadixSort(m_renderKeys, m_renderKeysScratch);
+
+    for (uint64_t renderKey : m_renderKeys) {
+        m_sceneContext.PbrResources.SetDrawPass(Pbr::DrawSort::GetPass(renderKey));
+        getObject(Pbr::DrawSort::GetIndex(renderKey)).Render(m_sceneContext);
+    }
+    m_sceneContext.PbrResources.SetDrawPass(std::nullopt);
+
     RenderObjects(m_quadLayerObjects, m_sceneContext);
 
     OnRender(frameTime);
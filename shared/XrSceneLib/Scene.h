@@ -16,11 +16,13 @@
 #pragma once
 
 #include <mutex>
+#include <unordered_map>
 #include <XrUtility/XrActionContext.h>
 
 #include "FrameTime.h"
 #include "SceneContext.h"
 #include "SceneObject.h"
+#include "StaticBatchObject.h"
 #include "QuadLayerObject.h"
 
 struct Scene {
@@ -93,12 +95,20 @@ protected:
     }
 
 private:
+    // Add the geometry of the visible static objects to the static batch, and remove it when they are hidden, removed or no
+    // longer static.
+    void UpdateStaticBatch();
+
     xr::ActionContext m_actionContext;
 
     std::atomic<bool> m_isActive{true};
 
     std::vector<std::shared_ptr<SceneObject>> m_sceneObjects;
     std::vector<std::shared_ptr<QuadLayerObject>> m_quadLayerObjects;
+    StaticBatchObject m_staticBatch; // Rendered with the render key index of m_sceneObjects.size().
+    std::unordered_map<const SceneObject*, std::vector<Pbr::StaticBatch::EntryId>> m_staticEntries;
+    std::vector<uint64_t> m_renderKeys; // Kept with their scratch space to reuse their memory.
+    std::vector<uint64_t> m_renderKeysScratch;
 
     mutable std::mutex m_uninitializedMutex;
     std::vector<std::shared_ptr<SceneObject>> m_uninitializedSceneObjects;
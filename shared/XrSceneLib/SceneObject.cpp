@@ -23,6 +23,16 @@ void SceneObject::Update(const FrameTime& frameTime) {
 void SceneObject::Render(SceneContext& sceneContext) const {
 }
 
+Pbr::DrawPasses SceneObject::GetDrawPasses() const {
+    Pbr::DrawPasses passes;
+    passes.Opaque = true;
+    return passes;
+}
+
+std::vector<Pbr::StaticBatch::EntryId> SceneObject::AddStaticGeometry(Pbr::StaticBatch& batch) const {
+    return {};
+}
+
 DirectX::XMMATRIX SceneObject::LocalTransform() const {
     if (!m_localTransformDirty) {
         return DirectX::XMLoadFloat4x4(&m_localTransform);
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <XrUtility/XrMath.h>
+#include <pbr/PbrStaticBatch.h>
 #include "SceneContext.h"
 #include "FrameTime.h"
 #include "ObjectMotion.h"
@@ -40,6 +41,15 @@ public:
         return State == SceneObjectState::Initialized && m_isVisible && (m_parent ? m_parent->IsVisible() : true);
     }
 
+    // Static objects promise not to move: the scene merges the geometry they offer through AddStaticGeometry into its static
+    // batch, with one draw per material, while they are visible. Objects that stop being static are rendered on their own again.
+    void SetStatic(bool isStatic) {
+        m_isStatic = isStatic;
+    }
+    bool IsStatic() const {
+        return m_isStatic;
+    }
+
     const XrPosef& Pose() const {
         return m_pose;
     }
@@ -60,10 +70,19 @@ public:
     DirectX::XMMATRIX WorldTransform() const;
 
     virtual void Update(const FrameTime& frameTime);
+
+    // Scenes render their objects once per Pbr::DrawPass that GetDrawPasses reports, set on the PBR resources of the context.
+    // Objects draw only their content of that pass. Objects that don't report their passes are rendered once, in the opaque pass.
     virtual void Render(SceneContext& sceneContext) const;
+    virtual Pbr::DrawPasses GetDrawPasses() const;
+
+    // Add the geometry of the object, placed with its world transform, to a static batch, and return the ids of the added
+    // entries. Objects that return none are rendered on their own even when static, which is the default.
+    virtual std::vector<Pbr::StaticBatch::EntryId> AddStaticGeometry(Pbr::StaticBatch& batch) const;
 
 private:
     bool m_isVisible{true};
+    bool m_isStatic{false};
 
     XrPosef m_pose = xr::math::Pose::Identity();
     XrVector3f m_scale = {1, 1, 1};
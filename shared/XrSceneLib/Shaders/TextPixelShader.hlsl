@@ -0,0 +1,23 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+
+#include "TextShared.hlsl"
+
+// The atlas stores glyph coverage.
+float4 main(PSInputText input) : SV_TARGET
+{
+    return PremultipliedColor(input.Color, GlyphAtlas.Sample(GlyphAtlasSampler, input.TexCoord).r);
+}
@@ -0,0 +1,26 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+
+#include "TextShared.hlsl"
+
+// The atlas stores signed distance fields with the glyph edge at 0.5. The edge is antialiased over about one pixel on
+// screen, so glyphs stay sharp at any magnification.
+float4 main(PSInputText input) : SV_TARGET
+{
+    const float distance = GlyphAtlas.Sample(GlyphAtlasSampler, input.TexCoord).r;
+    const float edgeWidth = max(fwidth(distance) * 0.5, 1e-5);
+    return PremultipliedColor(input.Color, smoothstep(0.5 - edgeWidth, 0.5 + edgeWidth, distance));
+}
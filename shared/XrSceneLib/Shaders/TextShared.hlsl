@@ -0,0 +1,32 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+
+struct PSInputText
+{
+    float4 PositionProj : SV_POSITION;
+    float2 TexCoord     : TEXCOORD0;
+    float4 Color        : COLOR0;
+};
+
+Texture2D GlyphAtlas : register(t0);
+SamplerState GlyphAtlasSampler : register(s0);
+
+// Text is blended with premultiplied alpha.
+float4 PremultipliedColor(float4 color, float coverage)
+{
+    const float alpha = color.a * coverage;
+    return float4(color.rgb * alpha, alpha);
+}
@@ -0,0 +1,47 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+
+#include "TextShared.hlsl"
+
+// Shares the scene and model constant buffers bound by the PBR resources.
+cbuffer SceneBuffer : register(b0)
+{
+    float4x4 ViewProjection : packoffset(c0);
+};
+
+cbuffer ModelConstantBuffer : register(b1)
+{
+    float4x4 ModelToWorld : packoffset(c0);
+};
+
+struct VSInputText
+{
+    float3 Position : POSITION;
+    float2 TexCoord : TEXCOORD0;
+    float4 Color    : COLOR0;
+};
+
+PSInputText main(VSInputText input)
+{
+    PSInputText output;
+
+    const float4 positionWorld = mul(float4(input.Position, 1), ModelToWorld);
+    output.PositionProj = mul(positionWorld, ViewProjection);
+    output.TexCoord = input.TexCoord;
+    output.Color = input.Color;
+
+    return output;
+}
@@ -0,0 +1,47 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#include "pch.h"
+#include "StaticBatchObject.h"
+
+using namespace DirectX;
+
+StaticBatchObject::EntryId StaticBatchObject::AddStatic(const Pbr::PrimitiveBuilder& primitiveBuilder,
+                                                        std::shared_ptr<Pbr::Material> material,
+                                                        const XrPosef& pose,
+                                                        const XrVector3f& scale) {
+    const XMMATRIX transform = XMMatrixScalingFromVector(xr::math::LoadXrVector3(scale)) * xr::math::LoadXrPose(pose);
+    return m_batch.Add(primitiveBuilder, std::move(material), transform);
+}
+
+void StaticBatchObject::RemoveStatic(EntryId entryId) {
+    m_batch.Remove(entryId);
+}
+
+void StaticBatchObject::Render(SceneContext& sceneContext) const {
+    if (!IsVisible()) {
+        return;
+    }
+
+    sceneContext.PbrResources.SetShadingMode(Pbr::ShadingMode::Regular);
+    sceneContext.PbrResources.SetFillMode(Pbr::FillMode::Solid);
+    sceneContext.PbrResources.SetModelToWorld(WorldTransform(), sceneContext.DeviceContext.get());
+    sceneContext.PbrResources.Bind(sceneContext.DeviceContext.get());
+    m_batch.Render(sceneContext.PbrResources, sceneContext.DeviceContext.get());
+}
+
+Pbr::DrawPasses StaticBatchObject::GetDrawPasses() const {
+    return m_batch.GetDrawPasses();
+}
@@ -0,0 +1,46 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#pragma once
+
+#include <pbr/PbrStaticBatch.h>
+#include "SceneObject.h"
+#include "SceneContext.h"
+
+// A scene object for geometry that never moves after placement, such as floors, UI frames or room geometry.
+// Static geometry is placed relative to this object, and all geometry sharing a material is drawn with a single draw call.
+class StaticBatchObject : public SceneObject {
+public:
+    using EntryId = Pbr::StaticBatch::EntryId;
+
+    EntryId AddStatic(const Pbr::PrimitiveBuilder& primitiveBuilder,
+                      std::shared_ptr<Pbr::Material> material,
+                      const XrPosef& pose,
+                      const XrVector3f& scale = {1, 1, 1});
+    void RemoveStatic(EntryId entryId);
+
+    const Pbr::StaticBatch& Batch() const {
+        return m_batch;
+    }
+    Pbr::StaticBatch& Batch() {
+        return m_batch;
+    }
+
+    void Render(SceneContext& sceneContext) const override;
+    Pbr::DrawPasses GetDrawPasses() const override;
+
+private:
+    Pbr::StaticBatch m_batch;
+};
@@ -0,0 +1,210 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#include "pch.h"
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+#include "TextLayout.h"
+
+namespace {
+    float AlignmentFactor(TextAlignment alignment) {
+        return alignment == TextAlignment::Leading ? 0.0f : alignment == TextAlignment::Center ? 0.5f : 1.0f;
+    }
+
+    float AlignmentFactor(ParagraphAlignment alignment) {
+        return alignment == ParagraphAlignment::Near ? 0.0f : alignment == ParagraphAlignment::Center ? 0.5f : 1.0f;
+    }
+
+    struct LaidOutGlyph {
+        char32_t Codepoint;
+        float PenX;
+        GlyphMetrics Metrics;
+    };
+
+    struct Line {
+        size_t Begin;
+        size_t End;
+        float Width; // Excluding trailing spaces.
+    };
+} // namespace
+
+std::u32string ToCodepoints(std::wstring_view text) {
+    std::u32string codepoints;
+    codepoints.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        const char32_t unit = static_cast<char32_t>(text[i]);
+        if constexpr (sizeof(wchar_t) == 2) {
+            if (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < text.size()) {
+                const char32_t low = static_cast<char32_t>(text[i + 1]);
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    codepoints.push_back(0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00));
+                    i++;
+                    continue;
+                }
+            }
+            if (unit >= 0xD800 && unit <= 0xDFFF) {
+                codepoints.push_back(0xFFFD);
+                continue;
+            }
+        }
+        codepoints.push_back(unit);
+    }
+    return codepoints;
+}
+
+TextLayoutResult LayoutText(std::u32string_view text,
+                            const FontMetrics& fontMetrics,
+                            const std::function<const GlyphMetrics&(char32_t)>& getGlyph,
+                            const TextLayoutOptions& options) {
+    std::vector<LaidOutGlyph> glyphs;
+    glyphs.reserve(text.size());
+    std::vector<Line> lines;
+
+    const bool wrap = options.WordWrap && options.Width > 0;
+    size_t lineBegin = 0;
+    size_t breakIndex = 0; // First glyph after the last space on the line, 0 if there is none.
+    float penX = 0;
+
+    const auto endLine = [&](size_t end) {
+        float width = 0;
+        for (size_t i = end; i > lineBegin; i--) {
+            if (glyphs[i - 1].Codepoint != U' ') {
+                width = glyphs[i - 1].PenX + glyphs[i - 1].Metrics.Advance;
+                break;
+            }
+        }
+        lines.push_back(Line{lineBegin, end, width});
+        lineBegin = end;
+        breakIndex = 0;
+    };
+
+    for (const char32_t codepoint : text) {
+        if (codepoint == U'\n') {
+            endLine(glyphs.size());
+            penX = 0;
+            continue;
+        }
+        if (codepoint == U'\r') {
+            continue;
+        }
+
+        const GlyphMetrics& metrics = getGlyph(codepoint);
+        if (wrap && codepoint != U' ' && penX + metrics.Advance > options.Width && glyphs.size() > lineBegin) {
+            // Move the word being typed to the next line, or break inside it if it is the only word on the line.
+            const size_t wrapIndex = breakIndex > lineBegin ? breakIndex : glyphs.size();
+            const float shift = wrapIndex < glyphs.size() ? glyphs[wrapIndex].PenX : penX;
+            endLine(wrapIndex);
+            for (size_t i = wrapIndex; i < glyphs.size(); i++) {
+                glyphs[i].PenX -= shift;
+            }
+            penX -= shift;
+        }
+
+        glyphs.push_back(LaidOutGlyph{codepoint, penX, metrics});
+        penX += metrics.Advance;
+        if (codepoint == U' ') {
+            breakIndex = glyphs.size();
+        }
+    }
+    endLine(glyphs.size());
+
+    TextLayoutResult result{};
+    result.LineCount = static_cast<uint32_t>(lines.size());
+
+    const float lineHeight = fontMetrics.LineHeight();
+    const float textHeight = lines.size() * lineHeight - fontMetrics.LineGap;
+    float textWidth = 0;
+    for (const Line& line : lines) {
+        textWidth = std::max(textWidth, line.Width);
+    }
+
+    result.Width = options.Width > 0 ? options.Width : textWidth;
+    result.Height = options.Height > 0 ? options.Height : textHeight;
+
+    const float offsetY = (result.Height - textHeight) * AlignmentFactor(options.VerticalAlignment);
+    result.Glyphs.reserve(glyphs.size());
+    for (size_t lineIndex = 0; lineIndex < lines.size(); lineIndex++) {
+        const Line& line = lines[lineIndex];
+        const float offsetX = (result.Width - line.Width) * AlignmentFactor(options.HorizontalAlignment);
+        const float baseline = offsetY + lineIndex * lineHeight + fontMetrics.Ascent;
+        for (size_t i = line.Begin; i < line.End; i++) {
+            const LaidOutGlyph& glyph = glyphs[i];
+            if (glyph.Metrics.AtlasBounds.Width > 0 && glyph.Metrics.AtlasBounds.Height > 0) {
+                result.Glyphs.push_back(PositionedGlyph{glyph.Codepoint,
+                                                        offsetX + glyph.PenX + glyph.Metrics.BitmapLeft,
+                                                        baseline + glyph.Metrics.BitmapTop,
+                                                        glyph.Metrics.AtlasBounds});
+            }
+        }
+    }
+
+    return result;
+}
+
+std::vector<TextRect> ComputeDirtyRects(const std::vector<TextCluster>& before, const std::vector<TextCluster>& after, float inflate) {
+    const auto clusterLess = [](const TextCluster* a, const TextCluster* b) {
+        return std::tie(a->Bounds.Top, a->Bounds.Left, a->Bounds.Bottom, a->Bounds.Right, a->Text) <
+               std::tie(b->Bounds.Top, b->Bounds.Left, b->Bounds.Bottom, b->Bounds.Right, b->Text);
+    };
+    const auto sortedClusters = [&](const std::vector<TextCluster>& clusters) {
+        std::vector<const TextCluster*> sorted(clusters.size());
+        std::transform(clusters.begin(), clusters.end(), sorted.begin(), [](const TextCluster& cluster) { return &cluster; });
+        std::sort(sorted.begin(), sorted.end(), clusterLess);
+        return sorted;
+    };
+
+    // Clusters present in only one of the layouts are dirty, in their old place to erase them and in their new place to draw them.
+    const std::vector<const TextCluster*> sortedBefore = sortedClusters(before);
+    const std::vector<const TextCluster*> sortedAfter = sortedClusters(after);
+    std::vector<const TextCluster*> changed;
+    std::set_symmetric_difference(
+        sortedBefore.begin(), sortedBefore.end(), sortedAfter.begin(), sortedAfter.end(), std::back_inserter(changed), clusterLess);
+
+    std::vector<TextRect> dirtyRects;
+    dirtyRects.reserve(changed.size());
+    for (const TextCluster* cluster : changed) {
+        dirtyRects.push_back(TextRect{cluster->Bounds.Left - inflate,
+                                      cluster->Bounds.Top - inflate,
+                                      cluster->Bounds.Right + inflate,
+                                      cluster->Bounds.Bottom + inflate});
+    }
+
+    // Merge until no two rectangles overlap, and join the rectangles of each line into one span.
+    const auto shouldMerge = [](const TextRect& a, const TextRect& b) {
+        const bool sameLine = a.Top == b.Top && a.Bottom == b.Bottom;
+        const bool intersect = a.Left < b.Right && b.Left < a.Right && a.Top < b.Bottom && b.Top < a.Bottom;
+        return sameLine || intersect;
+    };
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t i = 0; i < dirtyRects.size(); i++) {
+            for (size_t j = i + 1; j < dirtyRects.size(); j++) {
+                if (shouldMerge(dirtyRects[i], dirtyRects[j])) {
+                    TextRect& rect = dirtyRects[i];
+                    rect.Left = std::min(rect.Left, dirtyRects[j].Left);
+                    rect.Top = std::min(rect.Top, dirtyRects[j].Top);
+                    rect.Right = std::max(rect.Right, dirtyRects[j].Right);
+                    rect.Bottom = std::max(rect.Bottom, dirtyRects[j].Bottom);
+                    dirtyRects.erase(dirtyRects.begin() + j);
+                    merged = true;
+                    j = i;
+                }
+            }
+        }
+    }
+
+    return dirtyRects;
+}
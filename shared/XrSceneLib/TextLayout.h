@@ -0,0 +1,96 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "GlyphAtlas.h"
+
+enum class TextAlignment { Leading, Center, Trailing };
+enum class ParagraphAlignment { Near, Center, Far };
+
+// Font metrics in pixels.
+struct FontMetrics {
+    float Ascent;
+    float Descent;
+    float LineGap;
+
+    float LineHeight() const {
+        return Ascent + Descent + LineGap;
+    }
+};
+
+// Metrics of a rasterized glyph in pixels. The bitmap offset is relative to the pen position on the baseline, Y pointing down.
+struct GlyphMetrics {
+    float Advance;
+    int32_t BitmapLeft;
+    int32_t BitmapTop;
+    AtlasRect AtlasBounds; // Empty for glyphs without a bitmap, e.g. spaces.
+};
+
+struct TextLayoutOptions {
+    float Width = 0;  // Layout box width in pixels. 0 disables word wrapping and alignment is relative to the widest line.
+    float Height = 0; // Layout box height in pixels. 0 sizes the box to the text.
+    TextAlignment HorizontalAlignment = TextAlignment::Center;
+    ParagraphAlignment VerticalAlignment = ParagraphAlignment::Center;
+    bool WordWrap = true;
+};
+
+// A glyph bitmap placed in the layout box, in pixels from the top left corner of the box.
+struct PositionedGlyph {
+    char32_t Codepoint;
+    float X;
+    float Y;
+    AtlasRect AtlasBounds;
+};
+
+struct TextLayoutResult {
+    std::vector<PositionedGlyph> Glyphs; // Only glyphs with a bitmap.
+    float Width;  // Layout box size, as given or measured.
+    float Height;
+    uint32_t LineCount;
+};
+
+// Convert UTF-16 (or UTF-32 where wchar_t is 32 bits) to code points. Unpaired surrogates become U+FFFD.
+std::u32string ToCodepoints(std::wstring_view text);
+
+// Lay out text on lines broken at newlines and, when wrapping, at spaces or anywhere in words longer than the box width.
+// getGlyph is called for each code point and must return its metrics. This function has no graphics dependency.
+TextLayoutResult LayoutText(std::u32string_view text,
+                            const FontMetrics& fontMetrics,
+                            const std::function<const GlyphMetrics&(char32_t)>& getGlyph,
+                            const TextLayoutOptions& options);
+
+struct TextRect {
+    float Left;
+    float Top;
+    float Right;
+    float Bottom;
+};
+
+// A laid out character cluster, identified by its characters and its box.
+struct TextCluster {
+    std::wstring Text;
+    TextRect Bounds;
+};
+
+// Returns the areas to redraw when a layout changes from before to after: the boxes of clusters that were added, removed,
+// changed or moved, grown by inflate to cover ink overhanging the boxes. Boxes overlapping each other or on the same line
+// are merged. Returns nothing when the layouts have the same clusters. This function has no graphics dependency.
+std::vector<TextRect> ComputeDirtyRects(const std::vector<TextCluster>& before, const std::vector<TextCluster>& after, float inflate);
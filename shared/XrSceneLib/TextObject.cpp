@@ -0,0 +1,138 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#include "pch.h"
+#include <algorithm>
+#include "TextObject.h"
+
+namespace {
+    uint32_t PackColor(const Pbr::RGBAColor& color) {
+        const auto toByte = [](float value) { return (uint32_t)(std::clamp(value, 0.0f, 1.0f) * 255 + 0.5f); };
+        return toByte(color.x) | (toByte(color.y) << 8) | (toByte(color.z) << 16) | (toByte(color.w) << 24);
+    }
+} // namespace
+
+TextObject::TextObject(std::shared_ptr<TextRenderer> textRenderer, TextObjectInfo info)
+    : m_textRenderer(std::move(textRenderer))
+    , m_info(std::move(info)) {
+}
+
+void TextObject::SetText(std::wstring_view text) {
+    std::u32string codepoints = ToCodepoints(text);
+    if (codepoints != m_text) {
+        m_text = std::move(codepoints);
+        m_verticesDirty = true;
+    }
+}
+
+void TextObject::SetColor(Pbr::RGBAColor color) {
+    m_info.Color = color;
+    m_verticesDirty = true;
+}
+
+void TextObject::UpdateVertices(SceneContext& sceneContext) const {
+    ID3D11DeviceContext* const context = sceneContext.DeviceContext.get();
+    m_textRenderer->PrepareGlyphs(m_text, context);
+
+    // Layout is done in atlas pixels, then scaled to meters.
+    const float metersPerPixel = m_info.FontSize / m_textRenderer->Info().FontSize;
+    TextLayoutOptions options;
+    options.Width = m_info.Width / metersPerPixel;
+    options.Height = m_info.Height / metersPerPixel;
+    options.HorizontalAlignment = m_info.HorizontalAlignment;
+    options.VerticalAlignment = m_info.VerticalAlignment;
+    options.WordWrap = m_info.WordWrap;
+    const TextLayoutResult layout = m_textRenderer->Layout(m_text, options);
+
+    m_quadCount = (uint32_t)layout.Glyphs.size();
+    m_atlasGeneration = m_textRenderer->AtlasGeneration();
+    m_verticesDirty = false;
+    if (m_quadCount == 0) {
+        return;
+    }
+
+    const uint32_t vertexCount = m_quadCount * 4;
+    if (vertexCount > m_vertexCapacity) {
+        // Grow to the next power of two, so that text growing a few characters at a time rarely recreates the buffer.
+        uint32_t capacity = 64;
+        while (capacity < vertexCount) {
+            capacity *= 2;
+        }
+        const CD3D11_BUFFER_DESC bufferDesc(
+            capacity * sizeof(TextVertex), D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+        m_vertexBuffer = nullptr;
+        CHECK_HRCMD(sceneContext.Device->CreateBuffer(&bufferDesc, nullptr, m_vertexBuffer.put()));
+        m_vertexCapacity = capacity;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    CHECK_HRCMD(context->Map(m_vertexBuffer.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+    TextVertex* vertex = static_cast<TextVertex*>(mapped.pData);
+
+    const TextRendererInfo& rendererInfo = m_textRenderer->Info();
+    const float texelWidth = 1.0f / rendererInfo.AtlasWidth;
+    const float texelHeight = 1.0f / rendererInfo.AtlasHeight;
+    const uint32_t color = PackColor(m_info.Color);
+    for (const PositionedGlyph& glyph : layout.Glyphs) {
+        // Layout coordinates have Y down from the top left of the box; the object is centered on the box with Y up.
+        const float left = (glyph.X - layout.Width * 0.5f) * metersPerPixel;
+        const float right = left + glyph.AtlasBounds.Width * metersPerPixel;
+        const float top = (layout.Height * 0.5f - glyph.Y) * metersPerPixel;
+        const float bottom = top - glyph.AtlasBounds.Height * metersPerPixel;
+        const float u0 = glyph.AtlasBounds.X * texelWidth;
+        const float u1 = (glyph.AtlasBounds.X + glyph.AtlasBounds.Width) * texelWidth;
+        const float v0 = glyph.AtlasBounds.Y * texelHeight;
+        const float v1 = (glyph.AtlasBounds.Y + glyph.AtlasBounds.Height) * texelHeight;
+
+        *vertex++ = {{left, top, 0}, {u0, v0}, color};
+        *vertex++ = {{right, top, 0}, {u1, v0}, color};
+        *vertex++ = {{left, bottom, 0}, {u0, v1}, color};
+        *vertex++ = {{right, bottom, 0}, {u1, v1}, color};
+    }
+
+    context->Unmap(m_vertexBuffer.get(), 0);
+}
+
+Pbr::DrawPasses TextObject::GetDrawPasses() const {
+    Pbr::DrawPasses passes;
+    passes.Blended = !m_text.empty();
+    return passes;
+}
+
+void TextObject::Render(SceneContext& sceneContext) const {
+    // Glyphs are blended over what is behind them, so text is only drawn in the blended pass.
+    if (!IsVisible() || m_text.empty() || sceneContext.PbrResources.GetDrawPass() == Pbr::DrawPass::Opaque) {
+        return;
+    }
+
+    // Glyphs evicted from a full atlas by another text invalidate this text's quads.
+    if (m_verticesDirty || m_atlasGeneration != m_textRenderer->AtlasGeneration()) {
+        UpdateVertices(sceneContext);
+    }
+    if (m_quadCount == 0) {
+        return;
+    }
+
+    ID3D11DeviceContext* const context = sceneContext.DeviceContext.get();
+    sceneContext.PbrResources.SetModelToWorld(WorldTransform(), context);
+    sceneContext.PbrResources.Bind(context);
+    m_textRenderer->Bind(context, sceneContext.PbrResources.GetDepthFuncReversed());
+
+    ID3D11Buffer* const vertexBuffers[] = {m_vertexBuffer.get()};
+    const UINT strides[] = {sizeof(TextVertex)};
+    const UINT offsets[] = {0};
+    context->IASetVertexBuffers(0, 1, vertexBuffers, strides, offsets);
+    m_textRenderer->DrawQuads(context, m_quadCount);
+}
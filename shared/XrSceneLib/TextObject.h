@@ -0,0 +1,61 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#pragma once
+
+#include <pbr/PbrCommon.h>
+#include "Scene.h"
+#include "SceneContext.h"
+#include "TextRenderer.h"
+
+struct TextObjectInfo {
+    float FontSize = 0.02f; // Em size in meters.
+    float Width = 0;        // Layout box size in meters, centered on the object. 0 sizes the box to the text.
+    float Height = 0;
+    Pbr::RGBAColor Color = Pbr::RGBA::White;
+    TextAlignment HorizontalAlignment = TextAlignment::Center;
+    ParagraphAlignment VerticalAlignment = ParagraphAlignment::Center;
+    bool WordWrap = true;
+};
+
+// A scene object drawing a string with a shared glyph atlas. The text lies in the XY plane, reading along +X with +Y up.
+// Changing the text only rebuilds this object's quads, and glyphs are rasterized only the first time they are used.
+class TextObject : public SceneObject {
+public:
+    TextObject(std::shared_ptr<TextRenderer> textRenderer, TextObjectInfo info = {});
+
+    void SetText(std::wstring_view text);
+    void SetColor(Pbr::RGBAColor color);
+
+    void Render(SceneContext& sceneContext) const override;
+    Pbr::DrawPasses GetDrawPasses() const override;
+
+private:
+    void UpdateVertices(SceneContext& sceneContext) const;
+
+    const std::shared_ptr<TextRenderer> m_textRenderer;
+    TextObjectInfo m_info;
+    std::u32string m_text;
+
+    mutable bool m_verticesDirty{true};
+    mutable uint32_t m_atlasGeneration{0};
+    mutable uint32_t m_quadCount{0};
+    mutable uint32_t m_vertexCapacity{0};
+    mutable winrt::com_ptr<ID3D11Buffer> m_vertexBuffer;
+};
+
+inline std::shared_ptr<TextObject> CreateTextObject(std::shared_ptr<TextRenderer> textRenderer, TextObjectInfo info = {}) {
+    return std::make_shared<TextObject>(std::move(textRenderer), std::move(info));
+}
@@ -0,0 +1,280 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#include "pch.h"
+#include <algorithm>
+#include "SceneContext.h"
+#include "TextRenderer.h"
+
+#include <TextVertexShader.h>
+#include <TextPixelShader.h>
+#include <TextSdfPixelShader.h>
+
+namespace {
+    // Quads are indexed with 16-bit indices, so larger draws are split into batches using a base vertex.
+    constexpr uint32_t MaxQuadsPerBatch = 65536 / 4;
+
+    const D3D11_INPUT_ELEMENT_DESC TextVertexDesc[] = {
+        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+    };
+
+    winrt::com_ptr<IDWriteFontFace> CreateFontFace(IDWriteFactory2* dwriteFactory, const wchar_t* fontName) {
+        winrt::com_ptr<IDWriteFontCollection> fontCollection;
+        CHECK_HRCMD(dwriteFactory->GetSystemFontCollection(fontCollection.put()));
+
+        UINT32 familyIndex = 0;
+        BOOL exists = FALSE;
+        CHECK_HRCMD(fontCollection->FindFamilyName(fontName, &familyIndex, &exists));
+        if (!exists) {
+            throw std::runtime_error(fmt::format("Font family {} not found", xr::wide_to_utf8(fontName)));
+        }
+
+        winrt::com_ptr<IDWriteFontFamily> fontFamily;
+        CHECK_HRCMD(fontCollection->GetFontFamily(familyIndex, fontFamily.put()));
+
+        winrt::com_ptr<IDWriteFont> font;
+        CHECK_HRCMD(fontFamily->GetFirstMatchingFont(
+            DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STRETCH_NORMAL, DWRITE_FONT_STYLE_NORMAL, font.put()));
+
+        winrt::com_ptr<IDWriteFontFace> fontFace;
+        CHECK_HRCMD(font->CreateFontFace(fontFace.put()));
+        return fontFace;
+    }
+
+    // Returns 8-bit coverage of the glyph run within bounds, or an empty vector if the glyph has no visible pixels.
+    std::vector<uint8_t> RasterizeCoverage(IDWriteGlyphRunAnalysis* analysis, RECT* bounds) {
+        // Grayscale antialiased analyses provide a 1x1 texture. Otherwise fall back to averaging the ClearType subpixels.
+        CHECK_HRCMD(analysis->GetAlphaTextureBounds(DWRITE_TEXTURE_ALIASED_1x1, bounds));
+        if (bounds->right > bounds->left && bounds->bottom > bounds->top) {
+            std::vector<uint8_t> coverage((size_t)(bounds->right - bounds->left) * (bounds->bottom - bounds->top));
+            CHECK_HRCMD(analysis->CreateAlphaTexture(DWRITE_TEXTURE_ALIASED_1x1, bounds, coverage.data(), (UINT32)coverage.size()));
+            return coverage;
+        }
+
+        CHECK_HRCMD(analysis->GetAlphaTextureBounds(DWRITE_TEXTURE_CLEARTYPE_3x1, bounds));
+        if (bounds->right <= bounds->left || bounds->bottom <= bounds->top) {
+            return {};
+        }
+
+        std::vector<uint8_t> coverage((size_t)(bounds->right - bounds->left) * (bounds->bottom - bounds->top));
+        std::vector<uint8_t> subpixels(coverage.size() * 3);
+        CHECK_HRCMD(analysis->CreateAlphaTexture(DWRITE_TEXTURE_CLEARTYPE_3x1, bounds, subpixels.data(), (UINT32)subpixels.size()));
+        for (size_t i = 0; i < coverage.size(); i++) {
+            coverage[i] = (uint8_t)((subpixels[i * 3] + subpixels[i * 3 + 1] + subpixels[i * 3 + 2] + 1) / 3);
+        }
+        return coverage;
+    }
+} // namespace
+
+TextRenderer::TextRenderer(SceneContext& sceneContext, TextRendererInfo info)
+    : m_info(std::move(info))
+    , m_packer(m_info.AtlasWidth, m_info.AtlasHeight) {
+    ID3D11Device* const device = sceneContext.Device.get();
+
+    CHECK_HRCMD(DWriteCreateFactory(
+        DWRITE_FACTORY_TYPE_SHARED, winrt::guid_of<IDWriteFactory2>(), reinterpret_cast<IUnknown**>(m_dwriteFactory.put_void())));
+    m_fontFace = CreateFontFace(m_dwriteFactory.get(), m_info.FontName);
+
+    DWRITE_FONT_METRICS designMetrics;
+    m_fontFace->GetMetrics(&designMetrics);
+    m_designUnitScale = m_info.FontSize / designMetrics.designUnitsPerEm;
+    m_fontMetrics.Ascent = designMetrics.ascent * m_designUnitScale;
+    m_fontMetrics.Descent = designMetrics.descent * m_designUnitScale;
+    m_fontMetrics.LineGap = designMetrics.lineGap * m_designUnitScale;
+
+    const CD3D11_TEXTURE2D_DESC atlasDesc(DXGI_FORMAT_R8_UNORM, m_info.AtlasWidth, m_info.AtlasHeight, 1, 1);
+    CHECK_HRCMD(device->CreateTexture2D(&atlasDesc, nullptr, m_atlasTexture.put()));
+    CHECK_HRCMD(device->CreateShaderResourceView(m_atlasTexture.get(), nullptr, m_atlasView.put()));
+
+    std::vector<uint16_t> quadIndices(MaxQuadsPerBatch * 6);
+    for (uint32_t quad = 0; quad < MaxQuadsPerBatch; quad++) {
+        const uint16_t firstVertex = (uint16_t)(quad * 4);
+        uint16_t* const indices = &quadIndices[quad * 6];
+        indices[0] = firstVertex;
+        indices[1] = firstVertex + 1;
+        indices[2] = firstVertex + 2;
+        indices[3] = firstVertex + 2;
+        indices[4] = firstVertex + 1;
+        indices[5] = firstVertex + 3;
+    }
+    const CD3D11_BUFFER_DESC indexBufferDesc((UINT)(quadIndices.size() * sizeof(uint16_t)), D3D11_BIND_INDEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+    const D3D11_SUBRESOURCE_DATA indexData{quadIndices.data()};
+    CHECK_HRCMD(device->CreateBuffer(&indexBufferDesc, &indexData, m_quadIndexBuffer.put()));
+
+    CHECK_HRCMD(device->CreateVertexShader(g_TextVertexShader, sizeof(g_TextVertexShader), nullptr, m_vertexShader.put()));
+    CHECK_HRCMD(device->CreateInputLayout(
+        TextVertexDesc, (UINT)std::size(TextVertexDesc), g_TextVertexShader, sizeof(g_TextVertexShader), m_inputLayout.put()));
+    if (m_info.SignedDistanceField) {
+        CHECK_HRCMD(device->CreatePixelShader(g_TextSdfPixelShader, sizeof(g_TextSdfPixelShader), nullptr, m_pixelShader.put()));
+    } else {
+        CHECK_HRCMD(device->CreatePixelShader(g_TextPixelShader, sizeof(g_TextPixelShader), nullptr, m_pixelShader.put()));
+    }
+
+    CD3D11_SAMPLER_DESC samplerDesc(D3D11_DEFAULT);
+    CHECK_HRCMD(device->CreateSamplerState(&samplerDesc, m_sampler.put()));
+
+    // Text is blended with premultiplied alpha.
+    CD3D11_BLEND_DESC blendDesc(D3D11_DEFAULT);
+    D3D11_RENDER_TARGET_BLEND_DESC& rtBlendDesc = blendDesc.RenderTarget[0];
+    rtBlendDesc.BlendEnable = TRUE;
+    rtBlendDesc.SrcBlend = D3D11_BLEND_ONE;
+    rtBlendDesc.DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+    rtBlendDesc.SrcBlendAlpha = D3D11_BLEND_ONE;
+    rtBlendDesc.DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+    CHECK_HRCMD(device->CreateBlendState(&blendDesc, m_blendState.put()));
+
+    // Text is visible from both sides.
+    CD3D11_RASTERIZER_DESC rasterizerDesc(D3D11_DEFAULT);
+    rasterizerDesc.CullMode = D3D11_CULL_NONE;
+    CHECK_HRCMD(device->CreateRasterizerState(&rasterizerDesc, m_rasterizerState.put()));
+
+    // Text is tested against depth but doesn't write it, like other blended geometry.
+    for (bool reverseZ : {false, true}) {
+        CD3D11_DEPTH_STENCIL_DESC depthStencilDesc(D3D11_DEFAULT);
+        depthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+        depthStencilDesc.DepthFunc = reverseZ ? D3D11_COMPARISON_GREATER_EQUAL : D3D11_COMPARISON_LESS_EQUAL;
+        CHECK_HRCMD(device->CreateDepthStencilState(&depthStencilDesc, m_depthStencilStates[reverseZ].put()));
+    }
+}
+
+void TextRenderer::PrepareGlyphs(std::u32string_view text, _In_ ID3D11DeviceContext* context) {
+    bool atlasReset = false;
+    for (size_t i = 0; i < text.size(); i++) {
+        const char32_t codepoint = text[i];
+        if (codepoint == U'\n' || m_glyphs.count(codepoint) != 0) {
+            continue;
+        }
+
+        std::optional<GlyphMetrics> glyph = RasterizeGlyph(codepoint, context);
+        if (!glyph) {
+            // The atlas is full. Start over with only the glyphs of this text, which must fit on their own.
+            if (atlasReset) {
+                throw std::runtime_error("Text glyphs don't fit in the glyph atlas");
+            }
+            ResetAtlas();
+            atlasReset = true;
+            i = (size_t)-1;
+            continue;
+        }
+        m_glyphs.emplace(codepoint, *glyph);
+    }
+}
+
+void TextRenderer::ResetAtlas() {
+    m_glyphs.clear();
+    m_packer.Reset();
+    m_atlasGeneration++;
+}
+
+std::optional<GlyphMetrics> TextRenderer::RasterizeGlyph(char32_t codepoint, _In_ ID3D11DeviceContext* context) {
+    const UINT32 codepoint32 = codepoint;
+    UINT16 glyphIndex = 0;
+    CHECK_HRCMD(m_fontFace->GetGlyphIndices(&codepoint32, 1, &glyphIndex));
+
+    DWRITE_GLYPH_METRICS designMetrics;
+    CHECK_HRCMD(m_fontFace->GetDesignGlyphMetrics(&glyphIndex, 1, &designMetrics, FALSE));
+
+    GlyphMetrics glyph{};
+    glyph.Advance = designMetrics.advanceWidth * m_designUnitScale;
+
+    const FLOAT glyphAdvance = 0;
+    const DWRITE_GLYPH_OFFSET glyphOffset{};
+    DWRITE_GLYPH_RUN glyphRun{};
+    glyphRun.fontFace = m_fontFace.get();
+    glyphRun.fontEmSize = m_info.FontSize;
+    glyphRun.glyphCount = 1;
+    glyphRun.glyphIndices = &glyphIndex;
+    glyphRun.glyphAdvances = &glyphAdvance;
+    glyphRun.glyphOffsets = &glyphOffset;
+
+    winrt::com_ptr<IDWriteGlyphRunAnalysis> analysis;
+    CHECK_HRCMD(m_dwriteFactory->CreateGlyphRunAnalysis(&glyphRun,
+                                                        nullptr,
+                                                        DWRITE_RENDERING_MODE_NATURAL_SYMMETRIC,
+                                                        DWRITE_MEASURING_MODE_NATURAL,
+                                                        DWRITE_GRID_FIT_MODE_DEFAULT,
+                                                        DWRITE_TEXT_ANTIALIAS_MODE_GRAYSCALE,
+                                                        0,
+                                                        0,
+                                                        analysis.put()));
+
+    RECT bounds{};
+    std::vector<uint8_t> bitmap = RasterizeCoverage(analysis.get(), &bounds);
+    if (bitmap.empty()) {
+        return glyph; // E.g. a space, which only advances the pen.
+    }
+
+    uint32_t width = bounds.right - bounds.left;
+    uint32_t height = bounds.bottom - bounds.top;
+    int32_t padding = 0;
+    if (m_info.SignedDistanceField) {
+        // Pad the bitmap so the distance field can fall off to zero around the glyph.
+        padding = (int32_t)m_info.SdfSpread;
+        const uint32_t paddedWidth = width + padding * 2;
+        const uint32_t paddedHeight = height + padding * 2;
+        std::vector<uint8_t> padded((size_t)paddedWidth * paddedHeight);
+        for (uint32_t y = 0; y < height; y++) {
+            std::copy_n(&bitmap[(size_t)y * width], width, &padded[(size_t)(y + padding) * paddedWidth + padding]);
+        }
+        bitmap = GenerateSignedDistanceField(padded.data(), paddedWidth, paddedHeight, m_info.SdfSpread);
+        width = paddedWidth;
+        height = paddedHeight;
+    }
+
+    // Leave a one texel gutter so bilinear filtering doesn't bleed neighbouring glyphs in.
+    const std::optional<AtlasRect> allocation = m_packer.Allocate(width + 1, height + 1);
+    if (!allocation) {
+        return std::nullopt;
+    }
+
+    const D3D11_BOX box{allocation->X, allocation->Y, 0, allocation->X + width, allocation->Y + height, 1};
+    context->UpdateSubresource(m_atlasTexture.get(), 0, &box, bitmap.data(), width, 0);
+
+    glyph.BitmapLeft = bounds.left - padding;
+    glyph.BitmapTop = bounds.top - padding;
+    glyph.AtlasBounds = {allocation->X, allocation->Y, width, height};
+    return glyph;
+}
+
+TextLayoutResult TextRenderer::Layout(std::u32string_view text, const TextLayoutOptions& options) const {
+    const auto getGlyph = [this](char32_t codepoint) -> const GlyphMetrics& { return m_glyphs.at(codepoint); };
+    return LayoutText(text, m_fontMetrics, getGlyph, options);
+}
+
+void TextRenderer::Bind(_In_ ID3D11DeviceContext* context, bool reverseZ) const {
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context->IASetInputLayout(m_inputLayout.get());
+    context->IASetIndexBuffer(m_quadIndexBuffer.get(), DXGI_FORMAT_R16_UINT, 0);
+    context->VSSetShader(m_vertexShader.get(), nullptr, 0);
+    context->PSSetShader(m_pixelShader.get(), nullptr, 0);
+
+    ID3D11ShaderResourceView* const shaderResources[] = {m_atlasView.get()};
+    context->PSSetShaderResources(0, (UINT)std::size(shaderResources), shaderResources);
+    ID3D11SamplerState* const samplers[] = {m_sampler.get()};
+    context->PSSetSamplers(0, (UINT)std::size(samplers), samplers);
+
+    context->OMSetBlendState(m_blendState.get(), nullptr, 0xFFFFFFFF);
+    context->OMSetDepthStencilState(m_depthStencilStates[reverseZ].get(), 0);
+    context->RSSetState(m_rasterizerState.get());
+}
+
+void TextRenderer::DrawQuads(_In_ ID3D11DeviceContext* context, uint32_t quadCount) const {
+    for (uint32_t firstQuad = 0; firstQuad < quadCount; firstQuad += MaxQuadsPerBatch) {
+        const uint32_t batchQuads = std::min(quadCount - firstQuad, MaxQuadsPerBatch);
+        context->DrawIndexed(batchQuads * 6, 0, firstQuad * 4);
+    }
+}
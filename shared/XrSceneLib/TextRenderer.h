@@ -0,0 +1,93 @@
+//*********************************************************
+//    Copyright (c) Microsoft. All rights reserved.
+//
+//    Apache 2.0 License
+//
+//    You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+//    implied. See the License for the specific language governing
+//    permissions and limitations under the License.
+//
+//*********************************************************
+#pragma once
+
+#include <dwrite_2.h>
+#include <string_view>
+#include <unordered_map>
+#include "TextLayout.h"
+
+struct SceneContext;
+
+struct TextRendererInfo {
+    const wchar_t* FontName = L"Segoe UI";
+    float FontSize = 48;          // Rasterization size in pixels.
+    uint32_t AtlasWidth = 1024;   // The atlas is a single R8 texture.
+    uint32_t AtlasHeight = 1024;
+    bool SignedDistanceField = false; // Store distance fields instead of coverage, so that glyphs stay sharp when magnified.
+    uint32_t SdfSpread = 4;           // Distance range in texels stored in the distance field.
+};
+
+struct TextVertex {
+    DirectX::XMFLOAT3 Position;
+    DirectX::XMFLOAT2 TexCoord;
+    uint32_t Color; // RGBA8, linear.
+};
+
+// Rasterizes glyphs of one font once into a shared atlas texture, and draws text quads with a dedicated shader.
+// Text objects lay out their strings with this renderer and keep their quads in their own vertex buffers.
+// Must only be used on the render thread.
+class TextRenderer {
+public:
+    TextRenderer(SceneContext& sceneContext, TextRendererInfo info = {});
+
+    const TextRendererInfo& Info() const {
+        return m_info;
+    }
+
+    // Rasterize the glyphs of the text that aren't in the atlas yet. If the atlas runs out of space it is cleared and its
+    // generation changes, which invalidates all layouts made before.
+    void PrepareGlyphs(std::u32string_view text, _In_ ID3D11DeviceContext* context);
+
+    // Lay out text whose glyphs were prepared for the current atlas generation.
+    TextLayoutResult Layout(std::u32string_view text, const TextLayoutOptions& options) const;
+
+    uint32_t AtlasGeneration() const {
+        return m_atlasGeneration;
+    }
+
+    // Bind the text shaders, atlas and states. The PBR resources must be bound before, as their scene and model constant
+    // buffers supply the view projection and model to world transforms.
+    void Bind(_In_ ID3D11DeviceContext* context, bool reverseZ) const;
+
+    // Draw quads from the bound vertex buffer, four vertices per quad.
+    void DrawQuads(_In_ ID3D11DeviceContext* context, uint32_t quadCount) const;
+
+private:
+    std::optional<GlyphMetrics> RasterizeGlyph(char32_t codepoint, _In_ ID3D11DeviceContext* context);
+    void ResetAtlas();
+
+    const TextRendererInfo m_info;
+    winrt::com_ptr<IDWriteFactory2> m_dwriteFactory;
+    winrt::com_ptr<IDWriteFontFace> m_fontFace;
+    FontMetrics m_fontMetrics{};
+    float m_designUnitScale{1};
+
+    SkylinePacker m_packer;
+    std::unordered_map<char32_t, GlyphMetrics> m_glyphs;
+    uint32_t m_atlasGeneration{0};
+
+    winrt::com_ptr<ID3D11Texture2D> m_atlasTexture;
+    winrt::com_ptr<ID3D11ShaderResourceView> m_atlasView;
+    winrt::com_ptr<ID3D11Buffer> m_quadIndexBuffer;
+    winrt::com_ptr<ID3D11VertexShader> m_vertexShader;
+    winrt::com_ptr<ID3D11PixelShader> m_pixelShader;
+    winrt::com_ptr<ID3D11InputLayout> m_inputLayout;
+    winrt::com_ptr<ID3D11SamplerState> m_sampler;
+    winrt::com_ptr<ID3D11BlendState> m_blendState;
+    winrt::com_ptr<ID3D11RasterizerState> m_rasterizerState;
+    winrt::com_ptr<ID3D11DepthStencilState> m_depthStencilStates[2]; // Indexed by reverseZ.
+};
@@ -14,6 +14,8 @@
 //
 //*********************************************************
 #include "pch.h"
+#include <algorithm>
+#include <cmath>
 #include <pbr/PbrMaterial.h>
 #include "TextTexture.h"
 
@@ -83,30 +85,90 @@ TextTexture::TextTexture(SceneContext& sceneContext, TextTextureInfo textInfo)
 }
 
 void TextTexture::Draw(const wchar_t* text) {
-    m_d2dContext->SaveDrawingState(m_stateBlock.get());
+    const std::wstring_view newText = text ? text : L"";
+    if (m_drawn && newText == m_text) {
+        return;
+    }
 
     const D2D1_SIZE_F renderTargetSize = m_d2dContext->GetSize();
-    m_d2dContext->BeginDraw();
-
-    const auto& background = m_textInfo.Background;
-    m_d2dContext->Clear(D2D1::ColorF(background.x, background.y, background.z, background.w));
-
-    const UINT32 textLength = text ? static_cast<UINT32>(wcslen(text)) : 0;
-    if (textLength > 0) {
-        const auto& margin = m_textInfo.Margin;
-        m_d2dContext->DrawText(text,
-                               textLength,
-                               m_textFormat.get(),
-                               D2D1::RectF(m_textInfo.Margin,
-                                           m_textInfo.Margin,
-                                           renderTargetSize.width - m_textInfo.Margin * 2,
-                                           renderTargetSize.height - m_textInfo.Margin * 2),
-                               m_brush.get());
+    const auto& margin = m_textInfo.Margin;
+    const D2D1_RECT_F layoutRect =
+        D2D1::RectF(margin, margin, renderTargetSize.width - margin * 2, renderTargetSize.height - margin * 2);
+
+    winrt::com_ptr<IDWriteTextLayout> textLayout;
+    CHECK_HRCMD(m_dwriteFactory->CreateTextLayout(newText.data(),
+                                                  static_cast<UINT32>(newText.size()),
+                                                  m_textFormat.get(),
+                                                  std::max(layoutRect.right - layoutRect.left, 0.0f),
+                                                  std::max(layoutRect.bottom - layoutRect.top, 0.0f),
+                                                  textLayout.put()));
+    std::vector<TextCluster> clusters = GetClusters(textLayout.get(), newText);
+
+    // Glyph ink can extend past the cluster boxes, e.g. for italics, so the dirty areas are grown by part of the font size.
+    std::vector<TextRect> dirtyRects;
+    if (m_drawn) {
+        dirtyRects = ComputeDirtyRects(m_clusters, clusters, m_textInfo.FontSize / 4);
+    } else {
+        dirtyRects.push_back(TextRect{0, 0, renderTargetSize.width, renderTargetSize.height});
+    }
+
+    if (!dirtyRects.empty()) {
+        m_d2dContext->SaveDrawingState(m_stateBlock.get());
+        m_d2dContext->BeginDraw();
+
+        const auto& background = m_textInfo.Background;
+        for (const TextRect& dirtyRect : dirtyRects) {
+            // Snap the clip to whole pixels so that aliased clipping covers partially dirty pixels.
+            const D2D1_RECT_F clipRect = D2D1::RectF(std::max(std::floor(dirtyRect.Left), 0.0f),
+                                                     std::max(std::floor(dirtyRect.Top), 0.0f),
+                                                     std::min(std::ceil(dirtyRect.Right), renderTargetSize.width),
+                                                     std::min(std::ceil(dirtyRect.Bottom), renderTargetSize.height));
+            m_d2dContext->PushAxisAlignedClip(clipRect, D2D1_ANTIALIAS_MODE_ALIASED);
+            m_d2dContext->Clear(D2D1::ColorF(background.x, background.y, background.z, background.w));
+            if (!newText.empty()) {
+                m_d2dContext->DrawTextLayout(D2D1::Point2F(layoutRect.left, layoutRect.top), textLayout.get(), m_brush.get());
+            }
+            m_d2dContext->PopAxisAlignedClip();
+        }
+
+        m_d2dContext->EndDraw();
+        m_d2dContext->RestoreDrawingState(m_stateBlock.get());
     }
 
-    m_d2dContext->EndDraw();
+    m_drawn = true;
+    m_text = newText;
+    m_clusters = std::move(clusters);
+}
+
+std::vector<TextCluster> TextTexture::GetClusters(IDWriteTextLayout* textLayout, std::wstring_view text) const {
+    UINT32 clusterCount = 0;
+    const HRESULT hr = textLayout->GetClusterMetrics(nullptr, 0, &clusterCount);
+    if (hr != E_NOT_SUFFICIENT_BUFFER) {
+        CHECK_HRCMD(hr);
+    }
+    std::vector<DWRITE_CLUSTER_METRICS> clusterMetrics(clusterCount);
+    CHECK_HRCMD(textLayout->GetClusterMetrics(clusterMetrics.data(), clusterCount, &clusterCount));
+
+    // Cluster boxes are relative to the layout origin, which is offset by the margin in the texture.
+    const float margin = m_textInfo.Margin;
+    std::vector<TextCluster> clusters;
+    clusters.reserve(clusterCount);
+    UINT32 textPosition = 0;
+    for (const DWRITE_CLUSTER_METRICS& metrics : clusterMetrics) {
+        if (!metrics.isWhitespace && !metrics.isNewline) {
+            FLOAT x, y;
+            DWRITE_HIT_TEST_METRICS hitTest;
+            CHECK_HRCMD(textLayout->HitTestTextPosition(textPosition, FALSE, &x, &y, &hitTest));
+            clusters.push_back(TextCluster{std::wstring{text.substr(textPosition, metrics.length)},
+                                           TextRect{margin + hitTest.left,
+                                                    margin + hitTest.top,
+                                                    margin + hitTest.left + hitTest.width,
+                                                    margin + hitTest.top + hitTest.height}});
+        }
+        textPosition += metrics.length;
+    }
 
-    m_d2dContext->RestoreDrawingState(m_stateBlock.get());
+    return clusters;
 }
 
 ID3D11Texture2D* TextTexture::Texture() const {
@@ -21,6 +21,7 @@
 
 #include "pbr/PbrMaterial.h"
 #include "SceneContext.h"
+#include "TextLayout.h"
 
 struct TextTextureInfo {
     TextTextureInfo(uint32_t width, uint32_t height)
@@ -44,11 +45,15 @@ class TextTexture {
 public:
     TextTexture(SceneContext& sceneContext, TextTextureInfo textInfo);
 
+    // Draw the text, keeping its laid out clusters for the next draw. Only the areas where the text changed are redrawn, and drawing
+    // the same text again does nothing.
     void Draw(const wchar_t* text);
     ID3D11Texture2D* Texture() const;
     std::shared_ptr<Pbr::Material> CreatePbrMaterial(const Pbr::Resources& pbrResources) const;
 
 private:
+    std::vector<TextCluster> GetClusters(IDWriteTextLayout* textLayout, std::wstring_view text) const;
+
     const TextTextureInfo m_textInfo;
     winrt::com_ptr<ID2D1Factory2> m_d2dFactory;
     winrt::com_ptr<ID2D1Device1> m_d2dDevice;
@@ -59,4 +64,8 @@ private:
     winrt::com_ptr<IDWriteFactory2> m_dwriteFactory;
     winrt::com_ptr<IDWriteTextFormat> m_textFormat;
     winrt::com_ptr<ID3D11Texture2D> m_textDWriteTexture;
+
+    bool m_drawn{false};
+    std::wstring m_text;
+    std::vector<TextCluster> m_clusters;
 };
@@ -23,6 +23,7 @@ namespace xr {
     struct ExtensionContext : xr::ExtensionDispatchTable {
         bool SupportsD3D11;
         bool SupportsD3D12;
+        bool SupportsVulkan2;
         bool SupportsDepthInfo;
         bool SupportsVisibilityMask;
         bool SupportsUnboundedSpace;
@@ -64,6 +65,9 @@ namespace xr {
 #endif
 #ifdef XR_USE_GRAPHICS_API_D3D12
         extensions.SupportsD3D12 = isExtensionEnabled(XR_KHR_D3D12_ENABLE_EXTENSION_NAME);
+#endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+        extensions.SupportsVulkan2 = isExtensionEnabled(XR_KHR_VULKAN_ENABLE2_EXTENSION_NAME);
 #endif
         extensions.SupportsDepthInfo = isExtensionEnabled(XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME);
         extensions.SupportsVisibilityMask = isExtensionEnabled(XR_KHR_VISIBILITY_MASK_EXTENSION_NAME);
@@ -2,6 +2,7 @@
 // Copyright (C) Microsoft Corporation.  All Rights Reserved
 // Licensed under the MIT License. See License.txt in the project root for license information.
 #include "pch.h"
+#include <algorithm>
 #include <stdexcept>
 #define TINYGLTF_USE_RAPIDJSON
 #define TINYGLTF_USE_RAPIDJSON_CRTALLOCATOR
@@ -109,6 +110,30 @@ namespace
     template<> float ReadNormalizedFloat<float>(const uint8_t* ptr) { return *reinterpret_cast<const float*>(ptr); }
     template<> float ReadNormalizedFloat<uint16_t>(const uint8_t* ptr) { return *reinterpret_cast<const uint16_t*>(ptr) / (float)std::numeric_limits<uint16_t>::max(); }
     template<> float ReadNormalizedFloat<uint8_t>(const uint8_t* ptr) { return *reinterpret_cast<const uint8_t*>(ptr) / (float)std::numeric_limits<uint8_t>::max(); }
+    // Animated rotations can also be normalized signed short or byte, where the lowest value maps to -1 like the one above it.
+    template<> float ReadNormalizedFloat<int16_t>(const uint8_t* ptr) { return std::max(*reinterpret_cast<const int16_t*>(ptr) / (float)std::numeric_limits<int16_t>::max(), -1.0f); }
+    template<> float ReadNormalizedFloat<int8_t>(const uint8_t* ptr) { return std::max(*reinterpret_cast<const int8_t*>(ptr) / (float)std::numeric_limits<int8_t>::max(), -1.0f); }
+
+    // Reads the VEC3 or VEC4 output of an animation sampler into XMFLOAT4 values, leaving w at 0 for VEC3.
+    template <typename TComponentType>
+    void ReadAnimationValues(const tinygltf::Accessor& accessor, const tinygltf::BufferView& bufferView, const tinygltf::Buffer& buffer, std::vector<XMFLOAT4>& values)
+    {
+        const size_t componentCount = accessor.type == TINYGLTF_TYPE_VEC4 ? 4 : 3;
+        const size_t PackedSize = sizeof(TComponentType) * componentCount;
+        const size_t stride = bufferView.byteStride == 0 ? PackedSize : bufferView.byteStride;
+        ValidateAccessor(accessor, bufferView, buffer, stride, PackedSize);
+
+        values.resize(accessor.count);
+        const uint8_t* bufferPtr = buffer.data.data() + bufferView.byteOffset + accessor.byteOffset;
+        for (size_t i = 0; i < accessor.count; i++, bufferPtr += stride)
+        {
+            float* value = &values[i].x;
+            for (size_t component = 0; component < componentCount; component++)
+            {
+                value[component] = ReadNormalizedFloat<TComponentType>(bufferPtr + sizeof(TComponentType) * component);
+            }
+        }
+    }
 
     // Convert array of 16 doubles to an XMMATRIX.
     XMMATRIX XM_CALLCONV Double4x4ToXMMatrix(FXMMATRIX defaultMatrix, const std::vector<double>& doubleData)
@@ -346,6 +371,78 @@ namespace
         }
     }
 
+    // Reads the joint indices (VEC4) of a skinned glTF primitive into a GltfHelper Primitive.
+    // This function uses a template type to express the VEC4 component type (byte or ushort).
+    template <typename TComponentType>
+    void ReadJointsToVertexField(const tinygltf::Accessor& accessor, const tinygltf::BufferView& bufferView, const tinygltf::Buffer& buffer, GltfHelper::Primitive& primitive)
+    {
+        // If stride is not specified, it is tightly packed.
+        constexpr size_t PackedSize = sizeof(TComponentType) * 4;
+        const size_t stride = bufferView.byteStride == 0 ? PackedSize : bufferView.byteStride;
+        ValidateAccessor(accessor, bufferView, buffer, stride, PackedSize);
+
+        // Resize the vertices vector, if necessary, to include room for the attribute data.
+        // If there are multiple attributes for a primitive, the first one will resize, and the subsequent will not need to.
+        primitive.Vertices.resize(accessor.count);
+
+        // Copy the attribute value over from the glTF buffer into the appropriate vertex field.
+        const uint8_t* bufferPtr = buffer.data.data() + bufferView.byteOffset + accessor.byteOffset;
+        for (size_t i = 0; i < accessor.count; i++, bufferPtr += stride)
+        {
+            const TComponentType* joints = reinterpret_cast<const TComponentType*>(bufferPtr);
+            primitive.Vertices[i].Joints0 = XMUINT4(joints[0], joints[1], joints[2], joints[3]);
+        }
+    }
+
+    // Reads the joint indices (VEC4) of a skinned glTF primitive into a GltfHelper Primitive.
+    void ReadJointsToVertexField(const tinygltf::Accessor& accessor, const tinygltf::BufferView& bufferView, const tinygltf::Buffer& buffer, GltfHelper::Primitive& primitive)
+    {
+        if (accessor.type != TINYGLTF_TYPE_VEC4)
+        {
+            throw std::exception("Accessor for primitive JOINTS_0 must have VEC4 type.");
+        }
+
+        if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+        {
+            ReadJointsToVertexField<uint8_t>(accessor, bufferView, buffer, primitive);
+        }
+        else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+        {
+            ReadJointsToVertexField<uint16_t>(accessor, bufferView, buffer, primitive);
+        }
+        else
+        {
+            throw std::exception("Accessor for JOINTS_0 uses unsupported component type.");
+        }
+    }
+
+    // Reads the joint weights (VEC4) of a skinned glTF primitive into a GltfHelper Primitive.
+    void ReadWeightsToVertexField(const tinygltf::Accessor& accessor, const tinygltf::BufferView& bufferView, const tinygltf::Buffer& buffer, GltfHelper::Primitive& primitive)
+    {
+        if (accessor.type != TINYGLTF_TYPE_VEC4)
+        {
+            throw std::exception("Accessor for primitive WEIGHTS_0 must have VEC4 type.");
+        }
+
+        // Weights are stored like colors, as floats or normalized integers.
+        if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+        {
+            ReadColorToVertexField<float, &GltfHelper::Vertex::Weights0>(4, accessor, bufferView, buffer, primitive);
+        }
+        else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE && accessor.normalized)
+        {
+            ReadColorToVertexField<uint8_t, &GltfHelper::Vertex::Weights0>(4, accessor, bufferView, buffer, primitive);
+        }
+        else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT && accessor.normalized)
+        {
+            ReadColorToVertexField<uint16_t, &GltfHelper::Vertex::Weights0>(4, accessor, bufferView, buffer, primitive);
+        }
+        else
+        {
+            throw std::exception("Accessor for WEIGHTS_0 uses unsupported component type.");
+        }
+    }
+
     // Load a primitive's (vertex) attributes. Vertex attributes can be positions, normals, tangents, texture coordinates, colors, and more.
     void XM_CALLCONV LoadAttributeAccessor(const tinygltf::Model& gltfModel, const std::string& attributeName, int accessorId, GltfHelper::Primitive& primitive)
     {
@@ -386,6 +483,14 @@ namespace
         {
             ReadColorToVertexField<&GltfHelper::Vertex::Color0>(accessor, bufferView, buffer, primitive);
         }
+        else if (attributeName.compare("JOINTS_0") == 0)
+        {
+            ReadJointsToVertexField(accessor, bufferView, buffer, primitive);
+        }
+        else if (attributeName.compare("WEIGHTS_0") == 0)
+        {
+            ReadWeightsToVertexField(accessor, bufferView, buffer, primitive);
+        }
         else
         {
             return; // Ignore unsupported vertex accessors like TEXCOORD_1.
@@ -537,9 +642,172 @@ namespace GltfHelper
             }
         }
 
+        // Only vertices with both joints and weights are skinned.
+        primitive.Skinned = gltfPrimitive.attributes.find("JOINTS_0") != std::end(gltfPrimitive.attributes) &&
+                            gltfPrimitive.attributes.find("WEIGHTS_0") != std::end(gltfPrimitive.attributes);
+
         return primitive;
     }
 
+    Skin ReadSkin(const tinygltf::Model& gltfModel, const tinygltf::Skin& gltfSkin)
+    {
+        Skin skin;
+        skin.JointNodes = gltfSkin.joints;
+
+        XMFLOAT4X4 identity;
+        XMStoreFloat4x4(&identity, XMMatrixIdentity());
+        skin.InverseBindMatrices.resize(skin.JointNodes.size(), identity);
+
+        if (gltfSkin.inverseBindMatrices != -1)
+        {
+            const tinygltf::Accessor& accessor = gltfModel.accessors.at(gltfSkin.inverseBindMatrices);
+            if (accessor.type != TINYGLTF_TYPE_MAT4 || accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+            {
+                throw std::exception("Accessor for inverse bind matrices must have MAT4 type and FLOAT component type.");
+            }
+            if (accessor.count < skin.JointNodes.size() || accessor.bufferView == -1)
+            {
+                throw std::exception("Accessor for inverse bind matrices has too few matrices.");
+            }
+
+            const tinygltf::BufferView& bufferView = gltfModel.bufferViews.at(accessor.bufferView);
+            const tinygltf::Buffer& buffer = gltfModel.buffers.at(bufferView.buffer);
+            constexpr size_t PackedSize = sizeof(XMFLOAT4X4);
+            const size_t stride = bufferView.byteStride == 0 ? PackedSize : bufferView.byteStride;
+            ValidateAccessor(accessor, bufferView, buffer, stride, PackedSize);
+
+            // glTF matrices are column-major for column vectors, which is the same memory layout as the row-major
+            // matrices for row vectors that DirectXMath uses.
+            const uint8_t* bufferPtr = buffer.data.data() + bufferView.byteOffset + accessor.byteOffset;
+            for (size_t i = 0; i < skin.JointNodes.size(); i++, bufferPtr += stride)
+            {
+                skin.InverseBindMatrices[i] = *reinterpret_cast<const XMFLOAT4X4*>(bufferPtr);
+            }
+        }
+
+        return skin;
+    }
+
+    Animation ReadAnimation(const tinygltf::Model& gltfModel, const tinygltf::Animation& gltfAnimation)
+    {
+        Animation animation;
+        animation.Name = gltfAnimation.name;
+
+        for (const tinygltf::AnimationChannel& gltfChannel : gltfAnimation.channels)
+        {
+            AnimationChannel channel;
+            if (gltfChannel.target_path == "translation")
+            {
+                channel.Path = AnimationPath::Translation;
+            }
+            else if (gltfChannel.target_path == "rotation")
+            {
+                channel.Path = AnimationPath::Rotation;
+            }
+            else if (gltfChannel.target_path == "scale")
+            {
+                channel.Path = AnimationPath::Scale;
+            }
+            else
+            {
+                continue; // Morph target weights.
+            }
+
+            if (gltfChannel.target_node == -1)
+            {
+                continue; // Channels without a target node are only used by extensions.
+            }
+            channel.TargetNode = gltfChannel.target_node;
+
+            const tinygltf::AnimationSampler& gltfSampler = gltfAnimation.samplers.at(gltfChannel.sampler);
+            if (gltfSampler.interpolation == "STEP")
+            {
+                channel.Interpolation = AnimationInterpolation::Step;
+            }
+            else if (gltfSampler.interpolation == "CUBICSPLINE")
+            {
+                channel.Interpolation = AnimationInterpolation::CubicSpline;
+            }
+            else
+            {
+                channel.Interpolation = AnimationInterpolation::Linear;
+            }
+
+            // Read the key times.
+            {
+                const tinygltf::Accessor& accessor = gltfModel.accessors.at(gltfSampler.input);
+                if (accessor.type != TINYGLTF_TYPE_SCALAR || accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+                {
+                    throw std::exception("Accessor for animation sampler input must have SCALAR type and FLOAT component type.");
+                }
+                if (accessor.count == 0 || accessor.bufferView == -1)
+                {
+                    throw std::exception("Accessor for animation sampler input has no keys.");
+                }
+
+                const tinygltf::BufferView& bufferView = gltfModel.bufferViews.at(accessor.bufferView);
+                const tinygltf::Buffer& buffer = gltfModel.buffers.at(bufferView.buffer);
+                constexpr size_t PackedSize = sizeof(float);
+                const size_t stride = bufferView.byteStride == 0 ? PackedSize : bufferView.byteStride;
+                ValidateAccessor(accessor, bufferView, buffer, stride, PackedSize);
+
+                channel.Times.resize(accessor.count);
+                const uint8_t* bufferPtr = buffer.data.data() + bufferView.byteOffset + accessor.byteOffset;
+                for (size_t i = 0; i < accessor.count; i++, bufferPtr += stride)
+                {
+                    channel.Times[i] = *reinterpret_cast<const float*>(bufferPtr);
+                }
+            }
+
+            // Read the key values. Only rotations can be normalized integers, which must be signed or unsigned short or byte.
+            {
+                const tinygltf::Accessor& accessor = gltfModel.accessors.at(gltfSampler.output);
+                const int expectedType = channel.Path == AnimationPath::Rotation ? TINYGLTF_TYPE_VEC4 : TINYGLTF_TYPE_VEC3;
+                if (accessor.type != expectedType)
+                {
+                    throw std::exception("Accessor for animation sampler output has incorrect type (VEC4 expected for rotations, VEC3 otherwise).");
+                }
+                const size_t valuesPerKey = channel.Interpolation == AnimationInterpolation::CubicSpline ? 3 : 1;
+                if (accessor.count != channel.Times.size() * valuesPerKey || accessor.bufferView == -1)
+                {
+                    throw std::exception("Accessor for animation sampler output doesn't match the number of keys.");
+                }
+
+                const tinygltf::BufferView& bufferView = gltfModel.bufferViews.at(accessor.bufferView);
+                const tinygltf::Buffer& buffer = gltfModel.buffers.at(bufferView.buffer);
+                const bool rotation = channel.Path == AnimationPath::Rotation;
+                if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+                {
+                    ReadAnimationValues<float>(accessor, bufferView, buffer, channel.Values);
+                }
+                else if (rotation && accessor.normalized && accessor.componentType == TINYGLTF_COMPONENT_TYPE_SHORT)
+                {
+                    ReadAnimationValues<int16_t>(accessor, bufferView, buffer, channel.Values);
+                }
+                else if (rotation && accessor.normalized && accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+                {
+                    ReadAnimationValues<uint16_t>(accessor, bufferView, buffer, channel.Values);
+                }
+                else if (rotation && accessor.normalized && accessor.componentType == TINYGLTF_COMPONENT_TYPE_BYTE)
+                {
+                    ReadAnimationValues<int8_t>(accessor, bufferView, buffer, channel.Values);
+                }
+                else if (rotation && accessor.normalized && accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+                {
+                    ReadAnimationValues<uint8_t>(accessor, bufferView, buffer, channel.Values);
+                }
+                else
+                {
+                    throw std::exception("Accessor for animation sampler output has unsupported component type.");
+                }
+            }
+
+            animation.Channels.push_back(std::move(channel));
+        }
+
+        return animation;
+    }
+
     Material ReadMaterial(const tinygltf::Model& gltfModel, const tinygltf::Material& gltfMaterial)
     {
         // Read an optional VEC4 parameter if available, otherwise use the default.
@@ -591,6 +859,12 @@ namespace GltfHelper
                     texture.Image = &gltfModel.images.at(gltfTexture.source);
                 }
 
+                const auto& basisuIt = gltfTexture.extensions.find("KHR_texture_basisu");
+                if (basisuIt != std::end(gltfTexture.extensions) && basisuIt->second.Has("source"))
+                {
+                    texture.Ktx2Image = &gltfModel.images.at((int)basisuIt->second.Get("source").GetNumberAsInt());
+                }
+
                 if (gltfTexture.sampler != -1)
                 {
                     texture.Sampler = &gltfModel.samplers.at(gltfTexture.sampler);
@@ -644,6 +918,7 @@ namespace GltfHelper
                              alphaMode == "BLEND" ? AlphaMode::Blend : AlphaMode::Opaque;
         material.DoubleSided = readParameterFactorAsBoolean(gltfMaterial.additionalValues, "doubleSided", false);
         material.AlphaCutoff = (float)readParameterFactorAsScalar(gltfMaterial.additionalValues, "alphaCutoff", 0.5f);
+        material.Unlit = gltfMaterial.extensions.find("KHR_materials_unlit") != std::end(gltfMaterial.extensions);
 
         return material;
     }
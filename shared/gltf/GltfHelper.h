@@ -10,6 +10,7 @@
 #include "pch.h"
 
 #include <DirectXMath.h>
+#include <string>
 #include <vector>
 
 namespace tinygltf
@@ -17,6 +18,8 @@ namespace tinygltf
     class Node;
     class Model;
     struct Primitive;
+    struct Skin;
+    struct Animation;
     struct Material;
     struct Image;
     struct Sampler;
@@ -32,6 +35,8 @@ namespace GltfHelper
         DirectX::XMFLOAT4 Tangent;
         DirectX::XMFLOAT2 TexCoord0;
         DirectX::XMFLOAT4 Color0;
+        DirectX::XMUINT4 Joints0;   // Indices into the joints of the skin of the node.
+        DirectX::XMFLOAT4 Weights0;
         // Note: This implementation does not currently support TexCoord1 attributes.
     };
 
@@ -40,6 +45,34 @@ namespace GltfHelper
     {
         std::vector<Vertex> Vertices;
         std::vector<uint32_t> Indices;
+        bool Skinned{false}; // Whether the vertices have joints and weights.
+    };
+
+    // The joints of a skin and the matrices transforming the bind pose of the mesh into the space of each joint.
+    struct Skin
+    {
+        std::vector<int> JointNodes;
+        std::vector<DirectX::XMFLOAT4X4> InverseBindMatrices;
+    };
+
+    enum class AnimationPath { Translation, Rotation, Scale };
+    enum class AnimationInterpolation { Step, Linear, CubicSpline };
+
+    // The keyframes animating one property of a node. Values holds one element per key, or three for cubic splines (in-tangent,
+    // value, out-tangent). Rotations are quaternions, translations and scales have a w of 0.
+    struct AnimationChannel
+    {
+        int TargetNode;
+        AnimationPath Path;
+        AnimationInterpolation Interpolation;
+        std::vector<float> Times;
+        std::vector<DirectX::XMFLOAT4> Values;
+    };
+
+    struct Animation
+    {
+        std::string Name;
+        std::vector<AnimationChannel> Channels;
     };
 
     enum class AlphaMode { Opaque, Mask, Blend };
@@ -50,6 +83,7 @@ namespace GltfHelper
         struct Texture
         {
             const tinygltf::Image* Image;
+            const tinygltf::Image* Ktx2Image; // From KHR_texture_basisu, if present. Image is then an optional fallback.
             const tinygltf::Sampler* Sampler;
         };
 
@@ -70,6 +104,7 @@ namespace GltfHelper
         AlphaMode AlphaMode;
         float AlphaCutoff;
         bool DoubleSided;
+        bool Unlit; // From KHR_materials_unlit.
     };
 
     // Reads the "transform" or "TRS" data for a Node as an XMMATRIX.
@@ -78,6 +113,13 @@ namespace GltfHelper
     // Parses the primitive attributes and indices from the glTF accessors/bufferviews/buffers into a common simplified data structure, the Primitive.
     Primitive ReadPrimitive(const tinygltf::Model& gltfModel, const tinygltf::Primitive& gltfPrimitive);
 
+    // Parses the joints and inverse bind matrices of a skin. Missing inverse bind matrices are identity matrices.
+    Skin ReadSkin(const tinygltf::Model& gltfModel, const tinygltf::Skin& gltfSkin);
+
+    // Parses the channels of an animation and the keyframes of their samplers. Channels animating morph target weights are
+    // skipped, since morph targets aren't supported.
+    Animation ReadAnimation(const tinygltf::Model& gltfModel, const tinygltf::Animation& gltfAnimation);
+
     // Parses the material values into a simplified data structure, the Material.
     Material ReadMaterial(const tinygltf::Model& gltfModel, const tinygltf::Material& gltfMaterial);
 
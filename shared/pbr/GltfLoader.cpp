@@ -2,6 +2,7 @@
 // Copyright (C) Microsoft Corporation.  All Rights Reserved
 // Licensed under the MIT License. See License.txt in the project root for license information.
 #include "pch.h"
+#include <cmath>
 #define TINYGLTF_USE_RAPIDJSON
 #define TINYGLTF_USE_RAPIDJSON_CRTALLOCATOR
 #define TINYGLTF_NO_STB_IMAGE_WRITE
@@ -12,8 +13,81 @@
 using namespace DirectX;
 
 namespace {
+    // Choose the block format for an image bound to the given material slot.
+    Pbr::BlockFormat SelectBlockFormat(Pbr::TextureCompression compression,
+                                       Pbr::ShaderSlots::PSMaterial slot,
+                                       const uint8_t* rgba,
+                                       size_t texelCount) {
+        if (slot == Pbr::ShaderSlots::Normal) {
+            return Pbr::BlockFormat::BC5; // The shader reconstructs Z from X and Y for two-channel normal textures.
+        }
+        if (compression == Pbr::TextureCompression::Quality) {
+            return Pbr::BlockFormat::BC7;
+        }
+
+        // Only base color uses alpha. BC1 has none, so translucent base colors need BC3.
+        if (slot == Pbr::ShaderSlots::BaseColor) {
+            for (size_t i = 0; i < texelCount; i++) {
+                if (rgba[i * 4 + 3] != 255) {
+                    return Pbr::BlockFormat::BC3;
+                }
+            }
+        }
+        return Pbr::BlockFormat::BC1;
+    }
+
+    // Image loader callback for tinygltf. KTX2 images are kept in their encoded form so that their block compressed levels
+    // can be uploaded without a decode and recompress step. Other images are decoded by stb_image.
+    bool LoadImageData(tinygltf::Image* image,
+                       const int imageIndex,
+                       std::string* err,
+                       std::string* warn,
+                       int reqWidth,
+                       int reqHeight,
+                       const unsigned char* bytes,
+                       int size,
+                       void* userData) {
+        if (Pbr::Ktx2::IsKtx2(bytes, size)) {
+            image->image.assign(bytes, bytes + size);
+            image->mimeType = "image/ktx2";
+            return true;
+        }
+
+        return tinygltf::LoadImageData(image, imageIndex, err, warn, reqWidth, reqHeight, bytes, size, userData);
+    }
+
+    bool IsKtx2Image(const tinygltf::Image& image) {
+        return Pbr::Ktx2::IsKtx2(image.image.data(), image.image.size());
+    }
+
+    // Use the KHR_texture_basisu image when it can be read, otherwise the core image. There is no Basis Universal transcoder,
+    // so ETC1S and UASTC images without a core image fall back to the default texture of the slot, as if the texture was
+    // absent, and the material keeps its factors. Other KTX2 images without a fallback are still returned so that loading
+    // them reports why they aren't supported.
+    const tinygltf::Image* SelectImage(const GltfHelper::Material::Texture& texture) {
+        if (texture.Ktx2Image != nullptr) {
+            const std::vector<uint8_t>& data = texture.Ktx2Image->image;
+            if (Pbr::Ktx2::IsSupported(data.data(), data.size())) {
+                return texture.Ktx2Image;
+            }
+            if (texture.Image == nullptr) {
+                return Pbr::Ktx2::IsBasisUniversal(data.data(), data.size()) ? nullptr : texture.Ktx2Image;
+            }
+        }
+        return texture.Image;
+    }
+
     // Create a DirectX texture view from a tinygltf Image.
-    winrt::com_ptr<ID3D11ShaderResourceView> LoadImage(_In_ ID3D11Device* device, const tinygltf::Image& image, bool sRGB) {
+    winrt::com_ptr<ID3D11ShaderResourceView> LoadImage(const Pbr::Resources& pbrResources,
+                                                        const tinygltf::Image& image,
+                                                        Pbr::ShaderSlots::PSMaterial slot,
+                                                        bool sRGB,
+                                                        Pbr::MipFilter mipFilter) {
+        if (IsKtx2Image(image)) {
+            const Pbr::Ktx2Image ktx2Image = Pbr::Ktx2::Read(image.image.data(), image.image.size());
+            return Pbr::Texture::CreateKtx2Texture(pbrResources.GetDevice().get(), ktx2Image, sRGB, mipFilter);
+        }
+
         // First convert the image to RGBA if it isn't already.
         std::vector<uint8_t> tempBuffer;
         const uint8_t* rgbaBuffer = GltfHelper::ReadImageAsRGBA(image, &tempBuffer);
@@ -21,8 +95,20 @@ namespace {
             return nullptr;
         }
 
+        const Pbr::TextureCompression compression = pbrResources.GetTextureCompression();
+        if (compression != Pbr::TextureCompression::None) {
+            const Pbr::BlockFormat blockFormat = SelectBlockFormat(compression, slot, rgbaBuffer, (size_t)image.width * image.height);
+            return pbrResources.CreateCompressedTexture(rgbaBuffer, image.width, image.height, blockFormat, sRGB, mipFilter);
+        }
+
         const DXGI_FORMAT format = sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
-        return Pbr::Texture::CreateTexture(device, rgbaBuffer, image.width * image.height * 4, image.width, image.height, format);
+        return Pbr::Texture::CreateTexture(
+            pbrResources.GetDevice().get(), rgbaBuffer, image.width * image.height * 4, image.width, image.height, format, mipFilter);
+    }
+
+    bool UsesMipmaps(int glMinFilter) {
+        // Unspecified (-1) filters are left to the implementation, which uses mipmapping for the default sampler.
+        return glMinFilter != TINYGLTF_TEXTURE_FILTER_NEAREST && glMinFilter != TINYGLTF_TEXTURE_FILTER_LINEAR;
     }
 
     D3D11_FILTER ConvertFilter(int glMinFilter, int glMagFilter) {
@@ -92,18 +178,47 @@ namespace {
     // which node it corresponds to any appropriate node transformation be happen in the shader.
     using PrimitiveBuilderMap = std::map<int, Pbr::PrimitiveBuilder>;
 
+    // Maps glTF node ids to the indices of the nodes in the Pbr Model.
+    using NodeIndexMap = std::map<int, Pbr::NodeIndex_t>;
+
+    // Convert the joints and weights of a skinned glTF vertex. The joints are offset by the first joint of the skin in the model.
+    Pbr::SkinVertex ConvertSkinVertex(const GltfHelper::Vertex& vertex, uint32_t firstJoint) {
+        Pbr::SkinVertex skinVertex;
+        skinVertex.Joints = {(uint16_t)(firstJoint + vertex.Joints0.x),
+                             (uint16_t)(firstJoint + vertex.Joints0.y),
+                             (uint16_t)(firstJoint + vertex.Joints0.z),
+                             (uint16_t)(firstJoint + vertex.Joints0.w)};
+
+        // Weights should sum to one, but normalize them so that the quantized weights don't scale the vertex.
+        const XMVECTOR weights = XMVectorSaturate(XMLoadFloat4(&vertex.Weights0));
+        const float weightSum = XMVectorGetX(XMVectorSum(weights));
+        XMFLOAT4 normalizedWeights{};
+        if (weightSum > 0) {
+            XMStoreFloat4(&normalizedWeights, XMVectorScale(weights, 65535.0f / weightSum));
+        }
+        skinVertex.Weights = {(uint16_t)std::lround(normalizedWeights.x),
+                              (uint16_t)std::lround(normalizedWeights.y),
+                              (uint16_t)std::lround(normalizedWeights.z),
+                              (uint16_t)std::lround(normalizedWeights.w)};
+        return skinVertex;
+    }
+
     // Load a glTF node from the tinygltf object model. This will process the node's mesh (if specified) and then recursively load the child
-    // nodes too.
+    // nodes too. Skinned meshes use the joints of the node's skin, starting at the skin's entry in firstSkinJoints.
     void XM_CALLCONV LoadNode(Pbr::NodeIndex_t parentNodeIndex,
                               const tinygltf::Model& gltfModel,
                               int nodeId,
+                              const std::vector<uint32_t>& firstSkinJoints,
                               PrimitiveBuilderMap& primitiveBuilderMap,
-                              Pbr::Model& model) {
+                              NodeIndexMap& nodeIndexMap,
+                              Pbr::Model& model,
+                              Pbr::MeshOptimizationStats& meshOptimizationStats) {
         const tinygltf::Node& gltfNode = gltfModel.nodes.at(nodeId);
 
         // Read the local transform for this node and add it into the Pbr Model.
         const XMMATRIX nodeLocalTransform = GltfHelper::ReadNodeLocalTransform(gltfNode);
         const Pbr::NodeIndex_t transformIndex = model.AddNode(nodeLocalTransform, parentNodeIndex, gltfNode.name);
+        nodeIndexMap[nodeId] = transformIndex;
 
         if (gltfNode.mesh != -1) // Load the node's optional mesh when specified.
         {
@@ -122,6 +237,13 @@ namespace {
                 const uint32_t startVertex = (uint32_t)primitiveBuilder.Vertices.size();
                 const uint32_t startIndex = (uint32_t)primitiveBuilder.Indices.size();
 
+                // Skinned vertices ignore the transform of their node and are posed relative to the root by the joints. Once
+                // a builder has skinned vertices, the vertices of other primitives get zero weights so they aren't skinned.
+                const bool skinned = primitive.Skinned && gltfNode.skin != -1;
+                if (skinned || !primitiveBuilder.SkinVertices.empty()) {
+                    primitiveBuilder.SkinVertices.resize(startVertex + primitive.Vertices.size(), Pbr::SkinVertex{});
+                }
+
                 // Convert the GltfHelper vertices into the PBR vertex format.
                 primitiveBuilder.Vertices.resize(startVertex + primitive.Vertices.size());
                 for (size_t i = 0; i < primitive.Vertices.size(); i++) {
@@ -132,9 +254,12 @@ namespace {
                     pbrVertex.Tangent = vertex.Tangent;
                     pbrVertex.Color0 = vertex.Color0;
                     pbrVertex.TexCoord0 = vertex.TexCoord0;
-                    pbrVertex.ModelTransformIndex = transformIndex;
+                    pbrVertex.ModelTransformIndex = skinned ? Pbr::RootNodeIndex : transformIndex;
 
                     primitiveBuilder.Vertices[i + startVertex] = pbrVertex;
+                    if (skinned) {
+                        primitiveBuilder.SkinVertices[i + startVertex] = ConvertSkinVertex(vertex, firstSkinJoints.at(gltfNode.skin));
+                    }
                 }
 
                 // Insert indicies with reverse winding order.
@@ -144,38 +269,139 @@ namespace {
                     primitiveBuilder.Indices[startIndex + i + 1] = startVertex + primitive.Indices[i + 2];
                     primitiveBuilder.Indices[startIndex + i + 2] = startVertex + primitive.Indices[i + 1];
                 }
+
+                // Reorder the glTF primitive for the vertex cache, overdraw and vertex fetch. Its positions share the
+                // node's space, which the overdraw ordering relies on, unlike the merged primitive.
+                meshOptimizationStats += primitiveBuilder.Optimize(startVertex, startIndex);
             }
         }
 
         // Recursively load all children.
         for (const int childNodeId : gltfNode.children) {
-            LoadNode(transformIndex, gltfModel, childNodeId, primitiveBuilderMap, model);
+            LoadNode(transformIndex,
+                     gltfModel,
+                     childNodeId,
+                     firstSkinJoints,
+                     primitiveBuilderMap,
+                     nodeIndexMap,
+                     model,
+                     meshOptimizationStats);
+        }
+    }
+
+    Pbr::AnimationPath ConvertAnimationPath(GltfHelper::AnimationPath path) {
+        switch (path) {
+        case GltfHelper::AnimationPath::Rotation:
+            return Pbr::AnimationPath::Rotation;
+        case GltfHelper::AnimationPath::Scale:
+            return Pbr::AnimationPath::Scale;
+        default:
+            return Pbr::AnimationPath::Translation;
+        }
+    }
+
+    Pbr::AnimationInterpolation ConvertAnimationInterpolation(GltfHelper::AnimationInterpolation interpolation) {
+        switch (interpolation) {
+        case GltfHelper::AnimationInterpolation::Step:
+            return Pbr::AnimationInterpolation::Step;
+        case GltfHelper::AnimationInterpolation::CubicSpline:
+            return Pbr::AnimationInterpolation::CubicSpline;
+        default:
+            return Pbr::AnimationInterpolation::Linear;
         }
     }
 } // namespace
 
 namespace Gltf {
-    std::shared_ptr<Pbr::Model> FromGltfObject(const Pbr::Resources& pbrResources, const tinygltf::Model& gltfModel) {
+    std::shared_ptr<Pbr::Model> FromGltfObject(const Pbr::Resources& pbrResources,
+                                               const tinygltf::Model& gltfModel,
+                                               Pbr::MeshOptimizationStats* meshOptimizationStats,
+                                               std::vector<std::shared_ptr<Pbr::AnimationClip>>* animations) {
         // Start off with an empty Pbr Model.
         auto model = std::make_shared<Pbr::Model>();
 
+        // The joints of all skins are concatenated in the model, in the order of the glTF skins.
+        std::vector<GltfHelper::Skin> skins;
+        std::vector<uint32_t> firstSkinJoints;
+        uint32_t jointCount = 0;
+        for (const tinygltf::Skin& gltfSkin : gltfModel.skins) {
+            skins.push_back(GltfHelper::ReadSkin(gltfModel, gltfSkin));
+            firstSkinJoints.push_back(jointCount);
+            jointCount += (uint32_t)skins.back().JointNodes.size();
+        }
+
         // Read and transform mesh/node data. Primitives with the same material are merged to reduce draw calls.
         PrimitiveBuilderMap primitiveBuilderMap;
+        NodeIndexMap nodeIndexMap;
+        Pbr::MeshOptimizationStats loadedMeshOptimizationStats;
         {
             const int defaultSceneId = (gltfModel.defaultScene == -1) ? 0 : gltfModel.defaultScene;
             const tinygltf::Scene& defaultScene = gltfModel.scenes.at(defaultSceneId);
 
             // Process the root scene nodes. The children will be processed recursively.
             for (const int rootNodeId : defaultScene.nodes) {
-                LoadNode(Pbr::RootNodeIndex, gltfModel, rootNodeId, primitiveBuilderMap, *model);
+                LoadNode(Pbr::RootNodeIndex,
+                         gltfModel,
+                         rootNodeId,
+                         firstSkinJoints,
+                         primitiveBuilderMap,
+                         nodeIndexMap,
+                         *model,
+                         loadedMeshOptimizationStats);
+            }
+        }
+
+        // Add the skins once all joint nodes exist. Joints outside of the default scene stay at the root.
+        for (const GltfHelper::Skin& skin : skins) {
+            std::vector<Pbr::NodeIndex_t> jointNodes(skin.JointNodes.size(), Pbr::RootNodeIndex);
+            for (size_t joint = 0; joint < skin.JointNodes.size(); joint++) {
+                const auto nodeIndex = nodeIndexMap.find(skin.JointNodes[joint]);
+                if (nodeIndex != nodeIndexMap.end()) {
+                    jointNodes[joint] = nodeIndex->second;
+                }
             }
+            model->AddSkin(jointNodes, skin.InverseBindMatrices);
+        }
+
+        // Read the animations. Channels of nodes outside of the default scene are dropped.
+        if (animations) {
+            animations->clear();
+            for (const tinygltf::Animation& gltfAnimation : gltfModel.animations) {
+                const GltfHelper::Animation animation = GltfHelper::ReadAnimation(gltfModel, gltfAnimation);
+
+                auto clip = std::make_shared<Pbr::AnimationClip>();
+                clip->Name = animation.Name;
+                for (const GltfHelper::AnimationChannel& gltfChannel : animation.Channels) {
+                    const auto nodeIndex = nodeIndexMap.find(gltfChannel.TargetNode);
+                    if (nodeIndex == nodeIndexMap.end()) {
+                        continue;
+                    }
+
+                    Pbr::AnimationChannel channel;
+                    channel.TargetNode = nodeIndex->second;
+                    channel.Path = ConvertAnimationPath(gltfChannel.Path);
+                    channel.Interpolation = ConvertAnimationInterpolation(gltfChannel.Interpolation);
+                    channel.Times = gltfChannel.Times;
+                    channel.Values.resize(gltfChannel.Values.size());
+                    for (size_t i = 0; i < gltfChannel.Values.size(); i++) {
+                        XMStoreFloat4A(&channel.Values[i], XMLoadFloat4(&gltfChannel.Values[i]));
+                    }
+                    clip->AddChannel(std::move(channel));
+                }
+                animations->push_back(std::move(clip));
+            }
+        }
+
+        if (meshOptimizationStats) {
+            *meshOptimizationStats = loadedMeshOptimizationStats;
         }
 
         // Load the materials referenced by the primitives
         std::map<int, std::shared_ptr<Pbr::Material>> materialMap;
         {
             // Create D3D cache for reuse of texture views and samplers when possible.
-            using ImageKey = std::tuple<const tinygltf::Image*, bool>; // Item1 is a pointer to the image, Item2 is sRGB.
+            // Item1 is a pointer to the image, Item2 is sRGB, Item3 is whether it is a normal map, which compresses differently.
+            using ImageKey = std::tuple<const tinygltf::Image*, bool, bool>;
             std::map<ImageKey, winrt::com_ptr<ID3D11ShaderResourceView>> imageMap;
             std::map<const tinygltf::Sampler*, winrt::com_ptr<ID3D11SamplerState>> samplerMap;
 
@@ -201,15 +427,18 @@ namespace Gltf {
                                            bool sRGB,
                                            Pbr::RGBAColor defaultRGBA) {
                         // Find or load the image referenced by the texture.
-                        const ImageKey imageKey = std::make_tuple(texture.Image, sRGB);
+                        const tinygltf::Image* image = SelectImage(texture);
+                        const ImageKey imageKey = std::make_tuple(image, sRGB, slot == Pbr::ShaderSlots::Normal);
                         winrt::com_ptr<ID3D11ShaderResourceView> textureView = imageMap[imageKey];
                         if (!textureView) // If not cached, load the image and store it in the texture cache.
                         {
-                            // TODO: Generate mipmaps if sampler's minification filter (minFilter) uses mipmapping.
-                            // TODO: If texture is not power-of-two and (sampler has wrapping=repeat/mirrored_repeat OR minFilter uses
-                            // mipmapping), resize to power-of-two.
-                            textureView = texture.Image != nullptr ? LoadImage(pbrResources.GetDevice().get(), *texture.Image, sRGB)
-                                                                   : pbrResources.CreateSolidColorTexture(defaultRGBA);
+                            // Generate mipmaps unless the sampler's minification filter explicitly doesn't use mipmapping.
+                            // Non-power-of-two textures are not resized; each mip level is rounded down instead.
+                            const bool useMips = texture.Sampler == nullptr || UsesMipmaps(texture.Sampler->minFilter);
+                            const Pbr::MipFilter mipFilter = useMips ? pbrResources.GetMipFilter() : Pbr::MipFilter::None;
+                            textureView = image != nullptr
+                                              ? LoadImage(pbrResources, *image, slot, sRGB, mipFilter)
+                                              : pbrResources.CreateSolidColorTexture(defaultRGBA);
                             imageMap[imageKey] = textureView;
                         }
 
@@ -236,6 +465,7 @@ namespace Gltf {
 
                     pbrMaterial->SetDoubleSided(material.DoubleSided);
                     pbrMaterial->SetAlphaBlended(material.AlphaMode == GltfHelper::AlphaMode::Blend);
+                    pbrMaterial->SetUnlit(material.Unlit);
 
                     Pbr::Material::ConstantBufferData& parameters = pbrMaterial->Parameters();
                     parameters.BaseColorFactor = material.BaseColorFactor;
@@ -264,17 +494,20 @@ namespace Gltf {
 
     std::shared_ptr<Pbr::Model> FromGltfBinary(const Pbr::Resources& pbrResources,
                                                _In_reads_bytes_(bufferBytes) const uint8_t* buffer,
-                                               uint32_t bufferBytes) {
+                                               uint32_t bufferBytes,
+                                               Pbr::MeshOptimizationStats* meshOptimizationStats,
+                                               std::vector<std::shared_ptr<Pbr::AnimationClip>>* animations) {
         // Parse the GLB buffer data into a tinygltf model object.
         tinygltf::Model gltfModel;
         std::string errorMessage;
         tinygltf::TinyGLTF loader;
+        loader.SetImageLoader(LoadImageData, nullptr);
         if (!loader.LoadBinaryFromMemory(&gltfModel, &errorMessage, nullptr /*warn*/, buffer, bufferBytes, ".")) {
             const auto msg =
                 std::string("\r\nFailed to load gltf model (") + std::to_string(bufferBytes) + " bytes). Error: " + errorMessage;
             throw std::exception(msg.c_str());
         }
 
-        return FromGltfObject(pbrResources, gltfModel);
+        return FromGltfObject(pbrResources, gltfModel, meshOptimizationStats, animations);
     }
 } // namespace Gltf
@@ -8,27 +8,38 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "PbrResources.h"
 #include "PbrModel.h"
+#include "PbrAnimation.h"
 
 namespace tinygltf { class Model; }
 
 namespace Gltf
 {
-    // Creates a Pbr Model from tinygltf model.
+    // Creates a Pbr Model from tinygltf model. Meshes are reordered for the vertex cache, overdraw and vertex fetch,
+    // and the cache miss ratios before and after are returned in meshOptimizationStats when given. The glTF animations
+    // are returned in animations when given, as clips that play on the returned model, its clones and its instances.
     std::shared_ptr<Pbr::Model> FromGltfObject(
         const Pbr::Resources& pbrResources,
-        const tinygltf::Model& gltfModel);
+        const tinygltf::Model& gltfModel,
+        Pbr::MeshOptimizationStats* meshOptimizationStats = nullptr,
+        std::vector<std::shared_ptr<Pbr::AnimationClip>>* animations = nullptr);
 
 
     // Creates a Pbr Model from glTF 2.0 GLB file content.
     std::shared_ptr<Pbr::Model> FromGltfBinary(
         const Pbr::Resources& pbrResources,
         _In_reads_bytes_(bufferBytes) const uint8_t* buffer,
-        uint32_t bufferBytes);
+        uint32_t bufferBytes,
+        Pbr::MeshOptimizationStats* meshOptimizationStats = nullptr,
+        std::vector<std::shared_ptr<Pbr::AnimationClip>>* animations = nullptr);
 
     template<typename Container>
-    std::shared_ptr<Pbr::Model> FromGltfBinary(const Pbr::Resources& pbrResources, const Container& buffer) {
-        return FromGltfBinary(pbrResources, buffer.data(), static_cast<uint32_t>(buffer.size()));
+    std::shared_ptr<Pbr::Model> FromGltfBinary(const Pbr::Resources& pbrResources,
+                                               const Container& buffer,
+                                               Pbr::MeshOptimizationStats* meshOptimizationStats = nullptr,
+                                               std::vector<std::shared_ptr<Pbr::AnimationClip>>* animations = nullptr) {
+        return FromGltfBinary(pbrResources, buffer.data(), static_cast<uint32_t>(buffer.size()), meshOptimizationStats, animations);
     }
 }
@@ -0,0 +1,230 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "PbrAnimation.h"
+#include "PbrModel.h"
+#include "PbrModelInstance.h"
+#include "PbrParallel.h"
+
+using namespace DirectX;
+
+namespace {
+    constexpr uint32_t NoPose = ~0u;
+
+    // Players of one batch usually play similar clips, so the tasks are split by the average number of channels.
+    constexpr uint64_t MinChannelsPerTask = 1024;
+
+    // Find the key before the time, starting from the key found by the previous evaluation since playback usually moves by
+    // less than one key per frame. Times outside of the keys are clamped. Returns the fraction of the way to the next key.
+    float FindKey(const std::vector<float>& times, float time, uint32_t& key) {
+        const uint32_t keyCount = (uint32_t)times.size();
+        if (keyCount < 2 || time <= times.front()) {
+            key = 0;
+            return 0.0f;
+        }
+        if (time >= times.back()) {
+            key = keyCount - 2;
+            return 1.0f;
+        }
+
+        if (key >= keyCount - 1 || time < times[key]) {
+            key = (uint32_t)(std::upper_bound(times.begin(), times.end(), time) - times.begin()) - 1;
+        } else if (time >= times[key + 1]) {
+            if (key + 2 < keyCount && time < times[key + 2]) {
+                key++;
+            } else {
+                key = (uint32_t)(std::upper_bound(times.begin() + key + 1, times.end(), time) - times.begin()) - 1;
+            }
+        }
+        return (time - times[key]) / (times[key + 1] - times[key]);
+    }
+
+    XMVECTOR SampleChannel(const Pbr::AnimationChannel& channel, float time, uint32_t& key) {
+        const float t = FindKey(channel.Times, time, key);
+        const XMFLOAT4A* values = channel.Values.data();
+        const bool rotation = channel.Path == Pbr::AnimationPath::Rotation;
+        const bool singleKey = channel.Times.size() < 2;
+
+        switch (channel.Interpolation) {
+        case Pbr::AnimationInterpolation::Step:
+            return XMLoadFloat4A(&values[t < 1.0f ? key : key + 1]);
+
+        case Pbr::AnimationInterpolation::Linear: {
+            if (singleKey) {
+                return XMLoadFloat4A(&values[0]);
+            }
+            const XMVECTOR value0 = XMLoadFloat4A(&values[key]);
+            const XMVECTOR value1 = XMLoadFloat4A(&values[key + 1]);
+            return rotation ? XMQuaternionSlerp(value0, value1, t) : XMVectorLerp(value0, value1, t);
+        }
+
+        case Pbr::AnimationInterpolation::CubicSpline: {
+            if (singleKey) {
+                return XMLoadFloat4A(&values[1]);
+            }
+            // The tangents are per second, the spline is evaluated over the key interval.
+            const float keyDuration = channel.Times[key + 1] - channel.Times[key];
+            const XMVECTOR value0 = XMLoadFloat4A(&values[key * 3 + 1]);
+            const XMVECTOR outTangent0 = XMVectorScale(XMLoadFloat4A(&values[key * 3 + 2]), keyDuration);
+            const XMVECTOR inTangent1 = XMVectorScale(XMLoadFloat4A(&values[key * 3 + 3]), keyDuration);
+            const XMVECTOR value1 = XMLoadFloat4A(&values[key * 3 + 4]);
+            const XMVECTOR value = XMVectorHermite(value0, outTangent0, value1, inTangent1, t);
+            return rotation ? XMQuaternionNormalize(value) : value;
+        }
+
+        default:
+            throw std::exception("Unknown animation interpolation");
+        }
+    }
+} // namespace
+
+namespace Pbr {
+    void AnimationClip::AddChannel(AnimationChannel channel) {
+        if (channel.Times.empty()) {
+            throw std::exception("Animation channels need at least one key");
+        }
+        if (!std::is_sorted(channel.Times.begin(), channel.Times.end())) {
+            throw std::exception("Animation key times must not decrease");
+        }
+        const size_t valuesPerKey = channel.Interpolation == AnimationInterpolation::CubicSpline ? 3 : 1;
+        if (channel.Values.size() != channel.Times.size() * valuesPerKey) {
+            throw std::exception("Animation values don't match the number of keys");
+        }
+
+        m_duration = std::max(m_duration, channel.Times.back());
+        m_channels.push_back(std::move(channel));
+    }
+
+    AnimationPlayer::AnimationPlayer(std::shared_ptr<const AnimationClip> clip, std::shared_ptr<Model> model)
+        : m_clip(std::move(clip))
+        , m_model(std::move(model)) {
+        if (!m_model) {
+            throw std::exception("Animation players need a model");
+        }
+        Initialize();
+    }
+
+    AnimationPlayer::AnimationPlayer(std::shared_ptr<const AnimationClip> clip, std::shared_ptr<ModelInstance> modelInstance)
+        : m_clip(std::move(clip))
+        , m_modelInstance(std::move(modelInstance)) {
+        if (!m_modelInstance) {
+            throw std::exception("Animation players need a model instance");
+        }
+        Initialize();
+    }
+
+    void AnimationPlayer::Initialize() {
+        if (!m_clip) {
+            throw std::exception("Animation players need a clip");
+        }
+
+        const Model& model = m_model ? *m_model : *m_modelInstance->GetModel();
+        std::vector<uint32_t> nodePoses(model.GetNodeCount(), NoPose);
+        for (const AnimationChannel& channel : m_clip->GetChannels()) {
+            if (channel.TargetNode >= model.GetNodeCount()) {
+                throw std::out_of_range("Animation target node out of range");
+            }
+
+            uint32_t& pose = nodePoses[channel.TargetNode];
+            if (pose == NoPose) {
+                pose = (uint32_t)m_animatedNodes.size();
+                m_animatedNodes.push_back(channel.TargetNode);
+            }
+            m_channelPoses.push_back(pose);
+        }
+        m_cachedKeys.resize(m_channelPoses.size(), 0);
+
+        m_restPoses.resize(m_animatedNodes.size());
+        for (size_t i = 0; i < m_animatedNodes.size(); i++) {
+            const NodeIndex_t node = m_animatedNodes[i];
+            const XMMATRIX transform = m_model ? m_model->GetNode(node).GetTransform() : m_modelInstance->GetNodeTransform(node);
+
+            XMVECTOR scale, rotation, translation;
+            if (!XMMatrixDecompose(&scale, &rotation, &translation, transform)) {
+                // Degenerate transforms, e.g. with a zero scale, only keep their translation.
+                scale = XMVectorZero();
+                rotation = XMQuaternionIdentity();
+                translation = transform.r[3];
+            }
+            XMStoreFloat4A(&m_restPoses[i].Translation, translation);
+            XMStoreFloat4A(&m_restPoses[i].Rotation, rotation);
+            XMStoreFloat4A(&m_restPoses[i].Scale, scale);
+        }
+        m_poses = m_restPoses;
+    }
+
+    void AnimationPlayer::SetTime(float seconds) {
+        const float duration = m_clip->GetDuration();
+        if (duration <= 0) {
+            m_time = 0;
+        } else if (Looping) {
+            m_time = std::fmod(seconds, duration);
+            if (m_time < 0) {
+                m_time += duration;
+            }
+        } else {
+            m_time = std::clamp(seconds, 0.0f, duration);
+        }
+    }
+
+    void AnimationPlayer::Advance(float seconds) {
+        SetTime(m_time + seconds);
+    }
+
+    void AnimationPlayer::Apply() {
+        std::copy(m_restPoses.begin(), m_restPoses.end(), m_poses.begin());
+
+        const std::vector<AnimationChannel>& channels = m_clip->GetChannels();
+        for (size_t i = 0; i < channels.size(); i++) {
+            const AnimationChannel& channel = channels[i];
+            const XMVECTOR value = SampleChannel(channel, m_time, m_cachedKeys[i]);
+
+            NodePose& pose = m_poses[m_channelPoses[i]];
+            switch (channel.Path) {
+            case AnimationPath::Translation:
+                XMStoreFloat4A(&pose.Translation, value);
+                break;
+            case AnimationPath::Rotation:
+                XMStoreFloat4A(&pose.Rotation, value);
+                break;
+            case AnimationPath::Scale:
+                XMStoreFloat4A(&pose.Scale, value);
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < m_animatedNodes.size(); i++) {
+            const NodePose& pose = m_poses[i];
+            const XMMATRIX transform = XMMatrixAffineTransformation(
+                XMLoadFloat4A(&pose.Scale), XMVectorZero(), XMLoadFloat4A(&pose.Rotation), XMLoadFloat4A(&pose.Translation));
+            if (m_model) {
+                m_model->GetNode(m_animatedNodes[i]).SetTransform(transform);
+            } else {
+                m_modelInstance->SetNodeTransform(m_animatedNodes[i], transform);
+            }
+        }
+    }
+
+    void UpdateAnimations(const std::vector<AnimationPlayer*>& players, float deltaSeconds) {
+        if (players.empty()) {
+            return;
+        }
+
+        uint64_t channelCount = 0;
+        for (const AnimationPlayer* player : players) {
+            channelCount += player->GetClip()->GetChannels().size();
+        }
+        const uint64_t channelsPerPlayer = std::max<uint64_t>(1, channelCount / players.size());
+
+        Internal::ParallelFor((uint32_t)players.size(), channelsPerPlayer, MinChannelsPerTask, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                players[i]->Advance(deltaSeconds);
+                players[i]->Apply();
+            }
+        });
+    }
+} // namespace Pbr
@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// Keyframe animation of node transforms. Clips hold the keyframes and can be shared by any number of players, which each pose
+// one model or model instance.
+//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+#include "PbrCommon.h"
+
+namespace Pbr {
+    struct Model;
+    struct ModelInstance;
+
+    enum class AnimationPath : uint32_t {
+        Translation,
+        Rotation,
+        Scale,
+    };
+
+    enum class AnimationInterpolation : uint32_t {
+        Step,
+        Linear,      // Rotations are spherically interpolated.
+        CubicSpline, // Hermite splines with an in-tangent and an out-tangent per key.
+    };
+
+    // The keyframes animating one property of a node. Key times are stored apart from the values, which are loaded as whole SIMD
+    // vectors. Values holds one element per key, or three for cubic splines: in-tangent, value, out-tangent. Rotations are
+    // quaternions, translations and scales ignore w.
+    struct AnimationChannel {
+        NodeIndex_t TargetNode{RootNodeIndex};
+        AnimationPath Path{AnimationPath::Translation};
+        AnimationInterpolation Interpolation{AnimationInterpolation::Linear};
+        std::vector<float> Times; // In seconds, increasing.
+        std::vector<DirectX::XMFLOAT4A> Values;
+    };
+
+    // A set of channels played together, such as one glTF animation.
+    struct AnimationClip final {
+        std::string Name;
+
+        // Add a channel, throwing if its times decrease or the number of values doesn't match the number of keys.
+        void AddChannel(AnimationChannel channel);
+
+        const std::vector<AnimationChannel>& GetChannels() const {
+            return m_channels;
+        }
+
+        // Time of the last key of all channels, in seconds.
+        float GetDuration() const {
+            return m_duration;
+        }
+
+    private:
+        std::vector<AnimationChannel> m_channels;
+        float m_duration{0};
+    };
+
+    // Plays a clip on a model or on a model instance. Nodes keep the translation, rotation and scale of the transform they had
+    // when the player was created for the paths the clip doesn't animate.
+    struct AnimationPlayer final {
+        AnimationPlayer(std::shared_ptr<const AnimationClip> clip, std::shared_ptr<Model> model);
+        AnimationPlayer(std::shared_ptr<const AnimationClip> clip, std::shared_ptr<ModelInstance> modelInstance);
+
+        // Whether time wraps around at the end of the clip, or stops at the end. Enabled by default.
+        bool Looping{true};
+
+        // Set or advance the playback time, in seconds.
+        void SetTime(float seconds);
+        void Advance(float seconds);
+        float GetTime() const {
+            return m_time;
+        }
+
+        // Evaluate all channels at the playback time and set the transforms of the animated nodes.
+        void Apply();
+
+        const std::shared_ptr<const AnimationClip>& GetClip() const {
+            return m_clip;
+        }
+
+    private:
+        // Translation, rotation and scale of an animated node.
+        struct NodePose {
+            DirectX::XMFLOAT4A Translation;
+            DirectX::XMFLOAT4A Rotation;
+            DirectX::XMFLOAT4A Scale;
+        };
+
+        void Initialize();
+
+        std::shared_ptr<const AnimationClip> m_clip;
+        std::shared_ptr<Model> m_model;                 // Either the model or the model instance is set.
+        std::shared_ptr<ModelInstance> m_modelInstance;
+        std::vector<NodeIndex_t> m_animatedNodes;       // Each node animated by the clip, once.
+        std::vector<NodePose> m_restPoses;              // Per animated node, the pose when the player was created.
+        std::vector<NodePose> m_poses;                  // Per animated node, the pose being evaluated.
+        std::vector<uint32_t> m_channelPoses;           // Per channel, the index of its node in m_animatedNodes.
+        std::vector<uint32_t> m_cachedKeys;             // Per channel, the key before the time of the last evaluation.
+        float m_time{0};
+    };
+
+    // Advance and apply many players, spread over the system thread pool. Players must not animate the same model or model
+    // instance, since they set node transforms concurrently.
+    void UpdateAnimations(const std::vector<AnimationPlayer*>& players, float deltaSeconds);
+} // namespace Pbr
@@ -0,0 +1,638 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include "PbrBlockCompression.h"
+#include "PbrParallel.h"
+
+namespace {
+    constexpr uint32_t TexelsPerBlock = 16;
+    constexpr uint64_t MinBlocksPerTask = 1024;
+
+    // 16 texels of a block with 4 channels in the 0-255 range.
+    using BlockTexels = std::array<std::array<float, 4>, TexelsPerBlock>;
+
+    void LoadBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, BlockTexels& texels) {
+        for (uint32_t y = 0; y < 4; y++) {
+            const uint32_t sy = std::min(blockY * 4 + y, height - 1);
+            for (uint32_t x = 0; x < 4; x++) {
+                const uint32_t sx = std::min(blockX * 4 + x, width - 1);
+                const uint8_t* texel = &rgba[(static_cast<size_t>(sy) * width + sx) * 4];
+                for (uint32_t c = 0; c < 4; c++) {
+                    texels[y * 4 + x][c] = texel[c];
+                }
+            }
+        }
+    }
+
+    void StoreBlock(const std::array<std::array<uint8_t, 4>, TexelsPerBlock>& texels,
+                    uint8_t* rgba,
+                    uint32_t width,
+                    uint32_t height,
+                    uint32_t blockX,
+                    uint32_t blockY) {
+        for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; y++) {
+            for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; x++) {
+                uint8_t* texel = &rgba[(static_cast<size_t>(blockY * 4 + y) * width + blockX * 4 + x) * 4];
+                std::memcpy(texel, texels[y * 4 + x].data(), 4);
+            }
+        }
+    }
+
+    // Find the line through the texels' first channelCount channels that best fits them (principal axis of the covariance),
+    // and return its extent over the texels as two endpoints.
+    void FitEndpoints(const BlockTexels& texels, uint32_t channelCount, std::array<float, 4>& low, std::array<float, 4>& high) {
+        std::array<float, 4> mean{};
+        for (const auto& texel : texels) {
+            for (uint32_t c = 0; c < channelCount; c++) {
+                mean[c] += texel[c] / TexelsPerBlock;
+            }
+        }
+
+        float covariance[4][4]{};
+        for (const auto& texel : texels) {
+            for (uint32_t i = 0; i < channelCount; i++) {
+                for (uint32_t j = 0; j < channelCount; j++) {
+                    covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+                }
+            }
+        }
+
+        // Power iteration converges to the principal axis quickly for 16 samples.
+        std::array<float, 4> axis{1, 1, 1, 1};
+        for (int iteration = 0; iteration < 8; iteration++) {
+            std::array<float, 4> next{};
+            float lengthSquared = 0;
+            for (uint32_t i = 0; i < channelCount; i++) {
+                for (uint32_t j = 0; j < channelCount; j++) {
+                    next[i] += covariance[i][j] * axis[j];
+                }
+                lengthSquared += next[i] * next[i];
+            }
+            if (lengthSquared < 1e-12f) {
+                break; // Uniform block; any axis works.
+            }
+            const float invLength = 1 / std::sqrt(lengthSquared);
+            for (uint32_t i = 0; i < channelCount; i++) {
+                axis[i] = next[i] * invLength;
+            }
+        }
+
+        float minProjection = std::numeric_limits<float>::max();
+        float maxProjection = std::numeric_limits<float>::lowest();
+        for (const auto& texel : texels) {
+            float projection = 0;
+            for (uint32_t c = 0; c < channelCount; c++) {
+                projection += (texel[c] - mean[c]) * axis[c];
+            }
+            minProjection = std::min(minProjection, projection);
+            maxProjection = std::max(maxProjection, projection);
+        }
+
+        for (uint32_t c = 0; c < channelCount; c++) {
+            low[c] = std::clamp(mean[c] + axis[c] * minProjection, 0.0f, 255.0f);
+            high[c] = std::clamp(mean[c] + axis[c] * maxProjection, 0.0f, 255.0f);
+        }
+    }
+
+    // Position of a texel along the segment from a to b, in [0, 1].
+    float ProjectOnSegment(const std::array<float, 4>& texel, const float* a, const float* b, uint32_t channelCount) {
+        float dot = 0, lengthSquared = 0;
+        for (uint32_t c = 0; c < channelCount; c++) {
+            const float direction = b[c] - a[c];
+            dot += (texel[c] - a[c]) * direction;
+            lengthSquared += direction * direction;
+        }
+        return lengthSquared > 0 ? std::clamp(dot / lengthSquared, 0.0f, 1.0f) : 0.0f;
+    }
+
+    struct BitWriter {
+        uint8_t* Data; // Must be zero initialized.
+        uint32_t Position{0};
+
+        void Write(uint32_t value, uint32_t bitCount) {
+            for (uint32_t i = 0; i < bitCount; i++, Position++) {
+                if ((value >> i) & 1) {
+                    Data[Position >> 3] |= static_cast<uint8_t>(1 << (Position & 7));
+                }
+            }
+        }
+    };
+
+    struct BitReader {
+        const uint8_t* Data;
+        uint32_t Position{0};
+
+        uint32_t Read(uint32_t bitCount) {
+            uint32_t value = 0;
+            for (uint32_t i = 0; i < bitCount; i++, Position++) {
+                value |= ((Data[Position >> 3] >> (Position & 7)) & 1u) << i;
+            }
+            return value;
+        }
+    };
+
+#pragma region BC1
+    uint16_t To565(const float* rgb) {
+        const uint32_t r = static_cast<uint32_t>(rgb[0] * 31 / 255 + 0.5f);
+        const uint32_t g = static_cast<uint32_t>(rgb[1] * 63 / 255 + 0.5f);
+        const uint32_t b = static_cast<uint32_t>(rgb[2] * 31 / 255 + 0.5f);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    std::array<float, 4> From565(uint16_t color) {
+        const uint32_t r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+        return {static_cast<float>((r << 3) | (r >> 2)),
+                static_cast<float>((g << 2) | (g >> 4)),
+                static_cast<float>((b << 3) | (b >> 2)),
+                255.0f};
+    }
+
+    // Encodes the color part of BC1/BC3 in four-color mode.
+    void EncodeColorBlock(const BlockTexels& texels, uint8_t* block) {
+        std::array<float, 4> low{}, high{};
+        FitEndpoints(texels, 3, low, high);
+
+        uint16_t color0 = To565(high.data());
+        uint16_t color1 = To565(low.data());
+        if (color0 < color1) {
+            std::swap(color0, color1);
+        }
+
+        uint32_t indices = 0;
+        if (color0 != color1) {
+            const std::array<float, 4> a = From565(color0);
+            const std::array<float, 4> b = From565(color1);
+            constexpr uint32_t IndexForLevel[4] = {0, 2, 3, 1}; // Palette entries ordered from color0 to color1.
+            for (uint32_t i = 0; i < TexelsPerBlock; i++) {
+                const float t = ProjectOnSegment(texels[i], a.data(), b.data(), 3);
+                indices |= IndexForLevel[static_cast<uint32_t>(t * 3 + 0.5f)] << (i * 2);
+            }
+        }
+
+        std::memcpy(block, &color0, 2);
+        std::memcpy(block + 2, &color1, 2);
+        std::memcpy(block + 4, &indices, 4);
+    }
+
+    void DecodeColorBlock(const uint8_t* block, bool allowThreeColorMode, std::array<std::array<uint8_t, 4>, TexelsPerBlock>& texels) {
+        uint16_t color0, color1;
+        uint32_t indices;
+        std::memcpy(&color0, block, 2);
+        std::memcpy(&color1, block + 2, 2);
+        std::memcpy(&indices, block + 4, 4);
+
+        const std::array<float, 4> a = From565(color0);
+        const std::array<float, 4> b = From565(color1);
+        std::array<std::array<float, 4>, 4> palette{a, b};
+        const bool fourColorMode = color0 > color1 || !allowThreeColorMode;
+        for (uint32_t c = 0; c < 3; c++) {
+            if (fourColorMode) {
+                palette[2][c] = (2 * a[c] + b[c]) / 3;
+                palette[3][c] = (a[c] + 2 * b[c]) / 3;
+            } else {
+                palette[2][c] = (a[c] + b[c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = fourColorMode ? 255.0f : 0.0f;
+
+        for (uint32_t i = 0; i < TexelsPerBlock; i++) {
+            const auto& entry = palette[(indices >> (i * 2)) & 3];
+            for (uint32_t c = 0; c < 4; c++) {
+                texels[i][c] = static_cast<uint8_t>(entry[c] + 0.5f);
+            }
+        }
+    }
+#pragma endregion
+
+#pragma region BC4
+    // Encodes one channel in eight-value mode.
+    void EncodeSingleChannelBlock(const BlockTexels& texels, uint32_t channel, uint8_t* block) {
+        float minValue = 255, maxValue = 0;
+        for (const auto& texel : texels) {
+            minValue = std::min(minValue, texel[channel]);
+            maxValue = std::max(maxValue, texel[channel]);
+        }
+
+        const uint8_t endpoint0 = static_cast<uint8_t>(maxValue + 0.5f);
+        const uint8_t endpoint1 = static_cast<uint8_t>(minValue + 0.5f);
+
+        uint64_t indices = 0;
+        if (endpoint0 != endpoint1) {
+            constexpr uint64_t IndexForLevel[8] = {0, 2, 3, 4, 5, 6, 7, 1}; // Palette entries ordered from endpoint0 to endpoint1.
+            const float range = static_cast<float>(endpoint1) - endpoint0;
+            for (uint32_t i = 0; i < TexelsPerBlock; i++) {
+                const float t = std::clamp((texels[i][channel] - endpoint0) / range, 0.0f, 1.0f);
+                indices |= IndexForLevel[static_cast<uint32_t>(t * 7 + 0.5f)] << (i * 3);
+            }
+        }
+
+        block[0] = endpoint0;
+        block[1] = endpoint1;
+        for (uint32_t i = 0; i < 6; i++) {
+            block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+        }
+    }
+
+    void DecodeSingleChannelBlock(const uint8_t* block, uint32_t channel, std::array<std::array<uint8_t, 4>, TexelsPerBlock>& texels) {
+        const float endpoint0 = block[0], endpoint1 = block[1];
+        std::array<float, 8> palette{endpoint0, endpoint1};
+        if (block[0] > block[1]) {
+            for (uint32_t i = 2; i < 8; i++) {
+                palette[i] = ((8 - i) * endpoint0 + (i - 1) * endpoint1) / 7;
+            }
+        } else {
+            for (uint32_t i = 2; i < 6; i++) {
+                palette[i] = ((6 - i) * endpoint0 + (i - 1) * endpoint1) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for (uint32_t i = 0; i < 6; i++) {
+            indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+        }
+        for (uint32_t i = 0; i < TexelsPerBlock; i++) {
+            texels[i][channel] = static_cast<uint8_t>(palette[(indices >> (i * 3)) & 7] + 0.5f);
+        }
+    }
+#pragma endregion
+
+#pragma region BC7
+    constexpr uint32_t Bc7Weights2[4] = {0, 21, 43, 64};
+    constexpr uint32_t Bc7Weights3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+    constexpr uint32_t Bc7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    // Bit counts of the fields of each BC7 mode.
+    struct Bc7Mode {
+        uint32_t SubsetCount;
+        uint32_t PartitionBits;
+        uint32_t RotationBits;
+        uint32_t IndexSelectionBits;
+        uint32_t ColorBits;
+        uint32_t AlphaBits;
+        bool EndpointPBits; // A p-bit per endpoint.
+        bool SubsetPBits;   // A p-bit per subset, shared by its two endpoints.
+        uint32_t IndexBits;
+        uint32_t SecondaryIndexBits;
+    };
+
+    constexpr Bc7Mode Bc7Modes[8] = {
+        {3, 4, 0, 0, 4, 0, true, false, 3, 0},
+        {2, 6, 0, 0, 6, 0, false, true, 3, 0},
+        {3, 6, 0, 0, 5, 0, false, false, 2, 0},
+        {2, 6, 0, 0, 7, 0, true, false, 2, 0},
+        {1, 0, 2, 1, 5, 6, false, false, 2, 3},
+        {1, 0, 2, 0, 7, 8, false, false, 2, 2},
+        {1, 0, 0, 0, 7, 7, true, false, 4, 0},
+        {2, 6, 0, 0, 5, 5, true, false, 2, 0},
+    };
+
+    // Two subset partitions, with a bit set for each texel of the second subset.
+    constexpr uint16_t Bc7Partitions2[64] = {
+        0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+        0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+        0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+        0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+    };
+
+    // Three subset partitions, with the subset of each texel in two bits.
+    constexpr uint32_t Bc7Partitions3[64] = {
+        0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+        0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+        0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+        0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+        0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+        0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+        0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+        0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254,
+    };
+
+    // The anchor texels of the second subset of two subset partitions, and of the second and third subsets of three subset
+    // partitions. The anchor texels and texel 0 store their indices with one bit less, whose most significant bit is zero.
+    constexpr uint8_t Bc7Anchors2[64] = {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+        15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6, 6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+    };
+    constexpr uint8_t Bc7Anchors3Second[64] = {
+        3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3, 3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+        8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15, 3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3,
+    };
+    constexpr uint8_t Bc7Anchors3Third[64] = {
+        15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8, 15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+        15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8, 15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8,
+    };
+
+    uint32_t GetBc7Subset(uint32_t subsetCount, uint32_t partition, uint32_t texel) {
+        switch (subsetCount) {
+        case 2:
+            return (Bc7Partitions2[partition] >> texel) & 1;
+        case 3:
+            return (Bc7Partitions3[partition] >> (texel * 2)) & 3;
+        default:
+            return 0;
+        }
+    }
+
+    bool IsBc7Anchor(uint32_t subsetCount, uint32_t partition, uint32_t texel) {
+        return texel == 0 || (subsetCount == 2 && texel == Bc7Anchors2[partition]) ||
+               (subsetCount == 3 && (texel == Bc7Anchors3Second[partition] || texel == Bc7Anchors3Third[partition]));
+    }
+
+    const uint32_t* GetBc7Weights(uint32_t indexBits) {
+        return indexBits == 2 ? Bc7Weights2 : indexBits == 3 ? Bc7Weights3 : Bc7Weights4;
+    }
+
+    uint32_t Bc7Interpolate(uint32_t endpoint0, uint32_t endpoint1, uint32_t weight) {
+        return ((64 - weight) * endpoint0 + weight * endpoint1 + 32) >> 6;
+    }
+
+    // Mode 6: one subset, RGBA endpoints with 7 bits per channel plus a unique p-bit per endpoint, 4-bit indices.
+    void EncodeBc7Mode6Block(const BlockTexels& texels, uint8_t* block) {
+        std::array<float, 4> low{}, high{};
+        FitEndpoints(texels, 4, low, high);
+
+        struct Candidate {
+            std::array<uint32_t, 4> Endpoint0, Endpoint1; // Quantized to 7 bits.
+            uint32_t PBit0, PBit1;
+            std::array<uint32_t, TexelsPerBlock> Indices;
+            float Error;
+        };
+
+        Candidate best{};
+        best.Error = std::numeric_limits<float>::max();
+        for (uint32_t pbits = 0; pbits < 4; pbits++) {
+            Candidate candidate{};
+            candidate.PBit0 = pbits & 1;
+            candidate.PBit1 = pbits >> 1;
+
+            float a[4], b[4];
+            for (uint32_t c = 0; c < 4; c++) {
+                candidate.Endpoint0[c] = std::clamp(static_cast<int>((high[c] - candidate.PBit0) / 2 + 0.5f), 0, 127);
+                candidate.Endpoint1[c] = std::clamp(static_cast<int>((low[c] - candidate.PBit1) / 2 + 0.5f), 0, 127);
+                a[c] = static_cast<float>((candidate.Endpoint0[c] << 1) | candidate.PBit0);
+                b[c] = static_cast<float>((candidate.Endpoint1[c] << 1) | candidate.PBit1);
+            }
+
+            for (uint32_t i = 0; i < TexelsPerBlock; i++) {
+                const float t = ProjectOnSegment(texels[i], a, b, 4) * 64;
+                uint32_t index = 0;
+                while (index < 15 && std::abs(Bc7Weights4[index + 1] - t) < std::abs(Bc7Weights4[index] - t)) {
+                    index++;
+                }
+                candidate.Indices[i] = index;
+
+                for (uint32_t c = 0; c < 4; c++) {
+                    const float decoded = static_cast<float>(
+                        Bc7Interpolate(static_cast<uint32_t>(a[c]), static_cast<uint32_t>(b[c]), Bc7Weights4[index]));
+                    candidate.Error += (decoded - texels[i][c]) * (decoded - texels[i][c]);
+                }
+            }
+
+            if (candidate.Error < best.Error) {
+                best = candidate;
+            }
+        }
+
+        // The most significant bit of the first index is implicitly zero; swap the endpoints if needed.
+        if (best.Indices[0] >= 8) {
+            std::swap(best.Endpoint0, best.Endpoint1);
+            std::swap(best.PBit0, best.PBit1);
+            for (uint32_t& index : best.Indices) {
+                index = 15 - index;
+            }
+        }
+
+        std::memset(block, 0, 16);
+        BitWriter writer{block};
+        writer.Write(1 << 6, 7); // Mode 6
+        for (uint32_t c = 0; c < 4; c++) {
+            writer.Write(best.Endpoint0[c], 7);
+            writer.Write(best.Endpoint1[c], 7);
+        }
+        writer.Write(best.PBit0, 1);
+        writer.Write(best.PBit1, 1);
+        writer.Write(best.Indices[0], 3);
+        for (uint32_t i = 1; i < TexelsPerBlock; i++) {
+            writer.Write(best.Indices[i], 4);
+        }
+    }
+
+    // Decode a block of any of the 8 modes (https://learn.microsoft.com/windows/win32/direct3d11/bc7-format-mode-reference).
+    void DecodeBc7Block(const uint8_t* block, std::array<std::array<uint8_t, 4>, TexelsPerBlock>& texels) {
+        // The mode is the number of zero bits before the first set bit. Blocks without a set bit in the first byte are
+        // reserved and decode to transparent black.
+        uint32_t modeIndex = 0;
+        while (modeIndex < 8 && (block[0] & (1 << modeIndex)) == 0) {
+            modeIndex++;
+        }
+        if (modeIndex == 8) {
+            for (auto& texel : texels) {
+                texel = {0, 0, 0, 0};
+            }
+            return;
+        }
+
+        const Bc7Mode& mode = Bc7Modes[modeIndex];
+        BitReader reader{block};
+        reader.Read(modeIndex + 1);
+        const uint32_t partition = reader.Read(mode.PartitionBits);
+        const uint32_t rotation = reader.Read(mode.RotationBits);
+        const uint32_t indexSelection = reader.Read(mode.IndexSelectionBits);
+
+        // Endpoints are stored channel by channel, two per subset.
+        const uint32_t endpointCount = mode.SubsetCount * 2;
+        uint32_t endpoints[6][4] = {};
+        for (uint32_t c = 0; c < 3; c++) {
+            for (uint32_t e = 0; e < endpointCount; e++) {
+                endpoints[e][c] = reader.Read(mode.ColorBits);
+            }
+        }
+        for (uint32_t e = 0; e < endpointCount && mode.AlphaBits > 0; e++) {
+            endpoints[e][3] = reader.Read(mode.AlphaBits);
+        }
+
+        // P-bits add a least significant bit to every channel of the endpoint.
+        uint32_t colorBits = mode.ColorBits, alphaBits = mode.AlphaBits;
+        if (mode.EndpointPBits || mode.SubsetPBits) {
+            uint32_t pbits[6];
+            for (uint32_t e = 0; e < endpointCount; e++) {
+                pbits[e] = mode.EndpointPBits || e % 2 == 0 ? reader.Read(1) : pbits[e - 1];
+            }
+            const uint32_t channelCount = mode.AlphaBits > 0 ? 4 : 3;
+            for (uint32_t e = 0; e < endpointCount; e++) {
+                for (uint32_t c = 0; c < channelCount; c++) {
+                    endpoints[e][c] = (endpoints[e][c] << 1) | pbits[e];
+                }
+            }
+            colorBits++;
+            alphaBits += mode.AlphaBits > 0 ? 1 : 0;
+        }
+
+        // Expand to 8 bits by replicating the most significant bits.
+        for (uint32_t e = 0; e < endpointCount; e++) {
+            for (uint32_t c = 0; c < 4; c++) {
+                const uint32_t bits = c < 3 ? colorBits : alphaBits;
+                endpoints[e][c] = bits == 0 ? 255 : ((endpoints[e][c] << (8 - bits)) | (endpoints[e][c] >> (2 * bits - 8)));
+            }
+        }
+
+        uint32_t indices[TexelsPerBlock], secondaryIndices[TexelsPerBlock] = {};
+        for (uint32_t i = 0; i < TexelsPerBlock; i++) {
+            indices[i] = reader.Read(mode.IndexBits - (IsBc7Anchor(mode.SubsetCount, partition, i) ? 1 : 0));
+        }
+        for (uint32_t i = 0; i < TexelsPerBlock && mode.SecondaryIndexBits > 0; i++) {
+            secondaryIndices[i] = reader.Read(mode.SecondaryIndexBits - (i == 0 ? 1 : 0));
+        }
+
+        // Modes 4 and 5 interpolate alpha with the secondary indices. Mode 4 can swap which set of indices color uses.
+        const bool separateAlpha = mode.SecondaryIndexBits > 0;
+        const uint32_t* colorWeights = GetBc7Weights(indexSelection ? mode.SecondaryIndexBits : mode.IndexBits);
+        const uint32_t* alphaWeights = GetBc7Weights(separateAlpha && !indexSelection ? mode.SecondaryIndexBits : mode.IndexBits);
+        for (uint32_t i = 0; i < TexelsPerBlock; i++) {
+            const uint32_t subset = GetBc7Subset(mode.SubsetCount, partition, i);
+            const uint32_t* endpoint0 = endpoints[subset * 2];
+            const uint32_t* endpoint1 = endpoints[subset * 2 + 1];
+            const uint32_t colorIndex = indexSelection ? secondaryIndices[i] : indices[i];
+            const uint32_t alphaIndex = separateAlpha && !indexSelection ? secondaryIndices[i] : indices[i];
+            for (uint32_t c = 0; c < 3; c++) {
+                texels[i][c] = static_cast<uint8_t>(Bc7Interpolate(endpoint0[c], endpoint1[c], colorWeights[colorIndex]));
+            }
+            texels[i][3] = static_cast<uint8_t>(Bc7Interpolate(endpoint0[3], endpoint1[3], alphaWeights[alphaIndex]));
+
+            // Rotation swaps alpha with red, green or blue after decoding.
+            if (rotation > 0) {
+                std::swap(texels[i][3], texels[i][rotation - 1]);
+            }
+        }
+    }
+#pragma endregion
+
+    void EncodeBlock(const BlockTexels& texels, Pbr::BlockFormat format, uint8_t* block) {
+        switch (format) {
+        case Pbr::BlockFormat::BC1:
+            EncodeColorBlock(texels, block);
+            break;
+        case Pbr::BlockFormat::BC3:
+            EncodeSingleChannelBlock(texels, 3, block);
+            EncodeColorBlock(texels, block + 8);
+            break;
+        case Pbr::BlockFormat::BC4:
+            EncodeSingleChannelBlock(texels, 0, block);
+            break;
+        case Pbr::BlockFormat::BC5:
+            EncodeSingleChannelBlock(texels, 0, block);
+            EncodeSingleChannelBlock(texels, 1, block + 8);
+            break;
+        case Pbr::BlockFormat::BC7:
+            EncodeBc7Mode6Block(texels, block);
+            break;
+        }
+    }
+
+    void DecodeBlock(const uint8_t* block, Pbr::BlockFormat format, std::array<std::array<uint8_t, 4>, TexelsPerBlock>& texels) {
+        for (auto& texel : texels) {
+            texel = {0, 0, 0, 255};
+        }
+
+        switch (format) {
+        case Pbr::BlockFormat::BC1:
+            DecodeColorBlock(block, true, texels);
+            break;
+        case Pbr::BlockFormat::BC3:
+            DecodeColorBlock(block + 8, false, texels);
+            DecodeSingleChannelBlock(block, 3, texels);
+            break;
+        case Pbr::BlockFormat::BC4:
+            DecodeSingleChannelBlock(block, 0, texels);
+            break;
+        case Pbr::BlockFormat::BC5:
+            DecodeSingleChannelBlock(block, 0, texels);
+            DecodeSingleChannelBlock(block + 8, 1, texels);
+            break;
+        case Pbr::BlockFormat::BC7:
+            DecodeBc7Block(block, texels);
+            break;
+        }
+    }
+} // namespace
+
+namespace Pbr {
+    namespace BlockCompression {
+        uint32_t GetBlockByteSize(BlockFormat format) {
+            return (format == BlockFormat::BC1 || format == BlockFormat::BC4) ? 8 : 16;
+        }
+
+        uint32_t GetRowPitch(BlockFormat format, uint32_t width) {
+            return std::max(1u, (width + BlockDimension - 1) / BlockDimension) * GetBlockByteSize(format);
+        }
+
+        std::vector<uint8_t> Compress(const uint8_t* rgba, uint32_t width, uint32_t height, BlockFormat format) {
+            const uint32_t blocksX = std::max(1u, (width + BlockDimension - 1) / BlockDimension);
+            const uint32_t blocksY = std::max(1u, (height + BlockDimension - 1) / BlockDimension);
+            const uint32_t rowPitch = GetRowPitch(format, width);
+
+            std::vector<uint8_t> blocks(static_cast<size_t>(rowPitch) * blocksY);
+            if (width == 0 || height == 0) {
+                return blocks;
+            }
+
+            Internal::ParallelFor(blocksY, blocksX, MinBlocksPerTask, [&](uint32_t rowBegin, uint32_t rowEnd) {
+                BlockTexels texels;
+                for (uint32_t blockY = rowBegin; blockY < rowEnd; blockY++) {
+                    for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+                        LoadBlock(rgba, width, height, blockX, blockY, texels);
+                        EncodeBlock(texels, format, &blocks[static_cast<size_t>(blockY) * rowPitch + blockX * GetBlockByteSize(format)]);
+                    }
+                }
+            });
+
+            return blocks;
+        }
+
+        std::vector<uint8_t> Decompress(const uint8_t* blocks, uint32_t width, uint32_t height, BlockFormat format) {
+            const uint32_t blocksX = std::max(1u, (width + BlockDimension - 1) / BlockDimension);
+            const uint32_t blocksY = std::max(1u, (height + BlockDimension - 1) / BlockDimension);
+            const uint32_t rowPitch = GetRowPitch(format, width);
+
+            std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+            std::array<std::array<uint8_t, 4>, TexelsPerBlock> texels;
+            for (uint32_t blockY = 0; blockY < blocksY; blockY++) {
+                for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+                    DecodeBlock(&blocks[static_cast<size_t>(blockY) * rowPitch + blockX * GetBlockByteSize(format)], format, texels);
+                    StoreBlock(texels, rgba.data(), width, height, blockX, blockY);
+                }
+            }
+
+            return rgba;
+        }
+
+        double ComputePsnr(const uint8_t* expected, const uint8_t* actual, size_t texelCount, uint32_t channelMask) {
+            double squaredError = 0;
+            size_t sampleCount = 0;
+            for (size_t i = 0; i < texelCount; i++) {
+                for (uint32_t c = 0; c < 4; c++) {
+                    if (channelMask & (1u << c)) {
+                        const double difference = static_cast<double>(expected[i * 4 + c]) - actual[i * 4 + c];
+                        squaredError += difference * difference;
+                        sampleCount++;
+                    }
+                }
+            }
+
+            if (squaredError == 0 || sampleCount == 0) {
+                return std::numeric_limits<double>::infinity();
+            }
+            const double meanSquaredError = squaredError / sampleCount;
+            return 10 * std::log10(255.0 * 255.0 / meanSquaredError);
+        }
+    } // namespace BlockCompression
+} // namespace Pbr
@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// CPU block compression (BCn) of 8-bit RGBA images. This code has no graphics API dependency so that it can be used
+// offline, at load time, or to round-trip images for quality measurements.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Pbr {
+    enum class BlockFormat : uint32_t {
+        BC1, // RGB, 8 bytes per block. Alpha is ignored.
+        BC3, // RGBA, 16 bytes per block. BC1 color with a BC4 alpha block.
+        BC4, // R, 8 bytes per block.
+        BC5, // RG, 16 bytes per block. Two BC4 blocks, used for two-channel normal maps.
+        BC7, // RGBA, 16 bytes per block. Only mode 6 (single subset, 7.7.7.7 endpoints with p-bits) is encoded; all modes decode.
+    };
+
+    // Texture compression applied by the loaders.
+    enum class TextureCompression : uint32_t {
+        None,    // Textures are uploaded as 8-bit RGBA.
+        Fast,    // BC1 for opaque color (BC3 with alpha), BC5 for normals.
+        Quality, // BC7 for color, BC5 for normals.
+    };
+
+    namespace BlockCompression {
+        constexpr uint32_t BlockDimension = 4;
+
+        uint32_t GetBlockByteSize(BlockFormat format);
+
+        // Byte size of one row of blocks for an image of the given width.
+        uint32_t GetRowPitch(BlockFormat format, uint32_t width);
+
+        // Compress a tightly packed RGBA image. Images whose size is not a multiple of 4 are padded by repeating edge texels.
+        // Large images are compressed in parallel on the system thread pool.
+        std::vector<uint8_t> Compress(const uint8_t* rgba, uint32_t width, uint32_t height, BlockFormat format);
+
+        // Decompress into a tightly packed RGBA image. Channels absent from the format are 0, except alpha which is 255.
+        // BC7 blocks of the reserved mode decode to transparent black, like on GPUs.
+        std::vector<uint8_t> Decompress(const uint8_t* blocks, uint32_t width, uint32_t height, BlockFormat format);
+
+        // Peak signal-to-noise ratio in dB between two RGBA images over the channels selected by channelMask (bit 0 = red).
+        // Returns infinity for identical images.
+        double ComputePsnr(const uint8_t* expected, const uint8_t* actual, size_t texelCount, uint32_t channelMask = 0xF);
+    } // namespace BlockCompression
+} // namespace Pbr
@@ -2,6 +2,7 @@
 // Copyright (C) Microsoft Corporation.  All Rights Reserved
 // Licensed under the MIT License. See License.txt in the project root for license information.
 #include "pch.h"
+#include <algorithm>
 #include <sstream>
 // Implementation is in the Gltf library so this isn't needed: #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -21,7 +22,58 @@ namespace Pbr {
             }
         }
     } // namespace Internal
+} // namespace Pbr
+
+namespace {
+    // Create a 2D texture and its view from the initial data of each mip level, most detailed level first.
+    winrt::com_ptr<ID3D11ShaderResourceView> CreateTextureFromLevels(_In_ ID3D11Device* device,
+                                                                     DXGI_FORMAT format,
+                                                                     uint32_t width,
+                                                                     uint32_t height,
+                                                                     const std::vector<D3D11_SUBRESOURCE_DATA>& initData) {
+        D3D11_TEXTURE2D_DESC desc{};
+        desc.Width = width;
+        desc.Height = height;
+        desc.MipLevels = (UINT)initData.size();
+        desc.ArraySize = 1;
+        desc.Format = format;
+        desc.SampleDesc.Count = 1;
+        desc.SampleDesc.Quality = 0;
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+        winrt::com_ptr<ID3D11Texture2D> texture2D;
+        Pbr::Internal::ThrowIfFailed(device->CreateTexture2D(&desc, initData.data(), texture2D.put()));
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+        srvDesc.Format = desc.Format;
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Texture2D.MipLevels = desc.MipLevels;
+        srvDesc.Texture2D.MostDetailedMip = 0;
+
+        winrt::com_ptr<ID3D11ShaderResourceView> textureView;
+        Pbr::Internal::ThrowIfFailed(device->CreateShaderResourceView(texture2D.get(), &srvDesc, textureView.put()));
+
+        return textureView;
+    }
+
+    // Create a texture from levels of 8-bit RGBA texels or of blocks, most detailed level first.
+    winrt::com_ptr<ID3D11ShaderResourceView> CreateTextureFromLevels(_In_ ID3D11Device* device,
+                                                                     DXGI_FORMAT format,
+                                                                     const std::optional<Pbr::BlockFormat>& blockFormat,
+                                                                     const std::vector<Pbr::MipLevel>& levels) {
+        std::vector<D3D11_SUBRESOURCE_DATA> initData(levels.size());
+        for (size_t level = 0; level < levels.size(); level++) {
+            initData[level].pSysMem = levels[level].Pixels.data();
+            initData[level].SysMemPitch =
+                blockFormat ? Pbr::BlockCompression::GetRowPitch(*blockFormat, levels[level].Width) : levels[level].Width * 4;
+            initData[level].SysMemSlicePitch = (UINT)levels[level].Pixels.size();
+        }
+        return CreateTextureFromLevels(device, format, levels[0].Width, levels[0].Height, initData);
+    }
+} // namespace
 
+namespace Pbr {
     const D3D11_INPUT_ELEMENT_DESC Vertex::s_vertexDesc[6] = {
         {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
         {"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
@@ -31,6 +83,59 @@ namespace Pbr {
         {"TRANSFORMINDEX", 0, DXGI_FORMAT_R16_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
     };
 
+    const D3D11_INPUT_ELEMENT_DESC CompactVertex::s_vertexDesc[6] = {
+        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"NORMAL", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TRANSFORMINDEX", 0, DXGI_FORMAT_R16_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TANGENT", 0, DXGI_FORMAT_R16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+    };
+
+    const D3D11_INPUT_ELEMENT_DESC QuantizedVertex::s_vertexDesc[6] = {
+        {"POSITION", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"NORMAL", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TRANSFORMINDEX", 0, DXGI_FORMAT_R16_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TANGENT", 0, DXGI_FORMAT_R16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+    };
+
+    const D3D11_INPUT_ELEMENT_DESC StreamingVertex::s_vertexDesc[6] = {
+        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TRANSFORMINDEX", 0, DXGI_FORMAT_R16_UINT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+    };
+
+    const D3D11_INPUT_ELEMENT_DESC SkinVertex::s_vertexDesc[8] = {
+        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TRANSFORMINDEX", 0, DXGI_FORMAT_R16_UINT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"JOINTS", 0, DXGI_FORMAT_R16G16B16A16_UINT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"WEIGHTS", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+    };
+
+    UINT GetVertexStride(VertexFormat vertexFormat) {
+        switch (vertexFormat) {
+        case VertexFormat::Compact:
+            return sizeof(CompactVertex);
+        case VertexFormat::CompactQuantized:
+            return sizeof(QuantizedVertex);
+        case VertexFormat::Streaming:
+            return sizeof(StreamingVertex::Dynamic) + sizeof(StreamingVertex::Static);
+        case VertexFormat::Skinned:
+            return sizeof(Vertex) + sizeof(SkinVertex);
+        default:
+            return sizeof(Vertex);
+        }
+    }
+
     RGBAColor XM_CALLCONV FromSRGB(DirectX::XMVECTOR color) {
         RGBAColor linearColor{};
         DirectX::XMStoreFloat4(&linearColor, DirectX::XMColorSRGBToRGB(color));
@@ -124,6 +229,7 @@ namespace Pbr {
             }
         }
 
+        Optimize(startVertexIndex, startIndicesIndex);
         return *this;
     }
 
@@ -237,6 +343,51 @@ namespace Pbr {
         return *this;
     }
 
+    MeshOptimizationStats PrimitiveBuilder::Optimize(size_t startVertex, size_t startIndex) {
+        if ((Indices.size() - startIndex) % 3 != 0) {
+            throw std::exception("Only triangle lists can be optimized");
+        }
+
+        // Optimize with indices relative to startVertex.
+        std::vector<uint32_t> indices(Indices.begin() + startIndex, Indices.end());
+        for (uint32_t& index : indices) {
+            index -= (uint32_t)startVertex;
+        }
+
+        const size_t vertexCount = Vertices.size() - startVertex;
+        MeshOptimizationStats stats;
+        stats.TriangleCount = indices.size() / 3;
+        stats.VertexCount = vertexCount;
+        if (stats.TriangleCount == 0) {
+            return stats;
+        }
+        stats.CacheMissesBefore = MeshOptimizer::CountCacheMisses(indices.data(), indices.size(), vertexCount);
+
+        MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+        MeshOptimizer::OptimizeOverdraw(
+            indices.data(), indices.size(), &Vertices[startVertex].Position, sizeof(Pbr::Vertex), vertexCount);
+
+        std::vector<uint32_t> remap;
+        const size_t uniqueVertexCount = MeshOptimizer::OptimizeVertexFetchRemap(indices.data(), indices.size(), vertexCount, remap);
+        const std::vector<Pbr::Vertex> vertices = MeshOptimizer::RemapVertices(&Vertices[startVertex], remap, uniqueVertexCount);
+        Vertices.resize(startVertex);
+        Vertices.insert(Vertices.end(), vertices.begin(), vertices.end());
+        if (!SkinVertices.empty()) {
+            const std::vector<Pbr::SkinVertex> skinVertices =
+                MeshOptimizer::RemapVertices(&SkinVertices[startVertex], remap, uniqueVertexCount);
+            SkinVertices.resize(startVertex);
+            SkinVertices.insert(SkinVertices.end(), skinVertices.begin(), skinVertices.end());
+        }
+
+        for (size_t i = 0; i < indices.size(); i++) {
+            Indices[startIndex + i] = indices[i] + (uint32_t)startVertex;
+        }
+
+        stats.VertexCount = uniqueVertexCount;
+        stats.CacheMissesAfter = MeshOptimizer::CountCacheMisses(indices.data(), indices.size(), uniqueVertexCount);
+        return stats;
+    }
+
     namespace Texture {
         std::array<uint8_t, 4> LoadRGBAUI4(RGBAColor color) {
             XMFLOAT4 colorf;
@@ -298,41 +449,168 @@ namespace Pbr {
             return textureView;
         }
 
+        winrt::com_ptr<ID3D11ShaderResourceView> CreateCubeTexture(_In_ ID3D11Device* device, const CubeMap& cubeMap) {
+            if (cubeMap.Size == 0 || cubeMap.MipLevels == 0 || cubeMap.Texels.size() != cubeMap.GetLevelOffset(6, 0)) {
+                throw std::exception("Cube map has no texels");
+            }
+
+            const CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_R16G16B16A16_FLOAT,
+                                             cubeMap.Size,
+                                             cubeMap.Size,
+                                             6,
+                                             cubeMap.MipLevels,
+                                             D3D11_BIND_SHADER_RESOURCE,
+                                             D3D11_USAGE_IMMUTABLE,
+                                             0,
+                                             1,
+                                             0,
+                                             D3D11_RESOURCE_MISC_TEXTURECUBE);
+
+            std::vector<D3D11_SUBRESOURCE_DATA> initData(6 * cubeMap.MipLevels);
+            for (uint32_t face = 0; face < 6; face++) {
+                for (uint32_t level = 0; level < cubeMap.MipLevels; level++) {
+                    D3D11_SUBRESOURCE_DATA& levelData = initData[D3D11CalcSubresource(level, face, cubeMap.MipLevels)];
+                    levelData.pSysMem = &cubeMap.Texels[cubeMap.GetLevelOffset(face, level)];
+                    levelData.SysMemPitch = std::max(1u, cubeMap.Size >> level) * sizeof(DirectX::PackedVector::XMHALF4);
+                }
+            }
+
+            winrt::com_ptr<ID3D11Texture2D> cubeTexture;
+            Internal::ThrowIfFailed(device->CreateTexture2D(&desc, initData.data(), cubeTexture.put()));
+
+            const CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_TEXTURECUBE, desc.Format);
+            winrt::com_ptr<ID3D11ShaderResourceView> textureView;
+            Internal::ThrowIfFailed(device->CreateShaderResourceView(cubeTexture.get(), &srvDesc, textureView.put()));
+            return textureView;
+        }
+
+        winrt::com_ptr<ID3D11ShaderResourceView> CreateBrdfLutTexture(_In_ ID3D11Device* device,
+                                                                      const std::vector<uint16_t>& brdfLut,
+                                                                      uint32_t size) {
+            if (size == 0 || brdfLut.size() != (size_t)size * size * 2) {
+                throw std::exception("BRDF lookup table size doesn't match its data");
+            }
+
+            const CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_R16G16_UNORM, size, size, 1, 1, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE);
+            D3D11_SUBRESOURCE_DATA initData{};
+            initData.pSysMem = brdfLut.data();
+            initData.SysMemPitch = size * 2 * sizeof(uint16_t);
+
+            winrt::com_ptr<ID3D11Texture2D> texture;
+            Internal::ThrowIfFailed(device->CreateTexture2D(&desc, &initData, texture.put()));
+
+            const CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_TEXTURE2D, desc.Format);
+            winrt::com_ptr<ID3D11ShaderResourceView> textureView;
+            Internal::ThrowIfFailed(device->CreateShaderResourceView(texture.get(), &srvDesc, textureView.put()));
+            return textureView;
+        }
+
         winrt::com_ptr<ID3D11ShaderResourceView> CreateTexture(_In_ ID3D11Device* device,
                                                                _In_reads_bytes_(size) const uint8_t* rgba,
                                                                uint32_t size,
                                                                int width,
                                                                int height,
-                                                               DXGI_FORMAT format) {
-            D3D11_TEXTURE2D_DESC desc{};
-            desc.Width = width;
-            desc.Height = height;
-            desc.MipLevels = 1;
-            desc.ArraySize = 1;
-            desc.Format = format;
-            desc.SampleDesc.Count = 1;
-            desc.SampleDesc.Quality = 0;
-            desc.Usage = D3D11_USAGE_DEFAULT;
-            desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+                                                               DXGI_FORMAT format,
+                                                               MipFilter mipFilter) {
+            // Mips are generated from the 8-bit RGBA data, so other formats only get the top level.
+            const bool isRgba8 = format == DXGI_FORMAT_R8G8B8A8_UNORM || format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+            const bool sRGB = format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+            const std::vector<MipLevel> mips =
+                isRgba8 ? MipGenerator::GenerateMips(rgba, width, height, sRGB, mipFilter) : std::vector<MipLevel>{};
+
+            std::vector<D3D11_SUBRESOURCE_DATA> initData(1 + mips.size());
+            initData[0].pSysMem = rgba;
+            initData[0].SysMemPitch = size / height;
+            initData[0].SysMemSlicePitch = size;
+            for (size_t level = 0; level < mips.size(); level++) {
+                initData[level + 1].pSysMem = mips[level].Pixels.data();
+                initData[level + 1].SysMemPitch = mips[level].Width * 4;
+                initData[level + 1].SysMemSlicePitch = (UINT)mips[level].Pixels.size();
+            }
 
-            D3D11_SUBRESOURCE_DATA initData{};
-            initData.pSysMem = rgba;
-            initData.SysMemPitch = size / height;
-            initData.SysMemSlicePitch = size;
+            return CreateTextureFromLevels(device, format, width, height, initData);
+        }
 
-            winrt::com_ptr<ID3D11Texture2D> texture2D;
-            Internal::ThrowIfFailed(device->CreateTexture2D(&desc, &initData, texture2D.put()));
+        DXGI_FORMAT GetDxgiFormat(BlockFormat format, bool sRGB) {
+            switch (format) {
+            case BlockFormat::BC1:
+                return sRGB ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+            case BlockFormat::BC3:
+                return sRGB ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+            case BlockFormat::BC4:
+                return DXGI_FORMAT_BC4_UNORM;
+            case BlockFormat::BC5:
+                return DXGI_FORMAT_BC5_UNORM;
+            case BlockFormat::BC7:
+                return sRGB ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+            default:
+                throw std::exception("Unknown block format");
+            }
+        }
 
-            D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
-            srvDesc.Format = desc.Format;
-            srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-            srvDesc.Texture2D.MipLevels = desc.MipLevels;
-            srvDesc.Texture2D.MostDetailedMip = desc.MipLevels - 1;
+        winrt::com_ptr<ID3D11ShaderResourceView> CreateCompressedTexture(_In_ ID3D11Device* device,
+                                                                         _In_reads_bytes_(width* height * 4) const uint8_t* rgba,
+                                                                         uint32_t width,
+                                                                         uint32_t height,
+                                                                         BlockFormat blockFormat,
+                                                                         bool sRGB,
+                                                                         MipFilter mipFilter) {
+            if (width % BlockCompression::BlockDimension != 0 || height % BlockCompression::BlockDimension != 0) {
+                const DXGI_FORMAT format = sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+                return CreateTexture(device, rgba, width * height * 4, width, height, format, mipFilter);
+            }
 
-            winrt::com_ptr<ID3D11ShaderResourceView> textureView;
-            Internal::ThrowIfFailed(device->CreateShaderResourceView(texture2D.get(), &srvDesc, textureView.put()));
+            // Mips are filtered from the uncompressed levels so that compression errors don't accumulate down the chain.
+            const std::vector<MipLevel> mips = MipGenerator::GenerateMips(rgba, width, height, sRGB, mipFilter);
 
-            return textureView;
+            std::vector<MipLevel> levels;
+            levels.reserve(1 + mips.size());
+            levels.push_back({width, height, BlockCompression::Compress(rgba, width, height, blockFormat)});
+            for (const MipLevel& mip : mips) {
+                std::vector<uint8_t> blocks = BlockCompression::Compress(mip.Pixels.data(), mip.Width, mip.Height, blockFormat);
+                levels.push_back({mip.Width, mip.Height, std::move(blocks)});
+            }
+
+            return CreateTextureFromLevels(device, GetDxgiFormat(blockFormat, sRGB), blockFormat, levels);
+        }
+
+        winrt::com_ptr<ID3D11ShaderResourceView> CreateKtx2Texture(_In_ ID3D11Device* device,
+                                                                   const Ktx2Image& image,
+                                                                   bool sRGB,
+                                                                   MipFilter mipFilter) {
+            const MipLevel& top = image.Levels.at(0);
+            const DXGI_FORMAT rgbaFormat = sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+            if (!image.Format) {
+                // Files without a mip chain leave its generation to the loader.
+                if (image.Levels.size() == 1) {
+                    const uint32_t size = (uint32_t)top.Pixels.size();
+                    return CreateTexture(device, top.Pixels.data(), size, top.Width, top.Height, rgbaFormat, mipFilter);
+                }
+                return CreateTextureFromLevels(device, rgbaFormat, std::nullopt, image.Levels);
+            }
+
+            const DXGI_FORMAT format = GetDxgiFormat(*image.Format, sRGB);
+            const bool blockAligned =
+                top.Width % BlockCompression::BlockDimension == 0 && top.Height % BlockCompression::BlockDimension == 0;
+            if (blockAligned && IsFormatSupported(device, format)) {
+                return CreateTextureFromLevels(device, format, image.Format, image.Levels);
+            }
+
+            // The blocks can't be uploaded as they are, so transcode them on the CPU. BC7 requires feature level 11; without it,
+            // BC7 is transcoded to BC3 like the textures the loader compresses itself. Everything else is decoded to RGBA.
+            const DXGI_FORMAT bc3Format = GetDxgiFormat(BlockFormat::BC3, sRGB);
+            if (image.Format == BlockFormat::BC7 && blockAligned && IsFormatSupported(device, bc3Format)) {
+                const Ktx2Image bc3 = Ktx2::Transcode(image, BlockFormat::BC3);
+                return CreateTextureFromLevels(device, bc3Format, bc3.Format, bc3.Levels);
+            }
+            const Ktx2Image rgba = Ktx2::Transcode(image, std::nullopt);
+            return CreateTextureFromLevels(device, rgbaFormat, std::nullopt, rgba.Levels);
+        }
+
+        bool IsFormatSupported(_In_ ID3D11Device* device, DXGI_FORMAT format) {
+            constexpr UINT RequiredSupport = D3D11_FORMAT_SUPPORT_TEXTURE2D | D3D11_FORMAT_SUPPORT_SHADER_SAMPLE;
+            UINT formatSupport = 0;
+            return SUCCEEDED(device->CheckFormatSupport(format, &formatSupport)) && (formatSupport & RequiredSupport) == RequiredSupport;
         }
 
         winrt::com_ptr<ID3D11SamplerState> CreateSampler(_In_ ID3D11Device* device, D3D11_TEXTURE_ADDRESS_MODE addressMode) {
@@ -14,6 +14,12 @@
 #include <d3d11_2.h>
 #include <DirectXMath.h>
 #include <DirectXColors.h>
+#include "PbrBlockCompression.h"
+#include "PbrIbl.h"
+#include "PbrKtx2.h"
+#include "PbrMeshOptimizer.h"
+#include "PbrMipGenerator.h"
+#include "PbrVertexQuantization.h"
 
 namespace Pbr {
     namespace Internal {
@@ -58,9 +64,70 @@ namespace Pbr {
         static const D3D11_INPUT_ELEMENT_DESC s_vertexDesc[6];
     };
 
+    // Vertex structure of VertexFormat::Compact, 32 bytes.
+    struct CompactVertex {
+        DirectX::XMFLOAT3 Position;
+        std::array<int16_t, 4> NormalTangent; // Octahedral encoded normal (xy) and tangent (zw), snorm16.
+        std::array<uint16_t, 2> TexCoord0;    // Half floats.
+        std::array<uint8_t, 4> Color0;        // RGBA8 unorm.
+        NodeIndex_t ModelTransformIndex;
+        int16_t TangentSign; // Bitangent sign, snorm16.
+
+        static const D3D11_INPUT_ELEMENT_DESC s_vertexDesc[6];
+    };
+
+    // Vertex structure of VertexFormat::CompactQuantized, 28 bytes. Positions are decoded with the primitive's bounds.
+    struct QuantizedVertex {
+        std::array<int16_t, 4> Position; // snorm16 relative to the primitive bounds. w is unused.
+        std::array<int16_t, 4> NormalTangent;
+        std::array<uint16_t, 2> TexCoord0;
+        std::array<uint8_t, 4> Color0;
+        NodeIndex_t ModelTransformIndex;
+        int16_t TangentSign;
+
+        static const D3D11_INPUT_ELEMENT_DESC s_vertexDesc[6];
+    };
+
+    static_assert(sizeof(CompactVertex) == 32 && sizeof(QuantizedVertex) == 28, "Unexpected compact vertex padding");
+
+    // Vertex streams of VertexFormat::Streaming. Updated geometry usually moves its vertices while the other attributes stay
+    // the same, so only the first stream has to be uploaded again.
+    struct StreamingVertex {
+        // Stream 0: the attributes that change when the geometry moves.
+        struct Dynamic {
+            DirectX::XMFLOAT3 Position;
+            DirectX::XMFLOAT3 Normal;
+            DirectX::XMFLOAT4 Tangent;
+        };
+
+        // Stream 1: the attributes that usually stay the same.
+        struct Static {
+            DirectX::XMFLOAT4 Color0;
+            DirectX::XMFLOAT2 TexCoord0;
+            NodeIndex_t ModelTransformIndex;
+        };
+
+        static const D3D11_INPUT_ELEMENT_DESC s_vertexDesc[6];
+    };
+
+    // Second vertex stream of VertexFormat::Skinned, after a stream of Pbr::Vertex. The joints index into the joint matrices
+    // of the model. Vertices whose weights are all zero aren't skinned and only use their node transform.
+    struct SkinVertex {
+        std::array<uint16_t, 4> Joints;
+        std::array<uint16_t, 4> Weights; // unorm16, summing to 1 for skinned vertices.
+
+        static const D3D11_INPUT_ELEMENT_DESC s_vertexDesc[8]; // Including the elements of Pbr::Vertex in stream 0.
+    };
+
+    // Size of a vertex of the given format, in bytes. For VertexFormat::Streaming and VertexFormat::Skinned, the size of both
+    // streams.
+    UINT GetVertexStride(VertexFormat vertexFormat);
+
     struct PrimitiveBuilder {
         std::vector<Pbr::Vertex> Vertices;
         std::vector<uint32_t> Indices;
+        // Either empty, or one per vertex for primitives of VertexFormat::Skinned.
+        std::vector<Pbr::SkinVertex> SkinVertices;
 
         PrimitiveBuilder& AddAxis(float axisLength = 1.0f,
                                   float axisThickness = 0.1f,
@@ -83,6 +150,11 @@ namespace Pbr {
                                   DirectX::XMFLOAT2 textureCoord = {1, 1},
                                   Pbr::NodeIndex_t transformIndex = Pbr::RootNodeIndex,
                                   RGBAColor vertexColor = RGBA::White);
+
+        // Reorder the triangles and vertices added from startVertex and startIndex for the post-transform vertex
+        // cache, overdraw and vertex fetch. Those indices must only reference vertices from startVertex, and
+        // vertices they don't reference are removed. AddSphere optimizes its own vertices.
+        MeshOptimizationStats Optimize(size_t startVertex = 0, size_t startIndex = 0);
     };
 
     namespace Texture {
@@ -94,12 +166,42 @@ namespace Pbr {
         winrt::com_ptr<ID3D11ShaderResourceView> CreateFlatCubeTexture(_In_ ID3D11Device* device,
                                                                        RGBAColor color,
                                                                        DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM);
+        // Create a R16G16B16A16_FLOAT cube texture with all the levels of the cube map.
+        winrt::com_ptr<ID3D11ShaderResourceView> CreateCubeTexture(_In_ ID3D11Device* device, const CubeMap& cubeMap);
+        // Create a R16G16_UNORM texture from a BRDF lookup table computed by Ibl::ComputeBrdfLut.
+        winrt::com_ptr<ID3D11ShaderResourceView> CreateBrdfLutTexture(_In_ ID3D11Device* device,
+                                                                      const std::vector<uint16_t>& brdfLut,
+                                                                      uint32_t size);
+        // Create a texture from RGBA data. If a mip filter is given, the full mip chain is generated on the CPU
+        // (in linear space for sRGB formats) and uploaded with the initial data.
         winrt::com_ptr<ID3D11ShaderResourceView> CreateTexture(_In_ ID3D11Device* device,
                                                                _In_reads_bytes_(size) const uint8_t* rgba,
                                                                uint32_t size,
                                                                int width,
                                                                int height,
-                                                               DXGI_FORMAT format);
+                                                               DXGI_FORMAT format,
+                                                               MipFilter mipFilter = MipFilter::None);
+        // Get the DXGI format storing the block format. BC4 and BC5 have no sRGB variant.
+        DXGI_FORMAT GetDxgiFormat(BlockFormat format, bool sRGB);
+        // Create a block compressed texture from RGBA data. The mip chain is generated from the uncompressed data and each level
+        // is compressed separately. D3D11 requires the top level of a block compressed texture to be a multiple of 4 in size,
+        // so other images are uploaded uncompressed.
+        winrt::com_ptr<ID3D11ShaderResourceView> CreateCompressedTexture(_In_ ID3D11Device* device,
+                                                                         _In_reads_bytes_(width* height * 4) const uint8_t* rgba,
+                                                                         uint32_t width,
+                                                                         uint32_t height,
+                                                                         BlockFormat blockFormat,
+                                                                         bool sRGB,
+                                                                         MipFilter mipFilter = MipFilter::None);
+        // Create a texture from the levels of a KTX2 image. The sRGB flag overrides the color space stored in the file. BC7 images
+        // the device can't sample are transcoded to BC3, and other block compressed images it can't sample are decoded to 8-bit
+        // RGBA. Single level RGBA images get a mip chain generated.
+        winrt::com_ptr<ID3D11ShaderResourceView> CreateKtx2Texture(_In_ ID3D11Device* device,
+                                                                   const Ktx2Image& image,
+                                                                   bool sRGB,
+                                                                   MipFilter mipFilter = MipFilter::None);
+        // Returns whether 2D textures of the format can be created and sampled.
+        bool IsFormatSupported(_In_ ID3D11Device* device, DXGI_FORMAT format);
         winrt::com_ptr<ID3D11SamplerState> CreateSampler(_In_ ID3D11Device* device,
                                                          D3D11_TEXTURE_ADDRESS_MODE addressMode = D3D11_TEXTURE_ADDRESS_CLAMP);
     } // namespace Texture
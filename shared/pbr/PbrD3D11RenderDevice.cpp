@@ -0,0 +1,404 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include "PbrCommon.h"
+#include "PbrD3D11RenderDevice.h"
+
+namespace {
+    UINT GetBindFlags(Pbr::BufferUsage usage) {
+        switch (usage) {
+        case Pbr::BufferUsage::Vertex:
+            return D3D11_BIND_VERTEX_BUFFER;
+        case Pbr::BufferUsage::Index:
+            return D3D11_BIND_INDEX_BUFFER;
+        case Pbr::BufferUsage::Constant:
+            return D3D11_BIND_CONSTANT_BUFFER;
+        case Pbr::BufferUsage::Structured:
+            return D3D11_BIND_SHADER_RESOURCE;
+        }
+        throw std::out_of_range("Unknown buffer usage");
+    }
+
+    D3D11_FILTER GetFilter(Pbr::SamplerFilter filter) {
+        switch (filter) {
+        case Pbr::SamplerFilter::Point:
+            return D3D11_FILTER_MIN_MAG_MIP_POINT;
+        case Pbr::SamplerFilter::Linear:
+            return D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+        case Pbr::SamplerFilter::Anisotropic:
+            return D3D11_FILTER_ANISOTROPIC;
+        }
+        throw std::out_of_range("Unknown sampler filter");
+    }
+
+    void CheckSlots(uint32_t startSlot, uint32_t count, uint32_t slotCount) {
+        if ((uint64_t)startSlot + count > slotCount) {
+            throw std::out_of_range("Binding slot out of range");
+        }
+    }
+} // namespace
+
+namespace Pbr {
+    D3D11RenderDevice::D3D11RenderDevice(_In_ ID3D11Device* device, _In_ ID3D11DeviceContext* context) {
+        m_device.copy_from(device);
+        m_context.copy_from(context);
+    }
+
+    void D3D11RenderDevice::SetContext(_In_ ID3D11DeviceContext* context) {
+        if (m_context.get() != context) {
+            m_context.copy_from(context);
+            InvalidateState();
+        }
+    }
+
+    void D3D11RenderDevice::InvalidateState() {
+        m_boundPipeline.reset();
+    }
+
+    BufferHandle D3D11RenderDevice::Import(_In_ ID3D11Buffer* buffer, BufferUsage usage, _In_opt_ ID3D11ShaderResourceView* view) {
+        D3D11_BUFFER_DESC desc;
+        buffer->GetDesc(&desc);
+
+        Buffer imported{nullptr, nullptr, usage, desc.Usage == D3D11_USAGE_DYNAMIC};
+        imported.Object.copy_from(buffer);
+        imported.View.copy_from(view);
+        return m_buffers.Add(std::move(imported));
+    }
+
+    TextureHandle D3D11RenderDevice::Import(_In_ ID3D11ShaderResourceView* textureView) {
+        Texture imported;
+        textureView->GetResource(imported.Object.put());
+        imported.View.copy_from(textureView);
+        return m_textures.Add(std::move(imported));
+    }
+
+    SamplerHandle D3D11RenderDevice::Import(_In_ ID3D11SamplerState* sampler) {
+        winrt::com_ptr<ID3D11SamplerState> imported;
+        imported.copy_from(sampler);
+        return m_samplers.Add(std::move(imported));
+    }
+
+    ID3D11Buffer* D3D11RenderDevice::GetBuffer(BufferHandle buffer) {
+        return m_buffers.Get(buffer).Object.get();
+    }
+
+    ID3D11ShaderResourceView* D3D11RenderDevice::GetTextureView(TextureHandle texture) {
+        return m_textures.Get(texture).View.get();
+    }
+
+    BufferHandle D3D11RenderDevice::CreateBuffer(const BufferDesc& desc, const void* initialData) {
+        CD3D11_BUFFER_DESC bufferDesc(desc.ByteSize, GetBindFlags(desc.Usage));
+        if (desc.Dynamic) {
+            bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+            bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        }
+        if (desc.Usage == BufferUsage::Structured) {
+            bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+            bufferDesc.StructureByteStride = desc.StructureByteStride;
+        }
+
+        const D3D11_SUBRESOURCE_DATA data{initialData, 0, 0};
+        Buffer buffer{nullptr, nullptr, desc.Usage, desc.Dynamic};
+        Internal::ThrowIfFailed(m_device->CreateBuffer(&bufferDesc, initialData ? &data : nullptr, buffer.Object.put()));
+        if (desc.Usage == BufferUsage::Structured) {
+            const CD3D11_SHADER_RESOURCE_VIEW_DESC viewDesc(
+                D3D11_SRV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, desc.ByteSize / desc.StructureByteStride);
+            Internal::ThrowIfFailed(m_device->CreateShaderResourceView(buffer.Object.get(), &viewDesc, buffer.View.put()));
+        }
+        return m_buffers.Add(std::move(buffer));
+    }
+
+    TextureHandle D3D11RenderDevice::CreateTexture(const TextureDesc& desc, const SubresourceData* initialData) {
+        CD3D11_TEXTURE2D_DESC textureDesc(
+            (DXGI_FORMAT)desc.Format, desc.Width, desc.Height, desc.ArraySize, desc.MipLevels, D3D11_BIND_SHADER_RESOURCE);
+        if (desc.Cube) {
+            textureDesc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
+        }
+
+        std::vector<D3D11_SUBRESOURCE_DATA> data;
+        if (initialData) {
+            for (uint32_t subresource = 0; subresource < desc.GetSubresourceCount(); subresource++) {
+                const SubresourceData& source = initialData[subresource];
+                data.push_back({source.Data, source.RowPitch, source.ByteSize});
+            }
+        }
+
+        winrt::com_ptr<ID3D11Texture2D> texture2D;
+        Internal::ThrowIfFailed(m_device->CreateTexture2D(&textureDesc, initialData ? data.data() : nullptr, texture2D.put()));
+
+        // Views of cube textures sample them as cubes, and views of other textures as arrays when they have several slices.
+        const D3D11_SRV_DIMENSION dimension = desc.Cube && desc.ArraySize > 6 ? D3D11_SRV_DIMENSION_TEXTURECUBEARRAY
+                                              : desc.Cube                     ? D3D11_SRV_DIMENSION_TEXTURECUBE
+                                              : desc.ArraySize > 1            ? D3D11_SRV_DIMENSION_TEXTURE2DARRAY
+                                                                              : D3D11_SRV_DIMENSION_TEXTURE2D;
+        const CD3D11_SHADER_RESOURCE_VIEW_DESC viewDesc(
+            texture2D.get(), dimension, textureDesc.Format, 0, desc.MipLevels, 0, desc.Cube ? desc.ArraySize / 6 : desc.ArraySize);
+
+        Texture texture;
+        texture.Object.copy_from(texture2D.get());
+        Internal::ThrowIfFailed(m_device->CreateShaderResourceView(texture2D.get(), &viewDesc, texture.View.put()));
+        return m_textures.Add(std::move(texture));
+    }
+
+    ShaderHandle D3D11RenderDevice::CreateShader(ShaderStage stage, const void* bytecode, size_t byteSize) {
+        Shader shader{stage};
+        if (stage == ShaderStage::Vertex) {
+            winrt::com_ptr<ID3D11VertexShader> vertexShader;
+            Internal::ThrowIfFailed(m_device->CreateVertexShader(bytecode, byteSize, nullptr, vertexShader.put()));
+            shader.Object.copy_from(vertexShader.get());
+            shader.Bytecode.assign(static_cast<const uint8_t*>(bytecode), static_cast<const uint8_t*>(bytecode) + byteSize);
+        } else {
+            winrt::com_ptr<ID3D11PixelShader> pixelShader;
+            Internal::ThrowIfFailed(m_device->CreatePixelShader(bytecode, byteSize, nullptr, pixelShader.put()));
+            shader.Object.copy_from(pixelShader.get());
+        }
+        return m_shaders.Add(std::move(shader));
+    }
+
+    PipelineHandle D3D11RenderDevice::CreatePipeline(const PipelineDesc& desc) {
+        const Shader& vertexShader = m_shaders.Get(desc.VertexShader);
+        if (vertexShader.Stage != ShaderStage::Vertex) {
+            throw std::logic_error("Pipeline vertex shader isn't a vertex shader");
+        }
+
+        Pipeline pipeline;
+        vertexShader.Object.as(pipeline.VertexShader);
+        if (desc.PixelShader != ShaderHandle::None) {
+            const Shader& pixelShader = m_shaders.Get(desc.PixelShader);
+            if (pixelShader.Stage != ShaderStage::Pixel) {
+                throw std::logic_error("Pipeline pixel shader isn't a pixel shader");
+            }
+            pixelShader.Object.as(pipeline.PixelShader);
+        }
+
+        if (!desc.InputLayout.empty()) {
+            std::vector<D3D11_INPUT_ELEMENT_DESC> elements;
+            for (const VertexElement& element : desc.InputLayout) {
+                elements.push_back({element.SemanticName,
+                                    element.SemanticIndex,
+                                    (DXGI_FORMAT)element.Format,
+                                    element.InputSlot,
+                                    element.ByteOffset,
+                                    element.PerInstance ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA,
+                                    element.PerInstance ? 1u : 0u});
+            }
+            Internal::ThrowIfFailed(m_device->CreateInputLayout(elements.data(),
+                                                                (UINT)elements.size(),
+                                                                vertexShader.Bytecode.data(),
+                                                                vertexShader.Bytecode.size(),
+                                                                pipeline.InputLayout.put()));
+        }
+
+        // The same fixed function state as the PBR pipeline states.
+        CD3D11_BLEND_DESC blendDesc(D3D11_DEFAULT);
+        if (desc.Blend == BlendMode::AlphaBlended) {
+            D3D11_RENDER_TARGET_BLEND_DESC& renderTarget = blendDesc.RenderTarget[0];
+            renderTarget.BlendEnable = TRUE;
+            renderTarget.SrcBlend = D3D11_BLEND_SRC_ALPHA;
+            renderTarget.DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+            renderTarget.SrcBlendAlpha = D3D11_BLEND_ZERO;
+            renderTarget.DestBlendAlpha = D3D11_BLEND_ONE;
+            for (D3D11_RENDER_TARGET_BLEND_DESC& otherRenderTarget : blendDesc.RenderTarget) {
+                otherRenderTarget = renderTarget;
+            }
+        }
+        Internal::ThrowIfFailed(m_device->CreateBlendState(&blendDesc, pipeline.BlendState.put()));
+
+        CD3D11_DEPTH_STENCIL_DESC depthStencilDesc(CD3D11_DEFAULT{});
+        depthStencilDesc.DepthFunc = desc.ReverseZ ? D3D11_COMPARISON_GREATER : D3D11_COMPARISON_LESS;
+        depthStencilDesc.DepthWriteMask = desc.Blend == BlendMode::AlphaBlended ? D3D11_DEPTH_WRITE_MASK_ZERO : D3D11_DEPTH_WRITE_MASK_ALL;
+        Internal::ThrowIfFailed(m_device->CreateDepthStencilState(&depthStencilDesc, pipeline.DepthStencilState.put()));
+
+        CD3D11_RASTERIZER_DESC rasterizerDesc(D3D11_DEFAULT);
+        rasterizerDesc.CullMode = desc.Cull == CullMode::None ? D3D11_CULL_NONE : D3D11_CULL_BACK;
+        rasterizerDesc.FillMode = desc.Wireframe ? D3D11_FILL_WIREFRAME : D3D11_FILL_SOLID;
+        rasterizerDesc.FrontCounterClockwise = desc.FrontCounterClockwise;
+        Internal::ThrowIfFailed(m_device->CreateRasterizerState(&rasterizerDesc, pipeline.RasterizerState.put()));
+
+        return m_pipelines.Add(std::move(pipeline));
+    }
+
+    SamplerHandle D3D11RenderDevice::CreateSampler(const SamplerDesc& desc) {
+        CD3D11_SAMPLER_DESC samplerDesc(CD3D11_DEFAULT{});
+        samplerDesc.Filter = GetFilter(desc.Filter);
+        samplerDesc.AddressU = samplerDesc.AddressV = samplerDesc.AddressW =
+            desc.AddressMode == SamplerAddressMode::Clamp ? D3D11_TEXTURE_ADDRESS_CLAMP : D3D11_TEXTURE_ADDRESS_WRAP;
+        samplerDesc.MaxAnisotropy = desc.MaxAnisotropy;
+
+        winrt::com_ptr<ID3D11SamplerState> sampler;
+        Internal::ThrowIfFailed(m_device->CreateSamplerState(&samplerDesc, sampler.put()));
+        return m_samplers.Add(std::move(sampler));
+    }
+
+    // The context holds references to the bound objects, which keeps them alive until they are unbound.
+    void D3D11RenderDevice::Release(BufferHandle buffer) {
+        m_buffers.Remove(buffer);
+    }
+
+    void D3D11RenderDevice::Release(TextureHandle texture) {
+        m_textures.Remove(texture);
+    }
+
+    void D3D11RenderDevice::Release(ShaderHandle shader) {
+        m_shaders.Remove(shader);
+    }
+
+    void D3D11RenderDevice::Release(PipelineHandle pipeline) {
+        m_pipelines.Remove(pipeline);
+    }
+
+    void D3D11RenderDevice::Release(SamplerHandle sampler) {
+        m_samplers.Remove(sampler);
+    }
+
+    void D3D11RenderDevice::UpdateBuffer(BufferHandle buffer, uint32_t byteOffset, const void* data, uint32_t byteSize) {
+        const Buffer& target = m_buffers.Get(buffer);
+        if (target.Dynamic) {
+            D3D11_MAPPED_SUBRESOURCE mapped;
+            Internal::ThrowIfFailed(m_context->Map(target.Object.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+            std::memcpy(mapped.pData, data, byteSize);
+            m_context->Unmap(target.Object.get(), 0);
+        } else if (target.Usage == BufferUsage::Constant) {
+            m_context->UpdateSubresource(target.Object.get(), 0, nullptr, data, 0, 0);
+        } else {
+            const D3D11_BOX box{byteOffset, 0, 0, byteOffset + byteSize, 1, 1};
+            m_context->UpdateSubresource(target.Object.get(), 0, &box, data, 0, 0);
+        }
+    }
+
+    void D3D11RenderDevice::UpdateTexture(TextureHandle texture,
+                                          uint32_t subresource,
+                                          const TextureRegion& region,
+                                          const SubresourceData& data) {
+        const D3D11_BOX box{region.X, region.Y, 0, region.X + region.Width, region.Y + region.Height, 1};
+        m_context->UpdateSubresource(m_textures.Get(texture).Object.get(), subresource, &box, data.Data, data.RowPitch, 0);
+    }
+
+    void D3D11RenderDevice::SetViewport(const Viewport& viewport) {
+        const D3D11_VIEWPORT d3dViewport{viewport.X, viewport.Y, viewport.Width, viewport.Height, viewport.MinDepth, viewport.MaxDepth};
+        m_context->RSSetViewports(1, &d3dViewport);
+    }
+
+    void D3D11RenderDevice::SetPipeline(PipelineHandle pipeline) {
+        if (pipeline == PipelineHandle::None) {
+            m_context->IASetInputLayout(nullptr);
+            m_context->VSSetShader(nullptr, nullptr, 0);
+            m_context->PSSetShader(nullptr, nullptr, 0);
+            m_boundPipeline.reset();
+            return;
+        }
+
+        // The bound pipeline holds references to its states, so that objects released since can't be mistaken for new ones.
+        const Pipeline& state = m_pipelines.Get(pipeline);
+        const Pipeline* previous = m_boundPipeline ? &*m_boundPipeline : nullptr;
+        if (!previous) {
+            m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        }
+        if (!previous || previous->InputLayout != state.InputLayout) {
+            m_context->IASetInputLayout(state.InputLayout.get());
+        }
+        if (!previous || previous->VertexShader != state.VertexShader) {
+            m_context->VSSetShader(state.VertexShader.get(), nullptr, 0);
+        }
+        if (!previous || previous->PixelShader != state.PixelShader) {
+            m_context->PSSetShader(state.PixelShader.get(), nullptr, 0);
+        }
+        if (!previous || previous->BlendState != state.BlendState) {
+            m_context->OMSetBlendState(state.BlendState.get(), nullptr, 0xFFFFFFFF);
+        }
+        if (!previous || previous->DepthStencilState != state.DepthStencilState) {
+            m_context->OMSetDepthStencilState(state.DepthStencilState.get(), 0);
+        }
+        if (!previous || previous->RasterizerState != state.RasterizerState) {
+            m_context->RSSetState(state.RasterizerState.get());
+        }
+        m_boundPipeline = state;
+    }
+
+    void D3D11RenderDevice::SetVertexBuffers(
+        uint32_t startSlot, uint32_t count, const BufferHandle* buffers, const uint32_t* strides, const uint32_t* offsets) {
+        CheckSlots(startSlot, count, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT);
+        std::array<ID3D11Buffer*, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT> vertexBuffers;
+        for (uint32_t i = 0; i < count; i++) {
+            vertexBuffers[i] = buffers[i] == BufferHandle::None ? nullptr : m_buffers.Get(buffers[i]).Object.get();
+        }
+        m_context->IASetVertexBuffers(startSlot, count, vertexBuffers.data(), strides, offsets);
+    }
+
+    void D3D11RenderDevice::SetIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset) {
+        ID3D11Buffer* const indexBuffer = buffer == BufferHandle::None ? nullptr : m_buffers.Get(buffer).Object.get();
+        m_context->IASetIndexBuffer(indexBuffer, format == IndexFormat::UInt16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, offset);
+    }
+
+    void D3D11RenderDevice::SetConstantBuffers(ShaderStage stage, uint32_t startSlot, uint32_t count, const BufferHandle* buffers) {
+        CheckSlots(startSlot, count, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+        std::array<ID3D11Buffer*, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT> constantBuffers;
+        for (uint32_t i = 0; i < count; i++) {
+            constantBuffers[i] = buffers[i] == BufferHandle::None ? nullptr : m_buffers.Get(buffers[i]).Object.get();
+        }
+        if (stage == ShaderStage::Vertex) {
+            m_context->VSSetConstantBuffers(startSlot, count, constantBuffers.data());
+        } else {
+            m_context->PSSetConstantBuffers(startSlot, count, constantBuffers.data());
+        }
+    }
+
+    void D3D11RenderDevice::SetShaderBuffers(ShaderStage stage, uint32_t startSlot, uint32_t count, const BufferHandle* buffers) {
+        SetShaderResources(stage, startSlot, count, buffers);
+    }
+
+    void D3D11RenderDevice::SetShaderTextures(ShaderStage stage, uint32_t startSlot, uint32_t count, const TextureHandle* textures) {
+        SetShaderResources(stage, startSlot, count, textures);
+    }
+
+    void D3D11RenderDevice::SetSamplers(ShaderStage stage, uint32_t startSlot, uint32_t count, const SamplerHandle* samplers) {
+        CheckSlots(startSlot, count, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT);
+        std::array<ID3D11SamplerState*, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT> samplerStates;
+        for (uint32_t i = 0; i < count; i++) {
+            samplerStates[i] = samplers[i] == SamplerHandle::None ? nullptr : m_samplers.Get(samplers[i]).get();
+        }
+        if (stage == ShaderStage::Vertex) {
+            m_context->VSSetSamplers(startSlot, count, samplerStates.data());
+        } else {
+            m_context->PSSetSamplers(startSlot, count, samplerStates.data());
+        }
+    }
+
+    void D3D11RenderDevice::Draw(uint32_t vertexCount, uint32_t startVertex) {
+        m_context->Draw(vertexCount, startVertex);
+    }
+
+    void D3D11RenderDevice::DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) {
+        m_context->DrawIndexed(indexCount, startIndex, baseVertex);
+    }
+
+    void D3D11RenderDevice::DrawIndexedInstanced(
+        uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) {
+        m_context->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+    }
+
+    template <typename THandle>
+    void D3D11RenderDevice::SetShaderResources(ShaderStage stage, uint32_t startSlot, uint32_t count, const THandle* handles) {
+        CheckSlots(startSlot, count, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT);
+        std::array<ID3D11ShaderResourceView*, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT> views;
+        for (uint32_t i = 0; i < count; i++) {
+            if (handles[i] == THandle::None) {
+                views[i] = nullptr;
+            } else if constexpr (std::is_same_v<THandle, BufferHandle>) {
+                views[i] = m_buffers.Get(handles[i]).View.get();
+            } else {
+                views[i] = m_textures.Get(handles[i]).View.get();
+            }
+        }
+        if (stage == ShaderStage::Vertex) {
+            m_context->VSSetShaderResources(startSlot, count, views.data());
+        } else {
+            m_context->PSSetShaderResources(startSlot, count, views.data());
+        }
+    }
+} // namespace Pbr
@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#pragma once
+
+#include <optional>
+#include <vector>
+#include <winrt/base.h>
+#include <d3d11.h>
+#include "PbrRenderDevice.h"
+
+namespace Pbr {
+    // The render device on a D3D11 device and one of its contexts. Existing D3D11 objects can be imported to get handles,
+    // and the objects of handles looked up, so code can move to the render device one call site at a time.
+    struct D3D11RenderDevice final : RenderDevice {
+        D3D11RenderDevice(_In_ ID3D11Device* device, _In_ ID3D11DeviceContext* context);
+
+        // Send the following commands to another context of the device.
+        void SetContext(_In_ ID3D11DeviceContext* context);
+
+        // Set the whole pipeline with the next SetPipeline, after other code changed the state of the context. Otherwise
+        // SetPipeline only sets the states that differ from the previous pipeline.
+        void InvalidateState();
+
+        // Imports hold a reference to their object until their handle is released.
+        BufferHandle Import(_In_ ID3D11Buffer* buffer, BufferUsage usage, _In_opt_ ID3D11ShaderResourceView* view = nullptr);
+        TextureHandle Import(_In_ ID3D11ShaderResourceView* textureView);
+        SamplerHandle Import(_In_ ID3D11SamplerState* sampler);
+        ID3D11Buffer* GetBuffer(BufferHandle buffer);
+        ID3D11ShaderResourceView* GetTextureView(TextureHandle texture);
+
+        BufferHandle CreateBuffer(const BufferDesc& desc, const void* initialData = nullptr) override;
+        TextureHandle CreateTexture(const TextureDesc& desc, const SubresourceData* initialData = nullptr) override;
+        ShaderHandle CreateShader(ShaderStage stage, const void* bytecode, size_t byteSize) override;
+        PipelineHandle CreatePipeline(const PipelineDesc& desc) override;
+        SamplerHandle CreateSampler(const SamplerDesc& desc) override;
+
+        void Release(BufferHandle buffer) override;
+        void Release(TextureHandle texture) override;
+        void Release(ShaderHandle shader) override;
+        void Release(PipelineHandle pipeline) override;
+        void Release(SamplerHandle sampler) override;
+
+        void UpdateBuffer(BufferHandle buffer, uint32_t byteOffset, const void* data, uint32_t byteSize) override;
+        void UpdateTexture(
+            TextureHandle texture, uint32_t subresource, const TextureRegion& region, const SubresourceData& data) override;
+
+        void SetViewport(const Viewport& viewport) override;
+        void SetPipeline(PipelineHandle pipeline) override;
+        void SetVertexBuffers(
+            uint32_t startSlot, uint32_t count, const BufferHandle* buffers, const uint32_t* strides, const uint32_t* offsets) override;
+        void SetIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset = 0) override;
+        void SetConstantBuffers(ShaderStage stage, uint32_t startSlot, uint32_t count, const BufferHandle* buffers) override;
+        void SetShaderBuffers(ShaderStage stage, uint32_t startSlot, uint32_t count, const BufferHandle* buffers) override;
+        void SetShaderTextures(ShaderStage stage, uint32_t startSlot, uint32_t count, const TextureHandle* textures) override;
+        void SetSamplers(ShaderStage stage, uint32_t startSlot, uint32_t count, const SamplerHandle* samplers) override;
+
+        void Draw(uint32_t vertexCount, uint32_t startVertex) override;
+        void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) override;
+        void DrawIndexedInstanced(
+            uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+
+    private:
+        struct Buffer {
+            winrt::com_ptr<ID3D11Buffer> Object;
+            winrt::com_ptr<ID3D11ShaderResourceView> View; // Only for BufferUsage::Structured.
+            BufferUsage Usage;
+            bool Dynamic;
+        };
+
+        struct Texture {
+            winrt::com_ptr<ID3D11Resource> Object;
+            winrt::com_ptr<ID3D11ShaderResourceView> View;
+        };
+
+        struct Shader {
+            ShaderStage Stage;
+            winrt::com_ptr<ID3D11DeviceChild> Object;
+            std::vector<uint8_t> Bytecode; // Vertex shaders keep their bytecode to create the input layouts of pipelines.
+        };
+
+        struct Pipeline {
+            winrt::com_ptr<ID3D11InputLayout> InputLayout;
+            winrt::com_ptr<ID3D11VertexShader> VertexShader;
+            winrt::com_ptr<ID3D11PixelShader> PixelShader;
+            winrt::com_ptr<ID3D11BlendState> BlendState;
+            winrt::com_ptr<ID3D11DepthStencilState> DepthStencilState;
+            winrt::com_ptr<ID3D11RasterizerState> RasterizerState;
+        };
+
+        template <typename THandle>
+        void SetShaderResources(ShaderStage stage, uint32_t startSlot, uint32_t count, const THandle* handles);
+
+        winrt::com_ptr<ID3D11Device> m_device;
+        winrt::com_ptr<ID3D11DeviceContext> m_context;
+        std::optional<Pipeline> m_boundPipeline; // Empty until the first SetPipeline and after InvalidateState.
+
+        Internal::HandleTable<BufferHandle, Buffer> m_buffers;
+        Internal::HandleTable<TextureHandle, Texture> m_textures;
+        Internal::HandleTable<ShaderHandle, Shader> m_shaders;
+        Internal::HandleTable<PipelineHandle, Pipeline> m_pipelines;
+        Internal::HandleTable<SamplerHandle, winrt::com_ptr<ID3D11SamplerState>> m_samplers;
+    };
+} // namespace Pbr
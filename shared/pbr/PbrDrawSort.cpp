@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include "PbrDrawSort.h"
+
+namespace {
+    constexpr uint32_t DigitBits = 8;
+    constexpr uint32_t DigitCount = 64 / DigitBits;
+    constexpr uint32_t BucketCount = 1 << DigitBits;
+
+    // Below this many keys the fixed cost of the passes outweighs the comparisons of std::sort.
+    constexpr size_t MinRadixSortKeyCount = 1024;
+} // namespace
+
+namespace Pbr {
+    namespace DrawSort {
+        uint64_t MakeKey(DrawPass pass, float viewDepth, uint32_t index) {
+            // The bits of non-negative floats order like the floats themselves, and the sign bit is always clear, which leaves
+            // 31 bits for the depth. Blended draws invert them to sort back to front.
+            uint32_t depthBits = 0;
+            if (viewDepth > 0) {
+                std::memcpy(&depthBits, &viewDepth, sizeof(depthBits));
+            }
+            if (pass == DrawPass::Blended) {
+                depthBits = 0x7FFFFFFF - depthBits;
+            }
+            return ((uint64_t)pass << 63) | ((uint64_t)depthBits << 32) | index;
+        }
+
+        void RadixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch) {
+            if (keys.size() < MinRadixSortKeyCount) {
+                std::sort(keys.begin(), keys.end());
+                return;
+            }
+
+            // Count the digits of all passes in one read of the keys.
+            std::array<std::array<size_t, BucketCount>, DigitCount> counts{};
+            for (uint64_t key : keys) {
+                for (uint32_t digit = 0; digit < DigitCount; digit++) {
+                    counts[digit][(key >> (digit * DigitBits)) & (BucketCount - 1)]++;
+                }
+            }
+
+            scratch.resize(keys.size());
+            uint64_t* source = keys.data();
+            uint64_t* destination = scratch.data();
+            for (uint32_t digit = 0; digit < DigitCount; digit++) {
+                std::array<size_t, BucketCount>& digitCounts = counts[digit];
+
+                // A pass where every key has the same digit wouldn't move anything, e.g. the pass bit when all draws are opaque.
+                const uint64_t firstBucket = (source[0] >> (digit * DigitBits)) & (BucketCount - 1);
+                if (digitCounts[firstBucket] == keys.size()) {
+                    continue;
+                }
+
+                size_t offset = 0;
+                for (size_t& count : digitCounts) {
+                    const size_t bucketSize = count;
+                    count = offset;
+                    offset += bucketSize;
+                }
+
+                for (size_t i = 0; i < keys.size(); i++) {
+                    const uint64_t key = source[i];
+                    destination[digitCounts[(key >> (digit * DigitBits)) & (BucketCount - 1)]++] = key;
+                }
+                std::swap(source, destination);
+            }
+
+            if (source != keys.data()) {
+                keys.swap(scratch);
+            }
+        }
+    } // namespace DrawSort
+} // namespace Pbr
@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// Ordering of draws by pass and view-space depth with 64-bit sort keys and a radix sort. This code has no graphics API
+// dependency.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Pbr {
+    // Opaque draws are drawn first, front to back so that early depth testing rejects hidden pixels, and alpha-blended draws
+    // after them, back to front so that they blend over what is behind them.
+    enum class DrawPass : uint32_t {
+        Opaque,
+        Blended,
+    };
+
+    // The passes that an object has anything to draw in, so that the passes it has nothing in can be skipped.
+    struct DrawPasses {
+        bool Opaque{false};
+        bool Blended{false};
+
+        bool Any() const {
+            return Opaque || Blended;
+        }
+    };
+
+    namespace DrawSort {
+        // Pack the pass, the view-space depth (the distance along the view direction) and the index of a draw into a key.
+        // Keys in increasing order put the opaque draws before the blended ones, opaque draws front to back and blended draws
+        // back to front, and draws at the same depth in the order of their index. Depths behind the viewer and NaNs count as 0.
+        uint64_t MakeKey(DrawPass pass, float viewDepth, uint32_t index);
+
+        inline DrawPass GetPass(uint64_t key) {
+            return (key >> 63) != 0 ? DrawPass::Blended : DrawPass::Opaque;
+        }
+
+        inline uint32_t GetIndex(uint64_t key) {
+            return (uint32_t)key;
+        }
+
+        // Sort keys in increasing order with a least significant digit radix sort of 8-bit digits, in time linear in the
+        // number of keys. Digits that are the same in all keys are skipped. Small arrays fall back to std::sort. Scratch is
+        // resized to the size of keys, so it can be reused between calls to avoid allocations.
+        void RadixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch);
+    } // namespace DrawSort
+} // namespace Pbr
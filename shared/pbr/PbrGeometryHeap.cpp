@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "PbrCommon.h"
+#include "PbrGeometryHeap.h"
+
+namespace Pbr {
+    struct GeometryHeap::Impl {
+        struct HeapBuffer {
+            winrt::com_ptr<ID3D11Buffer> Buffer;
+            RangeAllocator Allocator;
+        };
+
+        struct PendingUpload {
+            winrt::com_ptr<ID3D11Buffer> Buffer;
+            uint32_t ByteOffset;
+            std::vector<uint8_t> Data;
+        };
+
+        winrt::com_ptr<ID3D11Device> Device;
+        UINT BindFlags;
+        uint32_t ElementSize;
+        uint32_t BufferElementCount;
+
+        std::mutex Mutex;
+        std::vector<HeapBuffer> Buffers;
+        std::vector<PendingUpload> PendingUploads;
+        std::atomic<bool> HasPendingUploads{false};
+
+        void Free(size_t bufferIndex, const GeometryRange& range) {
+            std::lock_guard guard(Mutex);
+            Buffers[bufferIndex].Allocator.Free(range.Offset, range.Count);
+        }
+    };
+
+    GeometryHeap::GeometryHeap(_In_ ID3D11Device* device, UINT bindFlags, uint32_t elementSize, uint32_t bufferByteSize)
+        : m_impl(std::make_shared<Impl>()) {
+        m_impl->Device.copy_from(device);
+        m_impl->BindFlags = bindFlags;
+        m_impl->ElementSize = elementSize;
+        m_impl->BufferElementCount = std::max(1u, bufferByteSize / elementSize);
+    }
+
+    std::shared_ptr<const GeometryRange> GeometryHeap::Allocate(_In_reads_bytes_(count* elementSize) const void* data, uint32_t count) {
+        if (count == 0) {
+            return nullptr;
+        }
+
+        std::lock_guard guard(m_impl->Mutex);
+
+        auto range = std::make_unique<GeometryRange>();
+        range->Count = count;
+        range->ElementSize = m_impl->ElementSize;
+
+        size_t bufferIndex = 0;
+        for (; bufferIndex < m_impl->Buffers.size(); bufferIndex++) {
+            const std::optional<uint32_t> offset = m_impl->Buffers[bufferIndex].Allocator.Allocate(count);
+            if (offset) {
+                range->Offset = offset.value();
+                break;
+            }
+        }
+
+        if (bufferIndex == m_impl->Buffers.size()) {
+            const uint32_t elementCount = std::max(count, m_impl->BufferElementCount);
+            const CD3D11_BUFFER_DESC desc(elementCount * m_impl->ElementSize, m_impl->BindFlags);
+            winrt::com_ptr<ID3D11Buffer> buffer;
+            Internal::ThrowIfFailed(m_impl->Device->CreateBuffer(&desc, nullptr, buffer.put()));
+
+            m_impl->Buffers.push_back(Impl::HeapBuffer{std::move(buffer), RangeAllocator(elementCount)});
+            range->Offset = m_impl->Buffers.back().Allocator.Allocate(count).value();
+        }
+
+        range->Buffer = m_impl->Buffers[bufferIndex].Buffer;
+
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        m_impl->PendingUploads.push_back(Impl::PendingUpload{
+            range->Buffer, range->Offset * m_impl->ElementSize, std::vector<uint8_t>(bytes, bytes + count * m_impl->ElementSize)});
+        m_impl->HasPendingUploads = true;
+
+        return std::shared_ptr<const GeometryRange>(range.release(), [impl = m_impl, bufferIndex](const GeometryRange* range) {
+            impl->Free(bufferIndex, *range);
+            delete range;
+        });
+    }
+
+    void GeometryHeap::Flush(_In_ ID3D11DeviceContext* context) {
+        if (!m_impl->HasPendingUploads) {
+            return;
+        }
+
+        std::vector<Impl::PendingUpload> pendingUploads;
+        {
+            std::lock_guard guard(m_impl->Mutex);
+            pendingUploads.swap(m_impl->PendingUploads);
+            m_impl->HasPendingUploads = false;
+        }
+
+        // Uploads are applied in allocation order, so a range that was freed and allocated again ends up with its newest data.
+        for (const Impl::PendingUpload& upload : pendingUploads) {
+            const D3D11_BOX box{upload.ByteOffset, 0, 0, upload.ByteOffset + (UINT)upload.Data.size(), 1, 1};
+            context->UpdateSubresource(upload.Buffer.get(), 0, &box, upload.Data.data(), 0, 0);
+        }
+    }
+
+    GeometryHeapStats GeometryHeap::GetStats() const {
+        std::lock_guard guard(m_impl->Mutex);
+
+        GeometryHeapStats stats;
+        for (const Impl::HeapBuffer& heapBuffer : m_impl->Buffers) {
+            const RangeAllocatorStats allocatorStats = heapBuffer.Allocator.GetStats();
+            stats.BufferCount++;
+            stats.ReservedBytes += (size_t)allocatorStats.Size * m_impl->ElementSize;
+            stats.UsedBytes += (size_t)allocatorStats.UsedSize * m_impl->ElementSize;
+            stats.FreeRangeCount += allocatorStats.FreeRangeCount;
+            stats.FragmentedBytes +=
+                (size_t)(allocatorStats.Size - allocatorStats.UsedSize - allocatorStats.LargestFreeRange) * m_impl->ElementSize;
+        }
+        return stats;
+    }
+} // namespace Pbr
@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#pragma once
+
+#include <memory>
+#include <winrt/base.h>
+#include <d3d11.h>
+#include "PbrRangeAllocator.h"
+
+namespace Pbr {
+    // A range of elements in a buffer of a geometry heap. The range returns to its heap when the last reference is released.
+    struct GeometryRange {
+        winrt::com_ptr<ID3D11Buffer> Buffer;
+        uint32_t Offset{0}; // First element of the range, i.e. the base vertex or start index.
+        uint32_t Count{0};
+        uint32_t ElementSize{0};
+    };
+
+    // Buffer usage of geometry heaps, in bytes. Stats of several heaps can be summed.
+    struct GeometryHeapStats {
+        uint32_t BufferCount{0};
+        size_t ReservedBytes{0};
+        size_t UsedBytes{0};
+        uint32_t FreeRangeCount{0};
+        size_t FragmentedBytes{0}; // Free bytes outside the largest free range of their buffer.
+
+        // 0 when each buffer's free space is one contiguous range, approaching 1 as it is split into many small ranges.
+        float Fragmentation() const {
+            const size_t freeBytes = ReservedBytes - UsedBytes;
+            return freeBytes == 0 ? 0.0f : (float)FragmentedBytes / freeBytes;
+        }
+
+        GeometryHeapStats& operator+=(const GeometryHeapStats& other) {
+            BufferCount += other.BufferCount;
+            ReservedBytes += other.ReservedBytes;
+            UsedBytes += other.UsedBytes;
+            FreeRangeCount += other.FreeRangeCount;
+            FragmentedBytes += other.FragmentedBytes;
+            return *this;
+        }
+    };
+
+    // Large vertex or index buffers that primitives suballocate their geometry from, so primitives with the same vertex or
+    // index format share buffers and draw with base vertex and start index offsets instead of rebinding. Buffers are added
+    // when no free range fits and are kept for the lifetime of the heap. Allocation is thread safe; the data is uploaded by
+    // the next Flush, since the immediate context can only be used from the rendering thread.
+    struct GeometryHeap final {
+        static constexpr uint32_t DefaultBufferByteSize = 4 * 1024 * 1024;
+
+        GeometryHeap(_In_ ID3D11Device* device, UINT bindFlags, uint32_t elementSize, uint32_t bufferByteSize = DefaultBufferByteSize);
+
+        // Allocate a range of count elements and queue the upload of its data. Geometry larger than a buffer gets a buffer of its own.
+        // Returns null when count is 0, since an empty range has no offset to draw from.
+        std::shared_ptr<const GeometryRange> Allocate(_In_reads_bytes_(count* elementSize) const void* data, uint32_t count);
+
+        // Upload the data of ranges allocated since the last flush.
+        void Flush(_In_ ID3D11DeviceContext* context);
+
+        GeometryHeapStats GetStats() const;
+
+    private:
+        struct Impl;
+        std::shared_ptr<Impl> m_impl; // Shared with the allocated ranges, which free themselves into it.
+    };
+} // namespace Pbr
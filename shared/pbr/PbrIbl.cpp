@@ -0,0 +1,519 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include "PbrIbl.h"
+#include "PbrMipGenerator.h"
+#include "PbrParallel.h"
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace {
+    constexpr float Pi = 3.14159265358979f;
+    constexpr uint32_t FaceCount = 6;
+
+    // Work below this many samples is done inline, e.g. the smallest levels of the specular cube map.
+    constexpr uint64_t MinSamplesPerTask = 256 * 1024;
+
+    constexpr uint8_t ContainerMagic[4] = {'P', 'B', 'R', 'L'};
+    constexpr uint32_t ContainerVersion = 1;
+    constexpr size_t ContainerHeaderSize = 20 + 9 * sizeof(XMFLOAT3);
+
+    template <typename T>
+    T ReadValue(const uint8_t* data, size_t size, size_t offset) {
+        if (offset + sizeof(T) > size) {
+            throw std::exception("Data is truncated");
+        }
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void WriteValue(std::vector<uint8_t>& data, size_t offset, T value) {
+        std::memcpy(data.data() + offset, &value, sizeof(T));
+    }
+
+    // Low discrepancy sequence of sample points in [0, 1)^2.
+    XMFLOAT2 Hammersley(uint32_t index, uint32_t count) {
+        uint32_t bits = index;
+        bits = (bits << 16) | (bits >> 16);
+        bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+        bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+        bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+        bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+        return {(float)index / count, bits * 2.3283064365386963e-10f};
+    }
+
+    // Half vector distributed by the GGX distribution of the given alpha, around +Z.
+    XMFLOAT3 ImportanceSampleGgx(XMFLOAT2 xi, float alpha) {
+        const float phi = 2 * Pi * xi.x;
+        const float cosTheta = std::sqrt((1 - xi.y) / (1 + (alpha * alpha - 1) * xi.y));
+        const float sinTheta = std::sqrt(1 - cosTheta * cosTheta);
+        return {sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta};
+    }
+
+    uint16_t ToUnorm16(float value) {
+        return (uint16_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f);
+    }
+
+    // Direction through the point (u, v) in [-1, 1]^2 of a face, with v pointing down.
+    XMVECTOR FaceDirection(uint32_t face, float u, float v) {
+        switch (face) {
+        case 0:
+            return XMVectorSet(1, -v, -u, 0);
+        case 1:
+            return XMVectorSet(-1, -v, u, 0);
+        case 2:
+            return XMVectorSet(u, 1, v, 0);
+        case 3:
+            return XMVectorSet(u, -1, -v, 0);
+        case 4:
+            return XMVectorSet(u, -v, 1, 0);
+        default:
+            return XMVectorSet(-u, -v, -1, 0);
+        }
+    }
+
+    float TexelCoordinate(uint32_t texel, uint32_t size) {
+        return 2 * (texel + 0.5f) / size - 1;
+    }
+
+    float AreaElement(float x, float y) {
+        return std::atan2(x * y, std::sqrt(x * x + y * y + 1));
+    }
+
+    // Solid angle of the texel centered on (u, v) of a face of size texels.
+    float TexelSolidAngle(float u, float v, uint32_t size) {
+        const float halfTexel = 1.0f / size;
+        return AreaElement(u - halfTexel, v - halfTexel) - AreaElement(u - halfTexel, v + halfTexel) -
+               AreaElement(u + halfTexel, v - halfTexel) + AreaElement(u + halfTexel, v + halfTexel);
+    }
+
+    std::array<float, 9> XM_CALLCONV ShBasis(FXMVECTOR direction) {
+        XMFLOAT3 d;
+        XMStoreFloat3(&d, direction);
+        return {0.282095f,
+                0.488603f * d.y,
+                0.488603f * d.z,
+                0.488603f * d.x,
+                1.092548f * d.x * d.y,
+                1.092548f * d.y * d.z,
+                0.315392f * (3 * d.z * d.z - 1),
+                1.092548f * d.x * d.z,
+                0.546274f * (d.x * d.x - d.y * d.y)};
+    }
+
+    // A level of a cube map in full floats, faces in turn.
+    struct FloatCubeLevel {
+        uint32_t Size;
+        std::vector<XMFLOAT4> Texels;
+    };
+
+    // The most detailed level of the cube map and its box filtered mip chain, the source of the specular filtering.
+    std::vector<FloatCubeLevel> CreateSourceLevels(const Pbr::CubeMap& cubeMap) {
+        std::vector<FloatCubeLevel> levels(Pbr::MipGenerator::GetLevelCount(cubeMap.Size, cubeMap.Size));
+        levels[0].Size = cubeMap.Size;
+        levels[0].Texels.resize((size_t)FaceCount * cubeMap.Size * cubeMap.Size);
+        for (uint32_t face = 0; face < FaceCount; face++) {
+            const XMHALF4* source = &cubeMap.Texels[cubeMap.GetLevelOffset(face, 0)];
+            XMFLOAT4* destination = &levels[0].Texels[(size_t)face * cubeMap.Size * cubeMap.Size];
+            XMConvertHalfToFloatStream(&destination->x, sizeof(float), &source->x, sizeof(HALF), (size_t)cubeMap.Size * cubeMap.Size * 4);
+        }
+
+        for (size_t level = 1; level < levels.size(); level++) {
+            const FloatCubeLevel& parent = levels[level - 1];
+            FloatCubeLevel& child = levels[level];
+            child.Size = std::max(1u, parent.Size / 2);
+            child.Texels.resize((size_t)FaceCount * child.Size * child.Size);
+            for (uint32_t face = 0; face < FaceCount; face++) {
+                const XMFLOAT4* parentFace = &parent.Texels[(size_t)face * parent.Size * parent.Size];
+                for (uint32_t y = 0; y < child.Size; y++) {
+                    for (uint32_t x = 0; x < child.Size; x++) {
+                        const uint32_t x0 = std::min(x * 2, parent.Size - 1), x1 = std::min(x * 2 + 1, parent.Size - 1);
+                        const uint32_t y0 = std::min(y * 2, parent.Size - 1), y1 = std::min(y * 2 + 1, parent.Size - 1);
+                        const XMVECTOR sum = XMVectorAdd(XMVectorAdd(XMLoadFloat4(&parentFace[y0 * parent.Size + x0]),
+                                                                     XMLoadFloat4(&parentFace[y0 * parent.Size + x1])),
+                                                         XMVectorAdd(XMLoadFloat4(&parentFace[y1 * parent.Size + x0]),
+                                                                     XMLoadFloat4(&parentFace[y1 * parent.Size + x1])));
+                        XMStoreFloat4(&child.Texels[((size_t)face * child.Size + y) * child.Size + x], XMVectorScale(sum, 0.25f));
+                    }
+                }
+            }
+        }
+        return levels;
+    }
+
+    // Bilinear sample of a level, clamped at the edges of the face the direction points to.
+    XMVECTOR XM_CALLCONV SampleLevel(const FloatCubeLevel& level, FXMVECTOR direction) {
+        XMFLOAT3 d;
+        XMStoreFloat3(&d, direction);
+        const float ax = std::abs(d.x), ay = std::abs(d.y), az = std::abs(d.z);
+        uint32_t face;
+        float u, v, major;
+        if (ax >= ay && ax >= az) {
+            face = d.x > 0 ? 0 : 1;
+            u = d.x > 0 ? -d.z : d.z;
+            v = -d.y;
+            major = ax;
+        } else if (ay >= az) {
+            face = d.y > 0 ? 2 : 3;
+            u = d.x;
+            v = d.y > 0 ? d.z : -d.z;
+            major = ay;
+        } else {
+            face = d.z > 0 ? 4 : 5;
+            u = d.z > 0 ? d.x : -d.x;
+            v = -d.y;
+            major = az;
+        }
+
+        const float s = (u / major + 1) * 0.5f * level.Size - 0.5f;
+        const float t = (v / major + 1) * 0.5f * level.Size - 0.5f;
+        const float s0 = std::floor(s), t0 = std::floor(t);
+        const int maxTexel = (int)level.Size - 1;
+        const int x0 = std::clamp((int)s0, 0, maxTexel), x1 = std::clamp((int)s0 + 1, 0, maxTexel);
+        const int y0 = std::clamp((int)t0, 0, maxTexel), y1 = std::clamp((int)t0 + 1, 0, maxTexel);
+
+        const XMFLOAT4* texels = &level.Texels[(size_t)face * level.Size * level.Size];
+        const XMVECTOR top = XMVectorLerp(XMLoadFloat4(&texels[y0 * level.Size + x0]), XMLoadFloat4(&texels[y0 * level.Size + x1]), s - s0);
+        const XMVECTOR bottom =
+            XMVectorLerp(XMLoadFloat4(&texels[y1 * level.Size + x0]), XMLoadFloat4(&texels[y1 * level.Size + x1]), s - s0);
+        return XMVectorLerp(top, bottom, t - t0);
+    }
+
+    XMVECTOR XM_CALLCONV SampleTrilinear(const std::vector<FloatCubeLevel>& levels, FXMVECTOR direction, float lod) {
+        lod = std::clamp(lod, 0.0f, (float)(levels.size() - 1));
+        const uint32_t level0 = (uint32_t)lod;
+        const uint32_t level1 = std::min(level0 + 1, (uint32_t)levels.size() - 1);
+        const XMVECTOR sample0 = SampleLevel(levels[level0], direction);
+        return level0 == level1 ? sample0 : XMVectorLerp(sample0, SampleLevel(levels[level1], direction), lod - level0);
+    }
+
+    struct FilterSample {
+        XMFLOAT3 Direction; // Around +Z, the normal and view direction.
+        float Weight;
+        float Lod; // Source level covering the solid angle of the sample, which avoids aliasing with few samples.
+    };
+
+    // Weighted sum of the filter samples around the normal.
+    XMVECTOR XM_CALLCONV FilterDirection(const std::vector<FloatCubeLevel>& levels,
+                                         const std::vector<FilterSample>& samples,
+                                         FXMVECTOR normal) {
+        const XMVECTOR up = std::abs(XMVectorGetZ(normal)) < 0.999f ? g_XMIdentityR2 : g_XMIdentityR0;
+        const XMVECTOR tangent = XMVector3Normalize(XMVector3Cross(up, normal));
+        const XMVECTOR bitangent = XMVector3Cross(normal, tangent);
+
+        XMVECTOR color = XMVectorZero();
+        for (const FilterSample& sample : samples) {
+            XMVECTOR direction = XMVectorScale(tangent, sample.Direction.x);
+            direction = XMVectorMultiplyAdd(bitangent, XMVectorReplicate(sample.Direction.y), direction);
+            direction = XMVectorMultiplyAdd(normal, XMVectorReplicate(sample.Direction.z), direction);
+            color = XMVectorMultiplyAdd(SampleTrilinear(levels, direction, sample.Lod), XMVectorReplicate(sample.Weight), color);
+        }
+        return color;
+    }
+} // namespace
+
+namespace Pbr {
+    size_t CubeMap::GetLevelOffset(uint32_t face, uint32_t level) const {
+        size_t faceTexels = 0;
+        size_t levelOffset = 0;
+        for (uint32_t mip = 0; mip < MipLevels; mip++) {
+            const size_t mipSize = std::max(1u, Size >> mip);
+            if (mip == level) {
+                levelOffset = faceTexels;
+            }
+            faceTexels += mipSize * mipSize;
+        }
+        return face * faceTexels + levelOffset;
+    }
+
+    namespace Ibl {
+        std::vector<uint16_t> ComputeBrdfLut(uint32_t size, uint32_t sampleCount) {
+            if (size == 0 || sampleCount == 0) {
+                throw std::out_of_range("BRDF lookup tables need a size and samples");
+            }
+
+            std::vector<uint16_t> lut((size_t)size * size * 2);
+            Internal::ParallelFor(size, (uint64_t)size * sampleCount, MinSamplesPerTask, [&](uint32_t begin, uint32_t end) {
+                std::vector<XMFLOAT3> halfVectors(sampleCount);
+                for (uint32_t y = begin; y < end; y++) {
+                    // Roughness is squared as in the pixel shader, and k = alpha / 2 fits the Smith geometry term to GGX.
+                    const float roughness = 1 - (y + 0.5f) / size;
+                    const float alpha = roughness * roughness;
+                    const float k = alpha / 2;
+                    for (uint32_t i = 0; i < sampleCount; i++) {
+                        halfVectors[i] = ImportanceSampleGgx(Hammersley(i, sampleCount), alpha);
+                    }
+
+                    for (uint32_t x = 0; x < size; x++) {
+                        const float NdotV = (x + 0.5f) / size;
+                        const float sinV = std::sqrt(1 - NdotV * NdotV);
+                        const float geometryV = NdotV / (NdotV * (1 - k) + k);
+
+                        float scale = 0;
+                        float bias = 0;
+                        for (const XMFLOAT3& h : halfVectors) {
+                            const float VdotH = sinV * h.x + NdotV * h.z;
+                            const float NdotL = 2 * VdotH * h.z - NdotV;
+                            if (NdotL > 0 && VdotH > 0) {
+                                const float geometry = geometryV * NdotL / (NdotL * (1 - k) + k);
+                                const float visibility = geometry * VdotH / (h.z * NdotV);
+                                const float fresnel = std::pow(1 - VdotH, 5.0f);
+                                scale += (1 - fresnel) * visibility;
+                                bias += fresnel * visibility;
+                            }
+                        }
+
+                        const size_t texel = ((size_t)y * size + x) * 2;
+                        lut[texel] = ToUnorm16(scale / sampleCount);
+                        lut[texel + 1] = ToUnorm16(bias / sampleCount);
+                    }
+                }
+            });
+            return lut;
+        }
+
+        SphericalHarmonics9 ComputeIrradiance(const CubeMap& radiance) {
+            if (radiance.Size == 0 || radiance.Texels.size() < radiance.GetLevelOffset(FaceCount, 0)) {
+                throw std::out_of_range("Cube map has no texels");
+            }
+
+            double sums[9][3]{};
+            for (uint32_t face = 0; face < FaceCount; face++) {
+                const XMHALF4* texels = &radiance.Texels[radiance.GetLevelOffset(face, 0)];
+                for (uint32_t y = 0; y < radiance.Size; y++) {
+                    for (uint32_t x = 0; x < radiance.Size; x++) {
+                        const float u = TexelCoordinate(x, radiance.Size);
+                        const float v = TexelCoordinate(y, radiance.Size);
+                        const float solidAngle = TexelSolidAngle(u, v, radiance.Size);
+                        const std::array<float, 9> basis = ShBasis(XMVector3Normalize(FaceDirection(face, u, v)));
+
+                        XMFLOAT4 color;
+                        XMStoreFloat4(&color, XMLoadHalf4(&texels[y * radiance.Size + x]));
+                        for (size_t i = 0; i < basis.size(); i++) {
+                            const double weight = (double)basis[i] * solidAngle;
+                            sums[i][0] += color.x * weight;
+                            sums[i][1] += color.y * weight;
+                            sums[i][2] += color.z * weight;
+                        }
+                    }
+                }
+            }
+
+            // The cosine lobe convolution scales band l by A_l = pi, 2pi/3 and pi/4, and the result is divided by pi.
+            constexpr double BandScales[9] = {1, 2.0 / 3, 2.0 / 3, 2.0 / 3, 0.25, 0.25, 0.25, 0.25, 0.25};
+            SphericalHarmonics9 irradiance;
+            for (size_t i = 0; i < irradiance.Coefficients.size(); i++) {
+                irradiance.Coefficients[i] = {(float)(sums[i][0] * BandScales[i]),
+                                              (float)(sums[i][1] * BandScales[i]),
+                                              (float)(sums[i][2] * BandScales[i])};
+            }
+            return irradiance;
+        }
+
+        XMFLOAT3 XM_CALLCONV EvaluateIrradiance(const SphericalHarmonics9& irradiance, FXMVECTOR direction) {
+            const std::array<float, 9> basis = ShBasis(XMVector3Normalize(direction));
+            XMVECTOR sum = XMVectorZero();
+            for (size_t i = 0; i < basis.size(); i++) {
+                sum = XMVectorMultiplyAdd(XMLoadFloat3(&irradiance.Coefficients[i]), XMVectorReplicate(basis[i]), sum);
+            }
+            XMFLOAT3 result;
+            XMStoreFloat3(&result, XMVectorMax(sum, XMVectorZero()));
+            return result;
+        }
+
+        CubeMap PrefilterSpecular(const CubeMap& radiance, uint32_t size, uint32_t sampleCount) {
+            if (radiance.Size == 0 || radiance.Texels.size() < radiance.GetLevelOffset(FaceCount, 0)) {
+                throw std::out_of_range("Cube map has no texels");
+            }
+            if (size == 0 || sampleCount == 0) {
+                throw std::out_of_range("Prefiltered cube maps need a size and samples");
+            }
+
+            const std::vector<FloatCubeLevel> sourceLevels = CreateSourceLevels(radiance);
+            const float sourceTexelSolidAngle = 4 * Pi / (FaceCount * (float)radiance.Size * radiance.Size);
+
+            CubeMap specular;
+            specular.Size = size;
+            specular.MipLevels = MipGenerator::GetLevelCount(size, size);
+            specular.Texels.resize(specular.GetLevelOffset(FaceCount, 0));
+
+            std::vector<FilterSample> samples;
+
+            for (uint32_t level = 0; level < specular.MipLevels; level++) {
+                samples.clear();
+                if (level == 0) {
+                    samples.push_back({{0, 0, 1}, 1, std::max(0.0f, std::log2((float)radiance.Size / size))});
+                } else {
+                    const float roughness = (float)level / specular.MipLevels;
+                    const float alpha = roughness * roughness;
+                    for (uint32_t i = 0; i < sampleCount; i++) {
+                        const XMFLOAT3 h = ImportanceSampleGgx(Hammersley(i, sampleCount), alpha);
+                        const float NdotL = 2 * h.z * h.z - 1;
+                        if (NdotL > 0) {
+                            // With the view along the normal, the pdf of the reflected direction is D / 4.
+                            const float denominator = h.z * h.z * (alpha * alpha - 1) + 1;
+                            const float distribution = alpha * alpha / (Pi * denominator * denominator);
+                            const float sampleSolidAngle = 4 / (sampleCount * distribution);
+                            const float lod = std::max(0.0f, 0.5f * std::log2(sampleSolidAngle / sourceTexelSolidAngle) + 1);
+                            samples.push_back({{2 * h.z * h.x, 2 * h.z * h.y, NdotL}, NdotL, lod});
+                        }
+                    }
+                }
+
+                float weightSum = 0;
+                for (const FilterSample& sample : samples) {
+                    weightSum += sample.Weight;
+                }
+
+                const uint32_t levelSize = std::max(1u, size >> level);
+                const uint64_t samplesPerRow = (uint64_t)levelSize * samples.size();
+                Internal::ParallelFor(FaceCount * levelSize, samplesPerRow, MinSamplesPerTask, [&](uint32_t begin, uint32_t end) {
+                    for (uint32_t row = begin; row < end; row++) {
+                        const uint32_t face = row / levelSize;
+                        const uint32_t y = row % levelSize;
+                        XMHALF4* texels = &specular.Texels[specular.GetLevelOffset(face, level) + y * levelSize];
+                        for (uint32_t x = 0; x < levelSize; x++) {
+                            const XMVECTOR normal = FaceDirection(face, TexelCoordinate(x, levelSize), TexelCoordinate(y, levelSize));
+                            const XMVECTOR color = FilterDirection(sourceLevels, samples, XMVector3Normalize(normal));
+                            XMStoreHalf4(&texels[x], XMVectorSetW(XMVectorScale(color, 1 / weightSum), 1));
+                        }
+                    }
+                });
+            }
+            return specular;
+        }
+
+        CubeMap ReadDdsCubeMap(const uint8_t* data, size_t size) {
+            if (size < 128 || std::memcmp(data, "DDS ", 4) != 0) {
+                throw std::exception("Data is not a DDS file");
+            }
+
+            constexpr uint32_t MipMapCountFlag = 0x20000;  // DDSD_MIPMAPCOUNT
+            constexpr uint32_t FourCCFlag = 0x4;           // DDPF_FOURCC
+            constexpr uint32_t AllCubeMapFaces = 0xFE00;   // DDSCAPS2_CUBEMAP and DDSCAPS2_CUBEMAP_POSITIVEX to NEGATIVEZ
+            constexpr uint32_t TextureCubeMiscFlag = 0x4;  // D3D11_RESOURCE_MISC_TEXTURECUBE
+            constexpr uint32_t Dx10FourCC = '0' << 24 | '1' << 16 | 'X' << 8 | 'D';
+
+            const uint32_t flags = ReadValue<uint32_t>(data, size, 8);
+            const uint32_t height = ReadValue<uint32_t>(data, size, 12);
+            const uint32_t width = ReadValue<uint32_t>(data, size, 16);
+            const uint32_t mipLevels = (flags & MipMapCountFlag) ? std::max(1u, ReadValue<uint32_t>(data, size, 28)) : 1;
+            const uint32_t pixelFormatFlags = ReadValue<uint32_t>(data, size, 80);
+            const uint32_t fourCC = ReadValue<uint32_t>(data, size, 84);
+            const uint32_t caps2 = ReadValue<uint32_t>(data, size, 112);
+
+            size_t offset = 128;
+            bool cubeMap = (caps2 & AllCubeMapFaces) == AllCubeMapFaces;
+            uint32_t texelByteSize = 0;
+            if ((pixelFormatFlags & FourCCFlag) && fourCC == Dx10FourCC) {
+                const uint32_t dxgiFormat = ReadValue<uint32_t>(data, size, 128);
+                const uint32_t miscFlag = ReadValue<uint32_t>(data, size, 136);
+                const uint32_t arraySize = ReadValue<uint32_t>(data, size, 140);
+                cubeMap = (miscFlag & TextureCubeMiscFlag) && arraySize == 1;
+                texelByteSize = dxgiFormat == 10 /* DXGI_FORMAT_R16G16B16A16_FLOAT */   ? 8
+                                : dxgiFormat == 2 /* DXGI_FORMAT_R32G32B32A32_FLOAT */ ? 16
+                                                                                       : 0;
+                offset = 148;
+            } else if (pixelFormatFlags & FourCCFlag) {
+                texelByteSize = fourCC == 113 /* D3DFMT_A16B16G16R16F */ ? 8 : fourCC == 116 /* D3DFMT_A32B32G32R32F */ ? 16 : 0;
+            }
+            if (texelByteSize == 0) {
+                throw std::exception("DDS cube maps must be in the R16G16B16A16_FLOAT or R32G32B32A32_FLOAT format");
+            }
+            if (!cubeMap || width != height || width == 0) {
+                throw std::exception("DDS texture is not a cube map");
+            }
+
+            CubeMap result;
+            result.Size = width;
+            result.MipLevels = std::min(mipLevels, MipGenerator::GetLevelCount(width, height));
+            result.Texels.resize(result.GetLevelOffset(FaceCount, 0));
+
+            // The faces are stored in turn with all their levels, like the subresources of the texture.
+            for (uint32_t face = 0; face < FaceCount; face++) {
+                for (uint32_t level = 0; level < mipLevels; level++) {
+                    const size_t levelSize = std::max(1u, width >> level);
+                    const size_t levelByteSize = levelSize * levelSize * texelByteSize;
+                    if (offset + levelByteSize > size) {
+                        throw std::exception("Data is truncated");
+                    }
+                    if (level < result.MipLevels) {
+                        XMHALF4* texels = &result.Texels[result.GetLevelOffset(face, level)];
+                        if (texelByteSize == 8) {
+                            std::memcpy(texels, data + offset, levelByteSize);
+                        } else {
+                            XMConvertFloatToHalfStream(&texels->x,
+                                                       sizeof(HALF),
+                                                       reinterpret_cast<const float*>(data + offset),
+                                                       sizeof(float),
+                                                       levelSize * levelSize * 4);
+                        }
+                    }
+                    offset += levelByteSize;
+                }
+            }
+            return result;
+        }
+
+        std::vector<uint8_t> Write(const PrecomputedLighting& lighting) {
+            const size_t lutBytes = lighting.BrdfLut.size() * sizeof(uint16_t);
+            const size_t specularBytes = lighting.Specular.Texels.size() * sizeof(XMHALF4);
+            if (lighting.BrdfLut.size() != (size_t)lighting.BrdfLutSize * lighting.BrdfLutSize * 2 ||
+                lighting.Specular.Texels.size() != lighting.Specular.GetLevelOffset(FaceCount, 0)) {
+                throw std::exception("Precomputed lighting sizes don't match its data");
+            }
+
+            std::vector<uint8_t> data(ContainerHeaderSize + lutBytes + specularBytes);
+            std::memcpy(data.data(), ContainerMagic, sizeof(ContainerMagic));
+            WriteValue<uint32_t>(data, 4, ContainerVersion);
+            WriteValue<uint32_t>(data, 8, lighting.BrdfLutSize);
+            WriteValue<uint32_t>(data, 12, lighting.Specular.Size);
+            WriteValue<uint32_t>(data, 16, lighting.Specular.MipLevels);
+            for (size_t i = 0; i < lighting.DiffuseIrradiance.Coefficients.size(); i++) {
+                WriteValue<XMFLOAT3>(data, 20 + i * sizeof(XMFLOAT3), lighting.DiffuseIrradiance.Coefficients[i]);
+            }
+            std::memcpy(data.data() + ContainerHeaderSize, lighting.BrdfLut.data(), lutBytes);
+            std::memcpy(data.data() + ContainerHeaderSize + lutBytes, lighting.Specular.Texels.data(), specularBytes);
+            return data;
+        }
+
+        PrecomputedLighting Read(const uint8_t* data, size_t size) {
+            if (size < ContainerHeaderSize || std::memcmp(data, ContainerMagic, sizeof(ContainerMagic)) != 0 ||
+                ReadValue<uint32_t>(data, size, 4) != ContainerVersion) {
+                throw std::exception("Data is not precomputed lighting of this version");
+            }
+
+            PrecomputedLighting lighting;
+            lighting.BrdfLutSize = ReadValue<uint32_t>(data, size, 8);
+            lighting.Specular.Size = ReadValue<uint32_t>(data, size, 12);
+            lighting.Specular.MipLevels = ReadValue<uint32_t>(data, size, 16);
+            for (size_t i = 0; i < lighting.DiffuseIrradiance.Coefficients.size(); i++) {
+                lighting.DiffuseIrradiance.Coefficients[i] = ReadValue<XMFLOAT3>(data, size, 20 + i * sizeof(XMFLOAT3));
+            }
+            if (lighting.Specular.MipLevels > MipGenerator::GetLevelCount(lighting.Specular.Size, lighting.Specular.Size)) {
+                throw std::exception("Precomputed lighting has too many specular levels");
+            }
+
+            const size_t lutTexels = (size_t)lighting.BrdfLutSize * lighting.BrdfLutSize * 2;
+            const size_t specularTexels = lighting.Specular.GetLevelOffset(FaceCount, 0);
+            if (size != ContainerHeaderSize + lutTexels * sizeof(uint16_t) + specularTexels * sizeof(XMHALF4)) {
+                throw std::exception("Precomputed lighting has an unexpected size");
+            }
+            lighting.BrdfLut.resize(lutTexels);
+            std::memcpy(lighting.BrdfLut.data(), data + ContainerHeaderSize, lutTexels * sizeof(uint16_t));
+            lighting.Specular.Texels.resize(specularTexels);
+            std::memcpy(lighting.Specular.Texels.data(),
+                        data + ContainerHeaderSize + lutTexels * sizeof(uint16_t),
+                        specularTexels * sizeof(XMHALF4));
+            return lighting;
+        }
+    } // namespace Ibl
+} // namespace Pbr
@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// Precomputation of image based lighting: the split-sum BRDF lookup table, the diffuse irradiance as spherical harmonics and
+// the GGX prefiltered mips of the specular environment map, with a binary container to cache the results. The results are
+// deterministic for the same inputs and settings. This code has no graphics API dependency.
+//
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+namespace Pbr {
+    // A cube map of linear RGB radiance in half floats, the layout of a DXGI_FORMAT_R16G16B16A16_FLOAT texture. Faces are in
+    // the D3D order +X, -X, +Y, -Y, +Z, -Z.
+    struct CubeMap {
+        uint32_t Size{0}; // Width and height of the faces at the most detailed level.
+        uint32_t MipLevels{0};
+        std::vector<DirectX::PackedVector::XMHALF4> Texels; // In subresource order: the levels of each face in turn.
+
+        // Index in Texels of the first texel of a level of a face.
+        size_t GetLevelOffset(uint32_t face, uint32_t level) const;
+    };
+
+    // Irradiance divided by pi, which is what the pixel shader reads from a diffuse environment map, as the coefficients of
+    // the spherical harmonics bands 0 to 2.
+    struct SphericalHarmonics9 {
+        std::array<DirectX::XMFLOAT3, 9> Coefficients{};
+    };
+
+    // The results of the precomputation.
+    struct PrecomputedLighting {
+        uint32_t BrdfLutSize{0};
+        std::vector<uint16_t> BrdfLut; // Rows of R16G16_UNORM scale and bias on F0, indexed like the pixel shader samples it.
+        SphericalHarmonics9 DiffuseIrradiance;
+        CubeMap Specular; // Empty when there is no environment.
+    };
+
+    namespace Ibl {
+        constexpr uint32_t DefaultBrdfLutSize = 128;
+        constexpr uint32_t DefaultBrdfSampleCount = 256;
+        constexpr uint32_t DefaultSpecularSize = 256;
+        constexpr uint32_t DefaultSpecularSampleCount = 64;
+
+        // Integrate the GGX BRDF with the split-sum approximation. Texel (x, y) holds NdotV = (x + 0.5) / size and perceptual
+        // roughness 1 - (y + 0.5) / size, matching the texture coordinates of the pixel shader.
+        std::vector<uint16_t> ComputeBrdfLut(uint32_t size, uint32_t sampleCount);
+
+        // Project the most detailed level of a radiance cube map onto spherical harmonics, convolved with the cosine lobe.
+        SphericalHarmonics9 ComputeIrradiance(const CubeMap& radiance);
+
+        // Irradiance divided by pi in a direction, as the pixel shader evaluates it.
+        DirectX::XMFLOAT3 XM_CALLCONV EvaluateIrradiance(const SphericalHarmonics9& irradiance, DirectX::FXMVECTOR direction);
+
+        // Filter the most detailed level of a radiance cube map with the GGX distribution into a full mip chain of faces of
+        // size texels. Level m holds perceptual roughness m / MipLevels, matching the level the pixel shader samples.
+        // Faces are filtered in parallel on the system thread pool.
+        CubeMap PrefilterSpecular(const CubeMap& radiance, uint32_t size, uint32_t sampleCount);
+
+        // Read a cube map from a DDS file in the R16G16B16A16_FLOAT or R32G32B32A32_FLOAT format, with all its levels.
+        // Throws for other formats and for textures that aren't cube maps.
+        CubeMap ReadDdsCubeMap(const uint8_t* data, size_t size);
+
+        // Write the precomputed lighting to a binary container, and read it back. Read throws for data that wasn't written
+        // by the same version of Write.
+        std::vector<uint8_t> Write(const PrecomputedLighting& lighting);
+        PrecomputedLighting Read(const uint8_t* data, size_t size);
+    } // namespace Ibl
+} // namespace Pbr
@@ -0,0 +1,370 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "stb_image.h" // For the zlib decoder; the implementation is in the Gltf library.
+#include "PbrKtx2.h"
+
+namespace {
+    constexpr uint8_t Identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+    constexpr size_t HeaderSize = 80;    // Identifier, header and index.
+    constexpr size_t LevelIndexSize = 24; // byteOffset, byteLength and uncompressedByteLength per level.
+    constexpr uint32_t MaxDimension = 16384; // D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION
+
+    enum SupercompressionScheme : uint32_t {
+        None = 0,
+        BasisLZ = 1,
+        Zstandard = 2,
+        Zlib = 3,
+    };
+
+    enum DfdColorModel : uint8_t {
+        RGBSDA = 1,
+        BC1A = 128,
+        BC3 = 130,
+        BC4 = 131,
+        BC5 = 132,
+        BC7 = 134,
+        ETC1S = 163,
+        UASTC = 166,
+    };
+
+    struct FormatMapping {
+        uint32_t VkFormat;
+        std::optional<Pbr::BlockFormat> Format;
+        bool SRGB;
+    };
+
+    // The first entry for each format and color space is the one written.
+    constexpr FormatMapping FormatMappings[] = {
+        {37 /* VK_FORMAT_R8G8B8A8_UNORM */, std::nullopt, false},
+        {43 /* VK_FORMAT_R8G8B8A8_SRGB */, std::nullopt, true},
+        {131 /* VK_FORMAT_BC1_RGB_UNORM_BLOCK */, Pbr::BlockFormat::BC1, false},
+        {132 /* VK_FORMAT_BC1_RGB_SRGB_BLOCK */, Pbr::BlockFormat::BC1, true},
+        {133 /* VK_FORMAT_BC1_RGBA_UNORM_BLOCK */, Pbr::BlockFormat::BC1, false},
+        {134 /* VK_FORMAT_BC1_RGBA_SRGB_BLOCK */, Pbr::BlockFormat::BC1, true},
+        {137 /* VK_FORMAT_BC3_UNORM_BLOCK */, Pbr::BlockFormat::BC3, false},
+        {138 /* VK_FORMAT_BC3_SRGB_BLOCK */, Pbr::BlockFormat::BC3, true},
+        {139 /* VK_FORMAT_BC4_UNORM_BLOCK */, Pbr::BlockFormat::BC4, false},
+        {141 /* VK_FORMAT_BC5_UNORM_BLOCK */, Pbr::BlockFormat::BC5, false},
+        {145 /* VK_FORMAT_BC7_UNORM_BLOCK */, Pbr::BlockFormat::BC7, false},
+        {146 /* VK_FORMAT_BC7_SRGB_BLOCK */, Pbr::BlockFormat::BC7, true},
+    };
+
+    template <typename T>
+    T ReadValue(const uint8_t* data, size_t size, size_t offset) {
+        if (offset + sizeof(T) > size) {
+            throw std::runtime_error("KTX2 data is truncated");
+        }
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void WriteValue(std::vector<uint8_t>& data, size_t offset, T value) {
+        std::memcpy(data.data() + offset, &value, sizeof(T));
+    }
+
+    // Computed in 64 bits so that it can't overflow for any 32-bit width and height, even where size_t is 32 bits.
+    uint64_t GetLevelByteSize(const std::optional<Pbr::BlockFormat>& format, uint32_t width, uint32_t height) {
+        if (!format) {
+            return static_cast<uint64_t>(width) * height * 4;
+        }
+        const uint64_t blockColumns = (static_cast<uint64_t>(width) + Pbr::BlockCompression::BlockDimension - 1) /
+                                      Pbr::BlockCompression::BlockDimension;
+        const uint64_t blockRows = (static_cast<uint64_t>(height) + Pbr::BlockCompression::BlockDimension - 1) /
+                                   Pbr::BlockCompression::BlockDimension;
+        return blockColumns * blockRows * Pbr::BlockCompression::GetBlockByteSize(*format);
+    }
+
+    // Size of a mip level along one axis. Levels past the end of the mip chain are 1, rather than shifting by 32 or more.
+    uint32_t GetMipDimension(uint32_t size, uint32_t level) {
+        return level < 32 ? std::max(1u, size >> level) : 1u;
+    }
+
+    // Bytes per texel block, which is also the required alignment of the level data.
+    uint32_t GetTexelBlockByteSize(const std::optional<Pbr::BlockFormat>& format) {
+        return format ? Pbr::BlockCompression::GetBlockByteSize(*format) : 4;
+    }
+
+    struct DfdSample {
+        uint16_t BitOffset;
+        uint8_t BitLength;
+        uint8_t ChannelType; // Channel id in the low 4 bits, qualifiers in the high 4 bits.
+        uint32_t Upper;
+    };
+
+    // Basic data format descriptor (Khronos Data Format Specification, section 5) for the supported formats.
+    std::vector<uint8_t> CreateDataFormatDescriptor(const std::optional<Pbr::BlockFormat>& format, bool sRGB) {
+        constexpr uint8_t Alpha = 15, Linear = 0x10;
+        uint8_t colorModel = RGBSDA;
+        std::vector<DfdSample> samples;
+        if (!format) {
+            samples = {{0, 8, 0, 255}, {8, 8, 1, 255}, {16, 8, 2, 255}, {24, 8, static_cast<uint8_t>(Alpha | (sRGB ? Linear : 0)), 255}};
+        } else {
+            switch (*format) {
+            case Pbr::BlockFormat::BC1:
+                colorModel = BC1A;
+                samples = {{0, 64, 0, UINT32_MAX}};
+                break;
+            case Pbr::BlockFormat::BC3:
+                colorModel = BC3;
+                samples = {{0, 64, static_cast<uint8_t>(Alpha | (sRGB ? Linear : 0)), UINT32_MAX}, {64, 64, 0, UINT32_MAX}};
+                break;
+            case Pbr::BlockFormat::BC4:
+                colorModel = BC4;
+                samples = {{0, 64, 0, UINT32_MAX}};
+                break;
+            case Pbr::BlockFormat::BC5:
+                colorModel = BC5;
+                samples = {{0, 64, 0, UINT32_MAX}, {64, 64, 1, UINT32_MAX}};
+                break;
+            case Pbr::BlockFormat::BC7:
+                colorModel = BC7;
+                samples = {{0, 128, 0, UINT32_MAX}};
+                break;
+            }
+        }
+
+        const uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+        std::vector<uint8_t> dfd(4 + blockSize, 0);
+        WriteValue<uint32_t>(dfd, 0, static_cast<uint32_t>(dfd.size()));
+        WriteValue<uint32_t>(dfd, 4, 0);                   // Vendor Khronos, basic descriptor type.
+        WriteValue<uint32_t>(dfd, 8, 2 | (blockSize << 16)); // Version 1.3 of the data format specification.
+        dfd[12] = colorModel;
+        dfd[13] = 1;            // BT.709 primaries.
+        dfd[14] = sRGB ? 2 : 1; // sRGB or linear transfer function.
+        dfd[15] = 0;            // Straight alpha.
+        dfd[16] = dfd[17] = format ? Pbr::BlockCompression::BlockDimension - 1 : 0;
+        dfd[20] = static_cast<uint8_t>(GetTexelBlockByteSize(format));
+        for (size_t i = 0; i < samples.size(); i++) {
+            const size_t offset = 28 + 16 * i;
+            WriteValue<uint16_t>(dfd, offset, samples[i].BitOffset);
+            dfd[offset + 2] = samples[i].BitLength - 1;
+            dfd[offset + 3] = samples[i].ChannelType;
+            WriteValue<uint32_t>(dfd, offset + 8, 0);
+            WriteValue<uint32_t>(dfd, offset + 12, samples[i].Upper);
+        }
+        return dfd;
+    }
+    const FormatMapping* FindFormatMapping(uint32_t vkFormat) {
+        const auto mapping = std::find_if(
+            std::begin(FormatMappings), std::end(FormatMappings), [&](const FormatMapping& m) { return m.VkFormat == vkFormat; });
+        return mapping != std::end(FormatMappings) ? &*mapping : nullptr;
+    }
+
+    // Color model of the basic data format descriptor, or 0 if the descriptor is out of range.
+    uint8_t GetColorModel(const uint8_t* data, size_t size) {
+        const uint32_t dfdOffset = ReadValue<uint32_t>(data, size, 48);
+        return dfdOffset < size && size - dfdOffset > 12 ? data[dfdOffset + 12] : 0;
+    }
+
+    // Check the header of a KTX2 file for features this reader doesn't support. Returns null if the file can be read.
+    const char* GetUnsupportedReason(const uint8_t* data, size_t size) {
+        if (size < HeaderSize) {
+            return "KTX2 data is truncated";
+        }
+
+        const uint32_t vkFormat = ReadValue<uint32_t>(data, size, 12);
+        const uint32_t width = ReadValue<uint32_t>(data, size, 20);
+        const uint32_t height = ReadValue<uint32_t>(data, size, 24);
+        const uint32_t depth = ReadValue<uint32_t>(data, size, 28);
+        const uint32_t layerCount = ReadValue<uint32_t>(data, size, 32);
+        const uint32_t faceCount = ReadValue<uint32_t>(data, size, 36);
+        const uint32_t levelCount = ReadValue<uint32_t>(data, size, 40);
+        const uint32_t supercompression = ReadValue<uint32_t>(data, size, 44);
+
+        if (vkFormat == 0 /* VK_FORMAT_UNDEFINED */) {
+            const uint8_t colorModel = GetColorModel(data, size);
+            return colorModel == UASTC   ? "KTX2 image uses UASTC encoding, which requires a Basis Universal transcoder"
+                   : colorModel == ETC1S ? "KTX2 image uses ETC1S encoding, which requires a Basis Universal transcoder"
+                                         : "KTX2 image has an undefined format";
+        }
+        if (supercompression != None && supercompression != Zlib) {
+            return "KTX2 supercompression scheme is not supported";
+        }
+        if (width == 0 || height == 0 || depth > 1 || layerCount > 1 || faceCount != 1) {
+            return "Only 2D KTX2 textures are supported";
+        }
+        if (width > MaxDimension || height > MaxDimension) {
+            return "KTX2 image is larger than the maximum texture size of 16384";
+        }
+        if (levelCount > Pbr::MipGenerator::GetLevelCount(width, height)) {
+            return "KTX2 image has more levels than its mip chain";
+        }
+        if (std::max(1u, levelCount) > (size - HeaderSize) / LevelIndexSize) {
+            return "KTX2 data is truncated";
+        }
+        if (FindFormatMapping(vkFormat) == nullptr) {
+            return "KTX2 vkFormat is not supported";
+        }
+        return nullptr;
+    }
+} // namespace
+
+namespace Pbr {
+    namespace Ktx2 {
+        bool IsKtx2(const uint8_t* data, size_t size) {
+            return size >= sizeof(Identifier) && std::memcmp(data, Identifier, sizeof(Identifier)) == 0;
+        }
+
+        bool IsSupported(const uint8_t* data, size_t size) {
+            return IsKtx2(data, size) && GetUnsupportedReason(data, size) == nullptr;
+        }
+
+        bool IsBasisUniversal(const uint8_t* data, size_t size) {
+            if (!IsKtx2(data, size) || size < HeaderSize) {
+                return false;
+            }
+            const uint8_t colorModel = GetColorModel(data, size);
+            return ReadValue<uint32_t>(data, size, 44) == BasisLZ || colorModel == ETC1S || colorModel == UASTC;
+        }
+
+        Ktx2Image Read(const uint8_t* data, size_t size) {
+            if (!IsKtx2(data, size)) {
+                throw std::runtime_error("Data is not a KTX2 file");
+            }
+            if (const char* reason = GetUnsupportedReason(data, size)) {
+                throw std::runtime_error(reason);
+            }
+
+            const uint32_t vkFormat = ReadValue<uint32_t>(data, size, 12);
+            const uint32_t width = ReadValue<uint32_t>(data, size, 20);
+            const uint32_t height = ReadValue<uint32_t>(data, size, 24);
+            const uint32_t levelCount = std::max(1u, ReadValue<uint32_t>(data, size, 40));
+            const uint32_t supercompression = ReadValue<uint32_t>(data, size, 44);
+            const FormatMapping* mapping = FindFormatMapping(vkFormat);
+
+            Ktx2Image image;
+            image.Format = mapping->Format;
+            image.SRGB = mapping->SRGB;
+            image.Levels.reserve(levelCount);
+            for (uint32_t level = 0; level < levelCount; level++) {
+                const size_t indexOffset = HeaderSize + level * LevelIndexSize;
+                const uint64_t byteOffset = ReadValue<uint64_t>(data, size, indexOffset);
+                const uint64_t byteLength = ReadValue<uint64_t>(data, size, indexOffset + 8);
+                const uint64_t uncompressedByteLength = ReadValue<uint64_t>(data, size, indexOffset + 16);
+                if (byteOffset > size || byteLength > size - byteOffset) {
+                    throw std::runtime_error("KTX2 level data is out of range");
+                }
+
+                // Validate the level size against the file before allocating it.
+                const uint32_t mipWidth = GetMipDimension(width, level);
+                const uint32_t mipHeight = GetMipDimension(height, level);
+                const uint64_t levelByteSize = GetLevelByteSize(image.Format, mipWidth, mipHeight);
+                if ((supercompression == Zlib ? uncompressedByteLength : byteLength) != levelByteSize) {
+                    throw std::runtime_error("KTX2 level data has an unexpected size");
+                }
+
+                MipLevel& mip = image.Levels.emplace_back();
+                mip.Width = mipWidth;
+                mip.Height = mipHeight;
+                mip.Pixels.resize(static_cast<size_t>(levelByteSize));
+
+                const uint8_t* levelData = data + byteOffset;
+                if (supercompression == Zlib) {
+                    if (byteLength > static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+                        throw std::runtime_error("KTX2 level data is out of range");
+                    }
+                    const int decodedSize = stbi_zlib_decode_buffer(reinterpret_cast<char*>(mip.Pixels.data()),
+                                                                    static_cast<int>(mip.Pixels.size()),
+                                                                    reinterpret_cast<const char*>(levelData),
+                                                                    static_cast<int>(byteLength));
+                    if (decodedSize != static_cast<int>(mip.Pixels.size())) {
+                        throw std::runtime_error("KTX2 level data failed to inflate");
+                    }
+                } else {
+                    std::memcpy(mip.Pixels.data(), levelData, mip.Pixels.size());
+                }
+            }
+
+            return image;
+        }
+
+        Ktx2Image Transcode(const Ktx2Image& image, const std::optional<BlockFormat>& format) {
+            if (image.Format == format) {
+                return image;
+            }
+
+            Ktx2Image transcoded;
+            transcoded.Format = format;
+            transcoded.SRGB = image.SRGB;
+            transcoded.Levels.reserve(image.Levels.size());
+            for (const MipLevel& level : image.Levels) {
+                std::vector<uint8_t> pixels =
+                    image.Format ? BlockCompression::Decompress(level.Pixels.data(), level.Width, level.Height, *image.Format)
+                                 : level.Pixels;
+                if (format) {
+                    pixels = BlockCompression::Compress(pixels.data(), level.Width, level.Height, *format);
+                }
+                transcoded.Levels.push_back({level.Width, level.Height, std::move(pixels)});
+            }
+            return transcoded;
+        }
+
+        std::vector<uint8_t> Write(const Ktx2Image& image) {
+            if (image.Levels.empty()) {
+                throw std::runtime_error("KTX2 image has no levels");
+            }
+
+            // BC4 and BC5 have no sRGB variant.
+            const bool sRGB = image.SRGB && image.Format != BlockFormat::BC4 && image.Format != BlockFormat::BC5;
+            const auto mapping = std::find_if(std::begin(FormatMappings), std::end(FormatMappings), [&](const FormatMapping& m) {
+                return m.Format == image.Format && m.SRGB == sRGB;
+            });
+            if (mapping == std::end(FormatMappings)) {
+                throw std::runtime_error("Image format cannot be written to KTX2");
+            }
+
+            const std::vector<uint8_t> dfd = CreateDataFormatDescriptor(image.Format, mapping->SRGB);
+            const size_t levelCount = image.Levels.size();
+            const size_t dfdOffset = HeaderSize + levelCount * LevelIndexSize;
+            const size_t alignment = GetTexelBlockByteSize(image.Format);
+
+            // Level data follows the descriptor, smallest level first, each aligned to the texel block size.
+            std::vector<size_t> levelOffsets(levelCount);
+            size_t fileSize = dfdOffset + dfd.size();
+            for (size_t level = levelCount; level-- > 0;) {
+                fileSize = (fileSize + alignment - 1) / alignment * alignment;
+                levelOffsets[level] = fileSize;
+                fileSize += image.Levels[level].Pixels.size();
+            }
+
+            std::vector<uint8_t> file(fileSize, 0);
+            std::memcpy(file.data(), Identifier, sizeof(Identifier));
+            WriteValue<uint32_t>(file, 12, mapping->VkFormat);
+            WriteValue<uint32_t>(file, 16, 1); // typeSize
+            WriteValue<uint32_t>(file, 20, image.Levels[0].Width);
+            WriteValue<uint32_t>(file, 24, image.Levels[0].Height);
+            WriteValue<uint32_t>(file, 28, 0); // pixelDepth
+            WriteValue<uint32_t>(file, 32, 0); // layerCount
+            WriteValue<uint32_t>(file, 36, 1); // faceCount
+            WriteValue<uint32_t>(file, 40, static_cast<uint32_t>(levelCount));
+            WriteValue<uint32_t>(file, 44, None);
+            WriteValue<uint32_t>(file, 48, static_cast<uint32_t>(dfdOffset));
+            WriteValue<uint32_t>(file, 52, static_cast<uint32_t>(dfd.size()));
+            // Key/value data and supercompression global data are empty.
+
+            for (size_t level = 0; level < levelCount; level++) {
+                const MipLevel& mip = image.Levels[level];
+                if (mip.Pixels.size() != GetLevelByteSize(image.Format, mip.Width, mip.Height)) {
+                    throw std::runtime_error("KTX2 level data has an unexpected size");
+                }
+
+                const size_t indexOffset = HeaderSize + level * LevelIndexSize;
+                WriteValue<uint64_t>(file, indexOffset, levelOffsets[level]);
+                WriteValue<uint64_t>(file, indexOffset + 8, mip.Pixels.size());
+                WriteValue<uint64_t>(file, indexOffset + 16, mip.Pixels.size());
+                std::memcpy(file.data() + levelOffsets[level], mip.Pixels.data(), mip.Pixels.size());
+            }
+            std::memcpy(file.data() + dfdOffset, dfd.data(), dfd.size());
+
+            return file;
+        }
+    } // namespace Ktx2
+} // namespace Pbr
@@ -0,0 +1,49 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// Reading and writing of KTX2 texture containers (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html), as
+// referenced by the KHR_texture_basisu glTF extension. This code has no graphics API dependency.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "PbrBlockCompression.h"
+#include "PbrMipGenerator.h"
+
+namespace Pbr {
+    // A 2D texture with its mip chain as stored in a KTX2 container.
+    struct Ktx2Image {
+        std::optional<BlockFormat> Format; // Empty for 8-bit RGBA.
+        bool SRGB{false};
+        std::vector<MipLevel> Levels; // Most detailed level first. Pixels holds the blocks for block compressed formats.
+    };
+
+    namespace Ktx2 {
+        // Returns whether the data starts with the KTX2 file identifier.
+        bool IsKtx2(const uint8_t* data, size_t size);
+
+        // Returns whether Read can load the KTX2 file, based on its header.
+        bool IsSupported(const uint8_t* data, size_t size);
+
+        // Returns whether the KTX2 file holds a Basis Universal payload (BasisLZ/ETC1S or UASTC), based on its header.
+        bool IsBasisUniversal(const uint8_t* data, size_t size);
+
+        // Read a 2D texture in a BC1/3/4/5/7 or 8-bit RGBA format. Level data may be stored as is or with ZLIB supercompression.
+        // Throws for Basis Universal payloads and Zstandard supercompression, which need a transcoder that isn't part of this
+        // library, and for arrays, cube maps and 3D textures. Also throws for malformed files: images larger than 16384
+        // texels, more levels than the mip chain has, or level data that is out of range or doesn't match the size of its level.
+        Ktx2Image Read(const uint8_t* data, size_t size);
+
+        // Convert the levels of an image to another format on the CPU: block compressed levels are decoded, and compressed
+        // again if the format is block compressed. Used for block formats the device can't sample.
+        Ktx2Image Transcode(const Ktx2Image& image, const std::optional<BlockFormat>& format);
+
+        // Write a texture without supercompression, e.g. to store the output of the block compressor for later loads.
+        std::vector<uint8_t> Write(const Ktx2Image& image);
+    } // namespace Ktx2
+} // namespace Pbr
@@ -8,6 +8,18 @@
 
 using namespace DirectX;
 
+namespace {
+    bool IsTwoChannelNormalTexture(_In_opt_ ID3D11ShaderResourceView* textureView) {
+        if (textureView == nullptr) {
+            return false;
+        }
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC desc;
+        textureView->GetDesc(&desc);
+        return desc.Format == DXGI_FORMAT_BC5_UNORM || desc.Format == DXGI_FORMAT_R8G8_UNORM || desc.Format == DXGI_FORMAT_R16G16_UNORM;
+    }
+} // namespace
+
 namespace Pbr {
     Material::Material(Pbr::Resources const& pbrResources) {
         const CD3D11_BUFFER_DESC constantBufferDesc(sizeof(ConstantBufferData), D3D11_BIND_CONSTANT_BUFFER);
@@ -23,6 +35,8 @@ namespace Pbr {
         clone->m_samplers = m_samplers;
         clone->m_alphaBlended = m_alphaBlended;
         clone->m_doubleSided = m_doubleSided;
+        clone->m_unlit = m_unlit;
+        clone->m_imageBasedLighting = m_imageBasedLighting;
         return clone;
     }
 
@@ -60,12 +74,25 @@ namespace Pbr {
                               _In_ ID3D11ShaderResourceView* textureView,
                               _In_opt_ ID3D11SamplerState* sampler) {
         m_textures[slot].copy_from(textureView);
+        m_textureSlices[slot] = nullptr;
+        m_pixelShaderPermutation.reset();
+
+        if (slot == ShaderSlots::Normal) {
+            const uint32_t twoChannel = IsTwoChannelNormalTexture(textureView) ? 1 : 0;
+            if (m_parameters.NormalTextureTwoChannel != twoChannel) {
+                Parameters().NormalTextureTwoChannel = twoChannel;
+            }
+        }
 
         if (sampler) {
             m_samplers[slot].copy_from(sampler);
         }
     }
 
+    ID3D11ShaderResourceView* Material::GetTexture(ShaderSlots::PSMaterial slot) const {
+        return m_textures[slot].get();
+    }
+
     void Material::SetDoubleSided(bool doubleSided) {
         m_doubleSided = doubleSided;
     }
@@ -78,33 +105,102 @@ namespace Pbr {
         m_alphaBlended = alphaBlended;
     }
 
-    void Material::Bind(_In_ ID3D11DeviceContext* context, const Resources& pbrResources) const {
-        // If the parameters of the constant buffer have changed, update the constant buffer.
-        if (m_parametersChanged) {
-            m_parametersChanged = false;
-            context->UpdateSubresource(m_constantBuffer.get(), 0, nullptr, &m_parameters, 0, 0);
-        }
+    void Material::SetUnlit(bool unlit) {
+        m_unlit = unlit;
+        m_pixelShaderPermutation.reset();
+    }
 
-        pbrResources.SetBlendState(context, m_alphaBlended);
-        pbrResources.SetDepthStencilState(context, m_alphaBlended);
-        pbrResources.SetRasterizerState(context, m_doubleSided, m_wireframe);
+    void Material::SetImageBasedLighting(bool imageBasedLighting) {
+        m_imageBasedLighting = imageBasedLighting;
+        m_pixelShaderPermutation.reset();
+    }
 
-        ID3D11Buffer* psConstantBuffers[] = {m_constantBuffer.get()};
-        context->PSSetConstantBuffers(Pbr::ShaderSlots::ConstantBuffers::Material, 1, psConstantBuffers);
+    PixelShaderPermutation Material::GetPixelShaderPermutation(const Resources& pbrResources) const {
+        // The solid color textures of previous device resources are no longer neutral.
+        const uint32_t pipelineStateGeneration = pbrResources.GetPipelineStateGeneration();
+        if (!m_pixelShaderPermutation || m_pixelShaderPermutationGeneration != pipelineStateGeneration) {
+            MaterialFeatures features;
+            features.Textured = false;
+            for (size_t slot = 0; slot < TextureCount; slot++) {
+                features.Textured |= !pbrResources.IsNeutralMaterialTexture((ShaderSlots::PSMaterial)slot, m_textures[slot].get());
+            }
+            features.Lit = !m_unlit;
+            features.ImageBasedLighting = m_imageBasedLighting;
+            m_pixelShaderPermutation = SelectPixelShaderPermutation(features);
+            m_pixelShaderPermutationGeneration = pipelineStateGeneration;
+        }
+        return *m_pixelShaderPermutation;
+    }
 
-        static_assert(Pbr::ShaderSlots::BaseColor == 0, "BaseColor must be the first slot");
+    void Material::Bind(_In_ ID3D11DeviceContext* context, const Resources& pbrResources, VertexFormat vertexFormat) const {
+        const PipelineStateKey pipelineStateKey = pbrResources.GetPipelineStateKey(
+            m_alphaBlended, m_doubleSided, m_wireframe, vertexFormat, GetPixelShaderPermutation(pbrResources));
+        const uint32_t pipelineStateGeneration = pbrResources.GetPipelineStateGeneration();
+        if (m_pipelineState == nullptr || m_pipelineStateKey != pipelineStateKey || m_pipelineStateGeneration != pipelineStateGeneration) {
+            m_pipelineState = &pbrResources.GetPipelineState(pipelineStateKey);
+            m_pipelineStateKey = pipelineStateKey;
+            m_pipelineStateGeneration = pipelineStateGeneration;
+        }
+        pbrResources.BindPipelineState(context, *m_pipelineState);
+
+        // The imports only import again when a texture or sampler changed, or the render device was recreated.
+        if (pbrResources.GetTextureArraysEnabled()) {
+            // Slices of a previous texture array pool went away with the device resources that the generation tracks.
+            if (m_textureSlicesGeneration != pipelineStateGeneration) {
+                m_textureSlices = {};
+                m_textureSlicesGeneration = pipelineStateGeneration;
+            }
+            for (size_t slot = 0; slot < TextureCount; slot++) {
+                if (!m_textureSlices[slot] && m_textures[slot]) {
+                    m_textureSlices[slot] = pbrResources.GetTextureArrayPool().GetSlice(context, m_textures[slot].get());
+                    if (m_parameters.TextureSlices[slot] != m_textureSlices[slot]->Slice) {
+                        m_parameters.TextureSlices[slot] = m_textureSlices[slot]->Slice;
+                        m_parametersChanged = true;
+                        m_tableParametersChanged = true;
+                    }
+                }
+                pbrResources.Import(m_textureImports[slot], m_textureSlices[slot] ? m_textureSlices[slot]->ArrayView.get() : nullptr);
+            }
+        } else {
+            for (size_t slot = 0; slot < TextureCount; slot++) {
+                pbrResources.Import(m_textureImports[slot], m_textures[slot].get());
+            }
+        }
 
-        std::array<ID3D11ShaderResourceView*, TextureCount> textures;
-        std::transform(m_textures.begin(), m_textures.end(), textures.begin(), [](const auto& texture) { return texture.get(); });
-        context->PSSetShaderResources(Pbr::ShaderSlots::BaseColor, (UINT)textures.size(), textures.data());
+        if (pbrResources.GetMaterialTableEnabled()) {
+            // Slots of a previous material table went away with the device resources that the generation tracks.
+            if (!m_tableSlot || m_tableSlotGeneration != pipelineStateGeneration) {
+                m_tableSlot = pbrResources.GetMaterialTable().Allocate();
+                m_tableSlotGeneration = pipelineStateGeneration;
+                m_tableParametersChanged = true;
+            }
+            if (m_tableParametersChanged) {
+                m_tableParametersChanged = false;
+                pbrResources.GetMaterialTable().Update(*m_tableSlot, &m_parameters);
+            }
+            pbrResources.BindMaterialTable(context, m_tableSlot->Index);
+        } else {
+            // If the parameters of the constant buffer have changed, update the constant buffer.
+            RenderDevice& renderDevice = pbrResources.GetRenderDevice(context);
+            const BufferHandle psConstantBuffers[] = {
+                pbrResources.Import(m_constantBufferImport, m_constantBuffer.get(), BufferUsage::Constant)};
+            if (m_parametersChanged) {
+                m_parametersChanged = false;
+                renderDevice.UpdateBuffer(psConstantBuffers[0], 0, &m_parameters, (uint32_t)sizeof(m_parameters));
+            }
+            renderDevice.SetConstantBuffers(ShaderStage::Pixel, Pbr::ShaderSlots::ConstantBuffers::Material, 1, psConstantBuffers);
+            pbrResources.BindMaterialTable(context, 0);
+        }
 
-        std::array<ID3D11SamplerState*, TextureCount> samplers;
-        std::transform(m_samplers.begin(), m_samplers.end(), samplers.begin(), [](const auto& sampler) { return sampler.get(); });
-        context->PSSetSamplers(Pbr::ShaderSlots::BaseColor, (UINT)samplers.size(), samplers.data());
+        for (size_t slot = 0; slot < TextureCount; slot++) {
+            pbrResources.Import(m_samplerImports[slot], m_samplers[slot].get());
+        }
+        pbrResources.BindMaterialTextures(context, m_textureImports.data(), m_samplerImports.data());
     }
 
     Material::ConstantBufferData& Material::Parameters() {
         m_parametersChanged = true;
+        m_tableParametersChanged = true;
         return m_parameters;
     }
 
@@ -7,6 +7,7 @@
 #include <array>
 #include <map>
 #include <memory>
+#include <optional>
 #include <winrt/base.h>
 #include <d3d11.h>
 #include <d3d11_2.h>
@@ -29,10 +30,16 @@ namespace Pbr {
             float RoughnessFactor{1};
             // packoffset(c2)
             alignas(16) RGBColor EmissiveFactor{1, 1, 1};
-            // packoffset(c3.x, c3.y and c3.z)
+            // packoffset(c3)
             alignas(16) float NormalScale{1};
             float OcclusionStrength{1};
             float AlphaCutoff{0};
+            // Nonzero when the normal texture only stores X and Y, like BC5, so the shader reconstructs Z.
+            // Set by the material from the format of its normal texture.
+            uint32_t NormalTextureTwoChannel{0};
+            // packoffset(c4 and c5.x): slice of each texture in its texture array, indexed by ShaderSlots::PSMaterial.
+            // Set by the material when texture arrays are enabled.
+            alignas(16) uint32_t TextureSlices[ShaderSlots::LastMaterialSlot + 1]{};
         };
 #pragma warning(pop)
 
@@ -55,13 +62,28 @@ namespace Pbr {
         void SetTexture(ShaderSlots::PSMaterial slot,
                         _In_ ID3D11ShaderResourceView* textureView,
                         _In_opt_ ID3D11SamplerState* sampler = nullptr);
+        ID3D11ShaderResourceView* GetTexture(ShaderSlots::PSMaterial slot) const;
 
         void SetDoubleSided(bool doubleSided);
         void SetWireframe(bool wireframeMode);
         void SetAlphaBlended(bool alphaBlended);
 
-        // Bind this material to current context.
-        void Bind(_In_ ID3D11DeviceContext* context, const Resources& pbrResources) const;
+        // Alpha-blended materials are drawn in DrawPass::Blended, after all opaque materials.
+        bool GetAlphaBlended() const {
+            return m_alphaBlended;
+        }
+
+        // Set whether the material is lit, and whether it's lit by image-based lighting besides the directional light. Both are
+        // enabled by default. Together with whether the material has any textures besides the neutral solid color textures of
+        // Resources, they select the pixel shader permutation that draws the material.
+        void SetUnlit(bool unlit);
+        void SetImageBasedLighting(bool imageBasedLighting);
+        PixelShaderPermutation GetPixelShaderPermutation(const Resources& pbrResources) const;
+
+        // Bind this material to current context, with the shaders for the vertex format of the primitive being drawn. With the
+        // material table enabled, the parameters are written to the material's slot of the table instead of its constant buffer.
+        // With texture arrays enabled, the textures are copied into the texture array pool on first use.
+        void Bind(_In_ ID3D11DeviceContext* context, const Resources& pbrResources, VertexFormat vertexFormat = VertexFormat::Full) const;
 
         ConstantBufferData& Parameters();
         const ConstantBufferData& Parameters() const;
@@ -71,15 +93,40 @@ namespace Pbr {
 
     private:
         mutable bool m_parametersChanged{true};
-        ConstantBufferData m_parameters;
+        mutable bool m_tableParametersChanged{true};
+        mutable ConstantBufferData m_parameters; // The texture slices are set by Bind.
+
+        // Allocated by the first bind with the material table enabled, and again when the device resources are recreated.
+        mutable std::shared_ptr<const MaterialTableSlot> m_tableSlot;
+        mutable uint32_t m_tableSlotGeneration{0};
 
         bool m_alphaBlended{false};
         bool m_doubleSided{false};
         bool m_wireframe{false};
+        bool m_unlit{false};
+        bool m_imageBasedLighting{true};
+
+        // Selected again when the textures or lighting change, or the device resources are recreated.
+        mutable std::optional<PixelShaderPermutation> m_pixelShaderPermutation;
+        mutable uint32_t m_pixelShaderPermutationGeneration{0};
+
+        // The pipeline state is resolved again only when the key or the resources' generation changes.
+        mutable const PipelineState* m_pipelineState{nullptr};
+        mutable PipelineStateKey m_pipelineStateKey{};
+        mutable uint32_t m_pipelineStateGeneration{0};
 
         static constexpr size_t TextureCount = ShaderSlots::LastMaterialSlot + 1;
         std::array<winrt::com_ptr<ID3D11ShaderResourceView>, TextureCount> m_textures;
         std::array<winrt::com_ptr<ID3D11SamplerState>, TextureCount> m_samplers;
+
+        // Got by the first bind with texture arrays enabled, and again when a texture is set or the device resources are recreated.
+        mutable std::array<std::shared_ptr<const TextureArraySlice>, TextureCount> m_textureSlices;
+        mutable uint32_t m_textureSlicesGeneration{0};
         winrt::com_ptr<ID3D11Buffer> m_constantBuffer;
+
+        // The constant buffer, textures and samplers bound by the last bind, imported into the render device of the resources.
+        mutable ImportedBuffer m_constantBufferImport;
+        mutable std::array<ImportedTexture, TextureCount> m_textureImports;
+        mutable std::array<ImportedSampler, TextureCount> m_samplerImports;
     };
 } // namespace Pbr
@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <numeric>
+#include <vector>
+#include "PbrCommon.h"
+#include "PbrMaterialTable.h"
+
+namespace Pbr {
+    struct MaterialTable::Impl {
+        winrt::com_ptr<ID3D11Device> Device;
+        uint32_t ElementSize;
+
+        mutable std::mutex Mutex;
+        std::vector<uint8_t> Parameters; // Sized to the capacity of the table.
+        uint32_t Capacity{0};
+        std::vector<bool> DirtySlots;
+        std::vector<uint32_t> FreeSlots;
+        uint32_t SlotCount{0};
+        std::atomic<bool> HasChanges{false};
+
+        // Only used by the rendering thread.
+        uint32_t BufferCapacity{0};
+        winrt::com_ptr<ID3D11Buffer> ParametersBuffer;
+        winrt::com_ptr<ID3D11ShaderResourceView> ParametersResourceView;
+        winrt::com_ptr<ID3D11Buffer> MaterialIndexBuffer;
+        MaterialTableStats LastFlushStats;
+
+        void Free(uint32_t index) {
+            std::lock_guard guard(Mutex);
+            FreeSlots.push_back(index);
+            SlotCount--;
+        }
+
+        void CreateBuffers(uint32_t capacity) {
+            D3D11_BUFFER_DESC parametersDesc{};
+            parametersDesc.Usage = D3D11_USAGE_DEFAULT;
+            parametersDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+            parametersDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+            parametersDesc.StructureByteStride = ElementSize;
+            parametersDesc.ByteWidth = capacity * parametersDesc.StructureByteStride;
+            ParametersBuffer = nullptr;
+            Internal::ThrowIfFailed(Device->CreateBuffer(&parametersDesc, nullptr, ParametersBuffer.put()));
+
+            D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+            srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+            srvDesc.Buffer.NumElements = capacity;
+            ParametersResourceView = nullptr;
+            Internal::ThrowIfFailed(Device->CreateShaderResourceView(ParametersBuffer.get(), &srvDesc, ParametersResourceView.put()));
+
+            std::vector<uint32_t> indices(capacity);
+            std::iota(indices.begin(), indices.end(), 0);
+            const CD3D11_BUFFER_DESC indexDesc((UINT)(capacity * sizeof(uint32_t)), D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+            const D3D11_SUBRESOURCE_DATA indexData{indices.data()};
+            MaterialIndexBuffer = nullptr;
+            Internal::ThrowIfFailed(Device->CreateBuffer(&indexDesc, &indexData, MaterialIndexBuffer.put()));
+
+            BufferCapacity = capacity;
+        }
+    };
+
+    MaterialTable::MaterialTable(_In_ ID3D11Device* device, uint32_t elementSize, uint32_t initialCapacity)
+        : m_impl(std::make_shared<Impl>()) {
+        m_impl->Device.copy_from(device);
+        m_impl->ElementSize = elementSize;
+        m_impl->Capacity = std::max(1u, initialCapacity);
+        m_impl->Parameters.resize((size_t)m_impl->Capacity * elementSize);
+        m_impl->DirtySlots.resize(m_impl->Capacity, false);
+        m_impl->CreateBuffers(m_impl->Capacity);
+    }
+
+    std::shared_ptr<const MaterialTableSlot> MaterialTable::Allocate() {
+        std::lock_guard guard(m_impl->Mutex);
+
+        auto slot = std::make_unique<MaterialTableSlot>();
+        if (!m_impl->FreeSlots.empty()) {
+            slot->Index = m_impl->FreeSlots.back();
+            m_impl->FreeSlots.pop_back();
+        } else {
+            slot->Index = m_impl->SlotCount; // Without free slots, the used slots are exactly the first SlotCount.
+            if (slot->Index == m_impl->Capacity) {
+                m_impl->Capacity *= 2;
+                m_impl->Parameters.resize((size_t)m_impl->Capacity * m_impl->ElementSize);
+                m_impl->DirtySlots.resize(m_impl->Capacity, false);
+                m_impl->HasChanges = true; // The buffers are recreated by the next flush.
+            }
+        }
+        m_impl->SlotCount++;
+
+        return std::shared_ptr<const MaterialTableSlot>(slot.release(), [impl = m_impl](const MaterialTableSlot* slot) {
+            impl->Free(slot->Index);
+            delete slot;
+        });
+    }
+
+    void MaterialTable::Update(const MaterialTableSlot& slot, _In_reads_bytes_(elementSize) const void* parameters) {
+        std::lock_guard guard(m_impl->Mutex);
+        memcpy(&m_impl->Parameters[(size_t)slot.Index * m_impl->ElementSize], parameters, m_impl->ElementSize);
+        m_impl->DirtySlots[slot.Index] = true;
+        m_impl->HasChanges = true;
+    }
+
+    bool MaterialTable::Flush(_In_ ID3D11DeviceContext* context) {
+        if (!m_impl->HasChanges) {
+            return false;
+        }
+
+        std::lock_guard guard(m_impl->Mutex);
+        m_impl->HasChanges = false;
+        m_impl->LastFlushStats = {};
+
+        // A grown table is uploaded as a whole into its new buffers.
+        const uint32_t capacity = m_impl->Capacity;
+        const bool recreated = capacity != m_impl->BufferCapacity;
+        if (recreated) {
+            m_impl->CreateBuffers(capacity);
+            std::fill(m_impl->DirtySlots.begin(), m_impl->DirtySlots.end(), true);
+        }
+
+        const UINT slotSize = m_impl->ElementSize;
+        for (uint32_t begin = 0; begin < capacity; begin++) {
+            if (!m_impl->DirtySlots[begin]) {
+                continue;
+            }
+
+            uint32_t end = begin + 1;
+            while (end < capacity && m_impl->DirtySlots[end]) {
+                end++;
+            }
+            std::fill(m_impl->DirtySlots.begin() + begin, m_impl->DirtySlots.begin() + end, false);
+
+            const D3D11_BOX box{begin * slotSize, 0, 0, end * slotSize, 1, 1};
+            context->UpdateSubresource(m_impl->ParametersBuffer.get(), 0, &box, &m_impl->Parameters[(size_t)begin * slotSize], 0, 0);
+            m_impl->LastFlushStats.LastFlushRangeCount++;
+            m_impl->LastFlushStats.LastFlushBytes += (size_t)(end - begin) * slotSize;
+            begin = end;
+        }
+
+        return recreated;
+    }
+
+    ID3D11Buffer* MaterialTable::GetParameterBuffer() const {
+        return m_impl->ParametersBuffer.get();
+    }
+
+    ID3D11ShaderResourceView* MaterialTable::GetShaderResourceView() const {
+        return m_impl->ParametersResourceView.get();
+    }
+
+    ID3D11Buffer* MaterialTable::GetMaterialIndexBuffer() const {
+        return m_impl->MaterialIndexBuffer.get();
+    }
+
+    MaterialTableStats MaterialTable::GetStats() const {
+        std::lock_guard guard(m_impl->Mutex);
+        MaterialTableStats stats = m_impl->LastFlushStats;
+        stats.Capacity = m_impl->Capacity;
+        stats.SlotCount = m_impl->SlotCount;
+        return stats;
+    }
+} // namespace Pbr
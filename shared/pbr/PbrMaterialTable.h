@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#pragma once
+
+#include <memory>
+#include <winrt/base.h>
+#include <d3d11.h>
+
+namespace Pbr {
+    // A slot of a material table. The slot returns to its table when the last reference is released.
+    struct MaterialTableSlot {
+        uint32_t Index{0};
+    };
+
+    // Usage of a material table, and the uploads of its most recent flush.
+    struct MaterialTableStats {
+        uint32_t Capacity{0};
+        uint32_t SlotCount{0};
+        uint32_t LastFlushRangeCount{0}; // Contiguous ranges of slots that were uploaded.
+        size_t LastFlushBytes{0};
+    };
+
+    // The parameters of many materials in one structured buffer of elementSize bytes each (Material::ConstantBufferData),
+    // which the pixel shader indexes with the material index of the draw instead of reading a constant buffer bound per
+    // material. The material index reaches the shaders through a per-instance vertex buffer holding each index at its own
+    // position, so a draw selects its material with its start instance location. Parameters are staged on the CPU and the
+    // next Flush uploads the changed ranges of slots; both buffers double in size when the table is full. Slots can be
+    // released from any thread.
+    struct MaterialTable final {
+        static constexpr uint32_t DefaultCapacity = 256;
+
+        MaterialTable(_In_ ID3D11Device* device, uint32_t elementSize, uint32_t initialCapacity = DefaultCapacity);
+
+        // Allocate a slot, growing the table if needed. The parameters of the slot are undefined until Update.
+        std::shared_ptr<const MaterialTableSlot> Allocate();
+
+        // Stage the parameters of a slot for the next Flush.
+        void Update(const MaterialTableSlot& slot, _In_reads_bytes_(elementSize) const void* parameters);
+
+        // Recreate the buffers if the table grew, and upload the changed slots. Returns whether the buffers were recreated,
+        // in which case they need to be bound again.
+        bool Flush(_In_ ID3D11DeviceContext* context);
+
+        // The structured buffer of parameters and its view, and the per-instance vertex buffer of material indices
+        // (DXGI_FORMAT_R32_UINT).
+        ID3D11Buffer* GetParameterBuffer() const;
+        ID3D11ShaderResourceView* GetShaderResourceView() const;
+        ID3D11Buffer* GetMaterialIndexBuffer() const;
+
+        MaterialTableStats GetStats() const;
+
+    private:
+        struct Impl;
+        std::shared_ptr<Impl> m_impl; // Shared with the allocated slots, which free themselves into it.
+    };
+} // namespace Pbr
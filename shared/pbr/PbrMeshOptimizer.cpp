@@ -0,0 +1,353 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "PbrMeshOptimizer.h"
+
+namespace {
+    // Parameters of Forsyth's vertex scoring, from "Linear-Speed Vertex Cache Optimisation" (Tom Forsyth, 2006).
+    constexpr int32_t ForsythCacheSize = 32;
+    constexpr float CacheDecayPower = 1.5f;
+    constexpr float LastTriangleScore = 0.75f;
+    constexpr float ValenceBoostScale = 2.0f;
+    constexpr float ValenceBoostPower = 0.5f;
+
+    float VertexScore(int32_t cachePosition, uint32_t remainingTriangles) {
+        if (remainingTriangles == 0) {
+            return -1.0f; // No triangle needs this vertex anymore.
+        }
+
+        float score = 0.0f;
+        if (cachePosition >= 0) {
+            if (cachePosition < 3) {
+                // The vertices of the last triangle get a fixed score, so the next triangle doesn't just reuse its edge.
+                score = LastTriangleScore;
+            } else {
+                const float scaler = 1.0f / (ForsythCacheSize - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scaler, CacheDecayPower);
+            }
+        }
+
+        // Prefer vertices with few remaining triangles, to finish them off and avoid isolated triangles later.
+        score += ValenceBoostScale * std::pow((float)remainingTriangles, -ValenceBoostPower);
+        return score;
+    }
+
+    struct Float3 {
+        float X, Y, Z;
+    };
+
+    Float3 operator-(const Float3& a, const Float3& b) {
+        return {a.X - b.X, a.Y - b.Y, a.Z - b.Z};
+    }
+
+    Float3 Cross(const Float3& a, const Float3& b) {
+        return {a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X};
+    }
+
+    float Dot(const Float3& a, const Float3& b) {
+        return a.X * b.X + a.Y * b.Y + a.Z * b.Z;
+    }
+
+    Float3 ReadPosition(const void* positions, size_t positionStride, uint32_t index) {
+        const float* position = reinterpret_cast<const float*>(static_cast<const uint8_t*>(positions) + index * positionStride);
+        return {position[0], position[1], position[2]};
+    }
+} // namespace
+
+namespace Pbr {
+    namespace MeshOptimizer {
+        size_t CountCacheMisses(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+            // A vertex is in the FIFO cache when fewer than cacheSize other vertices were added after it.
+            std::vector<size_t> cacheTimestamps(vertexCount, 0);
+            size_t timestamp = (size_t)cacheSize + 1;
+            size_t misses = 0;
+            for (size_t i = 0; i < indexCount; i++) {
+                const uint32_t index = indices[i];
+                if (timestamp - cacheTimestamps[index] > cacheSize) {
+                    cacheTimestamps[index] = timestamp++;
+                    misses++;
+                }
+            }
+            return misses;
+        }
+
+        void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+            const size_t triangleCount = indexCount / 3;
+            if (triangleCount == 0) {
+                return;
+            }
+
+            // Triangles that use each vertex. The first remainingTriangles[v] entries are the triangles not emitted yet.
+            std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+            for (size_t i = 0; i < triangleCount * 3; i++) {
+                remainingTriangles[indices[i]]++;
+            }
+
+            std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+            for (size_t v = 0; v < vertexCount; v++) {
+                adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remainingTriangles[v];
+            }
+
+            std::vector<uint32_t> adjacency(triangleCount * 3);
+            {
+                std::vector<uint32_t> fillCounts(vertexCount, 0);
+                for (size_t i = 0; i < triangleCount * 3; i++) {
+                    const uint32_t v = indices[i];
+                    adjacency[adjacencyOffsets[v] + fillCounts[v]++] = (uint32_t)(i / 3);
+                }
+            }
+
+            std::vector<int32_t> cachePositions(vertexCount, -1);
+            std::vector<float> vertexScores(vertexCount);
+            for (size_t v = 0; v < vertexCount; v++) {
+                vertexScores[v] = VertexScore(-1, remainingTriangles[v]);
+            }
+
+            auto triangleScore = [&](size_t triangle) {
+                return vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] +
+                       vertexScores[indices[triangle * 3 + 2]];
+            };
+
+            // Start with the best triangle of the whole mesh.
+            uint32_t bestTriangle = 0;
+            {
+                float bestScore = -1.0f;
+                for (size_t t = 0; t < triangleCount; t++) {
+                    const float score = triangleScore(t);
+                    if (score > bestScore) {
+                        bestScore = score;
+                        bestTriangle = (uint32_t)t;
+                    }
+                }
+            }
+
+            std::vector<uint32_t> optimizedIndices;
+            optimizedIndices.reserve(triangleCount * 3);
+            std::vector<bool> emitted(triangleCount, false);
+            std::vector<uint32_t> cache;
+            std::vector<uint32_t> newCache;
+            cache.reserve(ForsythCacheSize + 3);
+            newCache.reserve(ForsythCacheSize + 3);
+            size_t nextUnemitted = 0;
+
+            for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+                if (bestTriangle == InvalidIndex) {
+                    // No triangle around the cached vertices is left; continue with the next one in the input order.
+                    while (emitted[nextUnemitted]) {
+                        nextUnemitted++;
+                    }
+                    bestTriangle = (uint32_t)nextUnemitted;
+                }
+
+                const std::array<uint32_t, 3> triangle = {
+                    indices[bestTriangle * 3], indices[bestTriangle * 3 + 1], indices[bestTriangle * 3 + 2]};
+                optimizedIndices.insert(optimizedIndices.end(), triangle.begin(), triangle.end());
+                emitted[bestTriangle] = true;
+
+                // Remove the triangle from the remaining triangles of its vertices.
+                for (const uint32_t v : triangle) {
+                    const auto begin = adjacency.begin() + adjacencyOffsets[v];
+                    const auto end = begin + remainingTriangles[v];
+                    std::iter_swap(std::find(begin, end, bestTriangle), end - 1);
+                    remainingTriangles[v]--;
+                }
+
+                // Move the vertices of the triangle to the front of the LRU cache.
+                newCache.clear();
+                for (const uint32_t v : triangle) {
+                    if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+                        newCache.push_back(v);
+                    }
+                }
+                for (const uint32_t v : cache) {
+                    if (std::find(triangle.begin(), triangle.end(), v) == triangle.end()) {
+                        newCache.push_back(v);
+                    }
+                }
+
+                for (size_t i = 0; i < newCache.size(); i++) {
+                    const uint32_t v = newCache[i];
+                    cachePositions[v] = i < ForsythCacheSize ? (int32_t)i : -1;
+                    vertexScores[v] = VertexScore(cachePositions[v], remainingTriangles[v]);
+                }
+
+                newCache.resize(std::min<size_t>(newCache.size(), ForsythCacheSize));
+                std::swap(cache, newCache);
+
+                // The next triangle is the best one around the cached vertices, as only their scores changed.
+                bestTriangle = InvalidIndex;
+                float bestScore = -1.0f;
+                for (const uint32_t v : cache) {
+                    for (uint32_t i = 0; i < remainingTriangles[v]; i++) {
+                        const uint32_t t = adjacency[adjacencyOffsets[v] + i];
+                        const float score = triangleScore(t);
+                        if (score > bestScore) {
+                            bestScore = score;
+                            bestTriangle = t;
+                        }
+                    }
+                }
+            }
+
+            std::copy(optimizedIndices.begin(), optimizedIndices.end(), indices);
+        }
+
+        void OptimizeOverdraw(uint32_t* indices,
+                              size_t indexCount,
+                              const void* positions,
+                              size_t positionStride,
+                              size_t vertexCount,
+                              float threshold) {
+            const size_t triangleCount = indexCount / 3;
+            if (triangleCount == 0) {
+                return;
+            }
+
+            // FIFO cache simulation that can be flushed, returning the misses of one triangle.
+            std::vector<size_t> cacheTimestamps(vertexCount, 0);
+            size_t timestamp = (size_t)DefaultCacheSize + 1;
+            auto triangleMisses = [&](size_t triangle) {
+                uint32_t misses = 0;
+                for (size_t i = triangle * 3; i < triangle * 3 + 3; i++) {
+                    if (timestamp - cacheTimestamps[indices[i]] > DefaultCacheSize) {
+                        cacheTimestamps[indices[i]] = timestamp++;
+                        misses++;
+                    }
+                }
+                return misses;
+            };
+            auto flushCache = [&] { timestamp += DefaultCacheSize + 1; };
+
+            // Hard boundaries are where the cache optimized order misses on all vertices of a triangle, so reordering
+            // there costs nothing.
+            std::vector<size_t> hardBoundaries;
+            for (size_t t = 0; t < triangleCount; t++) {
+                if (triangleMisses(t) == 3) {
+                    hardBoundaries.push_back(t);
+                }
+            }
+            hardBoundaries.push_back(triangleCount);
+
+            // Soft boundaries split the hard clusters as soon as their ACMR from a flushed cache gets within the
+            // threshold of the ACMR of the whole hard cluster, as in Tipsify (Sander, Nehab and Barczak, 2007).
+            std::vector<size_t> clusterStarts;
+            for (size_t h = 0; h + 1 < hardBoundaries.size(); h++) {
+                const size_t start = hardBoundaries[h];
+                const size_t end = hardBoundaries[h + 1];
+
+                flushCache();
+                size_t hardClusterMisses = 0;
+                for (size_t t = start; t < end; t++) {
+                    hardClusterMisses += triangleMisses(t);
+                }
+                const float targetAcmr = threshold * hardClusterMisses / (end - start);
+
+                flushCache();
+                clusterStarts.push_back(start);
+                size_t runningMisses = 0;
+                size_t runningTriangles = 0;
+                for (size_t t = start; t < end; t++) {
+                    runningMisses += triangleMisses(t);
+                    runningTriangles++;
+                    if (t + 1 < end && runningMisses <= targetAcmr * runningTriangles) {
+                        clusterStarts.push_back(t + 1);
+                        flushCache();
+                        runningMisses = 0;
+                        runningTriangles = 0;
+                    }
+                }
+            }
+
+            if (clusterStarts.size() < 2) {
+                return;
+            }
+            clusterStarts.push_back(triangleCount);
+            const size_t clusterCount = clusterStarts.size() - 1;
+
+            // Area weighted centroid and normal of each cluster, and the centroid of the mesh.
+            std::vector<Float3> clusterCentroids(clusterCount, Float3{0, 0, 0});
+            std::vector<Float3> clusterNormals(clusterCount, Float3{0, 0, 0});
+            std::vector<float> clusterAreas(clusterCount, 0.0f);
+            Float3 meshCentroid{0, 0, 0};
+            float meshArea = 0.0f;
+            for (size_t c = 0; c < clusterCount; c++) {
+                for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++) {
+                    const Float3 p0 = ReadPosition(positions, positionStride, indices[t * 3]);
+                    const Float3 p1 = ReadPosition(positions, positionStride, indices[t * 3 + 1]);
+                    const Float3 p2 = ReadPosition(positions, positionStride, indices[t * 3 + 2]);
+
+                    // The cross product length is twice the triangle area, which cancels out in the weighted averages.
+                    const Float3 normal = Cross(p1 - p0, p2 - p0);
+                    const float area = std::sqrt(Dot(normal, normal));
+                    const Float3 centroid{(p0.X + p1.X + p2.X) / 3, (p0.Y + p1.Y + p2.Y) / 3, (p0.Z + p1.Z + p2.Z) / 3};
+
+                    Float3& clusterCentroid = clusterCentroids[c];
+                    clusterCentroid = {clusterCentroid.X + centroid.X * area,
+                                       clusterCentroid.Y + centroid.Y * area,
+                                       clusterCentroid.Z + centroid.Z * area};
+                    Float3& clusterNormal = clusterNormals[c];
+                    clusterNormal = {clusterNormal.X + normal.X, clusterNormal.Y + normal.Y, clusterNormal.Z + normal.Z};
+                    clusterAreas[c] += area;
+                }
+
+                meshCentroid = {meshCentroid.X + clusterCentroids[c].X,
+                                meshCentroid.Y + clusterCentroids[c].Y,
+                                meshCentroid.Z + clusterCentroids[c].Z};
+                meshArea += clusterAreas[c];
+            }
+
+            if (meshArea <= 0) {
+                return;
+            }
+            meshCentroid = {meshCentroid.X / meshArea, meshCentroid.Y / meshArea, meshCentroid.Z / meshArea};
+
+            // Clusters that face away from the center of the mesh are more likely to be in front of the others.
+            std::vector<float> sortKeys(clusterCount, 0.0f);
+            for (size_t c = 0; c < clusterCount; c++) {
+                const float normalLength = std::sqrt(Dot(clusterNormals[c], clusterNormals[c]));
+                if (clusterAreas[c] > 0 && normalLength > 0) {
+                    const float areaScale = 1.0f / clusterAreas[c];
+                    const Float3 centroid{
+                        clusterCentroids[c].X * areaScale, clusterCentroids[c].Y * areaScale, clusterCentroids[c].Z * areaScale};
+                    sortKeys[c] = Dot(centroid - meshCentroid, clusterNormals[c]) / normalLength;
+                }
+            }
+
+            std::vector<uint32_t> clusterOrder(clusterCount);
+            for (size_t c = 0; c < clusterCount; c++) {
+                clusterOrder[c] = (uint32_t)c;
+            }
+            std::stable_sort(
+                clusterOrder.begin(), clusterOrder.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+            std::vector<uint32_t> sortedIndices;
+            sortedIndices.reserve(triangleCount * 3);
+            for (const uint32_t c : clusterOrder) {
+                sortedIndices.insert(sortedIndices.end(), indices + clusterStarts[c] * 3, indices + clusterStarts[c + 1] * 3);
+            }
+
+            const size_t missesBefore = CountCacheMisses(indices, triangleCount * 3, vertexCount);
+            const size_t missesAfter = CountCacheMisses(sortedIndices.data(), sortedIndices.size(), vertexCount);
+            if (missesAfter <= missesBefore * threshold) {
+                std::copy(sortedIndices.begin(), sortedIndices.end(), indices);
+            }
+        }
+
+        size_t OptimizeVertexFetchRemap(uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& remap) {
+            remap.assign(vertexCount, InvalidIndex);
+            uint32_t nextVertex = 0;
+            for (size_t i = 0; i < indexCount; i++) {
+                uint32_t& newIndex = remap[indices[i]];
+                if (newIndex == InvalidIndex) {
+                    newIndex = nextVertex++;
+                }
+                indices[i] = newIndex;
+            }
+            return nextVertex;
+        }
+    } // namespace MeshOptimizer
+} // namespace Pbr
@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// Triangle and vertex reordering of indexed triangle lists for the post-transform vertex cache, overdraw and vertex
+// fetch. This code has no graphics API dependency.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Pbr {
+    // Cache miss counts of a mesh before and after optimization, measured with MeshOptimizer::CountCacheMisses.
+    // Stats of several meshes can be summed to get the combined ratios.
+    struct MeshOptimizationStats {
+        size_t TriangleCount{0};
+        size_t VertexCount{0};
+        size_t CacheMissesBefore{0};
+        size_t CacheMissesAfter{0};
+
+        // Average cache miss ratio: transformed vertices per triangle. 0.5 is the lower bound for large regular meshes, 3 the worst.
+        float AcmrBefore() const {
+            return TriangleCount == 0 ? 0.0f : (float)CacheMissesBefore / TriangleCount;
+        }
+        float AcmrAfter() const {
+            return TriangleCount == 0 ? 0.0f : (float)CacheMissesAfter / TriangleCount;
+        }
+
+        MeshOptimizationStats& operator+=(const MeshOptimizationStats& other) {
+            TriangleCount += other.TriangleCount;
+            VertexCount += other.VertexCount;
+            CacheMissesBefore += other.CacheMissesBefore;
+            CacheMissesAfter += other.CacheMissesAfter;
+            return *this;
+        }
+    };
+
+    namespace MeshOptimizer {
+        constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+        // Size of the FIFO cache that ACMR is measured with, a common size for the post-transform cache of current GPUs.
+        constexpr uint32_t DefaultCacheSize = 16;
+
+        // Count vertex shader invocations for an indexed triangle list with a FIFO post-transform cache.
+        size_t CountCacheMisses(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = DefaultCacheSize);
+
+        // Reorder triangles for the post-transform vertex cache with Forsyth's linear-speed algorithm, which doesn't
+        // depend on the exact cache size. The winding of each triangle is kept.
+        void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+        // Reorder the clusters of a cache optimized triangle list so outward facing clusters are drawn first, which
+        // reduces overdraw of closed meshes from most view directions. Clusters are cut where the cache optimized
+        // order stays within the threshold of its ACMR even with a flushed cache, and the order is kept if sorting
+        // would raise the cache misses by more than the threshold. Positions are three floats, each positionStride
+        // bytes apart.
+        void OptimizeOverdraw(uint32_t* indices,
+                              size_t indexCount,
+                              const void* positions,
+                              size_t positionStride,
+                              size_t vertexCount,
+                              float threshold = 1.05f);
+
+        // Number vertices in the order the indices first reference them, so vertex fetch reads memory sequentially.
+        // Rewrites the indices and fills remap with the new index of each vertex, or InvalidIndex for unreferenced
+        // vertices. Returns the number of referenced vertices.
+        size_t OptimizeVertexFetchRemap(uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& remap);
+
+        // Apply a remap from OptimizeVertexFetchRemap to a vertex array, dropping unreferenced vertices.
+        template <typename TVertex>
+        std::vector<TVertex> RemapVertices(const TVertex* vertices, const std::vector<uint32_t>& remap, size_t uniqueVertexCount) {
+            std::vector<TVertex> remapped(uniqueVertexCount);
+            for (size_t i = 0; i < remap.size(); i++) {
+                if (remap[i] != InvalidIndex) {
+                    remapped[remap[i]] = vertices[i];
+                }
+            }
+            return remapped;
+        }
+    } // namespace MeshOptimizer
+} // namespace Pbr
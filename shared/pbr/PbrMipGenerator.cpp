@@ -0,0 +1,211 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "PbrMipGenerator.h"
+#include "PbrParallel.h"
+
+namespace {
+    struct Texel {
+        float R, G, B, A;
+    };
+
+    struct ImageView {
+        const uint8_t* Pixels;
+        uint32_t Width;
+        uint32_t Height;
+    };
+
+    constexpr float Pi = 3.14159265358979f;
+
+    const std::array<float, 256>& SrgbToLinearTable() {
+        static const std::array<float, 256> table = [] {
+            std::array<float, 256> values{};
+            for (uint32_t i = 0; i < 256; i++) {
+                const float c = i / 255.0f;
+                values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return values;
+        }();
+        return table;
+    }
+
+    uint8_t ToUnorm8(float value) {
+        return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    uint8_t LinearToSrgb8(float value) {
+        value = std::clamp(value, 0.0f, 1.0f);
+        return ToUnorm8(value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1 / 2.4f) - 0.055f);
+    }
+
+    struct TexelCodec {
+        bool SRGB;
+
+        Texel Decode(const uint8_t* rgba) const {
+            if (SRGB) {
+                const std::array<float, 256>& table = SrgbToLinearTable();
+                return {table[rgba[0]], table[rgba[1]], table[rgba[2]], rgba[3] / 255.0f};
+            }
+            return {rgba[0] / 255.0f, rgba[1] / 255.0f, rgba[2] / 255.0f, rgba[3] / 255.0f};
+        }
+
+        void Encode(const Texel& texel, uint8_t* rgba) const {
+            if (SRGB) {
+                rgba[0] = LinearToSrgb8(texel.R);
+                rgba[1] = LinearToSrgb8(texel.G);
+                rgba[2] = LinearToSrgb8(texel.B);
+            } else {
+                rgba[0] = ToUnorm8(texel.R);
+                rgba[1] = ToUnorm8(texel.G);
+                rgba[2] = ToUnorm8(texel.B);
+            }
+            rgba[3] = ToUnorm8(texel.A);
+        }
+    };
+
+    void Accumulate(Texel& sum, const Texel& texel, float weight) {
+        sum.R += texel.R * weight;
+        sum.G += texel.G * weight;
+        sum.B += texel.B * weight;
+        sum.A += texel.A * weight;
+    }
+
+    // Filtering cost is counted in source texel reads.
+    constexpr uint64_t MinTexelReadsPerTask = 128 * 1024;
+
+    void DownsampleBox(const ImageView& src, Pbr::MipLevel& dst, const TexelCodec& codec) {
+        Pbr::Internal::ParallelFor(dst.Height, dst.Width * 4, MinTexelReadsPerTask, [&](uint32_t rowBegin, uint32_t rowEnd) {
+            for (uint32_t y = rowBegin; y < rowEnd; y++) {
+                const uint32_t y0 = std::min(y * 2, src.Height - 1);
+                const uint32_t y1 = std::min(y * 2 + 1, src.Height - 1);
+                for (uint32_t x = 0; x < dst.Width; x++) {
+                    const uint32_t x0 = std::min(x * 2, src.Width - 1);
+                    const uint32_t x1 = std::min(x * 2 + 1, src.Width - 1);
+
+                    Texel sum{};
+                    Accumulate(sum, codec.Decode(&src.Pixels[(y0 * src.Width + x0) * 4]), 0.25f);
+                    Accumulate(sum, codec.Decode(&src.Pixels[(y0 * src.Width + x1) * 4]), 0.25f);
+                    Accumulate(sum, codec.Decode(&src.Pixels[(y1 * src.Width + x0) * 4]), 0.25f);
+                    Accumulate(sum, codec.Decode(&src.Pixels[(y1 * src.Width + x1) * 4]), 0.25f);
+                    codec.Encode(sum, &dst.Pixels[(y * dst.Width + x) * 4]);
+                }
+            }
+        });
+    }
+
+    constexpr uint32_t KaiserTapCount = 6;
+
+    // Zeroth order modified Bessel function of the first kind, used by the Kaiser window.
+    float BesselI0(float x) {
+        float sum = 1, term = 1;
+        for (int k = 1; k < 20; k++) {
+            term *= (x / (2 * k)) * (x / (2 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Weights of a Kaiser-windowed sinc for a 2:1 reduction. Destination texel centers fall between two source texels,
+    // so the taps sit at distances -2.5 to 2.5 source texels and are the same for every destination texel.
+    const std::array<float, KaiserTapCount>& KaiserWeights() {
+        static const std::array<float, KaiserTapCount> weights = [] {
+            constexpr float Alpha = 4.0f;
+            constexpr float Radius = KaiserTapCount / 2.0f;
+            std::array<float, KaiserTapCount> values{};
+            float sum = 0;
+            for (uint32_t i = 0; i < KaiserTapCount; i++) {
+                const float distance = i - Radius + 0.5f;
+                const float x = distance / 2; // Cutoff at half the source sampling rate.
+                const float sinc = std::sin(Pi * x) / (Pi * x);
+                const float ratio = distance / Radius;
+                const float window = BesselI0(Alpha * std::sqrt(std::max(0.0f, 1 - ratio * ratio))) / BesselI0(Alpha);
+                values[i] = sinc * window;
+                sum += values[i];
+            }
+            for (float& value : values) {
+                value /= sum;
+            }
+            return values;
+        }();
+        return weights;
+    }
+
+    void DownsampleKaiser(const ImageView& src, Pbr::MipLevel& dst, const TexelCodec& codec) {
+        const std::array<float, KaiserTapCount>& weights = KaiserWeights();
+        constexpr int32_t FirstTap = -static_cast<int32_t>(KaiserTapCount / 2) + 1;
+
+        // Horizontal pass into a linear float image of dst.Width x src.Height.
+        std::vector<Texel> horizontal(static_cast<size_t>(dst.Width) * src.Height);
+        Pbr::Internal::ParallelFor(src.Height, dst.Width * KaiserTapCount, MinTexelReadsPerTask, [&](uint32_t rowBegin, uint32_t rowEnd) {
+            for (uint32_t y = rowBegin; y < rowEnd; y++) {
+                const uint8_t* srcRow = &src.Pixels[static_cast<size_t>(y) * src.Width * 4];
+                for (uint32_t x = 0; x < dst.Width; x++) {
+                    Texel sum{};
+                    for (uint32_t tap = 0; tap < KaiserTapCount; tap++) {
+                        const int32_t sx = std::clamp<int32_t>(static_cast<int32_t>(x * 2) + FirstTap + tap, 0, src.Width - 1);
+                        Accumulate(sum, codec.Decode(&srcRow[sx * 4]), weights[tap]);
+                    }
+                    horizontal[static_cast<size_t>(y) * dst.Width + x] = sum;
+                }
+            }
+        });
+
+        // Vertical pass, clamping the result since the negative lobes may overshoot.
+        Pbr::Internal::ParallelFor(dst.Height, dst.Width * KaiserTapCount, MinTexelReadsPerTask, [&](uint32_t rowBegin, uint32_t rowEnd) {
+            for (uint32_t y = rowBegin; y < rowEnd; y++) {
+                for (uint32_t x = 0; x < dst.Width; x++) {
+                    Texel sum{};
+                    for (uint32_t tap = 0; tap < KaiserTapCount; tap++) {
+                        const int32_t sy = std::clamp<int32_t>(static_cast<int32_t>(y * 2) + FirstTap + tap, 0, src.Height - 1);
+                        Accumulate(sum, horizontal[static_cast<size_t>(sy) * dst.Width + x], weights[tap]);
+                    }
+                    codec.Encode(sum, &dst.Pixels[(static_cast<size_t>(y) * dst.Width + x) * 4]);
+                }
+            }
+        });
+    }
+} // namespace
+
+namespace Pbr {
+    namespace MipGenerator {
+        uint32_t GetLevelCount(uint32_t width, uint32_t height) {
+            uint32_t levels = 1;
+            for (uint32_t size = std::max(width, height); size > 1; size /= 2) {
+                levels++;
+            }
+            return levels;
+        }
+
+        std::vector<MipLevel> GenerateMips(const uint8_t* rgba, uint32_t width, uint32_t height, bool sRGB, MipFilter filter) {
+            std::vector<MipLevel> levels;
+            if (filter == MipFilter::None || width == 0 || height == 0) {
+                return levels;
+            }
+
+            const uint32_t levelCount = GetLevelCount(width, height);
+            levels.reserve(levelCount - 1);
+
+            const TexelCodec codec{sRGB};
+            ImageView src{rgba, width, height};
+            for (uint32_t level = 1; level < levelCount; level++) {
+                MipLevel next{std::max(1u, src.Width / 2), std::max(1u, src.Height / 2), {}};
+                next.Pixels.resize(static_cast<size_t>(next.Width) * next.Height * 4);
+
+                if (filter == MipFilter::Kaiser) {
+                    DownsampleKaiser(src, next, codec);
+                } else {
+                    DownsampleBox(src, next, codec);
+                }
+
+                levels.push_back(std::move(next));
+                src = ImageView{levels.back().Pixels.data(), levels.back().Width, levels.back().Height};
+            }
+
+            return levels;
+        }
+    } // namespace MipGenerator
+} // namespace Pbr
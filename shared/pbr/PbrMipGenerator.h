@@ -0,0 +1,35 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// CPU mip chain generation for 8-bit RGBA images. This code has no graphics API dependency.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Pbr {
+    enum class MipFilter : uint32_t {
+        None,   // No mip chain is generated.
+        Box,    // 2x2 average. Fast, slightly blurry.
+        Kaiser, // Separable Kaiser-windowed sinc over 6x6 texels. Sharper, costs about 3x the box filter.
+    };
+
+    struct MipLevel {
+        uint32_t Width;
+        uint32_t Height;
+        std::vector<uint8_t> Pixels; // Tightly packed RGBA, 4 bytes per texel.
+    };
+
+    namespace MipGenerator {
+        // Number of levels in a full mip chain, including the top level.
+        uint32_t GetLevelCount(uint32_t width, uint32_t height);
+
+        // Generate mip levels 1 to N-1 from a tightly packed RGBA image, which is level 0.
+        // When sRGB is true the color channels are filtered in linear space; alpha is always linear.
+        // Large levels are filtered in parallel on the system thread pool.
+        std::vector<MipLevel> GenerateMips(const uint8_t* rgba, uint32_t width, uint32_t height, bool sRGB, MipFilter filter);
+    } // namespace MipGenerator
+} // namespace Pbr
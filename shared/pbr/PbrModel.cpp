@@ -2,6 +2,8 @@
 // Copyright (C) Microsoft Corporation.  All Rights Reserved
 // Licensed under the MIT License. See License.txt in the project root for license information.
 #include "pch.h"
+#include <algorithm>
+#include <set>
 #include "PbrCommon.h"
 #include "PbrModel.h"
 
@@ -12,6 +14,61 @@ using namespace DirectX;
 namespace
 {
     constexpr Pbr::NodeIndex_t RootParentNodeIndex = -1;
+
+    size_t GetTextureByteSize(_In_ ID3D11ShaderResourceView* textureView)
+    {
+        winrt::com_ptr<ID3D11Resource> resource;
+        textureView->GetResource(resource.put());
+        const winrt::com_ptr<ID3D11Texture2D> texture = resource.try_as<ID3D11Texture2D>();
+        if (!texture)
+        {
+            return 0;
+        }
+
+        D3D11_TEXTURE2D_DESC desc;
+        texture->GetDesc(&desc);
+
+        // Block compressed formats store 4x4 texel blocks.
+        uint32_t blockDimension = 1;
+        uint32_t blockByteSize = 4;
+        switch (desc.Format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC4_UNORM:
+            blockDimension = 4;
+            blockByteSize = 8;
+            break;
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC6H_UF16:
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            blockDimension = 4;
+            blockByteSize = 16;
+            break;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            blockByteSize = 8;
+            break;
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            blockByteSize = 16;
+            break;
+        default:
+            break;
+        }
+
+        size_t byteSize = 0;
+        for (uint32_t mip = 0; mip < desc.MipLevels; mip++)
+        {
+            const uint32_t width = std::max(desc.Width >> mip, 1u);
+            const uint32_t height = std::max(desc.Height >> mip, 1u);
+            const size_t blocksWide = (width + blockDimension - 1) / blockDimension;
+            const size_t blocksHigh = (height + blockDimension - 1) / blockDimension;
+            byteSize += blocksWide * blocksHigh * blockByteSize;
+        }
+        return byteSize * desc.ArraySize;
+    }
 }
 
 namespace Pbr
@@ -27,17 +84,94 @@ namespace Pbr
     void Model::Render(Pbr::Resources const& pbrResources, _In_ ID3D11DeviceContext* context) const
     {
         UpdateTransforms(pbrResources, context);
+        RenderPrimitives(pbrResources,
+                         context,
+                         m_modelTransforms,
+                         *m_modelTransformsBuffer,
+                         m_jointMatricesBuffer ? *m_jointMatricesBuffer : BufferHandle::None,
+                         nullptr);
+    }
 
-        ID3D11ShaderResourceView* vsShaderResources[] = { m_modelTransformsResourceView.get() };
-        context->VSSetShaderResources(Pbr::ShaderSlots::Transforms, _countof(vsShaderResources), vsShaderResources);
+    DrawPasses Model::GetDrawPasses() const
+    {
+        return GetDrawPasses(nullptr);
+    }
 
-        for (const Pbr::Primitive& primitive : m_primitives)
+    DrawPasses Model::GetDrawPasses(const MaterialOverrides* materialOverrides) const
+    {
+        DrawPasses passes;
+        auto materialOverride = materialOverrides ? materialOverrides->begin() : MaterialOverrides::const_iterator{};
+        for (uint32_t primitiveIndex = 0; primitiveIndex < m_primitives.size() && !(passes.Opaque && passes.Blended); primitiveIndex++)
         {
-            if (primitive.GetMaterial()->Hidden) continue;
+            const Pbr::Material* material = m_primitives[primitiveIndex].GetMaterial().get();
+            if (materialOverrides && materialOverride != materialOverrides->end() && materialOverride->first == primitiveIndex)
+            {
+                material = materialOverride->second.get();
+                ++materialOverride;
+            }
 
-            primitive.GetMaterial()->SetWireframe(pbrResources.GetFillMode() == FillMode::Wireframe);
-            primitive.GetMaterial()->Bind(context, pbrResources);
-            primitive.Render(context);
+            if (!material->Hidden)
+            {
+                (material->GetAlphaBlended() ? passes.Blended : passes.Opaque) = true;
+            }
+        }
+        return passes;
+    }
+
+    void Model::RenderPrimitives(Pbr::Resources const& pbrResources,
+                                 _In_ ID3D11DeviceContext* context,
+                                 const std::vector<XMFLOAT4X4>& nodeTransforms,
+                                 BufferHandle modelTransforms,
+                                 BufferHandle jointMatrices,
+                                 const MaterialOverrides* materialOverrides) const
+    {
+        static_assert(Pbr::ShaderSlots::JointMatrices == Pbr::ShaderSlots::Transforms + 1, "Transforms and joints are bound together");
+        const BufferHandle vsShaderBuffers[] = { modelTransforms, jointMatrices };
+        pbrResources.GetRenderDevice(context).SetShaderBuffers(
+            ShaderStage::Vertex, Pbr::ShaderSlots::Transforms, _countof(vsShaderBuffers), vsShaderBuffers);
+
+        // Views look down -Z, so the view-space depth of a bounds center is its negated z.
+        const XMMATRIX modelToView = XMMatrixMultiply(pbrResources.GetModelToWorld(), pbrResources.GetViewTransform());
+        const std::optional<DrawPass> drawPass = pbrResources.GetDrawPass();
+
+        // The overrides are sorted by primitive index, so they are walked along with the primitives.
+        m_draws.clear();
+        m_drawKeys.clear();
+        auto materialOverride = materialOverrides ? materialOverrides->begin() : MaterialOverrides::const_iterator{};
+        for (uint32_t primitiveIndex = 0; primitiveIndex < m_primitives.size(); primitiveIndex++)
+        {
+            const Pbr::Primitive& primitive = m_primitives[primitiveIndex];
+            Pbr::Material* material = primitive.GetMaterial().get();
+            if (materialOverrides && materialOverride != materialOverrides->end() && materialOverride->first == primitiveIndex)
+            {
+                material = materialOverride->second.get();
+                ++materialOverride;
+            }
+
+            if (material->Hidden) continue;
+
+            const DrawPass pass = material->GetAlphaBlended() ? DrawPass::Blended : DrawPass::Opaque;
+            if (drawPass && *drawPass != pass) continue;
+
+            // The node transforms are stored transposed for the shaders.
+            const NodeIndex_t nodeIndex = primitive.GetBoundsNodeIndex();
+            const XMMATRIX nodeToModel =
+                nodeIndex < nodeTransforms.size() ? XMMatrixTranspose(XMLoadFloat4x4(&nodeTransforms[nodeIndex])) : XMMatrixIdentity();
+            const XMVECTOR center =
+                XMVector3Transform(XMLoadFloat3(&primitive.GetBoundsCenter()), XMMatrixMultiply(nodeToModel, modelToView));
+
+            m_drawKeys.push_back(DrawSort::MakeKey(pass, -XMVectorGetZ(center), (uint32_t)m_draws.size()));
+            m_draws.emplace_back(&primitive, material);
+        }
+
+        // Opaque primitives are drawn front to back, then blended primitives back to front.
+        DrawSort::RadixSort(m_drawKeys, m_drawKeysScratch);
+        for (uint64_t drawKey : m_drawKeys)
+        {
+            const auto [primitive, material] = m_draws[DrawSort::GetIndex(drawKey)];
+            material->SetWireframe(pbrResources.GetFillMode() == FillMode::Wireframe);
+            material->Bind(context, pbrResources, primitive->GetVertexFormat());
+            primitive->Render(context, pbrResources);
         }
 
         // Expect the caller to reset other state, but the geometry shader is cleared specially.
@@ -53,7 +187,8 @@ namespace Pbr
         }
 
         m_nodes.emplace_back(transform, std::move(name), newNodeIndex, parentIndex);
-        m_modelTransformsStructuredBuffer = nullptr; // Structured buffer will need to be recreated.
+        m_nodeIndicesByName[m_nodes.back().Name].push_back(newNodeIndex);
+        m_modelTransformsBuffer = nullptr; // Structured buffer will need to be recreated.
         return m_nodes.back().Index;
     }
 
@@ -76,24 +211,71 @@ namespace Pbr
             clone->AddPrimitive(primitive.Clone(pbrResources));
         }
 
+        if (!m_jointNodes.empty())
+        {
+            clone->AddSkin(m_jointNodes, m_inverseBindMatrices);
+        }
+
         return clone;
     }
 
     std::optional<NodeIndex_t> Model::FindFirstNode(std::string_view name, std::optional<NodeIndex_t> const& parentNodeIndex) const {
-        // Children are guaranteed to come after their parents, so start looking after the parent index if one is provided.
-        const NodeIndex_t startIndex = parentNodeIndex ? parentNodeIndex.value() + 1 : Pbr::RootNodeIndex;
-        for (NodeIndex_t i = startIndex; i < m_nodes.size(); ++i) {
-            const Pbr::Node& node = m_nodes[i];
-            if ((!parentNodeIndex || node.ParentNodeIndex == parentNodeIndex.value()) && node.Name == name) {
-                return node.Index;
+        const auto nodeIndices = m_nodeIndicesByName.find(std::string(name));
+        if (nodeIndices == m_nodeIndicesByName.end()) {
+            return {};
+        }
+
+        const std::vector<NodeIndex_t>& indices = nodeIndices->second;
+        if (!parentNodeIndex) {
+            return indices.front();
+        }
+
+        // Children are guaranteed to come after their parents, so start looking after the parent index.
+        for (auto it = std::upper_bound(indices.begin(), indices.end(), parentNodeIndex.value()); it != indices.end(); ++it) {
+            if (m_nodes[*it].ParentNodeIndex == parentNodeIndex.value()) {
+                return *it;
             }
         }
         return {};
     }
 
+    ModelMemoryFootprint Model::GetMemoryFootprint() const
+    {
+        ModelMemoryFootprint footprint;
+        footprint.TransformBufferBytes = (m_nodes.size() + m_jointNodes.size()) * sizeof(decltype(m_modelTransforms)::value_type);
+
+        std::set<ID3D11Resource*> countedTextures;
+        for (const Primitive& primitive : m_primitives)
+        {
+            footprint.VertexBufferBytes += primitive.GetVertexBufferByteSize();
+            footprint.FullVertexBufferBytes += primitive.GetVertexCount() * sizeof(Vertex);
+            footprint.IndexBufferBytes += primitive.GetIndexBufferByteSize();
+
+            for (uint32_t slot = ShaderSlots::BaseColor; slot <= ShaderSlots::LastMaterialSlot; slot++)
+            {
+                ID3D11ShaderResourceView* const textureView = primitive.GetMaterial()->GetTexture((ShaderSlots::PSMaterial)slot);
+                if (textureView)
+                {
+                    winrt::com_ptr<ID3D11Resource> resource;
+                    textureView->GetResource(resource.put());
+                    if (countedTextures.insert(resource.get()).second)
+                    {
+                        footprint.TextureBytes += GetTextureByteSize(textureView);
+                    }
+                }
+            }
+        }
+
+        return footprint;
+    }
+
     XMMATRIX Model::GetNodeToModelRootTransform(NodeIndex_t nodeIndex) const
     {
         const Pbr::Node& node = GetNode(nodeIndex);
+        if (node.ParentNodeIndex == RootParentNodeIndex)
+        {
+            return XMMatrixIdentity(); // The root node itself.
+        }
 
         // Compute the transform recursively.
         const XMMATRIX parentTransform = node.ParentNodeIndex == Pbr::RootNodeIndex ? XMMatrixIdentity() : GetNodeToModelRootTransform(node.ParentNodeIndex);
@@ -105,52 +287,127 @@ namespace Pbr
         m_primitives.push_back(std::move(primitive));
     }
 
+    uint32_t Model::AddSkin(const std::vector<NodeIndex_t>& jointNodes, const std::vector<XMFLOAT4X4>& inverseBindMatrices)
+    {
+        if (jointNodes.size() != inverseBindMatrices.size())
+        {
+            throw std::exception("A skin needs one inverse bind matrix per joint");
+        }
+        if (std::any_of(jointNodes.begin(), jointNodes.end(), [&](NodeIndex_t nodeIndex) { return nodeIndex >= m_nodes.size(); }))
+        {
+            throw std::out_of_range("Joint node index is out of range");
+        }
+
+        const uint32_t firstJoint = (uint32_t)m_jointNodes.size();
+        m_jointNodes.insert(m_jointNodes.end(), jointNodes.begin(), jointNodes.end());
+        m_inverseBindMatrices.insert(m_inverseBindMatrices.end(), inverseBindMatrices.begin(), inverseBindMatrices.end());
+        m_modelTransformsBuffer = nullptr; // Recreates the joint matrices buffer along with the transforms buffer.
+        return firstJoint;
+    }
+
+    void Model::ComputeJointMatrices(const std::vector<XMFLOAT4X4>& modelTransforms, std::vector<XMFLOAT4X4>& jointMatrices) const
+    {
+        // Vertices are brought from the bind pose into joint space, posed by the joint, and made relative to the root node whose
+        // transform the vertex shader applies afterwards. The model transforms are transposed, so the order is reversed.
+        const XMMATRIX inverseRootTransform = XMMatrixInverse(nullptr, XMLoadFloat4x4(&modelTransforms[RootNodeIndex]));
+        jointMatrices.resize(m_jointNodes.size());
+        for (size_t joint = 0; joint < m_jointNodes.size(); joint++)
+        {
+            const XMMATRIX jointTransform = XMMatrixMultiply(inverseRootTransform, XMLoadFloat4x4(&modelTransforms[m_jointNodes[joint]]));
+            XMStoreFloat4x4(&jointMatrices[joint],
+                            XMMatrixMultiply(jointTransform, XMMatrixTranspose(XMLoadFloat4x4(&m_inverseBindMatrices[joint]))));
+        }
+    }
+
+    DeviceHandle<BufferHandle> Model::CreateTransformsBuffer(Pbr::Resources const& pbrResources, size_t nodeCount)
+    {
+        return pbrResources.CreateBuffer(
+            {BufferUsage::Structured, (uint32_t)(nodeCount * sizeof(XMFLOAT4X4)), (uint32_t)sizeof(XMFLOAT4X4)});
+    }
+
     void Model::UpdateTransforms(Pbr::Resources const& pbrResources, _In_ ID3D11DeviceContext* context) const
     {
-        const uint32_t newTotalModifyCount = std::accumulate(
-            m_nodes.begin(),
-            m_nodes.end(),
-            0,
-            [](uint32_t sumChangeCount, const Node& node) { return sumChangeCount + node.m_modifyCount; });
+        // The structured buffer is reset when a Node is added, and recreated along with the render device.
+        const bool recreateBuffer =
+            m_modelTransformsBuffer == nullptr || m_transformBuffersGeneration != pbrResources.GetRenderDeviceGeneration();
+        if (recreateBuffer)
+        {
+            m_modelTransforms.resize(m_nodes.size());
+            m_uploadedModifyCounts.assign(m_nodes.size(), 0);
+            m_dirtyNodes.assign(m_nodes.size(), true);
+
+            // Create/recreate the structured buffer which holds the node transforms.
+            m_modelTransformsBuffer = CreateTransformsBuffer(pbrResources, m_nodes.size());
+            m_jointMatricesBuffer = m_jointNodes.empty() ? nullptr : CreateTransformsBuffer(pbrResources, m_jointNodes.size());
+            m_transformBuffersGeneration = pbrResources.GetRenderDeviceGeneration();
+        }
+
+        // Nodes are guaranteed to come after their parents, so a single pass both marks the subtrees of changed nodes as dirty
+        // and multiplies each dirty node transform by its already updated parent transform.
+        assert(m_nodes.size() == m_modelTransforms.size());
+        m_lastTransformUpdateStats = {};
+        for (const auto& node : m_nodes)
+        {
+            assert(node.ParentNodeIndex == RootParentNodeIndex || node.ParentNodeIndex < node.Index);
+            const bool parentDirty = node.ParentNodeIndex != RootParentNodeIndex && m_dirtyNodes[node.ParentNodeIndex];
+            const bool dirty = recreateBuffer || parentDirty || node.m_modifyCount != m_uploadedModifyCounts[node.Index];
+            m_dirtyNodes[node.Index] = dirty;
+            if (!dirty)
+            {
+                continue;
+            }
+
+            const XMMATRIX parentTransform = (node.ParentNodeIndex == RootParentNodeIndex) ? XMMatrixIdentity() : XMLoadFloat4x4(&m_modelTransforms[node.ParentNodeIndex]);
+            XMStoreFloat4x4(&m_modelTransforms[node.Index], XMMatrixMultiply(parentTransform, XMMatrixTranspose(node.GetTransform())));
+            m_uploadedModifyCounts[node.Index] = node.m_modifyCount;
+            m_lastTransformUpdateStats.UpdatedNodeCount++;
+        }
+        if (m_lastTransformUpdateStats.UpdatedNodeCount > 0)
+        {
+            m_transformGeneration++;
+
+            // Skins have at most a few dozen joints, so their matrices are all uploaded whenever a node changed.
+            if (m_jointMatricesBuffer)
+            {
+                ComputeJointMatrices(m_modelTransforms, m_jointMatrices);
+                pbrResources.GetRenderDevice(context).UpdateBuffer(
+                    *m_jointMatricesBuffer, 0, m_jointMatrices.data(), (uint32_t)(m_jointMatrices.size() * sizeof(XMFLOAT4X4)));
+                m_lastTransformUpdateStats.UploadRangeCount++;
+                m_lastTransformUpdateStats.UploadBytes += m_jointMatrices.size() * sizeof(decltype(m_jointMatrices)::value_type);
+            }
+        }
 
-        // If none of the node transforms have changed, no need to recompute/update the model transform structured buffer.
-        if (newTotalModifyCount != TotalModifyCount || m_modelTransformsStructuredBuffer == nullptr)
+        // Upload the runs of dirty transforms. Runs separated by a few clean transforms are uploaded together, since
+        // uploading those again costs less than another update call.
+        constexpr size_t MaxCleanGap = 4;
+        const uint32_t transformByteSize = sizeof(decltype(m_modelTransforms)::value_type);
+        RenderDevice& renderDevice = pbrResources.GetRenderDevice(context);
+        size_t index = 0;
+        while (index < m_dirtyNodes.size())
         {
-            if (m_modelTransformsStructuredBuffer == nullptr) // The structured buffer is reset when a Node is added.
+            if (!m_dirtyNodes[index])
             {
-                m_modelTransforms.resize(m_nodes.size());
-
-                // Create/recreate the structured buffer and SRV which holds the node transforms.
-                // Use Usage=D3D11_USAGE_DYNAMIC and CPUAccessFlags=D3D11_CPU_ACCESS_WRITE with Map/Unmap instead?
-                D3D11_BUFFER_DESC desc{};
-                desc.Usage = D3D11_USAGE_DEFAULT;
-                desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-                desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
-                desc.StructureByteStride = sizeof(decltype(m_modelTransforms)::value_type);
-                desc.ByteWidth = (UINT)(m_modelTransforms.size() * desc.StructureByteStride);
-                m_modelTransformsStructuredBuffer = nullptr;
-                Internal::ThrowIfFailed(pbrResources.GetDevice()->CreateBuffer(&desc, nullptr, m_modelTransformsStructuredBuffer.put()));
-
-                D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
-                srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
-                srvDesc.Buffer.NumElements = (UINT)m_modelTransforms.size();
-                srvDesc.Buffer.ElementWidth = (UINT)m_modelTransforms.size();
-                m_modelTransformsResourceView = nullptr;
-                Internal::ThrowIfFailed(pbrResources.GetDevice()->CreateShaderResourceView(m_modelTransformsStructuredBuffer.get(), &srvDesc, m_modelTransformsResourceView.put()));
+                index++;
+                continue;
             }
 
-            // Nodes are guaranteed to come after their parents, so each node transform can be multiplied by its parent transform in a single pass.
-            assert(m_nodes.size() == m_modelTransforms.size());
-            for (const auto& node : m_nodes)
+            const size_t begin = index;
+            size_t end = index + 1;
+            for (size_t next = end; next < m_dirtyNodes.size() && next <= end + MaxCleanGap; next++)
             {
-                assert(node.ParentNodeIndex == RootParentNodeIndex || node.ParentNodeIndex < node.Index);
-                const XMMATRIX parentTransform = (node.ParentNodeIndex == RootParentNodeIndex) ? XMMatrixIdentity() : XMLoadFloat4x4(&m_modelTransforms[node.ParentNodeIndex]);
-                XMStoreFloat4x4(&m_modelTransforms[node.Index], XMMatrixMultiply(parentTransform, XMMatrixTranspose(node.GetTransform())));
+                if (m_dirtyNodes[next])
+                {
+                    end = next + 1;
+                }
             }
 
-            // Update node transform structured buffer.
-            context->UpdateSubresource(m_modelTransformsStructuredBuffer.get(), 0, nullptr, this->m_modelTransforms.data(), 0, 0);
-            TotalModifyCount = newTotalModifyCount;
+            renderDevice.UpdateBuffer(*m_modelTransformsBuffer,
+                                      (uint32_t)begin * transformByteSize,
+                                      &m_modelTransforms[begin],
+                                      (uint32_t)(end - begin) * transformByteSize);
+            m_lastTransformUpdateStats.UploadRangeCount++;
+            m_lastTransformUpdateStats.UploadBytes += (end - begin) * transformByteSize;
+            index = end;
         }
     }
 }
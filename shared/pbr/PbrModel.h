@@ -4,6 +4,7 @@
 #pragma once
 
 #include <optional>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 #include <winrt/base.h>
@@ -47,6 +48,34 @@ namespace Pbr {
         DirectX::XMFLOAT4X4 m_localTransform;
     };
 
+    // GPU memory used by a model, in bytes. Textures shared by several materials of the model are counted once.
+    struct ModelMemoryFootprint {
+        size_t VertexBufferBytes{0};
+        size_t IndexBufferBytes{0};
+        size_t TransformBufferBytes{0};
+        size_t TextureBytes{0};
+        size_t FullVertexBufferBytes{0}; // Size the vertex buffers would have with VertexFormat::Full.
+
+        size_t TotalBytes() const {
+            return VertexBufferBytes + IndexBufferBytes + TransformBufferBytes + TextureBytes;
+        }
+
+        // Fraction of vertex memory and fetch bandwidth saved by the compact vertex formats, between 0 and 1.
+        float VertexBytesReduction() const {
+            return FullVertexBufferBytes == 0 ? 0.0f : 1.0f - (float)VertexBufferBytes / FullVertexBufferBytes;
+        }
+    };
+
+    // Work done by the most recent transform update of a model. Only nodes whose transform or ancestors changed are updated.
+    struct TransformUpdateStats {
+        uint32_t UpdatedNodeCount{0};
+        uint32_t UploadRangeCount{0}; // Contiguous ranges of the transform buffer that were uploaded.
+        size_t UploadBytes{0};
+    };
+
+    // Materials that replace the materials of some primitives of a model, as (primitive index, material) sorted by index.
+    using MaterialOverrides = std::vector<std::pair<uint32_t, std::shared_ptr<Material>>>;
+
     // A model is a collection of primitives (which reference a material) and transforms referenced by the primitives' vertices.
     struct Model final {
         std::string Name;
@@ -60,13 +89,39 @@ namespace Pbr {
         // Add a primitive to the model.
         void AddPrimitive(Primitive primitive);
 
+        // Add the joints of a skin: the nodes posing each joint, and the inverse bind matrices that map the bind pose of the
+        // mesh into the space of each joint. Returns the index of the first joint, to add to the joint indices of the skin
+        // vertices. Skinned vertices end up relative to the root node, so they should use RootNodeIndex as transform index.
+        uint32_t AddSkin(const std::vector<NodeIndex_t>& jointNodes, const std::vector<DirectX::XMFLOAT4X4>& inverseBindMatrices);
+
+        uint32_t GetJointCount() const {
+            return (uint32_t)m_jointNodes.size();
+        }
+
+        // The joint matrices of the most recent Render, transposed like the shader reads them.
+        const std::vector<DirectX::XMFLOAT4X4>& GetJointMatrices() const {
+            return m_jointMatrices;
+        }
+
+        // The node to model transforms of the most recent Render, including the root node, transposed like the shader reads them.
+        const std::vector<DirectX::XMFLOAT4X4>& GetModelTransforms() const {
+            return m_modelTransforms;
+        }
+
+        // Compute the transform of a node relative to the root node from the node transforms, without the transforms of Render.
+        DirectX::XMMATRIX GetNodeToModelRootTransform(NodeIndex_t nodeIndex) const;
+
         // Render the model.
         void Render(Pbr::Resources const& pbrResources, _In_ ID3D11DeviceContext* context) const;
 
+        // The passes of the materials of the primitives that aren't hidden.
+        DrawPasses GetDrawPasses() const;
+
         // Remove all primitives.
         void Clear();
 
-        // Create a clone of this model.
+        // Create a clone of this model. Clones get their own materials and buffers; ModelInstance is much cheaper when copies only
+        // need their own node transforms or a few different materials.
         std::shared_ptr<Model> Clone(Pbr::Resources const& pbrResources) const;
 
         NodeIndex_t GetNodeCount() const {
@@ -89,14 +144,41 @@ namespace Pbr {
             return m_primitives[index];
         }
 
-        // Find the first node which matches a given name.
+        // Report the GPU memory used by the model's buffers and textures. Textures may also be shared with other models.
+        ModelMemoryFootprint GetMemoryFootprint() const;
+
+        // Report what the transform update of the most recent Render did.
+        const TransformUpdateStats& GetLastTransformUpdateStats() const {
+            return m_lastTransformUpdateStats;
+        }
+
+        // Find the first node which matches a given name, optionally among the children of a parent node. Names are looked up
+        // in an index that AddNode maintains, so the cost doesn't grow with the number of nodes.
         std::optional<NodeIndex_t> FindFirstNode(std::string_view name, std::optional<NodeIndex_t> const& parentNodeIndex = {}) const;
 
     private:
-        // Compute the transform relative to the root of the model for a given node.
-        DirectX::XMMATRIX GetNodeToModelRootTransform(NodeIndex_t nodeIndex) const;
-
-        // Updated the transforms used to render the model. This needs to be called any time a node transform is changed.
+        // Render the primitives with the given node transforms and joint matrices, replacing the materials of the overridden
+        // primitives. The visible primitives of the draw pass of the resources are drawn in the order of DrawSort, by the
+        // depth of their bounds centers with the (transposed) node transforms.
+        void RenderPrimitives(Pbr::Resources const& pbrResources,
+                              _In_ ID3D11DeviceContext* context,
+                              const std::vector<DirectX::XMFLOAT4X4>& nodeTransforms,
+                              BufferHandle modelTransforms,
+                              BufferHandle jointMatrices,
+                              const MaterialOverrides* materialOverrides) const;
+
+        // The passes of the primitives that aren't hidden, with the materials of the overridden primitives replaced.
+        DrawPasses GetDrawPasses(const MaterialOverrides* materialOverrides) const;
+
+        // Create a structured buffer of the given number of transforms in the render device of the resources.
+        static DeviceHandle<BufferHandle> CreateTransformsBuffer(Pbr::Resources const& pbrResources, size_t nodeCount);
+
+        // Compute the joint matrices of all skins from the (transposed) model transforms of the nodes.
+        void ComputeJointMatrices(const std::vector<DirectX::XMFLOAT4X4>& modelTransforms,
+                                  std::vector<DirectX::XMFLOAT4X4>& jointMatrices) const;
+
+        // Updated the transforms used to render the model. Only the subtrees of nodes changed since the last update are
+        // recomputed, and only the changed ranges of the structured buffer are uploaded.
         void UpdateTransforms(Pbr::Resources const& pbrResources, _In_ ID3D11DeviceContext* context) const;
 
     private:
@@ -108,11 +190,32 @@ namespace Pbr {
         // node's transform applied.
         Node::Collection m_nodes;
 
+        // Indices of the nodes with each name, in increasing order.
+        std::unordered_map<std::string, std::vector<NodeIndex_t>> m_nodeIndicesByName;
+
+        // The joints of all skins, concatenated.
+        std::vector<NodeIndex_t> m_jointNodes;
+        std::vector<DirectX::XMFLOAT4X4> m_inverseBindMatrices;
+
         // Temporary buffer holds the world transforms, computed from the node's local transforms.
         mutable std::vector<DirectX::XMFLOAT4X4> m_modelTransforms;
-        mutable winrt::com_ptr<ID3D11Buffer> m_modelTransformsStructuredBuffer;
-        mutable winrt::com_ptr<ID3D11ShaderResourceView> m_modelTransformsResourceView;
+        mutable DeviceHandle<BufferHandle> m_modelTransformsBuffer;
+        mutable uint32_t m_transformBuffersGeneration{0}; // The render device generation of the transforms and joint matrices buffers.
+
+        // Joint matrices, recomputed after updates that change any node transform.
+        mutable std::vector<DirectX::XMFLOAT4X4> m_jointMatrices;
+        mutable DeviceHandle<BufferHandle> m_jointMatricesBuffer;
+
+        mutable std::vector<uint32_t> m_uploadedModifyCounts; // Node modify counts at the last update.
+        mutable std::vector<bool> m_dirtyNodes;
+        mutable TransformUpdateStats m_lastTransformUpdateStats;
+        mutable uint32_t m_transformGeneration{0}; // Incremented by every update that changes a model transform.
+
+        // The draws of the most recent render and their sort keys, kept to reuse their memory.
+        mutable std::vector<std::pair<const Primitive*, Material*>> m_draws;
+        mutable std::vector<uint64_t> m_drawKeys;
+        mutable std::vector<uint64_t> m_drawKeysScratch;
 
-        mutable uint32_t TotalModifyCount{0};
+        friend struct ModelInstance;
     };
 } // namespace Pbr
@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <stdexcept>
+#include "PbrCommon.h"
+#include "PbrModelInstance.h"
+
+using namespace DirectX;
+
+namespace {
+    // Find an override in a vector of (index, value) pairs sorted by index, or the position to insert it at.
+    template <typename TOverrides, typename TIndex>
+    auto FindOverride(TOverrides& overrides, TIndex index) {
+        return std::lower_bound(
+            overrides.begin(), overrides.end(), index, [](const auto& entry, TIndex value) { return entry.first < value; });
+    }
+} // namespace
+
+namespace Pbr {
+    ModelInstance::ModelInstance(std::shared_ptr<const Model> model)
+        : m_model(std::move(model)) {
+        if (!m_model) {
+            throw std::exception("Model instances need a model");
+        }
+    }
+
+    void XM_CALLCONV ModelInstance::SetNodeTransform(NodeIndex_t nodeIndex, FXMMATRIX transform) {
+        if (nodeIndex >= m_model->GetNodeCount()) {
+            throw std::out_of_range("Node index out of range");
+        }
+
+        const auto it = FindOverride(m_nodeTransformOverrides, nodeIndex);
+        if (it != m_nodeTransformOverrides.end() && it->first == nodeIndex) {
+            XMStoreFloat4x4(&it->second, transform);
+        } else {
+            XMStoreFloat4x4(&m_nodeTransformOverrides.emplace(it, nodeIndex, XMFLOAT4X4{})->second, transform);
+        }
+        m_transformsChanged = true;
+    }
+
+    XMMATRIX XM_CALLCONV ModelInstance::GetNodeTransform(NodeIndex_t nodeIndex) const {
+        const auto it = FindOverride(m_nodeTransformOverrides, nodeIndex);
+        if (it != m_nodeTransformOverrides.end() && it->first == nodeIndex) {
+            return XMLoadFloat4x4(&it->second);
+        }
+        return m_model->GetNode(nodeIndex).GetTransform();
+    }
+
+    void ModelInstance::ResetNodeTransform(NodeIndex_t nodeIndex) {
+        const auto it = FindOverride(m_nodeTransformOverrides, nodeIndex);
+        if (it != m_nodeTransformOverrides.end() && it->first == nodeIndex) {
+            m_nodeTransformOverrides.erase(it);
+            m_transformsChanged = true;
+        }
+    }
+
+    void ModelInstance::ResetNodeTransforms() {
+        m_nodeTransformOverrides.clear();
+        m_nodeTransformOverrides.shrink_to_fit();
+        m_modelTransforms.clear();
+        m_modelTransforms.shrink_to_fit();
+        m_modelTransformsBuffer = nullptr;
+        m_jointMatricesBuffer = nullptr;
+    }
+
+    void ModelInstance::SetMaterialOverride(uint32_t primitiveIndex, std::shared_ptr<Material> material) {
+        if (primitiveIndex >= m_model->GetPrimitiveCount()) {
+            throw std::out_of_range("Primitive index out of range");
+        }
+
+        const auto it = FindOverride(m_materialOverrides, primitiveIndex);
+        const bool found = it != m_materialOverrides.end() && it->first == primitiveIndex;
+        if (!material) {
+            if (found) {
+                m_materialOverrides.erase(it);
+            }
+        } else if (found) {
+            it->second = std::move(material);
+        } else {
+            m_materialOverrides.emplace(it, primitiveIndex, std::move(material));
+        }
+    }
+
+    const std::shared_ptr<Material>& ModelInstance::GetMaterial(uint32_t primitiveIndex) const {
+        const auto it = FindOverride(m_materialOverrides, primitiveIndex);
+        if (it != m_materialOverrides.end() && it->first == primitiveIndex) {
+            return it->second;
+        }
+        return m_model->GetPrimitive(primitiveIndex).GetMaterial();
+    }
+
+    DrawPasses ModelInstance::GetDrawPasses() const {
+        return m_model->GetDrawPasses(&m_materialOverrides);
+    }
+
+    void ModelInstance::Render(Pbr::Resources const& pbrResources, _In_ ID3D11DeviceContext* context) const {
+        // The model's transforms are updated first, since unposed instances render with them and posed ones build on them.
+        m_model->UpdateTransforms(pbrResources, context);
+
+        const std::vector<XMFLOAT4X4>* nodeTransforms = &m_model->m_modelTransforms;
+        const DeviceHandle<BufferHandle>* modelTransforms = &m_model->m_modelTransformsBuffer;
+        const DeviceHandle<BufferHandle>* jointMatrices = &m_model->m_jointMatricesBuffer;
+        if (!m_nodeTransformOverrides.empty()) {
+            UpdateTransforms(pbrResources, context);
+            nodeTransforms = &m_modelTransforms;
+            modelTransforms = &m_modelTransformsBuffer;
+            jointMatrices = &m_jointMatricesBuffer;
+        }
+
+        m_model->RenderPrimitives(pbrResources,
+                                  context,
+                                  *nodeTransforms,
+                                  **modelTransforms,
+                                  *jointMatrices ? **jointMatrices : BufferHandle::None,
+                                  m_materialOverrides.empty() ? nullptr : &m_materialOverrides);
+    }
+
+    void ModelInstance::UpdateTransforms(Pbr::Resources const& pbrResources, _In_ ID3D11DeviceContext* context) const {
+        const NodeIndex_t nodeCount = m_model->GetNodeCount();
+        const uint32_t jointCount = m_model->GetJointCount();
+        const uint32_t renderDeviceGeneration = pbrResources.GetRenderDeviceGeneration();
+        if (!m_modelTransformsBuffer || m_transformBufferNodeCount != nodeCount || m_jointBufferJointCount != jointCount ||
+            m_transformBuffersGeneration != renderDeviceGeneration) {
+            m_transformBufferNodeCount = nodeCount;
+            m_jointBufferJointCount = jointCount;
+            m_transformBuffersGeneration = renderDeviceGeneration;
+            m_modelTransformsBuffer = Model::CreateTransformsBuffer(pbrResources, nodeCount);
+            m_jointMatricesBuffer = jointCount > 0 ? Model::CreateTransformsBuffer(pbrResources, jointCount) : nullptr;
+            m_transformsChanged = true;
+        }
+
+        if (!m_transformsChanged && m_modelTransformGeneration == m_model->m_transformGeneration) {
+            return;
+        }
+
+        // Nodes are guaranteed to come after their parents, so each node transform can be multiplied by its parent transform
+        // in a single pass. The transforms are kept to sort the draws of the instance by depth.
+        std::vector<XMFLOAT4X4>& modelTransforms = m_modelTransforms;
+        modelTransforms.resize(nodeCount);
+        auto nodeOverride = m_nodeTransformOverrides.begin();
+        for (NodeIndex_t nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++) {
+            const Node& node = m_model->GetNode(nodeIndex);
+            XMMATRIX localTransform;
+            if (nodeOverride != m_nodeTransformOverrides.end() && nodeOverride->first == nodeIndex) {
+                localTransform = XMLoadFloat4x4(&nodeOverride->second);
+                ++nodeOverride;
+            } else {
+                localTransform = node.GetTransform();
+            }
+
+            const XMMATRIX parentTransform =
+                node.ParentNodeIndex < nodeIndex ? XMLoadFloat4x4(&modelTransforms[node.ParentNodeIndex]) : XMMatrixIdentity();
+            XMStoreFloat4x4(&modelTransforms[nodeIndex], XMMatrixMultiply(parentTransform, XMMatrixTranspose(localTransform)));
+        }
+
+        RenderDevice& renderDevice = pbrResources.GetRenderDevice(context);
+        renderDevice.UpdateBuffer(*m_modelTransformsBuffer, 0, modelTransforms.data(), (uint32_t)(nodeCount * sizeof(XMFLOAT4X4)));
+        if (m_jointMatricesBuffer) {
+            std::vector<XMFLOAT4X4> jointMatrices;
+            m_model->ComputeJointMatrices(modelTransforms, jointMatrices);
+            renderDevice.UpdateBuffer(*m_jointMatricesBuffer, 0, jointMatrices.data(), (uint32_t)(jointCount * sizeof(XMFLOAT4X4)));
+        }
+        m_transformsChanged = false;
+        m_modelTransformGeneration = m_model->m_transformGeneration;
+    }
+
+    size_t ModelInstance::GetInstanceByteSize() const {
+        size_t byteSize = sizeof(ModelInstance);
+        byteSize += m_nodeTransformOverrides.capacity() * sizeof(NodeTransformOverride);
+        byteSize += m_materialOverrides.capacity() * sizeof(MaterialOverrides::value_type);
+        if (m_modelTransformsBuffer) {
+            byteSize += ((size_t)m_model->GetNodeCount() + m_model->GetJointCount()) * sizeof(XMFLOAT4X4);
+        }
+        byteSize += m_modelTransforms.capacity() * sizeof(XMFLOAT4X4);
+        return byteSize;
+    }
+} // namespace Pbr
@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+#include <winrt/base.h>
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include "PbrModel.h"
+
+namespace Pbr {
+    // An independently posable copy of a model that shares the model's primitives, materials and node hierarchy. An instance
+    // only owns the node transforms and materials that differ from the model: until a node transform is overridden it renders
+    // with the model's transform buffer, and a posed instance owns one transform buffer, plus one joint matrix buffer for
+    // skinned models. Changes to the model's own node transforms show through on the nodes the instance doesn't override.
+    struct ModelInstance final {
+        explicit ModelInstance(std::shared_ptr<const Model> model);
+
+        const std::shared_ptr<const Model>& GetModel() const {
+            return m_model;
+        }
+
+        // Override the transform of a node relative to its parent, for this instance only.
+        void XM_CALLCONV SetNodeTransform(NodeIndex_t nodeIndex, DirectX::FXMMATRIX transform);
+
+        // Get the transform of a node relative to its parent: the instance's override, or the model's transform.
+        DirectX::XMMATRIX XM_CALLCONV GetNodeTransform(NodeIndex_t nodeIndex) const;
+
+        // Go back to the model's transform for one node or for all nodes.
+        void ResetNodeTransform(NodeIndex_t nodeIndex);
+        void ResetNodeTransforms();
+
+        // Render a primitive with a different material, for this instance only. A null material removes the override.
+        void SetMaterialOverride(uint32_t primitiveIndex, std::shared_ptr<Material> material);
+
+        // Get the material a primitive is rendered with: the instance's override, or the model's material.
+        const std::shared_ptr<Material>& GetMaterial(uint32_t primitiveIndex) const;
+
+        // Render the model with the instance's node transforms and materials.
+        void Render(Pbr::Resources const& pbrResources, _In_ ID3D11DeviceContext* context) const;
+
+        // The passes of the instance's materials of the primitives that aren't hidden.
+        DrawPasses GetDrawPasses() const;
+
+        // Memory owned by this instance, in bytes, including its transform buffer. The shared model is not included.
+        size_t GetInstanceByteSize() const;
+
+    private:
+        using NodeTransformOverride = std::pair<NodeIndex_t, DirectX::XMFLOAT4X4>;
+
+        void UpdateTransforms(Pbr::Resources const& pbrResources, _In_ ID3D11DeviceContext* context) const;
+
+        std::shared_ptr<const Model> m_model;
+        std::vector<NodeTransformOverride> m_nodeTransformOverrides; // Sorted by node index.
+        MaterialOverrides m_materialOverrides;
+
+        mutable std::vector<DirectX::XMFLOAT4X4> m_modelTransforms; // Transposed like the model's, once a node is overridden.
+        mutable DeviceHandle<BufferHandle> m_modelTransformsBuffer; // Only created once a node is overridden.
+        mutable DeviceHandle<BufferHandle> m_jointMatricesBuffer;   // Only for posed instances of skinned models.
+        mutable uint32_t m_transformBuffersGeneration{0};          // The render device generation of the buffers.
+        mutable NodeIndex_t m_transformBufferNodeCount{0};
+        mutable uint32_t m_jointBufferJointCount{0};
+        mutable bool m_transformsChanged{false};
+        mutable uint32_t m_modelTransformGeneration{0};
+    };
+} // namespace Pbr
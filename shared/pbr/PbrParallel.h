@@ -0,0 +1,44 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// Data parallel helpers for CPU-side asset processing. This code has no graphics API dependency.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace Pbr {
+    namespace Internal {
+        // Run fn(begin, end) over [0, count) split into contiguous bands. Bands beyond the first run through std::async,
+        // which is backed by the system thread pool. Work smaller than minCostPerTask (in the caller's cost units) runs inline.
+        template <typename Fn>
+        void ParallelFor(uint32_t count, uint64_t costPerItem, uint64_t minCostPerTask, const Fn& fn) {
+            const uint32_t maxTasks = std::max(1u, std::thread::hardware_concurrency());
+            const uint64_t tasksForCost = (count * costPerItem) / std::max<uint64_t>(1, minCostPerTask);
+            const uint32_t taskCount = (uint32_t)std::clamp<uint64_t>(tasksForCost, 1, std::min(maxTasks, std::max(1u, count)));
+            if (taskCount <= 1) {
+                fn(0u, count);
+                return;
+            }
+
+            std::vector<std::future<void>> tasks;
+            tasks.reserve(taskCount - 1);
+            const uint32_t bandSize = (count + taskCount - 1) / taskCount;
+            for (uint32_t begin = bandSize; begin < count; begin += bandSize) {
+                const uint32_t end = std::min(begin + bandSize, count);
+                tasks.push_back(std::async(std::launch::async, [&fn, begin, end] { fn(begin, end); }));
+            }
+            fn(0u, std::min(bandSize, count));
+
+            for (std::future<void>& task : tasks) {
+                task.get(); // Propagates exceptions.
+            }
+        }
+    } // namespace Internal
+} // namespace Pbr
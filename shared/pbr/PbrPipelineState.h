@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// Graphics API independent key and cache for pipeline state objects. A pipeline state bundles the shader pair,
+// input layout, rasterizer, depth-stencil and blend state of a draw so that it can be created once and bound as a unit.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Pbr {
+    namespace PipelineStateBits {
+        enum : uint32_t {
+            Highlight = 1 << 0,               // Highlight shaders instead of the regular PBR shaders.
+            AlphaBlended = 1 << 1,            // Alpha blending enabled and depth writes disabled.
+            DoubleSided = 1 << 2,             // No back face culling.
+            Wireframe = 1 << 3,               // Wireframe fill mode.
+            FrontCounterClockwise = 1 << 4,   // Counter clockwise front face winding order.
+            ReverseZ = 1 << 5,                // Greater depth comparison for reversed depth buffers.
+            CompactVertex = 1 << 6,           // Input layout and vertex shaders of VertexFormat::Compact.
+            QuantizedPosition = 1 << 7,       // With CompactVertex, VertexFormat::CompactQuantized.
+            SplitVertexStreams = 1 << 8,      // Input layout of VertexFormat::Streaming, with the full vertex shaders.
+            SkinnedVertex = 1 << 9,           // Input layout and skinning vertex shaders of VertexFormat::Skinned.
+            MaterialTable = 1 << 10,          // Pixel shader reading the material parameters from the material table.
+            TextureArrays = 1 << 11,          // Pixel shader sampling the material textures from slices of texture arrays.
+            PixelShader = 3 << 12,            // Two bits holding the PixelShaderPermutation of the material.
+        };
+        constexpr uint32_t PixelShaderShift = 12;
+
+        // The vertex format bits, and their combinations that describe a vertex format.
+        constexpr uint32_t VertexFormatMask = CompactVertex | QuantizedPosition | SplitVertexStreams | SkinnedVertex;
+        constexpr uint32_t VertexFormats[] = {0, CompactVertex, CompactVertex | QuantizedPosition, SplitVertexStreams, SkinnedVertex};
+
+        // The bits that vary between the materials drawn with the same resources settings.
+        constexpr uint32_t MaterialMask = AlphaBlended | DoubleSided | Wireframe | VertexFormatMask | PixelShader;
+
+        // The bits that the highlight shaders ignore.
+        constexpr uint32_t PbrPixelShaderMask = MaterialTable | TextureArrays | PixelShader;
+    } // namespace PipelineStateBits
+
+    // Specializations of the PBR pixel shader, each skipping work that some materials don't need.
+    enum class PixelShaderPermutation : uint32_t {
+        Full,                 // Material textures, the directional light and image-based lighting.
+        NoImageBasedLighting, // Material textures and the directional light.
+        Flat,                 // Material factors without textures, the directional light and image-based lighting.
+        Unlit,                // Base color and emissive, without lighting.
+    };
+    constexpr uint32_t PixelShaderPermutationCount = 4;
+
+    // The contents of a material that decide which pixel shader permutation draws it.
+    struct MaterialFeatures {
+        bool Textured{true};           // Some texture differs from the neutral texture of its slot.
+        bool Lit{true};                // Lit by the directional light and image-based lighting.
+        bool ImageBasedLighting{true}; // With Lit, also lit by image-based lighting.
+    };
+
+    // The cheapest permutation that draws a material with the features correctly. Untextured materials don't sample their
+    // neutral textures, and materials without image-based lighting have no flat variant of their own.
+    constexpr PixelShaderPermutation SelectPixelShaderPermutation(const MaterialFeatures& features) {
+        if (!features.Lit) {
+            return PixelShaderPermutation::Unlit;
+        }
+        if (!features.ImageBasedLighting) {
+            return PixelShaderPermutation::NoImageBasedLighting;
+        }
+        return features.Textured ? PixelShaderPermutation::Full : PixelShaderPermutation::Flat;
+    }
+
+    // A packed description of a pipeline state. Two keys compare equal exactly when they describe the same state.
+    struct PipelineStateKey {
+        uint32_t Bits{0};
+
+        constexpr bool Has(uint32_t bit) const {
+            return (Bits & bit) != 0;
+        }
+
+        constexpr PipelineStateKey With(uint32_t bit, bool enabled) const {
+            return PipelineStateKey{enabled ? (Bits | bit) : (Bits & ~bit)};
+        }
+
+        constexpr PixelShaderPermutation GetPixelShaderPermutation() const {
+            return (PixelShaderPermutation)((Bits & PipelineStateBits::PixelShader) >> PipelineStateBits::PixelShaderShift);
+        }
+
+        constexpr PipelineStateKey With(PixelShaderPermutation permutation) const {
+            const uint32_t permutationBits = (uint32_t)permutation << PipelineStateBits::PixelShaderShift;
+            return PipelineStateKey{(Bits & ~PipelineStateBits::PixelShader) | permutationBits};
+        }
+
+        // Whether the vertex format bits describe a vertex format.
+        constexpr bool IsValid() const {
+            for (uint32_t vertexFormat : PipelineStateBits::VertexFormats) {
+                if ((Bits & PipelineStateBits::VertexFormatMask) == vertexFormat) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // The key with the bits that don't change the pipeline state cleared, so that keys of the same state compare equal.
+        // Highlight shaders ignore the material table, the texture arrays and the PBR pixel shader permutation.
+        constexpr PipelineStateKey Normalized() const {
+            return Has(PipelineStateBits::Highlight) ? PipelineStateKey{Bits & ~PipelineStateBits::PbrPixelShaderMask} : *this;
+        }
+
+        constexpr bool operator==(const PipelineStateKey& other) const {
+            return Bits == other.Bits;
+        }
+
+        constexpr bool operator!=(const PipelineStateKey& other) const {
+            return Bits != other.Bits;
+        }
+    };
+
+    struct PipelineStateKeyHash {
+        size_t operator()(const PipelineStateKey& key) const {
+            return std::hash<uint32_t>{}(key.Bits);
+        }
+    };
+
+    // The distinct normalized keys that materials can resolve to with the resources settings of the base key, which are the
+    // bits outside of PipelineStateBits::MaterialMask.
+    inline std::vector<PipelineStateKey> GetMaterialPipelineStateKeys(PipelineStateKey baseKey) {
+        const PipelineStateKey settingsKey{baseKey.Bits & ~PipelineStateBits::MaterialMask};
+        const uint32_t permutationCount = settingsKey.Has(PipelineStateBits::Highlight) ? 1 : PixelShaderPermutationCount;
+
+        std::vector<PipelineStateKey> keys;
+        for (uint32_t vertexFormat : PipelineStateBits::VertexFormats) {
+            for (uint32_t permutation = 0; permutation < permutationCount; permutation++) {
+                for (bool alphaBlended : {false, true}) {
+                    for (bool doubleSided : {false, true}) {
+                        for (bool wireframe : {false, true}) {
+                            keys.push_back(PipelineStateKey{settingsKey.Bits | vertexFormat}
+                                               .With((PixelShaderPermutation)permutation)
+                                               .With(PipelineStateBits::AlphaBlended, alphaBlended)
+                                               .With(PipelineStateBits::DoubleSided, doubleSided)
+                                               .With(PipelineStateBits::Wireframe, wireframe)
+                                               .Normalized());
+                        }
+                    }
+                }
+            }
+        }
+        return keys;
+    }
+
+    // Thread-safe cache of pipeline states keyed by PipelineStateKey.
+    // Returned references stay valid until Clear() is called or the cache is destroyed.
+    template <typename TPipelineState>
+    class PipelineStateCache {
+    public:
+        using Factory = std::function<std::unique_ptr<TPipelineState>(PipelineStateKey)>;
+
+        const TPipelineState& GetOrCreate(PipelineStateKey key, const Factory& factory) {
+            std::lock_guard guard(m_mutex);
+            auto it = m_states.find(key);
+            if (it == m_states.end()) {
+                it = m_states.emplace(key, factory(key)).first;
+            }
+            return *it->second;
+        }
+
+        const TPipelineState* Find(PipelineStateKey key) const {
+            std::lock_guard guard(m_mutex);
+            auto it = m_states.find(key);
+            return it == m_states.end() ? nullptr : it->second.get();
+        }
+
+        size_t Size() const {
+            std::lock_guard guard(m_mutex);
+            return m_states.size();
+        }
+
+        void Clear() {
+            std::lock_guard guard(m_mutex);
+            m_states.clear();
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+        std::unordered_map<PipelineStateKey, std::unique_ptr<TPipelineState>, PipelineStateKeyHash> m_states;
+    };
+} // namespace Pbr
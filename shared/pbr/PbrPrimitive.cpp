@@ -2,6 +2,9 @@
 // Copyright (C) Microsoft Corporation.  All Rights Reserved
 // Licensed under the MIT License. See License.txt in the project root for license information.
 #include "pch.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include "PbrCommon.h"
 #include "PbrResources.h"
 #include "PbrPrimitive.h"
@@ -9,61 +12,250 @@
 using namespace DirectX;
 
 namespace {
-    UINT GetPbrVertexByteSize(size_t size) {
-        return (UINT)(sizeof(decltype(Pbr::PrimitiveBuilder::Vertices)::value_type) * size);
+    // Encode the attributes shared by the compact vertex formats.
+    template <typename TCompactVertex>
+    void EncodeCompactAttributes(const Pbr::Vertex& vertex, TCompactVertex& compactVertex) {
+        using namespace Pbr::VertexQuantization;
+        const std::array<int16_t, 2> normal = EncodeOctahedral(vertex.Normal.x, vertex.Normal.y, vertex.Normal.z);
+        const std::array<int16_t, 2> tangent = EncodeOctahedral(vertex.Tangent.x, vertex.Tangent.y, vertex.Tangent.z);
+        compactVertex.NormalTangent = {normal[0], normal[1], tangent[0], tangent[1]};
+        compactVertex.TangentSign = FloatToSnorm16(vertex.Tangent.w < 0 ? -1.0f : 1.0f);
+        compactVertex.TexCoord0 = {FloatToHalf(vertex.TexCoord0.x), FloatToHalf(vertex.TexCoord0.y)};
+        compactVertex.Color0 = {FloatToUnorm8(vertex.Color0.x),
+                                FloatToUnorm8(vertex.Color0.y),
+                                FloatToUnorm8(vertex.Color0.z),
+                                FloatToUnorm8(vertex.Color0.w)};
+        compactVertex.ModelTransformIndex = vertex.ModelTransformIndex;
+    }
+
+    Pbr::VertexQuantization::PositionBounds ComputePositionBounds(const Pbr::PrimitiveBuilder& primitiveBuilder) {
+        return Pbr::VertexQuantization::ComputePositionBounds(
+            primitiveBuilder.Vertices.data(), primitiveBuilder.Vertices.size(), sizeof(Pbr::Vertex));
+    }
+
+    // Size of a vertex in the first vertex buffer. The skin vertices of VertexFormat::Skinned are in a buffer of their own.
+    UINT GetFirstStreamStride(Pbr::VertexFormat vertexFormat) {
+        return vertexFormat == Pbr::VertexFormat::Skinned ? (UINT)sizeof(Pbr::Vertex) : Pbr::GetVertexStride(vertexFormat);
+    }
+
+    // Returns the vertex data in the layout of the vertex format, only the first stream for VertexFormat::Skinned. Compact
+    // vertices are encoded into the storage vector.
+    const void* GetVertexData(const Pbr::PrimitiveBuilder& primitiveBuilder,
+                              Pbr::VertexFormat vertexFormat,
+                              const Pbr::VertexQuantization::PositionBounds& positionBounds,
+                              std::vector<uint8_t>& storage) {
+        const std::vector<Pbr::Vertex>& vertices = primitiveBuilder.Vertices;
+        if (vertexFormat == Pbr::VertexFormat::Full || vertexFormat == Pbr::VertexFormat::Skinned) {
+            return vertices.data();
+        }
+
+        storage.resize(vertices.size() * Pbr::GetVertexStride(vertexFormat));
+        if (vertexFormat == Pbr::VertexFormat::Compact) {
+            Pbr::CompactVertex* const compactVertices = reinterpret_cast<Pbr::CompactVertex*>(storage.data());
+            for (size_t i = 0; i < vertices.size(); i++) {
+                compactVertices[i].Position = vertices[i].Position;
+                EncodeCompactAttributes(vertices[i], compactVertices[i]);
+            }
+        } else {
+            Pbr::QuantizedVertex* const quantizedVertices = reinterpret_cast<Pbr::QuantizedVertex*>(storage.data());
+            for (size_t i = 0; i < vertices.size(); i++) {
+                const std::array<int16_t, 3> position = Pbr::VertexQuantization::QuantizePosition(&vertices[i].Position.x, positionBounds);
+                quantizedVertices[i].Position = {position[0], position[1], position[2], 0};
+                EncodeCompactAttributes(vertices[i], quantizedVertices[i]);
+            }
+        }
+        return storage.data();
     }
 
     winrt::com_ptr<ID3D11Buffer> CreateVertexBuffer(_In_ ID3D11Device* device,
                                                     const Pbr::PrimitiveBuilder& primitiveBuilder,
-                                                    bool updatableBuffers) {
+                                                    Pbr::VertexFormat vertexFormat,
+                                                    const Pbr::VertexQuantization::PositionBounds& positionBounds) {
         // Create Vertex Buffer
         D3D11_BUFFER_DESC desc{};
         desc.Usage = D3D11_USAGE_DEFAULT;
-        desc.ByteWidth = GetPbrVertexByteSize(primitiveBuilder.Vertices.size());
+        desc.ByteWidth = (UINT)(GetFirstStreamStride(vertexFormat) * primitiveBuilder.Vertices.size());
         desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 
-        if (updatableBuffers) {
-            desc.Usage = D3D11_USAGE_DYNAMIC;
-            desc.CPUAccessFlags |= D3D11_CPU_ACCESS_WRITE;
-        }
-
+        std::vector<uint8_t> encodedVertices;
         D3D11_SUBRESOURCE_DATA initData{};
-        initData.pSysMem = primitiveBuilder.Vertices.data();
+        initData.pSysMem = GetVertexData(primitiveBuilder, vertexFormat, positionBounds, encodedVertices);
 
         winrt::com_ptr<ID3D11Buffer> vertexBuffer;
         Pbr::Internal::ThrowIfFailed(device->CreateBuffer(&desc, &initData, vertexBuffer.put()));
         return vertexBuffer;
     }
 
+    // Vertex buffer of the second stream of VertexFormat::Skinned.
+    winrt::com_ptr<ID3D11Buffer> CreateSkinVertexBuffer(_In_ ID3D11Device* device, const Pbr::PrimitiveBuilder& primitiveBuilder) {
+        if (primitiveBuilder.SkinVertices.size() != primitiveBuilder.Vertices.size()) {
+            throw std::exception("Skinned primitives need one skin vertex per vertex");
+        }
+
+        D3D11_BUFFER_DESC desc{};
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.ByteWidth = (UINT)(sizeof(Pbr::SkinVertex) * primitiveBuilder.SkinVertices.size());
+        desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+        D3D11_SUBRESOURCE_DATA initData{};
+        initData.pSysMem = primitiveBuilder.SkinVertices.data();
+
+        winrt::com_ptr<ID3D11Buffer> skinVertexBuffer;
+        Pbr::Internal::ThrowIfFailed(device->CreateBuffer(&desc, &initData, skinVertexBuffer.put()));
+        return skinVertexBuffer;
+    }
+
+    // Constant buffer with the bounds that quantized positions are decoded with.
+    winrt::com_ptr<ID3D11Buffer> CreatePositionBoundsBuffer(_In_ ID3D11Device* device,
+                                                            const Pbr::VertexQuantization::PositionBounds& positionBounds) {
+        struct PrimitiveConstantBuffer {
+            DirectX::XMFLOAT4 PositionCenter;
+            DirectX::XMFLOAT4 PositionExtent;
+        };
+        static_assert((sizeof(PrimitiveConstantBuffer) % 16) == 0, "Constant Buffer must be divisible by 16 bytes");
+
+        const PrimitiveConstantBuffer constants{
+            {positionBounds.Center[0], positionBounds.Center[1], positionBounds.Center[2], 0},
+            {positionBounds.Extent[0], positionBounds.Extent[1], positionBounds.Extent[2], 0}};
+        const CD3D11_BUFFER_DESC desc(sizeof(PrimitiveConstantBuffer), D3D11_BIND_CONSTANT_BUFFER, D3D11_USAGE_IMMUTABLE);
+        D3D11_SUBRESOURCE_DATA initData{};
+        initData.pSysMem = &constants;
+
+        winrt::com_ptr<ID3D11Buffer> constantBuffer;
+        Pbr::Internal::ThrowIfFailed(device->CreateBuffer(&desc, &initData, constantBuffer.put()));
+        return constantBuffer;
+    }
+
+    // Indices are stored as 16-bit when every vertex can be addressed with them, halving index memory and bandwidth.
+    DXGI_FORMAT SelectIndexFormat(const Pbr::PrimitiveBuilder& primitiveBuilder) {
+        constexpr size_t MaxVertexCount16 = (size_t)std::numeric_limits<uint16_t>::max() + 1;
+        return primitiveBuilder.Vertices.size() <= MaxVertexCount16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    }
+
+    UINT GetIndexByteSize(DXGI_FORMAT indexFormat, size_t size) {
+        return (UINT)((indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t)) * size);
+    }
+
+    // Returns the index data in the given format. 16-bit indices are converted into the storage vector.
+    const void* GetIndexData(const Pbr::PrimitiveBuilder& primitiveBuilder, DXGI_FORMAT indexFormat, std::vector<uint16_t>& storage) {
+        if (indexFormat == DXGI_FORMAT_R32_UINT) {
+            return primitiveBuilder.Indices.data();
+        }
+
+        storage.resize(primitiveBuilder.Indices.size());
+        std::transform(primitiveBuilder.Indices.begin(), primitiveBuilder.Indices.end(), storage.begin(), [](uint32_t index) {
+            return (uint16_t)index;
+        });
+        return storage.data();
+    }
+
     winrt::com_ptr<ID3D11Buffer> CreateIndexBuffer(_In_ ID3D11Device* device,
                                                    const Pbr::PrimitiveBuilder& primitiveBuilder,
-                                                   bool updatableBuffers) {
+                                                   DXGI_FORMAT indexFormat) {
         // Create Index Buffer
         D3D11_BUFFER_DESC desc{};
         desc.Usage = D3D11_USAGE_DEFAULT;
-        desc.ByteWidth = (UINT)(sizeof(decltype(primitiveBuilder.Indices)::value_type) * primitiveBuilder.Indices.size());
+        desc.ByteWidth = GetIndexByteSize(indexFormat, primitiveBuilder.Indices.size());
         desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 
-        if (updatableBuffers) {
-            desc.Usage = D3D11_USAGE_DYNAMIC;
-            desc.CPUAccessFlags |= D3D11_CPU_ACCESS_WRITE;
-        }
-
+        std::vector<uint16_t> indices16;
         D3D11_SUBRESOURCE_DATA initData{};
-        initData.pSysMem = primitiveBuilder.Indices.data();
+        initData.pSysMem = GetIndexData(primitiveBuilder, indexFormat, indices16);
 
         winrt::com_ptr<ID3D11Buffer> indexBuffer;
         Pbr::Internal::ThrowIfFailed(device->CreateBuffer(&desc, &initData, indexBuffer.put()));
         return indexBuffer;
     }
+
+    UINT GetBufferByteSize(ID3D11Buffer* buffer) {
+        D3D11_BUFFER_DESC desc;
+        buffer->GetDesc(&desc);
+        return desc.ByteWidth;
+    }
 } // namespace
 
 namespace Pbr {
+    // The ring buffers of a primitive with updatable buffers, and the offsets of the most recent data in them.
+    struct Primitive::StreamingGeometry {
+        StreamingBuffer DynamicVertices{D3D11_BIND_VERTEX_BUFFER};
+        StreamingBuffer StaticVertices{D3D11_BIND_VERTEX_BUFFER};
+        StreamingBuffer Indices{D3D11_BIND_INDEX_BUFFER};
+        UINT DynamicVertexOffset{0};
+        UINT StaticVertexOffset{0};
+        UINT IndexByteOffset{0};
+
+        // The last uploaded static vertices and indices, so they are only uploaded again when they change.
+        std::vector<StreamingVertex::Static> StaticVertexData;
+        std::vector<uint8_t> IndexData;
+
+        uint64_t LastUpdateUploadBytes{0};
+        uint32_t UpdateCount{0};
+
+        StreamingBufferStats GetBufferStats() const {
+            StreamingBufferStats stats = DynamicVertices.GetStats();
+            stats += StaticVertices.GetStats();
+            stats += Indices.GetStats();
+            return stats;
+        }
+
+        void ResetStats() {
+            DynamicVertices.ResetStats();
+            StaticVertices.ResetStats();
+            Indices.ResetStats();
+            UpdateCount = 0;
+        }
+
+        // The context is only used once the buffers exist, so the first upload can happen without one.
+        void Upload(_In_ ID3D11Device* device,
+                    _In_opt_ ID3D11DeviceContext* context,
+                    const Pbr::PrimitiveBuilder& primitiveBuilder,
+                    DXGI_FORMAT indexFormat) {
+            const uint64_t uploadBytesBefore = GetBufferStats().UploadBytes;
+            const std::vector<Vertex>& vertices = primitiveBuilder.Vertices;
+
+            std::vector<StreamingVertex::Dynamic> dynamicVertices(vertices.size());
+            for (size_t i = 0; i < vertices.size(); i++) {
+                dynamicVertices[i] = {vertices[i].Position, vertices[i].Normal, vertices[i].Tangent};
+            }
+            DynamicVertexOffset = DynamicVertices.Write(
+                device, context, dynamicVertices.data(), (UINT)(dynamicVertices.size() * sizeof(StreamingVertex::Dynamic)), 16);
+
+            // Value initialization zeroes the padding as well, which makes the vertices comparable with memcmp.
+            std::vector<StreamingVertex::Static> staticVertices(vertices.size());
+            for (size_t i = 0; i < vertices.size(); i++) {
+                staticVertices[i].Color0 = vertices[i].Color0;
+                staticVertices[i].TexCoord0 = vertices[i].TexCoord0;
+                staticVertices[i].ModelTransformIndex = vertices[i].ModelTransformIndex;
+            }
+            const UINT staticVertexBytes = (UINT)(staticVertices.size() * sizeof(StreamingVertex::Static));
+            if (!StaticVertices.Get() || staticVertices.size() != StaticVertexData.size() ||
+                memcmp(staticVertices.data(), StaticVertexData.data(), staticVertexBytes) != 0) {
+                StaticVertexOffset = StaticVertices.Write(device, context, staticVertices.data(), staticVertexBytes, 16);
+                StaticVertexData = std::move(staticVertices);
+            }
+
+            std::vector<uint16_t> indices16;
+            const uint8_t* indexData = static_cast<const uint8_t*>(GetIndexData(primitiveBuilder, indexFormat, indices16));
+            const UINT indexBytes = GetIndexByteSize(indexFormat, primitiveBuilder.Indices.size());
+            if (!Indices.Get() || indexBytes != IndexData.size() || memcmp(indexData, IndexData.data(), indexBytes) != 0) {
+                IndexByteOffset = Indices.Write(device, context, indexData, indexBytes, GetIndexByteSize(indexFormat, 1));
+                IndexData.assign(indexData, indexData + indexBytes);
+            }
+
+            LastUpdateUploadBytes = GetBufferStats().UploadBytes - uploadBytesBefore;
+            UpdateCount++;
+        }
+    };
+
     Primitive::Primitive(UINT indexCount,
                          winrt::com_ptr<ID3D11Buffer> indexBuffer,
                          winrt::com_ptr<ID3D11Buffer> vertexBuffer,
-                         std::shared_ptr<Material> material)
+                         std::shared_ptr<Material> material,
+                         DXGI_FORMAT indexFormat)
         : m_indexCount(indexCount)
+        , m_indexFormat(indexFormat)
+        , m_vertexFormat(VertexFormat::Full)
+        , m_vertexCount(vertexBuffer ? GetBufferByteSize(vertexBuffer.get()) / sizeof(Vertex) : 0)
         , m_indexBuffer(std::move(indexBuffer))
         , m_vertexBuffer(std::move(vertexBuffer))
         , m_material(std::move(material)) {
@@ -73,30 +265,139 @@ namespace Pbr {
                          const Pbr::PrimitiveBuilder& primitiveBuilder,
                          std::shared_ptr<Pbr::Material> material,
                          bool updatableBuffers)
-        : Primitive((UINT)primitiveBuilder.Indices.size(),
-                    CreateIndexBuffer(pbrResources.GetDevice().get(), primitiveBuilder, updatableBuffers),
-                    CreateVertexBuffer(pbrResources.GetDevice().get(), primitiveBuilder, updatableBuffers),
-                    std::move(material)) {
+        : m_indexCount((UINT)primitiveBuilder.Indices.size())
+        , m_indexFormat(SelectIndexFormat(primitiveBuilder))
+        , m_vertexFormat(updatableBuffers                         ? VertexFormat::Streaming
+                         : !primitiveBuilder.SkinVertices.empty() ? VertexFormat::Skinned
+                                                                  : pbrResources.GetVertexFormat())
+        , m_vertexCount((UINT)primitiveBuilder.Vertices.size())
+        , m_material(std::move(material)) {
+        SetBounds(primitiveBuilder);
+
+        const winrt::com_ptr<ID3D11Device> device = pbrResources.GetDevice();
+        if (updatableBuffers) {
+            if (!primitiveBuilder.SkinVertices.empty()) {
+                throw std::exception("Skinned primitives are animated through their joints and can't have updatable buffers");
+            }
+            m_streaming = std::make_shared<StreamingGeometry>();
+            m_streaming->Upload(device.get(), nullptr, primitiveBuilder, m_indexFormat);
+            m_vertexBuffer.copy_from(m_streaming->DynamicVertices.Get());
+            m_indexBuffer.copy_from(m_streaming->Indices.Get());
+            return;
+        }
+
+        VertexQuantization::PositionBounds positionBounds;
+        if (m_vertexFormat == VertexFormat::CompactQuantized) {
+            positionBounds = ComputePositionBounds(primitiveBuilder);
+            m_positionBoundsBuffer = CreatePositionBoundsBuffer(device.get(), positionBounds);
+        }
+
+        // Skin vertices are bound as a second stream, which the base vertex of a heap range would offset as well, so skinned
+        // primitives keep buffers of their own.
+        if (m_vertexFormat == VertexFormat::Skinned) {
+            m_skinVertexBuffer = CreateSkinVertexBuffer(device.get(), primitiveBuilder);
+        }
+
+        // Geometry that never changes is suballocated from the shared geometry heaps.
+        if (pbrResources.GetGeometryHeapsEnabled() && m_vertexFormat != VertexFormat::Skinned && m_vertexCount > 0 &&
+            m_indexCount > 0) {
+            std::vector<uint8_t> encodedVertices;
+            std::vector<uint16_t> indices16;
+            m_vertexRange = pbrResources.AllocateVertices(
+                m_vertexFormat, GetVertexData(primitiveBuilder, m_vertexFormat, positionBounds, encodedVertices), m_vertexCount);
+            m_indexRange =
+                pbrResources.AllocateIndices(m_indexFormat, GetIndexData(primitiveBuilder, m_indexFormat, indices16), m_indexCount);
+        }
+
+        if (m_vertexRange && m_indexRange) {
+            m_vertexBuffer = m_vertexRange->Buffer;
+            m_indexBuffer = m_indexRange->Buffer;
+        } else {
+            m_vertexRange = nullptr;
+            m_indexRange = nullptr;
+            m_indexBuffer = CreateIndexBuffer(device.get(), primitiveBuilder, m_indexFormat);
+            m_vertexBuffer = CreateVertexBuffer(device.get(), primitiveBuilder, m_vertexFormat, positionBounds);
+        }
+    }
+
+    void Primitive::SetBounds(const Pbr::PrimitiveBuilder& primitiveBuilder) {
+        const VertexQuantization::PositionBounds bounds = ComputePositionBounds(primitiveBuilder);
+        m_boundsCenter = {bounds.Center[0], bounds.Center[1], bounds.Center[2]};
+        m_boundsNodeIndex = primitiveBuilder.Vertices.empty() ? RootNodeIndex : primitiveBuilder.Vertices[0].ModelTransformIndex;
     }
 
     Primitive Primitive::Clone(Pbr::Resources const& pbrResources) const {
-        return Primitive(m_indexCount, m_indexBuffer, m_vertexBuffer, m_material->Clone(pbrResources));
+        Primitive clone = *this;
+        clone.m_material = m_material->Clone(pbrResources);
+        return clone;
     }
 
     void Primitive::UpdateBuffers(_In_ ID3D11Device* device,
                                   _In_ ID3D11DeviceContext* context,
                                   const Pbr::PrimitiveBuilder& primitiveBuilder) {
+        SetBounds(primitiveBuilder);
+
+        // Streaming geometry is written behind the data of the previous frames, without waiting for the GPU.
+        if (m_streaming) {
+            m_indexCount = (UINT)primitiveBuilder.Indices.size();
+            m_indexFormat = SelectIndexFormat(primitiveBuilder);
+            m_vertexCount = (UINT)primitiveBuilder.Vertices.size();
+            m_streaming->Upload(device, context, primitiveBuilder, m_indexFormat);
+            m_vertexBuffer.copy_from(m_streaming->DynamicVertices.Get());
+            m_indexBuffer.copy_from(m_streaming->Indices.Get());
+            return;
+        }
+
+        // Geometry that changes moves out of the shared geometry heaps into buffers of its own.
+        if (m_vertexRange) {
+            m_vertexRange = nullptr;
+            m_indexRange = nullptr;
+            m_indexCount = (UINT)primitiveBuilder.Indices.size();
+            m_indexFormat = SelectIndexFormat(primitiveBuilder);
+            m_vertexCount = (UINT)primitiveBuilder.Vertices.size();
+
+            VertexQuantization::PositionBounds positionBounds;
+            if (m_vertexFormat == VertexFormat::CompactQuantized) {
+                positionBounds = ComputePositionBounds(primitiveBuilder);
+                m_positionBoundsBuffer = CreatePositionBoundsBuffer(device, positionBounds);
+            }
+            m_indexBuffer = CreateIndexBuffer(device, primitiveBuilder, m_indexFormat);
+            m_vertexBuffer = CreateVertexBuffer(device, primitiveBuilder, m_vertexFormat, positionBounds);
+            return;
+        }
+
         // Update vertex buffer.
         {
             D3D11_BUFFER_DESC vertDesc;
             m_vertexBuffer->GetDesc(&vertDesc);
 
-            UINT requiredSize = GetPbrVertexByteSize(primitiveBuilder.Vertices.size());
+            VertexQuantization::PositionBounds positionBounds;
+            if (m_vertexFormat == VertexFormat::CompactQuantized) {
+                positionBounds = ComputePositionBounds(primitiveBuilder);
+                m_positionBoundsBuffer = CreatePositionBoundsBuffer(device, positionBounds);
+            }
+
+            UINT requiredSize = (UINT)(GetFirstStreamStride(m_vertexFormat) * primitiveBuilder.Vertices.size());
             if (vertDesc.ByteWidth >= requiredSize) {
-                context->UpdateSubresource(m_vertexBuffer.get(), 0, nullptr, primitiveBuilder.Vertices.data(), requiredSize, requiredSize);
+                std::vector<uint8_t> encodedVertices;
+                const void* vertexData = GetVertexData(primitiveBuilder, m_vertexFormat, positionBounds, encodedVertices);
+                context->UpdateSubresource(m_vertexBuffer.get(), 0, nullptr, vertexData, requiredSize, requiredSize);
             } else {
-                m_vertexBuffer = CreateVertexBuffer(device, primitiveBuilder, true);
+                m_vertexBuffer = CreateVertexBuffer(device, primitiveBuilder, m_vertexFormat, positionBounds);
             }
+
+            if (m_skinVertexBuffer) {
+                const UINT requiredSkinSize = (UINT)(sizeof(SkinVertex) * primitiveBuilder.SkinVertices.size());
+                if (primitiveBuilder.SkinVertices.size() == primitiveBuilder.Vertices.size() &&
+                    GetBufferByteSize(m_skinVertexBuffer.get()) >= requiredSkinSize) {
+                    context->UpdateSubresource(
+                        m_skinVertexBuffer.get(), 0, nullptr, primitiveBuilder.SkinVertices.data(), requiredSkinSize, requiredSkinSize);
+                } else {
+                    m_skinVertexBuffer = CreateSkinVertexBuffer(device, primitiveBuilder);
+                }
+            }
+
+            m_vertexCount = (UINT)primitiveBuilder.Vertices.size();
         }
 
         // Update index buffer.
@@ -104,24 +405,95 @@ namespace Pbr {
             D3D11_BUFFER_DESC idxDesc;
             m_indexBuffer->GetDesc(&idxDesc);
 
-            UINT requiredSize = (UINT)(primitiveBuilder.Indices.size() * sizeof(decltype(primitiveBuilder.Indices)::value_type));
-            if (idxDesc.ByteWidth >= requiredSize) {
-                context->UpdateSubresource(m_indexBuffer.get(), 0, nullptr, primitiveBuilder.Indices.data(), requiredSize, requiredSize);
+            // The index width is kept while the vertices fit, and widened once they don't.
+            const DXGI_FORMAT indexFormat = m_indexFormat == DXGI_FORMAT_R32_UINT ? m_indexFormat : SelectIndexFormat(primitiveBuilder);
+            UINT requiredSize = GetIndexByteSize(indexFormat, primitiveBuilder.Indices.size());
+            if (indexFormat == m_indexFormat && idxDesc.ByteWidth >= requiredSize) {
+                std::vector<uint16_t> indices16;
+                const void* indexData = GetIndexData(primitiveBuilder, indexFormat, indices16);
+                context->UpdateSubresource(m_indexBuffer.get(), 0, nullptr, indexData, requiredSize, requiredSize);
             } else {
-                m_indexBuffer = CreateIndexBuffer(device, primitiveBuilder, true);
+                m_indexBuffer = CreateIndexBuffer(device, primitiveBuilder, indexFormat);
+                m_indexFormat = indexFormat;
             }
 
             m_indexCount = (UINT)primitiveBuilder.Indices.size();
         }
     }
 
-    void Primitive::Render(_In_ ID3D11DeviceContext* context) const {
-        const UINT stride = sizeof(Pbr::Vertex);
-        const UINT offset = 0;
-        ID3D11Buffer* const vertexBuffers[] = {m_vertexBuffer.get()};
-        context->IASetVertexBuffers(0, 1, vertexBuffers, &stride, &offset);
-        context->IASetIndexBuffer(m_indexBuffer.get(), DXGI_FORMAT_R32_UINT, 0);
-        context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        context->DrawIndexedInstanced(m_indexCount, 1, 0, 0, 0);
+    StreamingGeometryStats Primitive::GetStreamingStats() const {
+        StreamingGeometryStats stats;
+        if (m_streaming) {
+            stats.LastUpdateUploadBytes = m_streaming->LastUpdateUploadBytes;
+            stats.UpdateCount = m_streaming->UpdateCount;
+            stats.Buffers = m_streaming->GetBufferStats();
+        }
+        return stats;
+    }
+
+    void Primitive::ResetStreamingStats() {
+        if (m_streaming) {
+            m_streaming->ResetStats();
+        }
+    }
+
+    UINT Primitive::GetVertexBufferByteSize() const {
+        if (m_streaming) {
+            return m_streaming->DynamicVertices.GetCapacity() + m_streaming->StaticVertices.GetCapacity();
+        }
+        if (m_skinVertexBuffer) {
+            return GetBufferByteSize(m_vertexBuffer.get()) + GetBufferByteSize(m_skinVertexBuffer.get());
+        }
+        return m_vertexRange ? m_vertexRange->Count * m_vertexRange->ElementSize : GetBufferByteSize(m_vertexBuffer.get());
+    }
+
+    UINT Primitive::GetIndexBufferByteSize() const {
+        if (m_streaming) {
+            return m_streaming->Indices.GetCapacity();
+        }
+        return m_indexRange ? m_indexRange->Count * m_indexRange->ElementSize : GetBufferByteSize(m_indexBuffer.get());
+    }
+
+    void Primitive::Render(_In_ ID3D11DeviceContext* context, Pbr::Resources const& pbrResources) const {
+        ID3D11Buffer* vertexBuffers[Resources::MaxVertexStreams] = {m_vertexBuffer.get(), m_skinVertexBuffer.get()};
+        UINT strides[Resources::MaxVertexStreams] = {Pbr::GetVertexStride(m_vertexFormat), 0};
+        UINT offsets[Resources::MaxVertexStreams] = {0, 0};
+        UINT streamCount = 1;
+        if (m_streaming) {
+            vertexBuffers[0] = m_streaming->DynamicVertices.Get();
+            vertexBuffers[1] = m_streaming->StaticVertices.Get();
+            strides[0] = sizeof(StreamingVertex::Dynamic);
+            strides[1] = sizeof(StreamingVertex::Static);
+            offsets[0] = m_streaming->DynamicVertexOffset;
+            offsets[1] = m_streaming->StaticVertexOffset;
+            streamCount = 2;
+        } else if (m_skinVertexBuffer) {
+            strides[0] = sizeof(Vertex);
+            strides[1] = sizeof(SkinVertex);
+            streamCount = 2;
+        }
+
+        // The imports only import again when a buffer changed, e.g. a streaming buffer grew, or the render device was recreated.
+        for (UINT stream = 0; stream < streamCount; stream++) {
+            pbrResources.Import(m_vertexBufferImports[stream], vertexBuffers[stream], BufferUsage::Vertex);
+        }
+        pbrResources.Import(m_indexBufferImport, m_indexBuffer.get(), BufferUsage::Index);
+        pbrResources.BindGeometry(context, streamCount, m_vertexBufferImports.data(), strides, offsets, m_indexBufferImport, m_indexFormat);
+        Draw(context, pbrResources);
+    }
+
+    void Primitive::Draw(_In_ ID3D11DeviceContext* context, Pbr::Resources const& pbrResources) const {
+        RenderDevice& renderDevice = pbrResources.GetRenderDevice(context);
+        if (m_positionBoundsBuffer) {
+            const BufferHandle vsBuffers[] = {
+                pbrResources.Import(m_positionBoundsImport, m_positionBoundsBuffer.get(), BufferUsage::Constant)};
+            renderDevice.SetConstantBuffers(ShaderStage::Vertex, Pbr::ShaderSlots::ConstantBuffers::Primitive, 1, vsBuffers);
+        }
+
+        const UINT startIndex = m_indexRange  ? m_indexRange->Offset
+                                : m_streaming ? m_streaming->IndexByteOffset / GetIndexByteSize(m_indexFormat, 1)
+                                              : 0;
+        const INT baseVertex = m_vertexRange ? (INT)m_vertexRange->Offset : 0;
+        renderDevice.DrawIndexedInstanced(m_indexCount, 1, startIndex, baseVertex, pbrResources.GetBoundMaterialIndex());
     }
 } // namespace Pbr
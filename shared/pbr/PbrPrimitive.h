@@ -3,13 +3,23 @@
 // Licensed under the MIT License. See License.txt in the project root for license information.
 #pragma once
 
+#include <array>
 #include <vector>
 #include <winrt/base.h>
 #include <d3d11.h>
 #include <d3d11_2.h>
+#include "PbrGeometryHeap.h"
 #include "PbrMaterial.h"
+#include "PbrStreamingBuffer.h"
 
 namespace Pbr {
+    // Uploads of a primitive with updatable buffers. The counts are since the creation or the last ResetStreamingStats.
+    struct StreamingGeometryStats {
+        uint64_t LastUpdateUploadBytes{0}; // Bytes uploaded by the creation or the most recent UpdateBuffers.
+        uint32_t UpdateCount{0};
+        StreamingBufferStats Buffers; // Sum over the vertex streams and the index buffer.
+    };
+
     // A primitive holds a vertex buffer, index buffer, and a pointer to a PBR material.
     struct Primitive final {
         using Collection = std::vector<Primitive>;
@@ -18,7 +28,14 @@ namespace Pbr {
         Primitive(UINT indexCount,
                   winrt::com_ptr<ID3D11Buffer> indexBuffer,
                   winrt::com_ptr<ID3D11Buffer> vertexBuffer,
-                  std::shared_ptr<Material> material);
+                  std::shared_ptr<Material> material,
+                  DXGI_FORMAT indexFormat = DXGI_FORMAT_R32_UINT);
+
+        // Indices are uploaded as 16-bit when the builder has at most 65536 vertices, and as 32-bit otherwise.
+        // Vertices are uploaded in the vertex format of the resources. Primitives without updatable buffers share the geometry
+        // heaps of the resources when they are enabled. Updatable primitives use VertexFormat::Streaming instead: ring buffers
+        // that UpdateBuffers writes without stalling, where only the positions, normals and tangents are uploaded every time.
+        // Builders with skin vertices create primitives of VertexFormat::Skinned, which can't have updatable buffers.
         Primitive(Pbr::Resources const& pbrResources,
                   const Pbr::PrimitiveBuilder& primitiveBuilder,
                   std::shared_ptr<Material> material,
@@ -26,6 +43,11 @@ namespace Pbr {
 
         void UpdateBuffers(_In_ ID3D11Device* device, _In_ ID3D11DeviceContext* context, const Pbr::PrimitiveBuilder& primitiveBuilder);
 
+        // Upload bytes and reallocations of an updatable primitive's buffers. Empty for other primitives. Reset the stats at
+        // the end of each frame to get the uploads per frame.
+        StreamingGeometryStats GetStreamingStats() const;
+        void ResetStreamingStats();
+
         // Get the material for the primitive.
         std::shared_ptr<Material>& GetMaterial() {
             return m_material;
@@ -34,15 +56,61 @@ namespace Pbr {
             return m_material;
         }
 
+        DXGI_FORMAT GetIndexFormat() const {
+            return m_indexFormat;
+        }
+
+        VertexFormat GetVertexFormat() const {
+            return m_vertexFormat;
+        }
+
+        UINT GetVertexCount() const {
+            return m_vertexCount;
+        }
+
+        // Center of the bounds of the vertex positions, in the space of the node that the first vertex references. Used to
+        // order draws by depth. Primitives created from raw buffers have their center at the origin of the root node.
+        const DirectX::XMFLOAT3& GetBoundsCenter() const {
+            return m_boundsCenter;
+        }
+        NodeIndex_t GetBoundsNodeIndex() const {
+            return m_boundsNodeIndex;
+        }
+
+        // Size of the GPU buffers in bytes.
+        UINT GetVertexBufferByteSize() const;
+        UINT GetIndexBufferByteSize() const;
+
     protected:
         friend struct Model;
-        void Render(_In_ ID3D11DeviceContext* context) const;
+        // Render through the buffer bindings tracked by the resources, which skips rebinding shared geometry heap buffers.
+        void Render(_In_ ID3D11DeviceContext* context, Pbr::Resources const& pbrResources) const;
         Primitive Clone(Pbr::Resources const& pbrResources) const;
 
     private:
+        // Draw with the start instance location selecting the material index bound by the resources.
+        void Draw(_In_ ID3D11DeviceContext* context, Pbr::Resources const& pbrResources) const;
+        void SetBounds(const Pbr::PrimitiveBuilder& primitiveBuilder);
+
         UINT m_indexCount;
+        DXGI_FORMAT m_indexFormat;
+        VertexFormat m_vertexFormat;
+        UINT m_vertexCount;
+        DirectX::XMFLOAT3 m_boundsCenter{0, 0, 0};
+        NodeIndex_t m_boundsNodeIndex{RootNodeIndex};
         winrt::com_ptr<ID3D11Buffer> m_indexBuffer;
         winrt::com_ptr<ID3D11Buffer> m_vertexBuffer;
+        winrt::com_ptr<ID3D11Buffer> m_positionBoundsBuffer; // Only for VertexFormat::CompactQuantized.
+        winrt::com_ptr<ID3D11Buffer> m_skinVertexBuffer;     // Only for VertexFormat::Skinned, the second vertex stream.
+        std::shared_ptr<const GeometryRange> m_vertexRange;  // Set when the buffers are shared geometry heap buffers.
+        std::shared_ptr<const GeometryRange> m_indexRange;
+        struct StreamingGeometry;
+        std::shared_ptr<StreamingGeometry> m_streaming; // Set for primitives with updatable buffers. Shared with clones.
         std::shared_ptr<Material> m_material;
+
+        // The buffers bound by the last render, imported into the render device of the resources.
+        mutable std::array<ImportedBuffer, Resources::MaxVertexStreams> m_vertexBufferImports;
+        mutable ImportedBuffer m_indexBufferImport;
+        mutable ImportedBuffer m_positionBoundsImport;
     };
 } // namespace Pbr
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <iterator>
+#include <stdexcept>
+#include "PbrRangeAllocator.h"
+
+namespace Pbr {
+    RangeAllocator::RangeAllocator(uint32_t size)
+        : m_size(size) {
+        if (size > 0) {
+            InsertFreeRange(0, size);
+        }
+    }
+
+    std::optional<uint32_t> RangeAllocator::Allocate(uint32_t count) {
+        if (count == 0) {
+            throw std::out_of_range("Cannot allocate an empty range");
+        }
+
+        // The smallest free range that fits keeps large ranges available for large allocations.
+        const auto bestFit = m_freeRangesBySize.lower_bound(count);
+        if (bestFit == m_freeRangesBySize.end()) {
+            return {};
+        }
+
+        const uint32_t offset = bestFit->second;
+        const uint32_t freeCount = bestFit->first;
+        EraseFreeRange(m_freeRangesByOffset.find(offset));
+        if (freeCount > count) {
+            InsertFreeRange(offset + count, freeCount - count);
+        }
+
+        m_usedSize += count;
+        return offset;
+    }
+
+    void RangeAllocator::Free(uint32_t offset, uint32_t count) {
+        if (count == 0 || offset > m_size || count > m_size - offset || count > m_usedSize) {
+            throw std::out_of_range("Range is not allocated");
+        }
+
+        // The range must not overlap the free ranges around it.
+        const FreeRangeIterator next = m_freeRangesByOffset.lower_bound(offset);
+        if (next != m_freeRangesByOffset.end() && next->first < offset + count) {
+            throw std::out_of_range("Range is not allocated");
+        }
+        const FreeRangeIterator previous = next == m_freeRangesByOffset.begin() ? m_freeRangesByOffset.end() : std::prev(next);
+        if (previous != m_freeRangesByOffset.end() && previous->first + previous->second > offset) {
+            throw std::out_of_range("Range is not allocated");
+        }
+
+        m_usedSize -= count;
+
+        // Merge with the adjacent free ranges.
+        uint32_t begin = offset;
+        uint32_t end = offset + count;
+        if (next != m_freeRangesByOffset.end() && next->first == end) {
+            end += next->second;
+            EraseFreeRange(next);
+        }
+        if (previous != m_freeRangesByOffset.end() && previous->first + previous->second == begin) {
+            begin = previous->first;
+            EraseFreeRange(previous);
+        }
+        InsertFreeRange(begin, end - begin);
+    }
+
+    RangeAllocatorStats RangeAllocator::GetStats() const {
+        RangeAllocatorStats stats;
+        stats.Size = m_size;
+        stats.UsedSize = m_usedSize;
+        stats.FreeRangeCount = (uint32_t)m_freeRangesByOffset.size();
+        stats.LargestFreeRange = m_freeRangesBySize.empty() ? 0 : m_freeRangesBySize.rbegin()->first;
+        return stats;
+    }
+
+    void RangeAllocator::InsertFreeRange(uint32_t offset, uint32_t count) {
+        m_freeRangesByOffset.emplace(offset, count);
+        m_freeRangesBySize.emplace(count, offset);
+    }
+
+    void RangeAllocator::EraseFreeRange(FreeRangeIterator freeRange) {
+        auto [first, last] = m_freeRangesBySize.equal_range(freeRange->second);
+        for (auto it = first; it != last; ++it) {
+            if (it->second == freeRange->first) {
+                m_freeRangesBySize.erase(it);
+                break;
+            }
+        }
+        m_freeRangesByOffset.erase(freeRange);
+    }
+} // namespace Pbr
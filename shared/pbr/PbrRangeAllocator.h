@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// Suballocation of ranges from a fixed size block, e.g. elements of a large buffer. This code has no graphics API
+// dependency.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+
+namespace Pbr {
+    struct RangeAllocatorStats {
+        uint32_t Size{0};
+        uint32_t UsedSize{0};
+        uint32_t FreeRangeCount{0};
+        uint32_t LargestFreeRange{0};
+
+        // 0 when the free space is one contiguous range, approaching 1 as it is split into many small ranges.
+        float Fragmentation() const {
+            const uint32_t freeSize = Size - UsedSize;
+            return freeSize == 0 ? 0.0f : 1.0f - (float)LargestFreeRange / freeSize;
+        }
+    };
+
+    // Best-fit free list allocator of ranges in [0, size), in units chosen by the caller. Adjacent free ranges are merged
+    // when a range is freed. Not thread safe.
+    struct RangeAllocator final {
+        explicit RangeAllocator(uint32_t size);
+
+        // Returns the offset of a range of count units, or nothing if no free range is large enough.
+        std::optional<uint32_t> Allocate(uint32_t count);
+
+        // Return a range from Allocate. Throws if the range isn't allocated.
+        void Free(uint32_t offset, uint32_t count);
+
+        bool IsEmpty() const {
+            return m_usedSize == 0;
+        }
+
+        RangeAllocatorStats GetStats() const;
+
+    private:
+        using FreeRangeIterator = std::map<uint32_t, uint32_t>::iterator;
+
+        void InsertFreeRange(uint32_t offset, uint32_t count);
+        void EraseFreeRange(FreeRangeIterator freeRange);
+
+        uint32_t m_size;
+        uint32_t m_usedSize{0};
+        std::map<uint32_t, uint32_t> m_freeRangesByOffset;    // Offset to count.
+        std::multimap<uint32_t, uint32_t> m_freeRangesBySize; // Count to offset, for best-fit searches.
+    };
+} // namespace Pbr
@@ -0,0 +1,371 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <stdexcept>
+#include "PbrRecordingRenderDevice.h"
+
+namespace Pbr {
+    const char* ToString(RenderCommandType type) {
+        switch (type) {
+        case RenderCommandType::CreateBuffer:
+            return "CreateBuffer";
+        case RenderCommandType::CreateTexture:
+            return "CreateTexture";
+        case RenderCommandType::CreateShader:
+            return "CreateShader";
+        case RenderCommandType::CreatePipeline:
+            return "CreatePipeline";
+        case RenderCommandType::CreateSampler:
+            return "CreateSampler";
+        case RenderCommandType::Release:
+            return "Release";
+        case RenderCommandType::UpdateBuffer:
+            return "UpdateBuffer";
+        case RenderCommandType::UpdateTexture:
+            return "UpdateTexture";
+        case RenderCommandType::SetViewport:
+            return "SetViewport";
+        case RenderCommandType::SetPipeline:
+            return "SetPipeline";
+        case RenderCommandType::SetVertexBuffers:
+            return "SetVertexBuffers";
+        case RenderCommandType::SetIndexBuffer:
+            return "SetIndexBuffer";
+        case RenderCommandType::SetConstantBuffers:
+            return "SetConstantBuffers";
+        case RenderCommandType::SetShaderBuffers:
+            return "SetShaderBuffers";
+        case RenderCommandType::SetShaderTextures:
+            return "SetShaderTextures";
+        case RenderCommandType::SetSamplers:
+            return "SetSamplers";
+        case RenderCommandType::Draw:
+            return "Draw";
+        case RenderCommandType::DrawIndexed:
+            return "DrawIndexed";
+        case RenderCommandType::DrawIndexedInstanced:
+            return "DrawIndexedInstanced";
+        }
+        return "Unknown";
+    }
+
+    RecordingRenderDevice::RecordingRenderDevice(bool recordCommands)
+        : m_recordCommands(recordCommands) {
+    }
+
+    void RecordingRenderDevice::ResetStats() {
+        m_commands.clear();
+        m_stats = {};
+    }
+
+    uint32_t RecordingRenderDevice::GetLiveResourceCount() const {
+        return m_buffers.Size() + m_textures.Size() + m_shaders.Size() + m_pipelines.Size() + m_samplers.Size();
+    }
+
+    BufferHandle RecordingRenderDevice::CreateBuffer(const BufferDesc& desc, const void* initialData) {
+        if (desc.ByteSize == 0) {
+            throw std::out_of_range("Buffers can't be empty");
+        }
+        if (desc.Usage == BufferUsage::Structured && (desc.StructureByteStride == 0 || desc.ByteSize % desc.StructureByteStride != 0)) {
+            throw std::out_of_range("Structured buffers must hold a whole number of structures");
+        }
+
+        const BufferHandle buffer = m_buffers.Add(desc);
+        m_stats.CreatedResourceCount++;
+        const uint64_t uploadBytes = initialData ? desc.ByteSize : 0;
+        if (initialData) {
+            CountUpload(uploadBytes);
+        }
+        Record({RenderCommandType::CreateBuffer, ShaderStage::Vertex, (uint32_t)buffer, 0, 0, 0, uploadBytes});
+        return buffer;
+    }
+
+    TextureHandle RecordingRenderDevice::CreateTexture(const TextureDesc& desc, const SubresourceData* initialData) {
+        if (desc.Width == 0 || desc.Height == 0 || desc.GetSubresourceCount() == 0 || (desc.Cube && desc.ArraySize % 6 != 0)) {
+            throw std::out_of_range("Invalid texture size");
+        }
+
+        const TextureHandle texture = m_textures.Add(desc);
+        m_stats.CreatedResourceCount++;
+        uint64_t uploadBytes = 0;
+        if (initialData) {
+            for (uint32_t subresource = 0; subresource < desc.GetSubresourceCount(); subresource++) {
+                uploadBytes += initialData[subresource].ByteSize;
+            }
+            CountUpload(uploadBytes);
+        }
+        Record({RenderCommandType::CreateTexture, ShaderStage::Vertex, (uint32_t)texture, 0, desc.GetSubresourceCount(), 0, uploadBytes});
+        return texture;
+    }
+
+    ShaderHandle RecordingRenderDevice::CreateShader(ShaderStage stage, const void* bytecode, size_t byteSize) {
+        if (!bytecode || byteSize == 0) {
+            throw std::out_of_range("Shaders need bytecode");
+        }
+
+        const ShaderHandle shader = m_shaders.Add(stage);
+        m_stats.CreatedResourceCount++;
+        Record({RenderCommandType::CreateShader, stage, (uint32_t)shader, 0, 0, 0, byteSize});
+        return shader;
+    }
+
+    PipelineHandle RecordingRenderDevice::CreatePipeline(const PipelineDesc& desc) {
+        if (m_shaders.Get(desc.VertexShader) != ShaderStage::Vertex ||
+            (desc.PixelShader != ShaderHandle::None && m_shaders.Get(desc.PixelShader) != ShaderStage::Pixel)) {
+            throw std::logic_error("Pipeline shaders must be of their stage");
+        }
+        for (const VertexElement& element : desc.InputLayout) {
+            CheckSlots(element.InputSlot, 1, VertexBufferSlotCount);
+        }
+
+        const PipelineHandle pipeline = m_pipelines.Add(desc);
+        m_stats.CreatedResourceCount++;
+        Record({RenderCommandType::CreatePipeline, ShaderStage::Vertex, (uint32_t)pipeline});
+        return pipeline;
+    }
+
+    SamplerHandle RecordingRenderDevice::CreateSampler(const SamplerDesc& desc) {
+        const SamplerHandle sampler = m_samplers.Add(desc);
+        m_stats.CreatedResourceCount++;
+        Record({RenderCommandType::CreateSampler, ShaderStage::Pixel, (uint32_t)sampler});
+        return sampler;
+    }
+
+    void RecordingRenderDevice::Release(BufferHandle buffer) {
+        m_buffers.Remove(buffer);
+        m_stats.ReleasedResourceCount++;
+        Record({RenderCommandType::Release, ShaderStage::Vertex, (uint32_t)buffer});
+    }
+
+    void RecordingRenderDevice::Release(TextureHandle texture) {
+        m_textures.Remove(texture);
+        m_stats.ReleasedResourceCount++;
+        Record({RenderCommandType::Release, ShaderStage::Vertex, (uint32_t)texture});
+    }
+
+    void RecordingRenderDevice::Release(ShaderHandle shader) {
+        m_shaders.Remove(shader);
+        m_stats.ReleasedResourceCount++;
+        Record({RenderCommandType::Release, ShaderStage::Vertex, (uint32_t)shader});
+    }
+
+    void RecordingRenderDevice::Release(PipelineHandle pipeline) {
+        m_pipelines.Remove(pipeline);
+        m_stats.ReleasedResourceCount++;
+        Record({RenderCommandType::Release, ShaderStage::Vertex, (uint32_t)pipeline});
+    }
+
+    void RecordingRenderDevice::Release(SamplerHandle sampler) {
+        m_samplers.Remove(sampler);
+        m_stats.ReleasedResourceCount++;
+        Record({RenderCommandType::Release, ShaderStage::Vertex, (uint32_t)sampler});
+    }
+
+    void RecordingRenderDevice::UpdateBuffer(BufferHandle buffer, uint32_t byteOffset, const void* data, uint32_t byteSize) {
+        const BufferDesc& desc = m_buffers.Get(buffer);
+        const bool whole = desc.Usage == BufferUsage::Constant || desc.Dynamic;
+        if (!data || (uint64_t)byteOffset + byteSize > desc.ByteSize || (whole && (byteOffset != 0 || byteSize != desc.ByteSize))) {
+            throw std::out_of_range("Buffer update out of bounds");
+        }
+
+        CountUpload(byteSize);
+        Record({RenderCommandType::UpdateBuffer, ShaderStage::Vertex, (uint32_t)buffer, byteOffset, 0, 0, byteSize});
+    }
+
+    void RecordingRenderDevice::UpdateTexture(TextureHandle texture,
+                                              uint32_t subresource,
+                                              const TextureRegion& region,
+                                              const SubresourceData& data) {
+        const TextureDesc& desc = m_textures.Get(texture);
+        const uint32_t mipLevel = subresource % desc.MipLevels;
+        const uint32_t levelWidth = std::max(desc.Width >> mipLevel, 1u);
+        const uint32_t levelHeight = std::max(desc.Height >> mipLevel, 1u);
+        if (!data.Data || subresource >= desc.GetSubresourceCount() || (uint64_t)region.X + region.Width > levelWidth ||
+            (uint64_t)region.Y + region.Height > levelHeight) {
+            throw std::out_of_range("Texture update out of bounds");
+        }
+
+        CountUpload(data.ByteSize);
+        Record({RenderCommandType::UpdateTexture, ShaderStage::Pixel, (uint32_t)texture, subresource, 0, 0, data.ByteSize});
+    }
+
+    void RecordingRenderDevice::SetViewport(const Viewport& viewport) {
+        if (viewport.Width < 0 || viewport.Height < 0 || viewport.MinDepth > viewport.MaxDepth) {
+            throw std::out_of_range("Invalid viewport");
+        }
+
+        CountStateChange(!(viewport == m_viewport));
+        m_viewport = viewport;
+        Record({RenderCommandType::SetViewport, ShaderStage::Vertex, 0, 0, 1});
+    }
+
+    void RecordingRenderDevice::SetPipeline(PipelineHandle pipeline) {
+        if (pipeline != PipelineHandle::None) {
+            m_pipelines.Get(pipeline);
+        }
+
+        CountStateChange(pipeline != m_pipeline);
+        m_pipeline = pipeline;
+        Record({RenderCommandType::SetPipeline, ShaderStage::Vertex, (uint32_t)pipeline, 0, 1});
+    }
+
+    void RecordingRenderDevice::SetVertexBuffers(
+        uint32_t startSlot, uint32_t count, const BufferHandle* buffers, const uint32_t* strides, const uint32_t* offsets) {
+        CheckSlots(startSlot, count, VertexBufferSlotCount);
+
+        bool changed = false;
+        for (uint32_t i = 0; i < count; i++) {
+            if (buffers[i] != BufferHandle::None && m_buffers.Get(buffers[i]).Usage != BufferUsage::Vertex) {
+                throw std::logic_error("Only vertex buffers can be bound as vertex buffers");
+            }
+            const VertexBufferBinding binding{buffers[i], strides[i], offsets[i]};
+            changed |= !(m_vertexBuffers[startSlot + i] == binding);
+            m_vertexBuffers[startSlot + i] = binding;
+        }
+
+        CountStateChange(changed);
+        Record({RenderCommandType::SetVertexBuffers, ShaderStage::Vertex, count > 0 ? (uint32_t)buffers[0] : 0, startSlot, count});
+    }
+
+    void RecordingRenderDevice::SetIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset) {
+        if (buffer != BufferHandle::None && m_buffers.Get(buffer).Usage != BufferUsage::Index) {
+            throw std::logic_error("Only index buffers can be bound as index buffers");
+        }
+
+        CountStateChange(buffer != m_indexBuffer || format != m_indexFormat || offset != m_indexOffset);
+        m_indexBuffer = buffer;
+        m_indexFormat = format;
+        m_indexOffset = offset;
+        Record({RenderCommandType::SetIndexBuffer, ShaderStage::Vertex, (uint32_t)buffer, 0, 1});
+    }
+
+    void RecordingRenderDevice::SetConstantBuffers(ShaderStage stage, uint32_t startSlot, uint32_t count, const BufferHandle* buffers) {
+        CheckSlots(startSlot, count, ConstantBufferSlotCount);
+
+        bool changed = false;
+        for (uint32_t i = 0; i < count; i++) {
+            if (buffers[i] != BufferHandle::None && m_buffers.Get(buffers[i]).Usage != BufferUsage::Constant) {
+                throw std::logic_error("Only constant buffers can be bound as constant buffers");
+            }
+            BufferHandle& bound = m_constantBuffers[(uint32_t)stage][startSlot + i];
+            changed |= bound != buffers[i];
+            bound = buffers[i];
+        }
+
+        CountStateChange(changed);
+        Record({RenderCommandType::SetConstantBuffers, stage, count > 0 ? (uint32_t)buffers[0] : 0, startSlot, count});
+    }
+
+    void RecordingRenderDevice::SetShaderBuffers(ShaderStage stage, uint32_t startSlot, uint32_t count, const BufferHandle* buffers) {
+        for (uint32_t i = 0; i < count; i++) {
+            if (buffers[i] != BufferHandle::None && m_buffers.Get(buffers[i]).Usage != BufferUsage::Structured) {
+                throw std::logic_error("Only structured buffers can be bound as shader buffers");
+            }
+        }
+        BindShaderResources(RenderCommandType::SetShaderBuffers, stage, startSlot, count, buffers, ShaderBufferBit);
+    }
+
+    void RecordingRenderDevice::SetShaderTextures(ShaderStage stage, uint32_t startSlot, uint32_t count, const TextureHandle* textures) {
+        for (uint32_t i = 0; i < count; i++) {
+            if (textures[i] != TextureHandle::None) {
+                m_textures.Get(textures[i]);
+            }
+        }
+        BindShaderResources(RenderCommandType::SetShaderTextures, stage, startSlot, count, textures, 0);
+    }
+
+    void RecordingRenderDevice::SetSamplers(ShaderStage stage, uint32_t startSlot, uint32_t count, const SamplerHandle* samplers) {
+        CheckSlots(startSlot, count, SamplerSlotCount);
+
+        bool changed = false;
+        for (uint32_t i = 0; i < count; i++) {
+            if (samplers[i] != SamplerHandle::None) {
+                m_samplers.Get(samplers[i]);
+            }
+            SamplerHandle& bound = m_samplerBindings[(uint32_t)stage][startSlot + i];
+            changed |= bound != samplers[i];
+            bound = samplers[i];
+        }
+
+        CountStateChange(changed);
+        Record({RenderCommandType::SetSamplers, stage, count > 0 ? (uint32_t)samplers[0] : 0, startSlot, count});
+    }
+
+    void RecordingRenderDevice::Draw(uint32_t vertexCount, uint32_t startVertex) {
+        CheckDraw(false);
+        m_stats.DrawCount++;
+        m_stats.VertexCount += vertexCount;
+        Record({RenderCommandType::Draw, ShaderStage::Vertex, 0, startVertex, vertexCount, 1});
+    }
+
+    void RecordingRenderDevice::DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex [[maybe_unused]]) {
+        CheckDraw(true);
+        m_stats.DrawCount++;
+        m_stats.VertexCount += indexCount;
+        Record({RenderCommandType::DrawIndexed, ShaderStage::Vertex, 0, startIndex, indexCount, 1});
+    }
+
+    void RecordingRenderDevice::DrawIndexedInstanced(uint32_t indexCount,
+                                                     uint32_t instanceCount,
+                                                     uint32_t startIndex,
+                                                     int32_t baseVertex [[maybe_unused]],
+                                                     uint32_t startInstance [[maybe_unused]]) {
+        CheckDraw(true);
+        m_stats.DrawCount++;
+        m_stats.VertexCount += (uint64_t)indexCount * instanceCount;
+        Record({RenderCommandType::DrawIndexedInstanced, ShaderStage::Vertex, 0, startIndex, indexCount, instanceCount});
+    }
+
+    void RecordingRenderDevice::Record(const RenderCommand& command) {
+        if (m_recordCommands) {
+            m_commands.push_back(command);
+        }
+    }
+
+    void RecordingRenderDevice::CountStateChange(bool changed) {
+        if (changed) {
+            m_stats.StateChangeCount++;
+        } else {
+            m_stats.RedundantStateChangeCount++;
+        }
+    }
+
+    void RecordingRenderDevice::CountUpload(uint64_t byteSize) {
+        m_stats.UploadCount++;
+        m_stats.UploadBytes += byteSize;
+    }
+
+    void RecordingRenderDevice::CheckSlots(uint32_t startSlot, uint32_t count, uint32_t slotCount) const {
+        if ((uint64_t)startSlot + count > slotCount) {
+            throw std::out_of_range("Binding slot out of range");
+        }
+    }
+
+    void RecordingRenderDevice::CheckDraw(bool indexed) const {
+        if (m_pipeline == PipelineHandle::None) {
+            throw std::logic_error("Draw without a pipeline");
+        }
+        if (indexed && m_indexBuffer == BufferHandle::None) {
+            throw std::logic_error("Indexed draw without an index buffer");
+        }
+    }
+
+    template <typename THandle>
+    void RecordingRenderDevice::BindShaderResources(
+        RenderCommandType type, ShaderStage stage, uint32_t startSlot, uint32_t count, const THandle* handles, uint32_t tag) {
+        CheckSlots(startSlot, count, ShaderResourceSlotCount);
+
+        bool changed = false;
+        for (uint32_t i = 0; i < count; i++) {
+            const uint32_t resource = handles[i] == THandle::None ? 0 : ((uint32_t)handles[i] | tag);
+            uint32_t& bound = m_shaderResources[(uint32_t)stage][startSlot + i];
+            changed |= bound != resource;
+            bound = resource;
+        }
+
+        CountStateChange(changed);
+        Record({type, stage, count > 0 ? (uint32_t)handles[0] : 0, startSlot, count});
+    }
+} // namespace Pbr
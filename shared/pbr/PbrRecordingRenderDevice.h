@@ -0,0 +1,162 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// A null render device that records the commands it receives and counts draws, state changes, uploads and resources, so
+// that the submission cost and draw counts of rendering code can be measured without a GPU. This code has no graphics API
+// dependency.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "PbrRenderDevice.h"
+
+namespace Pbr {
+    enum class RenderCommandType : uint32_t {
+        CreateBuffer,
+        CreateTexture,
+        CreateShader,
+        CreatePipeline,
+        CreateSampler,
+        Release,
+        UpdateBuffer,
+        UpdateTexture,
+        SetViewport,
+        SetPipeline,
+        SetVertexBuffers,
+        SetIndexBuffer,
+        SetConstantBuffers,
+        SetShaderBuffers,
+        SetShaderTextures,
+        SetSamplers,
+        Draw,
+        DrawIndexed,
+        DrawIndexedInstanced,
+    };
+
+    const char* ToString(RenderCommandType type);
+
+    // A recorded command and the arguments that identify it. Arguments that don't apply to the command are 0.
+    struct RenderCommand {
+        RenderCommandType Type{RenderCommandType::Draw};
+        ShaderStage Stage{ShaderStage::Vertex};
+        uint32_t Handle{0}; // The object created, released or updated, or the first object bound.
+        uint32_t Slot{0};   // The first slot bound, or the first vertex or index drawn.
+        uint32_t Count{0};  // Slots bound, or vertices or indices drawn per instance.
+        uint32_t InstanceCount{0};
+        uint64_t ByteSize{0}; // Bytes uploaded.
+    };
+
+    struct RenderDeviceStats {
+        uint32_t DrawCount{0};
+        uint64_t VertexCount{0}; // Vertices drawn, counting each index of indexed draws and each instance.
+        uint32_t StateChangeCount{0};          // Binding commands that changed what was bound.
+        uint32_t RedundantStateChangeCount{0}; // Binding commands that bound what was already bound.
+        uint32_t UploadCount{0};               // Updates and creations with initial data.
+        uint64_t UploadBytes{0};
+        uint32_t CreatedResourceCount{0};
+        uint32_t ReleasedResourceCount{0};
+    };
+
+    // Commands are checked as a graphics API debug layer would check them: invalid handles and updates out of bounds throw
+    // std::out_of_range, and draws without the state they need throw std::logic_error. Recording the commands can be turned
+    // off to measure only the counting overhead.
+    struct RecordingRenderDevice final : RenderDevice {
+        explicit RecordingRenderDevice(bool recordCommands = true);
+
+        // The commands and statistics since the creation of the device or the most recent ResetStats.
+        const std::vector<RenderCommand>& GetCommands() const {
+            return m_commands;
+        }
+        const RenderDeviceStats& GetStats() const {
+            return m_stats;
+        }
+        void ResetStats();
+
+        // Objects created and not yet released.
+        uint32_t GetLiveResourceCount() const;
+
+        BufferHandle CreateBuffer(const BufferDesc& desc, const void* initialData = nullptr) override;
+        TextureHandle CreateTexture(const TextureDesc& desc, const SubresourceData* initialData = nullptr) override;
+        ShaderHandle CreateShader(ShaderStage stage, const void* bytecode, size_t byteSize) override;
+        PipelineHandle CreatePipeline(const PipelineDesc& desc) override;
+        SamplerHandle CreateSampler(const SamplerDesc& desc) override;
+
+        void Release(BufferHandle buffer) override;
+        void Release(TextureHandle texture) override;
+        void Release(ShaderHandle shader) override;
+        void Release(PipelineHandle pipeline) override;
+        void Release(SamplerHandle sampler) override;
+
+        void UpdateBuffer(BufferHandle buffer, uint32_t byteOffset, const void* data, uint32_t byteSize) override;
+        void UpdateTexture(
+            TextureHandle texture, uint32_t subresource, const TextureRegion& region, const SubresourceData& data) override;
+
+        void SetViewport(const Viewport& viewport) override;
+        void SetPipeline(PipelineHandle pipeline) override;
+        void SetVertexBuffers(
+            uint32_t startSlot, uint32_t count, const BufferHandle* buffers, const uint32_t* strides, const uint32_t* offsets) override;
+        void SetIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset = 0) override;
+        void SetConstantBuffers(ShaderStage stage, uint32_t startSlot, uint32_t count, const BufferHandle* buffers) override;
+        void SetShaderBuffers(ShaderStage stage, uint32_t startSlot, uint32_t count, const BufferHandle* buffers) override;
+        void SetShaderTextures(ShaderStage stage, uint32_t startSlot, uint32_t count, const TextureHandle* textures) override;
+        void SetSamplers(ShaderStage stage, uint32_t startSlot, uint32_t count, const SamplerHandle* samplers) override;
+
+        void Draw(uint32_t vertexCount, uint32_t startVertex) override;
+        void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) override;
+        void DrawIndexedInstanced(
+            uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+
+        // Slot counts of Direct3D 11.
+        static constexpr uint32_t VertexBufferSlotCount = 32;
+        static constexpr uint32_t ConstantBufferSlotCount = 14;
+        static constexpr uint32_t ShaderResourceSlotCount = 128;
+        static constexpr uint32_t SamplerSlotCount = 16;
+
+    private:
+        struct VertexBufferBinding {
+            BufferHandle Buffer{BufferHandle::None};
+            uint32_t Stride{0};
+            uint32_t Offset{0};
+
+            bool operator==(const VertexBufferBinding& other) const {
+                return Buffer == other.Buffer && Stride == other.Stride && Offset == other.Offset;
+            }
+        };
+
+        // Shader resource slots hold either a texture or a structured buffer, told apart by the high bit.
+        static constexpr uint32_t ShaderBufferBit = 0x80000000;
+
+        void Record(const RenderCommand& command);
+        void CountStateChange(bool changed);
+        void CountUpload(uint64_t byteSize);
+        void CheckSlots(uint32_t startSlot, uint32_t count, uint32_t slotCount) const;
+        void CheckDraw(bool indexed) const;
+        template <typename THandle>
+        void BindShaderResources(
+            RenderCommandType type, ShaderStage stage, uint32_t startSlot, uint32_t count, const THandle* handles, uint32_t tag);
+
+        bool m_recordCommands;
+        std::vector<RenderCommand> m_commands;
+        RenderDeviceStats m_stats;
+
+        Internal::HandleTable<BufferHandle, BufferDesc> m_buffers;
+        Internal::HandleTable<TextureHandle, TextureDesc> m_textures;
+        Internal::HandleTable<ShaderHandle, ShaderStage> m_shaders;
+        Internal::HandleTable<PipelineHandle, PipelineDesc> m_pipelines;
+        Internal::HandleTable<SamplerHandle, SamplerDesc> m_samplers;
+
+        Viewport m_viewport{};
+        PipelineHandle m_pipeline{PipelineHandle::None};
+        std::array<VertexBufferBinding, VertexBufferSlotCount> m_vertexBuffers{};
+        BufferHandle m_indexBuffer{BufferHandle::None};
+        IndexFormat m_indexFormat{IndexFormat::UInt16};
+        uint32_t m_indexOffset{0};
+        std::array<std::array<BufferHandle, ConstantBufferSlotCount>, ShaderStageCount> m_constantBuffers{};
+        std::array<std::array<uint32_t, ShaderResourceSlotCount>, ShaderStageCount> m_shaderResources{};
+        std::array<std::array<SamplerHandle, SamplerSlotCount>, ShaderStageCount> m_samplerBindings{};
+    };
+} // namespace Pbr
@@ -0,0 +1,227 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// A thin rendering device interface for creating buffers, textures, shaders and pipelines, binding state and drawing, with
+// handles in place of graphics API objects. D3D11RenderDevice implements it with Direct3D 11, and RecordingRenderDevice
+// records the commands without a GPU. This code has no graphics API dependency.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Pbr {
+    // Handles of the objects of a render device. None is no object, which unbinds a slot.
+    enum class BufferHandle : uint32_t { None = 0 };
+    enum class TextureHandle : uint32_t { None = 0 };
+    enum class ShaderHandle : uint32_t { None = 0 };
+    enum class PipelineHandle : uint32_t { None = 0 };
+    enum class SamplerHandle : uint32_t { None = 0 };
+
+    enum class ShaderStage : uint32_t {
+        Vertex,
+        Pixel,
+    };
+    constexpr uint32_t ShaderStageCount = 2;
+
+    enum class BufferUsage : uint32_t {
+        Vertex,
+        Index,
+        Constant,
+        Structured, // Read by shaders as a structured buffer, bound with SetShaderBuffers.
+    };
+
+    enum class IndexFormat : uint32_t {
+        UInt16,
+        UInt32,
+    };
+
+    enum class BlendMode : uint32_t {
+        Opaque,
+        AlphaBlended, // Also disables depth writes, like PipelineStateBits::AlphaBlended.
+    };
+
+    enum class CullMode : uint32_t {
+        Back,
+        None,
+    };
+
+    enum class SamplerFilter : uint32_t {
+        Point,
+        Linear,
+        Anisotropic,
+    };
+
+    enum class SamplerAddressMode : uint32_t {
+        Wrap,
+        Clamp,
+    };
+
+    struct BufferDesc {
+        BufferUsage Usage{BufferUsage::Vertex};
+        uint32_t ByteSize{0};
+        uint32_t StructureByteStride{0}; // Only for BufferUsage::Structured.
+        bool Dynamic{false};             // Written every frame by the CPU. Updates of dynamic buffers replace the whole buffer.
+    };
+
+    struct TextureDesc {
+        uint32_t Width{0};
+        uint32_t Height{0};
+        uint32_t MipLevels{1};
+        uint32_t ArraySize{1}; // Six per cube with Cube.
+        uint32_t Format{0};    // A DXGI_FORMAT value, which other graphics APIs map to their own formats.
+        bool Cube{false};
+
+        uint32_t GetSubresourceCount() const {
+            return MipLevels * ArraySize;
+        }
+    };
+
+    // Data of one subresource. Subresources are in the order of the levels of each array slice in turn.
+    struct SubresourceData {
+        const void* Data{nullptr};
+        uint32_t RowPitch{0}; // Bytes between rows of texels, or of blocks for block compressed formats.
+        uint32_t ByteSize{0};
+    };
+
+    struct TextureRegion {
+        uint32_t X{0};
+        uint32_t Y{0};
+        uint32_t Width{0};
+        uint32_t Height{0};
+    };
+
+    struct VertexElement {
+        const char* SemanticName{nullptr};
+        uint32_t SemanticIndex{0};
+        uint32_t Format{0}; // A DXGI_FORMAT value.
+        uint32_t InputSlot{0};
+        uint32_t ByteOffset{0};
+        bool PerInstance{false}; // Advanced once per instance instead of once per vertex.
+    };
+
+    struct PipelineDesc {
+        ShaderHandle VertexShader{ShaderHandle::None};
+        ShaderHandle PixelShader{ShaderHandle::None};
+        std::vector<VertexElement> InputLayout; // Read by the vertex shader, empty when it reads no vertex buffers.
+        BlendMode Blend{BlendMode::Opaque};
+        CullMode Cull{CullMode::Back};
+        bool Wireframe{false};
+        bool FrontCounterClockwise{false};
+        bool ReverseZ{false};
+    };
+
+    // The area of the render target that draws are mapped to, in pixels, and the depth range they are mapped to.
+    struct Viewport {
+        float X{0};
+        float Y{0};
+        float Width{0};
+        float Height{0};
+        float MinDepth{0};
+        float MaxDepth{1};
+
+        bool operator==(const Viewport& other) const {
+            return X == other.X && Y == other.Y && Width == other.Width && Height == other.Height && MinDepth == other.MinDepth &&
+                   MaxDepth == other.MaxDepth;
+        }
+    };
+
+    struct SamplerDesc {
+        SamplerFilter Filter{SamplerFilter::Linear};
+        SamplerAddressMode AddressMode{SamplerAddressMode::Wrap};
+        uint32_t MaxAnisotropy{1};
+    };
+
+    // Create objects, bind state and draw on one device and its immediate context. The pipeline bundles the shaders, input
+    // layout and fixed function state that PipelineState creates for each PipelineStateKey. Textures and structured buffers
+    // share the shader resource slots of a stage. Not thread safe.
+    struct RenderDevice {
+        virtual ~RenderDevice() = default;
+
+        virtual BufferHandle CreateBuffer(const BufferDesc& desc, const void* initialData = nullptr) = 0;
+        // Initial data has one entry per subresource, or is null.
+        virtual TextureHandle CreateTexture(const TextureDesc& desc, const SubresourceData* initialData = nullptr) = 0;
+        virtual ShaderHandle CreateShader(ShaderStage stage, const void* bytecode, size_t byteSize) = 0;
+        virtual PipelineHandle CreatePipeline(const PipelineDesc& desc) = 0;
+        virtual SamplerHandle CreateSampler(const SamplerDesc& desc) = 0;
+
+        // Release an object. Objects still bound stay alive until they are unbound.
+        virtual void Release(BufferHandle buffer) = 0;
+        virtual void Release(TextureHandle texture) = 0;
+        virtual void Release(ShaderHandle shader) = 0;
+        virtual void Release(PipelineHandle pipeline) = 0;
+        virtual void Release(SamplerHandle sampler) = 0;
+
+        // Constant and dynamic buffers are always updated whole, from offset 0.
+        virtual void UpdateBuffer(BufferHandle buffer, uint32_t byteOffset, const void* data, uint32_t byteSize) = 0;
+        virtual void UpdateTexture(
+            TextureHandle texture, uint32_t subresource, const TextureRegion& region, const SubresourceData& data) = 0;
+
+        virtual void SetViewport(const Viewport& viewport) = 0;
+        virtual void SetPipeline(PipelineHandle pipeline) = 0;
+        virtual void SetVertexBuffers(
+            uint32_t startSlot, uint32_t count, const BufferHandle* buffers, const uint32_t* strides, const uint32_t* offsets) = 0;
+        virtual void SetIndexBuffer(BufferHandle buffer, IndexFormat format, uint32_t offset = 0) = 0;
+        virtual void SetConstantBuffers(ShaderStage stage, uint32_t startSlot, uint32_t count, const BufferHandle* buffers) = 0;
+        virtual void SetShaderBuffers(ShaderStage stage, uint32_t startSlot, uint32_t count, const BufferHandle* buffers) = 0;
+        virtual void SetShaderTextures(ShaderStage stage, uint32_t startSlot, uint32_t count, const TextureHandle* textures) = 0;
+        virtual void SetSamplers(ShaderStage stage, uint32_t startSlot, uint32_t count, const SamplerHandle* samplers) = 0;
+
+        // Draw triangle lists.
+        virtual void Draw(uint32_t vertexCount, uint32_t startVertex) = 0;
+        virtual void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) = 0;
+        virtual void DrawIndexedInstanced(
+            uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) = 0;
+    };
+
+    namespace Internal {
+        // Objects of one kind of handle, for the render device implementations. Handles are indices plus one, and the slots
+        // of released objects are reused.
+        template <typename THandle, typename T>
+        class HandleTable {
+        public:
+            THandle Add(T object) {
+                uint32_t index;
+                if (m_freeIndices.empty()) {
+                    index = (uint32_t)m_objects.size();
+                    m_objects.emplace_back(std::move(object));
+                } else {
+                    index = m_freeIndices.back();
+                    m_freeIndices.pop_back();
+                    m_objects[index].emplace(std::move(object));
+                }
+                return (THandle)(index + 1);
+            }
+
+            // Throws for None and for released handles.
+            T& Get(THandle handle) {
+                const uint32_t index = (uint32_t)handle - 1;
+                if (handle == THandle::None || index >= m_objects.size() || !m_objects[index]) {
+                    throw std::out_of_range("Invalid render device handle");
+                }
+                return *m_objects[index];
+            }
+
+            void Remove(THandle handle) {
+                Get(handle);
+                const uint32_t index = (uint32_t)handle - 1;
+                m_objects[index].reset();
+                m_freeIndices.push_back(index);
+            }
+
+            uint32_t Size() const {
+                return (uint32_t)(m_objects.size() - m_freeIndices.size());
+            }
+
+        private:
+            std::vector<std::optional<T>> m_objects;
+            std::vector<uint32_t> m_freeIndices;
+        };
+    } // namespace Internal
+} // namespace Pbr
@@ -2,14 +2,38 @@
 // Copyright (C) Microsoft Corporation.  All Rights Reserved
 // Licensed under the MIT License. See License.txt in the project root for license information.
 #include "pch.h"
+#include <algorithm>
+#include <mutex>
+#include <tuple>
+#include <vector>
 #include "PbrCommon.h"
+#include "PbrD3D11RenderDevice.h"
 #include "PbrResources.h"
 #include "PbrMaterial.h"
 
 #include <PbrPixelShader.h>
+#include <PbrMaterialTablePixelShader.h>
+#include <PbrTextureArrayPixelShader.h>
+#include <PbrMaterialTableTextureArrayPixelShader.h>
+#include <PbrNoIblPixelShader.h>
+#include <PbrMaterialTableNoIblPixelShader.h>
+#include <PbrNoIblTextureArrayPixelShader.h>
+#include <PbrMaterialTableNoIblTextureArrayPixelShader.h>
+#include <PbrFlatPixelShader.h>
+#include <PbrMaterialTableFlatPixelShader.h>
+#include <PbrUnlitPixelShader.h>
+#include <PbrMaterialTableUnlitPixelShader.h>
+#include <PbrUnlitTextureArrayPixelShader.h>
+#include <PbrMaterialTableUnlitTextureArrayPixelShader.h>
 #include <PbrVertexShader.h>
+#include <PbrCompactVertexShader.h>
+#include <PbrQuantizedVertexShader.h>
+#include <PbrSkinnedVertexShader.h>
 #include <HighlightPixelShader.h>
 #include <HighlightVertexShader.h>
+#include <HighlightCompactVertexShader.h>
+#include <HighlightQuantizedVertexShader.h>
+#include <HighlightSkinnedVertexShader.h>
 
 using namespace DirectX;
 
@@ -20,110 +44,293 @@ namespace {
         alignas(16) DirectX::XMFLOAT3 LightDirection{};
         alignas(16) DirectX::XMFLOAT3 LightDiffuseColor{};
         alignas(16) int NumSpecularMipLevels{1};
+        int DiffuseIrradianceFromSH{0};
         alignas(16) DirectX::XMFLOAT3 HighlightPosition{};
         alignas(16) float AnimationTime{0};
+        alignas(16) DirectX::XMFLOAT4 DiffuseIrradiance[9]{}; // Spherical harmonics coefficients, used instead of the diffuse map.
     };
 
     struct ModelConstantBuffer {
         alignas(16) DirectX::XMFLOAT4X4 ModelToWorld;
     };
+
+    struct SlotRange {
+        UINT First;
+        UINT Count;
+    };
+
+    // The range from the first to the last slot whose imported object differs from the bound object, which is empty if none
+    // differs.
+    template <typename TImport, typename T>
+    SlotRange FindChangedSlots(const TImport* imports, T* const* boundObjects, UINT slotCount) {
+        UINT first = 0;
+        while (first < slotCount && imports[first].Object.get() == boundObjects[first]) {
+            first++;
+        }
+        UINT last = slotCount;
+        while (last > first && imports[last - 1].Object.get() == boundObjects[last - 1]) {
+            last--;
+        }
+        return {first, last - first};
+    }
+
+    Pbr::IndexFormat GetIndexFormat(DXGI_FORMAT format) {
+        return format == DXGI_FORMAT_R16_UINT ? Pbr::IndexFormat::UInt16 : Pbr::IndexFormat::UInt32;
+    }
 } // namespace
 
 namespace Pbr {
+    // The pipeline of the render device with the shaders and fixed-function state needed by a draw, created once per
+    // PipelineStateKey.
+    struct PipelineState {
+        PipelineStateKey Key;
+        DeviceHandle<PipelineHandle> Handle;
+    };
+
+    // Handles released by their last reference, which can go away on any thread, kept until the resources send them to the
+    // render device on the rendering thread.
+    struct DeviceReleaseQueue {
+        template <typename THandle>
+        void Push(THandle handle) {
+            std::lock_guard guard(Mutex);
+            std::get<std::vector<THandle>>(Handles).push_back(handle);
+        }
+
+        void ReleaseInto(RenderDevice& device) {
+            std::lock_guard guard(Mutex);
+            std::apply(
+                [&device](auto&... handles) {
+                    const auto release = [&device](auto& released) {
+                        for (const auto handle : released) {
+                            device.Release(handle);
+                        }
+                        released.clear();
+                    };
+                    (release(handles), ...);
+                },
+                Handles);
+        }
+
+    private:
+        std::mutex Mutex;
+        std::tuple<std::vector<BufferHandle>,
+                   std::vector<TextureHandle>,
+                   std::vector<ShaderHandle>,
+                   std::vector<PipelineHandle>,
+                   std::vector<SamplerHandle>>
+            Handles;
+    };
+
     struct Resources::Impl {
+        ~Impl() {
+            // The handles of an external render device are released into it, since it outlives the resources.
+            if (ExternalDevice) {
+                PipelineStates.Clear();
+                Resources = {};
+                ReleaseQueuedHandles();
+            }
+        }
+
         void Initialize(_In_ ID3D11Device* device) {
-            Internal::ThrowIfFailed(device->CreateInputLayout(Pbr::Vertex::s_vertexDesc,
-                                                              ARRAYSIZE(Pbr::Vertex::s_vertexDesc),
-                                                              g_PbrVertexShader,
-                                                              sizeof(g_PbrVertexShader),
-                                                              Resources.InputLayout.put()));
-
-            // Set up pixel shader.
-            Internal::ThrowIfFailed(
-                device->CreatePixelShader(g_PbrPixelShader, sizeof(g_PbrPixelShader), nullptr, Resources.PbrPixelShader.put()));
-            Internal::ThrowIfFailed(device->CreatePixelShader(
-                g_HighlightPixelShader, sizeof(g_HighlightPixelShader), nullptr, Resources.HighlightPixelShader.put()));
-
-            Internal::ThrowIfFailed(
-                device->CreateVertexShader(g_PbrVertexShader, sizeof(g_PbrVertexShader), nullptr, Resources.PbrVertexShader.put()));
-            Internal::ThrowIfFailed(device->CreateVertexShader(
-                g_HighlightVertexShader, sizeof(g_HighlightVertexShader), nullptr, Resources.HighlightVertexShader.put()));
+            D3DDevice.copy_from(device);
+            if (!ExternalDevice) {
+                // The handles of the previous render device go away with it, so their releases are dropped with its queue.
+                winrt::com_ptr<ID3D11DeviceContext> context;
+                device->GetImmediateContext(context.put());
+                OwnedDevice = std::make_unique<D3D11RenderDevice>(device, context.get());
+                Device = OwnedDevice.get();
+                Releases = std::make_shared<DeviceReleaseQueue>();
+            }
+            D3D11Device = dynamic_cast<D3D11RenderDevice*>(Device);
+            RenderDeviceGeneration++;
+
+            // Set up an input layout and the vertex shaders for each vertex format. Every input layout also reads the material
+            // index of the draw, one per instance, from the stream after the vertex streams.
+            const auto createVertexFormat = [this](const auto& vertexDesc, const auto& pbrVertexShader, const auto& highlightShader) {
+                DeviceResources::VertexFormatResources resources;
+                for (const D3D11_INPUT_ELEMENT_DESC& element : vertexDesc) {
+                    resources.InputLayout.push_back({element.SemanticName,
+                                                     element.SemanticIndex,
+                                                     (uint32_t)element.Format,
+                                                     element.InputSlot,
+                                                     element.AlignedByteOffset,
+                                                     element.InputSlotClass == D3D11_INPUT_PER_INSTANCE_DATA});
+                }
+                resources.InputLayout.push_back({"MATERIALINDEX", 0, DXGI_FORMAT_R32_UINT, MaterialIndexStream, 0, true});
+                resources.PbrVertexShader = CreateShader(ShaderStage::Vertex, pbrVertexShader, sizeof(pbrVertexShader));
+                resources.HighlightVertexShader = CreateShader(ShaderStage::Vertex, highlightShader, sizeof(highlightShader));
+                return resources;
+            };
+            Resources.VertexFormats[(uint32_t)VertexFormat::Full] =
+                createVertexFormat(Pbr::Vertex::s_vertexDesc, g_PbrVertexShader, g_HighlightVertexShader);
+            Resources.VertexFormats[(uint32_t)VertexFormat::Compact] =
+                createVertexFormat(Pbr::CompactVertex::s_vertexDesc, g_PbrCompactVertexShader, g_HighlightCompactVertexShader);
+            Resources.VertexFormats[(uint32_t)VertexFormat::CompactQuantized] =
+                createVertexFormat(Pbr::QuantizedVertex::s_vertexDesc, g_PbrQuantizedVertexShader, g_HighlightQuantizedVertexShader);
+            Resources.VertexFormats[(uint32_t)VertexFormat::Streaming] =
+                createVertexFormat(Pbr::StreamingVertex::s_vertexDesc, g_PbrVertexShader, g_HighlightVertexShader);
+            Resources.VertexFormats[(uint32_t)VertexFormat::Skinned] =
+                createVertexFormat(Pbr::SkinVertex::s_vertexDesc, g_PbrSkinnedVertexShader, g_HighlightSkinnedVertexShader);
+
+            // Geometry heaps for each vertex format of static geometry and each index format. Existing primitives keep the
+            // ranges of the previous heaps.
+            for (uint32_t format = 0; format < _countof(VertexHeaps); format++) {
+                VertexHeaps[format] =
+                    std::make_unique<GeometryHeap>(device, D3D11_BIND_VERTEX_BUFFER, GetVertexStride((VertexFormat)format));
+            }
+            IndexHeaps[0] = std::make_unique<GeometryHeap>(device, D3D11_BIND_INDEX_BUFFER, (uint32_t)sizeof(uint16_t));
+            IndexHeaps[1] = std::make_unique<GeometryHeap>(device, D3D11_BIND_INDEX_BUFFER, (uint32_t)sizeof(uint32_t));
+
+            // Materials allocate their slots again when the pipeline state generation changes below.
+            Materials = std::make_unique<MaterialTable>(device, (uint32_t)sizeof(Material::ConstantBufferData));
+            TextureArrays = std::make_unique<TextureArrayPool>(device);
+
+            // Set up the pixel shaders, for each permutation and combination of material table and texture arrays. The flat
+            // permutation samples no material textures, so it has no texture array variant.
+            const auto createPixelShader = [this](const auto& pixelShader) {
+                return CreateShader(ShaderStage::Pixel, pixelShader, sizeof(pixelShader));
+            };
+            auto& fullShaders = Resources.PbrPixelShaders[(uint32_t)PixelShaderPermutation::Full];
+            fullShaders[false][false] = createPixelShader(g_PbrPixelShader);
+            fullShaders[true][false] = createPixelShader(g_PbrMaterialTablePixelShader);
+            fullShaders[false][true] = createPixelShader(g_PbrTextureArrayPixelShader);
+            fullShaders[true][true] = createPixelShader(g_PbrMaterialTableTextureArrayPixelShader);
+            auto& noIblShaders = Resources.PbrPixelShaders[(uint32_t)PixelShaderPermutation::NoImageBasedLighting];
+            noIblShaders[false][false] = createPixelShader(g_PbrNoIblPixelShader);
+            noIblShaders[true][false] = createPixelShader(g_PbrMaterialTableNoIblPixelShader);
+            noIblShaders[false][true] = createPixelShader(g_PbrNoIblTextureArrayPixelShader);
+            noIblShaders[true][true] = createPixelShader(g_PbrMaterialTableNoIblTextureArrayPixelShader);
+            auto& flatShaders = Resources.PbrPixelShaders[(uint32_t)PixelShaderPermutation::Flat];
+            flatShaders[false][false] = createPixelShader(g_PbrFlatPixelShader);
+            flatShaders[true][false] = createPixelShader(g_PbrMaterialTableFlatPixelShader);
+            flatShaders[false][true] = flatShaders[false][false];
+            flatShaders[true][true] = flatShaders[true][false];
+            auto& unlitShaders = Resources.PbrPixelShaders[(uint32_t)PixelShaderPermutation::Unlit];
+            unlitShaders[false][false] = createPixelShader(g_PbrUnlitPixelShader);
+            unlitShaders[true][false] = createPixelShader(g_PbrMaterialTableUnlitPixelShader);
+            unlitShaders[false][true] = createPixelShader(g_PbrUnlitTextureArrayPixelShader);
+            unlitShaders[true][true] = createPixelShader(g_PbrMaterialTableUnlitTextureArrayPixelShader);
+            Resources.HighlightPixelShader = createPixelShader(g_HighlightPixelShader);
 
             // Set up the constant buffers.
             static_assert((sizeof(SceneConstantBuffer) % 16) == 0, "Constant Buffer must be divisible by 16 bytes");
-            const CD3D11_BUFFER_DESC pbrConstantBufferDesc(sizeof(SceneConstantBuffer), D3D11_BIND_CONSTANT_BUFFER);
-            Internal::ThrowIfFailed(device->CreateBuffer(&pbrConstantBufferDesc, nullptr, Resources.SceneConstantBuffer.put()));
+            Resources.SceneConstantBuffer =
+                MakeDeviceHandle(Device->CreateBuffer({BufferUsage::Constant, (uint32_t)sizeof(SceneConstantBuffer)}));
 
             static_assert((sizeof(ModelConstantBuffer) % 16) == 0, "Constant Buffer must be divisible by 16 bytes");
-            const CD3D11_BUFFER_DESC modelConstantBufferDesc(sizeof(ModelConstantBuffer), D3D11_BIND_CONSTANT_BUFFER);
-            Internal::ThrowIfFailed(device->CreateBuffer(&modelConstantBufferDesc, nullptr, Resources.ModelConstantBuffer.put()));
-
-            // Samplers for environment map and BRDF.
-            Resources.EnvironmentMapSampler = Texture::CreateSampler(device);
-            Resources.BrdfSampler = Texture::CreateSampler(device);
-
-            CD3D11_BLEND_DESC blendStateDesc(D3D11_DEFAULT);
-            Internal::ThrowIfFailed(device->CreateBlendState(&blendStateDesc, Resources.DefaultBlendState.put()));
-
-            D3D11_RENDER_TARGET_BLEND_DESC rtBlendDesc;
-            rtBlendDesc.BlendEnable = TRUE;
-            rtBlendDesc.SrcBlend = D3D11_BLEND_SRC_ALPHA;
-            rtBlendDesc.DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
-            rtBlendDesc.BlendOp = D3D11_BLEND_OP_ADD;
-            rtBlendDesc.SrcBlendAlpha = D3D11_BLEND_ZERO;
-            rtBlendDesc.DestBlendAlpha = D3D11_BLEND_ONE;
-            rtBlendDesc.BlendOpAlpha = D3D11_BLEND_OP_ADD;
-            rtBlendDesc.RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
-            for (UINT i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i) {
-                blendStateDesc.RenderTarget[i] = rtBlendDesc;
+            Resources.ModelConstantBuffer =
+                MakeDeviceHandle(Device->CreateBuffer({BufferUsage::Constant, (uint32_t)sizeof(ModelConstantBuffer)}));
+
+            // Samplers for environment map and BRDF, like Texture::CreateSampler.
+            const SamplerDesc samplerDesc{SamplerFilter::Linear, SamplerAddressMode::Clamp};
+            Resources.EnvironmentMapSampler = MakeDeviceHandle(Device->CreateSampler(samplerDesc));
+            Resources.BrdfSampler = MakeDeviceHandle(Device->CreateSampler(samplerDesc));
+
+            // Materials created before this point resolve their pipeline states again through the generation. The handles of
+            // the previous device resources of an external render device were queued by the assignments above.
+            PipelineStates.Clear();
+            PipelineStateGeneration++;
+            PrecreatedSettings.clear();
+            ReleaseQueuedHandles();
+            CreateMaterialPipelineStates();
+        }
+
+        // The pipeline state bits of the settings shared by all materials.
+        PipelineStateKey GetSettingsPipelineStateKey() const {
+            return PipelineStateKey{}
+                .With(PipelineStateBits::Highlight, Shading == ShadingMode::Highlight)
+                .With(PipelineStateBits::FrontCounterClockwise, WindingOrder == FrontFaceWindingOrder::CounterClockWise)
+                .With(PipelineStateBits::ReverseZ, ReverseZ)
+                .With(PipelineStateBits::MaterialTable, UseMaterialTable)
+                .With(PipelineStateBits::TextureArrays, UseTextureArrays);
+        }
+
+        // Pre-create the pipeline states that materials can resolve to with the current settings, so that no pipeline
+        // states are created while rendering. Called again when a setting changes, and does nothing for settings whose
+        // pipeline states were already created, since objects and layers switch between a few settings every frame.
+        void CreateMaterialPipelineStates() {
+            if (!Resources.SceneConstantBuffer) {
+                return; // No device resources to create the pipeline states from.
             }
-            Internal::ThrowIfFailed(device->CreateBlendState(&blendStateDesc, Resources.AlphaBlendState.put()));
-
-            for (bool doubleSided : {false, true}) {
-                for (bool wireframe : {false, true}) {
-                    for (bool frontCounterClockwise : {false, true}) {
-                        CD3D11_RASTERIZER_DESC rasterizerDesc(D3D11_DEFAULT);
-                        rasterizerDesc.CullMode = doubleSided ? D3D11_CULL_NONE : D3D11_CULL_BACK;
-                        rasterizerDesc.FillMode = wireframe ? D3D11_FILL_WIREFRAME : D3D11_FILL_SOLID;
-                        rasterizerDesc.FrontCounterClockwise = frontCounterClockwise;
-                        Internal::ThrowIfFailed(device->CreateRasterizerState(
-                            &rasterizerDesc, Resources.RasterizerStates[doubleSided][wireframe][frontCounterClockwise].put()));
-                    }
-                }
+            const PipelineStateKey settingsKey = GetSettingsPipelineStateKey();
+            if (std::find(PrecreatedSettings.begin(), PrecreatedSettings.end(), settingsKey) != PrecreatedSettings.end()) {
+                return;
             }
-
-            for (bool reverseZ : {false, true}) {
-                for (bool noWrite : {false, true}) {
-                    CD3D11_DEPTH_STENCIL_DESC depthStencilDesc(CD3D11_DEFAULT{});
-                    depthStencilDesc.DepthFunc = reverseZ ? D3D11_COMPARISON_GREATER : D3D11_COMPARISON_LESS;
-                    depthStencilDesc.DepthWriteMask = noWrite ? D3D11_DEPTH_WRITE_MASK_ZERO : D3D11_DEPTH_WRITE_MASK_ALL;
-                    Internal::ThrowIfFailed(
-                        device->CreateDepthStencilState(&depthStencilDesc, Resources.DepthStencilStates[reverseZ][noWrite].put()));
-                }
+            for (PipelineStateKey key : GetMaterialPipelineStateKeys(settingsKey)) {
+                GetPipelineState(key);
             }
+            PrecreatedSettings.push_back(settingsKey);
+        }
+
+        const PipelineState& GetPipelineState(PipelineStateKey key) {
+            return PipelineStates.GetOrCreate(key.Normalized(), [this](PipelineStateKey newKey) { return CreatePipelineState(newKey); });
+        }
+
+        std::unique_ptr<PipelineState> CreatePipelineState(PipelineStateKey key) const {
+            auto state = std::make_unique<PipelineState>();
+            state->Key = key;
+
+            const VertexFormat vertexFormat = key.Has(PipelineStateBits::SkinnedVertex)        ? VertexFormat::Skinned
+                                              : key.Has(PipelineStateBits::SplitVertexStreams) ? VertexFormat::Streaming
+                                              : !key.Has(PipelineStateBits::CompactVertex)    ? VertexFormat::Full
+                                              : key.Has(PipelineStateBits::QuantizedPosition) ? VertexFormat::CompactQuantized
+                                                                                              : VertexFormat::Compact;
+            const DeviceResources::VertexFormatResources& vertexFormatResources = Resources.VertexFormats[(uint32_t)vertexFormat];
+
+            PipelineDesc desc;
+            const bool highlight = key.Has(PipelineStateBits::Highlight);
+            desc.VertexShader = *(highlight ? vertexFormatResources.HighlightVertexShader : vertexFormatResources.PbrVertexShader);
+            desc.PixelShader = *(highlight ? Resources.HighlightPixelShader
+                                           : Resources.PbrPixelShaders[(uint32_t)key.GetPixelShaderPermutation()]
+                                                                      [key.Has(PipelineStateBits::MaterialTable)]
+                                                                      [key.Has(PipelineStateBits::TextureArrays)]);
+            desc.InputLayout = vertexFormatResources.InputLayout;
+            desc.Blend = key.Has(PipelineStateBits::AlphaBlended) ? BlendMode::AlphaBlended : BlendMode::Opaque;
+            desc.Cull = key.Has(PipelineStateBits::DoubleSided) ? CullMode::None : CullMode::Back;
+            desc.Wireframe = key.Has(PipelineStateBits::Wireframe);
+            desc.FrontCounterClockwise = key.Has(PipelineStateBits::FrontCounterClockwise);
+            desc.ReverseZ = key.Has(PipelineStateBits::ReverseZ);
+            state->Handle = MakeDeviceHandle(Device->CreatePipeline(desc));
+            return state;
         }
 
         struct DeviceResources {
-            winrt::com_ptr<ID3D11SamplerState> BrdfSampler;
-            winrt::com_ptr<ID3D11SamplerState> EnvironmentMapSampler;
-            winrt::com_ptr<ID3D11InputLayout> InputLayout;
-            winrt::com_ptr<ID3D11VertexShader> PbrVertexShader;
-            winrt::com_ptr<ID3D11PixelShader> PbrPixelShader;
-            winrt::com_ptr<ID3D11VertexShader> HighlightVertexShader;
-            winrt::com_ptr<ID3D11PixelShader> HighlightPixelShader;
-            winrt::com_ptr<ID3D11Buffer> SceneConstantBuffer;
-            winrt::com_ptr<ID3D11Buffer> ModelConstantBuffer;
+            struct VertexFormatResources {
+                std::vector<VertexElement> InputLayout;
+                DeviceHandle<ShaderHandle> PbrVertexShader;
+                DeviceHandle<ShaderHandle> HighlightVertexShader;
+            };
+
+            DeviceHandle<SamplerHandle> BrdfSampler;
+            DeviceHandle<SamplerHandle> EnvironmentMapSampler;
+            VertexFormatResources VertexFormats[5]; // Indexed by VertexFormat.
+            // Three dimensions for [PixelShaderPermutation][MaterialTable][TextureArrays]
+            DeviceHandle<ShaderHandle> PbrPixelShaders[PixelShaderPermutationCount][2][2];
+            DeviceHandle<ShaderHandle> HighlightPixelShader;
+            DeviceHandle<BufferHandle> SceneConstantBuffer;
+            DeviceHandle<BufferHandle> ModelConstantBuffer;
             winrt::com_ptr<ID3D11ShaderResourceView> BrdfLut;
             winrt::com_ptr<ID3D11ShaderResourceView> SpecularEnvironmentMap;
             winrt::com_ptr<ID3D11ShaderResourceView> DiffuseEnvironmentMap;
-            winrt::com_ptr<ID3D11BlendState> AlphaBlendState;
-            winrt::com_ptr<ID3D11BlendState> DefaultBlendState;
-            winrt::com_ptr<ID3D11RasterizerState>
-                RasterizerStates[2][2][2]; // Three dimensions for [DoubleSide][Wireframe][FrontCounterClockWise]
-            winrt::com_ptr<ID3D11DepthStencilState> DepthStencilStates[2][2]; // Two dimensions for [ReverseZ][NoWrite]
+            ImportedTexture BrdfLutImport;
+            ImportedTexture SpecularEnvironmentMapImport;
+            ImportedTexture DiffuseEnvironmentMapImport;
+            ImportedBuffer MaterialParametersImport;
+            ImportedBuffer MaterialIndicesImport;
             mutable std::map<uint32_t, winrt::com_ptr<ID3D11ShaderResourceView>> SolidColorTextureCache;
+            mutable std::map<uint64_t, winrt::com_ptr<ID3D11ShaderResourceView>> CompressedTextureCache;
         };
 
+        // Binds, uploads and draws go to the render device, which is either the external device the resources were created
+        // with, or a D3D11 render device owned by the resources and recreated with the device dependent resources.
+        RenderDevice* ExternalDevice{nullptr};
+        std::unique_ptr<D3D11RenderDevice> OwnedDevice;
+        RenderDevice* Device{nullptr};
+        D3D11RenderDevice* D3D11Device{nullptr}; // The render device when it is a D3D11 render device, which imports objects.
+        std::shared_ptr<DeviceReleaseQueue> Releases;
+        uint32_t RenderDeviceGeneration{0};
+        winrt::com_ptr<ID3D11Device> D3DDevice;
+
         DeviceResources Resources;
         SceneConstantBuffer SceneBuffer;
         ModelConstantBuffer ModelBuffer;
@@ -131,10 +338,156 @@ namespace Pbr {
         Duration HighlightAnimationTimeStart;
         DirectX::XMFLOAT3 HighlightPulseLocation;
 
+        PipelineStateCache<PipelineState> PipelineStates;
+        uint32_t PipelineStateGeneration{0};
+        std::vector<PipelineStateKey> PrecreatedSettings; // The settings keys whose material pipeline states were created.
+        mutable const PipelineState* BoundPipelineState{nullptr};
+
+        std::unique_ptr<GeometryHeap> VertexHeaps[3]; // Indexed by VertexFormat, except Streaming and Skinned which have no heap.
+        std::unique_ptr<GeometryHeap> IndexHeaps[2]; // 16-bit and 32-bit indices.
+        bool UseGeometryHeaps = true;
+        mutable ID3D11Buffer* BoundVertexBuffers[MaxVertexStreams]{};
+        mutable UINT BoundVertexStrides[MaxVertexStreams]{};
+        mutable UINT BoundVertexOffsets[MaxVertexStreams]{};
+        mutable ID3D11Buffer* BoundIndexBuffer{nullptr};
+        mutable DXGI_FORMAT BoundIndexFormat{DXGI_FORMAT_UNKNOWN};
+
+        template <typename Fn>
+        void ForEachGeometryHeap(Fn&& fn) const {
+            for (const std::unique_ptr<GeometryHeap>& heap : VertexHeaps) {
+                if (heap) {
+                    fn(*heap);
+                }
+            }
+            for (const std::unique_ptr<GeometryHeap>& heap : IndexHeaps) {
+                if (heap) {
+                    fn(*heap);
+                }
+            }
+        }
+
+        void FlushGeometryHeaps(_In_ ID3D11DeviceContext* context) const {
+            ForEachGeometryHeap([context](GeometryHeap& heap) { heap.Flush(context); });
+        }
+
+        RenderDevice& GetRenderDevice(_In_ ID3D11DeviceContext* context) const {
+            if (D3D11Device) {
+                D3D11Device->SetContext(context);
+            }
+            return *Device;
+        }
+
+        template <typename THandle>
+        DeviceHandle<THandle> MakeDeviceHandle(THandle handle) const {
+            const std::weak_ptr<DeviceReleaseQueue> releases = Releases;
+            return DeviceHandle<THandle>(new THandle(handle), [releases](const THandle* released) {
+                if (const std::shared_ptr<DeviceReleaseQueue> queue = releases.lock()) {
+                    queue->Push(*released);
+                }
+                delete released;
+            });
+        }
+
+        DeviceHandle<ShaderHandle> CreateShader(ShaderStage stage, const void* bytecode, size_t byteSize) const {
+            return MakeDeviceHandle(Device->CreateShader(stage, bytecode, byteSize));
+        }
+
+        void ReleaseQueuedHandles() const {
+            if (Releases && Device) {
+                Releases->ReleaseInto(*Device);
+            }
+        }
+
+        // Import D3D11 objects into a D3D11 render device. Other render devices only see the commands, so they get objects of
+        // the same size instead.
+        BufferHandle ImportObject(_In_ ID3D11Buffer* buffer, BufferUsage usage, _In_opt_ ID3D11ShaderResourceView* view = nullptr) const {
+            if (D3D11Device) {
+                return D3D11Device->Import(buffer, usage, view);
+            }
+            D3D11_BUFFER_DESC desc;
+            buffer->GetDesc(&desc);
+            return Device->CreateBuffer({usage, desc.ByteWidth, desc.StructureByteStride, desc.Usage == D3D11_USAGE_DYNAMIC});
+        }
+
+        TextureHandle ImportObject(_In_ ID3D11ShaderResourceView* textureView) const {
+            if (D3D11Device) {
+                return D3D11Device->Import(textureView);
+            }
+            winrt::com_ptr<ID3D11Resource> resource;
+            textureView->GetResource(resource.put());
+            TextureDesc desc{1, 1, 1, 1, DXGI_FORMAT_R8G8B8A8_UNORM};
+            if (const winrt::com_ptr<ID3D11Texture2D> texture = resource.try_as<ID3D11Texture2D>()) {
+                D3D11_TEXTURE2D_DESC textureDesc;
+                texture->GetDesc(&textureDesc);
+                desc = {textureDesc.Width,
+                        textureDesc.Height,
+                        textureDesc.MipLevels,
+                        textureDesc.ArraySize,
+                        (uint32_t)textureDesc.Format,
+                        (textureDesc.MiscFlags & D3D11_RESOURCE_MISC_TEXTURECUBE) != 0};
+            }
+            return Device->CreateTexture(desc);
+        }
+
+        SamplerHandle ImportObject(_In_ ID3D11SamplerState* sampler) const {
+            if (D3D11Device) {
+                return D3D11Device->Import(sampler);
+            }
+            D3D11_SAMPLER_DESC samplerDesc;
+            sampler->GetDesc(&samplerDesc);
+            SamplerDesc desc;
+            desc.Filter = samplerDesc.Filter == D3D11_FILTER_ANISOTROPIC          ? SamplerFilter::Anisotropic
+                          : samplerDesc.Filter == D3D11_FILTER_MIN_MAG_MIP_POINT ? SamplerFilter::Point
+                                                                                  : SamplerFilter::Linear;
+            desc.AddressMode = samplerDesc.AddressU == D3D11_TEXTURE_ADDRESS_CLAMP ? SamplerAddressMode::Clamp : SamplerAddressMode::Wrap;
+            desc.MaxAnisotropy = samplerDesc.MaxAnisotropy;
+            return Device->CreateSampler(desc);
+        }
+
+        template <typename TObject, typename THandle, typename... TArgs>
+        THandle Import(ImportedHandle<TObject, THandle>& import, _In_opt_ TObject* object, TArgs... args) const {
+            if (import.Object.get() != object || import.Generation != RenderDeviceGeneration) {
+                import.Object.copy_from(object);
+                import.Handle = object ? MakeDeviceHandle(ImportObject(object, args...)) : nullptr;
+                import.Generation = RenderDeviceGeneration;
+            }
+            return import.Get();
+        }
+
+        void BindMaterialTableBuffers(_In_ ID3D11DeviceContext* context) {
+            RenderDevice& renderDevice = GetRenderDevice(context);
+            const BufferHandle parameterBuffers[] = {Import(Resources.MaterialParametersImport,
+                                                            Materials->GetParameterBuffer(),
+                                                            BufferUsage::Structured,
+                                                            Materials->GetShaderResourceView())};
+            renderDevice.SetShaderBuffers(ShaderStage::Pixel, ShaderSlots::MaterialParameters, 1, parameterBuffers);
+
+            const BufferHandle vertexBuffers[] = {
+                Import(Resources.MaterialIndicesImport, Materials->GetMaterialIndexBuffer(), BufferUsage::Vertex)};
+            const uint32_t stride = sizeof(uint32_t);
+            const uint32_t offset = 0;
+            renderDevice.SetVertexBuffers(MaterialIndexStream, 1, vertexBuffers, &stride, &offset);
+        }
+
+        std::unique_ptr<MaterialTable> Materials;
+        bool UseMaterialTable = false;
+        mutable uint32_t BoundMaterialIndex{0};
+
+        std::unique_ptr<TextureArrayPool> TextureArrays;
+        bool UseTextureArrays = false;
+        mutable ID3D11ShaderResourceView* BoundMaterialTextures[MaterialTextureCount]{};
+        mutable ID3D11SamplerState* BoundMaterialSamplers[MaterialTextureCount]{};
+        mutable bool MaterialTexturesBound{false};
+
         ShadingMode Shading = ShadingMode::Regular;
         FillMode Fill = FillMode::Solid;
         FrontFaceWindingOrder WindingOrder = FrontFaceWindingOrder::ClockWise;
         bool ReverseZ = false;
+        DirectX::XMFLOAT4X4 View{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+        std::optional<DrawPass> Pass;
+        MipFilter TextureMipFilter = MipFilter::Box;
+        TextureCompression Compression = TextureCompression::None;
+        VertexFormat PrimitiveVertexFormat = VertexFormat::Full;
         mutable std::mutex m_cacheMutex;
     };
 
@@ -143,6 +496,14 @@ namespace Pbr {
         m_impl->Initialize(device);
     }
 
+    Resources::Resources(_In_ ID3D11Device* d3dDevice, RenderDevice& renderDevice)
+        : m_impl(std::make_unique<Impl>()) {
+        m_impl->ExternalDevice = &renderDevice;
+        m_impl->Device = &renderDevice;
+        m_impl->Releases = std::make_shared<DeviceReleaseQueue>();
+        m_impl->Initialize(d3dDevice);
+    }
+
     Resources::Resources(Resources&& resources) = default;
 
     Resources::~Resources() = default;
@@ -156,13 +517,34 @@ namespace Pbr {
     }
 
     void Resources::ReleaseDeviceDependentResources() {
+        m_impl->PipelineStates.Clear();
+        m_impl->PipelineStateGeneration++;
+        m_impl->PrecreatedSettings.clear();
+        m_impl->BoundPipelineState = nullptr;
+        std::fill(std::begin(m_impl->BoundVertexBuffers), std::end(m_impl->BoundVertexBuffers), nullptr);
+        m_impl->BoundIndexBuffer = nullptr;
+        for (std::unique_ptr<GeometryHeap>& heap : m_impl->VertexHeaps) {
+            heap.reset();
+        }
+        for (std::unique_ptr<GeometryHeap>& heap : m_impl->IndexHeaps) {
+            heap.reset();
+        }
+        m_impl->Materials.reset();
+        m_impl->TextureArrays.reset();
+        m_impl->MaterialTexturesBound = false;
         m_impl->Resources = {};
+        m_impl->ReleaseQueuedHandles();
+        if (m_impl->OwnedDevice) {
+            m_impl->OwnedDevice.reset();
+            m_impl->Device = nullptr;
+            m_impl->D3D11Device = nullptr;
+        }
+        m_impl->RenderDeviceGeneration++;
+        m_impl->D3DDevice = nullptr;
     }
 
     winrt::com_ptr<ID3D11Device> Resources::GetDevice() const {
-        winrt::com_ptr<ID3D11Device> device;
-        m_impl->Resources.SceneConstantBuffer->GetDevice(device.put());
-        return device;
+        return m_impl->D3DDevice;
     }
 
     void Resources::SetLight(DirectX::XMFLOAT3 direction, RGBColor diffuseColor) {
@@ -183,12 +565,22 @@ namespace Pbr {
 
     void XM_CALLCONV Resources::SetModelToWorld(DirectX::FXMMATRIX modelToWorld, _In_ ID3D11DeviceContext* context) const {
         XMStoreFloat4x4(&m_impl->ModelBuffer.ModelToWorld, XMMatrixTranspose(modelToWorld));
-        context->UpdateSubresource(m_impl->Resources.ModelConstantBuffer.get(), 0, nullptr, &m_impl->ModelBuffer, 0, 0);
+        m_impl->GetRenderDevice(context).UpdateBuffer(
+            *m_impl->Resources.ModelConstantBuffer, 0, &m_impl->ModelBuffer, (uint32_t)sizeof(m_impl->ModelBuffer));
+    }
+
+    DirectX::XMMATRIX XM_CALLCONV Resources::GetModelToWorld() const {
+        return XMMatrixTranspose(XMLoadFloat4x4(&m_impl->ModelBuffer.ModelToWorld));
     }
 
     void XM_CALLCONV Resources::SetViewProjection(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection) {
         XMStoreFloat4x4(&m_impl->SceneBuffer.ViewProjection, XMMatrixTranspose(XMMatrixMultiply(view, projection)));
         XMStoreFloat4(&m_impl->SceneBuffer.EyePosition, XMMatrixInverse(nullptr, view).r[3]);
+        XMStoreFloat4x4(&m_impl->View, view);
+    }
+
+    DirectX::XMMATRIX XM_CALLCONV Resources::GetViewTransform() const {
+        return XMLoadFloat4x4(&m_impl->View);
     }
 
     void Resources::SetEnvironmentMap(_In_ ID3D11ShaderResourceView* specularEnvironmentMap,
@@ -205,10 +597,28 @@ namespace Pbr {
         }
 
         m_impl->SceneBuffer.NumSpecularMipLevels = desc.TextureCube.MipLevels;
+        m_impl->SceneBuffer.DiffuseIrradianceFromSH = 0;
         m_impl->Resources.SpecularEnvironmentMap.copy_from(specularEnvironmentMap);
         m_impl->Resources.DiffuseEnvironmentMap.copy_from(diffuseEnvironmentMap);
     }
 
+    void Resources::SetEnvironmentMap(_In_ ID3D11ShaderResourceView* specularEnvironmentMap, const SphericalHarmonics9& diffuseIrradiance) {
+        D3D11_SHADER_RESOURCE_VIEW_DESC desc;
+        specularEnvironmentMap->GetDesc(&desc);
+        if (desc.ViewDimension != D3D_SRV_DIMENSION_TEXTURECUBE) {
+            throw std::exception("Specular Resource View Type is not D3D_SRV_DIMENSION_TEXTURECUBE");
+        }
+
+        m_impl->SceneBuffer.NumSpecularMipLevels = desc.TextureCube.MipLevels;
+        m_impl->SceneBuffer.DiffuseIrradianceFromSH = 1;
+        for (size_t i = 0; i < diffuseIrradiance.Coefficients.size(); i++) {
+            const XMFLOAT3& coefficient = diffuseIrradiance.Coefficients[i];
+            m_impl->SceneBuffer.DiffuseIrradiance[i] = {coefficient.x, coefficient.y, coefficient.z, 0};
+        }
+        m_impl->Resources.SpecularEnvironmentMap.copy_from(specularEnvironmentMap);
+        m_impl->Resources.DiffuseEnvironmentMap = nullptr;
+    }
+
     winrt::com_ptr<ID3D11ShaderResourceView> Resources::CreateSolidColorTexture(RGBAColor color) const {
         const std::array<uint8_t, 4> rgba = Texture::LoadRGBAUI4(color);
 
@@ -229,34 +639,63 @@ namespace Pbr {
         return m_impl->Resources.SolidColorTextureCache.emplace(colorKey, texture).first->second;
     }
 
+    bool Resources::IsNeutralMaterialTexture(ShaderSlots::PSMaterial slot, _In_opt_ ID3D11ShaderResourceView* texture) const {
+        const std::array<uint8_t, 4> rgba = Texture::LoadRGBAUI4(slot == ShaderSlots::Normal ? RGBA::FlatNormal : RGBA::White);
+        const uint32_t colorKey = *reinterpret_cast<const uint32_t*>(rgba.data());
+
+        std::lock_guard guard(m_impl->m_cacheMutex);
+        const auto textureIt = m_impl->Resources.SolidColorTextureCache.find(colorKey);
+        return textureIt != m_impl->Resources.SolidColorTextureCache.end() && textureIt->second.get() == texture;
+    }
+
     void Resources::Bind(_In_ ID3D11DeviceContext* context) const {
-        context->UpdateSubresource(m_impl->Resources.SceneConstantBuffer.get(), 0, nullptr, &m_impl->SceneBuffer, 0, 0);
+        m_impl->ReleaseQueuedHandles();
+        RenderDevice& renderDevice = m_impl->GetRenderDevice(context);
+        renderDevice.UpdateBuffer(*m_impl->Resources.SceneConstantBuffer, 0, &m_impl->SceneBuffer, (uint32_t)sizeof(m_impl->SceneBuffer));
+
+        // Shaders, input layout and fixed-function state are bound by the materials through pipeline states.
+        // The context may have been modified since the last bind, so the first material binds its whole pipeline state
+        // and the first primitive its buffers.
+        m_impl->BoundPipelineState = nullptr;
+        std::fill(std::begin(m_impl->BoundVertexBuffers), std::end(m_impl->BoundVertexBuffers), nullptr);
+        m_impl->BoundIndexBuffer = nullptr;
+        if (m_impl->D3D11Device) {
+            m_impl->D3D11Device->InvalidateState();
+        }
+        m_impl->FlushGeometryHeaps(context);
 
-        if (m_impl->Shading == ShadingMode::Highlight) {
-            context->VSSetShader(m_impl->Resources.HighlightVertexShader.get(), nullptr, 0);
-            context->PSSetShader(m_impl->Resources.HighlightPixelShader.get(), nullptr, 0);
-        } else {
-            context->VSSetShader(m_impl->Resources.PbrVertexShader.get(), nullptr, 0);
-            context->PSSetShader(m_impl->Resources.PbrPixelShader.get(), nullptr, 0);
+        // The material index stream is read by all input layouts, so it is bound even when materials use constant buffers.
+        // The table is gone while device resources are released.
+        if (m_impl->Materials) {
+            m_impl->Materials->Flush(context);
+            m_impl->BindMaterialTableBuffers(context);
         }
+        m_impl->BoundMaterialIndex = 0;
+        m_impl->MaterialTexturesBound = false;
 
-        ID3D11Buffer* vsBuffers[] = {m_impl->Resources.SceneConstantBuffer.get(), m_impl->Resources.ModelConstantBuffer.get()};
-        context->VSSetConstantBuffers(Pbr::ShaderSlots::ConstantBuffers::Scene, _countof(vsBuffers), vsBuffers);
-        ID3D11Buffer* psBuffers[] = {m_impl->Resources.SceneConstantBuffer.get()};
-        context->PSSetConstantBuffers(Pbr::ShaderSlots::ConstantBuffers::Scene, _countof(psBuffers), psBuffers);
-        context->IASetInputLayout(m_impl->Resources.InputLayout.get());
+        const BufferHandle vsBuffers[] = {*m_impl->Resources.SceneConstantBuffer, *m_impl->Resources.ModelConstantBuffer};
+        renderDevice.SetConstantBuffers(ShaderStage::Vertex, Pbr::ShaderSlots::ConstantBuffers::Scene, _countof(vsBuffers), vsBuffers);
+        const BufferHandle psBuffers[] = {*m_impl->Resources.SceneConstantBuffer};
+        renderDevice.SetConstantBuffers(ShaderStage::Pixel, Pbr::ShaderSlots::ConstantBuffers::Scene, _countof(psBuffers), psBuffers);
 
         static_assert(ShaderSlots::DiffuseTexture == ShaderSlots::SpecularTexture + 1, "Diffuse must follow Specular slot");
         static_assert(ShaderSlots::SpecularTexture == ShaderSlots::Brdf + 1, "Specular must follow BRDF slot");
-        ID3D11ShaderResourceView* shaderResources[] = {
-            m_impl->Resources.BrdfLut.get(), m_impl->Resources.SpecularEnvironmentMap.get(), m_impl->Resources.DiffuseEnvironmentMap.get()};
-        context->PSSetShaderResources(Pbr::ShaderSlots::Brdf, _countof(shaderResources), shaderResources);
-        ID3D11SamplerState* samplers[] = {m_impl->Resources.BrdfSampler.get(), m_impl->Resources.EnvironmentMapSampler.get()};
-        context->PSSetSamplers(ShaderSlots::Brdf, _countof(samplers), samplers);
+        Impl::DeviceResources& resources = m_impl->Resources;
+        const TextureHandle shaderResources[] = {
+            m_impl->Import(resources.BrdfLutImport, resources.BrdfLut.get()),
+            m_impl->Import(resources.SpecularEnvironmentMapImport, resources.SpecularEnvironmentMap.get()),
+            m_impl->Import(resources.DiffuseEnvironmentMapImport, resources.DiffuseEnvironmentMap.get())};
+        renderDevice.SetShaderTextures(ShaderStage::Pixel, Pbr::ShaderSlots::Brdf, _countof(shaderResources), shaderResources);
+        const SamplerHandle samplers[] = {*resources.BrdfSampler, *resources.EnvironmentMapSampler};
+        renderDevice.SetSamplers(ShaderStage::Pixel, ShaderSlots::Brdf, _countof(samplers), samplers);
     }
 
     void Resources::SetShadingMode(ShadingMode mode) {
+        if (m_impl->Shading == mode) {
+            return;
+        }
         m_impl->Shading = mode;
+        m_impl->CreateMaterialPipelineStates();
     }
 
     ShadingMode Resources::GetShadingMode() const {
@@ -271,8 +710,20 @@ namespace Pbr {
         return m_impl->Fill;
     }
 
+    void Resources::SetDrawPass(std::optional<DrawPass> pass) {
+        m_impl->Pass = pass;
+    }
+
+    std::optional<DrawPass> Resources::GetDrawPass() const {
+        return m_impl->Pass;
+    }
+
     void Resources::SetFrontFaceWindingOrder(FrontFaceWindingOrder windingOrder) {
+        if (m_impl->WindingOrder == windingOrder) {
+            return;
+        }
         m_impl->WindingOrder = windingOrder;
+        m_impl->CreateMaterialPipelineStates();
     }
 
     FrontFaceWindingOrder Resources::GetFrontFaceWindingOrder() const {
@@ -280,22 +731,285 @@ namespace Pbr {
     }
 
     void Resources::SetDepthFuncReversed(bool reverseZ) {
+        if (m_impl->ReverseZ == reverseZ) {
+            return;
+        }
         m_impl->ReverseZ = reverseZ;
+        m_impl->CreateMaterialPipelineStates();
+    }
+
+    bool Resources::GetDepthFuncReversed() const {
+        return m_impl->ReverseZ;
+    }
+
+    void Resources::SetMipFilter(MipFilter filter) {
+        m_impl->TextureMipFilter = filter;
+    }
+
+    MipFilter Resources::GetMipFilter() const {
+        return m_impl->TextureMipFilter;
+    }
+
+    void Resources::SetTextureCompression(TextureCompression compression) {
+        m_impl->Compression = compression;
+    }
+
+    TextureCompression Resources::GetTextureCompression() const {
+        return m_impl->Compression;
+    }
+
+    void Resources::SetVertexFormat(VertexFormat format) {
+        if (format == VertexFormat::Streaming) {
+            throw std::exception("The streaming vertex format is only used by primitives with updatable buffers");
+        }
+        if (format == VertexFormat::Skinned) {
+            throw std::exception("The skinned vertex format is only used by primitives with skin vertices");
+        }
+        m_impl->PrimitiveVertexFormat = format;
+    }
+
+    VertexFormat Resources::GetVertexFormat() const {
+        return m_impl->PrimitiveVertexFormat;
+    }
+
+    void Resources::SetGeometryHeapsEnabled(bool enabled) {
+        m_impl->UseGeometryHeaps = enabled;
+    }
+
+    bool Resources::GetGeometryHeapsEnabled() const {
+        return m_impl->UseGeometryHeaps;
     }
 
-    void Resources::SetBlendState(_In_ ID3D11DeviceContext* context, bool enabled) const {
-        context->OMSetBlendState(
-            enabled ? m_impl->Resources.AlphaBlendState.get() : m_impl->Resources.DefaultBlendState.get(), nullptr, 0xFFFFFF);
+    void Resources::SetMaterialTableEnabled(bool enabled) {
+        if (m_impl->UseMaterialTable == enabled) {
+            return;
+        }
+        m_impl->UseMaterialTable = enabled;
+        m_impl->CreateMaterialPipelineStates();
+    }
+
+    bool Resources::GetMaterialTableEnabled() const {
+        return m_impl->UseMaterialTable;
     }
 
-    void Resources::SetRasterizerState(_In_ ID3D11DeviceContext* context, bool doubleSided, bool wireframe) const {
-        context->RSSetState(m_impl->Resources
-                                .RasterizerStates[doubleSided ? 1 : 0][wireframe ? 1 : 0]
-                                                 [m_impl->WindingOrder == FrontFaceWindingOrder::CounterClockWise ? 1 : 0]
-                                .get());
+    MaterialTableStats Resources::GetMaterialTableStats() const {
+        return m_impl->Materials ? m_impl->Materials->GetStats() : MaterialTableStats{};
     }
 
-    void Resources::SetDepthStencilState(_In_ ID3D11DeviceContext* context, bool disableDepthWrite) const {
-        context->OMSetDepthStencilState(m_impl->Resources.DepthStencilStates[m_impl->ReverseZ ? 1 : 0][disableDepthWrite ? 1 : 0].get(), 1);
+    void Resources::SetTextureArraysEnabled(bool enabled) {
+        if (m_impl->UseTextureArrays == enabled) {
+            return;
+        }
+        m_impl->UseTextureArrays = enabled;
+        m_impl->CreateMaterialPipelineStates();
+    }
+
+    bool Resources::GetTextureArraysEnabled() const {
+        return m_impl->UseTextureArrays;
+    }
+
+    TextureArrayPoolStats Resources::GetTextureArrayStats() const {
+        return m_impl->TextureArrays ? m_impl->TextureArrays->GetStats() : TextureArrayPoolStats{};
+    }
+
+    GeometryHeapStats Resources::GetGeometryHeapStats() const {
+        GeometryHeapStats stats;
+        m_impl->ForEachGeometryHeap([&stats](const GeometryHeap& heap) { stats += heap.GetStats(); });
+        return stats;
+    }
+
+    std::shared_ptr<const GeometryRange>
+    Resources::AllocateVertices(VertexFormat vertexFormat, const void* vertices, uint32_t vertexCount) const {
+        if ((uint32_t)vertexFormat >= _countof(m_impl->VertexHeaps)) {
+            return nullptr;
+        }
+        const std::unique_ptr<GeometryHeap>& heap = m_impl->VertexHeaps[(uint32_t)vertexFormat];
+        return heap ? heap->Allocate(vertices, vertexCount) : nullptr;
+    }
+
+    std::shared_ptr<const GeometryRange>
+    Resources::AllocateIndices(DXGI_FORMAT indexFormat, const void* indices, uint32_t indexCount) const {
+        const std::unique_ptr<GeometryHeap>& heap = m_impl->IndexHeaps[indexFormat == DXGI_FORMAT_R16_UINT ? 0 : 1];
+        return heap ? heap->Allocate(indices, indexCount) : nullptr;
+    }
+
+    winrt::com_ptr<ID3D11ShaderResourceView> Resources::CreateCompressedTexture(_In_reads_bytes_(width* height * 4) const uint8_t* rgba,
+                                                                                uint32_t width,
+                                                                                uint32_t height,
+                                                                                BlockFormat blockFormat,
+                                                                                bool sRGB,
+                                                                                MipFilter mipFilter) const {
+        const winrt::com_ptr<ID3D11Device> device = GetDevice();
+
+        // BC7 requires feature level 11.
+        if (blockFormat == BlockFormat::BC7 && !Texture::IsFormatSupported(device.get(), Texture::GetDxgiFormat(blockFormat, sRGB))) {
+            blockFormat = BlockFormat::BC3;
+        }
+
+        // 64-bit FNV-1a over the settings and the image content.
+        uint64_t key = 14695981039346656037ull;
+        const auto hashBytes = [&key](const void* data, size_t size) {
+            for (size_t i = 0; i < size; i++) {
+                key = (key ^ static_cast<const uint8_t*>(data)[i]) * 1099511628211ull;
+            }
+        };
+        const uint32_t settings[] = {width, height, (uint32_t)blockFormat, (uint32_t)sRGB, (uint32_t)mipFilter};
+        hashBytes(settings, sizeof(settings));
+        hashBytes(rgba, static_cast<size_t>(width) * height * 4);
+
+        {
+            std::lock_guard guard(m_impl->m_cacheMutex);
+            auto textureIt = m_impl->Resources.CompressedTextureCache.find(key);
+            if (textureIt != m_impl->Resources.CompressedTextureCache.end()) {
+                return textureIt->second;
+            }
+        }
+
+        winrt::com_ptr<ID3D11ShaderResourceView> texture =
+            Pbr::Texture::CreateCompressedTexture(device.get(), rgba, width, height, blockFormat, sRGB, mipFilter);
+        std::lock_guard guard(m_impl->m_cacheMutex);
+        // If the key already exists then the existing texture will be returned.
+        return m_impl->Resources.CompressedTextureCache.emplace(key, texture).first->second;
+    }
+
+    PipelineStateKey Resources::GetPipelineStateKey(bool alphaBlended,
+                                                    bool doubleSided,
+                                                    bool wireframe,
+                                                    VertexFormat vertexFormat,
+                                                    PixelShaderPermutation pixelShader) const {
+        return m_impl->GetSettingsPipelineStateKey()
+            .With(pixelShader)
+            .With(PipelineStateBits::AlphaBlended, alphaBlended)
+            .With(PipelineStateBits::DoubleSided, doubleSided)
+            .With(PipelineStateBits::Wireframe, wireframe)
+            .With(PipelineStateBits::CompactVertex, vertexFormat == VertexFormat::Compact || vertexFormat == VertexFormat::CompactQuantized)
+            .With(PipelineStateBits::QuantizedPosition, vertexFormat == VertexFormat::CompactQuantized)
+            .With(PipelineStateBits::SplitVertexStreams, vertexFormat == VertexFormat::Streaming)
+            .With(PipelineStateBits::SkinnedVertex, vertexFormat == VertexFormat::Skinned)
+            .Normalized();
+    }
+
+    const PipelineState& Resources::GetPipelineState(PipelineStateKey key) const {
+        return m_impl->GetPipelineState(key);
+    }
+
+    uint32_t Resources::GetPipelineStateGeneration() const {
+        return m_impl->PipelineStateGeneration;
+    }
+
+    RenderDevice& Resources::GetRenderDevice(_In_ ID3D11DeviceContext* context) const {
+        return m_impl->GetRenderDevice(context);
+    }
+
+    BufferHandle Resources::Import(ImportedBuffer& import,
+                                   _In_opt_ ID3D11Buffer* buffer,
+                                   BufferUsage usage,
+                                   _In_opt_ ID3D11ShaderResourceView* view) const {
+        return m_impl->Import(import, buffer, usage, view);
+    }
+
+    TextureHandle Resources::Import(ImportedTexture& import, _In_opt_ ID3D11ShaderResourceView* texture) const {
+        return m_impl->Import(import, texture);
+    }
+
+    SamplerHandle Resources::Import(ImportedSampler& import, _In_opt_ ID3D11SamplerState* sampler) const {
+        return m_impl->Import(import, sampler);
+    }
+
+    DeviceHandle<BufferHandle> Resources::CreateBuffer(const BufferDesc& desc) const {
+        return m_impl->MakeDeviceHandle(m_impl->Device->CreateBuffer(desc));
+    }
+
+    uint32_t Resources::GetRenderDeviceGeneration() const {
+        return m_impl->RenderDeviceGeneration;
+    }
+
+    void Resources::BindPipelineState(_In_ ID3D11DeviceContext* context, const PipelineState& pipelineState) const {
+        // The render device only sets the states that differ from the previous pipeline.
+        if (m_impl->BoundPipelineState != &pipelineState) {
+            m_impl->GetRenderDevice(context).SetPipeline(*pipelineState.Handle);
+            m_impl->BoundPipelineState = &pipelineState;
+        }
+    }
+
+    MaterialTable& Resources::GetMaterialTable() const {
+        return *m_impl->Materials;
+    }
+
+    void Resources::BindMaterialTable(_In_ ID3D11DeviceContext* context, uint32_t materialIndex) const {
+        if (m_impl->Materials && m_impl->Materials->Flush(context)) {
+            m_impl->BindMaterialTableBuffers(context);
+        }
+        m_impl->BoundMaterialIndex = materialIndex;
+    }
+
+    uint32_t Resources::GetBoundMaterialIndex() const {
+        return m_impl->BoundMaterialIndex;
+    }
+
+    TextureArrayPool& Resources::GetTextureArrayPool() const {
+        return *m_impl->TextureArrays;
+    }
+
+    void Resources::BindMaterialTextures(_In_ ID3D11DeviceContext* context,
+                                         _In_reads_(MaterialTextureCount) const ImportedTexture* textures,
+                                         _In_reads_(MaterialTextureCount) const ImportedSampler* samplers) const {
+        static_assert(Pbr::ShaderSlots::BaseColor == 0, "BaseColor must be the first slot");
+
+        const bool bound = m_impl->MaterialTexturesBound;
+        const auto [firstTexture, textureCount] =
+            bound ? FindChangedSlots(textures, m_impl->BoundMaterialTextures, MaterialTextureCount) : SlotRange{0, MaterialTextureCount};
+        RenderDevice& renderDevice = m_impl->GetRenderDevice(context);
+        if (textureCount > 0) {
+            TextureHandle textureHandles[MaterialTextureCount];
+            for (UINT i = 0; i < textureCount; i++) {
+                textureHandles[i] = textures[firstTexture + i].Get();
+                m_impl->BoundMaterialTextures[firstTexture + i] = textures[firstTexture + i].Object.get();
+            }
+            renderDevice.SetShaderTextures(ShaderStage::Pixel, firstTexture, textureCount, textureHandles);
+        }
+
+        const auto [firstSampler, samplerCount] =
+            bound ? FindChangedSlots(samplers, m_impl->BoundMaterialSamplers, MaterialTextureCount) : SlotRange{0, MaterialTextureCount};
+        if (samplerCount > 0) {
+            SamplerHandle samplerHandles[MaterialTextureCount];
+            for (UINT i = 0; i < samplerCount; i++) {
+                samplerHandles[i] = samplers[firstSampler + i].Get();
+                m_impl->BoundMaterialSamplers[firstSampler + i] = samplers[firstSampler + i].Object.get();
+            }
+            renderDevice.SetSamplers(ShaderStage::Pixel, firstSampler, samplerCount, samplerHandles);
+        }
+
+        m_impl->MaterialTexturesBound = true;
+    }
+
+    void Resources::BindGeometry(_In_ ID3D11DeviceContext* context,
+                                 UINT vertexStreamCount,
+                                 _In_reads_(vertexStreamCount) const ImportedBuffer* vertexBuffers,
+                                 _In_reads_(vertexStreamCount) const UINT* vertexStrides,
+                                 _In_reads_(vertexStreamCount) const UINT* vertexOffsets,
+                                 const ImportedBuffer& indexBuffer,
+                                 DXGI_FORMAT indexFormat) const {
+        // Primitives loaded since the last bind may still have geometry heap data to upload.
+        m_impl->FlushGeometryHeaps(context);
+
+        // Streams past the primitive's are left bound, since the input layout doesn't read them.
+        RenderDevice& renderDevice = m_impl->GetRenderDevice(context);
+        for (UINT stream = 0; stream < vertexStreamCount; stream++) {
+            ID3D11Buffer* const vertexBuffer = vertexBuffers[stream].Object.get();
+            if (m_impl->BoundVertexBuffers[stream] != vertexBuffer || m_impl->BoundVertexStrides[stream] != vertexStrides[stream] ||
+                m_impl->BoundVertexOffsets[stream] != vertexOffsets[stream]) {
+                const BufferHandle vertexBufferHandle = vertexBuffers[stream].Get();
+                renderDevice.SetVertexBuffers(stream, 1, &vertexBufferHandle, &vertexStrides[stream], &vertexOffsets[stream]);
+                m_impl->BoundVertexBuffers[stream] = vertexBuffer;
+                m_impl->BoundVertexStrides[stream] = vertexStrides[stream];
+                m_impl->BoundVertexOffsets[stream] = vertexOffsets[stream];
+            }
+        }
+        if (m_impl->BoundIndexBuffer != indexBuffer.Object.get() || m_impl->BoundIndexFormat != indexFormat) {
+            renderDevice.SetIndexBuffer(indexBuffer.Get(), GetIndexFormat(indexFormat));
+            m_impl->BoundIndexBuffer = indexBuffer.Object.get();
+            m_impl->BoundIndexFormat = indexFormat;
+        }
     }
 } // namespace Pbr
@@ -6,16 +6,24 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <optional>
 #include <winrt/base.h>
 #include <d3d11.h>
 #include <d3d11_2.h>
 #include <DirectXMath.h>
 #include "PbrCommon.h"
+#include "PbrDrawSort.h"
+#include "PbrGeometryHeap.h"
+#include "PbrMaterialTable.h"
+#include "PbrPipelineState.h"
+#include "PbrRenderDevice.h"
+#include "PbrTextureArrayPool.h"
 
 namespace Pbr {
     namespace ShaderSlots {
         enum VSResourceViews {
             Transforms = 0,
+            JointMatrices = 1, // Only read by the skinning vertex shaders.
         };
 
         enum PSMaterial { // For both samplers and textures.
@@ -37,10 +45,15 @@ namespace Pbr {
             EnvironmentMapSampler = Brdf + 1
         };
 
+        enum MaterialTableResources { // Textures only, with the material table enabled.
+            MaterialParameters = DiffuseTexture + 1
+        };
+
         enum ConstantBuffers {
-            Scene,    // Used by VS and PS
-            Model,    // PS only
-            Material, // PS only
+            Scene,     // Used by VS and PS
+            Model,     // PS only
+            Material,  // PS only
+            Primitive, // VS only, position bounds of quantized vertices
         };
     } // namespace ShaderSlots
 
@@ -59,9 +72,36 @@ namespace Pbr {
         CounterClockWise,
     };
 
+    struct PipelineState;
+
+    // A handle of an object in the render device of the resources, released with the last reference. The last reference can go
+    // away on any thread: the release is queued and sent to the render device by the next Resources::Bind.
+    template <typename THandle>
+    using DeviceHandle = std::shared_ptr<const THandle>;
+
+    // The handle of a D3D11 object in the render device of the resources, kept by the owner of the object so that binds don't
+    // look it up. Resources::Import imports the object again when it changed or the render device was recreated.
+    template <typename TObject, typename THandle>
+    struct ImportedHandle {
+        winrt::com_ptr<TObject> Object;
+        DeviceHandle<THandle> Handle;
+        uint32_t Generation{0};
+
+        THandle Get() const {
+            return Handle ? *Handle : THandle::None;
+        }
+    };
+    using ImportedBuffer = ImportedHandle<ID3D11Buffer, BufferHandle>;
+    using ImportedTexture = ImportedHandle<ID3D11ShaderResourceView, TextureHandle>;
+    using ImportedSampler = ImportedHandle<ID3D11SamplerState, SamplerHandle>;
+
     // Global PBR resources required for rendering a scene.
     struct Resources final {
         explicit Resources(_In_ ID3D11Device* d3dDevice);
+        // Create the objects on the D3D11 device, but send the binds, uploads and draws of rendering to another render device,
+        // e.g. a RecordingRenderDevice to count them. That device gets objects of the same size in place of the D3D11 objects
+        // of primitives and materials. The render device must outlive the resources.
+        Resources(_In_ ID3D11Device* d3dDevice, RenderDevice& renderDevice);
         Resources(Resources&&);
 
         ~Resources();
@@ -92,9 +132,16 @@ namespace Pbr {
         // Set the specular and diffuse image-based lighting (IBL) maps. ShaderResourceViews must be TextureCubes.
         void SetEnvironmentMap(_In_ ID3D11ShaderResourceView* specularEnvironmentMap, _In_ ID3D11ShaderResourceView* diffuseEnvironmentMap);
 
+        // Set the specular IBL map and the diffuse irradiance as spherical harmonics, which the shader evaluates instead of
+        // sampling a diffuse map.
+        void SetEnvironmentMap(_In_ ID3D11ShaderResourceView* specularEnvironmentMap, const SphericalHarmonics9& diffuseIrradiance);
+
         // Set the current view and projection matrices.
         void XM_CALLCONV SetViewProjection(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection);
 
+        // Get the view matrix of the most recent SetViewProjection, which draws are sorted by.
+        DirectX::XMMATRIX XM_CALLCONV GetViewTransform() const;
+
         // Many 1x1 pixel colored textures are used in the PBR system. This is used to create textures backed by a cache to reduce the
         // number of textures created.
         winrt::com_ptr<ID3D11ShaderResourceView> CreateSolidColorTexture(RGBAColor color) const;
@@ -102,8 +149,18 @@ namespace Pbr {
         // Bind the the PBR resources to the current context.
         void Bind(_In_ ID3D11DeviceContext* context) const;
 
+        // The render device that the binds, uploads and draws of the resources, models, materials and primitives go through,
+        // sending its commands to the context unless the resources were created with a render device of their own.
+        RenderDevice& GetRenderDevice(_In_ ID3D11DeviceContext* context) const;
+
         // Set and update the model to world constant buffer value.
         void XM_CALLCONV SetModelToWorld(DirectX::FXMMATRIX modelToWorld, _In_ ID3D11DeviceContext* context) const;
+        DirectX::XMMATRIX XM_CALLCONV GetModelToWorld() const;
+
+        // Set or get the pass being drawn. Models then only draw the primitives of that pass, opaque ones front to back and
+        // blended ones back to front. Without a pass, which is the default, models draw both passes in turn.
+        void SetDrawPass(std::optional<DrawPass> pass);
+        std::optional<DrawPass> GetDrawPass() const;
 
         // Set or get the shading and fill modes.
         void SetShadingMode(ShadingMode mode);
@@ -114,13 +171,131 @@ namespace Pbr {
         FrontFaceWindingOrder GetFrontFaceWindingOrder() const;
 
         void SetDepthFuncReversed(bool reverseZ);
+        bool GetDepthFuncReversed() const;
+
+        // Set or get the filter used to generate mip chains for textures loaded from images. Box by default.
+        void SetMipFilter(MipFilter filter);
+        MipFilter GetMipFilter() const;
+
+        // Set or get the block compression applied to textures loaded from images. None by default.
+        void SetTextureCompression(TextureCompression compression);
+        TextureCompression GetTextureCompression() const;
+
+        // Set or get the vertex format of primitives created from builders. Full by default. Primitives with updatable
+        // buffers always use VertexFormat::Streaming, and primitives with skin vertices VertexFormat::Skinned, which can't be
+        // set here.
+        void SetVertexFormat(VertexFormat format);
+        VertexFormat GetVertexFormat() const;
+
+        // Set or get whether primitives created from builders without updatable buffers suballocate their geometry from
+        // vertex and index buffers shared per format, so consecutive draws don't rebind buffers. Enabled by default.
+        void SetGeometryHeapsEnabled(bool enabled);
+        bool GetGeometryHeapsEnabled() const;
+
+        // Buffer usage and fragmentation of the geometry heaps of all formats.
+        GeometryHeapStats GetGeometryHeapStats() const;
+
+        // Set or get whether materials keep their parameters in one table shared by all materials instead of in a constant
+        // buffer each. Draws then select their parameters with an index instead of binding a constant buffer, and parameter
+        // changes of many materials are uploaded together. Disabled by default.
+        void SetMaterialTableEnabled(bool enabled);
+        bool GetMaterialTableEnabled() const;
+
+        // Slot usage of the material table and the uploads of its most recent flush.
+        MaterialTableStats GetMaterialTableStats() const;
+
+        // Set or get whether materials sample their textures from slices of texture arrays shared by all textures of the same
+        // size and format. Materials then pass the slices with their parameters, and consecutive draws of materials whose
+        // textures share arrays bind no textures. Disabled by default.
+        void SetTextureArraysEnabled(bool enabled);
+        bool GetTextureArraysEnabled() const;
+
+        // Arrays and slices of the texture array pool.
+        TextureArrayPoolStats GetTextureArrayStats() const;
+
+        // Create a block compressed texture from RGBA data, falling back to BC3 if the device cannot sample BC7. Textures are cached
+        // by image content and settings, so models sharing an image only compress it once.
+        winrt::com_ptr<ID3D11ShaderResourceView> CreateCompressedTexture(_In_reads_bytes_(width* height * 4) const uint8_t* rgba,
+                                                                         uint32_t width,
+                                                                         uint32_t height,
+                                                                         BlockFormat blockFormat,
+                                                                         bool sRGB,
+                                                                         MipFilter mipFilter) const;
 
     private:
-        void SetBlendState(_In_ ID3D11DeviceContext* context, bool enabled) const;
-        void SetRasterizerState(_In_ ID3D11DeviceContext* context, bool doubleSided, bool wireframe) const;
-        void SetDepthStencilState(_In_ ID3D11DeviceContext* context, bool disableDepthWrite) const;
+        // Combine the per-material state and the primitive's vertex format with the current shading mode, winding order and
+        // depth direction.
+        PipelineStateKey GetPipelineStateKey(bool alphaBlended,
+                                             bool doubleSided,
+                                             bool wireframe,
+                                             VertexFormat vertexFormat,
+                                             PixelShaderPermutation pixelShader) const;
+
+        // Whether the texture is the solid color texture this returns for the neutral value of the material slot, such as
+        // white for the base color and a flat normal for the normal map.
+        bool IsNeutralMaterialTexture(ShaderSlots::PSMaterial slot, _In_opt_ ID3D11ShaderResourceView* texture) const;
+
+        // Get the pipeline state for the key, creating it if needed. The returned state is valid while
+        // GetPipelineStateGeneration() returns the same value, i.e. until device resources are recreated.
+        const PipelineState& GetPipelineState(PipelineStateKey key) const;
+        uint32_t GetPipelineStateGeneration() const;
+
+        // Get the handle of a D3D11 object in the render device from the import kept by the owner of the object, importing the
+        // object again when it changed or the render device was recreated. Null objects have the None handle.
+        BufferHandle Import(ImportedBuffer& import,
+                            _In_opt_ ID3D11Buffer* buffer,
+                            BufferUsage usage,
+                            _In_opt_ ID3D11ShaderResourceView* view = nullptr) const;
+        TextureHandle Import(ImportedTexture& import, _In_opt_ ID3D11ShaderResourceView* texture) const;
+        SamplerHandle Import(ImportedSampler& import, _In_opt_ ID3D11SamplerState* sampler) const;
+
+        // Create a buffer in the render device, which is valid while GetRenderDeviceGeneration() returns the same value.
+        DeviceHandle<BufferHandle> CreateBuffer(const BufferDesc& desc) const;
+        uint32_t GetRenderDeviceGeneration() const;
+
+        // Bind the pipeline state, only setting the parts that differ from the previously bound state.
+        void BindPipelineState(_In_ ID3D11DeviceContext* context, const PipelineState& pipelineState) const;
+
+        // Suballocate geometry from the heap of the vertex or index format, uploading the data on the next bind. Returns null when
+        // the format has no heap or the count is 0.
+        std::shared_ptr<const GeometryRange> AllocateVertices(VertexFormat vertexFormat, const void* vertices, uint32_t vertexCount) const;
+        std::shared_ptr<const GeometryRange> AllocateIndices(DXGI_FORMAT indexFormat, const void* indices, uint32_t indexCount) const;
+
+        // Bind up to MaxVertexStreams vertex buffers at byte offsets, e.g. the streams of VertexFormat::Streaming, and an index
+        // buffer, only setting the ones that differ from the previously bound buffers. Buffers are compared by their D3D11
+        // objects, since the primitives sharing a geometry heap buffer each import it.
+        void BindGeometry(_In_ ID3D11DeviceContext* context,
+                          UINT vertexStreamCount,
+                          _In_reads_(vertexStreamCount) const ImportedBuffer* vertexBuffers,
+                          _In_reads_(vertexStreamCount) const UINT* vertexStrides,
+                          _In_reads_(vertexStreamCount) const UINT* vertexOffsets,
+                          const ImportedBuffer& indexBuffer,
+                          DXGI_FORMAT indexFormat) const;
+
+        // Get the material table, which is recreated with the device dependent resources.
+        MaterialTable& GetMaterialTable() const;
+
+        // Upload the changed parameters of the material table, bind its buffers if they changed, and draw the following
+        // primitives with the given material index. Materials using constant buffers draw with index 0.
+        void BindMaterialTable(_In_ ID3D11DeviceContext* context, uint32_t materialIndex) const;
+        uint32_t GetBoundMaterialIndex() const;
+
+        // Get the texture array pool, which is recreated with the device dependent resources.
+        TextureArrayPool& GetTextureArrayPool() const;
+
+        // Bind the imported textures and samplers of a material, only setting the ones that differ from the previously bound ones.
+        static constexpr UINT MaterialTextureCount = ShaderSlots::LastMaterialSlot + 1;
+        void BindMaterialTextures(_In_ ID3D11DeviceContext* context,
+                                  _In_reads_(MaterialTextureCount) const ImportedTexture* textures,
+                                  _In_reads_(MaterialTextureCount) const ImportedSampler* samplers) const;
+
+        static constexpr UINT MaxVertexStreams = 2;
+        static constexpr UINT MaterialIndexStream = MaxVertexStreams; // Per-instance material indices, after the vertex streams.
 
         friend struct Material;
+        friend struct Primitive;
+        friend struct Model;
+        friend struct ModelInstance;
 
         struct Impl;
         std::unique_ptr<Impl> m_impl;
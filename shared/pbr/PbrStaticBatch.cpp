@@ -0,0 +1,183 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include "PbrCommon.h"
+#include "PbrStaticBatch.h"
+
+using namespace DirectX;
+
+namespace {
+    // Transform the builder's vertices by the given matrix. Normals use the inverse transpose so that
+    // non-uniform scale keeps them perpendicular to the surface. Mirroring transforms flip the triangle winding.
+    Pbr::PrimitiveBuilder XM_CALLCONV TransformGeometry(const Pbr::PrimitiveBuilder& source, FXMMATRIX transform) {
+        const XMMATRIX normalTransform = XMMatrixTranspose(XMMatrixInverse(nullptr, transform));
+        const bool mirrored = XMVectorGetX(XMMatrixDeterminant(transform)) < 0;
+
+        Pbr::PrimitiveBuilder result;
+        result.Vertices.reserve(source.Vertices.size());
+        for (const Pbr::Vertex& vertex : source.Vertices) {
+            Pbr::Vertex transformed = vertex;
+            XMStoreFloat3(&transformed.Position, XMVector3Transform(XMLoadFloat3(&vertex.Position), transform));
+            XMStoreFloat3(&transformed.Normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&vertex.Normal), normalTransform)));
+
+            const XMVECTOR tangent = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat4(&vertex.Tangent), transform));
+            XMStoreFloat4(&transformed.Tangent, XMVectorSetW(tangent, mirrored ? -vertex.Tangent.w : vertex.Tangent.w));
+
+            transformed.ModelTransformIndex = Pbr::RootNodeIndex;
+            result.Vertices.push_back(transformed);
+        }
+
+        result.Indices = source.Indices;
+        if (mirrored) {
+            for (size_t i = 0; i + 2 < result.Indices.size(); i += 3) {
+                std::swap(result.Indices[i + 1], result.Indices[i + 2]);
+            }
+        }
+
+        return result;
+    }
+} // namespace
+
+namespace Pbr {
+    StaticBatch::EntryId XM_CALLCONV StaticBatch::Add(const PrimitiveBuilder& primitiveBuilder,
+                                                      std::shared_ptr<Material> material,
+                                                      FXMMATRIX transform) {
+        Entry entry{TransformGeometry(primitiveBuilder, transform), std::move(material)};
+
+        std::lock_guard guard(m_mutex);
+        const EntryId entryId = m_nextEntryId++;
+        if (!entry.Geometry.Indices.empty()) {
+            UpdateGroup(entry.BatchMaterial, true);
+        }
+        m_entries.emplace(entryId, std::move(entry));
+        return entryId;
+    }
+
+    void StaticBatch::Remove(EntryId entryId) {
+        std::lock_guard guard(m_mutex);
+        const auto it = m_entries.find(entryId);
+        if (it == m_entries.end()) {
+            return;
+        }
+        if (!it->second.Geometry.Indices.empty()) {
+            UpdateGroup(it->second.BatchMaterial, false);
+        }
+        m_entries.erase(it);
+    }
+
+    void StaticBatch::Clear() {
+        std::lock_guard guard(m_mutex);
+        m_entries.clear();
+        for (Group& group : m_groups) {
+            group.EntryCount = 0;
+        }
+        m_dirty = true;
+    }
+
+    void StaticBatch::UpdateGroup(const std::shared_ptr<Material>& material, bool added) {
+        auto it = std::find_if(m_groups.begin(), m_groups.end(), [&](const Group& group) { return group.GroupMaterial == material; });
+        if (it == m_groups.end()) {
+            it = m_groups.insert(m_groups.end(), Group{material});
+        }
+        it->EntryCount = added ? it->EntryCount + 1 : it->EntryCount - 1;
+        it->Dirty = true;
+        m_dirty = true;
+    }
+
+    uint32_t StaticBatch::GetEntryCount() const {
+        std::lock_guard guard(m_mutex);
+        return (uint32_t)m_entries.size();
+    }
+
+    uint32_t StaticBatch::GetDrawCount() const {
+        std::lock_guard guard(m_mutex);
+        return m_model.GetPrimitiveCount();
+    }
+
+    uint32_t StaticBatch::GetLastRebuildGroupCount() const {
+        std::lock_guard guard(m_mutex);
+        return m_lastRebuildGroupCount;
+    }
+
+    DrawPasses StaticBatch::GetDrawPasses() const {
+        std::lock_guard guard(m_mutex);
+        DrawPasses passes;
+        for (const Group& group : m_groups) {
+            if (group.EntryCount > 0 && !group.GroupMaterial->Hidden) {
+                (group.GroupMaterial->GetAlphaBlended() ? passes.Blended : passes.Opaque) = true;
+            }
+        }
+        return passes;
+    }
+
+    void StaticBatch::Render(Pbr::Resources const& pbrResources, _In_ ID3D11DeviceContext* context) const {
+        {
+            std::lock_guard guard(m_mutex);
+            if (m_dirty) {
+                Rebuild(pbrResources);
+                m_dirty = false;
+            }
+        }
+
+        m_model.Render(pbrResources, context);
+    }
+
+    void StaticBatch::Rebuild(Pbr::Resources const& pbrResources) const {
+        // Drop the groups without entries and their merged buffers, keeping the order of the others. The groups that were
+        // built come first, since groups are added at the end, so the model keeps one primitive per built group.
+        if (std::any_of(m_groups.begin(), m_groups.end(), [](const Group& group) { return group.EntryCount == 0; })) {
+            std::vector<Group> groups;
+            std::vector<Primitive> primitives;
+            for (uint32_t groupIndex = 0; groupIndex < m_groups.size(); groupIndex++) {
+                if (m_groups[groupIndex].EntryCount == 0) {
+                    continue;
+                }
+                if (groupIndex < m_model.GetPrimitiveCount()) {
+                    primitives.push_back(std::move(m_model.GetPrimitive(groupIndex)));
+                }
+                groups.push_back(std::move(m_groups[groupIndex]));
+            }
+
+            m_model.Clear();
+            for (Primitive& primitive : primitives) {
+                m_model.AddPrimitive(std::move(primitive));
+            }
+            m_groups = std::move(groups);
+        }
+
+        // Merge the entries of the dirty groups only.
+        std::vector<PrimitiveBuilder> merged(m_groups.size());
+        for (const auto& [entryId, entry] : m_entries) {
+            const auto it = std::find_if(
+                m_groups.begin(), m_groups.end(), [&](const Group& group) { return group.GroupMaterial == entry.BatchMaterial; });
+            if (it == m_groups.end() || !it->Dirty) {
+                continue; // The material only has entries without indices, or its merged buffers are up to date.
+            }
+
+            PrimitiveBuilder& builder = merged[it - m_groups.begin()];
+            const uint32_t baseVertex = (uint32_t)builder.Vertices.size();
+            builder.Vertices.insert(builder.Vertices.end(), entry.Geometry.Vertices.begin(), entry.Geometry.Vertices.end());
+            for (uint32_t index : entry.Geometry.Indices) {
+                builder.Indices.push_back(baseVertex + index);
+            }
+        }
+
+        m_lastRebuildGroupCount = 0;
+        for (uint32_t groupIndex = 0; groupIndex < m_groups.size(); groupIndex++) {
+            Group& group = m_groups[groupIndex];
+            if (!group.Dirty) {
+                continue;
+            }
+
+            Primitive primitive(pbrResources, merged[groupIndex], group.GroupMaterial);
+            if (groupIndex < m_model.GetPrimitiveCount()) {
+                m_model.GetPrimitive(groupIndex) = std::move(primitive);
+            } else {
+                m_model.AddPrimitive(std::move(primitive));
+            }
+            group.Dirty = false;
+            m_lastRebuildGroupCount++;
+        }
+    }
+} // namespace Pbr
@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <winrt/base.h>
+#include <d3d11.h>
+#include <d3d11_2.h>
+#include <DirectXMath.h>
+#include "PbrCommon.h"
+#include "PbrMaterial.h"
+#include "PbrModel.h"
+
+namespace Pbr {
+    // A static batch holds geometry that never moves after placement. Each entry is transformed into the batch space
+    // when it is added, and all entries sharing a material are merged into a single vertex/index buffer pair.
+    // On the next render, only the buffers of the materials whose entries were added or removed are rebuilt.
+    struct StaticBatch final {
+        using EntryId = uint32_t;
+
+        // Add geometry placed with the given transform. Vertex transform indices are ignored, since the batch has a single node.
+        EntryId XM_CALLCONV Add(const PrimitiveBuilder& primitiveBuilder, std::shared_ptr<Material> material, DirectX::FXMMATRIX transform);
+
+        // Remove a previously added entry. Unknown ids are ignored.
+        void Remove(EntryId entryId);
+
+        // Remove all entries.
+        void Clear();
+
+        // Rebuild the merged buffers if membership changed, then render the batch.
+        // The caller sets the model to world transform of the batch space, as for any other model.
+        void Render(Pbr::Resources const& pbrResources, _In_ ID3D11DeviceContext* context) const;
+
+        uint32_t GetEntryCount() const;
+
+        // Number of draws issued by Render, which is the number of distinct materials after the last rebuild.
+        uint32_t GetDrawCount() const;
+
+        // Number of materials whose merged buffers the last rebuild recreated.
+        uint32_t GetLastRebuildGroupCount() const;
+
+        // The passes of the materials of the entries that aren't hidden, including entries added since the last rebuild.
+        DrawPasses GetDrawPasses() const;
+
+    private:
+        void Rebuild(Pbr::Resources const& pbrResources) const;
+
+        // Count an entry added to or removed from the group of its material, whose merged buffers are rebuilt on the next render.
+        void UpdateGroup(const std::shared_ptr<Material>& material, bool added);
+
+        struct Entry {
+            PrimitiveBuilder Geometry; // Already transformed into the batch space.
+            std::shared_ptr<Material> BatchMaterial;
+        };
+
+        // The entries sharing a material. The merged buffers of the n-th group are the n-th primitive of the model, once built.
+        struct Group {
+            std::shared_ptr<Material> GroupMaterial;
+            uint32_t EntryCount{0}; // Entries with any indices, the group is dropped on the next rebuild when none remain.
+            bool Dirty{true};
+        };
+
+        mutable std::mutex m_mutex;
+        std::map<EntryId, Entry> m_entries;
+        EntryId m_nextEntryId{0};
+        mutable std::vector<Group> m_groups;
+        mutable bool m_dirty{false};
+        mutable uint32_t m_lastRebuildGroupCount{0};
+        mutable Model m_model;
+    };
+} // namespace Pbr
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "PbrCommon.h"
+#include "PbrStreamingBuffer.h"
+
+namespace {
+    UINT AlignUp(UINT value, UINT alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    UINT NextPowerOfTwo(UINT value) {
+        UINT power = 1;
+        while (power < value) {
+            power <<= 1;
+        }
+        return power;
+    }
+} // namespace
+
+namespace Pbr {
+    StreamingBuffer::StreamingBuffer(UINT bindFlags)
+        : m_bindFlags(bindFlags) {
+    }
+
+    UINT StreamingBuffer::Write(_In_ ID3D11Device* device,
+                                _In_opt_ ID3D11DeviceContext* context,
+                                _In_reads_bytes_(byteSize) const void* data,
+                                UINT byteSize,
+                                UINT alignment) {
+        m_stats.UploadBytes += byteSize;
+
+        // Two writes must fit so the data the GPU may still be reading is never overwritten. Half a write more of headroom
+        // absorbs growth without recreating the buffer every time the data gets a little larger.
+        if (!m_buffer || m_capacity < 2 * (byteSize + alignment)) {
+            m_capacity = NextPowerOfTwo(std::max(MinCapacity, 2 * (byteSize + alignment) + byteSize / 2));
+
+            // Dynamic buffers must be created with their initial data or written with Map(DISCARD) first.
+            std::vector<uint8_t> initialData(m_capacity);
+            if (byteSize > 0) {
+                memcpy(initialData.data(), data, byteSize);
+            }
+            D3D11_SUBRESOURCE_DATA initData{};
+            initData.pSysMem = initialData.data();
+
+            const CD3D11_BUFFER_DESC desc(m_capacity, m_bindFlags, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+            m_buffer = nullptr;
+            Internal::ThrowIfFailed(device->CreateBuffer(&desc, &initData, m_buffer.put()));
+            m_stats.Reallocations++;
+            m_writeOffset = byteSize;
+            return 0;
+        }
+
+        if (byteSize == 0) {
+            return 0;
+        }
+        if (!context) {
+            throw std::exception("Streaming buffer updates require a device context");
+        }
+
+        UINT offset = AlignUp(m_writeOffset, alignment);
+        D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+        if (offset + byteSize > m_capacity) {
+            offset = 0;
+            mapType = D3D11_MAP_WRITE_DISCARD;
+            m_stats.Discards++;
+        }
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        Internal::ThrowIfFailed(context->Map(m_buffer.get(), 0, mapType, 0, &mapped));
+        memcpy(static_cast<uint8_t*>(mapped.pData) + offset, data, byteSize);
+        context->Unmap(m_buffer.get(), 0);
+
+        m_writeOffset = offset + byteSize;
+        return offset;
+    }
+} // namespace Pbr
@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#pragma once
+
+#include <cstdint>
+#include <winrt/base.h>
+#include <d3d11.h>
+
+namespace Pbr {
+    // Upload counters of streaming buffers, since the buffer was created or its stats were last reset. Resetting them once per
+    // frame makes them per-frame counts. Stats of several buffers can be summed.
+    struct StreamingBufferStats {
+        uint64_t UploadBytes{0};   // Bytes written.
+        uint32_t Reallocations{0}; // Buffers created because the data outgrew the previous one, including the first.
+        uint32_t Discards{0};      // Writes that wrapped around with Map(DISCARD).
+
+        StreamingBufferStats& operator+=(const StreamingBufferStats& other) {
+            UploadBytes += other.UploadBytes;
+            Reallocations += other.Reallocations;
+            Discards += other.Discards;
+            return *this;
+        }
+    };
+
+    // A D3D11_USAGE_DYNAMIC buffer that is written as a ring. Each write is appended behind the previous one with
+    // Map(NO_OVERWRITE), so the GPU can still read the data of earlier frames, and wraps to the start with Map(DISCARD)
+    // once the end is reached. The buffer holds at least two writes of the largest size seen, with headroom for growth,
+    // so it is only recreated when the data grows past that. Must be used from the rendering thread.
+    struct StreamingBuffer final {
+        explicit StreamingBuffer(UINT bindFlags);
+
+        // Copy the data into the buffer, returning its byte offset. The offset is a multiple of alignment, which must be a
+        // power of two. The context may be null when the buffer is empty, in which case it is created with the data.
+        UINT Write(_In_ ID3D11Device* device,
+                   _In_opt_ ID3D11DeviceContext* context,
+                   _In_reads_bytes_(byteSize) const void* data,
+                   UINT byteSize,
+                   UINT alignment);
+
+        ID3D11Buffer* Get() const {
+            return m_buffer.get();
+        }
+
+        UINT GetCapacity() const {
+            return m_capacity;
+        }
+
+        const StreamingBufferStats& GetStats() const {
+            return m_stats;
+        }
+        void ResetStats() {
+            m_stats = {};
+        }
+
+    private:
+        static constexpr UINT MinCapacity = 4 * 1024;
+
+        UINT m_bindFlags;
+        winrt::com_ptr<ID3D11Buffer> m_buffer;
+        UINT m_capacity{0};
+        UINT m_writeOffset{0};
+        StreamingBufferStats m_stats;
+    };
+} // namespace Pbr
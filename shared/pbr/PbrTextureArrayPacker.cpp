@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <stdexcept>
+#include "PbrTextureArrayPacker.h"
+
+namespace Pbr {
+    TextureArrayPacker::TextureArrayPacker(uint64_t arrayByteSize, uint32_t maxSlicesPerArray, uint64_t budgetBytes)
+        : m_arrayByteSize(arrayByteSize)
+        , m_maxSlicesPerArray(std::max(1u, maxSlicesPerArray))
+        , m_budgetBytes(budgetBytes) {
+    }
+
+    TextureArrayPlacement TextureArrayPacker::Allocate(const TextureArrayFormat& format, uint64_t sliceByteSize) {
+        if (sliceByteSize == 0) {
+            throw std::out_of_range("Texture slices cannot be empty");
+        }
+
+        // The fullest array with a free slice, so that partially used arrays fill up before empty ones are used.
+        std::vector<uint32_t>& formatArrays = m_arraysByFormat[format];
+        Array* best = nullptr;
+        uint32_t bestId = 0;
+        for (uint32_t id : formatArrays) {
+            Array& array = m_arrays[id];
+            if (array.UsedSliceCount < array.UsedSlices.size() && (!best || array.UsedSliceCount > best->UsedSliceCount)) {
+                best = &array;
+                bestId = id;
+            }
+        }
+
+        TextureArrayPlacement placement;
+        if (!best) {
+            if (m_freeArrayIds.empty()) {
+                bestId = (uint32_t)m_arrays.size();
+                m_arrays.emplace_back();
+            } else {
+                bestId = m_freeArrayIds.back();
+                m_freeArrayIds.pop_back();
+            }
+            best = &m_arrays[bestId];
+            best->Format = format;
+            best->SliceByteSize = sliceByteSize;
+            best->UsedSlices.assign((size_t)std::clamp<uint64_t>(m_arrayByteSize / sliceByteSize, 1, m_maxSlicesPerArray), false);
+            best->UsedSliceCount = 0;
+            m_arrayBytes += best->UsedSlices.size() * sliceByteSize;
+            formatArrays.push_back(bestId);
+            placement.NewArray = true;
+        } else if (best->SliceByteSize != sliceByteSize) {
+            throw std::out_of_range("Textures of one format must have the same slice size");
+        }
+
+        const auto freeSlice = std::find(best->UsedSlices.begin(), best->UsedSlices.end(), false);
+        *freeSlice = true;
+        best->UsedSliceCount++;
+
+        placement.Array = bestId;
+        placement.Slice = (uint32_t)(freeSlice - best->UsedSlices.begin());
+        return placement;
+    }
+
+    void TextureArrayPacker::Free(uint32_t array, uint32_t slice) {
+        if (array >= m_arrays.size() || slice >= m_arrays[array].UsedSlices.size() || !m_arrays[array].UsedSlices[slice]) {
+            throw std::out_of_range("Texture slice is not allocated");
+        }
+
+        Array& freed = m_arrays[array];
+        freed.UsedSlices[slice] = false;
+        if (--freed.UsedSliceCount == 0) {
+            freed.EmptySince = ++m_clock;
+        }
+    }
+
+    std::vector<uint32_t> TextureArrayPacker::Evict() {
+        std::vector<uint32_t> evicted;
+        while (m_arrayBytes > m_budgetBytes) {
+            Array* oldest = nullptr;
+            uint32_t oldestId = 0;
+            for (uint32_t id = 0; id < m_arrays.size(); id++) {
+                Array& array = m_arrays[id];
+                if (!array.UsedSlices.empty() && array.UsedSliceCount == 0 && (!oldest || array.EmptySince < oldest->EmptySince)) {
+                    oldest = &array;
+                    oldestId = id;
+                }
+            }
+            if (!oldest) {
+                break; // Arrays holding textures are never evicted.
+            }
+
+            std::vector<uint32_t>& formatArrays = m_arraysByFormat[oldest->Format];
+            formatArrays.erase(std::find(formatArrays.begin(), formatArrays.end(), oldestId));
+            if (formatArrays.empty()) {
+                m_arraysByFormat.erase(oldest->Format);
+            }
+
+            m_arrayBytes -= oldest->UsedSlices.size() * oldest->SliceByteSize;
+            *oldest = {};
+            m_freeArrayIds.push_back(oldestId);
+            m_evictedArrayCount++;
+            evicted.push_back(oldestId);
+        }
+        return evicted;
+    }
+
+    uint32_t TextureArrayPacker::GetSliceCount(uint32_t array) const {
+        return array < m_arrays.size() ? (uint32_t)m_arrays[array].UsedSlices.size() : 0;
+    }
+
+    TextureArrayStats TextureArrayPacker::GetStats() const {
+        TextureArrayStats stats;
+        for (const Array& array : m_arrays) {
+            if (array.UsedSlices.empty()) {
+                continue;
+            }
+            stats.ArrayCount++;
+            stats.EmptyArrayCount += array.UsedSliceCount == 0 ? 1 : 0;
+            stats.SliceCount += (uint32_t)array.UsedSlices.size();
+            stats.UsedSliceCount += array.UsedSliceCount;
+        }
+        stats.ArrayBytes = m_arrayBytes;
+        stats.EvictedArrayCount = m_evictedArrayCount;
+        return stats;
+    }
+} // namespace Pbr
@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// Placement of textures in the slices of texture arrays, and eviction of the arrays. This code has no graphics API
+// dependency.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace Pbr {
+    // Textures can share an array when all of these are equal.
+    struct TextureArrayFormat {
+        uint32_t Width{0};
+        uint32_t Height{0};
+        uint32_t MipLevels{0};
+        uint32_t Format{0}; // DXGI_FORMAT of the textures.
+
+        bool operator<(const TextureArrayFormat& other) const {
+            return std::tie(Width, Height, MipLevels, Format) < std::tie(other.Width, other.Height, other.MipLevels, other.Format);
+        }
+    };
+
+    struct TextureArrayPlacement {
+        uint32_t Array{0};
+        uint32_t Slice{0};
+        bool NewArray{false}; // The array must be created, with GetSliceCount(Array) slices of the format.
+    };
+
+    struct TextureArrayStats {
+        uint32_t ArrayCount{0};
+        uint32_t EmptyArrayCount{0}; // Arrays kept for reuse.
+        uint32_t SliceCount{0};
+        uint32_t UsedSliceCount{0};
+        uint64_t ArrayBytes{0};
+        uint32_t EvictedArrayCount{0}; // Since the packer was created.
+    };
+
+    // Packs textures into arrays of a fixed number of slices each, per format. A texture goes to the fullest array of its
+    // format that has a free slice, so that arrays drained by released textures stay empty. Empty arrays are kept for reuse
+    // while all arrays take at most budgetBytes, beyond which Evict removes the arrays that have been empty the longest.
+    // Not thread safe.
+    struct TextureArrayPacker final {
+        // Arrays get as many slices as fit in arrayByteSize, between 1 and maxSlicesPerArray.
+        TextureArrayPacker(uint64_t arrayByteSize, uint32_t maxSlicesPerArray, uint64_t budgetBytes);
+
+        // Place a texture of the format, which takes sliceByteSize bytes in an array. Textures of one format must have the
+        // same slice size. Array ids of evicted arrays are reused.
+        TextureArrayPlacement Allocate(const TextureArrayFormat& format, uint64_t sliceByteSize);
+
+        // Return a slice from Allocate. Throws if the slice isn't allocated.
+        void Free(uint32_t array, uint32_t slice);
+
+        // Remove empty arrays until all arrays fit in the budget, and return their ids so their resources can be released.
+        std::vector<uint32_t> Evict();
+
+        uint32_t GetSliceCount(uint32_t array) const;
+
+        TextureArrayStats GetStats() const;
+
+    private:
+        struct Array {
+            TextureArrayFormat Format;
+            uint64_t SliceByteSize{0};
+            std::vector<bool> UsedSlices; // Empty for evicted arrays.
+            uint32_t UsedSliceCount{0};
+            uint64_t EmptySince{0}; // Value of m_clock when the array last became empty.
+        };
+
+        uint64_t m_arrayByteSize;
+        uint32_t m_maxSlicesPerArray;
+        uint64_t m_budgetBytes;
+        uint64_t m_arrayBytes{0};
+        uint64_t m_clock{0};
+        uint32_t m_evictedArrayCount{0};
+        std::vector<Array> m_arrays; // Indexed by array id.
+        std::vector<uint32_t> m_freeArrayIds;
+        std::map<TextureArrayFormat, std::vector<uint32_t>> m_arraysByFormat;
+    };
+} // namespace Pbr
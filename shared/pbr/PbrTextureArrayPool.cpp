@@ -0,0 +1,224 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "PbrCommon.h"
+#include "PbrTextureArrayPool.h"
+
+namespace {
+    // Bytes of the texture's mip chain, which only needs to be accurate enough for the memory budget of the pool.
+    uint64_t GetSliceByteSize(const D3D11_TEXTURE2D_DESC& desc) {
+        uint32_t blockSize = 1;
+        uint32_t blockBytes;
+        switch (desc.Format) {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC4_UNORM:
+        case DXGI_FORMAT_BC4_SNORM:
+            blockSize = 4;
+            blockBytes = 8;
+            break;
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC5_SNORM:
+        case DXGI_FORMAT_BC6H_UF16:
+        case DXGI_FORMAT_BC6H_SF16:
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            blockSize = 4;
+            blockBytes = 16;
+            break;
+        case DXGI_FORMAT_R8_UNORM:
+            blockBytes = 1;
+            break;
+        case DXGI_FORMAT_R8G8_UNORM:
+            blockBytes = 2;
+            break;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            blockBytes = 8;
+            break;
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            blockBytes = 16;
+            break;
+        default:
+            blockBytes = 4;
+            break;
+        }
+
+        uint64_t bytes = 0;
+        for (uint32_t mip = 0; mip < desc.MipLevels; mip++) {
+            const uint32_t width = std::max(1u, desc.Width >> mip);
+            const uint32_t height = std::max(1u, desc.Height >> mip);
+            bytes += (uint64_t)((width + blockSize - 1) / blockSize) * ((height + blockSize - 1) / blockSize) * blockBytes;
+        }
+        return bytes;
+    }
+} // namespace
+
+namespace Pbr {
+    struct TextureArrayPool::Impl {
+        struct ArrayResources {
+            winrt::com_ptr<ID3D11Texture2D> Texture;
+            winrt::com_ptr<ID3D11ShaderResourceView> View;
+        };
+
+        Impl(_In_ ID3D11Device* device, uint64_t arrayByteSize, uint64_t budgetBytes)
+            : Packer(arrayByteSize, MaxSlicesPerArray, budgetBytes) {
+            Device.copy_from(device);
+        }
+
+        winrt::com_ptr<ID3D11Device> Device;
+
+        mutable std::mutex Mutex;
+        TextureArrayPacker Packer;
+        std::vector<ArrayResources> Arrays; // Indexed by the array ids of the packer.
+        std::map<ID3D11ShaderResourceView*, std::weak_ptr<const TextureArraySlice>> Slices; // By the texture that was copied.
+        uint32_t StandaloneTextureCount{0};
+
+        void CreateArray(uint32_t id, const D3D11_TEXTURE2D_DESC& textureDesc) {
+            D3D11_TEXTURE2D_DESC arrayDesc{};
+            arrayDesc.Width = textureDesc.Width;
+            arrayDesc.Height = textureDesc.Height;
+            arrayDesc.MipLevels = textureDesc.MipLevels;
+            arrayDesc.ArraySize = Packer.GetSliceCount(id);
+            arrayDesc.Format = textureDesc.Format;
+            arrayDesc.SampleDesc.Count = 1;
+            arrayDesc.Usage = D3D11_USAGE_DEFAULT;
+            arrayDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+            D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc{};
+            viewDesc.Format = textureDesc.Format;
+            viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+            viewDesc.Texture2DArray.MipLevels = arrayDesc.MipLevels;
+            viewDesc.Texture2DArray.ArraySize = arrayDesc.ArraySize;
+
+            if (id >= Arrays.size()) {
+                Arrays.resize(id + 1);
+            }
+            ArrayResources& array = Arrays[id];
+            array = {};
+            Internal::ThrowIfFailed(Device->CreateTexture2D(&arrayDesc, nullptr, array.Texture.put()));
+            Internal::ThrowIfFailed(Device->CreateShaderResourceView(array.Texture.get(), &viewDesc, array.View.put()));
+        }
+
+        void Evict() {
+            for (uint32_t id : Packer.Evict()) {
+                Arrays[id] = {};
+            }
+        }
+
+        void Free(ID3D11ShaderResourceView* texture, std::optional<uint32_t> array, uint32_t slice) {
+            std::lock_guard guard(Mutex);
+
+            // The texture may have been requested again after the last reference was released, with a new slice.
+            const auto entry = Slices.find(texture);
+            if (entry != Slices.end() && entry->second.expired()) {
+                Slices.erase(entry);
+            }
+
+            if (array) {
+                Packer.Free(*array, slice);
+                Evict();
+            } else {
+                StandaloneTextureCount--;
+            }
+        }
+    };
+
+    TextureArrayPool::TextureArrayPool(_In_ ID3D11Device* device, uint64_t arrayByteSize, uint64_t budgetBytes)
+        : m_impl(std::make_shared<Impl>(device, arrayByteSize, budgetBytes)) {
+    }
+
+    std::shared_ptr<const TextureArraySlice> TextureArrayPool::GetSlice(_In_ ID3D11DeviceContext* context,
+                                                                        _In_ ID3D11ShaderResourceView* texture) {
+        std::lock_guard guard(m_impl->Mutex);
+
+        const auto entry = m_impl->Slices.find(texture);
+        if (entry != m_impl->Slices.end()) {
+            if (std::shared_ptr<const TextureArraySlice> slice = entry->second.lock()) {
+                return slice;
+            }
+        }
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC textureViewDesc;
+        texture->GetDesc(&textureViewDesc);
+        if (textureViewDesc.ViewDimension != D3D11_SRV_DIMENSION_TEXTURE2D) {
+            throw std::exception("Texture arrays can only hold 2D textures");
+        }
+
+        winrt::com_ptr<ID3D11Resource> resource;
+        texture->GetResource(resource.put());
+        const winrt::com_ptr<ID3D11Texture2D> source = resource.as<ID3D11Texture2D>();
+        D3D11_TEXTURE2D_DESC textureDesc;
+        source->GetDesc(&textureDesc);
+
+        auto slice = std::make_unique<TextureArraySlice>();
+        slice->Texture.copy_from(texture);
+
+        // Only views of a whole texture can be copied into a slice, since the arrays have the format of the textures. Textures
+        // that can change after the copy, like render targets, are viewed instead, since slices are looked up by texture.
+        std::optional<uint32_t> array;
+        const UINT viewMipLevels = textureViewDesc.Texture2D.MipLevels;
+        const bool writable = textureDesc.Usage == D3D11_USAGE_DYNAMIC ||
+                              (textureDesc.BindFlags & (D3D11_BIND_RENDER_TARGET | D3D11_BIND_UNORDERED_ACCESS)) != 0;
+        if (!writable && textureViewDesc.Format == textureDesc.Format && textureViewDesc.Texture2D.MostDetailedMip == 0 &&
+            (viewMipLevels == textureDesc.MipLevels || viewMipLevels == (UINT)-1) && textureDesc.ArraySize == 1) {
+            const TextureArrayFormat format{textureDesc.Width, textureDesc.Height, textureDesc.MipLevels, (uint32_t)textureDesc.Format};
+            const TextureArrayPlacement placement = m_impl->Packer.Allocate(format, GetSliceByteSize(textureDesc));
+            if (placement.NewArray) {
+                m_impl->CreateArray(placement.Array, textureDesc);
+            }
+
+            const Impl::ArrayResources& arrayResources = m_impl->Arrays[placement.Array];
+            for (UINT mip = 0; mip < textureDesc.MipLevels; mip++) {
+                context->CopySubresourceRegion(arrayResources.Texture.get(),
+                                               D3D11CalcSubresource(mip, placement.Slice, textureDesc.MipLevels),
+                                               0,
+                                               0,
+                                               0,
+                                               source.get(),
+                                               D3D11CalcSubresource(mip, 0, textureDesc.MipLevels),
+                                               nullptr);
+            }
+            slice->ArrayView = arrayResources.View;
+            slice->Slice = placement.Slice;
+            array = placement.Array;
+
+            // A new array may take the pool over its budget.
+            m_impl->Evict();
+        } else {
+            D3D11_SHADER_RESOURCE_VIEW_DESC arrayViewDesc{};
+            arrayViewDesc.Format = textureViewDesc.Format;
+            arrayViewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+            arrayViewDesc.Texture2DArray.MostDetailedMip = textureViewDesc.Texture2D.MostDetailedMip;
+            arrayViewDesc.Texture2DArray.MipLevels = viewMipLevels;
+            arrayViewDesc.Texture2DArray.ArraySize = 1;
+            Internal::ThrowIfFailed(m_impl->Device->CreateShaderResourceView(source.get(), &arrayViewDesc, slice->ArrayView.put()));
+            m_impl->StandaloneTextureCount++;
+        }
+
+        std::shared_ptr<const TextureArraySlice> sharedSlice(
+            slice.release(), [impl = m_impl, texture, array](const TextureArraySlice* slice) {
+                impl->Free(texture, array, slice->Slice);
+                delete slice;
+            });
+        m_impl->Slices[texture] = sharedSlice;
+        return sharedSlice;
+    }
+
+    TextureArrayPoolStats TextureArrayPool::GetStats() const {
+        std::lock_guard guard(m_impl->Mutex);
+        TextureArrayPoolStats stats;
+        stats.Arrays = m_impl->Packer.GetStats();
+        stats.StandaloneTextureCount = m_impl->StandaloneTextureCount;
+        return stats;
+    }
+} // namespace Pbr
@@ -0,0 +1,46 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#pragma once
+
+#include <memory>
+#include <winrt/base.h>
+#include <d3d11.h>
+#include "PbrTextureArrayPacker.h"
+
+namespace Pbr {
+    // A texture copied into a slice of a texture array. The slice returns to its pool when the last reference is released.
+    struct TextureArraySlice {
+        winrt::com_ptr<ID3D11ShaderResourceView> ArrayView; // Texture2DArray view of the array holding the texture.
+        uint32_t Slice{0};
+        winrt::com_ptr<ID3D11ShaderResourceView> Texture; // The texture that was copied.
+    };
+
+    struct TextureArrayPoolStats {
+        TextureArrayStats Arrays;
+        uint32_t StandaloneTextureCount{0}; // Textures viewed as an array of their own instead of being copied.
+    };
+
+    // Texture2DArrays holding copies of material textures, one slice per texture, so that materials with textures of the same
+    // sizes and formats bind the same arrays and draws can skip binding textures. Textures are copied on the GPU the first
+    // time they are requested, and requesting a texture again returns the same slice while it is referenced. Textures that
+    // can't be copied into an array, such as views of part of a texture, get an array view of their own. So do render targets,
+    // unordered access and dynamic textures, whose copies would go stale when they are written. Thread safe.
+    struct TextureArrayPool final {
+        static constexpr uint64_t DefaultArrayByteSize = 16 * 1024 * 1024;
+        static constexpr uint32_t MaxSlicesPerArray = 256;
+        static constexpr uint64_t DefaultBudgetBytes = 256 * 1024 * 1024;
+
+        TextureArrayPool(_In_ ID3D11Device* device,
+                         uint64_t arrayByteSize = DefaultArrayByteSize,
+                         uint64_t budgetBytes = DefaultBudgetBytes);
+
+        std::shared_ptr<const TextureArraySlice> GetSlice(_In_ ID3D11DeviceContext* context, _In_ ID3D11ShaderResourceView* texture);
+
+        TextureArrayPoolStats GetStats() const;
+
+    private:
+        struct Impl;
+        std::shared_ptr<Impl> m_impl; // Shared with the slices, which free themselves into it.
+    };
+} // namespace Pbr
@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+#include "pch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include "PbrVertexQuantization.h"
+
+namespace Pbr {
+    namespace VertexQuantization {
+        int16_t FloatToSnorm16(float value) {
+            return (int16_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f);
+        }
+
+        float Snorm16ToFloat(int16_t value) {
+            // -32768 and -32767 both map to -1, as in the D3D conversion rules.
+            return std::max(value / 32767.0f, -1.0f);
+        }
+
+        uint8_t FloatToUnorm8(float value) {
+            return (uint8_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+        }
+
+        float Unorm8ToFloat(uint8_t value) {
+            return value / 255.0f;
+        }
+
+        uint16_t FloatToHalf(float value) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+            const uint32_t absBits = bits & 0x7FFFFFFF;
+
+            if (absBits >= 0x7F800000) { // Infinity or NaN, keeping NaNs quiet.
+                return sign | 0x7C00 | (absBits > 0x7F800000 ? 0x0200 : 0);
+            }
+            if (absBits >= 0x477FF000) { // Rounds above the largest half, 65504.
+                return sign | 0x7C00;
+            }
+            if (absBits < 0x38800000) { // Below the smallest normal half, 2^-14: denormal or zero.
+                if (absBits < 0x33000000) {
+                    return sign;
+                }
+                const uint32_t exponent = absBits >> 23;
+                const uint32_t mantissa = (absBits & 0x007FFFFF) | 0x00800000;
+                const uint32_t shift = 126 - exponent;
+                uint32_t half = mantissa >> shift;
+                const uint32_t remainder = mantissa & ((1u << shift) - 1);
+                const uint32_t halfway = 1u << (shift - 1);
+                if (remainder > halfway || (remainder == halfway && (half & 1))) {
+                    half++;
+                }
+                return sign | (uint16_t)half;
+            }
+
+            // Rebias the exponent and round the mantissa from 23 to 10 bits, to nearest even.
+            const uint32_t rebiased = absBits - 0x38000000;
+            const uint32_t rounded = rebiased + 0x0FFF + ((rebiased >> 13) & 1);
+            return sign | (uint16_t)(rounded >> 13);
+        }
+
+        float HalfToFloat(uint16_t value) {
+            const uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+            const uint32_t exponent = (value >> 10) & 0x1F;
+            const uint32_t mantissa = value & 0x03FF;
+
+            uint32_t bits;
+            if (exponent == 0x1F) {
+                bits = sign | 0x7F800000 | (mantissa << 13);
+            } else if (exponent != 0) {
+                bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+            } else if (mantissa != 0) {
+                const float denormal = std::ldexp((float)mantissa, -24);
+                std::memcpy(&bits, &denormal, sizeof(bits));
+                bits |= sign;
+            } else {
+                bits = sign;
+            }
+
+            float result;
+            std::memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+
+        std::array<int16_t, 2> EncodeOctahedral(float x, float y, float z) {
+            const float l1Norm = std::abs(x) + std::abs(y) + std::abs(z);
+            if (l1Norm == 0) {
+                return {0, 0};
+            }
+
+            float u = x / l1Norm;
+            float v = y / l1Norm;
+            if (z < 0) {
+                // Fold the lower hemisphere over the diagonals.
+                const float foldedU = (1 - std::abs(v)) * (u >= 0 ? 1.0f : -1.0f);
+                const float foldedV = (1 - std::abs(u)) * (v >= 0 ? 1.0f : -1.0f);
+                u = foldedU;
+                v = foldedV;
+            }
+            return {FloatToSnorm16(u), FloatToSnorm16(v)};
+        }
+
+        std::array<float, 3> DecodeOctahedral(int16_t x, int16_t y) {
+            float u = Snorm16ToFloat(x);
+            float v = Snorm16ToFloat(y);
+            const float z = 1 - std::abs(u) - std::abs(v);
+            if (z < 0) {
+                const float t = -z;
+                u += u >= 0 ? -t : t;
+                v += v >= 0 ? -t : t;
+            }
+
+            const float length = std::sqrt(u * u + v * v + z * z);
+            return {u / length, v / length, z / length};
+        }
+
+        PositionBounds ComputePositionBounds(const void* positions, size_t count, size_t stride) {
+            std::array<float, 3> minimum{};
+            std::array<float, 3> maximum{};
+            for (size_t i = 0; i < count; i++) {
+                float position[3];
+                std::memcpy(position, static_cast<const uint8_t*>(positions) + i * stride, sizeof(position));
+                for (size_t axis = 0; axis < 3; axis++) {
+                    minimum[axis] = i == 0 ? position[axis] : std::min(minimum[axis], position[axis]);
+                    maximum[axis] = i == 0 ? position[axis] : std::max(maximum[axis], position[axis]);
+                }
+            }
+
+            PositionBounds bounds;
+            for (size_t axis = 0; axis < 3; axis++) {
+                bounds.Center[axis] = (minimum[axis] + maximum[axis]) * 0.5f;
+                // A flat axis still needs a non-zero extent to divide by.
+                bounds.Extent[axis] = std::max((maximum[axis] - minimum[axis]) * 0.5f, std::numeric_limits<float>::min());
+            }
+            return bounds;
+        }
+
+        std::array<int16_t, 3> QuantizePosition(const float* position, const PositionBounds& bounds) {
+            std::array<int16_t, 3> quantized;
+            for (size_t axis = 0; axis < 3; axis++) {
+                quantized[axis] = FloatToSnorm16((position[axis] - bounds.Center[axis]) / bounds.Extent[axis]);
+            }
+            return quantized;
+        }
+
+        std::array<float, 3> DequantizePosition(const int16_t* quantized, const PositionBounds& bounds) {
+            std::array<float, 3> position;
+            for (size_t axis = 0; axis < 3; axis++) {
+                position[axis] = bounds.Center[axis] + bounds.Extent[axis] * Snorm16ToFloat(quantized[axis]);
+            }
+            return position;
+        }
+    } // namespace VertexQuantization
+} // namespace Pbr
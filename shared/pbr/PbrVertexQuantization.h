@@ -0,0 +1,52 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// Quantization of vertex attributes for the compact vertex formats. This code has no graphics API dependency, and the
+// decode functions mirror what the input assembler and the vertex shaders do on the GPU.
+//
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Pbr {
+    // Vertex formats for primitive vertex buffers. The compact formats trade some precision for less memory and bandwidth.
+    enum class VertexFormat : uint32_t {
+        Full,             // Pbr::Vertex, 32-bit floats for all attributes.
+        Compact,          // Pbr::CompactVertex: float positions, octahedral snorm16 normal and tangent, half UV, RGBA8 color.
+        CompactQuantized, // Pbr::QuantizedVertex: like Compact, with snorm16 positions relative to the primitive bounds.
+        Streaming,        // Pbr::StreamingVertex: Pbr::Vertex split into two streams, used by primitives with updatable buffers.
+        Skinned,          // Pbr::Vertex and a second stream of Pbr::SkinVertex, used by primitives with skin vertices.
+    };
+
+    namespace VertexQuantization {
+        int16_t FloatToSnorm16(float value);
+        float Snorm16ToFloat(int16_t value);
+
+        uint8_t FloatToUnorm8(float value);
+        float Unorm8ToFloat(uint8_t value);
+
+        // IEEE 754 half precision with round to nearest even.
+        uint16_t FloatToHalf(float value);
+        float HalfToFloat(uint16_t value);
+
+        // Map a unit vector onto the octahedron unfolded into [-1, 1]^2, stored as two snorm16 values.
+        std::array<int16_t, 2> EncodeOctahedral(float x, float y, float z);
+        std::array<float, 3> DecodeOctahedral(int16_t x, int16_t y);
+
+        // Axis aligned bounds that positions are quantized in. Decoded positions are Center + Extent * snorm.
+        struct PositionBounds {
+            std::array<float, 3> Center{};
+            std::array<float, 3> Extent{};
+        };
+
+        // Compute the bounds of count positions of three floats, stride bytes apart.
+        PositionBounds ComputePositionBounds(const void* positions, size_t count, size_t stride);
+
+        std::array<int16_t, 3> QuantizePosition(const float* position, const PositionBounds& bounds);
+        std::array<float, 3> DequantizePosition(const int16_t* quantized, const PositionBounds& bounds);
+    } // namespace VertexQuantization
+} // namespace Pbr
@@ -0,0 +1,7 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#define PBR_COMPACT_VERTEX
+#define PBR_QUANTIZED_POSITION
+#include "HighlightVertexShader.hlsl"
@@ -0,0 +1,6 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#define PBR_SKINNED
+#include "HighlightVertexShader.hlsl"
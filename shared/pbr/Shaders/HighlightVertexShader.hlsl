@@ -4,6 +4,7 @@
 //
 
 #include "HighlightShared.hlsl"
+#include "PbrVertexInput.hlsl"
 
 StructuredBuffer<float4x4> Transforms : register(t0);
 
@@ -12,26 +13,17 @@ cbuffer ModelConstantBuffer : register(b1)
     float4x4 ModelToWorld  : packoffset(c0);
 };
 
-struct VSInputFlat
-{
-    float4      Position            : POSITION;
-    float3      Normal              : NORMAL;
-    float4      Tangent             : TANGENT;
-    float4      Color0              : COLOR0;
-    float2      TexCoord0           : TEXCOORD0;
-    min16uint   ModelTransformIndex : TRANSFORMINDEX;
-};
-
 #define VSOutputFlat PSInputFlat
-VSOutputFlat main(VSInputFlat input)
+VSOutputFlat main(VSInputPbr input)
 {
     VSOutputFlat output;
+    const PbrVertex vertex = DecodeVertex(input);
 
-    const float4x4 modelTransform = mul(Transforms[input.ModelTransformIndex], ModelToWorld);
-    const float4 transformedPosWorld = mul(input.Position, modelTransform);
+    const float4x4 modelTransform = mul(Transforms[vertex.ModelTransformIndex], ModelToWorld);
+    const float4 transformedPosWorld = mul(vertex.Position, modelTransform);
     output.PositionProj = mul(transformedPosWorld, ViewProjection);
     output.PositionWorld = transformedPosWorld.xyz / transformedPosWorld.w;
-    output.NormalWorld = mul(input.Normal, (float3x3)modelTransform).xyz;
+    output.NormalWorld = mul(vertex.Normal, (float3x3)modelTransform).xyz;
 
     return output;
 }
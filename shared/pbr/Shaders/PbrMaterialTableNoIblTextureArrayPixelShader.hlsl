@@ -0,0 +1,8 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#define PBR_MATERIAL_TABLE
+#define PBR_TEXTURE_ARRAYS
+#define PBR_NO_IBL
+#include "PbrPixelShader.hlsl"
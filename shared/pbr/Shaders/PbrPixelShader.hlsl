@@ -18,23 +18,52 @@
 
 #include "PbrShared.hlsl"
 
+// Laid out like Pbr::Material::ConstantBufferData, both in the constant buffer and in the structured buffer.
+struct MaterialParameters
+{
+    float4 BaseColorFactor;
+    float MetallicFactor;
+    float RoughnessFactor;
+    float2 Padding0;
+    float3 EmissiveFactor;
+    float Padding1;
+    float NormalScale;
+    float OcclusionStrength;
+    float AlphaCutoff;
+    uint NormalTextureTwoChannel; // Nonzero for normal textures that only store X and Y, like BC5.
+    uint BaseColorSlice; // Slices of the textures in their texture arrays, with PBR_TEXTURE_ARRAYS.
+    uint MetallicRoughnessSlice;
+    uint NormalSlice;
+    uint OcclusionSlice;
+    uint EmissiveSlice;
+    float3 Padding3;
+};
+
+#if defined(PBR_MATERIAL_TABLE)
+// The parameters of all materials, indexed by the material index of the draw.
+StructuredBuffer<MaterialParameters> Materials : register(t8);
+#else
 cbuffer MaterialConstantBuffer : register(b2)
 {
-    float4 BaseColorFactor  : packoffset(c0);
-    float MetallicFactor    : packoffset(c1.x);
-    float RoughnessFactor   : packoffset(c1.y);
-    float3 EmissiveFactor   : packoffset(c2);
-    float NormalScale       : packoffset(c3.x);
-    float OcclusionStrength : packoffset(c3.y);
-    float AlphaCutoff       : packoffset(c3.z);
+    MaterialParameters Material;
 };
+#endif
+
+#if defined(PBR_TEXTURE_ARRAYS)
+// Each material texture is a slice of an array shared by the textures of the same size and format.
+#define MaterialTexture(type) Texture2DArray<type>
+#define SampleMaterialTexture(texture, sampler, slice, uv) texture.Sample(sampler, float3(uv, slice))
+#else
+#define MaterialTexture(type) Texture2D<type>
+#define SampleMaterialTexture(texture, sampler, slice, uv) texture.Sample(sampler, uv)
+#endif
 
 // The texture registers must match the order of the MaterialTextures enum.
-Texture2D<float4> BaseColorTexture          : register(t0);
-Texture2D<float3> MetallicRoughnessTexture  : register(t1); // Green(y)=Roughness, Blue(z)=Metallic
-Texture2D<float3> NormalTexture             : register(t2);
-Texture2D<float3> OcclusionTexture          : register(t3); // Red(x) channel
-Texture2D<float3> EmissiveTexture           : register(t4);
+MaterialTexture(float4) BaseColorTexture          : register(t0);
+MaterialTexture(float3) MetallicRoughnessTexture  : register(t1); // Green(y)=Roughness, Blue(z)=Metallic
+MaterialTexture(float3) NormalTexture             : register(t2);
+MaterialTexture(float3) OcclusionTexture          : register(t3); // Red(x) channel
+MaterialTexture(float3) EmissiveTexture           : register(t4);
 Texture2D<float3> BRDFTexture               : register(t5);
 TextureCube<float3> SpecularTexture         : register(t6);
 TextureCube<float3> DiffuseTexture          : register(t7);
@@ -51,13 +80,27 @@ static const float3 f0 = float3(0.04, 0.04, 0.04);
 static const float MinRoughness = 0.04;
 static const float PI = 3.141592653589793;
 
+float3 evaluateDiffuseIrradiance(float3 n)
+{
+    float3 irradiance = DiffuseIrradiance[0].rgb * 0.282095;
+    irradiance += DiffuseIrradiance[1].rgb * (0.488603 * n.y);
+    irradiance += DiffuseIrradiance[2].rgb * (0.488603 * n.z);
+    irradiance += DiffuseIrradiance[3].rgb * (0.488603 * n.x);
+    irradiance += DiffuseIrradiance[4].rgb * (1.092548 * n.x * n.y);
+    irradiance += DiffuseIrradiance[5].rgb * (1.092548 * n.y * n.z);
+    irradiance += DiffuseIrradiance[6].rgb * (0.315392 * (3.0 * n.z * n.z - 1.0));
+    irradiance += DiffuseIrradiance[7].rgb * (1.092548 * n.x * n.z);
+    irradiance += DiffuseIrradiance[8].rgb * (0.546274 * (n.x * n.x - n.y * n.y));
+    return max(irradiance, 0.0);
+}
+
 float3 getIBLContribution(float perceptualRoughness, float NdotV, float3 diffuseColor, float3 specularColor, float3 n, float3 reflection)
 {
     const float lod = perceptualRoughness * NumSpecularMipLevels;
 
     const float3 brdf = BRDFTexture.Sample(BRDFSampler, float2(NdotV, 1.0 - perceptualRoughness)).rgb;
 
-    const float3 diffuseLight = DiffuseTexture.Sample(IBLSampler, n).rgb;
+    const float3 diffuseLight = DiffuseIrradianceFromSH ? evaluateDiffuseIrradiance(n) : DiffuseTexture.Sample(IBLSampler, n).rgb;
     const float3 specularLight = SpecularTexture.SampleLevel(IBLSampler, reflection, lod).rgb;
 
     const float3 diffuse = diffuseLight * diffuseColor;
@@ -92,16 +135,43 @@ float microfacetDistribution(float NdotH, float alphaRoughness)
 
 float4 main(PSInputPbr input) : SV_TARGET
 {
+#if defined(PBR_MATERIAL_TABLE)
+    const MaterialParameters material = Materials[input.MaterialIndex];
+#else
+    const MaterialParameters material = Material;
+#endif
+
+#if defined(PBR_FLAT)
+    // Flat materials have the neutral texture in every slot, so only their factors are used.
+    const float4 baseColorSample = float4(1.0, 1.0, 1.0, 1.0);
+    const float3 mrSample = float3(1.0, 1.0, 1.0);
+    const float3 normalSample = float3(0.5, 0.5, 1.0);
+    const float occlusionSample = 1.0;
+    const float3 emissiveSample = float3(1.0, 1.0, 1.0);
+#else
     // Roughness is stored in the 'g' channel, metallic is stored in the 'b' channel.
     // This layout intentionally reserves the 'r' channel for (optional) occlusion map data
-    const float3 mrSample = MetallicRoughnessTexture.Sample(MetallicRoughnessSampler, input.TexCoord0);
-    const float4 baseColor = BaseColorTexture.Sample(BaseColorSampler, input.TexCoord0) * input.Color0 * BaseColorFactor;
+    const float4 baseColorSample = SampleMaterialTexture(BaseColorTexture, BaseColorSampler, material.BaseColorSlice, input.TexCoord0);
+    const float3 mrSample =
+        SampleMaterialTexture(MetallicRoughnessTexture, MetallicRoughnessSampler, material.MetallicRoughnessSlice, input.TexCoord0);
+    const float3 normalSample = SampleMaterialTexture(NormalTexture, NormalSampler, material.NormalSlice, input.TexCoord0);
+    const float occlusionSample = SampleMaterialTexture(OcclusionTexture, OcclusionSampler, material.OcclusionSlice, input.TexCoord0).r;
+    const float3 emissiveSample = SampleMaterialTexture(EmissiveTexture, EmissiveSampler, material.EmissiveSlice, input.TexCoord0);
+#endif
+
+    const float4 baseColor = baseColorSample * input.Color0 * material.BaseColorFactor;
 
     // Discard if below alpha cutoff.
-    clip(baseColor.a - AlphaCutoff);
+    clip(baseColor.a - material.AlphaCutoff);
+
+    const float3 emissive = emissiveSample * material.EmissiveFactor;
 
-    const float metallic = saturate(mrSample.b * MetallicFactor);
-    const float perceptualRoughness = clamp(mrSample.g * RoughnessFactor, MinRoughness, 1.0);
+#if defined(PBR_UNLIT)
+    // Unlit materials show their base color as it is.
+    return float4(baseColor.rgb + emissive, baseColor.a);
+#else
+    const float metallic = saturate(mrSample.b * material.MetallicFactor);
+    const float perceptualRoughness = clamp(mrSample.g * material.RoughnessFactor, MinRoughness, 1.0);
 
     // Roughness is authored as perceptual roughness; as is convention,
     // convert to material roughness by squaring the perceptual roughness [2].
@@ -119,9 +189,13 @@ float4 main(PSInputPbr input) : SV_TARGET
     const float3 specularEnvironmentR0 = specularColor.rgb;
     const float3 specularEnvironmentR90 = float3(1.0, 1.0, 1.0) * reflectance90;
 
-    // normal at surface point
-    float3 n = 2.0 * NormalTexture.Sample(NormalSampler, input.TexCoord0) - 1.0;
-    n = normalize(mul(n * float3(NormalScale, NormalScale, 1.0), input.TBN));
+    // normal at surface point. Two-channel normal textures (BC5) don't store Z, so it is reconstructed from X and Y.
+    float3 n = 2.0 * normalSample - 1.0;
+    if (material.NormalTextureTwoChannel != 0)
+    {
+        n.z = sqrt(saturate(1.0 - dot(n.xy, n.xy)));
+    }
+    n = normalize(mul(n * float3(material.NormalScale, material.NormalScale, 1.0), input.TBN));
 
     const float3 v = normalize(EyePosition - input.PositionWorld);   // Vector from surface point to camera
     const float3 l = normalize(LightDirection);                           // Vector from surface point to light
@@ -144,15 +218,16 @@ float4 main(PSInputPbr input) : SV_TARGET
     const float3 specContrib = F * G * D / (4.0 * NdotL * NdotV);
     float3 color = NdotL * LightColor * (diffuseContrib + specContrib);
 
+#if !defined(PBR_NO_IBL)
     // Calculate lighting contribution from image based lighting source (IBL)
     color += getIBLContribution(perceptualRoughness, NdotV, diffuseColor, specularColor, n, reflection);
+#endif
 
     // Apply optional PBR terms for additional (optional) shading
-    const float ao = OcclusionTexture.Sample(OcclusionSampler, input.TexCoord0).r;
-    color = lerp(color, color * ao, OcclusionStrength);
+    color = lerp(color, color * occlusionSample, material.OcclusionStrength);
 
-    const float3 emissive = EmissiveTexture.Sample(EmissiveSampler, input.TexCoord0) * EmissiveFactor;
     color += emissive;
 
     return float4(color, baseColor.a);
+#endif
 }
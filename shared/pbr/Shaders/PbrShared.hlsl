@@ -11,4 +11,5 @@ struct PSInputPbr
     float3x3 TBN        : TANGENT;
     float2 TexCoord0    : TEXCOORD0;
     float4 Color0       : COLOR0;
+    nointerpolation uint MaterialIndex : MATERIALINDEX; // Only read with PBR_MATERIAL_TABLE.
 };
\ No newline at end of file
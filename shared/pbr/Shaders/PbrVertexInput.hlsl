@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (C) Microsoft Corporation.  All Rights Reserved
+// Licensed under the MIT License. See License.txt in the project root for license information.
+//
+// Vertex shader input for the vertex formats of Pbr::VertexFormat, selected with PBR_COMPACT_VERTEX,
+// PBR_QUANTIZED_POSITION and PBR_SKINNED, and decoded into the attributes of the full format.
+
+#if defined(PBR_QUANTIZED_POSITION)
+
+cbuffer PrimitiveConstantBuffer : register(b3)
+{
+    float4 PositionCenter : packoffset(c0);
+    float4 PositionExtent : packoffset(c1);
+};
+
+#endif
+
+#if defined(PBR_SKINNED)
+
+// Joint matrices of the model, transposed like the node transforms. They map the bind pose into the space of the model root.
+StructuredBuffer<float4x4> JointMatrices : register(t1);
+
+#endif
+
+struct VSInputPbr
+{
+#if defined(PBR_COMPACT_VERTEX)
+    float3      Position            : POSITION;  // snorm16 within the primitive bounds with PBR_QUANTIZED_POSITION.
+    float4      NormalTangent       : NORMAL;    // Octahedral encoded normal (xy) and tangent (zw).
+    float       TangentSign         : TANGENT;   // Bitangent sign.
+#else
+    float4      Position            : POSITION;
+    float3      Normal              : NORMAL;
+    float4      Tangent             : TANGENT;
+#endif
+    float4      Color0              : COLOR0;
+    float2      TexCoord0           : TEXCOORD0;
+    min16uint   ModelTransformIndex : TRANSFORMINDEX;
+    uint        MaterialIndex       : MATERIALINDEX; // Per instance, the start instance location of the draw.
+#if defined(PBR_SKINNED)
+    uint4       Joints              : JOINTS;
+    float4      Weights             : WEIGHTS;   // All zero for vertices that aren't skinned.
+#endif
+};
+
+struct PbrVertex
+{
+    float4 Position;
+    float3 Normal;
+    float4 Tangent;
+    float4 Color0;
+    float2 TexCoord0;
+    uint ModelTransformIndex;
+};
+
+float3 DecodeOctahedral(float2 encoded)
+{
+    float3 v = float3(encoded, 1 - abs(encoded.x) - abs(encoded.y));
+    const float t = saturate(-v.z);
+    v.xy += v.xy >= 0 ? -t : t;
+    return normalize(v);
+}
+
+PbrVertex DecodeVertex(VSInputPbr input)
+{
+    PbrVertex vertex;
+#if defined(PBR_COMPACT_VERTEX)
+#if defined(PBR_QUANTIZED_POSITION)
+    vertex.Position = float4(PositionCenter.xyz + PositionExtent.xyz * input.Position, 1);
+#else
+    vertex.Position = float4(input.Position, 1);
+#endif
+    vertex.Normal = DecodeOctahedral(input.NormalTangent.xy);
+    vertex.Tangent = float4(DecodeOctahedral(input.NormalTangent.zw), input.TangentSign);
+#else
+    vertex.Position = input.Position;
+    vertex.Normal = input.Normal;
+    vertex.Tangent = input.Tangent;
+#endif
+    vertex.Color0 = input.Color0;
+    vertex.TexCoord0 = input.TexCoord0;
+    vertex.ModelTransformIndex = input.ModelTransformIndex;
+#if defined(PBR_SKINNED)
+    if (any(input.Weights))
+    {
+        const float4x4 skin = input.Weights.x * JointMatrices[input.Joints.x] + input.Weights.y * JointMatrices[input.Joints.y] +
+                              input.Weights.z * JointMatrices[input.Joints.z] + input.Weights.w * JointMatrices[input.Joints.w];
+        vertex.Position = mul(vertex.Position, skin);
+        vertex.Normal = mul(float4(vertex.Normal, 0), skin).xyz;
+        vertex.Tangent.xyz = mul(float4(vertex.Tangent.xyz, 0), skin).xyz;
+    }
+#endif
+    return vertex;
+}
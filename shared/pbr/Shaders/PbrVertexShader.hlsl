@@ -17,6 +17,7 @@
 //
 
 #include "PbrShared.hlsl"
+#include "PbrVertexInput.hlsl"
 
 StructuredBuffer<float4x4> Transforms : register(t0);
 
@@ -26,33 +27,25 @@ cbuffer ModelConstantBuffer : register(b1)
 
 };
 
-struct VSInputPbr
-{
-    float4      Position            : POSITION;
-    float3      Normal              : NORMAL;
-    float4      Tangent             : TANGENT;
-    float4      Color0              : COLOR0;
-    float2      TexCoord0           : TEXCOORD0;
-    min16uint   ModelTransformIndex : TRANSFORMINDEX;
-};
-
 #define VSOutputPbr PSInputPbr
 VSOutputPbr main(VSInputPbr input)
 {
     VSOutputPbr output;
+    const PbrVertex vertex = DecodeVertex(input);
 
-    const float4x4 modelTransform = mul(Transforms[input.ModelTransformIndex], ModelToWorld);
-    const float4 transformedPosWorld = mul(input.Position, modelTransform);
+    const float4x4 modelTransform = mul(Transforms[vertex.ModelTransformIndex], ModelToWorld);
+    const float4 transformedPosWorld = mul(vertex.Position, modelTransform);
     output.PositionProj = mul(transformedPosWorld, ViewProjection);
     output.PositionWorld = transformedPosWorld.xyz / transformedPosWorld.w;
 
-    const float3 normalW = normalize(mul(float4(input.Normal, 0.0), modelTransform).xyz);
-    const float3 tangentW = normalize(mul(float4(input.Tangent.xyz, 0.0), modelTransform).xyz);
-    const float3 bitangentW = cross(normalW, tangentW) * input.Tangent.w;
+    const float3 normalW = normalize(mul(float4(vertex.Normal, 0.0), modelTransform).xyz);
+    const float3 tangentW = normalize(mul(float4(vertex.Tangent.xyz, 0.0), modelTransform).xyz);
+    const float3 bitangentW = cross(normalW, tangentW) * vertex.Tangent.w;
     output.TBN = float3x3(tangentW, bitangentW, normalW);
 
-    output.TexCoord0 = input.TexCoord0;
-    output.Color0 = input.Color0;
+    output.TexCoord0 = vertex.TexCoord0;
+    output.Color0 = vertex.Color0;
+    output.MaterialIndex = input.MaterialIndex;
 
     return output;
 }
@@ -9,6 +9,8 @@ cbuffer SceneBuffer : register(b0)
     float3 LightDirection       : packoffset(c5);
     float3 LightColor           : packoffset(c6);
     int NumSpecularMipLevels    : packoffset(c7);
+    bool DiffuseIrradianceFromSH : packoffset(c7.y);
     float3 HighlightPosition    : packoffset(c8);
     float AnimationTime         : packoffset(c9);
+    float4 DiffuseIrradiance[9] : packoffset(c10); // Spherical harmonics coefficients of irradiance divided by pi.
 };
@@ -13,4 +13,6 @@
 
 #include <DirectXMath.h>
 
+#ifdef _WIN32
 #include <winrt/base.h> // winrt::com_ptr
+#endif